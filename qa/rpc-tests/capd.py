@@ -5,6 +5,7 @@
 import test_framework.loginit
 
 import io
+import threading
 import time
 import sys
 if sys.version_info[0] < 3:
@@ -158,6 +159,45 @@ class MyTest (BitcoinTestFramework):
         assert msg == msg1
         return True
 
+    def pollConcurrencyTest(self):
+        """Each capd poll holds an RPC thread while it waits, so many of them must not hold up other calls"""
+        node = self.nodes[0]
+        POLLERS = 6
+        prefix = "c0ffee"
+        subs = [node.capd("subscribe", prefix) for i in range(POLLERS)]
+        results = [None] * POLLERS
+
+        def poll(i):
+            # One connection per thread, since a connection can not be shared between threads
+            proxy = get_rpc_proxy(node.url, 0, timeout=120)
+            results[i] = proxy.capd("poll", subs[i], 20000)
+
+        pollers = [threading.Thread(target=poll, args=(i,)) for i in range(POLLERS)]
+        for t in pollers:
+            t.start()
+        time.sleep(1)
+
+        # Cheap, slow and other capd calls all finish while every poll is waiting
+        start = time.time()
+        for i in range(10):
+            node.getblockcount()
+            node.getblock(node.getbestblockhash())
+            node.capd("info")
+        assert time.time() - start < 10, "calls were held up by the waiting polls"
+        assert all(t.is_alive() for t in pollers)
+
+        # A matching message ends every poll
+        data = prefix + "0102"
+        node.capd("send", data)
+        for t in pollers:
+            t.join(TIMEOUT)
+            assert not t.is_alive()
+        for r in results:
+            assert_equal(len(r["messages"]), 1)
+            assert_equal(r["messages"][0]["data"], data)
+        for sub in subs:
+            node.capd("unsubscribe", sub)
+
     def run_test (self):
         logging.info("CAPD message pool test")
 
@@ -503,6 +543,8 @@ class MyTest (BitcoinTestFramework):
         # After 10 minutes the message is fully aged
         assert(m2["priority"] <= 0)
 
+        self.pollConcurrencyTest()
+
         logging.info("CAPD test finished")
         # time.sleep(1)
         # pdb.set_trace()
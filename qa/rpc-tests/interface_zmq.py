@@ -53,9 +53,11 @@ class ZMQSubscriber:
         assert_equal(topic, self.topic)
 
         if len(tmp) >= 3:
-            # Sequence should be incremental.
-            seq = tmp[2]
-            assert_equal(struct.unpack('<I', seq)[-1], self.sequence)
+            # Sequence should be incremental.  A subscriber that joined late starts from the first one it sees.
+            seq = struct.unpack('<I', tmp[2])[-1]
+            if self.sequence is None:
+                self.sequence = seq
+            assert_equal(seq, self.sequence)
             self.sequence += 1
         return body
 
@@ -75,6 +77,7 @@ class ZMQTest (BitcoinTestFramework):
         socket = self.zmq_context.socket(zmq.SUB)
         socket.set(zmq.RCVTIMEO, 60000)
         socket.connect(address)
+        self.socket = socket
 
         # Subscribe to all available topics.
         self.hashblock = ZMQSubscriber(socket, b"hashblock")
@@ -86,7 +89,8 @@ class ZMQTest (BitcoinTestFramework):
         self.rawds = ZMQSubscriber(socket, b"rawds")
 
         self.extra_args = [["-{}={}".format(sub, address) for sub in [
-            "zmqpubhashblock", "zmqpubhashtx", "zmqpubrawblock", "zmqpubrawtx", "zmqpubhashds", "zmqpubrawds"]], []]
+            "zmqpubhashblock", "zmqpubhashtx", "zmqpubrawblock", "zmqpubrawtx", "zmqpubhashds", "zmqpubrawds",
+            "zmqpubremovedtx", "zmqpubblockdisconnect"]], []]
         self.extra_args[0].append("-debug=dsproof")
         self.extra_args[0].append("-debug=zmq")
         ret  = start_nodes(self.num_nodes, self.options.tmpdir, self.extra_args)
@@ -222,6 +226,38 @@ class ZMQTest (BitcoinTestFramework):
             ds  = self.rawds.receive()
             assert len(ds) > 0
 
+        # Only listen to the reorg and mempool removal topics from here on
+        self.hashblock.unsubscribe()
+        self.rawblock.unsubscribe()
+        self.hashds.unsubscribe()
+        self.rawds.unsubscribe()
+        self.blockdisconnect = ZMQSubscriber(self.socket, b"blockdisconnect")
+        self.removedtx = ZMQSubscriber(self.socket, b"removedtx")
+        # Transactions were already removed from the mempool before this subscription
+        self.removedtx.sequence = None
+        time.sleep(1)  # let the subscriptions reach the publisher
+
+        logging.info("Disconnect the tip")
+        tip = self.nodes[0].getbestblockhash()
+        self.nodes[0].invalidateblock(tip)
+        assert_equal(self.blockdisconnect.receive().hex(), tip)
+        self.nodes[0].reconsiderblock(tip)
+        assert_equal(self.nodes[0].getbestblockhash(), tip)
+
+        logging.info("Mine the mempool")
+        mempoolTxs = self.nodes[0].gettxpoolinfo()["size"]
+        assert mempoolTxs > 0
+        blockhash = self.nodes[0].generate(1)[0]
+        minedTxids = self.nodes[0].getblock(blockhash)["txid"][1:]  # skip the coinbase
+        assert_equal(len(minedTxids), mempoolTxs)
+        removed = set()
+        for i in range(mempoolTxs):
+            body = self.removedtx.receive()
+            assert_equal(len(body), 33)
+            assert_equal(body[32], 4)  # included in a block
+            removed.add(body[:32].hex())
+        assert_equal(removed, set(minedTxids))
+
 
 if __name__ == '__main__':
     ZMQTest().main()
@@ -333,6 +333,58 @@ class RESTTest (BitcoinTestFramework):
         for tx in txs:
             assert_equal(tx in json_obj['txidem'], True)
 
+        #########################################
+        # /rest/blocks/ and /rest/getutxos/bulk #
+        #########################################
+
+        # a height range of raw blocks, each the same as the single block call
+        height = self.nodes[0].getblockcount()
+        response = http_get_call(url.hostname, url.port, '/rest/blocks/'+str(height-1)+'/5'+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        f = BytesIO(response.read())
+        for h in [height-1, height]:
+            block_hash = self.nodes[0].getblockhash(h)
+            assert_equal(unpack("<i", f.read(4))[0], h)
+            assert_equal(deser_uint256(f), int(block_hash, 16))
+            block_hex = http_get_call(url.hostname, url.port, '/rest/block/'+block_hash+self.FORMAT_SEPARATOR+'hex').strip()
+            assert_equal(encode(deser_string(f), "hex_codec").decode(), block_hex)
+        assert_equal(f.read(), b'')
+
+        # with undo data
+        response = http_get_call(url.hostname, url.port, '/rest/blocks/undo/'+str(height)+'/1'+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        f = BytesIO(response.read())
+        assert_equal(unpack("<i", f.read(4))[0], height)
+        deser_uint256(f)
+        deser_string(f)
+        assert_greater_than(len(deser_string(f)), 0)
+        assert_equal(f.read(), b'')
+
+        response = http_get_call(url.hostname, url.port, '/rest/blocks/'+str(height+1)+'/1'+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/blocks/0/1'+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+
+        # bulk utxo lookup, answered in the order asked
+        utxo = self.nodes[1].listunspent()[0]
+        bulk_request = json.dumps(["00"*32, utxo['outpoint']])
+        json_obj = json.loads(http_post_call(url.hostname, url.port, '/rest/getutxos/bulk'+self.FORMAT_SEPARATOR+'json', bulk_request).decode('utf-8'), parse_float=Decimal)
+        assert_equal(json_obj['chainHeight'], height)
+        assert_equal(len(json_obj['utxos']), 2)
+        assert_equal(json_obj['utxos'][0], None)
+        assert_equal(json_obj['utxos'][1]['outpoint'], utxo['outpoint'])
+        assert_equal(json_obj['utxos'][1]['value'], utxo['amount'])
+
+        bulk_request = ser_compact_size(2) + ser_uint256(0) + ser_uint256(int(utxo['outpoint'], 16))
+        f = BytesIO(http_post_call(url.hostname, url.port, '/rest/getutxos/bulk'+self.FORMAT_SEPARATOR+'bin', bulk_request))
+        assert_equal(unpack("<i", f.read(4))[0], height)
+        deser_uint256(f)
+        assert_equal(f.read(1), b'\x00')
+        assert_equal(f.read(1), b'\x01')
+
+        response = http_post_call(url.hostname, url.port, '/rest/getutxos/bulk'+self.FORMAT_SEPARATOR+'json', '{}', True)
+        assert_equal(response.status, 400)
+
         #test rest bestblock
         bb_hash = self.nodes[0].getbestblockhash()
 
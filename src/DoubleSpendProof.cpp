@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "DoubleSpendProof.h"
+#include "DoubleSpendProofStorage.h"
 #include "hashwrapper.h"
 #include "main.h"
 #include "pubkey.h"
@@ -11,7 +12,9 @@
 #include "script/standard.h"
 #include "txmempool.h"
 #include "validationinterface.h"
+#include "workerpool.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 #ifdef ENABLE_WALLET
@@ -28,6 +31,9 @@
 // tinyformat::format(std::cout, __VA_ARGS__)
 #endif
 
+//! Proofs waiting for their signature checks beyond this many are checked by the thread that received them
+static const size_t MAX_DSPROOF_VERIFY_QUEUE = 10000;
+
 namespace
 {
 enum Scripts
@@ -184,6 +190,17 @@ DoubleSpendProof DoubleSpendProof::create(const CTransaction &t1, const CTransac
 DoubleSpendProof::DoubleSpendProof() {}
 bool DoubleSpendProof::isEmpty() const { return m_prevOutpoint.IsNull(); }
 DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, const CTransactionRef ptx) const
+{
+    SpentOutput spent;
+    Validity validity = prepareValidation(pool, ptx, spent);
+    if (validity != Valid)
+        return validity;
+    return checkSignatures(spent);
+}
+
+DoubleSpendProof::Validity DoubleSpendProof::prepareValidation(const CTxMemPool &pool,
+    const CTransactionRef ptx,
+    SpentOutput &spent) const
 {
     AssertLockHeld(pool.cs_txmempool);
 
@@ -216,8 +233,8 @@ DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, co
     }
 
     // Get the previous output we are spending.
-    int64_t amount;
-    CScript prevOutScript;
+    int64_t &amount = spent.amount;
+    CScript &prevOutScript = spent.prevOutScript;
     {
         auto prev = pool._getTxIdx(m_prevOutpoint);
         if (prev.ptx.get())
@@ -258,15 +275,6 @@ DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, co
     else
         tx = *ptx;
 
-    /*
-     * TomZ: At this point (2019-07) we only support P2PKH payments.
-     *
-     * Since we have an actually spending tx, we could trivially support various other
-     * types of scripts because all we need to do is replace the signature from our 'tx'
-     * with the one that comes from the DSP.
-     */
-    Scripts scriptType = P2PKH; // FUTURE: look at prevTx to find out script-type
-
     StackItem pubkeyStk;
     for (size_t i = 0; i < tx.vin.size(); ++i)
     {
@@ -296,19 +304,32 @@ DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, co
         LOG(DSPROOF, "WARNING: dsproof is invalid because pubkey is not a byte array\n");
         return Invalid;
     }
-    VchType pubkey = pubkeyStk.asVch();
+    spent.pubkey = pubkeyStk.asVch();
 
-    if (pubkey.empty())
+    if (spent.pubkey.empty())
     {
         LOG(DSPROOF, "WARNING: dsproof is invalid because pubkey is empty\n");
         return Invalid;
     }
+    return Valid;
+}
+
+DoubleSpendProof::Validity DoubleSpendProof::checkSignatures(const SpentOutput &spent) const
+{
+    /*
+     * TomZ: At this point (2019-07) we only support P2PKH payments.
+     *
+     * Since we have an actually spending tx, we could trivially support various other
+     * types of scripts because all we need to do is replace the signature from our 'tx'
+     * with the one that comes from the DSP.
+     */
+    Scripts scriptType = P2PKH; // FUTURE: look at prevTx to find out script-type
 
     CScript inScript;
     if (scriptType == P2PKH)
     {
         inScript << m_spender1.pushData.front();
-        inScript << pubkey;
+        inScript << spent.pubkey;
     }
 
     // DS proofs won't work for complex scripts (non P2PKH), which is good because we aren't storing the tx associated
@@ -317,10 +338,10 @@ DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, co
     CTransaction noTx;
     CTransactionRef noTxRef = MakeTransactionRef(noTx);
 
-    DSPSignatureChecker checker1(this, m_spender1, amount);
+    DSPSignatureChecker checker1(this, m_spender1, spent.amount);
     ScriptImportedState sis1(&checker1);
     ScriptError_t error;
-    if (!VerifyScript(inScript, prevOutScript, checker1.flags(), sis1, &error))
+    if (!VerifyScript(inScript, spent.prevOutScript, checker1.flags(), sis1, &error))
     {
         LOG(DSPROOF, "DoubleSpendProof failed validating first tx due to %s\n", ScriptErrorString(error));
         return Invalid;
@@ -330,11 +351,11 @@ DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, co
     if (scriptType == P2PKH)
     {
         inScript << m_spender2.pushData.front();
-        inScript << pubkey;
+        inScript << spent.pubkey;
     }
-    DSPSignatureChecker checker2(this, m_spender2, amount);
+    DSPSignatureChecker checker2(this, m_spender2, spent.amount);
     ScriptImportedState sis2(&checker2);
-    if (!VerifyScript(inScript, prevOutScript, checker2.flags(), sis2, &error))
+    if (!VerifyScript(inScript, spent.prevOutScript, checker2.flags(), sis2, &error))
     {
         LOG(DSPROOF, "DoubleSpendProof failed validating second tx due to %s\n", ScriptErrorString(error));
         return Invalid;
@@ -342,6 +363,108 @@ DoubleSpendProof::Validity DoubleSpendProof::validate(const CTxMemPool &pool, co
     return Valid;
 }
 
+CDoubleSpendProofVerifier::CDoubleSpendProofVerifier() : state(std::make_shared<State>()) {}
+
+/** Check a proof's signatures and act on the result */
+static void CheckQueuedProof(const DoubleSpendProof &proof, const DoubleSpendProof::SpentOutput &spent, NodeId from)
+{
+    const uint256 hash = proof.GetHash();
+    try
+    {
+        if (proof.checkSignatures(spent) == DoubleSpendProof::Valid)
+        {
+            LOG(DSPROOF, "Double spend proof is valid from peer:%d\n", from);
+            AcceptDoubleSpendProof(proof);
+        }
+        else
+        {
+            LOG(DSPROOF, "Double spend proof didn't validate (%s) from peer:%d\n", hash.ToString(), from);
+            mempool.doubleSpendProofStorage()->markProofRejected(hash);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOG(DSPROOF, "Failure handling double spend proof. Peer: %d Reason: %s\n", from, e.what());
+        mempool.doubleSpendProofStorage()->markProofRejected(hash);
+    }
+}
+
+bool CDoubleSpendProofVerifier::Enqueue(const DoubleSpendProof &proof,
+    const DoubleSpendProof::SpentOutput &spent,
+    NodeId from)
+{
+    std::shared_ptr<State> s = state;
+    {
+        std::lock_guard<std::mutex> lock(s->cs);
+        if (s->fStopped || s->nQueued >= MAX_DSPROOF_VERIFY_QUEUE)
+            return false;
+        s->nQueued++;
+    }
+
+    bool fPosted = workerPool.Post(
+        [s, proof, spent, from]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(s->cs);
+                s->nQueued--;
+                if (s->fStopped)
+                {
+                    s->condDone.notify_all();
+                    return;
+                }
+                s->nRunning++;
+            }
+            CheckQueuedProof(proof, spent, from);
+            std::lock_guard<std::mutex> lock(s->cs);
+            s->nRunning--;
+            s->condDone.notify_all();
+        },
+        MAX_DSPROOF_VERIFY_QUEUE);
+    if (!fPosted)
+    {
+        std::lock_guard<std::mutex> lock(s->cs);
+        s->nQueued--;
+        s->condDone.notify_all();
+    }
+    return fPosted;
+}
+
+void CDoubleSpendProofVerifier::Wait()
+{
+    std::unique_lock<std::mutex> lock(state->cs);
+    state->condDone.wait(lock, [this]() { return state->fStopped || (state->nQueued == 0 && state->nRunning == 0); });
+}
+
+void CDoubleSpendProofVerifier::Stop()
+{
+    std::unique_lock<std::mutex> lock(state->cs);
+    state->fStopped = true;
+    state->condDone.notify_all();
+    state->condDone.wait(lock, [this]() { return state->nRunning == 0; });
+}
+
+void AcceptDoubleSpendProof(const DoubleSpendProof &proof)
+{
+    const auto ptx = mempool.addDoubleSpendProof(proof);
+    if (!ptx.get())
+        return;
+
+    // find any descendants of this double spent transaction. If there are any
+    // then we must also forward this double spend proof to any SPV peers that
+    // want to know about this tx or its descendants.
+    CTxMemPool::setEntries setDescendants;
+    {
+        READLOCK(mempool.cs_txmempool);
+        CTxMemPool::indexed_transaction_set::const_iterator iter = mempool.mapTx.find(ptx->GetId());
+        if (iter == mempool.mapTx.end())
+            return;
+        mempool._CalculateDescendants(iter, setDescendants);
+    }
+
+    // added to mempool correctly, then forward to nodes.
+    broadcastDspInv(ptx, proof.GetHash(), &setDescendants);
+}
+
 void broadcastDspInv(const CTransactionRef &dspTx, const uint256 &hash, CTxMemPool::setEntries *setDescendants)
 {
 #ifdef ENABLE_WALLET
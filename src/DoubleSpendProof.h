@@ -4,12 +4,18 @@
 #ifndef NEXA_DOUBLESPENDPROOF_H
 #define NEXA_DOUBLESPENDPROOF_H
 
+#include <net.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <serialize.h>
 #include <txmempool.h>
 #include <uint256.h>
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 
 class DoubleSpendProof
 {
@@ -40,6 +46,23 @@ public:
      */
     Validity validate(const CTxMemPool &pool, const CTransactionRef ptx = nullptr) const;
 
+    /** The output a proof double spends and the public key that spends it, which the signatures are checked against */
+    struct SpentOutput
+    {
+        CScript prevOutScript;
+        int64_t amount = 0;
+        VchType pubkey;
+    };
+
+    /** The part of validate() that needs the mempool: checks the form of the proof and looks up the output it double
+     *  spends.  Returns Valid when only the signatures are left to be checked by checkSignatures().
+     *  pool.cs_txmempool must be held.
+     */
+    Validity prepareValidation(const CTxMemPool &pool, const CTransactionRef ptx, SpentOutput &spent) const;
+
+    /** Checks the signatures of both spenders.  No locks are needed, so this can run on any thread. */
+    Validity checkSignatures(const SpentOutput &spent) const;
+
     /** Returns the hash of the input transaction (UTXO) that is being doublespent */
     const COutPoint &Outpoint() const { return m_prevOutpoint; }
 
@@ -120,6 +143,45 @@ private:
     Spender m_spender1, m_spender2;
 };
 
+/** Checks the signatures of double spend proofs received from peers on the worker pool, so that message handler
+ *  threads only do the mempool lookups.  The checks add valid proofs to the mempool and announce them, and remember
+ *  invalid ones as rejected.
+ */
+class CDoubleSpendProofVerifier
+{
+public:
+    CDoubleSpendProofVerifier();
+    ~CDoubleSpendProofVerifier() { Stop(); }
+
+    /** Queue a proof that passed prepareValidation() for its signature checks.  Returns false, and the caller should
+     *  check the proof itself, if the worker pool is not running or the queue is full or stopped.
+     */
+    bool Enqueue(const DoubleSpendProof &proof, const DoubleSpendProof::SpentOutput &spent, NodeId from);
+
+    /** Wait until every queued proof has been handled */
+    void Wait();
+
+    /** Stop checking proofs and wait for the checks that are running.  Proofs still queued are dropped. */
+    void Stop();
+
+private:
+    /** Shared with the queued checks, which may still be on the worker pool when the verifier is destroyed */
+    struct State
+    {
+        std::mutex cs;
+        std::condition_variable condDone;
+        size_t nQueued = 0;
+        size_t nRunning = 0;
+        bool fStopped = false;
+    };
+    std::shared_ptr<State> state;
+};
+
+extern CDoubleSpendProofVerifier dspVerifier;
+
+/** Finish handling a proof that validated: attach it to the double spent mempool transaction and announce it */
+void AcceptDoubleSpendProof(const DoubleSpendProof &proof);
+
 /** Send notifcation of the availability of a doublespend to all connected nodes */
 void broadcastDspInv(const CTransactionRef &dspTx,
     const uint256 &hash,
@@ -9,6 +9,7 @@
 #include <primitives/transaction.h>
 #include <utiltime.h>
 
+#include <algorithm>
 #include <limits>
 
 static constexpr int64_t SECONDS_TO_KEEP_ORPHANS = 90;
@@ -22,160 +23,184 @@ DoubleSpendProofStorage::DoubleSpendProofStorage() : m_recentRejects(120000, 0.0
 }
 
 DoubleSpendProofStorage::~DoubleSpendProofStorage() { m_timer.cancel(); }
+DoubleSpendProofStorage::Shard &DoubleSpendProofStorage::shardFor(const COutPoint &outpoint)
+{
+    return m_shards[m_shardHasher(outpoint) % SHARD_COUNT];
+}
+
+DoubleSpendProofStorage::Shard &DoubleSpendProofStorage::shardFor(int32_t proofId)
+{
+    return m_shards[uint32_t(proofId) % SHARD_COUNT];
+}
+
+const DoubleSpendProofStorage::Shard &DoubleSpendProofStorage::shardFor(int32_t proofId) const
+{
+    return m_shards[uint32_t(proofId) % SHARD_COUNT];
+}
+
 DoubleSpendProof DoubleSpendProofStorage::proof(int proof) const
 {
-    LOCK(m_lock);
-    auto iter = m_proofs.find(proof);
-    if (iter != m_proofs.end())
+    const Shard &shard = shardFor(proof);
+    LOCK(shard.cs);
+    auto iter = shard.proofs.find(proof);
+    if (iter != shard.proofs.end())
         return iter->second;
     return DoubleSpendProof();
 }
 
 std::pair<bool, int32_t> DoubleSpendProofStorage::add(const DoubleSpendProof &proof)
 {
-    LOCK(m_lock);
+    Shard &shard = shardFor(proof.Outpoint());
+    LOCK(shard.cs);
+    return _add(shard, proof);
+}
+
+std::pair<bool, int32_t> DoubleSpendProofStorage::_add(Shard &shard, const DoubleSpendProof &proof)
+{
+    AssertLockHeld(shard.cs);
 
     uint256 hash = proof.GetHash();
-    auto lookupIter = m_dspIdLookupTable.find(hash);
-    if (lookupIter != m_dspIdLookupTable.end())
+    auto lookupIter = shard.dspIdLookupTable.find(hash);
+    if (lookupIter != shard.dspIdLookupTable.end())
     {
-        claimOrphan(lookupIter->second);
+        _claimOrphan(shard, lookupIter->second);
         return {false, lookupIter->second};
     }
 
-    auto iter = m_proofs.find(m_nextId);
-    while (iter != m_proofs.end())
+    // Ids are positive and their remainder by SHARD_COUNT is the index of the shard that holds them
+    const int32_t shardIndex = &shard - &m_shards[0];
+    const int32_t maxSeq = std::numeric_limits<int32_t>::max() / SHARD_COUNT;
+    int32_t id = shard.nextSeq * SHARD_COUNT + shardIndex;
+    while (shard.proofs.count(id))
     {
-        if (++m_nextId < 0)
-            m_nextId = 1;
-        iter = m_proofs.find(m_nextId);
+        if (++shard.nextSeq >= maxSeq)
+            shard.nextSeq = 1;
+        id = shard.nextSeq * SHARD_COUNT + shardIndex;
     }
-    m_proofs.emplace(m_nextId, proof);
-    m_dspIdLookupTable.emplace(hash, m_nextId);
+    if (++shard.nextSeq >= maxSeq)
+        shard.nextSeq = 1;
+    shard.proofs.emplace(id, proof);
+    shard.dspIdLookupTable.emplace(hash, id);
 
-    return {true, m_nextId++};
+    return {true, id};
 }
 
 void DoubleSpendProofStorage::addOrphan(const DoubleSpendProof &proof, NodeId peerId)
 {
-    LOCK(m_lock);
-    const auto res = add(proof);
+    Shard &shard = shardFor(proof.Outpoint());
+    LOCK(shard.cs);
+    const auto res = _add(shard, proof);
     if (!res.first) // it was already in the storage
         return;
 
     const int32_t id = res.second;
-    m_orphans.emplace(id, std::make_pair(peerId, GetTime()));
-    m_prevTxIdLookupTable[proof.Outpoint().hash.GetCheapHash()].push_back(id);
+    shard.orphans.emplace(id, std::make_pair(peerId, GetTime()));
+    shard.orphansByOutpoint[proof.Outpoint()].push_back(id);
 }
 
-std::list<std::pair<int, int> > DoubleSpendProofStorage::findOrphans(const COutPoint &prevOut)
+std::list<std::pair<int, NodeId> > DoubleSpendProofStorage::findOrphans(const COutPoint &prevOut)
 {
-    std::list<std::pair<int, int> > answer;
-    LOCK(m_lock);
-    auto iter = m_prevTxIdLookupTable.find(prevOut.hash.GetCheapHash());
-    if (iter == m_prevTxIdLookupTable.end())
+    std::list<std::pair<int, NodeId> > answer;
+    Shard &shard = shardFor(prevOut);
+    LOCK(shard.cs);
+    auto iter = shard.orphansByOutpoint.find(prevOut);
+    if (iter == shard.orphansByOutpoint.end())
         return answer;
 
-    std::deque<int> &q = iter->second;
-    for (auto proofId = q.begin(); proofId != q.end(); ++proofId)
+    for (int32_t proofId : iter->second)
     {
-        auto proofIter = m_proofs.find(*proofId);
-        DbgAssert(proofIter != m_proofs.end(), );
-        if (proofIter != m_proofs.end())
-        {
-            if (proofIter->second.Outpoint() == prevOut)
-            {
-                auto orphanIter = m_orphans.find(*proofId);
-                if (orphanIter != m_orphans.end())
-                {
-                    answer.emplace_back(*proofId, orphanIter->second.first);
-                }
-            }
-        }
-        else
-            LOG(DSPROOF, "ERROR: no dsproofs found in m_proofs\n");
+        auto orphanIter = shard.orphans.find(proofId);
+        DbgAssert(orphanIter != shard.orphans.end(), );
+        if (orphanIter != shard.orphans.end())
+            answer.emplace_back(proofId, orphanIter->second.first);
     }
     return answer;
 }
 
-int DoubleSpendProofStorage::orphanCount(int proofId) { return m_orphans.count(proofId); }
+int DoubleSpendProofStorage::orphanCount(int proofId)
+{
+    Shard &shard = shardFor(proofId);
+    LOCK(shard.cs);
+    return shard.orphans.count(proofId);
+}
+
 void DoubleSpendProofStorage::claimOrphan(int proofId)
 {
-    LOCK(m_lock);
-    auto orphan = m_orphans.find(proofId);
-    if (orphan != m_orphans.end())
-    {
-        m_orphans.erase(orphan);
+    Shard &shard = shardFor(proofId);
+    LOCK(shard.cs);
+    _claimOrphan(shard, proofId);
+}
 
-        for (auto iter = m_prevTxIdLookupTable.begin(); iter != m_prevTxIdLookupTable.end(); ++iter)
-        {
-            auto &list = iter->second;
-            for (auto i = list.begin(); i != list.end(); ++i)
-            {
-                if (*i == proofId)
-                {
-                    list.erase(i);
-                    if (list.size() == 0)
-                        m_prevTxIdLookupTable.erase(iter);
-                    return;
-                }
-            }
-        }
-    }
+void DoubleSpendProofStorage::_claimOrphan(Shard &shard, int32_t proofId)
+{
+    AssertLockHeld(shard.cs);
+    auto orphan = shard.orphans.find(proofId);
+    if (orphan == shard.orphans.end())
+        return;
+    shard.orphans.erase(orphan);
+
+    auto proofIter = shard.proofs.find(proofId);
+    DbgAssert(proofIter != shard.proofs.end(), return );
+    auto orphanLookup = shard.orphansByOutpoint.find(proofIter->second.Outpoint());
+    DbgAssert(orphanLookup != shard.orphansByOutpoint.end(), return );
+    std::vector<int32_t> &ids = orphanLookup->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), proofId), ids.end());
+    if (ids.empty())
+        shard.orphansByOutpoint.erase(orphanLookup);
 }
 
 void DoubleSpendProofStorage::remove(int proof)
 {
-    LOCK(m_lock);
-    auto iter = m_proofs.find(proof);
-    if (iter == m_proofs.end())
+    Shard &shard = shardFor(proof);
+    LOCK(shard.cs);
+    _remove(shard, proof);
+}
+
+void DoubleSpendProofStorage::_remove(Shard &shard, int32_t proofId)
+{
+    AssertLockHeld(shard.cs);
+    auto iter = shard.proofs.find(proofId);
+    if (iter == shard.proofs.end())
         return;
 
-    auto orphan = m_orphans.find(iter->first);
-    if (orphan != m_orphans.end())
-    {
-        m_orphans.erase(orphan);
-        auto orphanLookup = m_prevTxIdLookupTable.find(iter->second.Outpoint().hash.GetCheapHash());
-        if (orphanLookup != m_prevTxIdLookupTable.end())
-        {
-            std::deque<int> &queue = orphanLookup->second;
-            if (queue.size() == 1)
-            {
-                DbgAssert(queue.front() == proof, );
-                if (queue.front() != proof)
-                    LOG(DSPROOF, "ERROR: queue front did not equal dsproof\n");
-                m_prevTxIdLookupTable.erase(orphanLookup);
-            }
-            else
-            {
-                for (auto i = queue.begin(); i != queue.end(); ++i)
-                {
-                    if (*i == proof)
-                    {
-                        i = queue.erase(i);
-                    }
-                }
-            }
-        }
-    }
-    auto hash = iter->second.GetHash();
-    m_dspIdLookupTable.erase(hash);
-    m_proofs.erase(iter);
+    _claimOrphan(shard, proofId);
+    shard.dspIdLookupTable.erase(iter->second.GetHash());
+    shard.proofs.erase(iter);
 }
 
 DoubleSpendProof DoubleSpendProofStorage::lookup(const uint256 &proofId) const
 {
-    LOCK(m_lock);
-    auto lookupIter = m_dspIdLookupTable.find(proofId);
-    if (lookupIter == m_dspIdLookupTable.end())
-        return DoubleSpendProof();
-    return m_proofs.at(lookupIter->second);
+    // The hash of a proof does not tell which outpoint it is for, so every shard is asked
+    for (const Shard &shard : m_shards)
+    {
+        LOCK(shard.cs);
+        auto lookupIter = shard.dspIdLookupTable.find(proofId);
+        if (lookupIter != shard.dspIdLookupTable.end())
+            return shard.proofs.at(lookupIter->second);
+    }
+    return DoubleSpendProof();
 }
 
 bool DoubleSpendProofStorage::exists(const uint256 &proofId) const
 {
-    LOCK(m_lock);
-    return m_dspIdLookupTable.find(proofId) != m_dspIdLookupTable.end();
+    for (const Shard &shard : m_shards)
+    {
+        LOCK(shard.cs);
+        if (shard.dspIdLookupTable.count(proofId))
+            return true;
+    }
+    return false;
+}
+
+size_t DoubleSpendProofStorage::size() const
+{
+    size_t count = 0;
+    for (const Shard &shard : m_shards)
+    {
+        LOCK(shard.cs);
+        count += shard.proofs.size();
+    }
+    return count;
 }
 
 void DoubleSpendProofStorage::periodicCleanup(const boost::system::error_code &error)
@@ -185,43 +210,49 @@ void DoubleSpendProofStorage::periodicCleanup(const boost::system::error_code &e
     m_timer.expires_from_now(boost::posix_time::minutes(1));
     m_timer.async_wait(std::bind(&DoubleSpendProofStorage::periodicCleanup, this, std::placeholders::_1));
 
-    LOCK(m_lock);
-    auto expire = GetTime() - SECONDS_TO_KEEP_ORPHANS;
-    auto iter = m_orphans.begin();
-    while (iter != m_orphans.end())
+    const int64_t expire = GetTime() - SECONDS_TO_KEEP_ORPHANS;
+    std::vector<NodeId> misbehaving;
+    size_t nOrphans = 0;
+    size_t nProofs = 0;
+    for (Shard &shard : m_shards)
     {
-        if (iter->second.second <= expire)
-        {
-            const int peerId = iter->second.first;
-            const int proofId = iter->first;
-            iter = m_orphans.erase(iter);
-            remove(proofId);
-
-            dosMan.Misbehaving(peerId, 1);
-        }
-        else
+        LOCK(shard.cs);
+        std::vector<int32_t> expired;
+        for (const auto &orphan : shard.orphans)
         {
-            ++iter;
+            if (orphan.second.second <= expire)
+            {
+                expired.push_back(orphan.first);
+                misbehaving.push_back(orphan.second.first);
+            }
         }
+        for (int32_t proofId : expired)
+            _remove(shard, proofId);
+        nOrphans += shard.orphans.size();
+        nProofs += shard.proofs.size();
     }
-    LOG(DSPROOF, "DSP orphan count: %d DSProof count: %d\n", m_orphans.size(), m_proofs.size());
+
+    // Penalize outside of the shard locks
+    for (NodeId peerId : misbehaving)
+        dosMan.Misbehaving(peerId, 1);
+    LOG(DSPROOF, "DSP orphan count: %d DSProof count: %d\n", nOrphans, nProofs);
 }
 
 bool DoubleSpendProofStorage::isRecentlyRejectedProof(const uint256 &proofHash) const
 {
-    LOCK(m_lock);
+    LOCK(m_rejectsLock);
     return m_recentRejects.contains(proofHash);
 }
 
 void DoubleSpendProofStorage::markProofRejected(const uint256 &proofHash)
 {
-    LOCK(m_lock);
+    LOCK(m_rejectsLock);
     m_recentRejects.insert(proofHash);
 }
 
 void DoubleSpendProofStorage::newBlockFound()
 {
-    LOCK(m_lock);
+    LOCK(m_rejectsLock);
     m_recentRejects.reset();
 }
 
@@ -6,22 +6,25 @@
 
 #include "DoubleSpendProof.h"
 #include "bloom.h"
+#include "coins.h"
 #include "net.h"
 
 #include <boost/asio.hpp>
 
-#include <deque>
-#include <map>
-#include <mutex>
-#include <set>
+#include <array>
+#include <list>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 class COutPoint;
 
 class DoubleSpendProofStorage
 {
 public:
+    //! Proofs are split across this many independently locked shards by the outpoint they double spend
+    static const unsigned int SHARD_COUNT = 16;
+
     DoubleSpendProofStorage();
     ~DoubleSpendProofStorage();
 
@@ -50,6 +53,9 @@ public:
     DoubleSpendProof lookup(const uint256 &proofId) const;
     bool exists(const uint256 &proofId) const;
 
+    //! Returns the number of proofs stored, orphans included
+    size_t size() const;
+
     // called every minute
     void periodicCleanup(const boost::system::error_code &error);
 
@@ -58,13 +64,6 @@ public:
     void newBlockFound();
 
 private:
-    // m_lock guards all the following data structures
-    mutable CCriticalSection m_lock;
-
-    std::map<int32_t, DoubleSpendProof> m_proofs;
-    int m_nextId = 1;
-    std::map<int, std::pair<NodeId, int64_t> > m_orphans;
-
     //! A salted hasher for use with the uint256 type in the LookupTable below.
     //! This code is inspired by txmempool.h's SaltedTxidHasher
     class SaltedHasher
@@ -77,9 +76,36 @@ private:
 
     using LookupTable = std::unordered_map<uint256, int32_t, SaltedHasher>;
 
-    LookupTable m_dspIdLookupTable;
-    std::map<uint64_t, std::deque<int> > m_prevTxIdLookupTable;
+    /** The proofs of every outpoint that hashes to one shard.  A proof id keeps the index of its shard in the low
+        bits, so proofs are found by id without searching. */
+    struct Shard
+    {
+        // cs guards all the following data structures
+        mutable CCriticalSection cs;
+
+        std::unordered_map<int32_t, DoubleSpendProof> proofs;
+        int32_t nextSeq = 1;
+        //! orphan proof id -> the peer that sent it and when it arrived
+        std::unordered_map<int32_t, std::pair<NodeId, int64_t> > orphans;
+        //! double spent outpoint -> ids of the orphan proofs for it
+        std::unordered_map<COutPoint, std::vector<int32_t>, SaltedOutpointHasher> orphansByOutpoint;
+        LookupTable dspIdLookupTable;
+    };
+
+    Shard &shardFor(const COutPoint &outpoint);
+    Shard &shardFor(int32_t proofId);
+    const Shard &shardFor(int32_t proofId) const;
+
+    // These require the shard's cs to be held
+    std::pair<bool, int32_t> _add(Shard &shard, const DoubleSpendProof &proof);
+    void _claimOrphan(Shard &shard, int32_t proofId);
+    void _remove(Shard &shard, int32_t proofId);
+
+    std::array<Shard, SHARD_COUNT> m_shards;
+    SaltedOutpointHasher m_shardHasher;
 
+    // m_rejectsLock guards m_recentRejects
+    mutable CCriticalSection m_rejectsLock;
     CRollingBloomFilter m_recentRejects;
 
     // initialize timer
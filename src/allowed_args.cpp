@@ -7,6 +7,9 @@
 
 #include "allowed_args.h"
 #include "bench/bench_constants.h"
+#include "blockstorage/blockcompression.h"
+#include "blockstorage/blockfilewriter.h"
+#include "blockstorage/blockindexsnapshot.h"
 #include "blockstorage/blockstorage.h"
 #include "chainparams.h"
 #include "dosman.h"
@@ -29,6 +32,7 @@
 #include "utilmoneystr.h"
 #include "utilstrencodings.h"
 #include "validation/validation.h"
+#include "zmq/zmqconfig.h"
 #ifdef ENABLE_WALLET
 #include "wallet/wallet.h"
 #endif
@@ -272,6 +276,16 @@ static void addGeneralOptions(AllowedArgs &allowedArgs, HelpMessageMode mode)
         .addArg("useblockdb", optionalBool,
             strprintf(_("Which method to store blocks on disk (default: %u) 0 = sequential files, 1 = blockdb"),
                 DEFAULT_BLOCK_DB_MODE))
+        .addArg("blockcompression=<codec>", requiredStr,
+            strprintf(_("Compress blocks and undo data as they are stored, with one of: %s (default: %s)"),
+                SupportedBlockCompressionNames(), DEFAULT_BLOCK_COMPRESSION))
+        .addArg("blockcompressionlevel=<n>", requiredInt,
+            strprintf(_("The -blockcompression level, 0 selects the default level of the codec and for lz4 any "
+                        "level above 0 selects high compression mode (default: %d)"),
+                DEFAULT_BLOCK_COMPRESSION_LEVEL))
+        .addArg("asyncblockwrites", optionalBool,
+            strprintf(_("Write block and undo files from a background thread and sync them in batches (default: %u)"),
+                DEFAULT_ASYNC_BLOCK_WRITES))
         .addArg("checkblocks=<n>", requiredInt,
             strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), DEFAULT_CHECKBLOCKS))
         .addArg("checklevel=<n>", requiredInt,
@@ -284,7 +298,20 @@ static void addGeneralOptions(AllowedArgs &allowedArgs, HelpMessageMode mode)
         allowedArgs.addArg("daemon", optionalBool, _("Run in the background as a daemon and accept commands"));
 #endif
 
-    allowedArgs.addArg("loadblock=<file>", requiredStr, _("Imports blocks from external blk000??.dat file on startup"))
+    allowedArgs
+        .addArg("addressindex", optionalBool,
+            strprintf(_("Maintain an index of the history, balance and unspent outputs of every output script, used "
+                        "by the getaddresshistory, getaddressbalance and getaddressutxos rpc calls (default: %u)"),
+                DEFAULT_ADDRESSINDEX))
+        .addArg("blockindexsnapshot", optionalBool,
+            strprintf(_("Save the block index to %s on shutdown and load it from there on the next startup, which is "
+                        "much faster than reading the block index database (default: %u)"),
+                BLOCKINDEX_SNAPSHOT_FILENAME, DEFAULT_BLOCKINDEX_SNAPSHOT))
+        .addArg("blockfilterindex", optionalBool,
+            strprintf(_("Maintain an index of BIP158 basic compact block filters, needed to serve them to light "
+                        "clients with -peerblockfilters (default: %u)"),
+                DEFAULT_BLOCKFILTERINDEX))
+        .addArg("loadblock=<file>", requiredStr, _("Imports blocks from external blk000??.dat file on startup"))
         .addArg("par=<n>", requiredInt,
             strprintf(_("Set the number of script verification threads (%u to %d, 0 = "
                         "auto, <0 = leave that many cores free, default: %d)"),
@@ -294,11 +321,15 @@ static void addGeneralOptions(AllowedArgs &allowedArgs, HelpMessageMode mode)
 #endif
         .addArg("prune=<n>", requiredInt,
             strprintf(_("Reduce storage requirements by pruning (deleting) old blocks. This mode is incompatible with "
-                        "-txindex and -rescan. "
+                        "-txindex, -addressindex, -blockfilterindex, -tokenindex and -rescan. "
                         "Warning: Reverting this setting requires re-downloading the entire blockchain. "
                         "(default: 0 = disable pruning blocks, >%u = target size in MiB to use for block files)"),
                 MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024))
         .addArg("reindex", optionalBool, _("Rebuild block chain index from current blk000??.dat files on startup"))
+        .addArg("tokenindex", optionalBool,
+            strprintf(_("Maintain an index of the unspent outputs, authorities and supply of every token group, used "
+                        "by the scantokens, gettokensupply and listtokenutxos rpc calls (default: %u)"),
+                DEFAULT_TOKENINDEX))
         .addArg("txindex", optionalBool,
             strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"),
                 DEFAULT_TXINDEX));
@@ -349,6 +380,9 @@ static void addConnectionOptions(AllowedArgs &allowedArgs)
         .addArg("peerbloomfilters", optionalBool,
             strprintf(_("Support filtering of blocks and transaction with bloom filters (default: %u)"),
                 DEFAULT_PEERBLOOMFILTERS))
+        .addArg("peerblockfilters", optionalBool,
+            strprintf(_("Serve compact block filters to peers per BIP157, requires -blockfilterindex (default: %u)"),
+                DEFAULT_PEERBLOCKFILTERS))
         .addDebugArg("enforcenodebloom", optionalBool,
             strprintf("Enforce minimum protocol version to limit use of bloom filters (default: %u)", 0))
         .addArg("port=<port>", requiredInt,
@@ -458,9 +492,27 @@ static void addZmqOptions(AllowedArgs &allowedArgs)
             _("Enable publishing of the hash of double spent transactions in <address>"), zmqParamOptional)
         .addArg("zmqpubrawds=<address>", requiredStr, _("Enable publishing of raw double spend proofs to <address>"),
             zmqParamOptional)
+        .addArg("zmqpubcapdmsg=<address>", requiredStr, _("Enable publishing of new CAPD messages to <address>"),
+            zmqParamOptional)
         .addArg("zmqpubrawblock=<address>", requiredStr, _("Enable publish raw block in <address>"), zmqParamOptional)
         .addArg(
-            "zmqpubrawtx=<address>", requiredStr, _("Enable publish raw transaction in <address>"), zmqParamOptional);
+            "zmqpubrawtx=<address>", requiredStr, _("Enable publish raw transaction in <address>"), zmqParamOptional)
+        .addArg("zmqpubrawtxbatch=<address>", requiredStr,
+            _("Enable publishing of raw transactions in batches of up to -zmqbatchsize to <address>"),
+            zmqParamOptional)
+        .addArg("zmqpubremovedtx=<address>", requiredStr,
+            _("Enable publishing of the hash of transactions that leave the mempool, and why, to <address>"),
+            zmqParamOptional)
+        .addArg("zmqpubblockdisconnect=<address>", requiredStr,
+            _("Enable publishing of the hash of blocks disconnected from the tip to <address>"), zmqParamOptional)
+        .addArg("zmqbatchsize=<n>", requiredInt,
+            strprintf(_("Most transactions in one -zmqpubrawtxbatch message (default: %u)"), DEFAULT_ZMQ_BATCH_SIZE),
+            zmqParamOptional)
+        .addArg("zmqqueuesize=<n>", requiredInt,
+            strprintf(_("Most notifications waiting to be published before new ones are dropped, an eighth of "
+                          "which is kept for block notifications (default: %u)"),
+                DEFAULT_ZMQ_QUEUE_SIZE),
+            zmqParamOptional);
 }
 
 static void addDebuggingOptions(AllowedArgs &allowedArgs, HelpMessageMode mode)
@@ -609,6 +661,34 @@ static void addRpcServerOptions(AllowedArgs &allowedArgs)
             strprintf(_("Set the number of threads to service RPC calls (default: %d)"), DEFAULT_HTTP_THREADS))
         .addDebugArg("rpcworkqueue=<n>", requiredInt,
             strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE))
+        .addArg("rpcheavythreads=<n>", requiredInt,
+            strprintf(_("Set the number of threads to service slow RPC calls like getblock or scantokens (default: %d)"),
+                DEFAULT_HTTP_HEAVY_THREADS))
+        .addDebugArg("rpcheavyworkqueue=<n>", requiredInt,
+            strprintf("Set the depth of the work queue to service slow RPC calls (default: %d)",
+                DEFAULT_HTTP_HEAVY_WORKQUEUE))
+        .addArg("rpcheavymethod=<method>", requiredStr,
+            _("Run calls of this RPC method on the slow RPC call threads. This option can be specified multiple times"))
+        .addArg("rpcfastmethod=<method>", requiredStr,
+            _("Run calls of this RPC method on the normal RPC threads even if it is a slow call by default. This option "
+              "can be specified multiple times"))
+        .addArg("restthreads=<n>", requiredInt,
+            strprintf(_("Set the number of threads to service REST and CAPD requests (default: %d)"),
+                DEFAULT_HTTP_REST_THREADS))
+        .addDebugArg("restworkqueue=<n>", requiredInt,
+            strprintf("Set the depth of the work queue to service REST and CAPD requests (default: %d)",
+                DEFAULT_HTTP_REST_WORKQUEUE))
+        .addArg("rpcpollthreads=<n>", requiredInt,
+            strprintf(_("Set the number of threads to service long polls like capd poll, which wait for messages "
+                        "(default: %d)"),
+                DEFAULT_HTTP_POLL_THREADS))
+        .addDebugArg("rpcpollworkqueue=<n>", requiredInt,
+            strprintf("Set the depth of the work queue to service long polls (default: %d)",
+                DEFAULT_HTTP_POLL_WORKQUEUE))
+        .addArg("rpclisteners=<n>", requiredInt,
+            strprintf(_("Set the number of threads accepting RPC and REST connections. More than one shares the "
+                        "listening sockets with SO_REUSEPORT (default: %d)"),
+                DEFAULT_HTTP_LISTENERS))
         .addDebugArg("rpcservertimeout=<n>", requiredInt,
             strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT))
         // Although a node does not use rpcconnect it must be allowed because NexaCli also uses the same config file
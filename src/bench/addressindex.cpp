@@ -0,0 +1,111 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "index/addressindex.h"
+#include "random.h"
+#include "txdb.h"
+
+//! history entries of the heavily used scripthash, spread evenly over the chain
+static const uint32_t HISTORY_ENTRIES = 1000000;
+static const uint32_t HISTORY_BLOCKS = 100000;
+static const uint32_t UNSPENT_ENTRIES = 100000;
+
+/** One in-memory address index with a single scripthash that has 1M history entries and 100k unspent outputs,
+ *  the shape of a busy exchange or mining pool address */
+static AddressIndexDB &GetBusyAddressIndex(uint256 &scripthash)
+{
+    static std::unique_ptr<AddressIndexDB> db;
+    static uint256 busy;
+    if (!db)
+    {
+        db.reset(new AddressIndexDB(8 << 20, true, true));
+        busy = GetRandHash();
+
+        CAddressBalance balance;
+        CAddressIndexUpdate update;
+        for (uint32_t i = 0; i < HISTORY_ENTRIES; i++)
+        {
+            const uint32_t height = i / (HISTORY_ENTRIES / HISTORY_BLOCKS);
+            const uint256 txhash = GetRandHash();
+            update.historyWrite.emplace_back(
+                CAddressHistoryKey(busy, height, txhash, 0, false), CAddressHistoryValue(COIN));
+            if (i < UNSPENT_ENTRIES)
+            {
+                update.unspentWrite.emplace_back(
+                    std::make_pair(busy, GetRandHash()), CAddressUnspentValue(txhash, 0, height, COIN));
+            }
+            balance.received += COIN;
+            balance.balance += COIN;
+            balance.nHistory++;
+
+            if (update.historyWrite.size() == 10000)
+            {
+                db->WriteUpdate(update, CBlockLocator());
+                update = CAddressIndexUpdate();
+            }
+        }
+        balance.nUnspent = UNSPENT_ENTRIES;
+        update.balances[busy] = balance;
+        db->WriteUpdate(update, CBlockLocator());
+    }
+    scripthash = busy;
+    return *db;
+}
+
+static void AddressIndexBalance(benchmark::State &state)
+{
+    uint256 scripthash;
+    AddressIndexDB &db = GetBusyAddressIndex(scripthash);
+    while (state.KeepRunning())
+    {
+        CAddressBalance balance;
+        db.ReadBalance(scripthash, balance);
+        assert(balance.nHistory == HISTORY_ENTRIES);
+    }
+}
+
+static void AddressIndexHistoryPage(benchmark::State &state)
+{
+    uint256 scripthash;
+    AddressIndexDB &db = GetBusyAddressIndex(scripthash);
+    uint32_t nFromHeight = 0;
+    while (state.KeepRunning())
+    {
+        std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > entries;
+        db.ReadHistory(scripthash, nFromHeight, 1000, entries);
+        assert(entries.size() == 1000);
+        nFromHeight = (nFromHeight + 7919) % (HISTORY_BLOCKS - 1000);
+    }
+}
+
+static void AddressIndexHistoryFull(benchmark::State &state)
+{
+    uint256 scripthash;
+    AddressIndexDB &db = GetBusyAddressIndex(scripthash);
+    while (state.KeepRunning())
+    {
+        std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > entries;
+        db.ReadHistory(scripthash, 0, HISTORY_ENTRIES, entries);
+        assert(entries.size() == HISTORY_ENTRIES);
+    }
+}
+
+static void AddressIndexUtxoPage(benchmark::State &state)
+{
+    uint256 scripthash;
+    AddressIndexDB &db = GetBusyAddressIndex(scripthash);
+    uint256 after;
+    while (state.KeepRunning())
+    {
+        std::vector<std::pair<uint256, CAddressUnspentValue> > entries;
+        db.ReadUnspent(scripthash, after, 1000, entries);
+        after = entries.size() == 1000 ? entries.back().first : uint256();
+    }
+}
+
+BENCHMARK(AddressIndexBalance, 100000);
+BENCHMARK(AddressIndexHistoryPage, 500);
+BENCHMARK(AddressIndexHistoryFull, 1);
+BENCHMARK(AddressIndexUtxoPage, 500);
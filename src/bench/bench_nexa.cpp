@@ -13,6 +13,7 @@
 #include "rpc/client.h"
 #include "sync.h"
 #include "util.h"
+#include "workerpool.h"
 
 #include <boost/lexical_cast.hpp>
 #include <memory>
@@ -54,5 +55,7 @@ int main(int argc, char *argv[])
             GetArg("-plot-width", DEFAULT_PLOT_WIDTH), GetArg("-plot-height", DEFAULT_PLOT_HEIGHT)));
     }
 
+    workerPool.Start(GetNumCores() - 1, "worker");
     benchmark::BenchRunner::RunAll(*printer, evaluations, scaling_factor, regex_filter, is_list_only);
+    workerPool.Stop();
 }
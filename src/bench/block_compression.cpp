@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "nexa-config.h"
+#endif
+
+#include "bench.h"
+#include "bench/data.h"
+#include "blockstorage/blockcompression.h"
+
+#include <cassert>
+
+#if defined(USE_LZ4) || defined(USE_ZSTD)
+
+/**
+ * The bundled block is used as raw bytes, which is what a storage record is; it does not need to deserialize as a
+ * nexa block for the codecs. The read/decompress throughput is the block size divided by the time per iteration.
+ */
+static std::vector<unsigned char> CompressBlock(BlockCompression codec, int nLevel)
+{
+    const std::vector<uint8_t> &raw = benchmark::data::block413567;
+    std::vector<unsigned char> record;
+    bool fCompressed = CompressRecord(codec, nLevel, raw.data(), raw.size(), record);
+    assert(fCompressed);
+    return record;
+}
+
+static void CompressBlockBench(benchmark::State &state, BlockCompression codec, int nLevel)
+{
+    const std::vector<uint8_t> &raw = benchmark::data::block413567;
+    std::vector<unsigned char> record;
+    while (state.KeepRunning())
+    {
+        CompressRecord(codec, nLevel, raw.data(), raw.size(), record);
+    }
+}
+
+static void DecompressBlockBench(benchmark::State &state, BlockCompression codec, int nLevel)
+{
+    const std::vector<unsigned char> record = CompressBlock(codec, nLevel);
+    std::vector<unsigned char> raw;
+    while (state.KeepRunning())
+    {
+        DecompressRecord(record.data(), record.size(), raw);
+    }
+    assert(raw == benchmark::data::block413567);
+}
+
+#ifdef USE_LZ4
+static void CompressBlockLZ4(benchmark::State &state) { CompressBlockBench(state, BlockCompression::LZ4, 0); }
+static void CompressBlockLZ4HC(benchmark::State &state) { CompressBlockBench(state, BlockCompression::LZ4, 9); }
+static void DecompressBlockLZ4(benchmark::State &state) { DecompressBlockBench(state, BlockCompression::LZ4, 0); }
+BENCHMARK(CompressBlockLZ4, 500);
+BENCHMARK(CompressBlockLZ4HC, 20);
+BENCHMARK(DecompressBlockLZ4, 1500);
+#endif
+
+#ifdef USE_ZSTD
+static void CompressBlockZstd(benchmark::State &state) { CompressBlockBench(state, BlockCompression::ZSTD, 0); }
+static void CompressBlockZstd19(benchmark::State &state) { CompressBlockBench(state, BlockCompression::ZSTD, 19); }
+static void DecompressBlockZstd(benchmark::State &state) { DecompressBlockBench(state, BlockCompression::ZSTD, 0); }
+BENCHMARK(CompressBlockZstd, 200);
+BENCHMARK(CompressBlockZstd19, 2);
+BENCHMARK(DecompressBlockZstd, 500);
+#endif
+#endif
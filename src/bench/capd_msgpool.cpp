@@ -0,0 +1,122 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "capd/capd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+// A messaging service receiving 100k messages per minute.  Each iteration is one second of that traffic.
+static const size_t MSGS_PER_SECOND = 100000 / 60;
+// Distinct seconds of traffic to replay.  The pool holds less than this, so replayed messages are new to it.
+static const size_t SECONDS = 6;
+// Messages arrive in bursts of this many, as in a CAPDMSG network message
+static const size_t BURST_SIZE = 100;
+
+static void CapdMessageStream(benchmark::State &state)
+{
+    std::vector<CapdMsgRef> msgs;
+    for (size_t i = 0; i < MSGS_PER_SECOND * SECONDS; i++)
+    {
+        CapdMsgRef m = std::make_shared<CapdMsg>("capd bench message " + std::to_string(i));
+        m->SetPowTarget(ArithToUint256(MIN_LOCAL_MSG_DIFFICULTY));
+        m->Solve();
+        msgs.push_back(m);
+    }
+
+    CapdMsgPool pool;
+    pool.SetMaxSize(2 * MSGS_PER_SECOND * msgs[0]->RamSize());
+    size_t next = 0;
+    while (state.KeepRunning())
+    {
+        for (size_t b = 0; b < MSGS_PER_SECOND; b += BURST_SIZE)
+        {
+            std::vector<CapdMsgRef> burst;
+            for (size_t i = 0; i < BURST_SIZE && b + i < MSGS_PER_SECOND; i++)
+            {
+                // Copy the message so its hash has to be calculated again, as it would be for one off the network
+                burst.push_back(MsgRefCopy(*msgs[next]));
+                burst.back()->cachedHash = uint256();
+                next = (next + 1) % msgs.size();
+            }
+
+            std::vector<unsigned char> powOk = capdProtocol.CheckPow(burst);
+            for (size_t i = 0; i < burst.size(); i++)
+            {
+                assert(powOk[i]);
+                try
+                {
+                    pool.add(burst[i]);
+                }
+                catch (CapdMsgPoolException &e)
+                {
+                }
+            }
+            // Nodes ask for the relay priority whenever they request messages
+            pool.GetRelayPriority();
+        }
+    }
+}
+
+// One second of the same traffic delivered to 10k subscribers, each watching one of 1000 prefixes
+static void CapdSubscriptionFanout(benchmark::State &state)
+{
+    const size_t SUBSCRIBERS = 10000;
+    const size_t PREFIXES = 1000;
+    CapdSubscriptions subs;
+    std::vector<uint64_t> ids;
+    for (size_t i = 0; i < SUBSCRIBERS; i++)
+    {
+        std::string prefix = "topic" + std::to_string(i % PREFIXES) + ":";
+        ids.push_back(subs.Subscribe(std::vector<unsigned char>(prefix.begin(), prefix.end()), 100));
+    }
+    std::vector<CapdMsgRef> msgs;
+    for (size_t i = 0; i < MSGS_PER_SECOND; i++)
+        msgs.push_back(std::make_shared<CapdMsg>("topic" + std::to_string(i % PREFIXES) + ":" + std::to_string(i)));
+
+    std::vector<CapdMsgRef> polled;
+    uint64_t dropped;
+    while (state.KeepRunning())
+    {
+        for (const auto &msg : msgs)
+            subs.Notify(msg);
+        for (uint64_t id : ids)
+            subs.Poll(id, 100, 0, polled, dropped);
+    }
+}
+
+// Solve messages at a difficulty on every core.  Solves per second fall as the target shrinks.
+static void CapdSolve(benchmark::State &state, const char *target)
+{
+    const unsigned int nThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    uint64_t i = 0;
+    while (state.KeepRunning())
+    {
+        CapdMsg msg("capd solve bench " + std::to_string(i++));
+        msg.SetPowTarget(uint256S(target));
+        bool solved = msg.Solve(0, nThreads);
+        assert(solved);
+    }
+}
+
+static void CapdSolveLocal(benchmark::State &state)
+{
+    CapdSolve(state, "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+}
+static void CapdSolve16Bits(benchmark::State &state)
+{
+    CapdSolve(state, "0000ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+}
+static void CapdSolve20Bits(benchmark::State &state)
+{
+    CapdSolve(state, "00000fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+}
+
+BENCHMARK(CapdMessageStream, 100);
+BENCHMARK(CapdSubscriptionFanout, 100);
+BENCHMARK(CapdSolveLocal, 1000);
+BENCHMARK(CapdSolve16Bits, 100);
+BENCHMARK(CapdSolve20Bits, 10);
@@ -5,9 +5,14 @@
 #include <bench/bench.h>
 #include <bench/data.h>
 
+#include "arith_uint256.h"
 #include "chainparams.h"
+#include "primitives/block.h"
+#include "streams.h"
 #include "validation/validation.h"
 
+#include <thread>
+
 #if 0 //  TODO: acquire a real nexa block
 
 // These are the two major time-sinks which happen after we have fully received
@@ -51,3 +56,52 @@ BENCHMARK(DeserializeBlockTest, 130);
 BENCHMARK(DeserializeAndCheckBlockTest, 160);
 
 #endif
+
+// A block of many small transactions, serialized once, to measure how fast transactions are read and hashed
+static CDataStream SyntheticBlockStream()
+{
+    CBlock block;
+    for (uint32_t i = 0; i < 4000; i++)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(2);
+        for (uint32_t j = 0; j < tx.vin.size(); j++)
+        {
+            tx.vin[j].prevout.hash = ArithToUint256(arith_uint256(i * 2 + j + 1));
+            tx.vin[j].scriptSig << std::vector<unsigned char>(100, i) << std::vector<unsigned char>(33, j);
+        }
+        tx.vout.resize(2);
+        for (auto &out : tx.vout)
+            out.scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i) << OP_EQUALVERIFY
+                                         << OP_CHECKSIG;
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block;
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+    return stream;
+}
+
+static void DeserializeTransactions(benchmark::State &state, unsigned int nThreads)
+{
+    CDataStream stream = SyntheticBlockStream();
+    const size_t nSize = stream.size() - 1;
+    while (state.KeepRunning())
+    {
+        CBlock block;
+        stream >> *(CBlockHeader *)&block;
+        UnserializeTransactions(stream, ReadCompactSize(stream), block.vtx, nThreads);
+        bool rewound = stream.Rewind(nSize);
+        assert(rewound);
+    }
+}
+
+static void DeserializeTransactionsSerial(benchmark::State &state) { DeserializeTransactions(state, 1); }
+static void DeserializeTransactionsParallel(benchmark::State &state)
+{
+    DeserializeTransactions(state, std::max(std::thread::hardware_concurrency(), 1U));
+}
+
+BENCHMARK(DeserializeTransactionsSerial, 50);
+BENCHMARK(DeserializeTransactionsParallel, 50);
@@ -61,6 +61,47 @@ static void SHA256D64_1024(benchmark::State &state)
     }
 }
 
+/* 1024 messages of 32 to 287 bytes, the sizes of transaction and sighash component serializations */
+static std::vector<std::vector<uint8_t> > MixedMessages()
+{
+    std::vector<std::vector<uint8_t> > msgs(1024);
+    for (size_t i = 0; i < msgs.size(); i++)
+        msgs[i].assign(32 + (i * 37) % 256, (uint8_t)i);
+    return msgs;
+}
+
+static void SHA256D_1024(benchmark::State &state)
+{
+    std::vector<std::vector<uint8_t> > msgs = MixedMessages();
+    std::vector<uint8_t> out(32 * msgs.size());
+    while (state.KeepRunning())
+    {
+        for (size_t i = 0; i < msgs.size(); i++)
+        {
+            uint8_t hash[CSHA256::OUTPUT_SIZE];
+            CSHA256().Write(msgs[i].data(), msgs[i].size()).Finalize(hash);
+            CSHA256().Write(hash, sizeof(hash)).Finalize(&out[32 * i]);
+        }
+    }
+}
+
+static void SHA256DMulti_1024(benchmark::State &state)
+{
+    std::vector<std::vector<uint8_t> > msgs = MixedMessages();
+    std::vector<const uint8_t *> inputs;
+    std::vector<size_t> lengths;
+    for (const std::vector<uint8_t> &msg : msgs)
+    {
+        inputs.push_back(msg.data());
+        lengths.push_back(msg.size());
+    }
+    std::vector<uint8_t> out(32 * msgs.size());
+    while (state.KeepRunning())
+    {
+        SHA256DMulti(out.data(), inputs.data(), lengths.data(), msgs.size());
+    }
+}
+
 static void SHA512(benchmark::State &state)
 {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
@@ -107,5 +148,7 @@ BENCHMARK(SHA512, 330);
 BENCHMARK(SHA256_32b, 4700 * 1000);
 BENCHMARK(SipHash_32b, 40 * 1001 * 1000);
 BENCHMARK(SHA256D64_1024, 7400);
+BENCHMARK(SHA256D_1024, 1500);
+BENCHMARK(SHA256DMulti_1024, 1500);
 BENCHMARK(FastRandom_32bit, 110 * 1000 * 1000);
 BENCHMARK(FastRandom_1bit, 440 * 1000 * 1000);
@@ -0,0 +1,149 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "DoubleSpendProof.h"
+#include "DoubleSpendProofStorage.h"
+#include "key.h"
+#include "random.h"
+#include "script/sighashtype.h"
+#include "script/standard.h"
+#include "streams.h"
+#include "version.h"
+
+#include <cassert>
+#include <thread>
+
+// A double spend attack on many coins at once: every proof is for a different outpoint
+static const size_t FLOOD_SIZE = 10000;
+// Message handler threads receiving the flood
+static const size_t FLOOD_THREADS = 4;
+
+struct FloodProof
+{
+    DoubleSpendProof proof;
+    DoubleSpendProof::SpentOutput spent;
+};
+
+// Build proofs of double spends of P2PKH outputs of key, with valid signatures
+static std::vector<FloodProof> MakeFlood(const CKey &key)
+{
+    FastRandomContext rng(true);
+    std::vector<FloodProof> flood(FLOOD_SIZE);
+    for (size_t i = 0; i < flood.size(); i++)
+    {
+        FloodProof &item = flood[i];
+        item.spent.prevOutScript = GetScriptForDestination(key.GetPubKey().GetID());
+        item.spent.amount = COIN;
+        item.spent.pubkey = ToByteVector(key.GetPubKey());
+
+        // The spenders must be sorted by their outputs hash
+        uint256 hashOutputs[2] = {rng.rand256(), rng.rand256()};
+        if (hashOutputs[0] > hashOutputs[1])
+            std::swap(hashOutputs[0], hashOutputs[1]);
+
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << COutPoint(rng.rand256());
+        for (int s = 0; s < 2; s++)
+        {
+            const uint32_t txVersion = 0;
+            const uint32_t outSequence = s;
+            const uint32_t lockTime = i;
+            const uint256 hashPrevOutputs = rng.rand256();
+            const uint256 hashSequence = rng.rand256();
+            const uint256 hashInAmounts;
+            uint256 sighash;
+            bool ok = SignatureHashNexa(item.spent.prevOutScript, txVersion, lockTime, SigHashType(), hashPrevOutputs,
+                hashSequence, hashInAmounts, hashOutputs[s], sighash, nullptr);
+            assert(ok);
+            std::vector<std::vector<uint8_t> > pushData(1);
+            key.SignSchnorr(sighash, pushData[0]);
+            ss << txVersion << outSequence << lockTime << hashPrevOutputs << hashSequence << hashInAmounts
+               << hashOutputs[s] << pushData;
+        }
+        ss >> item.proof;
+    }
+    return flood;
+}
+
+// Store the flood as orphans from several threads, then resolve each one as its double spend arrives
+static void DoubleSpendProofStorageFlood(benchmark::State &state)
+{
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<FloodProof> flood = MakeFlood(key);
+
+    while (state.KeepRunning())
+    {
+        DoubleSpendProofStorage storage;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < FLOOD_THREADS; t++)
+        {
+            threads.emplace_back(
+                [&storage, &flood, t]()
+                {
+                    for (size_t i = t; i < flood.size(); i += FLOOD_THREADS)
+                        storage.addOrphan(flood[i].proof, t);
+                    for (size_t i = t; i < flood.size(); i += FLOOD_THREADS)
+                    {
+                        for (const auto &orphan : storage.findOrphans(flood[i].proof.Outpoint()))
+                            storage.claimOrphan(orphan.first);
+                    }
+                });
+        }
+        for (auto &t : threads)
+            t.join();
+        assert(storage.size() == flood.size());
+    }
+    ECC_Stop();
+}
+
+// Check the signatures of the flood on the thread that received it, as proofs were handled before
+static void DoubleSpendProofVerifyFloodSerial(benchmark::State &state)
+{
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<FloodProof> flood = MakeFlood(key);
+
+    while (state.KeepRunning())
+    {
+        for (const FloodProof &item : flood)
+        {
+            DoubleSpendProof::Validity validity = item.proof.checkSignatures(item.spent);
+            assert(validity == DoubleSpendProof::Valid);
+        }
+    }
+    ECC_Stop();
+}
+
+// Hand the flood to the worker pool
+static void DoubleSpendProofVerifyFloodQueued(benchmark::State &state)
+{
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<FloodProof> flood = MakeFlood(key);
+
+    CDoubleSpendProofVerifier verifier;
+    while (state.KeepRunning())
+    {
+        for (const FloodProof &item : flood)
+        {
+            if (!verifier.Enqueue(item.proof, item.spent, 0))
+                item.proof.checkSignatures(item.spent);
+        }
+        verifier.Wait();
+    }
+    verifier.Stop();
+    ECC_Stop();
+}
+
+BENCHMARK(DoubleSpendProofStorageFlood, 10);
+BENCHMARK(DoubleSpendProofVerifyFloodSerial, 2);
+BENCHMARK(DoubleSpendProofVerifyFloodQueued, 2);
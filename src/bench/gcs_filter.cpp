@@ -0,0 +1,69 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "blockfilter.h"
+#include "random.h"
+
+//! about the number of distinct output scripts in a busy block
+static const int GCS_ELEMENTS = 10000;
+
+static GCSFilter::ElementSet MakeElements(int nElements)
+{
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < nElements; ++i)
+    {
+        // a P2PKT-sized script
+        GCSFilter::Element element(32);
+        GetRandBytes(element.data(), element.size());
+        elements.insert(std::move(element));
+    }
+    return elements;
+}
+
+static const GCSFilter::Params GCS_PARAMS(0, 0, BASIC_FILTER_P, BASIC_FILTER_M);
+
+static void GCSFilterConstruct(benchmark::State &state)
+{
+    const GCSFilter::ElementSet elements = MakeElements(GCS_ELEMENTS);
+    while (state.KeepRunning())
+    {
+        GCSFilter filter(GCS_PARAMS, elements);
+    }
+}
+
+static void GCSFilterDecode(benchmark::State &state)
+{
+    const std::vector<unsigned char> encoded = GCSFilter(GCS_PARAMS, MakeElements(GCS_ELEMENTS)).GetEncoded();
+    while (state.KeepRunning())
+    {
+        GCSFilter filter(GCS_PARAMS, encoded);
+    }
+}
+
+static void GCSFilterMatch(benchmark::State &state)
+{
+    const GCSFilter filter(GCS_PARAMS, MakeElements(GCS_ELEMENTS));
+    const GCSFilter::Element query(32, 0x42);
+    while (state.KeepRunning())
+    {
+        filter.Match(query);
+    }
+}
+
+/** A light wallet checking its 100 scripts against one block */
+static void GCSFilterMatchAny(benchmark::State &state)
+{
+    const GCSFilter filter(GCS_PARAMS, MakeElements(GCS_ELEMENTS));
+    const GCSFilter::ElementSet queries = MakeElements(100);
+    while (state.KeepRunning())
+    {
+        filter.MatchAny(queries);
+    }
+}
+
+BENCHMARK(GCSFilterConstruct, 100);
+BENCHMARK(GCSFilterDecode, 100);
+BENCHMARK(GCSFilterMatch, 1000);
+BENCHMARK(GCSFilterMatchAny, 1000);
@@ -5,18 +5,25 @@
 #include "bench.h"
 
 #include "consensus/merkle.h"
+#include "merkleblock.h"
 #include "random.h"
 #include "uint256.h"
 
-static void MerkleRoot(benchmark::State &state)
+static std::vector<uint256> RandomLeaves(size_t nLeaves)
 {
     FastRandomContext rng(true);
     std::vector<uint256> leaves;
-    leaves.resize(9001);
+    leaves.resize(nLeaves);
     for (auto &item : leaves)
     {
         item = rng.rand256();
     }
+    return leaves;
+}
+
+static void MerkleRoot(benchmark::State &state)
+{
+    std::vector<uint256> leaves = RandomLeaves(9001);
     while (state.KeepRunning())
     {
         bool mutation = false;
@@ -25,4 +32,44 @@ static void MerkleRoot(benchmark::State &state)
     }
 }
 
+static void MerkleRoot1M(benchmark::State &state, unsigned int nThreads)
+{
+    std::vector<uint256> leaves = RandomLeaves(1000000);
+    while (state.KeepRunning())
+    {
+        bool mutation = false;
+        uint256 hash = ComputeMerkleRoot(std::vector<uint256>(leaves), &mutation, nThreads);
+        leaves[mutation] = hash;
+    }
+}
+
+static void MerkleRoot1MSerial(benchmark::State &state) { MerkleRoot1M(state, 1); }
+static void MerkleRoot1MParallel(benchmark::State &state) { MerkleRoot1M(state, 0); }
+
+static void MerkleTree1M(benchmark::State &state)
+{
+    std::vector<uint256> leaves = RandomLeaves(1000000);
+    while (state.KeepRunning())
+    {
+        CMerkleTree tree(leaves);
+        leaves[0] = tree.GetRoot();
+    }
+}
+
+// Single transaction proofs taken from a tree that has already been built, as for a burst of gettxoutproof calls
+static void MerkleProofFromTree1M(benchmark::State &state)
+{
+    const CMerkleTree tree(RandomLeaves(1000000));
+    uint32_t pos = 0;
+    while (state.KeepRunning())
+    {
+        CPartialMerkleTree pmt(tree, {pos});
+        pos = (pos + 7919) % tree.GetNumLeaves();
+    }
+}
+
 BENCHMARK(MerkleRoot, 800);
+BENCHMARK(MerkleRoot1MSerial, 10);
+BENCHMARK(MerkleRoot1MParallel, 10);
+BENCHMARK(MerkleTree1M, 10);
+BENCHMARK(MerkleProofFromTree1M, 200000);
@@ -3,26 +3,47 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
-#include <bench/data.h>
 #include <chainparams.h>
 #include <test/test_nexa.h>
 
+#include <arith_uint256.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 #include <streams.h>
 #include <validation/validation.h>
 
 #include <univalue.h>
 
-#if 0 // TODO reenable when a large and real nextchain block becomes available
-static void BlockToJsonVerbose(benchmark::State &state)
+// TODO use a large and real nextchain block when one becomes available.  Until then this block of many ordinary
+// transactions stands in for one.
+static CBlock SyntheticBlock()
 {
-    TestingSetup test_setup(CBaseChainParams::REGTEST);
-    CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
-    char a = '\0';
-    stream.write(&a, 1); // Prevent compaction
-
     CBlock block;
-    stream >> block;
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(2);
+        for (uint32_t j = 0; j < tx.vin.size(); j++)
+        {
+            tx.vin[j].prevout.hash = ArithToUint256(arith_uint256(i * 2 + j + 1));
+            tx.vin[j].scriptSig << std::vector<unsigned char>(100, i) << std::vector<unsigned char>(33, j);
+        }
+        tx.vout.resize(2);
+        for (uint32_t j = 0; j < tx.vout.size(); j++)
+        {
+            tx.vout[j].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, i)
+                                                << OP_EQUALVERIFY << OP_CHECKSIG;
+            tx.vout[j].nValue = (i + j) * COIN;
+        }
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    return block;
+}
+
+static void BlockToJson(benchmark::State &state, bool fStreamed)
+{
+    TestingSetup test_setup(CBaseChainParams::REGTEST);
+    const CBlock block = SyntheticBlock();
 
     CBlockIndex blockindex;
     const uint256 blockHash = block.GetHash();
@@ -31,9 +52,25 @@ static void BlockToJsonVerbose(benchmark::State &state)
 
     while (state.KeepRunning())
     {
-        (void)blockToJSON(block, &blockindex, /*verbose*/ true);
+        if (!fStreamed)
+        {
+            (void)blockToJSON(block, &blockindex, /*verbose*/ true).write();
+            continue;
+        }
+        // The same output written in chunks to a sink that only counts the bytes
+        uint64_t nBytes = 0;
+        JSONStreamWriter out([&nBytes](const std::string &chunk) {
+            nBytes += chunk.size();
+            return true;
+        });
+        blockToJSON(out, block, &blockindex, /*verbose*/ true);
+        out.Flush();
+        assert(nBytes == out.BytesWritten());
     }
 }
 
+static void BlockToJsonVerbose(benchmark::State &state) { BlockToJson(state, false); }
+static void BlockToJsonVerboseStreamed(benchmark::State &state) { BlockToJson(state, true); }
+
 BENCHMARK(BlockToJsonVerbose, 10);
-#endif
+BENCHMARK(BlockToJsonVerboseStreamed, 10);
@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <policy/policy.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 #include <txmempool.h>
 
 #include <univalue.h>
@@ -48,7 +49,7 @@ static void RpcMempool(benchmark::State &state)
     }
 }
 
-static void RpcMempool10k(benchmark::State &state)
+static void FillMempool10k()
 {
     mempool.clear();
 
@@ -72,12 +73,36 @@ static void RpcMempool10k(benchmark::State &state)
         const CTransactionRef tx_r{MakeTransactionRef(tx)};
         AddTx(tx_r, /* fee */ int64_t(i) * COIN);
     }
+}
+
+static void RpcMempool10k(benchmark::State &state)
+{
+    FillMempool10k();
 
     while (state.KeepRunning())
     {
-        (void)mempoolToJSON(true);
+        (void)mempoolToJSON(true).write();
+    }
+}
+
+// The same output as RpcMempool10k, written in chunks to a sink that only counts the bytes
+static void RpcMempool10kStreamed(benchmark::State &state)
+{
+    FillMempool10k();
+
+    while (state.KeepRunning())
+    {
+        uint64_t nBytes = 0;
+        JSONStreamWriter out([&nBytes](const std::string &chunk) {
+            nBytes += chunk.size();
+            return true;
+        });
+        mempoolToJSON(out, true);
+        out.Flush();
+        assert(nBytes == out.BytesWritten());
     }
 }
 
 BENCHMARK(RpcMempool, 40);
 BENCHMARK(RpcMempool10k, 10);
+BENCHMARK(RpcMempool10kStreamed, 10);
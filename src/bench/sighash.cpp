@@ -0,0 +1,74 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "primitives/transaction.h"
+#include "script/sighashtype.h"
+#include "script/standard.h"
+
+#include <cassert>
+
+/** A consolidation transaction: nInputs inputs paying to two outputs */
+static CTransaction MakeConsolidationTx(size_t nInputs)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(nInputs);
+    for (size_t i = 0; i < nInputs; i++)
+    {
+        uint256 hash;
+        *hash.begin() = i & 0xff;
+        *(hash.begin() + 1) = (i >> 8) & 0xff;
+        tx.vin[i].prevout = COutPoint(hash);
+        tx.vin[i].amount = 1000 + i;
+        tx.vin[i].nSequence = CTxIn::SEQUENCE_FINAL;
+    }
+    tx.vout.resize(2);
+    tx.vout[0].scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 1) << OP_EQUALVERIFY
+                                        << OP_CHECKSIG;
+    tx.vout[0].nValue = 1000 * nInputs;
+    tx.vout[1].scriptPubKey = tx.vout[0].scriptPubKey;
+    tx.vout[1].nValue = 1000;
+    return CTransaction(tx);
+}
+
+/**
+ * Compute the signature hash of every input, as validating the transaction does. Without the precomputed data this
+ * is quadratic in the number of inputs; 10k inputs take tens of seconds that way, so only the precomputed case is run
+ * at that size.
+ */
+static void SighashAllInputs(benchmark::State &state, size_t nInputs, const SigHashType &sigHashType, bool fPrecompute)
+{
+    const CTransaction tx = MakeConsolidationTx(nInputs);
+    const CScript scriptCode = tx.vout[0].scriptPubKey;
+    uint256 sighash;
+    while (state.KeepRunning())
+    {
+        std::unique_ptr<PrecomputedTransactionData> txdata;
+        if (fPrecompute)
+            txdata.reset(new PrecomputedTransactionData(tx));
+        for (size_t i = 0; i < nInputs; i++)
+        {
+            bool ok = SignatureHashNexa(scriptCode, tx, i, sigHashType, sighash, nullptr, txdata.get());
+            assert(ok);
+        }
+    }
+}
+
+static void SighashAll1k(benchmark::State &state) { SighashAllInputs(state, 1000, SigHashType(), false); }
+static void SighashAll1kPrecomputed(benchmark::State &state) { SighashAllInputs(state, 1000, SigHashType(), true); }
+static void SighashAll10kPrecomputed(benchmark::State &state) { SighashAllInputs(state, 10000, SigHashType(), true); }
+static void SighashFirstN1k(benchmark::State &state)
+{
+    SighashAllInputs(state, 1000, SigHashType().setFirstNIn(255), false);
+}
+static void SighashFirstN1kPrecomputed(benchmark::State &state)
+{
+    SighashAllInputs(state, 1000, SigHashType().setFirstNIn(255), true);
+}
+
+BENCHMARK(SighashAll1k, 3);
+BENCHMARK(SighashAll1kPrecomputed, 500);
+BENCHMARK(SighashAll10kPrecomputed, 75);
+BENCHMARK(SighashFirstN1k, 50);
+BENCHMARK(SighashFirstN1kPrecomputed, 1000);
@@ -9,7 +9,11 @@
 #include "script/bitcoinconsensus.h"
 #endif
 #include "consensus/validation.h"
+#include "policy/policy.h"
+#include "script/bignum.h"
+#include "script/compiledscript.h"
 #include "script/script.h"
+#include "script/scripttemplate.h"
 #include "script/sign.h"
 #include "streams.h"
 
@@ -123,6 +127,117 @@ static void VerifyNestedIfScript(benchmark::State &state)
         assert(ret);
     }
 }
+
+// Modular arithmetic the way covenant scripts do it: set a modulus, then chain multiplies and adds
+static void VerifyBigNumScript(benchmark::State &state, unsigned int bits)
+{
+    const BigNum modulus = (bnOne << bits) - 189;
+    const BigNum x = modulus - 12345678;
+    const BigNum y = modulus / 3;
+    CScript script;
+    script << modulus.serialize(0) << OP_SETBMD << x.serialize(0) << OP_BIN2BIGNUM;
+    for (int i = 0; i < 45; ++i)
+    {
+        script << OP_DUP << OP_MUL << y.serialize(0) << OP_BIN2BIGNUM << OP_ADD;
+    }
+    while (state.KeepRunning())
+    {
+        Stack stack;
+        ScriptError error;
+        bool ret = EvalScript(stack, script, 0, MAX_OPS_PER_SCRIPT, ScriptImportedState(), &error);
+        assert(ret);
+    }
+}
+
+static void VerifyBigNum256Script(benchmark::State &state) { VerifyBigNumScript(state, 256); }
+static void VerifyBigNum512Script(benchmark::State &state) { VerifyBigNumScript(state, 512); }
+
+// A contract in the style of a template script: choose one of several spend paths, each a block of arithmetic.
+// Only the last path is taken, so three untaken branches are passed over on every run.
+static CScript BranchyContractScript()
+{
+    CScript script;
+    for (int path = 1; path <= 4; ++path)
+    {
+        script << OP_DUP << path << OP_NUMEQUAL << OP_IF << OP_DROP << OP_0;
+        for (int i = 0; i < 40; ++i)
+        {
+            script << OP_1 << OP_ADD;
+        }
+        script << OP_DROP << OP_ELSE;
+    }
+    script << OP_DROP;
+    for (int path = 1; path <= 4; ++path)
+    {
+        script << OP_ENDIF;
+    }
+    return script;
+}
+
+static void VerifyBranchyScript(benchmark::State &state, bool fCompiled)
+{
+    const CScript script = BranchyContractScript();
+    while (state.KeepRunning())
+    {
+        ScriptMachine sm(0, ScriptImportedState(), MAX_OPS_PER_SCRIPT, 0xffffffff);
+        sm.modifyStack().push_back(StackItem(VchStack, 1, 4));
+        bool ret = fCompiled ? sm.Eval(GetCompiledScript(script)) : sm.Eval(script);
+        assert(ret);
+    }
+}
+
+static void VerifyBranchyDecodedScript(benchmark::State &state) { VerifyBranchyScript(state, false); }
+static void VerifyBranchyCompiledScript(benchmark::State &state) { VerifyBranchyScript(state, true); }
+
+// Verify the template part of a P2PKT spend, either natively or by running the template in the script machine
+static void VerifyP2pktScript(benchmark::State &state, bool fNative)
+{
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+
+    const unsigned int flags = MANDATORY_SCRIPT_VERIFY_FLAGS;
+    CKey key;
+    static const std::array<unsigned char, 32> vchKey = {
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}};
+    key.Set(vchKey.begin(), vchKey.end(), true);
+    const CPubKey pubkey = key.GetPubKey();
+
+    const CMutableTransaction &txCredit = BuildCreditingTransaction(P2pktOutput(pubkey));
+    const CTransaction txSpend(BuildSpendingTransaction(CScript(), txCredit));
+    uint256 sighash;
+    bool hashed = SignatureHashNexa(p2pkt, txSpend, 0, defaultSigHashType, sighash);
+    assert(hashed);
+    std::vector<unsigned char> sig;
+    key.SignSchnorr(sighash, sig);
+    defaultSigHashType.appendToSig(sig);
+    const CScript constraint = CScript() << ToByteVector(pubkey);
+    const CScript satisfier = CScript() << sig;
+
+    TransactionSignatureChecker tsc(&txSpend, 0, flags);
+    ScriptImportedState sis(&tsc);
+    while (state.KeepRunning())
+    {
+        ScriptError err;
+        bool success = fNative ?
+                           VerifyTemplate(p2pkt, constraint, satisfier, flags, maxScriptTemplateOps, 0xffffffff, sis,
+                               &err, nullptr) :
+                           EvalTemplate(p2pkt, constraint, satisfier, flags, maxScriptTemplateOps, 0xffffffff, sis,
+                               &err, nullptr);
+        assert(err == SCRIPT_ERR_OK);
+        assert(success);
+    }
+    ECC_Stop();
+}
+
+static void VerifyP2pktNativeScript(benchmark::State &state) { VerifyP2pktScript(state, true); }
+static void VerifyP2pktMachineScript(benchmark::State &state) { VerifyP2pktScript(state, false); }
+
 BENCHMARK(VerifyScriptBench, 6300);
+BENCHMARK(VerifyP2pktNativeScript, 6300);
+BENCHMARK(VerifyP2pktMachineScript, 6300);
 
 BENCHMARK(VerifyNestedIfScript, 100);
+BENCHMARK(VerifyBigNum256Script, 1000);
+BENCHMARK(VerifyBigNum512Script, 500);
+BENCHMARK(VerifyBranchyDecodedScript, 5000);
+BENCHMARK(VerifyBranchyCompiledScript, 5000);
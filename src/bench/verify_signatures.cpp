@@ -0,0 +1,44 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "key.h"
+#include "pubkey.h"
+#include "random.h"
+
+#include <cassert>
+#include <thread>
+
+static const size_t BATCH_SIZE = 1000;
+
+// Verify a batch of Schnorr signatures of distinct hashes, as a payment processor checking signed messages would
+static void VerifySignatureBatch(benchmark::State &state, unsigned int nThreads)
+{
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+
+    FastRandomContext rng(true);
+    CKey key;
+    key.MakeNewKey(true);
+    std::vector<CHashSignature> batch(BATCH_SIZE);
+    for (auto &item : batch)
+    {
+        item.pubkey = key.GetPubKey();
+        item.hash = rng.rand256();
+        key.SignSchnorr(item.hash, item.sig);
+    }
+
+    while (state.KeepRunning())
+    {
+        std::vector<unsigned char> results = VerifySignatures(batch, nThreads);
+        assert(results[0] == 1);
+    }
+    ECC_Stop();
+}
+
+static void VerifySignatureBatchSerial(benchmark::State &state) { VerifySignatureBatch(state, 1); }
+static void VerifySignatureBatchParallel(benchmark::State &state) { VerifySignatureBatch(state, 0); }
+
+BENCHMARK(VerifySignatureBatchSerial, 20);
+BENCHMARK(VerifySignatureBatchParallel, 20);
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "crypto/common.h"
+#include "primitives/transaction.h"
+#include "script/script.h"
+#include "validationinterface.h"
+#include "zmq/zmqnotificationinterface.h"
+
+#include <cassert>
+#include <map>
+#include <string>
+#include <vector>
+
+// Transactions announced per iteration.  This stays under the default ZeroMQ high water marks, so that nothing is
+// dropped while the subscriber is not reading.
+static const size_t TXS_PER_ITERATION = 900;
+static const char *BENCH_ZMQ_ADDRESS = "tcp://127.0.0.1:28399";
+
+static std::vector<CTransactionRef> MakeTxs()
+{
+    std::vector<CTransactionRef> txs;
+    for (size_t i = 0; i < TXS_PER_ITERATION; i++)
+    {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << OP_1;
+        tx.vout.resize(2);
+        for (size_t j = 0; j < tx.vout.size(); j++)
+        {
+            tx.vout[j].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[j].nValue = (i + j) * COIN;
+        }
+        txs.push_back(MakeTransactionRef(tx));
+    }
+    return txs;
+}
+
+/** A local subscriber that reads messages until it has seen a given sequence number */
+class BenchSubscriber
+{
+public:
+    BenchSubscriber(const std::string &topic)
+    {
+        context = zmq_ctx_new();
+        socket = zmq_socket(context, ZMQ_SUB);
+        int timeout = 100;
+        zmq_setsockopt(socket, ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+        zmq_setsockopt(socket, ZMQ_SUBSCRIBE, topic.data(), topic.size());
+        int rc = zmq_connect(socket, BENCH_ZMQ_ADDRESS);
+        assert(rc == 0);
+    }
+
+    ~BenchSubscriber()
+    {
+        int linger = 0;
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_close(socket);
+        zmq_ctx_destroy(context);
+    }
+
+    /** Receive one message, returning its sequence number, or -1 on timeout */
+    int64_t Receive()
+    {
+        int64_t seq = -1;
+        int more = 1;
+        for (int part = 0; more; part++)
+        {
+            zmq_msg_t msg;
+            zmq_msg_init(&msg);
+            if (zmq_msg_recv(&msg, socket, 0) == -1)
+            {
+                zmq_msg_close(&msg);
+                return -1;
+            }
+            if (part == 2 && zmq_msg_size(&msg) == 4)
+                seq = ReadLE32((const unsigned char *)zmq_msg_data(&msg));
+            more = zmq_msg_more(&msg);
+            zmq_msg_close(&msg);
+        }
+        return seq;
+    }
+
+private:
+    void *context;
+    void *socket;
+};
+
+static void ZmqPublish(benchmark::State &state, const std::string &type, const std::string &topic, size_t nPerMessage)
+{
+    const std::vector<CTransactionRef> txs = MakeTxs();
+    std::map<std::string, std::string> args;
+    args["-zmq" + type] = BENCH_ZMQ_ADDRESS;
+    CZMQNotificationInterface *zmq = CZMQNotificationInterface::CreateWithArguments(args);
+    assert(zmq);
+    RegisterValidationInterface(zmq);
+
+    BenchSubscriber sub(topic);
+    // Until the subscription reaches the publisher its messages are thrown away, so keep announcing until one arrives
+    int64_t nSent = 0;
+    int64_t seq = -1;
+    while (seq < 0)
+    {
+        for (size_t i = 0; i < nPerMessage; i++)
+            SyncWithWallets(txs[nSent++ % txs.size()], nullptr, -1);
+        seq = sub.Receive();
+    }
+    while (seq + (int64_t)nPerMessage < nSent)
+        seq = sub.Receive();
+
+    while (state.KeepRunning())
+    {
+        // Announce as the validation threads would, then wait for the subscriber to see the last of it
+        for (const CTransactionRef &tx : txs)
+            SyncWithWallets(tx, nullptr, -1);
+        nSent += txs.size();
+        do
+        {
+            seq = sub.Receive();
+            assert(seq >= 0);
+        } while (seq + (int64_t)nPerMessage < nSent);
+    }
+
+    UnregisterValidationInterface(zmq);
+    delete zmq;
+}
+
+// One message per transaction
+static void ZmqPublishRawTx(benchmark::State &state) { ZmqPublish(state, "pubrawtx", "rawtx", 1); }
+// The same transactions, DEFAULT_ZMQ_BATCH_SIZE to a message
+static void ZmqPublishRawTxBatch(benchmark::State &state)
+{
+    ZmqPublish(state, "pubrawtxbatch", "txbatch", DEFAULT_ZMQ_BATCH_SIZE);
+}
+// Only the hashes, two messages per transaction
+static void ZmqPublishHashTx(benchmark::State &state) { ZmqPublish(state, "pubhashtx", "txidem", 1); }
+
+BENCHMARK(ZmqPublishRawTx, 20);
+BENCHMARK(ZmqPublishRawTxBatch, 20);
+BENCHMARK(ZmqPublishHashTx, 20);
@@ -0,0 +1,356 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilter.h"
+#include "crypto/common.h"
+#include "hashwrapper.h"
+#include "script/script.h"
+#include "streams.h"
+#include "undo.h"
+
+#include <algorithm>
+#include <ios>
+#include <map>
+
+static const std::map<BlockFilterType, std::string> g_filter_types = {
+    {BlockFilterType::BASIC, "basic"},
+};
+
+/** Map a 64 bit hash uniformly onto the range [0, n), without the bias or the cost of a modulo. */
+static inline uint64_t MapIntoRange(uint64_t x, uint64_t n)
+{
+#ifdef __SIZEOF_INT128__
+    return (static_cast<unsigned __int128>(x) * static_cast<unsigned __int128>(n)) >> 64;
+#else
+    // To perform the calculation on 64-bit numbers without losing the result to overflow, split the numbers into
+    // the most significant and least significant 32 bits and perform multiplication piece-wise.
+    uint64_t a_hi = x >> 32;
+    uint64_t a_lo = x & 0xFFFFFFFF;
+    uint64_t b_hi = n >> 32;
+    uint64_t b_lo = n & 0xFFFFFFFF;
+
+    uint64_t ab_hi = a_hi * b_hi;
+    uint64_t ab_mid = a_hi * b_lo;
+    uint64_t ba_mid = b_hi * a_lo;
+    uint64_t ab_lo = a_lo * b_lo;
+
+    uint64_t intermediate = ((ab_lo >> 32) + (ab_mid & 0xFFFFFFFF) + (ba_mid & 0xFFFFFFFF)) >> 32;
+    return ab_hi + (ab_mid >> 32) + (ba_mid >> 32) + intermediate;
+#endif
+}
+
+/** Appends bits to a byte vector, most significant bit first */
+class BitWriter
+{
+private:
+    std::vector<unsigned char> &out;
+    uint8_t buffer;
+    int offset; //!< number of bits already used in buffer
+
+public:
+    explicit BitWriter(std::vector<unsigned char> &_out) : out(_out), buffer(0), offset(0) {}
+    /** Write the nbits least significant bits of data, 0 < nbits <= 64 */
+    void Write(uint64_t data, int nbits)
+    {
+        while (nbits > 0)
+        {
+            int bits = std::min(8 - offset, nbits);
+            buffer |= (data << (64 - nbits)) >> (64 - 8 + offset);
+            offset += bits;
+            nbits -= bits;
+            if (offset == 8)
+                Flush();
+        }
+    }
+
+    /** Write out any partial byte, padding it with zero bits */
+    void Flush()
+    {
+        if (offset == 0)
+            return;
+        out.push_back(buffer);
+        buffer = 0;
+        offset = 0;
+    }
+};
+
+/** Reads bits from a byte range, most significant bit first */
+class BitReader
+{
+private:
+    const unsigned char *pos;
+    const unsigned char *const end;
+    uint8_t buffer;
+    int offset; //!< number of bits already consumed from buffer
+
+public:
+    BitReader(const unsigned char *_begin, const unsigned char *_end) : pos(_begin), end(_end), buffer(0), offset(8)
+    {
+    }
+
+    /** Read nbits bits as the least significant bits of the result, 0 < nbits <= 64 */
+    uint64_t Read(int nbits)
+    {
+        uint64_t data = 0;
+        while (nbits > 0)
+        {
+            if (offset == 8)
+            {
+                if (pos == end)
+                    throw std::ios_base::failure("GCS filter: unexpected end of data");
+                buffer = *pos++;
+                offset = 0;
+            }
+            int bits = std::min(8 - offset, nbits);
+            data <<= bits;
+            data |= static_cast<uint8_t>(buffer << offset) >> (8 - bits);
+            offset += bits;
+            nbits -= bits;
+        }
+        return data;
+    }
+};
+
+static void GolombRiceEncode(BitWriter &bitwriter, uint8_t P, uint64_t x)
+{
+    // Write quotient as unary-encoded: q 1's followed by one 0.
+    uint64_t q = x >> P;
+    while (q > 0)
+    {
+        int nbits = q <= 64 ? static_cast<int>(q) : 64;
+        bitwriter.Write(~0ULL, nbits);
+        q -= nbits;
+    }
+    bitwriter.Write(0, 1);
+
+    // Write the remainder in P bits. Since the remainder is just the bottom P bits of x, there is no need to mask
+    // first.
+    bitwriter.Write(x, P);
+}
+
+static uint64_t GolombRiceDecode(BitReader &bitreader, uint8_t P)
+{
+    // Read unary-encoded quotient: q 1's followed by one 0.
+    uint64_t q = 0;
+    while (bitreader.Read(1) == 1)
+    {
+        ++q;
+    }
+    uint64_t r = bitreader.Read(P);
+    return (q << P) + r;
+}
+
+GCSFilter::GCSFilter(const Params &_params) : params(_params), N(0), F(0), encoded(1, 0) {}
+GCSFilter::GCSFilter(const Params &_params, std::vector<unsigned char> encoded_filter)
+    : params(_params), encoded(std::move(encoded_filter))
+{
+    CDataStream stream(encoded, SER_NETWORK, PROTOCOL_VERSION);
+    uint64_t nElements = ReadCompactSize(stream);
+    N = static_cast<uint32_t>(nElements);
+    if (nElements != N)
+        throw std::ios_base::failure("N must be < 2^32");
+    F = static_cast<uint64_t>(N) * static_cast<uint64_t>(params.M);
+
+    // Surface any malformed encoding by attempting to decode every element.
+    const size_t nHeader = GetSizeOfCompactSize(N);
+    BitReader bitreader(encoded.data() + nHeader, encoded.data() + encoded.size());
+    for (uint64_t i = 0; i < N; ++i)
+    {
+        GolombRiceDecode(bitreader, params.P);
+    }
+}
+
+GCSFilter::GCSFilter(const Params &_params, const ElementSet &elements) : params(_params)
+{
+    size_t nElements = elements.size();
+    N = static_cast<uint32_t>(nElements);
+    if (nElements != N)
+        throw std::invalid_argument("N must be < 2^32");
+    F = static_cast<uint64_t>(N) * static_cast<uint64_t>(params.M);
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    WriteCompactSize(stream, N);
+    encoded.assign(stream.begin(), stream.end());
+    if (elements.empty())
+        return;
+
+    // Each element costs P + 1 bits plus the unary part, which averages about one more bit.
+    encoded.reserve(encoded.size() + (static_cast<size_t>(N) * (params.P + 2) + 7) / 8);
+
+    BitWriter bitwriter(encoded);
+    uint64_t last_value = 0;
+    for (uint64_t value : BuildHashedSet(elements))
+    {
+        uint64_t delta = value - last_value;
+        GolombRiceEncode(bitwriter, params.P, delta);
+        last_value = value;
+    }
+    bitwriter.Flush();
+}
+
+uint64_t GCSFilter::HashToRange(const Element &element) const
+{
+    uint64_t hash = CSipHasher(params.siphash_k0, params.siphash_k1).Write(element.data(), element.size()).Finalize();
+    return MapIntoRange(hash, F);
+}
+
+std::vector<uint64_t> GCSFilter::BuildHashedSet(const ElementSet &elements) const
+{
+    std::vector<uint64_t> hashed_elements;
+    hashed_elements.reserve(elements.size());
+    for (const Element &element : elements)
+    {
+        hashed_elements.push_back(HashToRange(element));
+    }
+    std::sort(hashed_elements.begin(), hashed_elements.end());
+    return hashed_elements;
+}
+
+bool GCSFilter::MatchInternal(const uint64_t *element_hashes, size_t size) const
+{
+    const size_t nHeader = GetSizeOfCompactSize(N);
+    BitReader bitreader(encoded.data() + nHeader, encoded.data() + encoded.size());
+
+    uint64_t value = 0;
+    size_t hashes_index = 0;
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        uint64_t delta = GolombRiceDecode(bitreader, params.P);
+        value += delta;
+
+        while (true)
+        {
+            if (hashes_index == size)
+            {
+                return false;
+            }
+            else if (element_hashes[hashes_index] == value)
+            {
+                return true;
+            }
+            else if (element_hashes[hashes_index] > value)
+            {
+                break;
+            }
+            hashes_index++;
+        }
+    }
+    return false;
+}
+
+bool GCSFilter::Match(const Element &element) const
+{
+    if (N == 0)
+        return false;
+    uint64_t query = HashToRange(element);
+    return MatchInternal(&query, 1);
+}
+
+bool GCSFilter::MatchAny(const ElementSet &elements) const
+{
+    if (N == 0 || elements.empty())
+        return false;
+    const std::vector<uint64_t> queries = BuildHashedSet(elements);
+    return MatchInternal(queries.data(), queries.size());
+}
+
+const std::string &BlockFilterTypeName(BlockFilterType filter_type)
+{
+    static const std::string unknown_retval = "";
+    auto it = g_filter_types.find(filter_type);
+    return it != g_filter_types.end() ? it->second : unknown_retval;
+}
+
+bool BlockFilterTypeByName(const std::string &name, BlockFilterType &filter_type)
+{
+    for (const auto &entry : g_filter_types)
+    {
+        if (entry.second == name)
+        {
+            filter_type = entry.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+GCSFilter::ElementSet BasicFilterElements(const CBlock &block, const CBlockUndo &block_undo)
+{
+    GCSFilter::ElementSet elements;
+
+    for (const CTransactionRef &tx : block.vtx)
+    {
+        for (const CTxOut &txout : tx->vout)
+        {
+            const CScript &script = txout.scriptPubKey;
+            if (script.empty() || script.IsUnspendable())
+                continue;
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+
+    for (const CTxUndo &tx_undo : block_undo.vtxundo)
+    {
+        for (const Coin &prevout : tx_undo.vprevout)
+        {
+            const CScript &script = prevout.out.scriptPubKey;
+            if (script.empty() || script.IsUnspendable())
+                continue;
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+
+    return elements;
+}
+
+BlockFilter::BlockFilter(BlockFilterType filter_type, const uint256 &block_hash, std::vector<unsigned char> filter)
+    : m_filter_type(filter_type), m_block_hash(block_hash)
+{
+    GCSFilter::Params params;
+    if (!BuildParams(params))
+    {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    m_filter = GCSFilter(params, std::move(filter));
+}
+
+BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock &block, const CBlockUndo &block_undo)
+    : m_filter_type(filter_type), m_block_hash(block.GetHash())
+{
+    GCSFilter::Params params;
+    if (!BuildParams(params))
+    {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    m_filter = GCSFilter(params, BasicFilterElements(block, block_undo));
+}
+
+bool BlockFilter::BuildParams(GCSFilter::Params &params) const
+{
+    switch (m_filter_type)
+    {
+    case BlockFilterType::BASIC:
+        params.siphash_k0 = ReadLE64(m_block_hash.begin());
+        params.siphash_k1 = ReadLE64(m_block_hash.begin() + 8);
+        params.P = BASIC_FILTER_P;
+        params.M = BASIC_FILTER_M;
+        return true;
+    case BlockFilterType::INVALID:
+        return false;
+    }
+
+    return false;
+}
+
+uint256 BlockFilter::GetHash() const
+{
+    const std::vector<unsigned char> &data = GetEncodedFilter();
+    return Hash(data.begin(), data.end());
+}
+
+uint256 BlockFilter::ComputeHeader(const uint256 &prev_header) const
+{
+    const uint256 &filter_hash = GetHash();
+    return Hash(filter_hash.begin(), filter_hash.end(), prev_header.begin(), prev_header.end());
+}
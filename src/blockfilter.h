@@ -0,0 +1,156 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_BLOCKFILTER_H
+#define NEXA_BLOCKFILTER_H
+
+#include "primitives/block.h"
+#include "serialize.h"
+#include "uint256.h"
+
+#include <set>
+#include <stdint.h>
+#include <vector>
+
+class CBlockUndo;
+
+/**
+ * A Golomb-coded set (GCS) as described in BIP158. It is a compact, probabilistic representation of a set of byte
+ * vectors that supports membership queries with a false positive rate of 1/M.
+ *
+ * Each element is hashed with SipHash into the range [0, N * M) and the sorted hashes are stored as Golomb-Rice
+ * coded deltas with parameter P. Unlike a bloom filter the encoding is close to the theoretical minimum size, and a
+ * client can test any number of its own elements against it with a single pass over the data.
+ */
+class GCSFilter
+{
+public:
+    typedef std::vector<unsigned char> Element;
+    typedef std::set<Element> ElementSet;
+
+    struct Params
+    {
+        uint64_t siphash_k0;
+        uint64_t siphash_k1;
+        uint8_t P; //!< Golomb-Rice coding parameter
+        uint32_t M; //!< Inverse false positive rate
+
+        Params(uint64_t _k0 = 0, uint64_t _k1 = 0, uint8_t _P = 0, uint32_t _M = 1)
+            : siphash_k0(_k0), siphash_k1(_k1), P(_P), M(_M)
+        {
+        }
+    };
+
+private:
+    Params params;
+    uint32_t N; //!< Number of elements in the filter
+    uint64_t F; //!< Range of element hashes, F = N * M
+    std::vector<unsigned char> encoded;
+
+    /** Hash a data element to an integer in the range [0, N * M). */
+    uint64_t HashToRange(const Element &element) const;
+
+    std::vector<uint64_t> BuildHashedSet(const ElementSet &elements) const;
+
+    /** Helper for the Match methods, queries must be sorted in ascending order. */
+    bool MatchInternal(const uint64_t *element_hashes, size_t size) const;
+
+public:
+    /** Constructs an empty filter. */
+    explicit GCSFilter(const Params &params = Params());
+
+    /** Reconstructs an already-created filter from an encoding, throws std::ios_base::failure if it is malformed. */
+    GCSFilter(const Params &params, std::vector<unsigned char> encoded_filter);
+
+    /** Builds a new filter from the params and set of elements. */
+    GCSFilter(const Params &params, const ElementSet &elements);
+
+    uint32_t GetN() const { return N; }
+    const Params &GetParams() const { return params; }
+    const std::vector<unsigned char> &GetEncoded() const { return encoded; }
+    /** Checks if the element may be in the set. False positives are possible with probability 1/M. */
+    bool Match(const Element &element) const;
+
+    /** Checks if any of the given elements may be in the set. False positives are possible with probability 1/M per
+     *  element checked. This is more efficient than checking Match on multiple elements separately. */
+    bool MatchAny(const ElementSet &elements) const;
+};
+
+static const uint8_t BASIC_FILTER_P = 19;
+static const uint32_t BASIC_FILTER_M = 784931;
+
+enum class BlockFilterType : uint8_t
+{
+    BASIC = 0,
+    INVALID = 255,
+};
+
+/** Get the human-readable name for a filter type. Returns the empty string for unknown types. */
+const std::string &BlockFilterTypeName(BlockFilterType filter_type);
+
+/** Find a filter type by its human-readable name. */
+bool BlockFilterTypeByName(const std::string &name, BlockFilterType &filter_type);
+
+/**
+ * Complete block filter struct as defined in BIP157. The basic filter holds every spendable output script created
+ * in the block and the output script of every coin the block spends, so that a light client can find both the
+ * payments to and the spends from its scripts.
+ */
+class BlockFilter
+{
+private:
+    BlockFilterType m_filter_type;
+    uint256 m_block_hash;
+    GCSFilter m_filter;
+
+    bool BuildParams(GCSFilter::Params &params) const;
+
+public:
+    BlockFilter() : m_filter_type(BlockFilterType::INVALID) {}
+    /** Reconstruct a BlockFilter from parts. */
+    BlockFilter(BlockFilterType filter_type, const uint256 &block_hash, std::vector<unsigned char> filter);
+
+    /** Construct a new BlockFilter of the specified type from a block and its undo data. */
+    BlockFilter(BlockFilterType filter_type, const CBlock &block, const CBlockUndo &block_undo);
+
+    BlockFilterType GetFilterType() const { return m_filter_type; }
+    const uint256 &GetBlockHash() const { return m_block_hash; }
+    const GCSFilter &GetFilter() const { return m_filter; }
+    const std::vector<unsigned char> &GetEncodedFilter() const { return m_filter.GetEncoded(); }
+    /** Compute the filter hash. */
+    uint256 GetHash() const;
+
+    /** Compute the filter header given the previous one. */
+    uint256 ComputeHeader(const uint256 &prev_header) const;
+
+    template <typename Stream>
+    void Serialize(Stream &s) const
+    {
+        s << static_cast<uint8_t>(m_filter_type) << m_block_hash << m_filter.GetEncoded();
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream &s)
+    {
+        std::vector<unsigned char> encoded_filter;
+        uint8_t filter_type;
+
+        s >> filter_type >> m_block_hash >> encoded_filter;
+
+        m_filter_type = static_cast<BlockFilterType>(filter_type);
+
+        GCSFilter::Params params;
+        if (!BuildParams(params))
+        {
+            throw std::ios_base::failure("unknown filter_type");
+        }
+        m_filter = GCSFilter(params, std::move(encoded_filter));
+    }
+};
+
+/** The elements of the basic filter of a block: the spendable output scripts of the block and the output scripts of
+ *  the coins it spends. Empty and OP_RETURN scripts are left out. */
+GCSFilter::ElementSet BasicFilterElements(const CBlock &block, const CBlockUndo &block_undo);
+
+#endif // NEXA_BLOCKFILTER_H
@@ -625,8 +625,7 @@ static bool ReconstructBlock(CNode *pfrom,
                 else
                 {
                     READLOCK(orphanpool.cs_orphanpool);
-                    std::map<uint256, CTxOrphanPool::COrphanTx>::iterator iter2 =
-                        orphanpool.mapOrphanTransactions.find(hash);
+                    CTxOrphanPool::OrphanMap::iterator iter2 = orphanpool.mapOrphanTransactions.find(hash);
                     if (iter2 != orphanpool.mapOrphanTransactions.end())
                     {
                         inOrphanCache = true;
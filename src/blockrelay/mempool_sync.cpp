@@ -293,8 +293,7 @@ bool CRequestMempoolSyncTx::HandleMessage(CDataStream &vRecv, CNode *pfrom)
             {
                 READLOCK(orphanpool.cs_orphanpool);
 
-                std::map<uint256, CTxOrphanPool::COrphanTx>::iterator iter =
-                    orphanpool.mapOrphanTransactions.find(hash);
+                CTxOrphanPool::OrphanMap::iterator iter = orphanpool.mapOrphanTransactions.find(hash);
                 if (iter != orphanpool.mapOrphanTransactions.end())
                 {
                     vTx.push_back(iter->second.ptx);
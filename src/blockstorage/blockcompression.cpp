@@ -0,0 +1,238 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "nexa-config.h"
+#endif
+
+#include "blockstorage/blockcompression.h"
+#include "crypto/common.h"
+#include "main.h"
+#include "tinyformat.h"
+
+#include <atomic>
+
+#ifdef USE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+static std::atomic<BlockCompression> blockCompression{BlockCompression::NONE};
+static std::atomic<int> nBlockCompressionLevel{DEFAULT_BLOCK_COMPRESSION_LEVEL};
+
+std::string BlockCompressionName(BlockCompression codec)
+{
+    switch (codec)
+    {
+    case BlockCompression::NONE:
+        return "none";
+    case BlockCompression::LZ4:
+        return "lz4";
+    case BlockCompression::ZSTD:
+        return "zstd";
+    }
+    return "";
+}
+
+bool BlockCompressionFromName(const std::string &name, BlockCompression &codec)
+{
+    for (BlockCompression c : {BlockCompression::NONE, BlockCompression::LZ4, BlockCompression::ZSTD})
+    {
+        if (name == BlockCompressionName(c))
+        {
+            codec = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsBlockCompressionSupported(BlockCompression codec)
+{
+    switch (codec)
+    {
+    case BlockCompression::NONE:
+        return true;
+    case BlockCompression::LZ4:
+#ifdef USE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    case BlockCompression::ZSTD:
+#ifdef USE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+std::string SupportedBlockCompressionNames()
+{
+    std::string names;
+    for (BlockCompression c : {BlockCompression::NONE, BlockCompression::LZ4, BlockCompression::ZSTD})
+    {
+        if (!IsBlockCompressionSupported(c))
+            continue;
+        if (!names.empty())
+            names += ", ";
+        names += BlockCompressionName(c);
+    }
+    return names;
+}
+
+void SetBlockCompression(BlockCompression codec, int nLevel)
+{
+    blockCompression = codec;
+    nBlockCompressionLevel = nLevel;
+}
+
+BlockCompression GetBlockCompression() { return blockCompression.load(); }
+/** Compress into dest, which has room for nDestSize bytes. Returns the compressed size or 0 on failure. */
+static size_t CompressPayload(BlockCompression codec,
+    int nLevel,
+    const unsigned char *raw,
+    size_t nRawSize,
+    unsigned char *dest,
+    size_t nDestSize)
+{
+    switch (codec)
+    {
+    case BlockCompression::LZ4:
+    {
+#ifdef USE_LZ4
+        if (nRawSize > (size_t)LZ4_MAX_INPUT_SIZE)
+            return 0;
+        // Levels above 0 select the slower high compression mode
+        int nCompressed = 0;
+        if (nLevel <= 0)
+            nCompressed = LZ4_compress_default((const char *)raw, (char *)dest, nRawSize, nDestSize);
+        else
+            nCompressed = LZ4_compress_HC((const char *)raw, (char *)dest, nRawSize, nDestSize, nLevel);
+        return nCompressed > 0 ? nCompressed : 0;
+#else
+        return 0;
+#endif
+    }
+    case BlockCompression::ZSTD:
+    {
+#ifdef USE_ZSTD
+        size_t nCompressed =
+            ZSTD_compress(dest, nDestSize, raw, nRawSize, nLevel != 0 ? nLevel : ZSTD_CLEVEL_DEFAULT);
+        return ZSTD_isError(nCompressed) ? 0 : nCompressed;
+#else
+        return 0;
+#endif
+    }
+    case BlockCompression::NONE:
+        break;
+    }
+    return 0;
+}
+
+bool CompressRecord(BlockCompression codec,
+    int nLevel,
+    const unsigned char *raw,
+    size_t nRawSize,
+    std::vector<unsigned char> &record)
+{
+    record.clear();
+    if (codec == BlockCompression::NONE || !IsBlockCompressionSupported(codec) || nRawSize > UINT32_MAX)
+        return false;
+
+    // Only keep the compressed record if it is smaller than the plain data
+    if (nRawSize <= COMPRESSED_RECORD_HEADER_SIZE)
+        return false;
+    record.resize(nRawSize);
+    const size_t nCompressed = CompressPayload(codec, nLevel, raw, nRawSize,
+        record.data() + COMPRESSED_RECORD_HEADER_SIZE, nRawSize - COMPRESSED_RECORD_HEADER_SIZE);
+    if (nCompressed == 0)
+    {
+        record.clear();
+        return false;
+    }
+    record.resize(COMPRESSED_RECORD_HEADER_SIZE + nCompressed);
+
+    unsigned char *p = record.data();
+    WriteLE64(p, COMPRESSED_RECORD_MAGIC);
+    p[8] = static_cast<uint8_t>(codec);
+    WriteLE32(p + 9, nRawSize);
+    WriteLE32(p + 13, nCompressed);
+    return true;
+}
+
+bool CompressRecord(const unsigned char *raw, size_t nRawSize, std::vector<unsigned char> &record)
+{
+    return CompressRecord(blockCompression.load(), nBlockCompressionLevel.load(), raw, nRawSize, record);
+}
+
+bool IsCompressedRecord(const unsigned char *data, size_t nSize)
+{
+    return nSize >= COMPRESSED_RECORD_HEADER_SIZE && ReadLE64(data) == COMPRESSED_RECORD_MAGIC;
+}
+
+void CheckCompressedRecordSize(const CCompressedRecordHeader &header)
+{
+    if (header.nRawSize > MAX_BLOCKFILE_SIZE || header.nSize > MAX_BLOCKFILE_SIZE)
+        throw std::ios_base::failure(strprintf(
+            "CheckCompressedRecordSize(): record sizes %u/%u out of range", header.nRawSize, header.nSize));
+}
+
+void DecompressRecord(const CCompressedRecordHeader &header,
+    const unsigned char *payload,
+    std::vector<unsigned char> &raw)
+{
+    const BlockCompression codec = static_cast<BlockCompression>(header.codec);
+    if (header.magic != COMPRESSED_RECORD_MAGIC)
+        throw std::ios_base::failure("DecompressRecord(): not a compressed record");
+    CheckCompressedRecordSize(header);
+    if (!IsBlockCompressionSupported(codec) || codec == BlockCompression::NONE)
+        throw std::ios_base::failure(
+            strprintf("DecompressRecord(): codec %u is not supported by this build", header.codec));
+
+    raw.resize(header.nRawSize);
+    switch (codec)
+    {
+    case BlockCompression::LZ4:
+    {
+#ifdef USE_LZ4
+        int nRaw = LZ4_decompress_safe((const char *)payload, (char *)raw.data(), header.nSize, header.nRawSize);
+        if (nRaw < 0 || (uint32_t)nRaw != header.nRawSize)
+            throw std::ios_base::failure("DecompressRecord(): corrupt lz4 record");
+#endif
+        break;
+    }
+    case BlockCompression::ZSTD:
+    {
+#ifdef USE_ZSTD
+        size_t nRaw = ZSTD_decompress(raw.data(), raw.size(), payload, header.nSize);
+        if (ZSTD_isError(nRaw) || nRaw != header.nRawSize)
+            throw std::ios_base::failure("DecompressRecord(): corrupt zstd record");
+#endif
+        break;
+    }
+    case BlockCompression::NONE:
+        break;
+    }
+}
+
+void DecompressRecord(const unsigned char *data, size_t nSize, std::vector<unsigned char> &raw)
+{
+    if (!IsCompressedRecord(data, nSize))
+        throw std::ios_base::failure("DecompressRecord(): not a compressed record");
+
+    CCompressedRecordHeader header;
+    header.magic = ReadLE64(data);
+    header.codec = data[8];
+    header.nRawSize = ReadLE32(data + 9);
+    header.nSize = ReadLE32(data + 13);
+    if (header.nSize > nSize - COMPRESSED_RECORD_HEADER_SIZE)
+        throw std::ios_base::failure("DecompressRecord(): truncated record");
+    DecompressRecord(header, data + COMPRESSED_RECORD_HEADER_SIZE, raw);
+}
@@ -0,0 +1,151 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_BLOCKSTORAGE_BLOCKCOMPRESSION_H
+#define NEXA_BLOCKSTORAGE_BLOCKCOMPRESSION_H
+
+#include "clientversion.h"
+#include "serialize.h"
+#include "streams.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Blocks and undo data can be stored compressed, one record at a time, by both block storage backends. A
+ * compressed record starts with COMPRESSED_RECORD_MAGIC followed by the codec, the size of the uncompressed
+ * serialization and the size of the compressed payload. Anything that does not start with the magic is a plain
+ * serialization, so records written before compression was enabled, or with compression turned off, are read as
+ * they always were. A serialized block starts with the hash of the previous block, so it can only be mistaken for a
+ * compressed record with a chance of 2^-64. An undo record starts with the compact size number of transactions,
+ * then the number of inputs of the first one and the VARINT height code of its first spent coin. Read that way the
+ * magic would be 78 transactions whose first has 69 inputs spending a coin of height 44, and the byte after the
+ * height code of a coin above height 0 is always 0, where the magic has 0x41, so an undo record never starts with
+ * the magic.
+ */
+
+enum class BlockCompression : uint8_t
+{
+    NONE = 0,
+    LZ4 = 1,
+    ZSTD = 2,
+};
+
+//! Default for -blockcompression
+static const char *const DEFAULT_BLOCK_COMPRESSION = "none";
+//! Default for -blockcompressionlevel, 0 selects the default level of the codec
+static const int DEFAULT_BLOCK_COMPRESSION_LEVEL = 0;
+
+static const uint64_t COMPRESSED_RECORD_MAGIC = 0x0152435a4158454eULL; // "NEXAZCR\x01"
+
+/** The fixed size header in front of the payload of a compressed record */
+struct CCompressedRecordHeader
+{
+    uint64_t magic;
+    uint8_t codec;
+    uint32_t nRawSize;
+    uint32_t nSize;
+
+    CCompressedRecordHeader() : magic(0), codec(0), nRawSize(0), nSize(0) {}
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(magic);
+        READWRITE(codec);
+        READWRITE(nRawSize);
+        READWRITE(nSize);
+    }
+};
+
+static const size_t COMPRESSED_RECORD_HEADER_SIZE = 17;
+
+/** The name of a codec as used by -blockcompression */
+std::string BlockCompressionName(BlockCompression codec);
+
+/** Parse a codec name, returns false if the name is unknown */
+bool BlockCompressionFromName(const std::string &name, BlockCompression &codec);
+
+/** Whether this build can compress and decompress records with codec */
+bool IsBlockCompressionSupported(BlockCompression codec);
+
+/** The names of every codec this build supports, for help and error messages */
+std::string SupportedBlockCompressionNames();
+
+/** Select the codec and level used for every record written from now on */
+void SetBlockCompression(BlockCompression codec, int nLevel);
+BlockCompression GetBlockCompression();
+
+/**
+ * Compress nRawSize bytes at raw into a complete record, header included, using codec at nLevel. Returns false,
+ * leaving record empty, if the codec is NONE or not supported, or if compressing would not save any space, in which
+ * case the data should be stored as it is.
+ */
+bool CompressRecord(BlockCompression codec,
+    int nLevel,
+    const unsigned char *raw,
+    size_t nRawSize,
+    std::vector<unsigned char> &record);
+
+/** Compress with the codec and level selected by SetBlockCompression() */
+bool CompressRecord(const unsigned char *raw, size_t nRawSize, std::vector<unsigned char> &record);
+
+/** Whether the nSize bytes at data start with a compressed record header */
+bool IsCompressedRecord(const unsigned char *data, size_t nSize);
+
+/**
+ * Check the sizes in a record header read from disk, before anything is allocated for them. Throws
+ * std::ios_base::failure if either is larger than a block file can be.
+ */
+void CheckCompressedRecordSize(const CCompressedRecordHeader &header);
+
+/**
+ * Decompress the payload of a record into raw. Throws std::ios_base::failure if the codec is unknown or not
+ * supported by this build, if the sizes are out of range, or if the payload is corrupt.
+ */
+void DecompressRecord(const CCompressedRecordHeader &header,
+    const unsigned char *payload,
+    std::vector<unsigned char> &raw);
+
+/** Decompress the complete record, header included, of nSize bytes at data into raw. Throws like the above. */
+void DecompressRecord(const unsigned char *data, size_t nSize, std::vector<unsigned char> &raw);
+
+/**
+ * Serialize obj into the bytes to store: a compressed record when compression is enabled and pays off, otherwise the
+ * plain serialization.
+ */
+template <typename T>
+std::vector<unsigned char> SerializeForStorage(const T &obj)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << obj;
+    std::vector<unsigned char> record;
+    if (!CompressRecord((const unsigned char *)ss.data(), ss.size(), record))
+        record.assign(ss.begin(), ss.end());
+    return record;
+}
+
+/**
+ * Read a compressed record from s. The first 8 bytes of the stream are consumed in any case; if they are not the
+ * record magic false is returned and the caller must rewind s to read the plain serialization instead.
+ */
+template <typename Stream>
+bool ReadCompressedRecord(Stream &s, std::vector<unsigned char> &raw)
+{
+    CCompressedRecordHeader header;
+    s >> header.magic;
+    if (header.magic != COMPRESSED_RECORD_MAGIC)
+        return false;
+    s >> header.codec >> header.nRawSize >> header.nSize;
+    CheckCompressedRecordSize(header);
+
+    std::vector<unsigned char> payload(header.nSize);
+    s.read((char *)payload.data(), payload.size());
+    DecompressRecord(header, payload.data(), raw);
+    return true;
+}
+
+#endif // NEXA_BLOCKSTORAGE_BLOCKCOMPRESSION_H
@@ -0,0 +1,253 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockstorage/blockfilewriter.h"
+#include "blockstorage/sequential_files.h"
+#include "util.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <tuple>
+
+extern bool AbortNode(const std::string &strMessage, const std::string &userMessage = "");
+
+//! stdio buffer used while writing a batch, so that consecutive records go to the disk in large writes
+static const size_t BLOCK_WRITE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+CBlockFileWriter blockFileWriter;
+
+void CBlockFileWriter::Start(uint64_t nMaxQueuedBytesIn)
+{
+    std::lock_guard<std::mutex> lock(cs_writer);
+    if (fRunning)
+        return;
+    nMaxQueuedBytes = nMaxQueuedBytesIn;
+    fStop = false;
+    fRunning = true;
+    writerThread = std::thread(&TraceThread<std::function<void()> >, "blkwriter",
+        std::bind(&CBlockFileWriter::ThreadWrite, this));
+}
+
+void CBlockFileWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs_writer);
+        if (!fRunning)
+            return;
+        fStop = true;
+    }
+    condQueued.notify_all();
+    if (writerThread.joinable())
+        writerThread.join();
+    Flush();
+    std::lock_guard<std::mutex> lock(cs_writer);
+    fRunning = false;
+}
+
+bool CBlockFileWriter::IsRunning() const
+{
+    std::lock_guard<std::mutex> lock(cs_writer);
+    return fRunning && !fStop;
+}
+
+bool CBlockFileWriter::Write(bool fUndo,
+    int nFile,
+    uint64_t nPos,
+    uint64_t nDataOffset,
+    std::vector<unsigned char> &&data)
+{
+    CPendingWriteRef pwrite = std::make_shared<CPendingWrite>();
+    pwrite->fUndo = fUndo;
+    pwrite->nFile = nFile;
+    pwrite->nPos = nPos;
+    pwrite->nDataPos = nPos + nDataOffset;
+    pwrite->data = std::move(data);
+
+    size_t nDepth = 0;
+    {
+        std::unique_lock<std::mutex> lock(cs_writer);
+        if (!fRunning || fStop)
+        {
+            lock.unlock();
+            std::vector<CPendingWriteRef> batch{pwrite};
+            WriteBatch(batch);
+            return !batch.empty();
+        }
+
+        // Bound the memory held by the queue, but always accept a record into an empty queue
+        condWritten.wait(
+            lock, [this] { return queue.empty() || nQueuedBytes < nMaxQueuedBytes || fStop || fWriteFailed; });
+        if (fWriteFailed)
+            return false;
+
+        pwrite->nSequence = ++nSequence;
+        nQueuedBytes += pwrite->data.size();
+        mapPending[PendingKey(fUndo, nFile, pwrite->nDataPos)] = pwrite;
+        mapPendingPerFile[std::make_pair(fUndo, nFile)]++;
+        queue.push_back(pwrite);
+        nDepth = queue.size();
+    }
+    condQueued.notify_one();
+    blockWriteQueueDepth << nDepth;
+    return true;
+}
+
+bool CBlockFileWriter::ReadPending(bool fUndo, const CDiskBlockPos &pos, std::vector<unsigned char> &data) const
+{
+    std::lock_guard<std::mutex> lock(cs_writer);
+    auto it = mapPending.find(PendingKey(fUndo, pos.nFile, pos.nPos));
+    if (it == mapPending.end())
+        return false;
+    const CPendingWrite &pending = *it->second;
+    data.assign(pending.data.begin() + (pos.nPos - pending.nPos), pending.data.end());
+    return true;
+}
+
+bool CBlockFileWriter::WaitForFile(bool fUndo, int nFile)
+{
+    std::unique_lock<std::mutex> lock(cs_writer);
+    if (!mapPendingPerFile.count(std::make_pair(fUndo, nFile)))
+        return true;
+    // Only wait for what has been queued so far, so that a steady stream of new blocks can not hold us up
+    const uint64_t nWaitFor = nSequence;
+    condWritten.wait(lock, [this, nWaitFor] { return nWrittenSequence >= nWaitFor || fWriteFailed; });
+    return nWrittenSequence >= nWaitFor;
+}
+
+bool CBlockFileWriter::Flush()
+{
+    std::set<std::pair<bool, int> > setFiles;
+    {
+        std::unique_lock<std::mutex> lock(cs_writer);
+        const uint64_t nWaitFor = nSequence;
+        condWritten.wait(
+            lock, [this, nWaitFor] { return nWrittenSequence >= nWaitFor || !fRunning || fWriteFailed; });
+        if (nWrittenSequence < nWaitFor)
+            return false;
+        setFiles.swap(setUnsyncedFiles);
+    }
+
+    for (const auto &file : setFiles)
+    {
+        const CDiskBlockPos pos(file.second, 0);
+        FILE *fileOut = file.first ? OpenUndoFile(pos) : OpenBlockFile(pos);
+        if (fileOut)
+        {
+            FileCommit(fileOut);
+            fclose(fileOut);
+            blockFileSyncs << 1;
+        }
+    }
+    return true;
+}
+
+size_t CBlockFileWriter::QueueDepth() const
+{
+    std::lock_guard<std::mutex> lock(cs_writer);
+    return queue.size();
+}
+
+void CBlockFileWriter::WriteBatch(std::vector<CPendingWriteRef> &batch)
+{
+    // Write each file front to back
+    std::sort(batch.begin(), batch.end(), [](const CPendingWriteRef &a, const CPendingWriteRef &b) {
+        return std::tie(a->fUndo, a->nFile, a->nPos) < std::tie(b->fUndo, b->nFile, b->nPos);
+    });
+
+    FILE *file = nullptr;
+    std::pair<bool, int> current(false, -1);
+    uint64_t nFilePos = 0;
+    bool fError = false;
+    for (const CPendingWriteRef &pwrite : batch)
+    {
+        if (!file || current != std::make_pair(pwrite->fUndo, pwrite->nFile))
+        {
+            if (file)
+                fclose(file);
+            current = std::make_pair(pwrite->fUndo, pwrite->nFile);
+            const CDiskBlockPos pos(pwrite->nFile, 0);
+            file = pwrite->fUndo ? OpenUndoFile(pos) : OpenBlockFile(pos);
+            if (!file)
+            {
+                fError = true;
+                break;
+            }
+            setvbuf(file, nullptr, _IOFBF, BLOCK_WRITE_BUFFER_SIZE);
+            nFilePos = std::numeric_limits<uint64_t>::max();
+        }
+        if (nFilePos != pwrite->nPos && fseek(file, pwrite->nPos, SEEK_SET))
+        {
+            fError = true;
+            break;
+        }
+        if (fwrite(pwrite->data.data(), 1, pwrite->data.size(), file) != pwrite->data.size())
+        {
+            fError = true;
+            break;
+        }
+        nFilePos = pwrite->nPos + pwrite->data.size();
+    }
+    if (file && fclose(file) != 0)
+        fError = true;
+
+    if (fError)
+    {
+        LOGA("ERROR: %s: failed to write %s file %d\n", __func__, current.first ? "undo" : "block", current.second);
+        batch.clear();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(cs_writer);
+    for (const CPendingWriteRef &pwrite : batch)
+    {
+        setUnsyncedFiles.insert(std::make_pair(pwrite->fUndo, pwrite->nFile));
+    }
+}
+
+void CBlockFileWriter::ThreadWrite()
+{
+    while (true)
+    {
+        std::vector<CPendingWriteRef> batch;
+        {
+            std::unique_lock<std::mutex> lock(cs_writer);
+            condQueued.wait(lock, [this] { return !queue.empty() || fStop; });
+            if (queue.empty())
+                return;
+            batch.assign(queue.begin(), queue.end());
+            queue.clear();
+        }
+
+        std::vector<CPendingWriteRef> written(batch);
+        WriteBatch(written);
+        if (written.empty())
+        {
+            // Leave the batch pending so that it can still be read, and let every waiter know it will never be written
+            {
+                std::lock_guard<std::mutex> lock(cs_writer);
+                fWriteFailed = true;
+            }
+            condWritten.notify_all();
+            AbortNode("Failed to write block data to disk");
+            std::unique_lock<std::mutex> lock(cs_writer);
+            condQueued.wait(lock, [this] { return fStop; });
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(cs_writer);
+            for (const CPendingWriteRef &pwrite : batch)
+            {
+                const std::pair<bool, int> file(pwrite->fUndo, pwrite->nFile);
+                mapPending.erase(PendingKey(pwrite->fUndo, pwrite->nFile, pwrite->nDataPos));
+                if (--mapPendingPerFile[file] == 0)
+                    mapPendingPerFile.erase(file);
+                nQueuedBytes -= pwrite->data.size();
+                nWrittenSequence = std::max(nWrittenSequence, pwrite->nSequence);
+            }
+        }
+        condWritten.notify_all();
+    }
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_BLOCKSTORAGE_BLOCKFILEWRITER_H
+#define NEXA_BLOCKSTORAGE_BLOCKFILEWRITER_H
+
+#include "chain.h"
+#include "stat.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+//! Default for -asyncblockwrites
+static const bool DEFAULT_ASYNC_BLOCK_WRITES = true;
+
+//! Writers block once this many bytes of block and undo records are waiting to be written
+static const uint64_t DEFAULT_BLOCK_WRITE_QUEUE_BYTES = 128 * 1024 * 1024;
+
+/**
+ * Writes block and undo records to the sequential block files from a background thread.
+ *
+ * Records are queued with their final position, which FindBlockPos()/FindUndoPos() have already reserved, so the
+ * caller does not wait for the disk. The writer thread takes everything that has queued up since its last pass,
+ * orders it by file and position and writes each file through one large buffer, so a burst of blocks during initial
+ * sync turns into a few big sequential writes. Nothing is synced to disk per record: Flush(), which FlushBlockFile()
+ * calls at file finalization and before the block index is written, waits for the queue to drain and then syncs
+ * every file written since the last flush once.
+ *
+ * A block can be read from the queue until it has been written. Any other read of a block or undo file waits until
+ * the queued writes to that file have been written.
+ *
+ * If a write fails the node is aborted. The records of the failed batch stay queued and readable, the written
+ * sequence does not move past them, and from then on every wait for the queue fails instead of waiting forever or
+ * reporting data as written that never reached the disk.
+ */
+class CBlockFileWriter
+{
+private:
+    struct CPendingWrite
+    {
+        bool fUndo;
+        int nFile;
+        //! where the record, including its message start and size header, goes in the file
+        uint64_t nPos;
+        //! the position a CDiskBlockPos for the record points to
+        uint64_t nDataPos;
+        //! the record
+        std::vector<unsigned char> data;
+        uint64_t nSequence;
+    };
+    typedef std::shared_ptr<CPendingWrite> CPendingWriteRef;
+    //! (fUndo, nFile, nDataPos)
+    typedef std::tuple<bool, int, uint64_t> PendingKey;
+
+    mutable std::mutex cs_writer;
+    std::condition_variable condQueued;
+    std::condition_variable condWritten;
+    std::deque<CPendingWriteRef> queue;
+    std::map<PendingKey, CPendingWriteRef> mapPending;
+    std::map<std::pair<bool, int>, uint64_t> mapPendingPerFile;
+    std::set<std::pair<bool, int> > setUnsyncedFiles;
+    uint64_t nQueuedBytes = 0;
+    uint64_t nMaxQueuedBytes = DEFAULT_BLOCK_WRITE_QUEUE_BYTES;
+    uint64_t nSequence = 0;
+    uint64_t nWrittenSequence = 0;
+    //! set when a batch could not be written, after which nothing more is written
+    bool fWriteFailed = false;
+    bool fRunning = false;
+    bool fStop = false;
+    std::thread writerThread;
+
+    void ThreadWrite();
+    void WriteBatch(std::vector<CPendingWriteRef> &batch);
+
+public:
+    ~CBlockFileWriter() { Stop(); }
+    /** Start the writer thread. Until it is started, and after it is stopped, records are written synchronously. */
+    void Start(uint64_t nMaxQueuedBytesIn = DEFAULT_BLOCK_WRITE_QUEUE_BYTES);
+
+    /** Write and sync everything that is queued and stop the writer thread */
+    void Stop();
+
+    bool IsRunning() const;
+
+    /**
+     * Write a record at nPos of block file (or undo file if fUndo) nFile, where nDataOffset bytes into the record
+     * is what a CDiskBlockPos for it points to. Queues the record if the writer is running, otherwise writes it
+     * right away. Blocks while the queue is full. Returns false if a synchronous write failed, or if an earlier
+     * queued write failed.
+     */
+    bool Write(bool fUndo, int nFile, uint64_t nPos, uint64_t nDataOffset, std::vector<unsigned char> &&data);
+
+    /**
+     * Copy the data of a record that is still queued, starting at the position pos points to, into data. Returns
+     * false if nothing is queued at pos.
+     */
+    bool ReadPending(bool fUndo, const CDiskBlockPos &pos, std::vector<unsigned char> &data) const;
+
+    /**
+     * Wait until every write queued so far to block file (or undo file if fUndo) nFile has been written. Returns
+     * false if a queued write failed.
+     */
+    bool WaitForFile(bool fUndo, int nFile);
+
+    /**
+     * Write everything that is queued and sync every file written since the last flush. Returns false if a queued
+     * write failed, in which case the files are not synced.
+     */
+    bool Flush();
+
+    /** The number of records waiting to be written */
+    size_t QueueDepth() const;
+};
+
+extern CBlockFileWriter blockFileWriter;
+
+//! The number of records waiting in the block writer queue, sampled as records are queued
+extern CStatHistory<uint64_t> blockWriteQueueDepth;
+//! The number of block and undo file syncs
+extern CStatHistory<uint64_t> blockFileSyncs;
+
+#endif // NEXA_BLOCKSTORAGE_BLOCKFILEWRITER_H
@@ -0,0 +1,343 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockstorage/blockindexsnapshot.h"
+#include "chain.h"
+#include "clientversion.h"
+#include "compat.h"
+#include "hashwrapper.h"
+#include "random.h"
+#include "streams.h"
+#include "txdb.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation/validation.h"
+
+#include <atomic>
+#include <unordered_map>
+
+static const uint32_t BLOCKINDEX_SNAPSHOT_MAGIC = 0x4e584249; // "NXBI"
+static const uint32_t BLOCKINDEX_SNAPSHOT_VERSION = 1;
+
+//! index of the parent record of a block without a parent
+static const int32_t NO_PARENT = -1;
+
+static std::atomic<bool> fBlockIndexComplete{false};
+
+/** The fixed size part at the start of the snapshot file */
+struct CBlockIndexSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint256 id;
+    uint64_t nRecords;
+
+    CBlockIndexSnapshotHeader() : magic(0), version(0), nRecords(0) {}
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(magic);
+        READWRITE(version);
+        READWRITE(id);
+        READWRITE(nRecords);
+    }
+};
+
+/** Deserializes directly out of a read only memory range, such as a mapped file, without copying it first */
+class CMemoryReader
+{
+private:
+    const unsigned char *pos;
+    const unsigned char *const end;
+    const int nType;
+    const int nVersion;
+
+public:
+    CMemoryReader(const unsigned char *_begin, const unsigned char *_end, int nTypeIn, int nVersionIn)
+        : pos(_begin), end(_end), nType(nTypeIn), nVersion(nVersionIn)
+    {
+    }
+
+    int GetType() const { return nType; }
+    int GetVersion() const { return nVersion; }
+    void read(char *pch, size_t nSize)
+    {
+        if (nSize > (size_t)(end - pos))
+            throw std::ios_base::failure("CMemoryReader::read(): end of data");
+        memcpy(pch, pos, nSize);
+        pos += nSize;
+    }
+
+    template <typename T>
+    CMemoryReader &operator>>(T &obj)
+    {
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
+/** A read only view of a whole file, memory mapped where the platform allows it */
+class CMappedFile
+{
+private:
+    const unsigned char *data;
+    size_t size;
+#ifdef WIN32
+    std::vector<unsigned char> buffer;
+#endif
+
+public:
+    explicit CMappedFile(const fs::path &path) : data(nullptr), size(0)
+    {
+        FILE *file = fsbridge::fopen(path, "rb");
+        if (!file)
+            return;
+        uint64_t nFileSize = fs::file_size(path);
+#ifndef WIN32
+        void *p = nFileSize ? mmap(nullptr, nFileSize, PROT_READ, MAP_PRIVATE, fileno(file), 0) : MAP_FAILED;
+        if (p != MAP_FAILED)
+        {
+            // The snapshot is read front to back exactly once.
+            madvise(p, nFileSize, MADV_SEQUENTIAL);
+            data = static_cast<const unsigned char *>(p);
+            size = nFileSize;
+        }
+#else
+        buffer.resize(nFileSize);
+        if (fread(buffer.data(), 1, buffer.size(), file) == buffer.size())
+        {
+            data = buffer.data();
+            size = buffer.size();
+        }
+#endif
+        fclose(file);
+    }
+
+    ~CMappedFile()
+    {
+#ifndef WIN32
+        if (data)
+            munmap(const_cast<unsigned char *>(data), size);
+#endif
+    }
+
+    bool IsNull() const { return data == nullptr; }
+    const unsigned char *begin() const { return data; }
+    const unsigned char *end() const { return data + size; }
+    size_t Size() const { return size; }
+};
+
+bool WriteBlockIndexSnapshot(const fs::path &path, const BlockMap &mapIndex, const uint256 &id)
+{
+    // Parents must come before their children so that they can be referenced by position.
+    std::vector<const CBlockIndex *> vIndex;
+    vIndex.reserve(mapIndex.size());
+    for (const auto &entry : mapIndex)
+    {
+        vIndex.push_back(entry.second);
+    }
+    std::sort(vIndex.begin(), vIndex.end(),
+        [](const CBlockIndex *a, const CBlockIndex *b) { return a->height() < b->height(); });
+
+    std::unordered_map<const CBlockIndex *, int32_t> mapPosition;
+    mapPosition.reserve(vIndex.size());
+
+    const fs::path pathTmp = path.string() + ".new";
+    try
+    {
+        FILE *fileSnapshot = fsbridge::fopen(pathTmp, "wb");
+        if (!fileSnapshot)
+            return error("%s: failed to open %s", __func__, pathTmp.string());
+        CAutoFile file(fileSnapshot, SER_DISK, CLIENT_VERSION);
+        CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+
+        CBlockIndexSnapshotHeader header;
+        header.magic = BLOCKINDEX_SNAPSHOT_MAGIC;
+        header.version = BLOCKINDEX_SNAPSHOT_VERSION;
+        header.id = id;
+        header.nRecords = vIndex.size();
+        file << header;
+        hasher << header;
+
+        for (const CBlockIndex *pindex : vIndex)
+        {
+            int32_t nParent = NO_PARENT;
+            if (pindex->pprev)
+            {
+                auto it = mapPosition.find(pindex->pprev);
+                if (it == mapPosition.end())
+                    return error("%s: parent of block %s is not in the block index", __func__,
+                        pindex->GetBlockHash().ToString());
+                nParent = it->second;
+            }
+            mapPosition.emplace(pindex, (int32_t)mapPosition.size());
+
+            const CDiskBlockIndex diskindex(pindex);
+            file << nParent << pindex->GetBlockHash() << diskindex;
+            hasher << nParent << pindex->GetBlockHash() << diskindex;
+        }
+
+        file << hasher.GetHash();
+        FileCommit(file.Get());
+        file.fclose();
+        if (!RenameOver(pathTmp, path))
+            return error("%s: failed to rename %s", __func__, pathTmp.string());
+    }
+    catch (const std::exception &e)
+    {
+        return error("%s: failed to write the block index snapshot: %s", __func__, e.what());
+    }
+    return true;
+}
+
+/** Delete every entry of a partially read block index */
+static void ClearBlockIndex(BlockMap &mapIndex)
+{
+    for (auto &entry : mapIndex)
+    {
+        delete entry.second;
+    }
+    mapIndex.clear();
+}
+
+bool ReadBlockIndexSnapshot(const fs::path &path, const uint256 &id, BlockMap &mapIndex)
+{
+    if (!mapIndex.empty())
+        return error("%s: the block index is already loaded", __func__);
+
+    CMappedFile file(path);
+    if (file.IsNull())
+        return error("%s: failed to open %s", __func__, path.string());
+    if (file.Size() < CSHA256::OUTPUT_SIZE)
+        return error("%s: block index snapshot is truncated", __func__);
+
+    // Check the trailing checksum before trusting any of the contents
+    const unsigned char *pchecksum = file.end() - CSHA256::OUTPUT_SIZE;
+    uint256 checksum;
+    CHash256().Write(file.begin(), pchecksum - file.begin()).Finalize(checksum.begin());
+    if (memcmp(checksum.begin(), pchecksum, CSHA256::OUTPUT_SIZE) != 0)
+        return error("%s: block index snapshot checksum mismatch", __func__);
+
+    CMemoryReader reader(file.begin(), pchecksum, SER_DISK, CLIENT_VERSION);
+    try
+    {
+        CBlockIndexSnapshotHeader header;
+        reader >> header;
+        if (header.magic != BLOCKINDEX_SNAPSHOT_MAGIC || header.version != BLOCKINDEX_SNAPSHOT_VERSION)
+            return error("%s: unknown block index snapshot version", __func__);
+        if (header.id != id)
+            return error("%s: block index snapshot does not match the block index database", __func__);
+
+        std::vector<CBlockIndex *> vIndex;
+        vIndex.reserve(header.nRecords);
+        mapIndex.reserve(header.nRecords);
+        for (uint64_t i = 0; i < header.nRecords; i++)
+        {
+            int32_t nParent;
+            uint256 hash;
+            CDiskBlockIndex diskindex;
+            reader >> nParent >> hash >> diskindex;
+
+            CBlockIndex *pindexNew = new CBlockIndex();
+            auto result = mapIndex.emplace(hash, pindexNew);
+            if (!result.second)
+            {
+                delete pindexNew;
+                ClearBlockIndex(mapIndex);
+                return error("%s: duplicate block %s in the block index snapshot", __func__, hash.ToString());
+            }
+            pindexNew->phashBlock = &result.first->first;
+
+            if (nParent != NO_PARENT)
+            {
+                if (nParent < 0 || (uint64_t)nParent >= i ||
+                    *vIndex[nParent]->phashBlock != diskindex.header.hashPrevBlock)
+                {
+                    ClearBlockIndex(mapIndex);
+                    return error("%s: bad parent for block %s in the block index snapshot", __func__, hash.ToString());
+                }
+                pindexNew->pprev = vIndex[nParent];
+            }
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->header = diskindex.header;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nSequenceId = diskindex.nSequenceId;
+            pindexNew->nTimeReceived = diskindex.nTimeReceived;
+            pindexNew->nNextMaxBlockSize = diskindex.nNextMaxBlockSize;
+            vIndex.push_back(pindexNew);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        ClearBlockIndex(mapIndex);
+        return error("%s: failed to read the block index snapshot: %s", __func__, e.what());
+    }
+    return true;
+}
+
+void SetBlockIndexComplete(bool fComplete) { fBlockIndexComplete = fComplete; }
+bool DumpBlockIndexSnapshot(CBlockTreeDB &blocktree)
+{
+    AssertLockHeld(cs_main);
+    if (!fBlockIndexComplete.load())
+        return false;
+    int64_t nStart = GetStopwatchMicros();
+
+    const uint256 id = GetRandHash();
+    size_t nBlocks = 0;
+    {
+        READLOCK(cs_mapBlockIndex);
+        nBlocks = mapBlockIndex.size();
+        if (!WriteBlockIndexSnapshot(GetDataDir() / BLOCKINDEX_SNAPSHOT_FILENAME, mapBlockIndex, id))
+            return false;
+    }
+    if (!blocktree.WriteBlockIndexSnapshotId(id))
+        return error("%s: failed to write the block index snapshot id", __func__);
+
+    LOGA("Dumped block index snapshot of %u blocks in %gs\n", nBlocks, (GetStopwatchMicros() - nStart) * 0.000001);
+    return true;
+}
+
+void RemoveBlockIndexSnapshot()
+{
+    const fs::path path = GetDataDir() / BLOCKINDEX_SNAPSHOT_FILENAME;
+    try
+    {
+        if (fs::remove(path))
+            LOGA("Removed the block index snapshot\n");
+    }
+    catch (const fs::filesystem_error &e)
+    {
+        LOGA("%s: failed to remove %s: %s\n", __func__, path.string(), e.what());
+    }
+}
+
+bool LoadBlockIndexSnapshot(CBlockTreeDB &blocktree)
+{
+    AssertLockHeld(cs_main);
+    int64_t nStart = GetStopwatchMicros();
+
+    uint256 id;
+    if (!blocktree.ReadBlockIndexSnapshotId(id))
+    {
+        LOGA("No valid block index snapshot, loading the block index from the database\n");
+        return false;
+    }
+
+    // From here on the block index may change, so the snapshot must never be used again unless it is rewritten.
+    if (!blocktree.EraseBlockIndexSnapshotId())
+        return error("%s: failed to invalidate the block index snapshot", __func__);
+
+    WRITELOCK(cs_mapBlockIndex);
+    if (!ReadBlockIndexSnapshot(GetDataDir() / BLOCKINDEX_SNAPSHOT_FILENAME, id, mapBlockIndex))
+        return false;
+
+    LOGA("Loaded block index snapshot of %u blocks in %gs\n", mapBlockIndex.size(),
+        (GetStopwatchMicros() - nStart) * 0.000001);
+    return true;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_BLOCKSTORAGE_BLOCKINDEXSNAPSHOT_H
+#define NEXA_BLOCKSTORAGE_BLOCKINDEXSNAPSHOT_H
+
+#include "fs.h"
+#include "main.h"
+#include "uint256.h"
+
+class CBlockTreeDB;
+
+//! Default for -blockindexsnapshot
+static const bool DEFAULT_BLOCKINDEX_SNAPSHOT = true;
+
+//! The file, in the data directory, that holds the block index snapshot
+static const char *const BLOCKINDEX_SNAPSHOT_FILENAME = "blockindex.dat";
+
+/**
+ * The block index snapshot is a flat file copy of every CDiskBlockIndex record in the block tree database, written
+ * on clean shutdown and read back on the next startup. Loading it is a single sequential pass over one mapped file
+ * instead of a LevelDB walk: records are stored in height order with the parent referenced by its position in the
+ * file, so no hash lookups are needed to link the index, and the block hashes are stored rather than recomputed.
+ *
+ * The snapshot carries a random id that is also written to the block tree database. The id is erased from the
+ * database as soon as the snapshot has been read, so any later change to the block index invalidates the snapshot
+ * unless the node shuts down cleanly and writes a new one.
+ */
+
+/** Write every entry of mapIndex to the snapshot file at path, tagged with id. */
+bool WriteBlockIndexSnapshot(const fs::path &path, const BlockMap &mapIndex, const uint256 &id);
+
+/**
+ * Read the snapshot file at path into mapIndex, which must be empty. Fails if the file is missing, of another
+ * version, not tagged with id or corrupt, in which case mapIndex is left empty.
+ */
+bool ReadBlockIndexSnapshot(const fs::path &path, const uint256 &id, BlockMap &mapIndex);
+
+/** Record that mapBlockIndex holds the complete block index, which must be the case before it can be dumped. A
+ *  startup that is interrupted while loading the block index must never leave a partial snapshot behind. */
+void SetBlockIndexComplete(bool fComplete);
+
+/** Dump mapBlockIndex to the snapshot file and record its id in the block tree database. Requires cs_main. */
+bool DumpBlockIndexSnapshot(CBlockTreeDB &blocktree);
+
+/** Delete the snapshot file, if any. Used when the block index could not be flushed, so that nothing is left that
+ *  might be mistaken for a copy of it. */
+void RemoveBlockIndexSnapshot();
+
+/** Load mapBlockIndex from the snapshot file if it matches the block tree database. Requires cs_main. */
+bool LoadBlockIndexSnapshot(CBlockTreeDB &blocktree);
+
+#endif // NEXA_BLOCKSTORAGE_BLOCKINDEXSNAPSHOT_H
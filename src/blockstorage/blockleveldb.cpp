@@ -4,6 +4,7 @@
 
 
 #include "blockleveldb.h"
+#include "blockcompression.h"
 #include "blockstorage.h"
 #include "hashwrapper.h"
 #include "main.h"
@@ -35,6 +36,11 @@ bool CBlockLevelDB::WriteBlock(const CBlock &block)
     std::ostringstream key;
     key << block.GetBlockTime() << ":" << block.GetHash().ToString();
 
+    if (GetBlockCompression() != BlockCompression::NONE)
+    {
+        std::vector<unsigned char> record = SerializeForStorage(block);
+        return pwrapperblock->Write(key.str(), CFlatData(record), IsChainNearlySyncd());
+    }
     if (IsChainNearlySyncd())
     {
         return pwrapperblock->Write(key.str(), block, true);
@@ -52,7 +58,31 @@ bool CBlockLevelDB::ReadBlock(const CBlockIndex *pindex, CBlock &block)
     // compaction are the most recent files only.
     std::ostringstream key;
     key << pindex->GetBlockTime() << ":" << pindex->GetBlockHash().ToString();
-    return pwrapperblock->Read(key.str(), block);
+
+    std::string strValue;
+    if (!pwrapperblock->Exists(key.str(), strValue))
+        return false;
+    try
+    {
+        CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue.Xor(pwrapperblock->getobfuscate_key());
+        if (IsCompressedRecord((const unsigned char *)ssValue.data(), ssValue.size()))
+        {
+            std::vector<unsigned char> raw;
+            DecompressRecord((const unsigned char *)ssValue.data(), ssValue.size(), raw);
+            CDataStream ssRaw(raw, SER_DISK, CLIENT_VERSION);
+            ssRaw >> block;
+        }
+        else
+        {
+            ssValue >> block;
+        }
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return true;
 }
 
 bool CBlockLevelDB::EraseBlock(CBlock &block)
@@ -95,6 +125,11 @@ bool CBlockLevelDB::WriteUndo(const CBlockUndo &blockundo, const CBlockIndex *pi
     hasher << blockundo;
     UndoDBValue value(hasher.GetHash(), hashBlock, &blockundo);
 
+    if (GetBlockCompression() != BlockCompression::NONE)
+    {
+        std::vector<unsigned char> record = SerializeForStorage(value);
+        return pwrapperundo->Write(key.str(), CFlatData(record), IsChainNearlySyncd());
+    }
     if (IsChainNearlySyncd())
     {
         return pwrapperundo->Write(key.str(), value, true);
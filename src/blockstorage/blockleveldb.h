@@ -5,6 +5,7 @@
 #ifndef BLOCKDB_H
 #define BLOCKDB_H
 
+#include "blockcompression.h"
 #include "chain.h"
 #include "dbabstract.h"
 #include "dbwrapper.h"
@@ -105,7 +106,17 @@ public:
         {
             CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
             ssValue.Xor(pwrapperundo->getobfuscate_key());
-            value.Unserialize(ssValue, blockundo);
+            if (IsCompressedRecord((const unsigned char *)ssValue.data(), ssValue.size()))
+            {
+                std::vector<unsigned char> raw;
+                DecompressRecord((const unsigned char *)ssValue.data(), ssValue.size(), raw);
+                CDataStream ssRaw(raw, SER_DISK, CLIENT_VERSION);
+                value.Unserialize(ssRaw, blockundo);
+            }
+            else
+            {
+                value.Unserialize(ssValue, blockundo);
+            }
         }
         catch (const std::exception &)
         {
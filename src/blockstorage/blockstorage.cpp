@@ -514,6 +514,54 @@ ConstCBlockRef ReadBlockFromDisk(const CBlockIndex *pindex, const Consensus::Par
     return pblockRef;
 }
 
+bool ReadRawBlockFromDisk(std::vector<unsigned char> &raw, const CBlockIndex *pindex)
+{
+    ConstCBlockRef pblock = blockcache.GetBlock(pindex->GetBlockHash());
+    if (!pblock && pblockdb)
+        pblock = ReadBlockFromDisk(pindex, Params().GetConsensus());
+    if (pblock)
+    {
+        // Already deserialized, or stored in a way that can only be read whole
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << *pblock;
+        raw.assign(ss.begin(), ss.end());
+        return true;
+    }
+    if (pblockdb)
+        return false;
+
+    if (!ReadRawBlockFromDiskSequential(pindex->GetBlockPos(), raw))
+        return false;
+
+    // Only the header needs to be read to check that this is the block we wanted.  It is small, so copy just the
+    // start of the block, unless the header turns out to be bigger than that.
+    CBlockHeader header;
+    for (size_t nRead = std::min(raw.size(), (size_t)1024);; nRead = raw.size())
+    {
+        try
+        {
+            CDataStream ss((const char *)raw.data(), (const char *)raw.data() + nRead, SER_DISK, CLIENT_VERSION);
+            ss >> header;
+            break;
+        }
+        catch (const std::exception &e)
+        {
+            if (nRead == raw.size())
+            {
+                LOGA("ERROR: %s: Deserialize error - %s at %s", __func__, e.what(), pindex->GetBlockPos().ToString());
+                return false;
+            }
+        }
+    }
+    if (header.GetHash() != pindex->GetBlockHash())
+    {
+        LOGA("ERROR: %s: GetHash() doesn't match index for %s at %s", __func__, pindex->ToString(),
+            pindex->GetBlockPos().ToString());
+        return false;
+    }
+    return true;
+}
+
 bool WriteUndoToDisk(const CBlockUndo &blockundo,
     CDiskBlockPos &pos,
     const CBlockIndex *pindex,
@@ -647,7 +695,8 @@ bool FlushStateToDiskInternal(CValidationState &state,
         // First make sure all block and undo data is flushed to disk.
         if (BLOCK_DB_MODE == SEQUENTIAL_BLOCK_FILES)
         {
-            FlushBlockFile();
+            if (!FlushBlockFile())
+                return state.Error("failed to write block files");
         }
         else
         {
@@ -871,7 +920,8 @@ bool FindBlockPos(CValidationState &state,
         {
             LOGA("Leaving block file %i: %s\n", nLastBlockFile, vinfoBlockFile[nLastBlockFile].ToString());
         }
-        FlushBlockFile(!fKnown);
+        if (!FlushBlockFile(!fKnown))
+            return state.Error("failed to write block files");
         nLastBlockFile = nFile;
     }
 
@@ -40,6 +40,10 @@ void SyncStorage(const CChainParams &chainparams);
 
 /** Functions for disk access for blocks */
 ConstCBlockRef ReadBlockFromDisk(const CBlockIndex *pindex, const Consensus::Params &consensusParams);
+/** Read the serialized form of a block, straight from the block files when possible so it is not deserialized and
+ * serialized again.  Only the header is checked against the index.
+ */
+bool ReadRawBlockFromDisk(std::vector<unsigned char> &raw, const CBlockIndex *pindex);
 bool WriteBlockToDisk(const ConstCBlockRef pblock,
     CDiskBlockPos &pos,
     const CMessageHeader::MessageStartChars &messageStart,
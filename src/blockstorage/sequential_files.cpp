@@ -6,6 +6,8 @@
 
 #include "sequential_files.h"
 
+#include "blockcompression.h"
+#include "blockfilewriter.h"
 #include "blockstorage.h"
 
 
@@ -47,31 +49,56 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
     return file;
 }
 
-FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) { return OpenDiskFile(pos, "blk", fReadOnly); }
-FILE *OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly) { return OpenDiskFile(pos, "rev", fReadOnly); }
-void FlushBlockFile(bool fFinalize)
+FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly)
+{
+    // Readers must see everything that was stored in the file so far
+    if (fReadOnly && !blockFileWriter.WaitForFile(false, pos.nFile))
+    {
+        LOGA("Unable to open block file %d, queued writes to it failed\n", pos.nFile);
+        return nullptr;
+    }
+    return OpenDiskFile(pos, "blk", fReadOnly);
+}
+FILE *OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly)
+{
+    if (fReadOnly && !blockFileWriter.WaitForFile(true, pos.nFile))
+    {
+        LOGA("Unable to open undo file %d, queued writes to it failed\n", pos.nFile);
+        return nullptr;
+    }
+    return OpenDiskFile(pos, "rev", fReadOnly);
+}
+bool FlushBlockFile(bool fFinalize)
 {
     LOCK(cs_LastBlockFile);
 
+    // Write out what is still queued and sync every block and undo file written to since the last flush. This
+    // includes the last block file, so it only needs another sync if it is being truncated.
+    if (!blockFileWriter.Flush())
+        return false;
+    if (!fFinalize)
+        return true;
+
     CDiskBlockPos posOld(nLastBlockFile, 0);
 
     FILE *fileOld = OpenBlockFile(posOld);
     if (fileOld)
     {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
+        TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
         FileCommit(fileOld);
         fclose(fileOld);
+        blockFileSyncs << 1;
     }
 
     fileOld = OpenUndoFile(posOld);
     if (fileOld)
     {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
+        TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
         FileCommit(fileOld);
         fclose(fileOld);
+        blockFileSyncs << 1;
     }
+    return true;
 }
 
 void UnlinkPrunedFiles(std::set<int> &setFilesToPrune)
@@ -86,52 +113,115 @@ void UnlinkPrunedFiles(std::set<int> &setFilesToPrune)
 }
 
 
+/**
+ * FindBlockPos() and FindUndoPos() reserve space for the uncompressed size of a record. When a smaller compressed
+ * record was written instead, give the unused tail back, as long as nothing has been stored after it in the meantime.
+ */
+static void ReleaseUnusedFileSpace(int nFile, uint64_t nReservedEnd, uint64_t nUsedEnd, bool fUndo)
+{
+    LOCK(cs_LastBlockFile);
+    if (nFile < 0 || (size_t)nFile >= vinfoBlockFile.size() || nUsedEnd >= nReservedEnd)
+        return;
+    uint64_t &nFileSize = fUndo ? vinfoBlockFile[nFile].nUndoSize : vinfoBlockFile[nFile].nSize;
+    if (nFileSize == nReservedEnd)
+    {
+        nFileSize = nUsedEnd;
+        setDirtyFileInfo.insert(nFile);
+    }
+}
+
 bool WriteBlockToDiskSequential(const CBlock &block,
     CDiskBlockPos &pos,
     const CMessageHeader::MessageStartChars &messageStart)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
+    // Build the whole record, index header included, and hand it to the block file writer
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    unsigned int nSize = GetSerializeSize(ss, block);
+    std::vector<unsigned char> record;
+    const bool fCompress = GetBlockCompression() != BlockCompression::NONE;
+    if (fCompress)
     {
-        return error("WriteBlockToDisk: OpenBlockFile failed");
+        record = SerializeForStorage(block);
+        ss << FLATDATA(messageStart) << (unsigned int)record.size();
+        ss.write((const char *)record.data(), record.size());
+    }
+    else
+    {
+        ss << FLATDATA(messageStart) << nSize << block;
     }
 
-    // Write index header
-    unsigned int nSize = GetSerializeSize(fileout, block);
-    fileout << FLATDATA(messageStart) << nSize;
-
-    // Write block
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
+    const uint64_t nRecordPos = pos.nPos;
+    const uint64_t nHeaderSize = sizeof(messageStart) + sizeof(nSize);
+    pos.nPos = nRecordPos + nHeaderSize;
+    if (!blockFileWriter.Write(false, pos.nFile, nRecordPos, nHeaderSize,
+            std::vector<unsigned char>(ss.begin(), ss.end())))
     {
-        return error("WriteBlockToDisk: ftell failed");
+        return error("WriteBlockToDisk: write to block file %d failed", pos.nFile);
+    }
+    if (fCompress)
+    {
+        ReleaseUnusedFileSpace(pos.nFile, pos.nPos + nSize, pos.nPos + record.size(), false);
     }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
     return true;
 }
 
 CBlockRef ReadBlockFromDiskSequential(const CDiskBlockPos &pos, const Consensus::Params &consensusParams)
 {
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-    {
-        LOGA("ERROR: ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
-        return nullptr;
-    }
-
-    // Read block
     std::shared_ptr<CBlock> pblock = MakeBlockRef(CBlock());
-    try
+
+    // A block that is still queued for writing is read from memory
+    std::vector<unsigned char> pending;
+    if (blockFileWriter.ReadPending(false, pos, pending))
     {
-        filein >> *pblock;
+        try
+        {
+            if (IsCompressedRecord(pending.data(), pending.size()))
+            {
+                std::vector<unsigned char> raw;
+                DecompressRecord(pending.data(), pending.size(), raw);
+                pending.swap(raw);
+            }
+            CDataStream ss(pending, SER_DISK, CLIENT_VERSION);
+            ss >> *pblock;
+        }
+        catch (const std::exception &e)
+        {
+            LOGA("Error - %s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
+            return nullptr;
+        }
     }
-    catch (const std::exception &e)
+    else
     {
-        LOGA("Error - %s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
-        return nullptr;
+        // Open history file to read
+        CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+        {
+            LOGA("ERROR: ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+            return nullptr;
+        }
+
+        // Read block
+        try
+        {
+            std::vector<unsigned char> raw;
+            if (ReadCompressedRecord(filein, raw))
+            {
+                CDataStream ss(raw, SER_DISK, CLIENT_VERSION);
+                ss >> *pblock;
+            }
+            else
+            {
+                // an uncompressed block, start over
+                if (fseek(filein.Get(), pos.nPos, SEEK_SET))
+                    throw std::ios_base::failure("fseek failed");
+                filein >> *pblock;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOGA("Error - %s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+            return nullptr;
+        }
     }
 
     // Check the header
@@ -144,6 +234,49 @@ CBlockRef ReadBlockFromDiskSequential(const CDiskBlockPos &pos, const Consensus:
     return pblock;
 }
 
+bool ReadRawBlockFromDiskSequential(const CDiskBlockPos &pos, std::vector<unsigned char> &raw)
+{
+    raw.clear();
+    if (pos.IsNull() || pos.nPos < sizeof(unsigned int))
+        return error("%s: no block data at %s", __func__, pos.ToString());
+
+    std::vector<unsigned char> record;
+    if (!blockFileWriter.ReadPending(false, pos, record))
+    {
+        // The record size sits just in front of the data that pos points to
+        CDiskBlockPos sizePos(pos.nFile, pos.nPos - sizeof(unsigned int));
+        CAutoFile filein(OpenBlockFile(sizePos, true), SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+        try
+        {
+            unsigned int nSize = 0;
+            filein >> nSize;
+            if (nSize > MAX_BLOCKFILE_SIZE)
+                return error("%s: record size %u out of range at %s", __func__, nSize, pos.ToString());
+            record.resize(nSize);
+            filein.read((char *)record.data(), record.size());
+        }
+        catch (const std::exception &e)
+        {
+            return error("%s: I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        }
+    }
+
+    try
+    {
+        if (IsCompressedRecord(record.data(), record.size()))
+            DecompressRecord(record.data(), record.size(), raw);
+        else
+            raw.swap(record);
+    }
+    catch (const std::exception &e)
+    {
+        return error("%s: Decompress error - %s at %s", __func__, e.what(), pos.ToString());
+    }
+    return true;
+}
+
 /* Calculate the amount of disk space the block & undo files currently use */
 uint64_t CalculateCurrentUsage()
 {
@@ -248,32 +381,40 @@ bool WriteUndoToDiskSequenatial(const CBlockUndo &blockundo,
     const uint256 &hashBlock,
     const CMessageHeader::MessageStartChars &messageStart)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
+    // Build the whole record, index header and checksum included, and hand it to the block file writer
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    unsigned int nSize = GetSerializeSize(ss, blockundo);
+    std::vector<unsigned char> record;
+    const bool fCompress = GetBlockCompression() != BlockCompression::NONE;
+    if (fCompress)
     {
-        return error("%s: OpenUndoFile failed", __func__);
+        record = SerializeForStorage(blockundo);
+        ss << FLATDATA(messageStart) << (unsigned int)record.size();
+        ss.write((const char *)record.data(), record.size());
     }
-
-    // Write index header
-    unsigned int nSize = GetSerializeSize(fileout, blockundo);
-    fileout << FLATDATA(messageStart) << nSize;
-
-    // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
+    else
     {
-        return error("%s: ftell failed", __func__);
+        ss << FLATDATA(messageStart) << nSize << blockundo;
     }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
 
     // calculate & write checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
     hasher << blockundo;
-    fileout << hasher.GetHash();
+    ss << hasher.GetHash();
 
+    const uint64_t nRecordPos = pos.nPos;
+    const uint64_t nHeaderSize = sizeof(messageStart) + sizeof(nSize);
+    pos.nPos = nRecordPos + nHeaderSize;
+    if (!blockFileWriter.Write(true, pos.nFile, nRecordPos, nHeaderSize,
+            std::vector<unsigned char>(ss.begin(), ss.end())))
+    {
+        return error("%s: write to undo file %d failed", __func__, pos.nFile);
+    }
+    if (fCompress)
+    {
+        ReleaseUnusedFileSpace(pos.nFile, pos.nPos + nSize + 32, pos.nPos + record.size() + 32, true);
+    }
     return true;
 }
 
@@ -288,11 +429,31 @@ bool ReadUndoFromDiskSequential(CBlockUndo &blockundo, const CDiskBlockPos &pos,
 
     // Read block
     uint256 hashChecksum;
+    uint256 hashData;
     CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
     try
     {
-        verifier << hashBlock;
-        verifier >> blockundo;
+        std::vector<unsigned char> raw;
+        if (ReadCompressedRecord(filein, raw))
+        {
+            // The checksum covers the uncompressed serialization
+            CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
+            hasher << hashBlock;
+            hasher.write((const char *)raw.data(), raw.size());
+            hashData = hasher.GetHash();
+
+            CDataStream ss(raw, SER_DISK, CLIENT_VERSION);
+            ss >> blockundo;
+        }
+        else
+        {
+            // uncompressed undo data, start over
+            if (fseek(filein.Get(), pos.nPos, SEEK_SET))
+                throw std::ios_base::failure("fseek failed");
+            verifier << hashBlock;
+            verifier >> blockundo;
+            hashData = verifier.GetHash();
+        }
         filein >> hashChecksum;
     }
     catch (const std::exception &e)
@@ -301,7 +462,7 @@ bool ReadUndoFromDiskSequential(CBlockUndo &blockundo, const CDiskBlockPos &pos,
     }
 
     // Verify checksum
-    if (hashChecksum != verifier.GetHash())
+    if (hashChecksum != hashData)
     {
         return error("%s: Checksum mismatch", __func__);
     }
@@ -23,7 +23,8 @@ FILE *OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 /** Translation to a filesystem path */
 fs::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix);
 
-void FlushBlockFile(bool fFinalize = false);
+/** Write out and sync the block and undo files. Returns false if queued block data could not be written. */
+bool FlushBlockFile(bool fFinalize = false);
 
 /**
  *  Actually unlink the specified files
@@ -34,6 +35,8 @@ bool WriteBlockToDiskSequential(const CBlock &block,
     CDiskBlockPos &pos,
     const CMessageHeader::MessageStartChars &messageStart);
 CBlockRef ReadBlockFromDiskSequential(const CDiskBlockPos &pos, const Consensus::Params &consensusParams);
+/** Read the serialized block at pos as it is stored, decompressing it if needed but without deserializing it */
+bool ReadRawBlockFromDiskSequential(const CDiskBlockPos &pos, std::vector<unsigned char> &raw);
 void FindFilesToPruneSequential(std::set<int> &setFilesToPrune, uint64_t nPruneAfterHeight);
 bool WriteUndoToDiskSequenatial(const CBlockUndo &blockundo,
     CDiskBlockPos &pos,
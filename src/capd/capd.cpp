@@ -5,6 +5,7 @@
 
 
 // Counterparty and protocol discovery
+#include <algorithm>
 #include <limits>
 #include <queue>
 
@@ -21,7 +22,10 @@
 #include "hashwrapper.h"
 #include "httpserver.h"
 #include "rpc/server.h"
+#include "util.h"
 #include "utilstrencodings.h"
+#include "validationinterface.h"
+#include "workerpool.h"
 
 #include <univalue.h>
 
@@ -127,6 +131,12 @@ uint256 CapdMsg::CalcHash() const
 
 PriorityType CapdMsg::Priority() const { return ::Priority(difficultyBits, data.size(), GetTime() - createTime); }
 PriorityType CapdMsg::InitialPriority() const { return ::Priority(difficultyBits, data.size(), 0); }
+PriorityType CapdMsg::PriorityAt(int64_t time) const
+{
+    // Same decay as Priority(), but the age may be negative
+    PriorityType ret = InitialPriority();
+    return ret - (ret / MSG_LIFETIME_SEC) * (time - (int64_t)createTime);
+}
 bool CapdMsg::DoesPowMeetTarget() const { return GetPowTarget() > GetHash(); }
 std::string CapdMsg::EncodeHex()
 {
@@ -136,20 +146,7 @@ std::string CapdMsg::EncodeHex()
 }
 
 
-bool CapdMsg::checkNonce(unsigned char *stage1, const arith_uint256 &hashTarget)
-{
-    uint256 hash;
-    CHash256 sha2;
-    sha2.Write(stage1, CSHA256::OUTPUT_SIZE);
-    sha2.Write(&nonce[0], nonce.size());
-    sha2.Finalize(hash.begin());
-
-    if (hashTarget > UintToArith256(hash))
-        return true;
-    return false;
-}
-
-bool CapdMsg::Solve(long int time)
+bool CapdMsg::Solve(long int time, unsigned int nThreads, int64_t timeoutMs, const std::atomic<bool> *cancel)
 {
     cachedHash = uint256(); // Clear the hash because we are changing the message
     if (time < YEAR_OF_SECONDS)
@@ -160,82 +157,14 @@ bool CapdMsg::Solve(long int time)
     CDataStream serialized(SER_GETHASH, CLIENT_VERSION);
     serialized << *this;
 
+    // The nonce is hashed after everything else, so the first stage is the same for every candidate
     CSHA256 sha;
     sha.Write((unsigned char *)serialized.data(), serialized.size());
-    unsigned char stage1[CSHA256::OUTPUT_SIZE];
-    sha.Finalize(stage1);
+    uint256 stage1;
+    sha.Finalize(stage1.begin());
 
     arith_uint256 hashTarget = arith_uint256().SetCompact(difficultyBits);
-
-    bool solved = false;
-
-    do
-    {
-        // Looking for the shortest solution means searching all possibilities of different nonce lengths.
-        nonce.resize(1);
-        uint64_t count = 0;
-        while (count < 256)
-        {
-            nonce[0] = count & 255;
-            if (checkNonce(stage1, hashTarget))
-            {
-                solved = true;
-                break;
-            }
-            count++;
-        }
-        if (solved)
-            break;
-
-        count = 0;
-        nonce.resize(2);
-        while (count < 256 * 256)
-        {
-            nonce[0] = count & 255;
-            nonce[1] = count >> 8;
-            if (checkNonce(stage1, hashTarget))
-            {
-                solved = true;
-                break;
-            }
-            count++;
-        }
-        if (solved)
-            break;
-
-        count = 0;
-        nonce.resize(3);
-        while (count < 256 * 256 * 256)
-        {
-            nonce[0] = count & 255;
-            nonce[1] = count >> 8;
-            nonce[2] = count >> 16;
-            if (checkNonce(stage1, hashTarget))
-            {
-                solved = true;
-                break;
-            }
-            count++;
-        }
-
-        count = 0;
-        nonce.resize(4);
-        while (count < 256UL * 256UL * 256UL * 256UL)
-        {
-            nonce[0] = count & 255;
-            nonce[1] = count >> 8;
-            nonce[2] = count >> 16;
-            nonce[3] = count >> 24;
-            if (checkNonce(stage1, hashTarget))
-            {
-                solved = true;
-                break;
-            }
-            count++;
-        }
-    } while (0);
-
-    return solved;
+    return SolveCapdNonce(stage1, hashTarget, nonce, nThreads, timeoutMs, cancel);
 }
 
 void CapdMsgPool::add(const CapdMsg &msg)
@@ -248,13 +177,17 @@ void CapdMsgPool::add(const CapdMsgRef &msg)
 {
     bool broadcast = false;
 
+    // Hashing does not need the pool, so do it before taking the lock.  The hash is cached in the message, so this
+    // is only a comparison if CapdProtocol::CheckPow already verified it.
+    if (!msg->DoesPowMeetTarget())
+    {
+        LOG(CAPD, "Message POW inconsistent");
+        throw CapdMsgPoolException("Message POW inconsistent");
+    }
+
     {
         WRITELOCK(csMsgPool);
-        if (!msg->DoesPowMeetTarget())
-        {
-            LOG(CAPD, "Message POW inconsistent");
-            throw CapdMsgPoolException("Message POW inconsistent");
-        }
+        _RefreshPriorities();
 
         if (msg->Priority() < _GetLocalPriority())
         {
@@ -267,7 +200,7 @@ void CapdMsgPool::add(const CapdMsgRef &msg)
         {
             // Free up some room
             _pare(msg->RamSize());
-            msgs.insert(msg);
+            msgs.insert(CapdMsgPoolEntry{msg, msg->PriorityAt(priorityTime)});
             size += msg->RamSize();
             broadcast = true;
         }
@@ -282,6 +215,8 @@ void CapdMsgPool::add(const CapdMsgRef &msg)
         auto *p = p2p; // Throw in a temp to avoid locking
         if (p)
             p->GossipMessage(msg);
+        subscriptions.Notify(msg);
+        GetMainSignals().NewCapdMessage(msg);
     }
 }
 
@@ -318,6 +253,27 @@ void CapdMsg::SetPowTargetHarderThanPriority(PriorityType priority)
     SetPowTargetHarderThan(PriorityToPowTarget(priority, data.size()));
 }
 
+void CapdMsgPool::_RefreshPriorities()
+{
+    int64_t now = GetTime();
+    if (now >= priorityTime && now - priorityTime < CAPD_PRIORITY_REFRESH_SEC)
+        return;
+    priorityTime = now;
+    // Walk the hash index, whose order does not change, and let each entry move to its new place in the priority index
+    for (MsgIter i = msgs.begin(); i != msgs.end(); i++)
+        msgs.modify(i, [this](CapdMsgPoolEntry &entry) { entry.priority = entry.msg->PriorityAt(priorityTime); });
+}
+
+CapdMsgRef CapdMsgPool::_GetMsgAtPercentile(unsigned int percentile) const
+{
+    auto &priorityIndexer = msgs.get<MsgPriorityTag>();
+    size_t count = priorityIndexer.size();
+    if (count == 0)
+        return nullmsgref;
+    size_t n = std::min(count * std::min(percentile, 100U) / 100, count - 1);
+    return priorityIndexer.nth(n)->msg;
+}
+
 uint256 CapdMsgPool::_GetRelayPowTarget()
 {
     static const uint256 minFwdDiffTgt = ArithToUint256(MIN_FORWARD_MSG_DIFFICULTY);
@@ -325,19 +281,11 @@ uint256 CapdMsgPool::_GetRelayPowTarget()
     if (size < maxSize * 8 / 10)
         return minFwdDiffTgt; // If the pool isn't filled up, return the minimum.
 
-    auto &priorityIndexer = msgs.get<MsgPriorityTag>();
-
-    unsigned int half = priorityIndexer.size() / 2;
-
-    MsgIterByPriority i = priorityIndexer.begin();
-    for (unsigned int j = 0; j < half; j++, i++)
-    {
-    } // essentially i += half;
-
-    if (i == priorityIndexer.end())
+    CapdMsgRef median = _GetMsgAtPercentile(50);
+    if (median == nullmsgref)
         return minFwdDiffTgt;
 
-    uint256 ret = (*i)->GetPowTarget();
+    uint256 ret = median->GetPowTarget();
     if (ret > minFwdDiffTgt)
         return minFwdDiffTgt;
     return ret;
@@ -350,13 +298,11 @@ uint256 CapdMsgPool::_GetLocalPowTarget()
     if (size < maxSize * 8 / 10)
         return minLclDiffTgt; // If the pool isn't filled up, return the minimum.
 
-    auto &priorityIndexer = msgs.get<MsgPriorityTag>();
-
-    MsgIterByPriority i = priorityIndexer.begin();
-    if (i == priorityIndexer.end())
+    CapdMsgRef lowest = _GetMsgAtPercentile(0);
+    if (lowest == nullmsgref)
         return minLclDiffTgt;
 
-    uint256 ret = (*i)->GetPowTarget();
+    uint256 ret = lowest->GetPowTarget();
     if (ret > minLclDiffTgt)
         return minLclDiffTgt;
     return ret;
@@ -367,19 +313,11 @@ PriorityType CapdMsgPool::_GetRelayPriority()
     if (size < maxSize * 8 / 10)
         return MIN_RELAY_PRIORITY;
 
-    auto &priorityIndexer = msgs.get<MsgPriorityTag>();
-
-    unsigned int half = priorityIndexer.size() / 2;
-
-    MsgIterByPriority i = priorityIndexer.begin();
-    for (unsigned int j = 0; j < half; j++, i++)
-    {
-    } // essentially i += half;
-
-    if (i == priorityIndexer.end())
+    CapdMsgRef median = _GetMsgAtPercentile(50);
+    if (median == nullmsgref)
         return MIN_RELAY_PRIORITY;
 
-    PriorityType ret = (*i)->Priority();
+    PriorityType ret = median->Priority();
     if (ret < MIN_RELAY_PRIORITY)
         return MIN_RELAY_PRIORITY;
     return ret;
@@ -390,13 +328,11 @@ PriorityType CapdMsgPool::_GetLocalPriority()
     if (size < maxSize * 8 / 10)
         return MIN_LOCAL_PRIORITY;
 
-    auto &priorityIndexer = msgs.get<MsgPriorityTag>();
-
-    MsgIterByPriority i = priorityIndexer.begin();
-    if (i == priorityIndexer.end())
+    CapdMsgRef lowest = _GetMsgAtPercentile(0);
+    if (lowest == nullmsgref)
         return MIN_LOCAL_PRIORITY;
 
-    PriorityType ret = (*i)->Priority();
+    PriorityType ret = lowest->Priority();
     if (ret < MIN_LOCAL_PRIORITY)
         return MIN_LOCAL_PRIORITY;
     return ret;
@@ -404,16 +340,11 @@ PriorityType CapdMsgPool::_GetLocalPriority()
 
 PriorityType CapdMsgPool::_GetHighestPriority()
 {
-    auto &priorityIndexer = msgs.get<MsgPriorityTag>();
-
-    MsgIterByPriority i = priorityIndexer.begin();
-    if (i == priorityIndexer.end())
+    CapdMsgRef highest = _GetMsgAtPercentile(100);
+    if (highest == nullmsgref)
         return MIN_RELAY_PRIORITY;
 
-    MsgIterByPriority last = priorityIndexer.end();
-    last--;
-
-    PriorityType ret = (*last)->Priority();
+    PriorityType ret = highest->Priority();
     if (ret < MIN_RELAY_PRIORITY)
         return MIN_RELAY_PRIORITY;
     return ret;
@@ -422,21 +353,23 @@ PriorityType CapdMsgPool::_GetHighestPriority()
 
 void CapdMsgPool::_pare(int len)
 {
-    len -= maxSize - size; // We already have this amount available
+    int64_t needed = (int64_t)len + (int64_t)size - (int64_t)maxSize; // We already have maxSize - size available
+    if (needed <= 0)
+        return;
+    needed += maxSize / CAPD_PARE_BATCH_DIVISOR;
+
+    _RefreshPriorities();
     auto &priorityIndexer = msgs.get<MsgPriorityTag>();
     MsgIterByPriority i = priorityIndexer.begin();
     auto end = priorityIndexer.end();
-
-    while ((len > 0) && (i != end))
+    while ((needed > 0) && (i != end))
     {
-        auto txSize = (*i)->RamSize();
-        len -= txSize;
-        size -= txSize;
-
-        auto j = i; // Advance before erase
+        auto msgSize = i->msg->RamSize();
+        needed -= msgSize;
+        size -= msgSize;
         i++;
-        priorityIndexer.erase(j);
     }
+    priorityIndexer.erase(priorityIndexer.begin(), i);
 }
 
 
@@ -446,7 +379,7 @@ CapdMsgRef CapdMsgPool::find(const uint256 &hash) const
     MsgIter i = msgs.find(hash);
     if (i == msgs.end())
         return nullmsgref;
-    return *i;
+    return i->msg;
 }
 
 std::vector<CapdMsgRef> CapdMsgPool::find(const std::vector<unsigned char> &v) const
@@ -461,9 +394,9 @@ std::vector<CapdMsgRef> CapdMsgPool::find(const std::vector<unsigned char> &v) c
         std::vector<CapdMsgRef> ret;
         for (; it != indexer.end(); it++)
         {
-            if (!(*it)->matches(srch))
+            if (!it->msg->matches(srch))
                 break;
-            ret.push_back(*it);
+            ret.push_back(it->msg);
         }
         return ret;
     }
@@ -477,9 +410,9 @@ std::vector<CapdMsgRef> CapdMsgPool::find(const std::vector<unsigned char> &v) c
         std::vector<CapdMsgRef> ret;
         for (; it != indexer.end(); it++)
         {
-            if (!(*it)->matches(srch))
+            if (!it->msg->matches(srch))
                 break;
-            ret.push_back(*it);
+            ret.push_back(it->msg);
         }
         return ret;
     }
@@ -495,9 +428,9 @@ std::vector<CapdMsgRef> CapdMsgPool::find(const std::vector<unsigned char> &v) c
         std::vector<CapdMsgRef> ret;
         for (; it != indexer.end(); it++)
         {
-            if (!(*it)->matches(srch))
+            if (!it->msg->matches(srch))
                 break;
-            ret.push_back(*it);
+            ret.push_back(it->msg);
         }
         return ret;
     }
@@ -513,9 +446,9 @@ std::vector<CapdMsgRef> CapdMsgPool::find(const std::vector<unsigned char> &v) c
         std::vector<CapdMsgRef> ret;
         for (; it != indexer.end(); it++)
         {
-            if (!(*it)->matches(srch))
+            if (!it->msg->matches(srch))
                 break;
-            ret.push_back(*it);
+            ret.push_back(it->msg);
         }
         return ret;
     }
@@ -523,6 +456,139 @@ std::vector<CapdMsgRef> CapdMsgPool::find(const std::vector<unsigned char> &v) c
     return std::vector<CapdMsgRef>();
 }
 
+uint64_t CapdSubscriptions::Subscribe(const std::vector<unsigned char> &prefix, size_t maxQueue)
+{
+    if (prefix.size() > MAX_PREFIX_SIZE)
+        throw CapdMsgPoolException("Subscription prefix is too long");
+
+    std::lock_guard<std::mutex> lock(csSubscriptions);
+    _ExpireIdle();
+    uint64_t id = nextId++;
+    Subscription &sub = subscriptions[id];
+    sub.prefix = prefix;
+    sub.maxQueue = std::max<size_t>(1, std::min<size_t>(maxQueue, MAX_QUEUE));
+    sub.dropped = 0;
+    sub.lastPoll = GetTime();
+    byPrefix[prefix.size()][std::string(prefix.begin(), prefix.end())].push_back(id);
+    return id;
+}
+
+bool CapdSubscriptions::Unsubscribe(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(csSubscriptions);
+    auto it = subscriptions.find(id);
+    if (it == subscriptions.end())
+        return false;
+    _Unsubscribe(it);
+    // Wake a poll that is waiting on this subscription so that it returns
+    condMessages.notify_all();
+    return true;
+}
+
+void CapdSubscriptions::_Unsubscribe(std::map<uint64_t, Subscription>::iterator it)
+{
+    const std::vector<unsigned char> &prefix = it->second.prefix;
+    auto lengthBucket = byPrefix.find(prefix.size());
+    auto prefixBucket = lengthBucket->second.find(std::string(prefix.begin(), prefix.end()));
+    std::vector<uint64_t> &ids = prefixBucket->second;
+    ids.erase(std::find(ids.begin(), ids.end(), it->first));
+    if (ids.empty())
+    {
+        lengthBucket->second.erase(prefixBucket);
+        if (lengthBucket->second.empty())
+            byPrefix.erase(lengthBucket);
+    }
+    subscriptions.erase(it);
+}
+
+void CapdSubscriptions::_ExpireIdle()
+{
+    int64_t now = GetTime();
+    if (now - lastExpiry < 60)
+        return;
+    lastExpiry = now;
+    for (auto it = subscriptions.begin(); it != subscriptions.end();)
+    {
+        auto cur = it++;
+        if (now - cur->second.lastPoll > CAPD_SUBSCRIPTION_IDLE_SEC)
+        {
+            LOG(CAPD, "Capd: removing idle subscription %d\n", cur->first);
+            _Unsubscribe(cur);
+        }
+    }
+}
+
+bool CapdSubscriptions::Poll(uint64_t id,
+    size_t maxMsgs,
+    int64_t timeoutMs,
+    std::vector<CapdMsgRef> &msgs,
+    uint64_t &dropped)
+{
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(std::min(timeoutMs, CAPD_MAX_POLL_TIMEOUT_MS));
+    std::unique_lock<std::mutex> lock(csSubscriptions);
+    while (true)
+    {
+        // Look the subscription up again after every wait, since it may have been removed meanwhile
+        auto it = subscriptions.find(id);
+        if (it == subscriptions.end())
+            return false;
+        Subscription &sub = it->second;
+        sub.lastPoll = GetTime();
+        if (!sub.queue.empty() || fInterrupted || std::chrono::steady_clock::now() >= deadline)
+        {
+            size_t count = std::min(maxMsgs, sub.queue.size());
+            msgs.assign(sub.queue.begin(), sub.queue.begin() + count);
+            sub.queue.erase(sub.queue.begin(), sub.queue.begin() + count);
+            dropped = sub.dropped;
+            sub.dropped = 0;
+            return true;
+        }
+        condMessages.wait_until(lock, deadline);
+    }
+}
+
+void CapdSubscriptions::Notify(const CapdMsgRef &msg)
+{
+    std::lock_guard<std::mutex> lock(csSubscriptions);
+    bool queued = false;
+    for (auto &lengthBucket : byPrefix)
+    {
+        size_t len = lengthBucket.first;
+        if (msg->data.size() < len)
+            break; // The buckets are in order of length, so no longer prefix can match either
+        auto prefixBucket = lengthBucket.second.find(std::string(msg->data.begin(), msg->data.begin() + len));
+        if (prefixBucket == lengthBucket.second.end())
+            continue;
+        for (uint64_t id : prefixBucket->second)
+        {
+            Subscription &sub = subscriptions[id];
+            if (sub.queue.size() >= sub.maxQueue)
+            {
+                sub.queue.pop_front();
+                sub.dropped++;
+            }
+            sub.queue.push_back(msg);
+            queued = true;
+        }
+    }
+    if (queued)
+        condMessages.notify_all();
+}
+
+size_t CapdSubscriptions::Count() const
+{
+    std::lock_guard<std::mutex> lock(csSubscriptions);
+    return subscriptions.size();
+}
+
+void CapdSubscriptions::Interrupt()
+{
+    std::lock_guard<std::mutex> lock(csSubscriptions);
+    fInterrupted = true;
+    condMessages.notify_all();
+}
+
 static const uint64_t MSGPOOL_DUMP_VERSION = 1;
 bool CapdMsgPool::LoadMsgPool(void)
 {
@@ -551,13 +617,14 @@ bool CapdMsgPool::LoadMsgPool(void)
         uint64_t num;
         file >> num;
         WRITELOCK(csMsgPool);
+        _RefreshPriorities();
         while (num--)
         {
             CapdMsg msg;
             file >> msg;
             CapdMsgRef ref = std::make_shared<CapdMsg>(msg);
             {
-                msgs.insert(ref);
+                msgs.insert(CapdMsgPoolEntry{ref, ref->PriorityAt(priorityTime)});
                 size += ref->RamSize();
                 ++count;
             }
@@ -603,7 +670,7 @@ bool CapdMsgPool::DumpMsgPool(void)
         MsgIterByPriority i = priorityIndexer.begin();
         for (unsigned int j = 0; i != priorityIndexer.end(); j++, i++)
         {
-            file << *((*i).get());
+            file << *(i->msg);
         }
 
         FileCommit(file.Get());
@@ -627,8 +694,9 @@ void CapdMsgPool::_DbgDump()
     MsgIterByPriority i = priorityIndexer.begin();
     for (unsigned int j = 0; i != priorityIndexer.end(); j++, i++)
     {
-        printf("%4d: priority:%f - difficulty:%s -- %s %.8s\n", j, (*i)->Priority(),
-            (*i)->GetPowTarget().GetHex().c_str(), (*i)->GetHash().GetHex().c_str(), &(*i)->data[0]);
+        const CapdMsgRef &m = i->msg;
+        printf("%4d: priority:%f - difficulty:%s -- %s %.8s\n", j, m->Priority(), m->GetPowTarget().GetHex().c_str(),
+            m->GetHash().GetHex().c_str(), &m->data[0]);
     }
 
     printf("relay: %s, local: %s\n", _GetRelayPowTarget().GetHex().c_str(), _GetLocalPowTarget().GetHex().c_str());
@@ -786,14 +854,13 @@ bool CapdProtocol::HandleCapdMessage(CNode *pfrom,
     else if (command == NetMsgType::CAPDMSG)
     {
         std::vector<CapdMsg> msgs; // TODO deserialize as CapdMsgRefs
+        std::vector<CapdMsgRef> candidates;
         std::vector<CapdMsgRef> goodMsgs;
         vRecv >> msgs;
         LOG(CAPD, "Capd: Received %d messages", msgs.size());
-        for (const CapdMsg &msg : msgs)
+        for (CapdMsg &msg : msgs)
         {
-            auto msgRef = MakeMsgRef(CapdMsg(msg));
-            uint256 hash = msgRef->GetHash();
-            LOG(CAPD, "received Msg %s\n", hash.GetHex());
+            auto msgRef = MakeMsgRef(std::move(msg));
             PriorityType priority = msgRef->Priority();
             LOG(CAPD, "Msg priority %f\n", priority);
             if (priority < cn->receivePriority)
@@ -803,6 +870,20 @@ bool CapdProtocol::HandleCapdMessage(CNode *pfrom,
                     msgRef->GetHash().GetHex(), pfrom->GetLogName(), priority, cn->receivePriority);
                 continue;
             }
+            candidates.push_back(msgRef);
+        }
+
+        // Hash the whole burst at once so that large bursts are verified by the proof of work threads
+        std::vector<unsigned char> powOk = CheckPow(candidates);
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            const CapdMsgRef &msgRef = candidates[i];
+            LOG(CAPD, "received Msg %s\n", msgRef->GetHash().GetHex());
+            if (!powOk[i])
+            {
+                LOG(CAPD, "Capd drop: message POW inconsistent");
+                continue;
+            }
 
             try
             {
@@ -911,6 +992,21 @@ void CapdProtocol::FlushGossipMessagesToNodes()
     }
 }
 
+std::vector<unsigned char> CapdProtocol::CheckPow(const std::vector<CapdMsgRef> &msgs)
+{
+    std::vector<unsigned char> results(msgs.size(), 0);
+    if (msgs.size() < CAPD_POW_CHECK_PARALLEL_MIN)
+    {
+        for (size_t i = 0; i < msgs.size(); i++)
+            results[i] = msgs[i]->DoesPowMeetTarget();
+        return results;
+    }
+
+    // A bad message fails only itself, so the rest of the burst keeps being checked
+    workerPool.Run(msgs.size(), [&](size_t i) { results[i] = msgs[i]->DoesPowMeetTarget(); });
+    return results;
+}
+
 void CapdNode::clear()
 {
     LOCK(csCapdNode);
@@ -1205,13 +1301,13 @@ bool StartCapd()
 {
     /* CAPD HTTPD handler currently off
     for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
-        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler);
+        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler, HTTP_WORK_REST);
     */
 
     return true;
 }
 
-void InterruptCapd() {}
+void InterruptCapd() { msgpool.subscriptions.Interrupt(); }
 void StopCapd()
 {
     for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
@@ -7,10 +7,19 @@
 #define NEXA_CAPD_H
 
 // Counterparty and protocol discovery
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <unordered_map>
 
 #include "arith_uint256.h"
+#include "capd/capdsolver.h"
 #include "crypto/sha256.h"
 #include "fastfilter.h"
 #include "protocol.h"
@@ -21,7 +30,9 @@
 
 #undef foreach
 #include "boost/multi_index/hashed_index.hpp"
+#include "boost/multi_index/member.hpp"
 #include "boost/multi_index/ordered_index.hpp"
+#include "boost/multi_index/ranked_index.hpp"
 #include "boost/multi_index_container.hpp"
 
 class CNode;
@@ -33,6 +44,7 @@ extern const uint64_t CAPD_MAX_MSG_TO_REQUEST;
 extern const uint64_t CAPD_MAX_MSG_TO_SEND;
 
 extern bool StartCapd();
+extern void InterruptCapd();
 extern void StopCapd();
 
 typedef double PriorityType;
@@ -44,6 +56,19 @@ extern arith_uint256 MIN_LOCAL_MSG_DIFFICULTY;
 
 extern uint64_t MSG_LIFETIME_SEC; //!< expected message lifetime in seconds
 
+/** The message pool orders messages by their priority at a reference time, and moves that time forward (recomputing
+    every message's position) once the clock is this many seconds past it */
+static const int64_t CAPD_PRIORITY_REFRESH_SEC = 10;
+/** When the pool is full, evict enough messages to also free 1/CAPD_PARE_BATCH_DIVISOR of its maximum size, so that
+    a stream of new messages does not evict one message per insert */
+static const uint64_t CAPD_PARE_BATCH_DIVISOR = 100;
+/** Bursts of at least this many messages have their proof of work checked on the worker pool */
+static const size_t CAPD_POW_CHECK_PARALLEL_MIN = 16;
+/** Subscriptions that have not been polled for this many seconds are removed */
+static const int64_t CAPD_SUBSCRIPTION_IDLE_SEC = 600;
+/** The longest a subscription poll may wait for messages, in milliseconds */
+static const int64_t CAPD_MAX_POLL_TIMEOUT_MS = 60 * 1000;
+
 /** The minimum message priority accepted and forwarded by the network
     Having a minimum reduces spam even if the msg pool is under utilized */
 extern PriorityType MIN_RELAY_PRIORITY;
@@ -200,8 +225,6 @@ protected:
         RESCINDHASH = 2,
     };
 
-    bool checkNonce(unsigned char *stage1, const arith_uint256 &hashTarget);
-
 public:
     static const uint8_t CURRENT_VERSION = 0;
 
@@ -339,7 +362,15 @@ public:
     @return True if the message is solved.  This function will check billions of solns so will hang before returning
     false.
     */
-    bool Solve(long int creationTime = 0);
+    bool Solve(long int creationTime = 0) { return Solve(creationTime, 1); }
+
+    /** Solve() using nThreads threads, giving up after timeoutMs milliseconds (0 means no limit) or once *cancel is
+        true.  The nonce found is the same whichever the number of threads.  See SolveCapdNonce.
+    */
+    bool Solve(long int creationTime,
+        unsigned int nThreads,
+        int64_t timeoutMs = 0,
+        const std::atomic<bool> *cancel = nullptr);
 
     /** Set difficulty bits based on difficulty value */
     void SetPowTarget(arith_uint256 target) { difficultyBits = target.GetCompact(); }
@@ -362,6 +393,9 @@ public:
     /** Returns the message's original priority (without time adjustment) */
     PriorityType InitialPriority() const;
 
+    /** Returns the message's priority at this time (seconds since epoch), which may be before its creation time */
+    PriorityType PriorityAt(int64_t time) const;
+
     /** Serialize into a hex string */
     std::string EncodeHex();
 };
@@ -385,11 +419,19 @@ public:
     bool operator()(const CapdMsgRef &a, const CapdMsgRef &b) const { return (a->Priority() < b->Priority()); }
 };
 
-// extracts a TxMemPoolEntry's transaction hash
+//! A message in the pool
+struct CapdMsgPoolEntry
+{
+    CapdMsgRef msg;
+    //! The message's priority at the pool's reference time, so that every entry is ordered at the same moment
+    PriorityType priority;
+};
+
+// extracts a message pool entry's message hash
 struct MsgHashExtractor
 {
     typedef uint256 result_type;
-    result_type operator()(const CapdMsgRef &msg) const { return msg->GetHash(); }
+    result_type operator()(const CapdMsgPoolEntry &entry) const { return entry.msg->GetHash(); }
 };
 
 class CapdMsgPoolException : public std::exception
@@ -407,8 +449,9 @@ class MsgLookupNExtractor
 public:
     typedef std::array<unsigned char, N> result_type;
 
-    result_type operator()(const CapdMsgRef &r) const
+    result_type operator()(const CapdMsgPoolEntry &entry) const
     {
+        const CapdMsgRef &r = entry.msg;
         result_type ret;
         size_t end = std::min(N, (size_t)r->data.size());
         size_t i;
@@ -476,18 +519,78 @@ struct MsgLookup16
 {
 };
 
+/** Local clients' subscriptions to the messages that start with a prefix.
+    A new message is matched with one hash lookup per distinct prefix length in use, however many subscriptions there
+    are, and a reference to it is queued on every matching subscription until the client polls.  Each queue is
+    bounded: when it is full the oldest message is dropped and counted.
+ */
+class CapdSubscriptions
+{
+public:
+    enum
+    {
+        DEFAULT_MAX_QUEUE = 1000,
+        MAX_QUEUE = 100000,
+        MAX_PREFIX_SIZE = 16
+    };
+
+    /** Subscribe to messages whose data starts with prefix (an empty prefix matches every message), keeping at most
+        maxQueue of them until they are polled.  Returns the subscription id.  Throws CapdMsgPoolException if the
+        prefix is longer than MAX_PREFIX_SIZE. */
+    uint64_t Subscribe(const std::vector<unsigned char> &prefix, size_t maxQueue = DEFAULT_MAX_QUEUE);
+
+    /** Remove a subscription.  Returns false if there is no such subscription. */
+    bool Unsubscribe(uint64_t id);
+
+    /** Take up to maxMsgs queued messages, oldest first, waiting up to timeoutMs for one to arrive if none is queued.
+        dropped is set to the number of messages lost to a full queue since the last poll.
+        Returns false if there is no such subscription. */
+    bool Poll(uint64_t id, size_t maxMsgs, int64_t timeoutMs, std::vector<CapdMsgRef> &msgs, uint64_t &dropped);
+
+    /** Queue a new message on every subscription whose prefix it matches */
+    void Notify(const CapdMsgRef &msg);
+
+    /** Return the number of subscriptions */
+    size_t Count() const;
+
+    /** Wake every waiting poll and stop polls from waiting, for shutdown */
+    void Interrupt();
+
+protected:
+    struct Subscription
+    {
+        std::vector<unsigned char> prefix;
+        size_t maxQueue;
+        std::deque<CapdMsgRef> queue;
+        uint64_t dropped;
+        int64_t lastPoll;
+    };
+
+    mutable std::mutex csSubscriptions;
+    std::condition_variable condMessages;
+    bool fInterrupted = false;
+    uint64_t nextId = 1;
+    int64_t lastExpiry = 0;
+    std::map<uint64_t, Subscription> subscriptions;
+    //! Subscription ids by prefix length, and then by prefix
+    std::map<size_t, std::unordered_map<std::string, std::vector<uint64_t> > > byPrefix;
+
+    void _Unsubscribe(std::map<uint64_t, Subscription>::iterator it);
+    //! Remove the subscriptions that have been idle for CAPD_SUBSCRIPTION_IDLE_SEC, at most once a minute
+    void _ExpireIdle();
+};
+
 //! The pool of all current messages
 class CapdMsgPool
 {
 protected:
-    typedef boost::multi_index_container<CapdMsgRef,
+    typedef boost::multi_index_container<CapdMsgPoolEntry,
         boost::multi_index::indexed_by<
             // sorted by message id (hash)
             boost::multi_index::ordered_unique<MsgHashExtractor>,
-            // priority:  TODO: replace with random_access so we can grab the median element efficiently
-            boost::multi_index::ordered_non_unique<boost::multi_index::tag<MsgPriorityTag>,
-                boost::multi_index::identity<CapdMsgRef>,
-                CompareCapdMsgRefByPriority>,
+            // priority: ranked so that the element at any position (such as the median) is found in O(log n)
+            boost::multi_index::ranked_non_unique<boost::multi_index::tag<MsgPriorityTag>,
+                boost::multi_index::member<CapdMsgPoolEntry, PriorityType, &CapdMsgPoolEntry::priority> >,
             boost::multi_index::
                 hashed_non_unique<boost::multi_index::tag<MsgLookup2>, MsgLookupNExtractor<2>, ArrayHash2>,
             boost::multi_index::
@@ -509,6 +612,12 @@ protected:
     uint64_t size = 0;
     /** the largest this msg pool should become */
     uint64_t maxSize = DEFAULT_MSG_POOL_MAX_SIZE;
+    /** Every entry's priority key is the message's priority at this time (seconds since epoch).  Priorities decay at
+        rates that depend on each message, so the order is only exact at one moment. */
+    int64_t priorityTime = 0;
+
+    /** Move priorityTime to now and recompute every entry's key, if CAPD_PRIORITY_REFRESH_SEC have passed */
+    void _RefreshPriorities();
 
     CapdProtocol *p2p = nullptr;
 
@@ -518,6 +627,9 @@ public:
         DEFAULT_MSG_POOL_MAX_SIZE = 10 * 1024 * 1024
     };
 
+    /** Local clients' subscriptions to the messages that enter this pool */
+    CapdSubscriptions subscriptions;
+
     CapdMsgPool(CapdProtocol *protoHandler = nullptr) : maxSize(DEFAULT_MSG_POOL_MAX_SIZE) {}
     /** Set a new maximum size for this message pool */
     void SetMaxSize(uint64_t newSize)
@@ -578,6 +690,15 @@ public:
     }
     PriorityType _GetHighestPriority();
 
+    /** Return the message at this percentile of the priority order (0 is the lowest priority message, 100 the
+        highest), or a null pointer if the pool is empty.  This is an O(log n) lookup. */
+    CapdMsgRef GetMsgAtPercentile(unsigned int percentile) const
+    {
+        READLOCK(csMsgPool);
+        return _GetMsgAtPercentile(percentile);
+    }
+    CapdMsgRef _GetMsgAtPercentile(unsigned int percentile) const;
+
     /** Add a message into the message pool.  Throws CapdMsgPoolException if the message was not added.
      */
     void add(const CapdMsgRef &msg);
@@ -615,7 +736,7 @@ public:
         auto end = priorityIndexer.end();
         for (MsgIterByPriority i = priorityIndexer.begin(); i != end; i++)
         {
-            CapdMsgRef m = *i;
+            CapdMsgRef m = i->msg;
             if (!f(m))
                 return false;
         }
@@ -632,7 +753,8 @@ public:
     /** Content search */
     std::vector<CapdMsgRef> find(const std::vector<unsigned char> &c) const;
 
-    /** Remove enough lowest priority messages to make at least len bytes available in the msgpool */
+    /** Remove enough lowest priority messages to make at least len bytes available in the msgpool.  If any have to
+        be removed, a batch of 1/CAPD_PARE_BATCH_DIVISOR of the pool's maximum size is freed beyond that. */
     void pare(int len)
     {
         WRITELOCK(csMsgPool);
@@ -676,6 +798,11 @@ public:
 
     /** Notify nodes about the existence of a message */
     void GossipMessage(const CapdMsgRef &msg);
+
+    /** Check the proof of work of each message, returning 1 for each message that meets its target and 0 otherwise.
+        Bursts of at least CAPD_POW_CHECK_PARALLEL_MIN messages are split across the worker pool.  Every message's
+        hash is cached as a side effect. */
+    std::vector<unsigned char> CheckPow(const std::vector<CapdMsgRef> &msgs);
 };
 
 /** This class stores info relevant to each CNode.
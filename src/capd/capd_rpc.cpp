@@ -14,6 +14,7 @@
 #include "httpserver.h"
 #include "rpc/server.h"
 #include "utilstrencodings.h"
+#include "workerpool.h"
 
 UniValue CapdMsg2UniValue(CapdMsgRef msg)
 {
@@ -33,17 +34,41 @@ UniValue CapdMsg2UniValue(CapdMsgRef msg)
     return ret;
 }
 
+// Numeric subcommand arguments arrive as strings from nexa-cli, since capd's parameters are not converted
+static int64_t CapdIntParam(const UniValue &param)
+{
+    if (param.isNum())
+        return param.get_int64();
+    int64_t ret;
+    if (!ParseInt64(param.get_str(), &ret))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid number: " + param.get_str());
+    return ret;
+}
+
 UniValue capdrpc(const UniValue &params, bool fHelp)
 {
     if (fHelp)
         throw std::runtime_error("capd\n"
-                                 "\nCAPD RPC calls, including info, get, list, and clear.\n"
+                                 "\nCAPD RPC calls, including info, get, list, clear, send, solve, subscribe, poll\n"
+                                 "and unsubscribe.\n"
                                  "capd clear: removes all messages from the pool.\n"
                                  "capd get <message hash>: returns a particular message.\n"
                                  "capd info: returns information about the message pool.\n"
                                  "capd list: returns the hash of every message in the pool.\n"
-                                 "capd send <message data>: sends hex (preferred) or ascii encoded message.\n"
-                                 "    To force ascii encoding use a non-hex character.\n"
+                                 "capd send <message data> [time budget ms] [priority]: sends hex (preferred)\n"
+                                 "    or ascii encoded message.  To force ascii encoding use a non-hex character.\n"
+                                 "    The proof of work is solved on every core, giving up after the time budget\n"
+                                 "    if one is given.  The priority defaults to the pool's relay priority.\n"
+                                 "capd solve <message data> [time budget ms] [priority]: like send, but returns\n"
+                                 "    the solved message (as capd get does, plus \"hex\" and \"solveTimeMs\")\n"
+                                 "    without sending it.\n"
+                                 "capd subscribe <hex prefix> [max queue]: queue every new message whose data\n"
+                                 "    starts with the prefix (\"\" matches all), keeping at most max queue\n"
+                                 "    (default 1000) until polled.  Returns the subscription id.\n"
+                                 "    Subscriptions that are not polled for 10 minutes expire.\n"
+                                 "capd poll <id> [timeout ms] [max messages]: return the queued messages,\n"
+                                 "    waiting up to timeout ms (default 0, at most 60000) for one to arrive.\n"
+                                 "capd unsubscribe <id>: removes a subscription.\n"
                                  "\nResult: \n"
                                  "capd info\n"
                                  "{                           (json object)\n"
@@ -68,6 +93,11 @@ UniValue capdrpc(const UniValue &params, bool fHelp)
                                  "}\n"
                                  "\ncapd list\n"
                                  "[ \"message id as hex string\", ... ] (json list)\n"
+                                 "\ncapd poll\n"
+                                 "{                           (json object)\n"
+                                 "  \"messages\" : [ ... ] Messages in the format returned by capd get, oldest first\n"
+                                 "  \"dropped\" : Messages lost because the queue was full since the last poll\n"
+                                 "}\n"
                                  "\nExamples:\n" +
                                  HelpExampleCli("capd", "info") + HelpExampleRpc("capd", "info"));
 
@@ -83,9 +113,9 @@ UniValue capdrpc(const UniValue &params, bool fHelp)
     }
 
     std::string cmd = params[0].get_str();
-    if (cmd == "send")
+    if (cmd == "send" || cmd == "solve")
     {
-        if (params.size() != 2)
+        if (params.size() < 2 || params.size() > 4)
         {
             throw std::runtime_error("Incorrect number of parameters, missing data");
         }
@@ -99,10 +129,29 @@ UniValue capdrpc(const UniValue &params, bool fHelp)
         {
             std::copy(s.begin(), s.end(), std::back_inserter(data));
         }
+        int64_t timeout = (params.size() > 2) ? CapdIntParam(params[2]) : 0;
+        PriorityType priority = msgpool.GetRelayPriority();
+        if (params.size() > 3)
+        {
+            priority = params[3].isNum() ? params[3].get_real() : atof(params[3].get_str().c_str());
+            if (!(priority > 0))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Priority must be positive");
+        }
 
         CapdMsgRef msg = std::make_shared<CapdMsg>(data);
-        msg->SetPowTargetHarderThanPriority(msgpool.GetRelayPriority());
-        msg->Solve();
+        msg->SetPowTargetHarderThanPriority(priority);
+        int64_t start = GetTimeMillis();
+        if (!msg->Solve(0, workerPool.Size() + 1, timeout))
+        {
+            throw JSONRPCError(RPC_MISC_ERROR, "Message not solved within the time budget");
+        }
+        if (cmd == "solve")
+        {
+            UniValue ret = CapdMsg2UniValue(msg);
+            ret.pushKV("solveTimeMs", GetTimeMillis() - start);
+            ret.pushKV("hex", msg->EncodeHex());
+            return ret;
+        }
         msgpool.add(msg);
         return msg->GetHash().GetHex();
     }
@@ -137,6 +186,67 @@ UniValue capdrpc(const UniValue &params, bool fHelp)
         msgpool.clear();
         return UniValue();
     }
+    if (cmd == "subscribe")
+    {
+        if (params.size() < 2 || params.size() > 3)
+        {
+            throw std::runtime_error("Incorrect number of parameters, missing prefix");
+        }
+        std::string s = params[1].get_str();
+        if (!IsHex(s) && !s.empty())
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Prefix must be hex");
+        }
+        size_t maxQueue = CapdSubscriptions::DEFAULT_MAX_QUEUE;
+        if (params.size() > 2)
+        {
+            int64_t q = CapdIntParam(params[2]);
+            if (q < 1 || q > CapdSubscriptions::MAX_QUEUE)
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Queue size out of range");
+            maxQueue = q;
+        }
+        try
+        {
+            return msgpool.subscriptions.Subscribe(ParseHex(s), maxQueue);
+        }
+        catch (CapdMsgPoolException &e)
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, e.what());
+        }
+    }
+    if (cmd == "poll")
+    {
+        if (params.size() < 2 || params.size() > 4)
+        {
+            throw std::runtime_error("Incorrect number of parameters, missing subscription id");
+        }
+        uint64_t id = CapdIntParam(params[1]);
+        int64_t timeout = (params.size() > 2) ? CapdIntParam(params[2]) : 0;
+        int64_t maxMsgs = (params.size() > 3) ? CapdIntParam(params[3]) : int64_t(CapdSubscriptions::MAX_QUEUE);
+        if (maxMsgs < 1)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Message count out of range");
+        std::vector<CapdMsgRef> msgs;
+        uint64_t dropped = 0;
+        if (!msgpool.subscriptions.Poll(id, maxMsgs, timeout, msgs, dropped))
+        {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "no such subscription");
+        }
+        UniValue arr(UniValue::VARR);
+        for (const auto &msg : msgs)
+            arr.push_back(CapdMsg2UniValue(msg));
+        UniValue ret(UniValue::VOBJ);
+        ret.pushKV("messages", arr);
+        ret.pushKV("dropped", dropped);
+        return ret;
+    }
+    if (cmd == "unsubscribe")
+    {
+        if (params.size() != 2)
+        {
+            throw std::runtime_error("Incorrect number of parameters, missing subscription id");
+        }
+        return msgpool.subscriptions.Unsubscribe(CapdIntParam(params[1]));
+    }
     throw std::runtime_error("unknown subcommand");
 }
 
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "capd/capdsolver.h"
+
+#include "crypto/sha256.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace
+{
+class CCapdNonceSearch
+{
+public:
+    static const uint64_t NOT_FOUND = std::numeric_limits<uint64_t>::max();
+
+    CCapdNonceSearch(const uint256 &stage1In,
+        const arith_uint256 &targetIn,
+        unsigned int nonceSizeIn,
+        std::chrono::steady_clock::time_point deadlineIn,
+        const std::atomic<bool> *cancelIn)
+        : stage1(stage1In), target(targetIn), nonceSize(nonceSizeIn), count(uint64_t(1) << (8 * nonceSizeIn)),
+          deadline(deadlineIn), cancel(cancelIn)
+    {
+    }
+
+    //! Check batches of nonces until they run out, one at or above the best solution is reached, or the search stops
+    void Run()
+    {
+        const size_t msgLen = stage1.size() + nonceSize;
+        std::vector<unsigned char> messages(msgLen * CAPD_SOLVE_BATCH_SIZE);
+        const unsigned char *inputs[CAPD_SOLVE_BATCH_SIZE];
+        size_t lengths[CAPD_SOLVE_BATCH_SIZE];
+        for (unsigned int i = 0; i < CAPD_SOLVE_BATCH_SIZE; i++)
+        {
+            std::copy(stage1.begin(), stage1.end(), messages.begin() + i * msgLen);
+            inputs[i] = &messages[i * msgLen];
+            lengths[i] = msgLen;
+        }
+        uint256 hashes[CAPD_SOLVE_BATCH_SIZE];
+
+        while (!stopped.load(std::memory_order_relaxed))
+        {
+            const uint64_t start = next.fetch_add(CAPD_SOLVE_BATCH_SIZE);
+            if (start >= count || start >= found.load())
+                break;
+            if ((cancel && cancel->load()) || std::chrono::steady_clock::now() >= deadline)
+            {
+                stopped = true;
+                break;
+            }
+
+            for (unsigned int i = 0; i < CAPD_SOLVE_BATCH_SIZE; i++)
+            {
+                unsigned char *dest = &messages[i * msgLen + stage1.size()];
+                const uint64_t c = start + i;
+                for (unsigned int x = 0; x < nonceSize; x++)
+                    dest[x] = (c >> (x * 8)) & 255;
+            }
+            SHA256DMulti(hashes[0].begin(), inputs, lengths, CAPD_SOLVE_BATCH_SIZE);
+
+            for (unsigned int i = 0; i < CAPD_SOLVE_BATCH_SIZE && start + i < count; i++)
+            {
+                if (target > UintToArith256(hashes[i]))
+                {
+                    // Keep the lowest solution, since another thread may have found a higher one
+                    uint64_t prev = found.load();
+                    while (start + i < prev && !found.compare_exchange_weak(prev, start + i))
+                    {
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    const uint256 &stage1;
+    const arith_uint256 &target;
+    const unsigned int nonceSize;
+    //! The number of nonces of this size
+    const uint64_t count;
+    const std::chrono::steady_clock::time_point deadline;
+    const std::atomic<bool> *cancel;
+
+    std::atomic<uint64_t> next{0};
+    std::atomic<uint64_t> found{NOT_FOUND};
+    std::atomic<bool> stopped{false};
+};
+} // namespace
+
+bool SolveCapdNonce(const uint256 &stage1,
+    const arith_uint256 &target,
+    std::vector<unsigned char> &nonce,
+    unsigned int nThreads,
+    int64_t timeoutMs,
+    const std::atomic<bool> *cancel)
+{
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (timeoutMs > 0)
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    for (unsigned int nonceSize = 1; nonceSize <= CAPD_MAX_NONCE_SIZE; nonceSize++)
+    {
+        CCapdNonceSearch search(stage1, target, nonceSize, deadline, cancel);
+        // Searchers that the pool has no thread for find the nonces already handed out and return at once
+        if (search.count >= CAPD_SOLVE_PARALLEL_MIN)
+            workerPool.Run(std::max(nThreads, 1U), [&search](size_t) { search.Run(); });
+        else
+            search.Run();
+
+        const uint64_t found = search.found.load();
+        if (found != CCapdNonceSearch::NOT_FOUND)
+        {
+            nonce.resize(nonceSize);
+            for (unsigned int x = 0; x < nonceSize; x++)
+                nonce[x] = (found >> (x * 8)) & 255;
+            return true;
+        }
+        if (search.stopped)
+            return false;
+    }
+    return false;
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_CAPD_CAPDSOLVER_H
+#define NEXA_CAPD_CAPDSOLVER_H
+
+#include "arith_uint256.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+//! The longest nonce that the CAPD solver tries, in bytes
+static const unsigned int CAPD_MAX_NONCE_SIZE = 4;
+//! Nonces hashed together in one SHA256DMulti call
+static const unsigned int CAPD_SOLVE_BATCH_SIZE = 32;
+//! Nonce lengths with fewer candidates than this are searched on the calling thread only
+static const uint64_t CAPD_SOLVE_PARALLEL_MIN = 256 * 256;
+
+/** Find a nonce for a CAPD message whose first hashing stage (see CapdMsg::CalcHash) gave stage1, such that the double
+    SHA256 of stage1 followed by the nonce is below target.
+
+    Shorter nonces are tried first.  Within each length the little-endian nonce values are handed out in batches to up
+    to nThreads threads (the caller's and those of the worker pool), and every batch below the best solution found so
+    far is still checked, so the result is the same nonce that a single thread searching in order would find.
+
+    The search gives up and returns false once timeoutMs milliseconds have passed (0 means no limit), or when
+    *cancel becomes true.  A solution already found when that happens is still returned.
+    @return true and sets nonce if a solution is found.
+*/
+bool SolveCapdNonce(const uint256 &stage1,
+    const arith_uint256 &target,
+    std::vector<unsigned char> &nonce,
+    unsigned int nThreads = 1,
+    int64_t timeoutMs = 0,
+    const std::atomic<bool> *cancel = nullptr);
+
+#endif
@@ -13,6 +13,7 @@
 #include "arith_uint256.h"
 #include "base58.h"
 #include "bloom.h"
+#include "capd/capdsolver.h"
 #include "cashaddrenc.h"
 #include "chainparams.h"
 #include "coins.h"
@@ -26,6 +27,7 @@
 #include "uint256.h"
 #include "util.h"
 #include "utilstrencodings.h"
+#include "workerpool.h"
 
 // DER-encoded ECDSA is more like 72 but better to be safe
 // Schnorr is only 64, but this must also include a few extra bytes for the sighashtype
@@ -73,6 +75,7 @@ CRecursiveSharedCriticalSection::~CRecursiveSharedCriticalSection() {}
 
 #include <algorithm>
 #include <string>
+#include <thread>
 #include <vector>
 
 static bool sigInited = false;
@@ -109,6 +112,8 @@ const int CLIENT_VERSION = 0; // 0 because app should report its version, not th
 // Stop the logging.  TODO we can offer an API that lets the app install a log callback function and then call it
 // here so that the app can get our logs and do whatever it wants with them.
 int LogPrintStr(const std::string &str) { return str.size(); }
+// Threads are named by the app, not the library
+void RenameThread(const char *name) {}
 namespace Logging
 {
 std::atomic<uint64_t> categoriesEnabled = 0; // 64 bit log id mask.
@@ -637,6 +642,72 @@ SLAPI int SignHashSchnorr(const unsigned char *hash,
     return sigSize;
 }
 
+/** Start nThreads worker threads that large blocks, signature batches and CAPD nonce searches are spread across.
+    Until they are started all work is done on the calling thread.  Does nothing if they are already running.
+*/
+SLAPI void StartWorkerThreads(unsigned int nThreads) { workerPool.Start(nThreads, "worker"); }
+
+/** Stop the worker threads started by StartWorkerThreads */
+SLAPI void StopWorkerThreads() { workerPool.Stop(); }
+
+/** Verify count signatures of 32 byte hashes, spreading them across up to nThreads of the threads started by
+    StartWorkerThreads and the calling thread (0 picks the number of threads from count).
+    pubkeys holds the serialized public keys back to back and pubkeyLens their sizes.  hashes holds count 32 byte
+    hashes.  sigs holds the signatures back to back and sigLens their sizes.  A 64 byte signature is verified as
+    Schnorr (see SignHashSchnorr) and any other as DER-serialized ECDSA.
+    results must be count bytes.  Each is set to 1 if its signature is valid, and 0 if not.
+    Returns the number of valid signatures.
+*/
+SLAPI int VerifyHashSignatures(unsigned int count,
+    const unsigned char *pubkeys,
+    const unsigned int *pubkeyLens,
+    const unsigned char *hashes,
+    const unsigned char *sigs,
+    const unsigned int *sigLens,
+    unsigned int nThreads,
+    unsigned char *results)
+{
+    checkSigInit();
+    std::vector<CHashSignature> batch(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        batch[i].pubkey.Set(pubkeys, pubkeys + pubkeyLens[i]);
+        batch[i].hash = uint256(hashes + 32 * i);
+        batch[i].sig.assign(sigs, sigs + sigLens[i]);
+        pubkeys += pubkeyLens[i];
+        sigs += sigLens[i];
+    }
+
+    std::vector<unsigned char> valid = VerifySignatures(batch, nThreads);
+    std::copy(valid.begin(), valid.end(), results);
+    return std::count(valid.begin(), valid.end(), 1);
+}
+
+/** Find the proof of work nonce of a CAPD message on up to nThreads threads (0 uses the calling thread and every
+    thread started by StartWorkerThreads), giving up after timeoutMs milliseconds (0 means no limit).
+    stage1 is the 32 byte SHA256 of the message serialized for hashing (see CapdMsg::CalcHash).
+    Returns the nonce size written to nonce, or 0 if no nonce was found in time or nonceLen is too small.
+*/
+SLAPI int SolveCapdMessage(const unsigned char *stage1,
+    uint32_t difficultyBits,
+    unsigned int nThreads,
+    int64_t timeoutMs,
+    unsigned char *nonce,
+    unsigned int nonceLen)
+{
+    if (nonceLen < CAPD_MAX_NONCE_SIZE)
+        return 0;
+    if (nThreads == 0)
+        nThreads = workerPool.Size() + 1;
+    arith_uint256 target;
+    target.SetCompact(difficultyBits);
+    std::vector<unsigned char> result;
+    if (!SolveCapdNonce(uint256(stage1), target, result, nThreads, timeoutMs))
+        return 0;
+    std::copy(result.begin(), result.end(), nonce);
+    return result.size();
+}
+
 #ifndef ANDROID
 /*
 Since the ScriptMachine is often going to be initialized, called and destructed within a single stack frame, it
@@ -76,6 +76,41 @@ SLAPI int SignHashSchnorr(const unsigned char *hash,
     unsigned char *result,
     unsigned int resultLen);
 
+/** Start nThreads worker threads that large blocks, signature batches and CAPD nonce searches are spread across.
+    Until they are started all work is done on the calling thread.
+*/
+SLAPI void StartWorkerThreads(unsigned int nThreads);
+
+/** Stop the worker threads started by StartWorkerThreads */
+SLAPI void StopWorkerThreads();
+
+/** Verify count signatures of 32 byte hashes on up to nThreads threads (0 picks the number of threads).  Only the
+    calling thread is used unless StartWorkerThreads has been called.
+    The public keys and signatures are passed back to back in pubkeys and sigs, with their sizes in pubkeyLens and
+    sigLens, and the hashes back to back in hashes.  64 byte signatures are Schnorr and any others ECDSA.
+    results (count bytes) receives 1 for each valid signature and 0 for each invalid one.
+    Returns the number of valid signatures.
+*/
+SLAPI int VerifyHashSignatures(unsigned int count,
+    const unsigned char *pubkeys,
+    const unsigned int *pubkeyLens,
+    const unsigned char *hashes,
+    const unsigned char *sigs,
+    const unsigned int *sigLens,
+    unsigned int nThreads,
+    unsigned char *results);
+
+/** Find the proof of work nonce of a CAPD message on up to nThreads threads (0 uses the calling thread and every
+    thread started by StartWorkerThreads), giving up after timeoutMs milliseconds (0 means no limit).  stage1 is the 32 byte SHA256 of the message's hash serialization
+    (data, createTime, rescindHash, expiration, difficultyBits) and difficultyBits its target in compact form.
+    Returns the nonce size written to nonce (which must be at least 4 bytes), or 0 if no nonce was found in time.
+*/
+SLAPI int SolveCapdMessage(const unsigned char *stage1,
+    uint32_t difficultyBits,
+    unsigned int nThreads,
+    int64_t timeoutMs,
+    unsigned char *nonce,
+    unsigned int nonceLen);
 
 /** Calculates the sha256 of data, and places it in result.  Result must be 32 bytes */
 SLAPI void sha256(const unsigned char* data, unsigned char len, unsigned char* result);
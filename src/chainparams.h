@@ -37,6 +37,8 @@ static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 1000000;
 static const unsigned int DEFAULT_MEMPOOL_EXPIRY = 72;
 /** Default for -cache.orphanPoolExpiry, expiration time for orphan pool transactions in hours */
 static const unsigned int DEFAULT_ORPHANPOOL_EXPIRY = 4;
+/** Default for -cache.orphanPoolPeerQuota, the percentage of the orphan pool that one peer's orphans may use */
+static const unsigned int DEFAULT_ORPHANPOOL_PEER_QUOTA = 25;
 
 
 struct CDNSSeedData
@@ -16,6 +16,15 @@
 Coin emptyCoin;
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const { return false; }
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const { return false; }
+void CCoinsView::GetCoins(const std::vector<COutPoint> &outpoints,
+    std::vector<Coin> &coins,
+    std::vector<bool> &found) const
+{
+    coins.resize(outpoints.size());
+    found.assign(outpoints.size(), false);
+    for (size_t i = 0; i < outpoints.size(); i++)
+        found[i] = GetCoin(outpoints[i], coins[i]);
+}
 uint256 CCoinsView::_GetBestBlock() const { return uint256(); }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins,
     const uint256 &hashBlock,
@@ -123,6 +132,46 @@ bool CCoinsViewCache::GetCoin(const COutPoint &outpoint, Coin &coin) const
     return false;
 }
 
+void CCoinsViewCache::GetCoins(const std::vector<COutPoint> &outpoints,
+    std::vector<Coin> &coins,
+    std::vector<bool> &found) const
+{
+    coins.resize(outpoints.size());
+    found.assign(outpoints.size(), false);
+
+    READLOCK(cs_utxo);
+    std::vector<COutPoint> vMissing;
+    std::vector<size_t> vMissingIdx;
+    for (size_t i = 0; i < outpoints.size(); i++)
+    {
+        CCoinsMap::const_iterator it = cacheCoins.find(outpoints[i]);
+        if (it == cacheCoins.end())
+        {
+            vMissing.push_back(outpoints[i]);
+            vMissingIdx.push_back(i);
+        }
+        else if (!it->second.coin.IsSpent())
+        {
+            coins[i] = it->second.coin;
+            found[i] = true;
+        }
+    }
+    if (vMissing.empty())
+        return;
+
+    std::vector<Coin> vBaseCoins;
+    std::vector<bool> vBaseFound;
+    base->GetCoins(vMissing, vBaseCoins, vBaseFound);
+    for (size_t i = 0; i < vMissing.size(); i++)
+    {
+        if (vBaseFound[i] && !vBaseCoins[i].IsSpent())
+        {
+            coins[vMissingIdx[i]] = std::move(vBaseCoins[i]);
+            found[vMissingIdx[i]] = true;
+        }
+    }
+}
+
 void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin &&coin, bool possible_overwrite)
 {
     WRITELOCK(cs_utxo);
@@ -172,6 +172,12 @@ public:
     //! This may (but cannot always) return true for spent outputs.
     virtual bool HaveCoin(const COutPoint &outpoint) const;
 
+    //! Retrieve many coins at once.  found[i] is set if coins[i] holds the coin of outpoints[i].  Views backed by a
+    //! database read them in key order, so pass the outpoints sorted.
+    virtual void GetCoins(const std::vector<COutPoint> &outpoints,
+        std::vector<Coin> &coins,
+        std::vector<bool> &found) const;
+
     //! Retrieve the block hash whose state this CCoinsView currently represents
     virtual uint256 _GetBestBlock() const;
     uint256 GetBestBlock() const
@@ -289,6 +295,14 @@ public:
     // Standard CCoinsView methods
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const;
     bool HaveCoin(const COutPoint &outpoint) const;
+    /**
+     * Look up many coins at once.  Unlike GetCoin(), coins that are not in this cache are read from the backing
+     * view in one batch and are not added to the cache, so that bulk lookups do not evict the working set.
+     * The cache is locked for the whole lookup, so keep batches to a bounded size.
+     */
+    void GetCoins(const std::vector<COutPoint> &outpoints,
+        std::vector<Coin> &coins,
+        std::vector<bool> &found) const override;
     uint256 GetBestBlock() const;
     uint256 _GetBestBlock() const;
     void SetBestBlock(const uint256 &hashBlock);
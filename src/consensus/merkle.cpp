@@ -6,6 +6,9 @@
 #include "merkle.h"
 #include "hashwrapper.h"
 #include "utilstrencodings.h"
+#include "workerpool.h"
+
+#include <algorithm>
 
 /*     WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
@@ -163,25 +166,69 @@ static void MerkleComputation(const std::vector<uint256> &leaves,
         *proot = h;
 }
 
-uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated)
+/** The number of threads to hash nPairs pairs of a level with.  nThreads of 0 picks it from the level size. */
+static unsigned int LevelThreads(size_t nPairs, unsigned int nThreads)
+{
+    if (nThreads == 0)
+    {
+        const size_t nCores = workerPool.Size() + 1;
+        nThreads = std::min<size_t>(nCores, std::max<size_t>(nPairs * 2 / MIN_PARALLEL_MERKLE_HASHES_PER_THREAD, 1));
+    }
+    return std::max<size_t>(std::min<size_t>(nThreads, nPairs), 1);
+}
+
+/** Hash nPairs pairs of hashes from in to out, splitting them into nThreads contiguous ranges for the worker pool.
+    out may only be the same as in if nThreads is 1, since a range's output would overwrite another range's input. */
+static void HashPairs(uint256 *out, const uint256 *in, size_t nPairs, unsigned int nThreads)
+{
+    if (nThreads <= 1)
+    {
+        SHA256D64(out->begin(), in->begin(), nPairs);
+        return;
+    }
+    workerPool.Run(nThreads, [&](size_t range) {
+        const size_t begin = nPairs * range / nThreads;
+        const size_t end = nPairs * (range + 1) / nThreads;
+        SHA256D64(out[begin].begin(), in[begin * 2].begin(), end - begin);
+    });
+}
+
+/** True if any two hashes that are paired together are identical */
+static bool HasIdenticalPair(const std::vector<uint256> &hashes)
+{
+    for (size_t pos = 0; pos + 1 < hashes.size(); pos += 2)
+    {
+        if (hashes[pos] == hashes[pos + 1])
+            return true;
+    }
+    return false;
+}
+
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated, unsigned int nThreads)
 {
     bool mutation = false;
+    std::vector<uint256> next;
     while (hashes.size() > 1)
     {
-        if (mutated)
-        {
-            for (size_t pos = 0; pos + 1 < hashes.size(); pos += 2)
-            {
-                if (hashes[pos] == hashes[pos + 1])
-                    mutation = true;
-            }
-        }
+        if (mutated && HasIdenticalPair(hashes))
+            mutation = true;
         if (hashes.size() & 1)
         {
             hashes.push_back(hashes.back());
         }
-        SHA256D64(hashes[0].begin(), hashes[0].begin(), hashes.size() / 2);
-        hashes.resize(hashes.size() / 2);
+        const size_t nPairs = hashes.size() / 2;
+        const unsigned int nLevelThreads = LevelThreads(nPairs, nThreads);
+        if (nLevelThreads <= 1)
+        {
+            SHA256D64(hashes[0].begin(), hashes[0].begin(), nPairs);
+            hashes.resize(nPairs);
+        }
+        else
+        {
+            next.resize(nPairs);
+            HashPairs(next.data(), hashes.data(), nPairs, nLevelThreads);
+            hashes.swap(next);
+        }
     }
     if (mutated)
         *mutated = mutation;
@@ -190,6 +237,41 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated)
     return hashes[0];
 }
 
+CMerkleTree::CMerkleTree(std::vector<uint256> leaves, unsigned int nThreads) : fMutated(false)
+{
+    levels.push_back(std::move(leaves));
+    while (levels.back().size() > 1)
+    {
+        std::vector<uint256> &level = levels.back();
+        fMutated |= HasIdenticalPair(level);
+        // Hash the last pair separately so that odd levels need not be padded
+        const size_t nPairs = level.size() / 2;
+        std::vector<uint256> parent((level.size() + 1) / 2);
+        HashPairs(parent.data(), level.data(), nPairs, LevelThreads(nPairs, nThreads));
+        if (level.size() & 1)
+        {
+            const uint256 &last = level.back();
+            CHash256().Write(last.begin(), 32).Write(last.begin(), 32).Finalize(parent.back().begin());
+        }
+        levels.push_back(std::move(parent));
+    }
+}
+
+std::vector<uint256> CMerkleTree::GetBranch(uint32_t position) const
+{
+    std::vector<uint256> branch;
+    if (position >= GetNumLeaves())
+        return branch;
+    for (size_t height = 0; height + 1 < levels.size(); height++)
+    {
+        const std::vector<uint256> &level = levels[height];
+        // The last node of an odd level is paired with itself
+        branch.push_back(level[std::min<size_t>(position ^ 1, level.size() - 1)]);
+        position >>= 1;
+    }
+    return branch;
+}
+
 std::vector<uint256> ComputeMerkleBranch(const std::vector<uint256> &leaves, uint32_t position)
 {
     std::vector<uint256> ret;
@@ -256,3 +338,14 @@ std::vector<uint256> BlockMerkleBranch(const SatoshiBlock &block, uint32_t posit
     }
     return ComputeMerkleBranch(std::move(leaves), position);
 }
+
+CMerkleTree BlockMerkleTree(const CBlock &block, unsigned int nThreads)
+{
+    std::vector<uint256> leaves;
+    leaves.resize(block.vtx.size());
+    for (size_t s = 0; s < block.vtx.size(); s++)
+    {
+        leaves[s] = block.vtx[s]->GetId();
+    }
+    return CMerkleTree(std::move(leaves), nThreads);
+}
@@ -13,7 +13,15 @@
 #include "primitives/transaction.h"
 #include "uint256.h"
 
-uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated = nullptr);
+//! Tree levels with at least this many hashes per worker thread are hashed on several threads
+static const size_t MIN_PARALLEL_MERKLE_HASHES_PER_THREAD = 16384;
+
+/*
+Compute the merkle root of hashes.  Large levels are split into up to nThreads parts that are hashed on the worker
+pool; 0 picks the number of parts from the size of each level and the number of worker threads.
+*mutated is set to true if two identical hashes were paired at any level.
+*/
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated = nullptr, unsigned int nThreads = 0);
 
 /*
 To compute a merkle path (AKA merkle proof), pass the index of the element being proved into position.
@@ -29,6 +37,36 @@ index specifying where the element was in the array when the merkle proof was cr
 */
 uint256 ComputeMerkleRootFromBranch(const uint256 &leaf, const std::vector<uint256> &branch, uint32_t position);
 
+/*
+ * Every level of a merkle tree, so that any number of branches (or partial merkle trees) can be taken from it in
+ * O(log n) each without hashing the tree again.  The levels are built the same way as ComputeMerkleRoot builds them.
+ */
+class CMerkleTree
+{
+private:
+    //! levels[0] holds the leaves and levels.back() the root.  Levels of odd length are not padded.
+    std::vector<std::vector<uint256> > levels;
+    bool fMutated;
+
+public:
+    explicit CMerkleTree(std::vector<uint256> leaves, unsigned int nThreads = 0);
+
+    size_t GetNumLeaves() const { return levels[0].size(); }
+    //! The number of levels above the leaves
+    int GetHeight() const { return levels.size() - 1; }
+    //! The number of nodes at height (0 being the leaves)
+    size_t GetWidth(int height) const { return levels[height].size(); }
+    //! The hash of node pos at height.  pos must be less than GetWidth(height).
+    const uint256 &GetHash(int height, size_t pos) const { return levels[height][pos]; }
+
+    uint256 GetRoot() const { return levels.back().empty() ? uint256() : levels.back()[0]; }
+    //! True if two identical hashes were paired at any level (see ComputeMerkleRoot)
+    bool IsMutated() const { return fMutated; }
+
+    //! The same branch as ComputeMerkleBranch(leaves, position), or an empty branch if position is not a leaf
+    std::vector<uint256> GetBranch(uint32_t position) const;
+};
+
 /*
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
@@ -44,4 +82,9 @@ uint256 BlockMerkleRoot(const SatoshiBlock &block, bool *mutated = nullptr);
 std::vector<uint256> BlockMerkleBranch(const CBlock &block, uint32_t position);
 std::vector<uint256> BlockMerkleBranch(const SatoshiBlock &block, uint32_t position);
 
+/*
+ * Build the complete merkle tree of the transactions in a block, to take many branches from.
+ */
+CMerkleTree BlockMerkleTree(const CBlock &block, unsigned int nThreads = 0);
+
 #endif // NEXA_CONSENSUS_MERKLE_H
@@ -8,8 +8,19 @@
 
 #include <assert.h>
 #include <string.h>
+#include <algorithm>
 #include <atomic>
 
+#if defined(__linux__) && defined(ENABLE_ARM_SHANI) && !defined(BUILD_BITCOIN_INTERNAL)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#if defined(MAC_OSX) && defined(ENABLE_ARM_SHANI) && !defined(BUILD_BITCOIN_INTERNAL)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+
 #if defined(__x86_64__) || defined(__amd64__)
 #if defined(USE_ASM)
 #include <cpuid.h>
@@ -30,6 +41,28 @@ namespace sha256d64_avx2
 void Transform_8way(unsigned char* out, const unsigned char* in);
 }
 
+namespace sha256_x86_shani
+{
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
+void Transform_2way(uint32_t* sa, uint32_t* sb, const unsigned char* chunka, const unsigned char* chunkb, size_t blocks);
+}
+
+namespace sha256d64_x86_shani
+{
+void Transform_2way(unsigned char* out, const unsigned char* in);
+}
+
+namespace sha256_arm_shani
+{
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
+void Transform_2way(uint32_t* sa, uint32_t* sb, const unsigned char* chunka, const unsigned char* chunkb, size_t blocks);
+}
+
+namespace sha256d64_arm_shani
+{
+void Transform_2way(unsigned char* out, const unsigned char* in);
+}
+
 // Internal implementation code.
 namespace
 {
@@ -407,6 +440,7 @@ void TransformD64(unsigned char* out, const unsigned char* in)
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
 typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+typedef void (*Transform2WayType)(uint32_t*, uint32_t*, const unsigned char*, const unsigned char*, size_t);
 
 template<TransformType tr>
 void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
@@ -447,7 +481,7 @@ void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
     WriteBE32(out + 28, s[7]);
 }
 
-bool SelfTest(TransformType tr) {
+bool SelfTestTransform(TransformType tr) {
     static const unsigned char in1[65] = {0, 0x80};
     static const unsigned char in2[129] = {
         0,
@@ -476,8 +510,53 @@ bool SelfTest(TransformType tr) {
 
 TransformType Transform = sha256::Transform;
 TransformD64Type TransformD64 = sha256::TransformD64;
+TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+//! Runs two independent streams of blocks through the compression function at once
+Transform2WayType Transform_2way = nullptr;
+
+/** Check a multi message TransformD64 kernel against the portable one over 8 unaligned messages */
+bool SelfTestD64(TransformD64Type tr, size_t ways, const unsigned char* in, const unsigned char* expected) {
+    unsigned char out[8 * 32];
+    for (size_t i = 0; i < 8; i += ways) tr(out + 32 * i, in + 64 * i);
+    return memcmp(out, expected, sizeof(out)) == 0;
+}
+
+/**
+ * Check every selected kernel. Transform, and the portable implementation the others are compared with, are checked
+ * against known answers; the double hash and multi-way kernels must then agree with the portable implementation.
+ */
+bool SelfTest() {
+    if (!SelfTestTransform(sha256::Transform) || !SelfTestTransform(Transform)) return false;
+
+    unsigned char data[8 * 64 + 1];
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = (unsigned char)(i * 37 + 11);
+    const unsigned char* in = data + 1; // Intentionally not aligned
+    unsigned char expected[8 * 32];
+    for (size_t i = 0; i < 8; ++i) sha256::TransformD64(expected + 32 * i, in + 64 * i);
+
+    if (!SelfTestD64(TransformD64, 1, in, expected)) return false;
+    if (TransformD64_2way && !SelfTestD64(TransformD64_2way, 2, in, expected)) return false;
+    if (TransformD64_4way && !SelfTestD64(TransformD64_4way, 4, in, expected)) return false;
+    if (TransformD64_8way && !SelfTestD64(TransformD64_8way, 8, in, expected)) return false;
+
+    if (Transform_2way) {
+        // Two streams of 4 blocks each, also checking that processing nothing leaves both states alone
+        uint32_t sa[8], sb[8], ra[8], rb[8];
+        sha256::Initialize(sa);
+        sha256::Initialize(sb);
+        sha256::Initialize(ra);
+        sha256::Initialize(rb);
+        Transform_2way(sa, sb, nullptr, nullptr, 0);
+        if (memcmp(sa, ra, sizeof(sa)) || memcmp(sb, rb, sizeof(sb))) return false;
+        Transform_2way(sa, sb, in, in + 4 * 64, 4);
+        sha256::Transform(ra, in, 4);
+        sha256::Transform(rb, in + 4 * 64, 4);
+        if (memcmp(sa, ra, sizeof(sa)) || memcmp(sb, rb, sizeof(sb))) return false;
+    }
+    return true;
+}
 
 #if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
 // We can't use cpuid.h's __get_cpuid as it does not support subleafs.
@@ -493,6 +572,22 @@ std::string SHA256AutoDetect()
     std::string ret = "standard";
 #if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
     uint32_t eax, ebx, ecx, edx;
+#if defined(ENABLE_SHANI) && !defined(BUILD_BITCOIN_INTERNAL)
+    cpuid(1, 0, eax, ebx, ecx, edx);
+    const bool have_sse41 = (ecx >> 19) & 1;
+    cpuid(7, 0, eax, ebx, ecx, edx);
+    const bool have_x86_shani = (ebx >> 29) & 1;
+    if (have_sse41 && have_x86_shani) {
+        // The SHA extensions beat the SSE4 and AVX2 paths, even the 8 way one, so use them for everything
+        Transform = sha256_x86_shani::Transform;
+        TransformD64 = TransformD64Wrapper<sha256_x86_shani::Transform>;
+        TransformD64_2way = sha256d64_x86_shani::Transform_2way;
+        Transform_2way = sha256_x86_shani::Transform_2way;
+        ret = "x86_shani(1way,2way)";
+        assert(SelfTest());
+        return ret;
+    }
+#endif
     cpuid(1, 0, eax, ebx, ecx, edx);
     if ((ecx >> 19) & 1) {
 #if defined(__x86_64__) || defined(__amd64__)
@@ -515,7 +610,37 @@ std::string SHA256AutoDetect()
     }
 #endif
 
-    assert(SelfTest(Transform));
+#if defined(ENABLE_ARM_SHANI) && !defined(BUILD_BITCOIN_INTERNAL)
+    bool have_arm_shani = false;
+#if defined(__linux__)
+#if defined(__arm__) // 32-bit
+    if (getauxval(AT_HWCAP2) & HWCAP2_SHA2) {
+        have_arm_shani = true;
+    }
+#endif
+#if defined(__aarch64__) // 64-bit
+    if (getauxval(AT_HWCAP) & HWCAP_SHA2) {
+        have_arm_shani = true;
+    }
+#endif
+#endif
+#if defined(MAC_OSX)
+    int val = 0;
+    size_t len = sizeof(val);
+    if (sysctlbyname("hw.optional.arm.FEAT_SHA256", &val, &len, nullptr, 0) == 0) {
+        have_arm_shani = val != 0;
+    }
+#endif
+    if (have_arm_shani) {
+        Transform = sha256_arm_shani::Transform;
+        TransformD64 = TransformD64Wrapper<sha256_arm_shani::Transform>;
+        TransformD64_2way = sha256d64_arm_shani::Transform_2way;
+        Transform_2way = sha256_arm_shani::Transform_2way;
+        ret = "arm_shani(1way,2way)";
+    }
+#endif
+
+    assert(SelfTest());
     return ret;
 }
 
@@ -594,6 +719,14 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
             blocks -= 4;
         }
     }
+    if (TransformD64_2way) {
+        while (blocks >= 2) {
+            TransformD64_2way(out, in);
+            out += 64;
+            in += 128;
+            blocks -= 2;
+        }
+    }
     while (blocks) {
         TransformD64(out, in);
         out += 32;
@@ -601,3 +734,105 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+namespace
+{
+/** The blocks of a padded message: the whole blocks of the input, hashed in place, then one or two tail blocks */
+struct MessageBlocks
+{
+    const unsigned char* in;
+    size_t nFull;
+    size_t nTotal;
+    unsigned char tail[128];
+
+    MessageBlocks(const unsigned char* inIn, size_t len) : in(inIn), nFull(len / 64)
+    {
+        const size_t rem = len % 64;
+        const size_t nTail = rem < 56 ? 1 : 2;
+        nTotal = nFull + nTail;
+        if (rem)
+            memcpy(tail, in + 64 * nFull, rem);
+        memset(tail + rem, 0, 64 * nTail - rem);
+        tail[rem] = 0x80;
+        WriteBE64(tail + 64 * nTail - 8, (uint64_t)len << 3);
+    }
+
+    /** Block k, and in nRun how many blocks from k on are contiguous in memory */
+    const unsigned char* At(size_t k, size_t& nRun) const
+    {
+        if (k < nFull) {
+            nRun = nFull - k;
+            return in + 64 * k;
+        }
+        nRun = nTotal - k;
+        return tail + 64 * (k - nFull);
+    }
+};
+
+void HashBlocks(uint32_t* s, const MessageBlocks& msg, size_t k)
+{
+    while (k < msg.nTotal) {
+        size_t nRun;
+        const unsigned char* p = msg.At(k, nRun);
+        Transform(s, p, nRun);
+        k += nRun;
+    }
+}
+
+/** Serialize the digest in s as the second, single block message of a double hash */
+void PadDigest(const uint32_t* s, unsigned char* block)
+{
+    for (int i = 0; i < 8; ++i) WriteBE32(block + 4 * i, s[i]);
+    memset(block + 32, 0, 32);
+    block[32] = 0x80;
+    WriteBE64(block + 56, 256);
+}
+
+void HashDouble2Way(unsigned char* out, const unsigned char* ina, size_t lena, const unsigned char* inb, size_t lenb)
+{
+    const MessageBlocks a(ina, lena), b(inb, lenb);
+    uint32_t sa[8], sb[8];
+    sha256::Initialize(sa);
+    sha256::Initialize(sb);
+
+    // Hash the blocks both messages have two at a time, then finish the longer one on its own
+    const size_t nCommon = std::min(a.nTotal, b.nTotal);
+    size_t k = 0;
+    while (k < nCommon) {
+        size_t nRunA, nRunB;
+        const unsigned char* pa = a.At(k, nRunA);
+        const unsigned char* pb = b.At(k, nRunB);
+        const size_t nRun = std::min(std::min(nRunA, nRunB), nCommon - k);
+        Transform_2way(sa, sb, pa, pb, nRun);
+        k += nRun;
+    }
+    HashBlocks(sa, a, k);
+    HashBlocks(sb, b, k);
+
+    unsigned char blocka[64], blockb[64];
+    PadDigest(sa, blocka);
+    PadDigest(sb, blockb);
+    sha256::Initialize(sa);
+    sha256::Initialize(sb);
+    Transform_2way(sa, sb, blocka, blockb, 1);
+    for (int i = 0; i < 8; ++i) {
+        WriteBE32(out + 4 * i, sa[i]);
+        WriteBE32(out + 32 + 4 * i, sb[i]);
+    }
+}
+} // namespace
+
+void SHA256DMulti(unsigned char* output, const unsigned char* const* inputs, const size_t* lengths, size_t count)
+{
+    size_t i = 0;
+    if (Transform_2way) {
+        for (; i + 2 <= count; i += 2) {
+            HashDouble2Way(output + 32 * i, inputs[i], lengths[i], inputs[i + 1], lengths[i + 1]);
+        }
+    }
+    for (; i < count; ++i) {
+        unsigned char hash[CSHA256::OUTPUT_SIZE];
+        CSHA256().Write(inputs[i], lengths[i]).Finalize(hash);
+        CSHA256().Write(hash, sizeof(hash)).Finalize(output + 32 * i);
+    }
+}
@@ -40,4 +40,14 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute the double-SHA256's of count independent messages of any length.
+ *  When the CPU can run two hashes side by side (SHA-NI, ARMv8 crypto) the messages are hashed in pairs,
+ *  which is faster than hashing them one after another; otherwise it is the same as hashing each on its own.
+ *  output:  pointer to a count*32 byte output buffer
+ *  inputs:  pointers to the messages
+ *  lengths: the length of each message
+ *  count:   the number of messages
+ */
+void SHA256DMulti(unsigned char* output, const unsigned char* const* inputs, const size_t* lengths, size_t count);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
@@ -0,0 +1,225 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Based on https://github.com/noloader/SHA-Intrinsics/blob/master/sha256-arm.c,
+// Written and placed in public domain by Jeffrey Walton.
+// Based on code from ARM, and by Johannes Schneiders, Skip Hovsmith and
+// Barry O'Rourke for the mbedTLS project.
+
+#ifdef ENABLE_ARM_SHANI
+
+#include <stdint.h>
+#include <stddef.h>
+#include <arm_acle.h>
+#include <arm_neon.h>
+
+namespace {
+
+alignas(uint32x4_t) const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+alignas(uint32x4_t) const uint32_t INIT[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+void inline __attribute__((always_inline)) QuadRound(uint32x4_t& s0, uint32x4_t& s1, uint32x4_t m, int i)
+{
+    const uint32x4_t msg = vaddq_u32(m, vld1q_u32(&K[4 * i]));
+    const uint32x4_t tmp = s0;
+    s0 = vsha256hq_u32(s0, s1, msg);
+    s1 = vsha256h2q_u32(s1, tmp, msg);
+}
+
+/** Compute the next four message words into m0 */
+void inline __attribute__((always_inline)) ShiftMessage(uint32x4_t& m0, uint32x4_t m1, uint32x4_t m2, uint32x4_t m3)
+{
+    m0 = vsha256su1q_u32(vsha256su0q_u32(m0, m1), m2, m3);
+}
+
+/** Run the compression function on one block, whose message words are in m0..m3 */
+void inline __attribute__((always_inline)) Compress(uint32x4_t& s0, uint32x4_t& s1, uint32x4_t m0, uint32x4_t m1, uint32x4_t m2, uint32x4_t m3)
+{
+    const uint32x4_t so0 = s0, so1 = s1;
+    QuadRound(s0, s1, m0, 0);
+    ShiftMessage(m0, m1, m2, m3);
+    QuadRound(s0, s1, m1, 1);
+    ShiftMessage(m1, m2, m3, m0);
+    QuadRound(s0, s1, m2, 2);
+    ShiftMessage(m2, m3, m0, m1);
+    QuadRound(s0, s1, m3, 3);
+    ShiftMessage(m3, m0, m1, m2);
+    QuadRound(s0, s1, m0, 4);
+    ShiftMessage(m0, m1, m2, m3);
+    QuadRound(s0, s1, m1, 5);
+    ShiftMessage(m1, m2, m3, m0);
+    QuadRound(s0, s1, m2, 6);
+    ShiftMessage(m2, m3, m0, m1);
+    QuadRound(s0, s1, m3, 7);
+    ShiftMessage(m3, m0, m1, m2);
+    QuadRound(s0, s1, m0, 8);
+    ShiftMessage(m0, m1, m2, m3);
+    QuadRound(s0, s1, m1, 9);
+    ShiftMessage(m1, m2, m3, m0);
+    QuadRound(s0, s1, m2, 10);
+    ShiftMessage(m2, m3, m0, m1);
+    QuadRound(s0, s1, m3, 11);
+    ShiftMessage(m3, m0, m1, m2);
+    QuadRound(s0, s1, m0, 12);
+    QuadRound(s0, s1, m1, 13);
+    QuadRound(s0, s1, m2, 14);
+    QuadRound(s0, s1, m3, 15);
+    s0 = vaddq_u32(s0, so0);
+    s1 = vaddq_u32(s1, so1);
+}
+
+/**
+ * Run the compression function on two independent blocks at once. Interleaving the rounds of the two keeps the SHA
+ * units busy while each waits on the result of its previous round.
+ */
+void inline __attribute__((always_inline)) Compress_2way(uint32x4_t& as0, uint32x4_t& as1, uint32x4_t am0, uint32x4_t am1, uint32x4_t am2, uint32x4_t am3,
+    uint32x4_t& bs0, uint32x4_t& bs1, uint32x4_t bm0, uint32x4_t bm1, uint32x4_t bm2, uint32x4_t bm3)
+{
+    const uint32x4_t aso0 = as0, aso1 = as1, bso0 = bs0, bso1 = bs1;
+    QuadRound(as0, as1, am0, 0);
+    ShiftMessage(am0, am1, am2, am3);
+    QuadRound(bs0, bs1, bm0, 0);
+    ShiftMessage(bm0, bm1, bm2, bm3);
+    QuadRound(as0, as1, am1, 1);
+    ShiftMessage(am1, am2, am3, am0);
+    QuadRound(bs0, bs1, bm1, 1);
+    ShiftMessage(bm1, bm2, bm3, bm0);
+    QuadRound(as0, as1, am2, 2);
+    ShiftMessage(am2, am3, am0, am1);
+    QuadRound(bs0, bs1, bm2, 2);
+    ShiftMessage(bm2, bm3, bm0, bm1);
+    QuadRound(as0, as1, am3, 3);
+    ShiftMessage(am3, am0, am1, am2);
+    QuadRound(bs0, bs1, bm3, 3);
+    ShiftMessage(bm3, bm0, bm1, bm2);
+    QuadRound(as0, as1, am0, 4);
+    ShiftMessage(am0, am1, am2, am3);
+    QuadRound(bs0, bs1, bm0, 4);
+    ShiftMessage(bm0, bm1, bm2, bm3);
+    QuadRound(as0, as1, am1, 5);
+    ShiftMessage(am1, am2, am3, am0);
+    QuadRound(bs0, bs1, bm1, 5);
+    ShiftMessage(bm1, bm2, bm3, bm0);
+    QuadRound(as0, as1, am2, 6);
+    ShiftMessage(am2, am3, am0, am1);
+    QuadRound(bs0, bs1, bm2, 6);
+    ShiftMessage(bm2, bm3, bm0, bm1);
+    QuadRound(as0, as1, am3, 7);
+    ShiftMessage(am3, am0, am1, am2);
+    QuadRound(bs0, bs1, bm3, 7);
+    ShiftMessage(bm3, bm0, bm1, bm2);
+    QuadRound(as0, as1, am0, 8);
+    ShiftMessage(am0, am1, am2, am3);
+    QuadRound(bs0, bs1, bm0, 8);
+    ShiftMessage(bm0, bm1, bm2, bm3);
+    QuadRound(as0, as1, am1, 9);
+    ShiftMessage(am1, am2, am3, am0);
+    QuadRound(bs0, bs1, bm1, 9);
+    ShiftMessage(bm1, bm2, bm3, bm0);
+    QuadRound(as0, as1, am2, 10);
+    ShiftMessage(am2, am3, am0, am1);
+    QuadRound(bs0, bs1, bm2, 10);
+    ShiftMessage(bm2, bm3, bm0, bm1);
+    QuadRound(as0, as1, am3, 11);
+    ShiftMessage(am3, am0, am1, am2);
+    QuadRound(bs0, bs1, bm3, 11);
+    ShiftMessage(bm3, bm0, bm1, bm2);
+    QuadRound(as0, as1, am0, 12);
+    QuadRound(bs0, bs1, bm0, 12);
+    QuadRound(as0, as1, am1, 13);
+    QuadRound(bs0, bs1, bm1, 13);
+    QuadRound(as0, as1, am2, 14);
+    QuadRound(bs0, bs1, bm2, 14);
+    QuadRound(as0, as1, am3, 15);
+    QuadRound(bs0, bs1, bm3, 15);
+    as0 = vaddq_u32(as0, aso0);
+    as1 = vaddq_u32(as1, aso1);
+    bs0 = vaddq_u32(bs0, bso0);
+    bs1 = vaddq_u32(bs1, bso1);
+}
+
+uint32x4_t inline __attribute__((always_inline)) Load(const unsigned char* in)
+{
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in)));
+}
+
+void inline __attribute__((always_inline)) Save(unsigned char* out, uint32x4_t s)
+{
+    vst1q_u8(out, vrev32q_u8(vreinterpretq_u8_u32(s)));
+}
+
+}
+
+namespace sha256_arm_shani {
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
+{
+    uint32x4_t s0 = vld1q_u32(&s[0]);
+    uint32x4_t s1 = vld1q_u32(&s[4]);
+    while (blocks--) {
+        Compress(s0, s1, Load(chunk), Load(chunk + 16), Load(chunk + 32), Load(chunk + 48));
+        chunk += 64;
+    }
+    vst1q_u32(&s[0], s0);
+    vst1q_u32(&s[4], s1);
+}
+
+void Transform_2way(uint32_t* sa, uint32_t* sb, const unsigned char* chunka, const unsigned char* chunkb, size_t blocks)
+{
+    uint32x4_t as0 = vld1q_u32(&sa[0]), as1 = vld1q_u32(&sa[4]);
+    uint32x4_t bs0 = vld1q_u32(&sb[0]), bs1 = vld1q_u32(&sb[4]);
+    while (blocks--) {
+        Compress_2way(as0, as1, Load(chunka), Load(chunka + 16), Load(chunka + 32), Load(chunka + 48),
+            bs0, bs1, Load(chunkb), Load(chunkb + 16), Load(chunkb + 32), Load(chunkb + 48));
+        chunka += 64;
+        chunkb += 64;
+    }
+    vst1q_u32(&sa[0], as0);
+    vst1q_u32(&sa[4], as1);
+    vst1q_u32(&sb[0], bs0);
+    vst1q_u32(&sb[4], bs1);
+}
+}
+
+namespace sha256d64_arm_shani {
+void Transform_2way(unsigned char* out, const unsigned char* in)
+{
+    alignas(uint32x4_t) static const uint32_t PAD0[4] = {0x80000000, 0, 0, 0};
+    alignas(uint32x4_t) static const uint32_t LEN512[4] = {0, 0, 0, 0x200};
+    alignas(uint32x4_t) static const uint32_t LEN256[4] = {0, 0, 0, 0x100};
+    const uint32x4_t zero = vdupq_n_u32(0), pad0 = vld1q_u32(PAD0);
+
+    // First hash: the 64 byte input, then a padding block for 512 bits
+    uint32x4_t as0 = vld1q_u32(&INIT[0]), as1 = vld1q_u32(&INIT[4]);
+    uint32x4_t bs0 = as0, bs1 = as1;
+    Compress_2way(as0, as1, Load(in), Load(in + 16), Load(in + 32), Load(in + 48),
+        bs0, bs1, Load(in + 64), Load(in + 80), Load(in + 96), Load(in + 112));
+    const uint32x4_t len512 = vld1q_u32(LEN512);
+    Compress_2way(as0, as1, pad0, zero, zero, len512, bs0, bs1, pad0, zero, zero, len512);
+
+    // Second hash: the 32 byte digest, whose words are the message words, followed by the padding for 256 bits
+    const uint32x4_t am0 = as0, am1 = as1, bm0 = bs0, bm1 = bs1;
+    as0 = bs0 = vld1q_u32(&INIT[0]);
+    as1 = bs1 = vld1q_u32(&INIT[4]);
+    const uint32x4_t len256 = vld1q_u32(LEN256);
+    Compress_2way(as0, as1, am0, am1, pad0, len256, bs0, bs1, bm0, bm1, pad0, len256);
+
+    Save(out, as0);
+    Save(out + 16, as1);
+    Save(out + 32, bs0);
+    Save(out + 48, bs1);
+}
+}
+
+#endif
@@ -0,0 +1,274 @@
+// Copyright (c) 2018-2019 The Bitcoin Core developers
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// Based on https://github.com/noloader/SHA-Intrinsics/blob/master/sha256-x86.c,
+// Written and placed in public domain by Jeffrey Walton.
+// Based on code from Intel, and by Sean Gulley for the miTLS project.
+
+#ifdef ENABLE_SHANI
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace {
+
+alignas(__m128i) const uint8_t MASK[16] = {0x03, 0x02, 0x01, 0x00, 0x07, 0x06, 0x05, 0x04, 0x0b, 0x0a, 0x09, 0x08, 0x0f, 0x0e, 0x0d, 0x0c};
+
+const uint32_t INIT[8] = {0x6a09e667ul, 0xbb67ae85ul, 0x3c6ef372ul, 0xa54ff53aul, 0x510e527ful, 0x9b05688cul, 0x1f83d9abul, 0x5be0cd19ul};
+
+/** The round constants, two per 64 bit word, four per quad round */
+const uint64_t K[32] = {
+    0x71374491428a2f98ull, 0xe9b5dba5b5c0fbcfull, 0x59f111f13956c25bull, 0xab1c5ed5923f82a4ull,
+    0x12835b01d807aa98ull, 0x550c7dc3243185beull, 0x80deb1fe72be5d74ull, 0xc19bf1749bdc06a7ull,
+    0xefbe4786e49b69c1ull, 0x240ca1cc0fc19dc6ull, 0x4a7484aa2de92c6full, 0x76f988da5cb0a9dcull,
+    0xa831c66d983e5152ull, 0xbf597fc7b00327c8ull, 0xd5a79147c6e00bf3ull, 0x1429296706ca6351ull,
+    0x2e1b213827b70a85ull, 0x53380d134d2c6dfcull, 0x766a0abb650a7354ull, 0x92722c8581c2c92eull,
+    0xa81a664ba2bfe8a1ull, 0xc76c51a3c24b8b70ull, 0xd6990624d192e819ull, 0x106aa070f40e3585ull,
+    0x1e376c0819a4c116ull, 0x34b0bcb52748774cull, 0x4ed8aa4a391c0cb3ull, 0x682e6ff35b9cca4full,
+    0x78a5636f748f82eeull, 0x8cc7020884c87814ull, 0xa4506ceb90befffaull, 0xc67178f2bef9a3f7ull};
+
+void inline __attribute__((always_inline)) QuadRound(__m128i& state0, __m128i& state1, __m128i m, int i)
+{
+    const __m128i msg = _mm_add_epi32(m, _mm_set_epi64x(K[2 * i + 1], K[2 * i]));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+}
+
+void inline __attribute__((always_inline)) ShiftMessageA(__m128i& m0, __m128i m1)
+{
+    m0 = _mm_sha256msg1_epu32(m0, m1);
+}
+
+void inline __attribute__((always_inline)) ShiftMessageC(__m128i& m0, __m128i m1, __m128i& m2)
+{
+    m2 = _mm_sha256msg2_epu32(_mm_add_epi32(m2, _mm_alignr_epi8(m1, m0, 4)), m1);
+}
+
+void inline __attribute__((always_inline)) ShiftMessageB(__m128i& m0, __m128i m1, __m128i& m2)
+{
+    ShiftMessageC(m0, m1, m2);
+    ShiftMessageA(m0, m1);
+}
+
+/** Convert the state from ABCD/EFGH order to the ABEF/CDGH order the instructions work on */
+void inline __attribute__((always_inline)) Shuffle(__m128i& s0, __m128i& s1)
+{
+    const __m128i t1 = _mm_shuffle_epi32(s0, 0xB1);
+    const __m128i t2 = _mm_shuffle_epi32(s1, 0x1B);
+    s0 = _mm_alignr_epi8(t1, t2, 0x08);
+    s1 = _mm_blend_epi16(t2, t1, 0xF0);
+}
+
+void inline __attribute__((always_inline)) Unshuffle(__m128i& s0, __m128i& s1)
+{
+    const __m128i t1 = _mm_shuffle_epi32(s0, 0x1B);
+    const __m128i t2 = _mm_shuffle_epi32(s1, 0xB1);
+    s0 = _mm_blend_epi16(t1, t2, 0xF0);
+    s1 = _mm_alignr_epi8(t2, t1, 0x08);
+}
+
+__m128i inline __attribute__((always_inline)) Load(const unsigned char* in)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)in), _mm_load_si128((const __m128i*)MASK));
+}
+
+void inline __attribute__((always_inline)) Save(unsigned char* out, __m128i s)
+{
+    _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(s, _mm_load_si128((const __m128i*)MASK)));
+}
+
+/** Run the compression function on one block, whose message words are in m0..m3 */
+void inline __attribute__((always_inline)) Compress(__m128i& s0, __m128i& s1, __m128i m0, __m128i m1, __m128i m2, __m128i m3)
+{
+    const __m128i so0 = s0, so1 = s1;
+    QuadRound(s0, s1, m0, 0);
+    QuadRound(s0, s1, m1, 1);
+    ShiftMessageA(m0, m1);
+    QuadRound(s0, s1, m2, 2);
+    ShiftMessageA(m1, m2);
+    QuadRound(s0, s1, m3, 3);
+    ShiftMessageB(m2, m3, m0);
+    QuadRound(s0, s1, m0, 4);
+    ShiftMessageB(m3, m0, m1);
+    QuadRound(s0, s1, m1, 5);
+    ShiftMessageB(m0, m1, m2);
+    QuadRound(s0, s1, m2, 6);
+    ShiftMessageB(m1, m2, m3);
+    QuadRound(s0, s1, m3, 7);
+    ShiftMessageB(m2, m3, m0);
+    QuadRound(s0, s1, m0, 8);
+    ShiftMessageB(m3, m0, m1);
+    QuadRound(s0, s1, m1, 9);
+    ShiftMessageB(m0, m1, m2);
+    QuadRound(s0, s1, m2, 10);
+    ShiftMessageB(m1, m2, m3);
+    QuadRound(s0, s1, m3, 11);
+    ShiftMessageB(m2, m3, m0);
+    QuadRound(s0, s1, m0, 12);
+    ShiftMessageB(m3, m0, m1);
+    QuadRound(s0, s1, m1, 13);
+    ShiftMessageC(m0, m1, m2);
+    QuadRound(s0, s1, m2, 14);
+    ShiftMessageC(m1, m2, m3);
+    QuadRound(s0, s1, m3, 15);
+    s0 = _mm_add_epi32(s0, so0);
+    s1 = _mm_add_epi32(s1, so1);
+}
+
+/**
+ * Run the compression function on two independent blocks at once. Interleaving the rounds of the two keeps the SHA
+ * units busy while each waits on the result of its previous round.
+ */
+void inline __attribute__((always_inline)) Compress_2way(__m128i& as0, __m128i& as1, __m128i am0, __m128i am1, __m128i am2, __m128i am3,
+    __m128i& bs0, __m128i& bs1, __m128i bm0, __m128i bm1, __m128i bm2, __m128i bm3)
+{
+    const __m128i aso0 = as0, aso1 = as1, bso0 = bs0, bso1 = bs1;
+    QuadRound(as0, as1, am0, 0);
+    QuadRound(bs0, bs1, bm0, 0);
+    QuadRound(as0, as1, am1, 1);
+    ShiftMessageA(am0, am1);
+    QuadRound(bs0, bs1, bm1, 1);
+    ShiftMessageA(bm0, bm1);
+    QuadRound(as0, as1, am2, 2);
+    ShiftMessageA(am1, am2);
+    QuadRound(bs0, bs1, bm2, 2);
+    ShiftMessageA(bm1, bm2);
+    QuadRound(as0, as1, am3, 3);
+    ShiftMessageB(am2, am3, am0);
+    QuadRound(bs0, bs1, bm3, 3);
+    ShiftMessageB(bm2, bm3, bm0);
+    QuadRound(as0, as1, am0, 4);
+    ShiftMessageB(am3, am0, am1);
+    QuadRound(bs0, bs1, bm0, 4);
+    ShiftMessageB(bm3, bm0, bm1);
+    QuadRound(as0, as1, am1, 5);
+    ShiftMessageB(am0, am1, am2);
+    QuadRound(bs0, bs1, bm1, 5);
+    ShiftMessageB(bm0, bm1, bm2);
+    QuadRound(as0, as1, am2, 6);
+    ShiftMessageB(am1, am2, am3);
+    QuadRound(bs0, bs1, bm2, 6);
+    ShiftMessageB(bm1, bm2, bm3);
+    QuadRound(as0, as1, am3, 7);
+    ShiftMessageB(am2, am3, am0);
+    QuadRound(bs0, bs1, bm3, 7);
+    ShiftMessageB(bm2, bm3, bm0);
+    QuadRound(as0, as1, am0, 8);
+    ShiftMessageB(am3, am0, am1);
+    QuadRound(bs0, bs1, bm0, 8);
+    ShiftMessageB(bm3, bm0, bm1);
+    QuadRound(as0, as1, am1, 9);
+    ShiftMessageB(am0, am1, am2);
+    QuadRound(bs0, bs1, bm1, 9);
+    ShiftMessageB(bm0, bm1, bm2);
+    QuadRound(as0, as1, am2, 10);
+    ShiftMessageB(am1, am2, am3);
+    QuadRound(bs0, bs1, bm2, 10);
+    ShiftMessageB(bm1, bm2, bm3);
+    QuadRound(as0, as1, am3, 11);
+    ShiftMessageB(am2, am3, am0);
+    QuadRound(bs0, bs1, bm3, 11);
+    ShiftMessageB(bm2, bm3, bm0);
+    QuadRound(as0, as1, am0, 12);
+    ShiftMessageB(am3, am0, am1);
+    QuadRound(bs0, bs1, bm0, 12);
+    ShiftMessageB(bm3, bm0, bm1);
+    QuadRound(as0, as1, am1, 13);
+    ShiftMessageC(am0, am1, am2);
+    QuadRound(bs0, bs1, bm1, 13);
+    ShiftMessageC(bm0, bm1, bm2);
+    QuadRound(as0, as1, am2, 14);
+    ShiftMessageC(am1, am2, am3);
+    QuadRound(bs0, bs1, bm2, 14);
+    ShiftMessageC(bm1, bm2, bm3);
+    QuadRound(as0, as1, am3, 15);
+    QuadRound(bs0, bs1, bm3, 15);
+    as0 = _mm_add_epi32(as0, aso0);
+    as1 = _mm_add_epi32(as1, aso1);
+    bs0 = _mm_add_epi32(bs0, bso0);
+    bs1 = _mm_add_epi32(bs1, bso1);
+}
+
+void inline __attribute__((always_inline)) LoadState(const uint32_t* s, __m128i& s0, __m128i& s1)
+{
+    s0 = _mm_loadu_si128((const __m128i*)s);
+    s1 = _mm_loadu_si128((const __m128i*)(s + 4));
+    Shuffle(s0, s1);
+}
+
+void inline __attribute__((always_inline)) StoreState(uint32_t* s, __m128i s0, __m128i s1)
+{
+    Unshuffle(s0, s1);
+    _mm_storeu_si128((__m128i*)s, s0);
+    _mm_storeu_si128((__m128i*)(s + 4), s1);
+}
+
+}
+
+namespace sha256_x86_shani {
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
+{
+    __m128i s0, s1;
+    LoadState(s, s0, s1);
+    while (blocks--) {
+        Compress(s0, s1, Load(chunk), Load(chunk + 16), Load(chunk + 32), Load(chunk + 48));
+        chunk += 64;
+    }
+    StoreState(s, s0, s1);
+}
+
+void Transform_2way(uint32_t* sa, uint32_t* sb, const unsigned char* chunka, const unsigned char* chunkb, size_t blocks)
+{
+    __m128i as0, as1, bs0, bs1;
+    LoadState(sa, as0, as1);
+    LoadState(sb, bs0, bs1);
+    while (blocks--) {
+        Compress_2way(as0, as1, Load(chunka), Load(chunka + 16), Load(chunka + 32), Load(chunka + 48),
+            bs0, bs1, Load(chunkb), Load(chunkb + 16), Load(chunkb + 32), Load(chunkb + 48));
+        chunka += 64;
+        chunkb += 64;
+    }
+    StoreState(sa, as0, as1);
+    StoreState(sb, bs0, bs1);
+}
+}
+
+namespace sha256d64_x86_shani {
+void Transform_2way(unsigned char* out, const unsigned char* in)
+{
+    __m128i as0, as1, bs0, bs1;
+    const __m128i zero = _mm_setzero_si128();
+
+    // First hash: the 64 byte input, then a padding block for 512 bits
+    LoadState(INIT, as0, as1);
+    LoadState(INIT, bs0, bs1);
+    Compress_2way(as0, as1, Load(in), Load(in + 16), Load(in + 32), Load(in + 48),
+        bs0, bs1, Load(in + 64), Load(in + 80), Load(in + 96), Load(in + 112));
+    const __m128i pad0 = _mm_set_epi32(0, 0, 0, 0x80000000);
+    const __m128i pad3 = _mm_set_epi32(0x200, 0, 0, 0);
+    Compress_2way(as0, as1, pad0, zero, zero, pad3, bs0, bs1, pad0, zero, zero, pad3);
+
+    // Second hash: the 32 byte digest, whose words are the message words, followed by the padding for 256 bits
+    Unshuffle(as0, as1);
+    Unshuffle(bs0, bs1);
+    const __m128i am0 = as0, am1 = as1, bm0 = bs0, bm1 = bs1;
+    LoadState(INIT, as0, as1);
+    LoadState(INIT, bs0, bs1);
+    const __m128i pad2 = _mm_set_epi32(0, 0, 0, 0x80000000);
+    const __m128i len3 = _mm_set_epi32(0x100, 0, 0, 0);
+    Compress_2way(as0, as1, am0, am1, pad2, len3, bs0, bs1, bm0, bm1, pad2, len3);
+
+    Unshuffle(as0, as1);
+    Unshuffle(bs0, bs1);
+    Save(out, as0);
+    Save(out + 16, as1);
+    Save(out + 32, bs0);
+    Save(out + 48, bs1);
+}
+}
+
+#endif
@@ -8,6 +8,7 @@
 // Independent global variables may be placed here for organizational
 // purposes.
 
+#include "DoubleSpendProof.h"
 #include "addrman.h"
 #include "blockrelay/blockrelay_common.h"
 #include "blockrelay/compactblock.h"
@@ -15,6 +16,7 @@
 #include "blockrelay/mempool_sync.h"
 #include "blockrelay/thinblock.h"
 #include "blockstorage/blockcache.h"
+#include "blockstorage/blockfilewriter.h"
 #include "capd/capd.h"
 #include "chain.h"
 #include "chainparams.h"
@@ -211,6 +213,7 @@ boost::asio::io_service stat_io_service;
 CBlockCache blockcache;
 CTxMemPool mempool;
 CTxOrphanPool orphanpool;
+CDoubleSpendProofVerifier dspVerifier;
 
 std::list<CStatBase *> mallocedStats;
 CStatMap statistics;
@@ -617,6 +620,12 @@ CTweak<uint32_t> orphanPoolExpiry("cache.orphanPoolExpiry",
         DEFAULT_ORPHANPOOL_EXPIRY),
     DEFAULT_ORPHANPOOL_EXPIRY);
 
+/** How much of the orphan pool, in percent, the orphans from one peer may use */
+CTweak<uint32_t> orphanPoolPeerQuota("cache.orphanPoolPeerQuota",
+    strprintf("Evict a peer's oldest orphans once they use more than <n> percent of the orphan pool (default: %u)",
+        DEFAULT_ORPHANPOOL_PEER_QUOTA),
+    DEFAULT_ORPHANPOOL_PEER_QUOTA);
+
 /** Are we going to save the mempool and orphanpool to disk on shutdown and load them on restart */
 CTweak<bool> persistTxPool("cache.persistTxPool",
     strprintf("Whether to save the mempool and orphanpool on shutdown and load them on restart (default: %u)",
@@ -705,6 +714,8 @@ CStatHistory<uint64_t> sendAmt;
 CStatHistory<uint64_t> nTxValidationTime("txValidationTime", STAT_OP_MAX | STAT_INDIVIDUAL);
 CCriticalSection cs_blockvalidationtime;
 CStatHistory<uint64_t> nBlockValidationTime("blockValidationTime", STAT_OP_MAX | STAT_INDIVIDUAL);
+CStatHistory<uint64_t> blockWriteQueueDepth("blockWriter/queueDepth", STAT_OP_MAX);
+CStatHistory<uint64_t> blockFileSyncs("blockWriter/fsyncs", STAT_OP_SUM);
 
 // Single classes for gather thin type block relay statistics
 CThinBlockData thindata;
@@ -9,12 +9,14 @@
 #include "crypto/hmac_sha256.h"
 #include "httpserver.h"
 #include "random.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h"
 #include "rpc/server.h"
 #include "sync.h"
 #include "ui_interface.h"
 #include "util.h"
 #include "utilstrencodings.h"
+#include <map>
 #include <stdio.h>
 
 #include <boost/algorithm/string.hpp> // boost::trim
@@ -22,6 +24,12 @@
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char *WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** RPC methods that can take long enough to hold up other calls, run on the heavy work queue by default */
+static const char *DEFAULT_HEAVY_RPC_METHODS[] = {"getblock", "getblockstats", "gettxoutsetinfo", "scantokens",
+    "listtokenutxos", "gettokensupply", "getaddresshistory", "getaddressutxos", "getrawtxpool", "getraworphanpool",
+    "getrawtransactionssince", "gettxoutproofs", "verifychain", "verifysignatures", "rollbackchain", "savetxpool",
+    "saveorphanpool", "generate", "generatetoaddress", "importwallet", "dumpwallet"};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wellet.
  */
@@ -60,6 +68,8 @@ private:
 static std::string strRPCUserColonPass;
 /* Stored RPC timer interface (for unregistration) */
 static HTTPRPCTimerInterface *httpRPCTimerInterface = nullptr;
+/* The work queue of every RPC method that does not run on the fast queue */
+static std::map<std::string, HTTPWorkClass> mapRPCWorkClass;
 
 static void JSONErrorReply(HTTPRequest *req, const UniValue &objError, const UniValue &id)
 {
@@ -150,6 +160,22 @@ static bool RPCAuthorized(const std::string &strAuth)
     return multiUserAuthorized(strUserPass);
 }
 
+/** Send a JSON-RPC reply whose result is written by a streaming RPC method */
+static void StreamJSONRPCReply(HTTPRequest *req, const RPCStreamResult &streamResult, const UniValue &id)
+{
+    StreamJSONReply(req,
+        [&streamResult, &id](JSONStreamWriter &out)
+        {
+            out.BeginObject();
+            out.Key("result");
+            streamResult(out);
+            out.Key("error");
+            out.Null();
+            out.KV("id", id);
+            out.EndObject();
+        });
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest *req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -195,6 +221,14 @@ static bool HTTPReq_JSONRPC(HTTPRequest *req, const std::string &)
         {
             jreq.parse(valRequest);
 
+            // Large results are written straight to the client as they are produced
+            RPCStreamResult streamResult = tableRPC.executeStreamed(jreq.strMethod, jreq.params);
+            if (streamResult)
+            {
+                StreamJSONRPCReply(req, streamResult, jreq.id);
+                return true;
+            }
+
             UniValue result = tableRPC.execute(jreq.strMethod, jreq.params);
 
             // Send reply
@@ -223,6 +257,76 @@ static bool HTTPReq_JSONRPC(HTTPRequest *req, const std::string &)
     return true;
 }
 
+/** The RPC calls that wait for events, by method and subcommand (the first parameter) */
+static const std::pair<const char *, const char *> RPC_LONG_POLLS[] = {{"capd", "poll"}};
+
+static HTTPWorkClass RPCMethodWorkClass(const UniValue &request)
+{
+    if (!request.isObject())
+        return HTTP_WORK_FAST;
+    const UniValue &method = find_value(request.get_obj(), "method");
+    if (!method.isStr())
+        return HTTP_WORK_FAST;
+    const UniValue &params = find_value(request.get_obj(), "params");
+    if (params.isArray() && params.size() > 0 && params[0].isStr())
+    {
+        for (const auto &poll : RPC_LONG_POLLS)
+        {
+            if (method.get_str() == poll.first && params[0].get_str() == poll.second)
+                return HTTP_WORK_POLL;
+        }
+    }
+    auto iter = mapRPCWorkClass.find(method.get_str());
+    return iter == mapRPCWorkClass.end() ? HTTP_WORK_FAST : iter->second;
+}
+
+HTTPWorkClass ClassifyJSONRPCBody(const std::string &body)
+{
+    if (body.size() > MAX_CLASSIFY_BODY_SIZE)
+        return HTTP_WORK_HEAVY;
+
+    UniValue valRequest;
+    if (!valRequest.read(body))
+        return HTTP_WORK_FAST;
+    if (!valRequest.isArray())
+        return RPCMethodWorkClass(valRequest);
+
+    HTTPWorkClass workClass = HTTP_WORK_FAST;
+    for (size_t i = 0; i < valRequest.size(); i++)
+    {
+        HTTPWorkClass callClass = RPCMethodWorkClass(valRequest[i]);
+        if (callClass == HTTP_WORK_POLL)
+            return callClass;
+        if (callClass == HTTP_WORK_REST || (callClass == HTTP_WORK_HEAVY && workClass == HTTP_WORK_FAST))
+            workClass = callClass;
+    }
+    return workClass;
+}
+
+static HTTPWorkClass ClassifyJSONRPC(HTTPRequest *req, const std::string &)
+{
+    return ClassifyJSONRPCBody(req->PeekBody(MAX_CLASSIFY_BODY_SIZE + 1));
+}
+
+void InitRPCWorkClasses()
+{
+    mapRPCWorkClass.clear();
+    for (const char *method : DEFAULT_HEAVY_RPC_METHODS)
+        mapRPCWorkClass[method] = HTTP_WORK_HEAVY;
+    // capd calls share the queue of the CAPD HTTP interface; its polls have a queue of their own
+    mapRPCWorkClass["capd"] = HTTP_WORK_REST;
+    if (mapMultiArgs.count("-rpcheavymethod"))
+    {
+        for (const std::string &method : mapMultiArgs["-rpcheavymethod"])
+            mapRPCWorkClass[method] = HTTP_WORK_HEAVY;
+    }
+    if (mapMultiArgs.count("-rpcfastmethod"))
+    {
+        for (const std::string &method : mapMultiArgs["-rpcfastmethod"])
+            mapRPCWorkClass.erase(method);
+    }
+}
+
 static bool InitRPCAuthentication()
 {
     if (mapArgs["-rpcpassword"] == "")
@@ -252,7 +356,8 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    InitRPCWorkClasses();
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTP_WORK_FAST, ClassifyJSONRPC);
 
     assert(EventBase());
     httpRPCTimerInterface = new HTTPRPCTimerInterface(EventBase());
@@ -6,11 +6,16 @@
 #ifndef NEXA_HTTPRPC_H
 #define NEXA_HTTPRPC_H
 
+#include "httpserver.h"
+
 #include <map>
 #include <string>
 
 class HTTPRequest;
 
+/** Requests with larger bodies are not parsed to pick their work queue, they go to the heavy queue */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 64 * 1024;
+
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -23,6 +28,16 @@ void InterruptHTTPRPC();
  */
 void StopHTTPRPC();
 
+/** Set up the work queue of each RPC method from the defaults, -rpcheavymethod and -rpcfastmethod */
+void InitRPCWorkClasses();
+
+/** Pick the work queue of a JSON-RPC request from the methods it calls, given its body or, for a larger body, its
+ * first MAX_CLASSIFY_BODY_SIZE + 1 bytes.  A batch goes to the slowest queue any of its calls needs: a long poll
+ * before a REST or CAPD call before a heavy call.  Requests that can not be parsed are left to the handler to reject
+ * on the fast queue, and larger ones go to the heavy queue.
+ */
+HTTPWorkClass ClassifyJSONRPCBody(const std::string &body);
+
 /** Start HTTP REST subsystem.
  * Precondition; HTTP and RPC has been started.
  */
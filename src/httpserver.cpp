@@ -9,7 +9,9 @@
 #include "compat.h"
 #include "netbase.h"
 #include "policy/policy.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h" // For HTTP status codes
+#include "rpc/stats.h"
 #include "sync.h"
 #include "ui_interface.h"
 #include "unlimited.h"
@@ -30,6 +32,7 @@
 #include <event2/event.h>
 #include <event2/http.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -45,20 +48,47 @@ static const size_t MAX_HEADERS_SIZE = 8192;
 /** Baseline HTTP Post body size */
 static const size_t BASELINE_BODY_SIZE = 0x02000000;
 
+/** Names of the work queues, indexed by HTTPWorkClass */
+static const char *WORK_QUEUE_NAMES[HTTP_WORK_CLASSES] = {"fast", "heavy", "rest", "poll"};
+
+/** The settings for the number of threads and the depth of each work queue, indexed by HTTPWorkClass */
+static const struct
+{
+    const char *threadsArg;
+    int defaultThreads;
+    const char *depthArg;
+    int defaultDepth;
+} WORK_QUEUE_ARGS[HTTP_WORK_CLASSES] = {
+    {"-rpcthreads", DEFAULT_HTTP_THREADS, "-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE},
+    {"-rpcheavythreads", DEFAULT_HTTP_HEAVY_THREADS, "-rpcheavyworkqueue", DEFAULT_HTTP_HEAVY_WORKQUEUE},
+    {"-restthreads", DEFAULT_HTTP_REST_THREADS, "-restworkqueue", DEFAULT_HTTP_REST_WORKQUEUE},
+    {"-rpcpollthreads", DEFAULT_HTTP_POLL_THREADS, "-rpcpollworkqueue", DEFAULT_HTTP_POLL_WORKQUEUE},
+};
+
 /** HTTP request work item */
 class HTTPWorkItem : public HTTPClosure
 {
 public:
-    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler &_func)
-        : req(std::move(_req)), path(_path), func(_func)
+    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req,
+        const std::string &_path,
+        const HTTPRequestHandler &_func,
+        HTTPWorkClass _workClass)
+        : req(std::move(_req)), path(_path), func(_func), workClass(_workClass), nQueued(GetStopwatchMicros())
+    {
+    }
+    void operator()()
     {
+        RecordHTTPQueueWait(WORK_QUEUE_NAMES[workClass], GetStopwatchMicros() - nQueued);
+        func(req.get(), path);
     }
-    void operator()() { func(req.get(), path); }
     std::unique_ptr<HTTPRequest> req;
 
 private:
     std::string path;
     HTTPRequestHandler func;
+    HTTPWorkClass workClass;
+    //! When the request was queued, for measuring how long it waited
+    uint64_t nQueued;
 };
 
 /** Simple work queue for distributing work over multiple threads.
@@ -75,6 +105,7 @@ private:
     bool running;
     size_t maxDepth;
     int numThreads;
+    uint64_t numRejected;
 
     /** RAII object to keep track of number of running worker threads */
     class ThreadCounter
@@ -95,7 +126,7 @@ private:
     };
 
 public:
-    WorkQueue(size_t _maxDepth) : running(true), maxDepth(_maxDepth), numThreads(0) {}
+    WorkQueue(size_t _maxDepth) : running(true), maxDepth(_maxDepth), numThreads(0), numRejected(0) {}
     /** Precondition: worker threads have all stopped
      */
     ~WorkQueue() {}
@@ -105,6 +136,7 @@ public:
         std::unique_lock<std::mutex> lock(cs_workQueue);
         if (queue.size() >= maxDepth)
         {
+            numRejected++;
             return false;
         }
         queue.emplace_back(std::unique_ptr<WorkItem>(item));
@@ -130,6 +162,15 @@ public:
             (*i)();
         }
     }
+    /** Fill in the number of running threads, the queue depth and the rejected item count */
+    void GetInfo(HTTPWorkQueueInfo &info)
+    {
+        std::unique_lock<std::mutex> lock(cs_workQueue);
+        info.threads = numThreads;
+        info.maxDepth = maxDepth;
+        info.depth = queue.size();
+        info.rejected = numRejected;
+    }
     /** Interrupt and exit loops */
     void Interrupt()
     {
@@ -142,29 +183,46 @@ public:
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler)
-        : prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix,
+        bool _exactMatch,
+        HTTPRequestHandler _handler,
+        HTTPWorkClass _workClass,
+        HTTPWorkClassifier _classifier)
+        : prefix(_prefix), exactMatch(_exactMatch), handler(_handler), workClass(_workClass), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPWorkClass workClass;
+    HTTPWorkClassifier classifier;
+};
+
+/** A libevent event loop with its own HTTP server, run by its own thread.  When there are several they all listen
+ * on the same sockets with SO_REUSEPORT and the kernel spreads the connections over them.
+ */
+struct HTTPListener
+{
+    struct event_base *base = nullptr;
+    struct evhttp *http = nullptr;
+    //! Bound listening sockets
+    std::vector<evhttp_bound_socket *> boundSockets;
+    std::thread thread;
+    std::future<bool> result;
 };
 
 /** HTTP module state */
 
-//! libevent event loop
+//! libevent event loop of the first listener, used for timers
 static struct event_base *eventBase = nullptr;
-//! HTTP server
-struct evhttp *eventHTTP = nullptr;
+//! Event loops and HTTP servers
+static std::vector<std::unique_ptr<HTTPListener> > httpListeners;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure> *workQueue = nullptr;
+//! Work queues for handling longer requests off the event loop threads, indexed by HTTPWorkClass
+static WorkQueue<HTTPClosure> *workQueues[HTTP_WORK_CLASSES] = {};
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
-//! Bound listening sockets
-std::vector<evhttp_bound_socket *> boundSockets;
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr &netaddr)
@@ -287,14 +345,17 @@ static void http_request_cb(struct evhttp_request *req, void *arg)
     // Dispatch to worker thread
     if (i != iend)
     {
-        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
+        HTTPWorkClass workClass = i->classifier ? i->classifier(hreq.get(), path) : i->workClass;
+        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler, workClass));
+        WorkQueue<HTTPClosure> *workQueue = workQueues[workClass];
         assert(workQueue);
         if (workQueue->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else
         {
-            LOGA("WARNING: request rejected because http work queue depth exceeded, it can be increased with the "
-                 "-rpcworkqueue= setting\n");
+            LOGA("WARNING: request rejected because the %s http work queue depth exceeded, it can be increased with "
+                 "the %s= setting\n",
+                WORK_QUEUE_NAMES[workClass], WORK_QUEUE_ARGS[workClass].depthArg);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     }
@@ -322,8 +383,8 @@ static bool ThreadHTTP(struct event_base *base, struct evhttp *http)
     return event_base_got_break(base) == 0;
 }
 
-/** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp *http)
+/** Determine what addresses the HTTP server listens on */
+static std::vector<std::pair<std::string, uint16_t> > HTTPBindEndpoints()
 {
     int defaultPort = GetArg("-rpcport", BaseParams().RPCPort());
     std::vector<std::pair<std::string, uint16_t> > endpoints;
@@ -355,24 +416,61 @@ static bool HTTPBindAddresses(struct evhttp *http)
         endpoints.push_back(std::make_pair("::", defaultPort));
         endpoints.push_back(std::make_pair("0.0.0.0", defaultPort));
     }
+    return endpoints;
+}
 
+/** Bind a socket with SO_REUSEPORT set, so that every listener can bind the same address */
+static evhttp_bound_socket *HTTPBindReusePort(HTTPListener &listener, const std::string &host, uint16_t port)
+{
+#ifdef LEV_OPT_REUSEABLE_PORT
+    CService addr;
+    if (!LookupNumeric(host.empty() ? "0.0.0.0" : host.c_str(), addr, port))
+        return nullptr;
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    if (!addr.GetSockAddr((struct sockaddr *)&sockaddr, &len))
+        return nullptr;
+    evconnlistener *evlistener = evconnlistener_new_bind(listener.base, nullptr, nullptr,
+        LEV_OPT_REUSEABLE | LEV_OPT_REUSEABLE_PORT | LEV_OPT_CLOSE_ON_FREE | LEV_OPT_CLOSE_ON_EXEC, -1,
+        (struct sockaddr *)&sockaddr, len);
+    if (!evlistener)
+        return nullptr;
+    evhttp_bound_socket *bind_handle = evhttp_bind_listener(listener.http, evlistener);
+    if (!bind_handle)
+        evconnlistener_free(evlistener);
+    return bind_handle;
+#else
+    return nullptr;
+#endif
+}
+
+/** Bind HTTP server to specified addresses */
+static bool HTTPBindAddresses(HTTPListener &listener,
+    const std::vector<std::pair<std::string, uint16_t> > &endpoints,
+    bool fReusePort)
+{
     // Bind addresses
-    for (std::vector<std::pair<std::string, uint16_t> >::iterator i = endpoints.begin(); i != endpoints.end(); ++i)
+    for (std::vector<std::pair<std::string, uint16_t> >::const_iterator i = endpoints.begin(); i != endpoints.end();
+         ++i)
     {
         LOG(HTTP, "Binding RPC on address %s port %i\n", i->first, i->second);
-        evhttp_bound_socket *bind_handle =
-            evhttp_bind_socket_with_handle(http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
+        evhttp_bound_socket *bind_handle = nullptr;
+        if (fReusePort)
+            bind_handle = HTTPBindReusePort(listener, i->first, i->second);
+        else
+            bind_handle = evhttp_bind_socket_with_handle(
+                listener.http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
         if (bind_handle)
         {
-            boundSockets.push_back(bind_handle);
+            listener.boundSockets.push_back(bind_handle);
         }
         else
         {
             LOGA("Binding RPC on address %s port %i failed.\n", i->first, i->second);
         }
     }
-    const bool fBoundAll = boundSockets.size() == endpoints.size();
-    const bool fBoundAny = boundSockets.size();
+    const bool fBoundAll = listener.boundSockets.size() == endpoints.size();
+    const bool fBoundAny = listener.boundSockets.size();
     if (GetBoolArg("-bindallorfail", false))
     {
         if (!fBoundAll)
@@ -386,9 +484,9 @@ static bool HTTPBindAddresses(struct evhttp *http)
 }
 
 /** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure> *queue)
+static void HTTPWorkQueueRun(WorkQueue<HTTPClosure> *queue, HTTPWorkClass workClass)
 {
-    RenameThread("nexa-httpworker");
+    RenameThread(strprintf("nexa-http-%s", WORK_QUEUE_NAMES[workClass]).c_str());
     queue->Run();
 }
 
@@ -414,11 +512,57 @@ static void libevent_log_cb(int severity, const char *_msg)
         LOG(LIBEVENT, "libevent: %s\n", msg);
 }
 
-bool InitHTTPServer()
+/** Free the HTTP server and event loop of a listener */
+static void FreeHTTPListener(HTTPListener &listener)
 {
-    struct evhttp *http = 0;
-    struct event_base *base = 0;
+    if (listener.http)
+    {
+        evhttp_free(listener.http);
+        listener.http = nullptr;
+    }
+    if (listener.base)
+    {
+        event_base_free(listener.base);
+        listener.base = nullptr;
+    }
+}
+
+/** Create an event loop and HTTP server and bind it to the endpoints */
+static std::unique_ptr<HTTPListener> NewHTTPListener(const std::vector<std::pair<std::string, uint16_t> > &endpoints,
+    bool fReusePort)
+{
+    std::unique_ptr<HTTPListener> listener(new HTTPListener());
+    listener->base = event_base_new();
+    if (!listener->base)
+    {
+        LOGA("Couldn't create an event_base: exiting\n");
+        return nullptr;
+    }
+
+    /* Create a new evhttp object to handle requests. */
+    listener->http = evhttp_new(listener->base);
+    if (!listener->http)
+    {
+        LOGA("couldn't create evhttp. Exiting.\n");
+        FreeHTTPListener(*listener);
+        return nullptr;
+    }
+
+    evhttp_set_timeout(listener->http, GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+    evhttp_set_max_headers_size(listener->http, MAX_HEADERS_SIZE);
+    evhttp_set_max_body_size(listener->http, BASELINE_BODY_SIZE + GetMaxAllowedNetMessage());
+    evhttp_set_gencb(listener->http, http_request_cb, nullptr);
+
+    if (!HTTPBindAddresses(*listener, endpoints, fReusePort))
+    {
+        FreeHTTPListener(*listener);
+        return nullptr;
+    }
+    return listener;
+}
 
+bool InitHTTPServer()
+{
     if (!InitHTTPAllowList())
         return false;
 
@@ -438,61 +582,71 @@ bool InitHTTPServer()
     evthread_use_pthreads();
 #endif
 
-    base = event_base_new(); // XXX RAII
-    if (!base)
+    int nListeners = std::max((long)GetArg("-rpclisteners", DEFAULT_HTTP_LISTENERS), 1L);
+#ifndef LEV_OPT_REUSEABLE_PORT
+    if (nListeners > 1)
     {
-        LOGA("Couldn't create an event_base: exiting\n");
-        return false;
+        LOGA("HTTP: this libevent can not share listening sockets, using a single listener thread\n");
+        nListeners = 1;
     }
-
-    /* Create a new evhttp object to handle requests. */
-    http = evhttp_new(base); // XXX RAII
-    if (!http)
+#endif
+    const bool fReusePort = nListeners > 1;
+    const std::vector<std::pair<std::string, uint16_t> > endpoints = HTTPBindEndpoints();
+    for (int i = 0; i < nListeners; i++)
     {
-        LOGA("couldn't create evhttp. Exiting.\n");
-        event_base_free(base);
-        return false;
+        std::unique_ptr<HTTPListener> listener = NewHTTPListener(endpoints, fReusePort);
+        if (!listener)
+        {
+            if (i == 0)
+            {
+                LOGA("Unable to bind any endpoint for RPC server\n");
+                return false;
+            }
+            LOGA("HTTP: could not start listener %d, continuing with %d\n", i + 1, i);
+            break;
+        }
+        if (i > 0 && listener->boundSockets.size() < httpListeners[0]->boundSockets.size())
+        {
+            // A listener missing some of the endpoints would make requests to them wait on the others
+            LOGA("HTTP: listener %d could not bind every endpoint, continuing with %d\n", i + 1, i);
+            FreeHTTPListener(*listener);
+            break;
+        }
+        httpListeners.push_back(std::move(listener));
     }
 
-    evhttp_set_timeout(http, GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
-    evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
-    evhttp_set_max_body_size(http, BASELINE_BODY_SIZE + GetMaxAllowedNetMessage());
-    evhttp_set_gencb(http, http_request_cb, nullptr);
-
-    if (!HTTPBindAddresses(http))
+    LOG(HTTP, "Initialized HTTP server\n");
+    for (int c = 0; c < HTTP_WORK_CLASSES; c++)
     {
-        LOGA("Unable to bind any endpoint for RPC server\n");
-        evhttp_free(http);
-        event_base_free(base);
-        return false;
+        int workQueueDepth = std::max((long)GetArg(WORK_QUEUE_ARGS[c].depthArg, WORK_QUEUE_ARGS[c].defaultDepth), 1L);
+        LOGA("HTTP: creating %s work queue of depth %d\n", WORK_QUEUE_NAMES[c], workQueueDepth);
+        workQueues[c] = new WorkQueue<HTTPClosure>(workQueueDepth);
     }
-
-    LOG(HTTP, "Initialized HTTP server\n");
-    int workQueueDepth = std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LOGA("HTTP: creating work queue of depth %d\n", workQueueDepth);
-
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
-    eventBase = base;
-    eventHTTP = http;
+    eventBase = httpListeners[0]->base;
     return true;
 }
 
-std::thread threadHTTP;
-std::future<bool> threadResult;
 static std::vector<std::thread> g_thread_http_workers;
 
 bool StartHTTPServer()
 {
     LOG(HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LOGA("HTTP: starting %d worker threads\n", rpcThreads);
-    std::packaged_task<bool(event_base *, evhttp *)> task(ThreadHTTP);
-    threadResult = task.get_future();
-    threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
+    LOGA("HTTP: starting %d listener threads\n", httpListeners.size());
+    for (std::unique_ptr<HTTPListener> &listener : httpListeners)
+    {
+        std::packaged_task<bool(event_base *, evhttp *)> task(ThreadHTTP);
+        listener->result = task.get_future();
+        listener->thread = std::thread(std::move(task), listener->base, listener->http);
+    }
 
-    for (int i = 0; i < rpcThreads; i++)
+    for (int c = 0; c < HTTP_WORK_CLASSES; c++)
     {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue);
+        int rpcThreads = std::max((long)GetArg(WORK_QUEUE_ARGS[c].threadsArg, WORK_QUEUE_ARGS[c].defaultThreads), 1L);
+        LOGA("HTTP: starting %d %s worker threads\n", rpcThreads, WORK_QUEUE_NAMES[c]);
+        for (int i = 0; i < rpcThreads; i++)
+        {
+            g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueues[c], (HTTPWorkClass)c);
+        }
     }
     return true;
 }
@@ -500,24 +654,28 @@ bool StartHTTPServer()
 void InterruptHTTPServer()
 {
     LOG(HTTP, "Interrupting HTTP server\n");
-    if (eventHTTP)
+    for (std::unique_ptr<HTTPListener> &listener : httpListeners)
     {
         // Unlisten sockets
-        for (evhttp_bound_socket *socket : boundSockets)
+        for (evhttp_bound_socket *socket : listener->boundSockets)
         {
-            evhttp_del_accept_socket(eventHTTP, socket);
+            evhttp_del_accept_socket(listener->http, socket);
         }
+        listener->boundSockets.clear();
         // Reject requests on current connections
-        evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
+        evhttp_set_gencb(listener->http, http_reject_request_cb, nullptr);
+    }
+    for (WorkQueue<HTTPClosure> *workQueue : workQueues)
+    {
+        if (workQueue)
+            workQueue->Interrupt();
     }
-    if (workQueue)
-        workQueue->Interrupt();
 }
 
 void StopHTTPServer()
 {
     LOG(HTTP, "Stopping HTTP server\n");
-    if (workQueue)
+    if (workQueues[0])
     {
         LOG(HTTP, "Waiting for HTTP worker threads to exit\n");
         for (auto &thread : g_thread_http_workers)
@@ -525,42 +683,56 @@ void StopHTTPServer()
             thread.join();
         }
         g_thread_http_workers.clear();
-        delete workQueue;
-        workQueue = nullptr;
+        for (WorkQueue<HTTPClosure> *&workQueue : workQueues)
+        {
+            delete workQueue;
+            workQueue = nullptr;
+        }
     }
-    if (eventBase)
+    for (std::unique_ptr<HTTPListener> &listener : httpListeners)
     {
         LOG(HTTP, "Waiting for HTTP event thread to exit\n");
         // Exit the event loop as soon as there are no active events.
-        event_base_loopexit(eventBase, nullptr);
+        event_base_loopexit(listener->base, nullptr);
+    }
+    for (std::unique_ptr<HTTPListener> &listener : httpListeners)
+    {
         // Give event loop a few seconds to exit (to send back last RPC responses), then break it
         // Before this was solved with event_base_loopexit, but that didn't work as expected in
         // at least libevent 2.0.21 and always introduced a delay. In libevent
         // master that appears to be solved, so in the future that solution
         // could be used again (if desirable).
         // (see discussion in https://github.com/bitcoin/bitcoin/pull/6990)
-        if (threadResult.valid() &&
-            threadResult.wait_for(std::chrono::milliseconds(2000)) == std::future_status::timeout)
+        if (listener->result.valid() &&
+            listener->result.wait_for(std::chrono::milliseconds(2000)) == std::future_status::timeout)
         {
             LOGA("HTTP event loop did not exit within allotted time, sending loopbreak\n");
-            event_base_loopbreak(eventBase);
+            event_base_loopbreak(listener->base);
         }
-        if (threadHTTP.joinable())
+        if (listener->thread.joinable())
         {
-            threadHTTP.join();
+            listener->thread.join();
         }
+        FreeHTTPListener(*listener);
     }
-    if (eventHTTP)
-    {
-        evhttp_free(eventHTTP);
-        eventHTTP = nullptr;
-    }
-    if (eventBase)
+    httpListeners.clear();
+    eventBase = nullptr;
+    LOG(HTTP, "Stopped HTTP server\n");
+}
+
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo()
+{
+    std::vector<HTTPWorkQueueInfo> ret;
+    for (int c = 0; c < HTTP_WORK_CLASSES; c++)
     {
-        event_base_free(eventBase);
-        eventBase = nullptr;
+        if (!workQueues[c])
+            continue;
+        HTTPWorkQueueInfo info;
+        info.name = WORK_QUEUE_NAMES[c];
+        workQueues[c]->GetInfo(info);
+        ret.push_back(info);
     }
-    LOG(HTTP, "Stopped HTTP server\n");
+    return ret;
 }
 
 struct event_base *EventBase() { return eventBase; }
@@ -587,10 +759,20 @@ void HTTPEvent::trigger(struct timeval *tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
-HTTPRequest::HTTPRequest(struct evhttp_request *_req) : req(_req), replySent(false) {}
+HTTPRequest::HTTPRequest(struct evhttp_request *_req) : req(_req), base(eventBase), replySent(false)
+{
+    evhttp_connection *conn = evhttp_request_get_connection(req);
+    if (conn)
+        base = evhttp_connection_get_base(conn);
+}
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent)
+    if (chunkedReply)
+    {
+        LOGA("%s: Unfinished chunked reply\n", __func__);
+        EndChunkedReply();
+    }
+    else if (!replySent)
     {
         // Keep track of whether reply was sent to avoid request leaks
         LOGA("%s: Unhandled request\n", __func__);
@@ -630,6 +812,18 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t maxSize)
+{
+    struct evbuffer *buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    size_t size = std::min(evbuffer_get_length(buf), maxSize);
+    std::string rv(size, '\0');
+    if (size && evbuffer_copyout(buf, &rv[0], size) != (ev_ssize_t)size)
+        return "";
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string &hdr, const std::string &value)
 {
     struct evkeyvalq *headers = evhttp_request_get_output_headers(req);
@@ -642,38 +836,212 @@ void HTTPRequest::WriteHeader(const std::string &hdr, const std::string &value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
+/** Re-enable reading from the socket once a reply is sent. This is the second part of the libevent
+ * workaround in http_request_cb.
+ */
+static void ReenableReading(struct evhttp_request *req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001)
+    {
+        evhttp_connection *conn = evhttp_request_get_connection(req);
+        if (conn)
+        {
+            bufferevent *bev = evhttp_connection_get_bufferevent(conn);
+            if (bev)
+            {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 void HTTPRequest::WriteReply(int nStatus, const std::string &strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !chunkedReply && req);
     // Send event to main http thread to send reply message
     struct evbuffer *evb = evhttp_request_get_output_buffer(req);
     assert(evb);
     evbuffer_add(evb, strReply.data(), strReply.size());
     auto req_copy = req;
-    HTTPEvent *ev = new HTTPEvent(eventBase, true,
+    HTTPEvent *ev = new HTTPEvent(base, true,
         [req_copy, nStatus]
         {
             evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-            // Re-enable reading from the socket. This is the second part of the libevent
-            // workaround above.
-            if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001)
+            ReenableReading(req_copy);
+        });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** Output of a chunked reply that the event loop thread has not handed to the client yet */
+struct HTTPChunkedReply
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    //! Bytes of chunks queued for the event loop thread
+    size_t nQueued = 0;
+    //! Bytes in the connection's output buffer when the event loop thread last looked
+    size_t nBuffered = 0;
+    //! The client went away
+    bool fClosed = false;
+    //! A re-check of the output buffer is waiting on the event loop
+    bool fCheckPending = false;
+    //! The reply was ended, so the event loop may have freed the request
+    bool fEnded = false;
+};
+
+/** The producer of a chunked reply waits while more than this is not yet sent */
+static const size_t MAX_CHUNKED_REPLY_BUFFER = 4 * 1024 * 1024;
+
+/** How often the event loop looks at the output buffer again while the producer of a chunked reply waits */
+static const int CHUNKED_REPLY_RECHECK_MS = 10;
+
+/**
+ * Record how much of a chunked reply the connection still has to send, on the event loop thread.  nSent is the size
+ * of a chunk that was just handed to libevent, 0 for a timed re-check.  libevent keeps the request until the reply is
+ * ended, but drops the connection if the client leaves.
+ */
+static void CheckChunkedReply(struct evhttp_request *req, HTTPChunkedReply &state, size_t nSent)
+{
+    std::lock_guard<std::mutex> lock(state.cs);
+    if (nSent == 0)
+    {
+        state.fCheckPending = false;
+        if (state.fEnded)
+            return;
+    }
+    evhttp_connection *conn = evhttp_request_get_connection(req);
+    size_t nBuffered = 0;
+    if (conn)
+    {
+        bufferevent *bev = evhttp_connection_get_bufferevent(conn);
+        if (bev)
+            nBuffered = evbuffer_get_length(bufferevent_get_output(bev));
+    }
+    state.nQueued -= nSent;
+    state.nBuffered = nBuffered;
+    if (!conn)
+        state.fClosed = true;
+    state.cond.notify_all();
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && !chunkedReply && req);
+    chunkedReply = std::make_shared<HTTPChunkedReply>();
+    auto req_copy = req;
+    HTTPEvent *ev =
+        new HTTPEvent(base, true, [req_copy, nStatus] { evhttp_send_reply_start(req_copy, nStatus, nullptr); });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string &chunk)
+{
+    struct evbuffer *evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, chunk.data(), chunk.size());
+    return QueueReplyChunk(evb);
+}
+
+bool HTTPRequest::WriteReplyChunk(std::vector<unsigned char> &&chunk)
+{
+    // Hand the memory itself to libevent, which frees it once the chunk has been sent
+    std::vector<unsigned char> *data = new std::vector<unsigned char>(std::move(chunk));
+    struct evbuffer *evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add_reference(evb, data->data(), data->size(),
+        [](const void *, size_t, void *extra) { delete static_cast<std::vector<unsigned char> *>(extra); }, data);
+    return QueueReplyChunk(evb);
+}
+
+bool HTTPRequest::QueueReplyChunk(struct evbuffer *evb)
+{
+    assert(chunkedReply && req);
+    std::shared_ptr<HTTPChunkedReply> state = chunkedReply;
+    auto req_copy = req;
+    const size_t size = evbuffer_get_length(evb);
+    {
+        std::unique_lock<std::mutex> lock(state->cs);
+        while (!state->fClosed && state->nQueued + state->nBuffered > MAX_CHUNKED_REPLY_BUFFER)
+        {
+            // The output buffer drains, and the client may leave, without an event for us, so have the event loop
+            // look again a little later
+            if (!state->fCheckPending)
             {
-                evhttp_connection *conn = evhttp_request_get_connection(req_copy);
-                if (conn)
-                {
-                    bufferevent *bev = evhttp_connection_get_bufferevent(conn);
-                    if (bev)
-                    {
-                        bufferevent_enable(bev, EV_READ | EV_WRITE);
-                    }
-                }
+                state->fCheckPending = true;
+                HTTPEvent *ev =
+                    new HTTPEvent(base, true, [req_copy, state] { CheckChunkedReply(req_copy, *state, 0); });
+                struct timeval tv = {0, CHUNKED_REPLY_RECHECK_MS * 1000};
+                ev->trigger(&tv);
             }
+            state->cond.wait(lock);
+        }
+        if (state->fClosed)
+        {
+            evbuffer_free(evb);
+            return false;
+        }
+        state->nQueued += size;
+    }
+
+    HTTPEvent *ev = new HTTPEvent(base, true,
+        [req_copy, evb, size, state]
+        {
+            if (evhttp_request_get_connection(req_copy))
+                evhttp_send_reply_chunk(req_copy, evb);
+            evbuffer_free(evb);
+            CheckChunkedReply(req_copy, *state, size);
         });
     ev->trigger(nullptr);
+    return true;
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(chunkedReply && req);
+    {
+        // A re-check still waiting on the event loop must not look at the request once it is ended
+        std::lock_guard<std::mutex> lock(chunkedReply->cs);
+        chunkedReply->fEnded = true;
+    }
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(base, true,
+        [req_copy]
+        {
+            // This frees the request if the client has gone away
+            ReenableReading(req_copy);
+            evhttp_send_reply_end(req_copy);
+        });
+    ev->trigger(nullptr);
+    chunkedReply.reset();
     replySent = true;
     req = nullptr; // transferred back to main thread
 }
 
+void StreamJSONReply(HTTPRequest *req, const std::function<void(JSONStreamWriter &out)> &writeJSON)
+{
+    req->WriteHeader("Content-Type", "application/json");
+    req->StartChunkedReply(HTTP_OK);
+    JSONStreamWriter out([req](const std::string &chunk) { return req->WriteReplyChunk(chunk); });
+    try
+    {
+        writeJSON(out);
+        out.Raw("\n");
+        out.Flush();
+    }
+    catch (const std::exception &e)
+    {
+        // The status is already sent, all that can be done is to cut the reply short
+        LOGA("Error while streaming the reply to %s: %s\n", req->GetURI(), e.what());
+    }
+    catch (...)
+    {
+        LOGA("Error while streaming the reply to %s\n", req->GetURI());
+    }
+    req->EndChunkedReply();
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection *con = evhttp_request_get_connection(req);
@@ -712,10 +1080,14 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix,
+    bool exactMatch,
+    const HTTPRequestHandler &handler,
+    HTTPWorkClass workClass,
+    const HTTPWorkClassifier &classifier)
 {
     LOG(HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, workClass, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -7,17 +7,29 @@
 #define NEXA_HTTPSERVER_H
 
 #include <functional>
+#include <memory>
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS = 4;
 static const int DEFAULT_HTTP_WORKQUEUE = 16;
+static const int DEFAULT_HTTP_HEAVY_THREADS = 2;
+static const int DEFAULT_HTTP_HEAVY_WORKQUEUE = 16;
+static const int DEFAULT_HTTP_REST_THREADS = 2;
+static const int DEFAULT_HTTP_REST_WORKQUEUE = 16;
+static const int DEFAULT_HTTP_POLL_THREADS = 8;
+static const int DEFAULT_HTTP_POLL_WORKQUEUE = 16;
+static const int DEFAULT_HTTP_LISTENERS = 1;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT = 30;
 
 struct evhttp_request;
 struct event_base;
+struct evbuffer;
 class CService;
 class HTTPRequest;
+class JSONStreamWriter;
+struct HTTPChunkedReply;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -33,13 +45,34 @@ void InterruptHTTPServer();
 /** Stop HTTP server */
 void StopHTTPServer();
 
+/** The work queues requests are handed to.  Each has its own worker threads and depth so that slow requests
+ * can not starve cheap ones.
+ */
+enum HTTPWorkClass
+{
+    HTTP_WORK_FAST, //!< Cheap RPC calls
+    HTTP_WORK_HEAVY, //!< RPC calls that can take a long time, like getblock or scantokens
+    HTTP_WORK_REST, //!< REST and CAPD requests
+    HTTP_WORK_POLL, //!< Long polls, which hold their thread until an event arrives or they time out
+    HTTP_WORK_CLASSES
+};
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<void(HTTPRequest *req, const std::string &)> HTTPRequestHandler;
+/** Picks the work queue of a request.  Called on the libevent thread, so it must be quick and must not consume
+ * the request body.
+ */
+typedef std::function<HTTPWorkClass(HTTPRequest *req, const std::string &)> HTTPWorkClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
  * be invoked.
+ * Requests are run on the workClass queue, unless a classifier is given to choose per request.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix,
+    bool exactMatch,
+    const HTTPRequestHandler &handler,
+    HTTPWorkClass workClass = HTTP_WORK_FAST,
+    const HTTPWorkClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -48,6 +81,20 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base *EventBase();
 
+/** The state of one of the HTTP work queues */
+struct HTTPWorkQueueInfo
+{
+    std::string name;
+    int threads = 0;
+    size_t maxDepth = 0;
+    size_t depth = 0;
+    //! Requests turned away because the queue was full
+    uint64_t rejected = 0;
+};
+
+/** Returns the state of every HTTP work queue, or nothing if the server is not running */
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo();
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -55,7 +102,14 @@ class HTTPRequest
 {
 private:
     struct evhttp_request *req;
+    //! The event loop of the listener thread that received the request, which must send the reply
+    struct event_base *base;
     bool replySent;
+    //! Set while a reply is being sent in chunks
+    std::shared_ptr<HTTPChunkedReply> chunkedReply;
+
+    //! Queue a piece of a chunked reply for the event loop, taking ownership of evb
+    bool QueueReplyChunk(struct evbuffer *evb);
 
 public:
     HTTPRequest(struct evhttp_request *req);
@@ -96,6 +150,12 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Return the request body without consuming it, for looking at the request before it is handled.
+     * At most maxSize bytes are returned.
+     */
+    std::string PeekBody(size_t maxSize);
+
     /**
      * Write output header.
      *
@@ -112,8 +172,34 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string &strReply = "");
+
+    /**
+     * Start a reply whose body is sent in pieces with WriteReplyChunk(), for replies too large to build in memory
+     * first.  Headers must be written before this.
+     *
+     * @note Call EndChunkedReply() when done instead of WriteReply().
+     */
+    void StartChunkedReply(int nStatus);
+
+    /**
+     * Send the next piece of a chunked reply.  Waits while a lot of earlier output has not been sent to the client
+     * yet.  Returns false if the client has gone away, so the caller can stop producing output.
+     */
+    bool WriteReplyChunk(const std::string &chunk);
+    /** The same, but the data is handed over to be sent as it is, without being copied again */
+    bool WriteReplyChunk(std::vector<unsigned char> &&chunk);
+
+    /**
+     * Finish a chunked reply.  As with WriteReply(), do not call any other HTTPRequest methods after this.
+     */
+    void EndChunkedReply();
 };
 
+/** Send a JSON reply in chunks as writeJSON produces it, so large replies are never held in memory whole.  If
+ * writeJSON throws after the status has been sent, the error is logged and the reply is cut short.
+ */
+void StreamJSONReply(HTTPRequest *req, const std::function<void(JSONStreamWriter &out)> &writeJSON);
+
 /** Event handler closure.
  */
 class HTTPClosure
@@ -0,0 +1,218 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/addressindex.h"
+#include "crypto/sha256.h"
+#include "undo.h"
+#include "util.h"
+#include "validation/validation.h"
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+uint256 ScriptHash(const CScript &script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+/** Fetch the running totals of a scripthash, reading them from the database the first time the scripthash is
+ *  touched by the block being applied */
+static CAddressBalance &GetUpdateBalance(const AddressIndexDB &db,
+    CAddressIndexUpdate &update,
+    const uint256 &scripthash)
+{
+    auto it = update.balances.find(scripthash);
+    if (it == update.balances.end())
+    {
+        CAddressBalance balance;
+        db.ReadBalance(scripthash, balance);
+        it = update.balances.emplace(scripthash, balance).first;
+    }
+    return it->second;
+}
+
+AddressIndex::AddressIndex(AddressIndexDB *_db) : db(_db) {}
+bool AddressIndex::ReadBestBlock(CBlockLocator &locator) const { return db->ReadBestBlock(locator); }
+bool AddressIndex::WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block and undo data inconsistent", __func__);
+
+    const uint32_t nHeight = pindex->height();
+    CAddressIndexUpdate update;
+
+    // Outputs first: with canonical transaction ordering a transaction may spend an output created later in the
+    // same block, and such outputs never need to touch the database.
+    std::map<uint256, std::pair<uint256, CAddressUnspentValue> > created;
+    for (const auto &ptx : block.vtx)
+    {
+        const uint256 idem = ptx->GetIdem();
+        for (uint32_t o = 0; o < ptx->vout.size(); o++)
+        {
+            const CTxOut &out = ptx->vout[o];
+            if (out.scriptPubKey.IsUnspendable())
+                continue;
+
+            const uint256 scripthash = ScriptHash(out.scriptPubKey);
+            update.historyWrite.emplace_back(
+                CAddressHistoryKey(scripthash, nHeight, idem, o, false), CAddressHistoryValue(out.nValue));
+            created.emplace(COutPoint(idem, o).hash,
+                std::make_pair(scripthash, CAddressUnspentValue(idem, o, nHeight, out.nValue)));
+
+            CAddressBalance &balance = GetUpdateBalance(*db, update, scripthash);
+            balance.received += out.nValue;
+            balance.balance += out.nValue;
+            balance.nHistory++;
+            balance.nUnspent++;
+        }
+    }
+
+    for (size_t i = 1; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = *block.vtx[i];
+        const CTxUndo &txundo = blockundo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size())
+            return error("%s: transaction and undo data inconsistent", __func__);
+
+        const uint256 id = tx.GetId();
+        for (uint32_t j = 0; j < tx.vin.size(); j++)
+        {
+            const Coin &coin = txundo.vprevout[j];
+            const uint256 &prevout = tx.vin[j].prevout.hash;
+            const uint256 scripthash = ScriptHash(coin.out.scriptPubKey);
+
+            CAddressHistoryValue value(-coin.out.nValue);
+            value.prevHeight = coin.nHeight;
+            auto it = created.find(prevout);
+            if (it != created.end())
+            {
+                value.prevIdem = it->second.second.txidem;
+                value.prevN = it->second.second.n;
+                created.erase(it);
+            }
+            else
+            {
+                CAddressUnspentValue unspent;
+                if (db->ReadUnspentEntry(scripthash, prevout, unspent))
+                {
+                    value.prevIdem = unspent.txidem;
+                    value.prevN = unspent.n;
+                }
+                update.unspentErase.emplace_back(scripthash, prevout);
+            }
+            update.historyWrite.emplace_back(CAddressHistoryKey(scripthash, nHeight, id, j, true), value);
+
+            CAddressBalance &balance = GetUpdateBalance(*db, update, scripthash);
+            balance.balance -= coin.out.nValue;
+            balance.nHistory++;
+            balance.nUnspent--;
+        }
+    }
+
+    update.unspentWrite.reserve(created.size());
+    for (const auto &entry : created)
+    {
+        update.unspentWrite.emplace_back(std::make_pair(entry.second.first, entry.first), entry.second.second);
+    }
+
+    LOCK(cs_main);
+    return db->WriteUpdate(update, chainActive.GetLocator(pindex));
+}
+
+bool AddressIndex::RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block and undo data inconsistent", __func__);
+
+    const uint32_t nHeight = pindex->height();
+    CAddressIndexUpdate update;
+
+    std::set<uint256> created;
+    for (const auto &ptx : block.vtx)
+    {
+        const uint256 idem = ptx->GetIdem();
+        for (uint32_t o = 0; o < ptx->vout.size(); o++)
+        {
+            const CTxOut &out = ptx->vout[o];
+            if (out.scriptPubKey.IsUnspendable())
+                continue;
+
+            const uint256 scripthash = ScriptHash(out.scriptPubKey);
+            const uint256 outpoint = COutPoint(idem, o).hash;
+            update.historyErase.emplace_back(scripthash, nHeight, idem, o, false);
+            update.unspentErase.emplace_back(scripthash, outpoint);
+            created.insert(outpoint);
+
+            CAddressBalance &balance = GetUpdateBalance(*db, update, scripthash);
+            balance.received -= out.nValue;
+            balance.balance -= out.nValue;
+            balance.nHistory--;
+            balance.nUnspent--;
+        }
+    }
+
+    for (size_t i = 1; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = *block.vtx[i];
+        const CTxUndo &txundo = blockundo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size())
+            return error("%s: transaction and undo data inconsistent", __func__);
+
+        const uint256 id = tx.GetId();
+        for (uint32_t j = 0; j < tx.vin.size(); j++)
+        {
+            const Coin &coin = txundo.vprevout[j];
+            const uint256 &prevout = tx.vin[j].prevout.hash;
+            const uint256 scripthash = ScriptHash(coin.out.scriptPubKey);
+            const CAddressHistoryKey key(scripthash, nHeight, id, j, true);
+
+            CAddressHistoryValue value;
+            if (!db->ReadHistoryEntry(key, value))
+                return error("%s: missing address history entry for input %s:%d", __func__, id.ToString(), j);
+            update.historyErase.push_back(key);
+            if (!created.count(prevout))
+            {
+                update.unspentWrite.emplace_back(std::make_pair(scripthash, prevout),
+                    CAddressUnspentValue(value.prevIdem, value.prevN, value.prevHeight, coin.out.nValue));
+            }
+
+            CAddressBalance &balance = GetUpdateBalance(*db, update, scripthash);
+            balance.balance += coin.out.nValue;
+            balance.nHistory--;
+            balance.nUnspent++;
+        }
+    }
+
+    LOCK(cs_main);
+    return db->WriteUpdate(update, chainActive.GetLocator(pindex->pprev));
+}
+
+bool AddressIndex::GetBalance(const uint256 &scripthash, CAddressBalance &balance) const
+{
+    return db->ReadBalance(scripthash, balance);
+}
+
+bool AddressIndex::GetHistory(const uint256 &scripthash,
+    uint32_t nFromHeight,
+    size_t nMax,
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const
+{
+    return db->ReadHistory(scripthash, nFromHeight, nMax, entries);
+}
+
+bool AddressIndex::GetHistory(const CAddressHistoryKey &after,
+    size_t nMax,
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const
+{
+    return db->ReadHistory(after, nMax, entries);
+}
+
+bool AddressIndex::GetUnspent(const uint256 &scripthash,
+    const uint256 &after,
+    size_t nMax,
+    std::vector<std::pair<uint256, CAddressUnspentValue> > &entries) const
+{
+    return db->ReadUnspent(scripthash, after, nMax, entries);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_INDEX_ADDRESSINDEX_H
+#define NEXA_INDEX_ADDRESSINDEX_H
+
+#include "index/baseindex.h"
+#include "txdb.h"
+#include "uint256.h"
+
+class CScript;
+
+/** The Electrum-style scripthash of an output script: the sha256 of the serialized scriptPubKey */
+uint256 ScriptHash(const CScript &script);
+
+/**
+ * AddressIndex maps the scripthash of every output in the active chain to the transactions that funded or spent
+ * it, the outputs that are still unspent and a running balance. This lets wallet backends answer Electrum-style
+ * history, balance and listunspent queries from the node itself, without an external indexer.
+ *
+ * It follows the BaseIndex life cycle. Each block is applied as a single database batch, and since spending entries
+ * record the output they spent a block can be undone again during a reorg.
+ */
+class AddressIndex final : public BaseIndex
+{
+private:
+    const std::unique_ptr<AddressIndexDB> db;
+
+protected:
+    const char *GetName() const override { return "addressindex"; }
+    bool ReadBestBlock(CBlockLocator &locator) const override;
+
+public:
+    /// Constructs the AddressIndex, which becomes available to be queried.
+    explicit AddressIndex(AddressIndexDB *db);
+
+    /// Add the entries of a connected block to the index.
+    bool WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) override;
+
+    /// Remove the entries of a disconnected block from the index and restore the outputs it spent.
+    bool RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) override;
+
+    /// The running totals of a scripthash
+    bool GetBalance(const uint256 &scripthash, CAddressBalance &balance) const;
+
+    /// Up to nMax history entries of a scripthash, in block order, starting at nFromHeight
+    bool GetHistory(const uint256 &scripthash,
+        uint32_t nFromHeight,
+        size_t nMax,
+        std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const;
+
+    /// Up to nMax history entries of after.scripthash, in block order, continuing after the entry "after"
+    bool GetHistory(const CAddressHistoryKey &after,
+        size_t nMax,
+        std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const;
+
+    /// Up to nMax unspent outputs of a scripthash, starting after outpoint hash "after"
+    bool GetUnspent(const uint256 &scripthash,
+        const uint256 &after,
+        size_t nMax,
+        std::vector<std::pair<uint256, CAddressUnspentValue> > &entries) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // NEXA_INDEX_ADDRESSINDEX_H
@@ -0,0 +1,253 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/baseindex.h"
+#include "blockstorage/blockstorage.h"
+#include "chainparams.h"
+#include "index/indexerror.h"
+#include "init.h"
+#include "undo.h"
+#include "util.h"
+#include "validation/validation.h"
+
+#include <algorithm>
+#include <vector>
+
+constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
+
+/** The started indexes, which the validation callbacks keep in sync */
+static CCriticalSection cs_indexes;
+static std::vector<BaseIndex *> vIndexes GUARDED_BY(cs_indexes);
+
+static void UnregisterIndex(BaseIndex *index)
+{
+    LOCK(cs_indexes);
+    vIndexes.erase(std::remove(vIndexes.begin(), vIndexes.end(), index), vIndexes.end());
+}
+
+void IndexesBlockConnected(const CBlock &block, const CBlockUndo &blockundo, CBlockIndex *pindex)
+{
+    LOCK(cs_indexes);
+    for (BaseIndex *index : vIndexes)
+        index->BlockConnected(block, blockundo, pindex);
+}
+
+void IndexesBlockDisconnected(const CBlock &block, CBlockIndex *pindex)
+{
+    LOCK(cs_indexes);
+    for (BaseIndex *index : vIndexes)
+        index->BlockDisconnected(block, pindex);
+}
+
+void StopIndexes()
+{
+    std::vector<BaseIndex *> indexes;
+    {
+        LOCK(cs_indexes);
+        indexes = vIndexes;
+    }
+    for (BaseIndex *index : indexes)
+        index->Stop();
+}
+
+BaseIndex::BaseIndex() : fSynced(false), pbestindex(nullptr) {}
+BaseIndex::~BaseIndex()
+{
+    UnregisterIndex(this);
+    if (syncthread.joinable())
+    {
+        shutdown_threads.store(true);
+        syncthread.join();
+    }
+}
+
+bool BaseIndex::Init()
+{
+    LOCK(cs_main);
+
+    CBlockLocator locator;
+    if (!ReadBestBlock(locator))
+    {
+        locator.SetNull();
+    }
+
+    // Unlike FindForkInGlobalIndex we want the exact block the index was written up to, even if it has since been
+    // reorganized out of the active chain, so that ThreadSync can rewind it.
+    CBlockIndex *pindex = nullptr;
+    if (!locator.vHave.empty())
+    {
+        pindex = LookupBlockIndex(locator.vHave[0]);
+        if (!pindex)
+            pindex = FindForkInGlobalIndex(chainActive, locator);
+    }
+    pbestindex = pindex;
+    return true;
+}
+
+static const CBlockIndex *NextSyncBlock(const CBlockIndex *pindex_prev)
+{
+    AssertLockHeld(cs_main);
+    if (!pindex_prev)
+    {
+        return chainActive.Genesis();
+    }
+    return chainActive.Next(pindex_prev);
+}
+
+bool BaseIndex::ReadBlockAndUndo(const CBlockIndex *pindex, ConstCBlockRef &pblock, CBlockUndo &blockundo)
+{
+    pblock = ReadBlockFromDisk(pindex, Params().GetConsensus());
+    if (!pblock)
+        return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+
+    // The genesis block has no undo data since its coinbase spends nothing.
+    blockundo.vtxundo.clear();
+    if (pindex->pprev && !ReadUndoFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev))
+        return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+    return true;
+}
+
+void BaseIndex::ThreadSync()
+{
+    while (fReindex || fImporting || IsInitialBlockDownload())
+    {
+        MilliSleep(1000);
+        if (shutdown_threads.load() == true)
+        {
+            return;
+        }
+    }
+
+    CBlockIndex *pindex = pbestindex.load();
+    int64_t last_log_time = 0;
+    while (!fSynced.load())
+    {
+        if (shutdown_threads.load() == true)
+        {
+            return;
+        }
+
+        // Find the next step: rewind a block that is no longer in the active chain, connect the next block, or
+        // switch over to the validation callbacks when there is nothing left to do. The switch is made under
+        // cs_main so that no block can be connected in between.
+        CBlockIndex *pindexRewind = nullptr;
+        const CBlockIndex *pindex_next = nullptr;
+        {
+            LOCK(cs_main);
+            if (pindex && !chainActive.Contains(pindex))
+            {
+                pindexRewind = pindex;
+            }
+            else
+            {
+                pindex_next = NextSyncBlock(pindex);
+                if (!pindex_next)
+                {
+                    pbestindex = pindex;
+                    fSynced = true;
+                    break;
+                }
+            }
+        }
+
+        ConstCBlockRef pblock;
+        CBlockUndo blockundo;
+        if (pindexRewind)
+        {
+            if (!ReadBlockAndUndo(pindexRewind, pblock, blockundo) || !RewindBlock(*pblock, blockundo, pindexRewind))
+            {
+                FatalError("%s: Failed to rewind block %s from %s", __func__, pindexRewind->GetBlockHash().ToString(),
+                    GetName());
+                return;
+            }
+            pindex = pindexRewind->pprev;
+            continue;
+        }
+
+        pindex = const_cast<CBlockIndex *>(pindex_next);
+        int64_t current_time = GetTime();
+        if (last_log_time + SYNC_LOG_INTERVAL < current_time)
+        {
+            LOGA("Syncing %s with block chain from height %d\n", GetName(), pindex->height());
+            last_log_time = current_time;
+        }
+
+        if (!ReadBlockAndUndo(pindex, pblock, blockundo) || !WriteBlock(*pblock, blockundo, pindex))
+        {
+            FatalError("%s: Failed to write block %s to %s database", __func__, pindex->GetBlockHash().ToString(),
+                GetName());
+            return;
+        }
+        pbestindex = pindex;
+    }
+
+    if (pindex)
+    {
+        LOGA("%s is enabled at height %d\n", GetName(), pindex->height());
+    }
+    else
+    {
+        LOGA("%s is enabled\n", GetName());
+    }
+}
+
+void BaseIndex::BlockConnected(const CBlock &block, const CBlockUndo &blockundo, CBlockIndex *pindex)
+{
+    if (!fSynced.load())
+        return;
+
+    if (WriteBlock(block, blockundo, pindex))
+    {
+        pbestindex = pindex;
+    }
+    else
+    {
+        FatalError("%s: Failed to write block %s to %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+    }
+}
+
+void BaseIndex::BlockDisconnected(const CBlock &block, CBlockIndex *pindex)
+{
+    if (!fSynced.load())
+        return;
+
+    CBlockUndo blockundo;
+    if (RewindNeedsUndo() && !ReadUndoFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev))
+    {
+        FatalError("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+        return;
+    }
+    if (!RewindBlock(block, blockundo, pindex))
+    {
+        FatalError("%s: Failed to rewind block %s from %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+        return;
+    }
+    pbestindex = pindex->pprev;
+}
+
+void BaseIndex::Start()
+{
+    if (!Init())
+    {
+        FatalError("%s: %s failed to initialize", __func__, GetName());
+        return;
+    }
+
+    {
+        LOCK(cs_indexes);
+        vIndexes.push_back(this);
+    }
+    syncthread = std::thread(&TraceThread<std::function<void()> >, GetName(), std::bind(&BaseIndex::ThreadSync, this));
+}
+
+void BaseIndex::Stop()
+{
+    UnregisterIndex(this);
+    shutdown_threads.store(true);
+    if (syncthread.joinable())
+    {
+        syncthread.join();
+    }
+}
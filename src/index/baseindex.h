@@ -0,0 +1,97 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_INDEX_BASEINDEX_H
+#define NEXA_INDEX_BASEINDEX_H
+
+#include "primitives/block.h"
+
+#include <atomic>
+#include <thread>
+
+class CBlockIndex;
+class CBlockUndo;
+struct CBlockLocator;
+
+/**
+ * The life cycle shared by the indexes that are built from the block and undo data of the active chain.
+ *
+ * Start() launches a sync thread that catches the index up to the tip, first rewinding any blocks it holds that are
+ * no longer in the active chain. Once it is caught up, ConnectBlock and DisconnectTip keep it in sync through
+ * IndexesBlockConnected() and IndexesBlockDisconnected(), which hand the block to every started index. Each index
+ * only says how to write and rewind one block.
+ */
+class BaseIndex
+{
+private:
+    /// Whether the index is in sync with the main chain. The flag is flipped from false to true once, after which
+    /// the validation callbacks keep the index in sync.
+    std::atomic<bool> fSynced;
+
+    /// The last block in the chain that the index is in sync with.
+    std::atomic<CBlockIndex *> pbestindex;
+
+    std::thread syncthread;
+
+    /// Initialize internal state from the database and block index.
+    bool Init();
+
+    /// Sync the index with the block index starting from the current best block, rewinding any blocks that are no
+    /// longer in the active chain first. Runs in its own thread until the index has caught up.
+    void ThreadSync();
+
+    /// Read the block and undo data for pindex from disk.
+    bool ReadBlockAndUndo(const CBlockIndex *pindex, ConstCBlockRef &pblock, CBlockUndo &blockundo);
+
+protected:
+    BaseIndex();
+
+    /// The name of the index, used for its thread and in log messages.
+    virtual const char *GetName() const = 0;
+
+    /// Read the locator of the last block written to the index.
+    virtual bool ReadBestBlock(CBlockLocator &locator) const = 0;
+
+    /// Whether RewindBlock needs the undo data of the block. When it does not, disconnecting a block from the tip
+    /// does not read it.
+    virtual bool RewindNeedsUndo() const { return true; }
+
+public:
+    /// Destructor interrupts sync thread if running and blocks until it exits.
+    virtual ~BaseIndex();
+
+    /// Add the entries of a connected block to the index.
+    virtual bool WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) = 0;
+
+    /// Remove the entries of a disconnected block from the index, making pindex->pprev its best block.
+    virtual bool RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) = 0;
+
+    /// Update the index with this newly connected block data
+    void BlockConnected(const CBlock &block, const CBlockUndo &blockundo, CBlockIndex *pindex);
+
+    /// Update the index for a block that was disconnected from the tip
+    void BlockDisconnected(const CBlock &block, CBlockIndex *pindex);
+
+    /// Is the index caught up to the current state of the block chain.
+    bool IsSynced() const { return fSynced.load(); }
+
+    /// Start initializes the sync state, begins the sync thread and adds the index to those the validation
+    /// callbacks update.
+    void Start();
+
+    /// Stops the instance from staying in sync with blockchain updates.
+    void Stop();
+};
+
+/// Hand a block connected by ConnectBlock to every started index
+void IndexesBlockConnected(const CBlock &block, const CBlockUndo &blockundo, CBlockIndex *pindex);
+
+/// Hand a block disconnected by DisconnectTip to every started index
+void IndexesBlockDisconnected(const CBlock &block, CBlockIndex *pindex);
+
+/// Stop every started index
+void StopIndexes();
+
+#endif // NEXA_INDEX_BASEINDEX_H
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/blockfilterindex.h"
+#include "undo.h"
+#include "util.h"
+#include "validation/validation.h"
+
+std::unique_ptr<BlockFilterIndex> g_blockfilterindex;
+
+bool IsBlockFilterIndexReady()
+{
+    bool fReady = false;
+    if (g_blockfilterindex)
+    {
+        fReady = g_blockfilterindex->IsSynced();
+    }
+    return fReady;
+}
+
+BlockFilterIndex::BlockFilterIndex(BlockFilterIndexDB *_db) : db(_db) {}
+bool BlockFilterIndex::ReadBestBlock(CBlockLocator &locator) const { return db->ReadBestBlock(locator); }
+bool BlockFilterIndex::WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex)
+{
+    uint256 prev_header;
+    if (pindex->pprev)
+    {
+        CBlockFilterEntry prev_entry;
+        if (!db->ReadFilter(pindex->pprev->GetBlockHash(), prev_entry))
+        {
+            return error("%s: Failed to read filter header of previous block %s", __func__,
+                pindex->pprev->GetBlockHash().ToString());
+        }
+        prev_header = prev_entry.header;
+    }
+
+    BlockFilter filter(BlockFilterType::BASIC, block, blockundo);
+    CBlockFilterEntry entry(filter.GetHash(), filter.ComputeHeader(prev_header), filter.GetEncodedFilter());
+
+    LOCK(cs_main);
+    return db->WriteFilter(pindex->GetBlockHash(), entry, chainActive.GetLocator(pindex));
+}
+
+bool BlockFilterIndex::RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex)
+{
+    // The filter of the disconnected block stays in the database, keyed by its hash, we only move the best block.
+    LOCK(cs_main);
+    return db->WriteBestBlock(chainActive.GetLocator(pindex->pprev));
+}
+
+bool BlockFilterIndex::LookupFilter(const CBlockIndex *pindex, BlockFilter &filter) const
+{
+    CBlockFilterEntry entry;
+    if (!db->ReadFilter(pindex->GetBlockHash(), entry))
+        return false;
+
+    try
+    {
+        filter = BlockFilter(BlockFilterType::BASIC, pindex->GetBlockHash(), std::move(entry.filter));
+    }
+    catch (const std::exception &e)
+    {
+        return error("%s: Failed to decode filter of block %s: %s", __func__, pindex->GetBlockHash().ToString(),
+            e.what());
+    }
+    return true;
+}
+
+bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex *pindex, uint256 &header) const
+{
+    CBlockFilterEntry entry;
+    if (!db->ReadFilter(pindex->GetBlockHash(), entry))
+        return false;
+    header = entry.header;
+    return true;
+}
+
+bool BlockFilterIndex::LookupFilterRange(int nStartHeight,
+    const CBlockIndex *pstop,
+    std::vector<BlockFilter> &filters) const
+{
+    if (nStartHeight < 0 || nStartHeight > (int)pstop->height())
+        return false;
+
+    filters.resize(pstop->height() - nStartHeight + 1);
+    const CBlockIndex *pindex = pstop;
+    for (auto it = filters.rbegin(); it != filters.rend(); ++it, pindex = pindex->pprev)
+    {
+        if (!LookupFilter(pindex, *it))
+            return false;
+    }
+    return true;
+}
+
+bool BlockFilterIndex::LookupFilterHashRange(int nStartHeight,
+    const CBlockIndex *pstop,
+    std::vector<uint256> &hashes) const
+{
+    if (nStartHeight < 0 || nStartHeight > (int)pstop->height())
+        return false;
+
+    hashes.resize(pstop->height() - nStartHeight + 1);
+    const CBlockIndex *pindex = pstop;
+    for (auto it = hashes.rbegin(); it != hashes.rend(); ++it, pindex = pindex->pprev)
+    {
+        CBlockFilterEntry entry;
+        if (!db->ReadFilter(pindex->GetBlockHash(), entry))
+            return false;
+        *it = entry.filterHash;
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_INDEX_BLOCKFILTERINDEX_H
+#define NEXA_INDEX_BLOCKFILTERINDEX_H
+
+#include "blockfilter.h"
+#include "index/baseindex.h"
+#include "txdb.h"
+#include "uint256.h"
+
+//! Interval between compact filter checkpoints, see BIP157
+static const int CFCHECKPT_INTERVAL = 1000;
+//! Maximum number of compact filters that may be requested with one getcfilters, see BIP157
+static const int MAX_GETCFILTERS_SIZE = 1000;
+//! Maximum number of compact filter headers that may be requested with one getcfheaders, see BIP157
+static const int MAX_GETCFHEADERS_SIZE = 2000;
+
+bool IsBlockFilterIndexReady();
+
+/**
+ * BlockFilterIndex builds the BIP158 basic compact filter of every block in the active chain, along with the chain
+ * of filter headers that commits to all previous filters. Light clients download these filters from us and match
+ * them locally, instead of having the node scan every block against a bloom filter for each of them.
+ *
+ * It follows the BaseIndex life cycle. Filters are stored by block hash so a reorg only has to move the best block
+ * back; the filters of the disconnected blocks stay valid for those blocks.
+ */
+class BlockFilterIndex final : public BaseIndex
+{
+private:
+    const std::unique_ptr<BlockFilterIndexDB> db;
+
+protected:
+    const char *GetName() const override { return "blockfilterindex"; }
+    bool ReadBestBlock(CBlockLocator &locator) const override;
+    bool RewindNeedsUndo() const override { return false; }
+
+public:
+    /// Constructs the BlockFilterIndex, which becomes available to be queried.
+    explicit BlockFilterIndex(BlockFilterIndexDB *db);
+
+    /// Build and store the filter and filter header of a connected block.
+    bool WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) override;
+
+    /// Move the best block back to the parent of a disconnected block. Its filter stays in the database.
+    bool RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) override;
+
+    /// Get a single filter by block.
+    bool LookupFilter(const CBlockIndex *pindex, BlockFilter &filter) const;
+
+    /// Get a single filter header by block.
+    bool LookupFilterHeader(const CBlockIndex *pindex, uint256 &header) const;
+
+    /// Get the filters of the blocks from nStartHeight up to and including pstop, which need not be in the active
+    /// chain. The filters are returned in height order.
+    bool LookupFilterRange(int nStartHeight, const CBlockIndex *pstop, std::vector<BlockFilter> &filters) const;
+
+    /// Get the filter hashes of the blocks from nStartHeight up to and including pstop, in height order.
+    bool LookupFilterHashRange(int nStartHeight, const CBlockIndex *pstop, std::vector<uint256> &hashes) const;
+};
+
+/// The global block filter index. May be null.
+extern std::unique_ptr<BlockFilterIndex> g_blockfilterindex;
+
+#endif // NEXA_INDEX_BLOCKFILTERINDEX_H
@@ -0,0 +1,17 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/indexerror.h"
+#include "init.h"
+#include "ui_interface.h"
+#include "util.h"
+
+void IndexFatalError(const std::string &strMessage)
+{
+    LOGA("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        "Error: A fatal internal error occurred, see debug.log for details", "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_INDEX_INDEXERROR_H
+#define NEXA_INDEX_INDEXERROR_H
+
+#include "tinyformat.h"
+
+#include <string>
+
+/** Log an error an index can not recover from, tell the user and shut the node down */
+void IndexFatalError(const std::string &strMessage);
+
+template <typename... Args>
+void FatalError(const char *fmt, const Args &...args)
+{
+    IndexFatalError(tfm::format(fmt, args...));
+}
+
+#endif // NEXA_INDEX_INDEXERROR_H
@@ -0,0 +1,183 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/tokenindex.h"
+#include "undo.h"
+#include "util.h"
+#include "validation/validation.h"
+
+std::unique_ptr<TokenIndex> g_tokenindex;
+
+/** Only outputs that carry a valid group are indexed */
+static bool IsIndexed(const CGroupTokenInfo &info) { return !info.invalid && info.associatedGroup != NoGroup; }
+
+/** Fetch the running totals of a group, reading them from the database the first time the group is touched by
+ *  the block being applied */
+static CTokenSupply &GetUpdateSupply(const TokenIndexDB &db, CTokenIndexUpdate &update, const CGroupTokenID &group)
+{
+    auto it = update.supplies.find(group.bytes());
+    if (it == update.supplies.end())
+    {
+        CTokenSupply supply;
+        db.ReadSupply(group.bytes(), supply);
+        it = update.supplies.emplace(group.bytes(), supply).first;
+    }
+    return it->second;
+}
+
+/** Add (fAdd) or remove one output to the running totals of its group */
+static void UpdateSupply(const TokenIndexDB &db, CTokenIndexUpdate &update, const CGroupTokenInfo &info, bool fAdd)
+{
+    CTokenSupply &supply = GetUpdateSupply(db, update, info.associatedGroup);
+    auto count = [fAdd](uint64_t &n) { n = fAdd ? n + 1 : n - 1; };
+    if (info.isAuthority())
+    {
+        count(supply.nAuthorities);
+        if (info.allowsMint())
+            count(supply.nMintAuthorities);
+        if (info.allowsMelt())
+            count(supply.nMeltAuthorities);
+    }
+    else
+    {
+        // Keep the total exact even where it does not fit a CAmount
+        const bool fFitted = supply.SupplyFitsAmount();
+        supply.AddSupply(fAdd ? info.quantity : -info.quantity);
+        if (fFitted && !supply.SupplyFitsAmount())
+            LOGA("Token index: the supply of group %s is now %s, more than an amount can hold\n",
+                EncodeGroupToken(info.associatedGroup), supply.SupplyToString());
+        count(supply.nUnspent);
+    }
+}
+
+static void WriteOutput(CTokenIndexUpdate &update,
+    const CGroupTokenInfo &info,
+    const uint256 &outpoint,
+    const Coin &coin)
+{
+    auto &entries = info.isAuthority() ? update.authorityWrite : update.unspentWrite;
+    entries.emplace_back(CTokenOutputKey(info.associatedGroup.bytes(), outpoint), coin);
+}
+
+static void EraseOutput(CTokenIndexUpdate &update, const CGroupTokenInfo &info, const uint256 &outpoint)
+{
+    auto &entries = info.isAuthority() ? update.authorityErase : update.unspentErase;
+    entries.emplace_back(info.associatedGroup.bytes(), outpoint);
+}
+
+TokenIndex::TokenIndex(TokenIndexDB *_db) : db(_db) {}
+bool TokenIndex::ReadBestBlock(CBlockLocator &locator) const { return db->ReadBestBlock(locator); }
+bool TokenIndex::WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block and undo data inconsistent", __func__);
+
+    const uint32_t nHeight = pindex->height();
+    CTokenIndexUpdate update;
+
+    // Outputs first: with canonical transaction ordering a transaction may spend an output created later in the
+    // same block, and such outputs never need to touch the database.
+    std::map<uint256, std::pair<CGroupTokenInfo, Coin> > created;
+    for (size_t i = 0; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = *block.vtx[i];
+        const uint256 idem = tx.GetIdem();
+        for (uint32_t o = 0; o < tx.vout.size(); o++)
+        {
+            const CGroupTokenInfo info(tx.vout[o].scriptPubKey);
+            if (!IsIndexed(info))
+                continue;
+            created.emplace(COutPoint(idem, o).hash, std::make_pair(info, Coin(tx.vout[o], nHeight, i == 0)));
+            UpdateSupply(*db, update, info, true);
+        }
+    }
+
+    for (size_t i = 1; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = *block.vtx[i];
+        const CTxUndo &txundo = blockundo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size())
+            return error("%s: transaction and undo data inconsistent", __func__);
+
+        for (uint32_t j = 0; j < tx.vin.size(); j++)
+        {
+            const CGroupTokenInfo info(txundo.vprevout[j].out.scriptPubKey);
+            if (!IsIndexed(info))
+                continue;
+            const uint256 &prevout = tx.vin[j].prevout.hash;
+            if (!created.erase(prevout))
+                EraseOutput(update, info, prevout);
+            UpdateSupply(*db, update, info, false);
+        }
+    }
+
+    for (const auto &entry : created)
+    {
+        WriteOutput(update, entry.second.first, entry.first, entry.second.second);
+    }
+
+    LOCK(cs_main);
+    return db->WriteUpdate(update, chainActive.GetLocator(pindex));
+}
+
+bool TokenIndex::RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block and undo data inconsistent", __func__);
+
+    CTokenIndexUpdate update;
+
+    std::set<uint256> created;
+    for (const auto &ptx : block.vtx)
+    {
+        const uint256 idem = ptx->GetIdem();
+        for (uint32_t o = 0; o < ptx->vout.size(); o++)
+        {
+            const CGroupTokenInfo info(ptx->vout[o].scriptPubKey);
+            if (!IsIndexed(info))
+                continue;
+            const uint256 outpoint = COutPoint(idem, o).hash;
+            EraseOutput(update, info, outpoint);
+            created.insert(outpoint);
+            UpdateSupply(*db, update, info, false);
+        }
+    }
+
+    for (size_t i = 1; i < block.vtx.size(); i++)
+    {
+        const CTransaction &tx = *block.vtx[i];
+        const CTxUndo &txundo = blockundo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size())
+            return error("%s: transaction and undo data inconsistent", __func__);
+
+        for (uint32_t j = 0; j < tx.vin.size(); j++)
+        {
+            const Coin &coin = txundo.vprevout[j];
+            const CGroupTokenInfo info(coin.out.scriptPubKey);
+            if (!IsIndexed(info))
+                continue;
+            const uint256 &prevout = tx.vin[j].prevout.hash;
+            if (!created.count(prevout))
+                WriteOutput(update, info, prevout, coin);
+            UpdateSupply(*db, update, info, true);
+        }
+    }
+
+    LOCK(cs_main);
+    return db->WriteUpdate(update, chainActive.GetLocator(pindex->pprev));
+}
+
+bool TokenIndex::GetSupply(const CGroupTokenID &group, CTokenSupply &supply) const
+{
+    return db->ReadSupply(group.bytes(), supply);
+}
+
+bool TokenIndex::GetUnspent(const CGroupTokenID &group,
+    bool fAuthorities,
+    const uint256 &after,
+    size_t nMax,
+    std::vector<std::pair<uint256, Coin> > &entries) const
+{
+    return db->ReadUnspent(group.bytes(), fAuthorities, after, nMax, entries);
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_INDEX_TOKENINDEX_H
+#define NEXA_INDEX_TOKENINDEX_H
+
+#include "consensus/grouptokens.h"
+#include "index/baseindex.h"
+#include "txdb.h"
+#include "uint256.h"
+
+/**
+ * TokenIndex maps every token group and subgroup to its unspent outputs and unspent authorities in the active chain,
+ * along with the running supply and authority counts of the group. This answers token explorer queries with a few
+ * database reads instead of a scan of the entire utxo set.
+ *
+ * It follows the BaseIndex life cycle. Each block is applied as a single database batch. The undo data holds every
+ * spent output, so a block can be undone again during a reorg without storing anything extra.
+ */
+class TokenIndex final : public BaseIndex
+{
+private:
+    const std::unique_ptr<TokenIndexDB> db;
+
+protected:
+    const char *GetName() const override { return "tokenindex"; }
+    bool ReadBestBlock(CBlockLocator &locator) const override;
+
+public:
+    /// Constructs the TokenIndex, which becomes available to be queried.
+    explicit TokenIndex(TokenIndexDB *db);
+
+    /// Add the token outputs of a connected block to the index and remove the ones it spent.
+    bool WriteBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) override;
+
+    /// Remove the token outputs of a disconnected block from the index and restore the outputs it spent.
+    bool RewindBlock(const CBlock &block, const CBlockUndo &blockundo, const CBlockIndex *pindex) override;
+
+    /// The running totals of a group or subgroup
+    bool GetSupply(const CGroupTokenID &group, CTokenSupply &supply) const;
+
+    /// Up to nMax unspent outputs holding tokens of a group (or its authorities if fAuthorities), starting after
+    /// outpoint hash "after"
+    bool GetUnspent(const CGroupTokenID &group,
+        bool fAuthorities,
+        const uint256 &after,
+        size_t nMax,
+        std::vector<std::pair<uint256, Coin> > &entries) const;
+};
+
+/// The global token index. May be null.
+extern std::unique_ptr<TokenIndex> g_tokenindex;
+
+#endif // NEXA_INDEX_TOKENINDEX_H
@@ -3,12 +3,12 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "index/txindex.h"
+#include "blockstorage/blockcompression.h"
 #include "blockstorage/blockstorage.h"
 #include "blockstorage/sequential_files.h"
 #include "chainparams.h"
+#include "index/indexerror.h"
 #include "init.h"
-#include "tinyformat.h"
-#include "ui_interface.h"
 #include "util.h"
 #include "validation/validation.h"
 
@@ -27,15 +27,6 @@ bool IsTxIndexReady()
     return fReady;
 }
 
-template <typename... Args>
-static void FatalError(const char *fmt, const Args &...args)
-{
-    std::string strMessage = tfm::format(fmt, args...);
-    LOGA("*** %s\n", strMessage);
-    uiInterface.ThreadSafeMessageBox(
-        "Error: A fatal internal error occurred, see debug.log for details", "", CClientUIInterface::MSG_ERROR);
-    StartShutdown();
-}
 TxIndex::TxIndex(TxIndexDB *_db) : db(_db), fSynced(false), pbestindex(nullptr) {}
 TxIndex::~TxIndex() {}
 bool TxIndex::Init()
@@ -255,9 +246,23 @@ bool TxIndex::FindTx(const uint256 &txhash, uint256 &blockhash, CTransactionRef
     CBlockHeader header;
     try
     {
-        file >> header;
-        fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-        file >> ptx;
+        std::vector<unsigned char> raw;
+        if (ReadCompressedRecord(file, raw))
+        {
+            // The offset is into the uncompressed block
+            CDataStream ss(raw, SER_DISK, CLIENT_VERSION);
+            ss >> header;
+            ss.ignore(postx.nTxOffset);
+            ss >> ptx;
+        }
+        else
+        {
+            if (fseek(file.Get(), postx.nPos, SEEK_SET))
+                return error("%s: fseek failed", __func__);
+            file >> header;
+            fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+            file >> ptx;
+        }
     }
     catch (const std::exception &e)
     {
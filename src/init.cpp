@@ -10,8 +10,12 @@
 
 #include "init.h"
 
+#include "DoubleSpendProof.h"
 #include "addrman.h"
 #include "amount.h"
+#include "blockstorage/blockcompression.h"
+#include "blockstorage/blockfilewriter.h"
+#include "blockstorage/blockindexsnapshot.h"
 #include "blockstorage/blockstorage.h"
 #include "blockstorage/sequential_files.h"
 #include "capd/capd.h"
@@ -28,6 +32,10 @@
 #include "fs.h"
 #include "httprpc.h"
 #include "httpserver.h"
+#include "index/addressindex.h"
+#include "index/baseindex.h"
+#include "index/blockfilterindex.h"
+#include "index/tokenindex.h"
 #include "index/txindex.h"
 #include "key.h"
 #include "main.h"
@@ -56,6 +64,7 @@
 #include "validation/validation.h"
 #include "validation/verifydb.h"
 #include "validationinterface.h"
+#include "workerpool.h"
 
 #ifdef ENABLE_WALLET
 #include "wallet/db.h"
@@ -163,17 +172,36 @@ public:
         }
         catch (const std::runtime_error &e)
         {
-            uiInterface.ThreadSafeMessageBox(
-                _("Error reading from database, shutting down."), "", CClientUIInterface::MSG_ERROR);
-            LOGA("Error reading from database: %s\n", e.what());
-            // Starting the shutdown sequence and returning false to the caller would be
-            // interpreted as 'entry not found' (as opposed to unable to read data), and
-            // could lead to invalid interpretation. Just exit immediately, as we can't
-            // continue anyway, and all writes should be atomic.
-            abort();
+            ReadFailed(e);
+        }
+    }
+    void GetCoins(const std::vector<COutPoint> &outpoints,
+        std::vector<Coin> &coins,
+        std::vector<bool> &found) const override
+    {
+        try
+        {
+            base->GetCoins(outpoints, coins, found);
+        }
+        catch (const std::runtime_error &e)
+        {
+            ReadFailed(e);
         }
     }
     // Writes do not need similar protection, as failure to write is handled by the caller.
+
+private:
+    [[noreturn]] static void ReadFailed(const std::runtime_error &e)
+    {
+        uiInterface.ThreadSafeMessageBox(
+            _("Error reading from database, shutting down."), "", CClientUIInterface::MSG_ERROR);
+        LOGA("Error reading from database: %s\n", e.what());
+        // Starting the shutdown sequence and returning false to the caller would be
+        // interpreted as 'entry not found' (as opposed to unable to read data), and
+        // could lead to invalid interpretation. Just exit immediately, as we can't
+        // continue anyway, and all writes should be atomic.
+        abort();
+    }
 };
 
 static CCoinsViewErrorCatcher *pcoinscatcher = nullptr;
@@ -191,6 +219,7 @@ void Interrupt()
     InterruptHTTPServer();
     InterruptHTTPRPC();
     InterruptRPC();
+    InterruptCapd();
     InterruptREST();
     InterruptTorControl();
     threadGroup.interrupt_all();
@@ -201,6 +230,7 @@ void Interrupt()
     {
         g_txindex->Stop();
     }
+    StopIndexes();
 }
 
 void Shutdown()
@@ -226,7 +256,18 @@ void Shutdown()
     StopHTTPServer();
     StopTxAdmission();
     StopNode();
+    dspVerifier.Stop();
     PV.reset(nullptr); // clean up scriptcheck threads
+    workerPool.Stop();
+#if ENABLE_ZMQ
+    // Validation has stopped, so publish what is still queued while the block files can still be read
+    if (pzmqNotificationInterface)
+    {
+        UnregisterValidationInterface(pzmqNotificationInterface);
+        delete pzmqNotificationInterface;
+        pzmqNotificationInterface = nullptr;
+    }
+#endif
 
     // This is the longest running shutdown procedure
     {
@@ -249,6 +290,9 @@ void Shutdown()
     {
         g_txindex.reset();
     }
+    g_addressindex.reset();
+    g_blockfilterindex.reset();
+    g_tokenindex.reset();
 
     StopTorControl();
     UnregisterNodeSignals(GetNodeSignals());
@@ -276,7 +320,21 @@ void Shutdown()
         LOCK(cs_main);
         if (pcoinsTip != nullptr)
         {
-            FlushStateToDisk();
+            CValidationState state;
+            const bool fFlushed = FlushStateToDisk(state, FLUSH_STATE_ALWAYS);
+            if (pblocktree != nullptr && GetBoolArg("-blockindexsnapshot", DEFAULT_BLOCKINDEX_SNAPSHOT))
+            {
+                // Only if everything was flushed does the block index in memory match the block index database.
+                // Otherwise don't write a snapshot, and don't leave an older one behind either.
+                if (fFlushed)
+                    DumpBlockIndexSnapshot(*pblocktree);
+                else
+                {
+                    LOGA("Block index was not flushed (%s), not writing a block index snapshot\n",
+                        state.GetRejectReason());
+                    RemoveBlockIndexSnapshot();
+                }
+            }
         }
         delete pcoinsTip;
         pcoinsTip = nullptr;
@@ -289,20 +347,13 @@ void Shutdown()
         delete pblockdb;
         pblockdb = nullptr;
     }
+    // The final flush above has written and synced everything that was queued
+    blockFileWriter.Stop();
 #ifdef ENABLE_WALLET
     if (pwalletMain)
         pwalletMain->Flush(true);
 #endif
 
-#if ENABLE_ZMQ
-    if (pzmqNotificationInterface)
-    {
-        UnregisterValidationInterface(pzmqNotificationInterface);
-        delete pzmqNotificationInterface;
-        pzmqNotificationInterface = nullptr;
-    }
-#endif
-
 #ifndef WIN32
     try
     {
@@ -463,7 +514,28 @@ static void ReconsiderChainOnStartup()
     }
 }
 
-void ThreadImport(std::vector<fs::path> vImportFiles, uint64_t nTxIndexCache)
+/** Create and start an index that is built from block data, if the option of its name is set.  For the same reasons
+    as the txindex this is done at the end of the import. */
+template <typename Index, typename IndexDB>
+static void StartIndex(std::unique_ptr<Index> &index,
+    const std::string &strName,
+    bool fDefault,
+    uint64_t nCacheSize)
+{
+    if (!GetBoolArg("-" + strName, fDefault))
+        return;
+
+    uiInterface.InitMessage(strprintf(_("Starting %s"), strName));
+    bool fWipeDatabase = GetBoolArg("-reindex", DEFAULT_REINDEX);
+    index = std::make_unique<Index>(new IndexDB(nCacheSize, false, fWipeDatabase));
+    index->Start();
+}
+
+void ThreadImport(std::vector<fs::path> vImportFiles,
+    uint64_t nTxIndexCache,
+    uint64_t nAddressIndexCache,
+    uint64_t nBlockFilterIndexCache,
+    uint64_t nTokenIndexCache)
 {
     const CChainParams &chainparams = Params();
     RenameThread("loadblk");
@@ -687,6 +759,13 @@ void ThreadImport(std::vector<fs::path> vImportFiles, uint64_t nTxIndexCache)
         g_txindex->Start();
     }
 
+    // The indexes built from block data, started last for the same reasons as the txindex above
+    StartIndex<AddressIndex, AddressIndexDB>(
+        g_addressindex, "addressindex", DEFAULT_ADDRESSINDEX, nAddressIndexCache);
+    StartIndex<BlockFilterIndex, BlockFilterIndexDB>(
+        g_blockfilterindex, "blockfilterindex", DEFAULT_BLOCKFILTERINDEX, nBlockFilterIndexCache);
+    StartIndex<TokenIndex, TokenIndexDB>(g_tokenindex, "tokenindex", DEFAULT_TOKENINDEX, nTokenIndexCache);
+
     // This should be done last in init. If not, then RPC's could be allowed before the wallet
     // is ready.
     uiInterface.InitMessage(_("Done loading"));
@@ -948,6 +1027,12 @@ bool AppInit2(Config &config)
     {
         if (GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX))
+            return InitError(_("Prune mode is incompatible with -addressindex."));
+        if (GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+        if (GetBoolArg("-tokenindex", DEFAULT_TOKENINDEX))
+            return InitError(_("Prune mode is incompatible with -tokenindex."));
 #ifdef ENABLE_WALLET
         if (GetBoolArg("-rescan", false))
         {
@@ -1073,6 +1158,13 @@ bool AppInit2(Config &config)
     if (GetBoolArg("-peerbloomfilters", DEFAULT_PEERBLOOMFILTERS))
         nLocalServices |= NODE_BLOOM;
 
+    if (GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS))
+    {
+        if (!GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+            return InitError(_("Cannot set -peerblockfilters without -blockfilterindex."));
+        nLocalServices |= NODE_CF;
+    }
+
     // BUIP010 Xtreme Thinblocks: begin section Initialize XTHIN service
     if (GetBoolArg("-use-thinblocks", DEFAULT_USE_THINBLOCKS))
         nLocalServices |= NODE_XTHIN;
@@ -1223,6 +1315,11 @@ bool AppInit2(Config &config)
     }
     LOGA("Using %d transaction admission threads\n", numTxAdmissionThreads.Value());
 
+    // Start the worker threads that large blocks, merkle trees and signature batches are spread across.  The thread
+    // that hands out the work takes part, so one fewer than the number of cores is needed.
+    workerPool.Start(GetNumCores() - 1, "worker");
+    LOGA("Using %d worker threads\n", workerPool.Size());
+
     InitSignatureCache();
 
     // Create the parallel block validator
@@ -1265,6 +1362,22 @@ bool AppInit2(Config &config)
         BLOCK_DB_MODE = DEFAULT_BLOCK_DB_MODE;
     }
 
+    // Records are compressed as they are written, anything already stored stays readable whatever the setting
+    BlockCompression blockCompression;
+    const std::string strBlockCompression = GetArg("-blockcompression", DEFAULT_BLOCK_COMPRESSION);
+    if (!BlockCompressionFromName(strBlockCompression, blockCompression) ||
+        !IsBlockCompressionSupported(blockCompression))
+    {
+        return InitError(strprintf(_("Unsupported -blockcompression=%s, this build supports: %s"),
+            strBlockCompression, SupportedBlockCompressionNames()));
+    }
+    SetBlockCompression(blockCompression, GetArg("-blockcompressionlevel", DEFAULT_BLOCK_COMPRESSION_LEVEL));
+    if (blockCompression != BlockCompression::NONE)
+        LOGA("Compressing blocks and undo data with %s\n", strBlockCompression);
+
+    if (BLOCK_DB_MODE == SEQUENTIAL_BLOCK_FILES && GetBoolArg("-asyncblockwrites", DEFAULT_ASYNC_BLOCK_WRITES))
+        blockFileWriter.Start();
+
     // Upgrading to 0.8; hard-link the old blknnnn.dat files into /blocks/
     if (BLOCK_DB_MODE == SEQUENTIAL_BLOCK_FILES)
     {
@@ -1307,6 +1420,10 @@ bool AppInit2(Config &config)
     LOGA("* Using %.1fMiB for block undo database\n", cacheConfig.nBlockUndoDBCache * (1.0 / 1024 / 1024));
     LOGA("* Using %.1fMiB for block index database\n", cacheConfig.nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LOGA("* Using %.1fMiB for txindex database\n", cacheConfig.nTxIndexCache * (1.0 / 1024 / 1024));
+    LOGA("* Using %.1fMiB for addressindex database\n", cacheConfig.nAddressIndexCache * (1.0 / 1024 / 1024));
+    LOGA("* Using %.1fMiB for blockfilterindex database\n",
+        cacheConfig.nBlockFilterIndexCache * (1.0 / 1024 / 1024));
+    LOGA("* Using %.1fMiB for tokenindex database\n", cacheConfig.nTokenIndexCache * (1.0 / 1024 / 1024));
     LOGA("* Using %.1fMiB for chain state database\n", cacheConfig.nCoinDBCache * (1.0 / 1024 / 1024));
     LOGA("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheMaxSize * (1.0 / 1024 / 1024));
 
@@ -1417,6 +1534,7 @@ bool AppInit2(Config &config)
             }
 
             fLoaded = true;
+            SetBlockIndexComplete(true);
         } while (false);
 
         if (!fLoaded)
@@ -1707,7 +1825,8 @@ bool AppInit2(Config &config)
         for (const std::string &strFile : mapMultiArgs["-loadblock"])
             vImportFiles.push_back(strFile);
     }
-    threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles, cacheConfig.nTxIndexCache));
+    threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles, cacheConfig.nTxIndexCache,
+        cacheConfig.nAddressIndexCache, cacheConfig.nBlockFilterIndexCache, cacheConfig.nTokenIndexCache));
 
     uiInterface.InitMessage(_("Waiting for Genesis Block..."));
     CBlockIndex *tip = nullptr;
@@ -13,6 +13,7 @@
 #include "blockrelay/mempool_sync.h"
 #include "blockrelay/thinblock.h"
 #include "blockstorage/blockcache.h"
+#include "blockstorage/blockcompression.h"
 #include "blockstorage/blockstorage.h"
 #include "blockstorage/sequential_files.h"
 #include "chainparams.h"
@@ -588,7 +589,17 @@ bool LoadExternalBlockFile(const CChainParams &chainparams, FILE *fileIn, CDiskB
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos); // Unnecessary, I just got the position
                 CBlockRef pblock1 = MakeBlockRef();
-                blkdat >> *pblock1;
+                std::vector<unsigned char> raw;
+                if (ReadCompressedRecord(blkdat, raw))
+                {
+                    CDataStream ss(raw, SER_DISK, CLIENT_VERSION);
+                    ss >> *pblock1;
+                }
+                else
+                {
+                    blkdat.SetPos(nBlockPos);
+                    blkdat >> *pblock1;
+                }
                 nRewind = blkdat.GetPos();
 
                 // detect out of order blocks, and store them for later
@@ -757,8 +768,6 @@ void MainCleanup()
 
     {
         // orphan transactions
-        WRITELOCK(orphanpool.cs_orphanpool);
-        orphanpool.mapOrphanTransactions.clear();
-        orphanpool.mapOrphanTransactionsByPrev.clear();
+        orphanpool.clear();
     }
 }
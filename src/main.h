@@ -112,6 +112,8 @@ static const bool DEFAULT_TESTSAFEMODE = false;
 static const unsigned int MAX_BLOCKS_TO_ANNOUNCE = 8;
 
 static const bool DEFAULT_PEERBLOOMFILTERS = true;
+/** Default for -peerblockfilters, serving BIP157 compact block filters */
+static const bool DEFAULT_PEERBLOCKFILTERS = false;
 
 static const bool DEFAULT_REINDEX = false;
 static const bool DEFAULT_DISCOVER = true;
@@ -10,6 +10,8 @@
 #include "hashwrapper.h"
 #include "utilstrencodings.h"
 
+#include <algorithm>
+
 using namespace std;
 
 #ifndef ANDROID // limit dependencies
@@ -70,49 +72,34 @@ CMerkleBlock::CMerkleBlock(const CBlock &block, const std::set<uint256> &txids)
     txn = CPartialMerkleTree(vHashes, vMatch);
 }
 
-uint256 CPartialMerkleTree::CalcHash(int height, unsigned int pos, const std::vector<uint256> &vTxid)
+CMerkleBlock::CMerkleBlock(const CBlockHeader &blockHeader,
+    const CMerkleTree &tree,
+    const std::vector<uint32_t> &vMatchPos)
+    : header(blockHeader), txn(tree, vMatchPos)
 {
-    if (height == 0)
-    {
-        // hash at height 0 is the txids themself
-        return vTxid[pos];
-    }
-    else
-    {
-        // calculate left hash
-        uint256 left = CalcHash(height - 1, pos * 2, vTxid), right;
-        // calculate right hash if not beyond the end of the array - copy left hash otherwise1
-        if (pos * 2 + 1 < CalcTreeWidth(height - 1))
-            right = CalcHash(height - 1, pos * 2 + 1, vTxid);
-        else
-            right = left;
-        // combine subhashes
-        return Hash(BEGIN(left), END(left), BEGIN(right), END(right));
-    }
 }
 
 void CPartialMerkleTree::TraverseAndBuild(int height,
     unsigned int pos,
-    const std::vector<uint256> &vTxid,
-    const std::vector<bool> &vMatch)
+    const CMerkleTree &tree,
+    const std::vector<uint32_t> &vMatchPos)
 {
     // determine whether this node is the parent of at least one matched txid
-    bool fParentOfMatch = false;
-    for (unsigned int p = pos << height; p < (pos + 1) << height && p < nTransactions; p++)
-        fParentOfMatch |= vMatch[p];
+    auto match = std::lower_bound(vMatchPos.begin(), vMatchPos.end(), (uint64_t)pos << height);
+    bool fParentOfMatch = match != vMatchPos.end() && *match < ((uint64_t)pos + 1) << height;
     // store as flag bit
     vBits.push_back(fParentOfMatch);
     if (height == 0 || !fParentOfMatch)
     {
         // if at height 0, or nothing interesting below, store hash and stop
-        vHash.push_back(CalcHash(height, pos, vTxid));
+        vHash.push_back(tree.GetHash(height, pos));
     }
     else
     {
         // otherwise, don't store any hash, but descend into the subtrees
-        TraverseAndBuild(height - 1, pos * 2, vTxid, vMatch);
+        TraverseAndBuild(height - 1, pos * 2, tree, vMatchPos);
         if (pos * 2 + 1 < CalcTreeWidth(height - 1))
-            TraverseAndBuild(height - 1, pos * 2 + 1, vTxid, vMatch);
+            TraverseAndBuild(height - 1, pos * 2 + 1, tree, vMatchPos);
     }
 }
 
@@ -170,20 +157,45 @@ uint256 CPartialMerkleTree::TraverseAndExtract(int height,
     }
 }
 
+/** The positions of the set bits of vMatch that are below nTransactions, in increasing order */
+static std::vector<uint32_t> MatchedPositions(const std::vector<bool> &vMatch, size_t nTransactions)
+{
+    std::vector<uint32_t> vMatchPos;
+    for (uint32_t p = 0; p < vMatch.size() && p < nTransactions; p++)
+    {
+        if (vMatch[p])
+            vMatchPos.push_back(p);
+    }
+    return vMatchPos;
+}
+
 CPartialMerkleTree::CPartialMerkleTree(const std::vector<uint256> &vTxid, const std::vector<bool> &vMatch)
-    : nTransactions(vTxid.size()), fBad(false)
+    : CPartialMerkleTree(CMerkleTree(vTxid), MatchedPositions(vMatch, vTxid.size()))
+{
+}
+
+CPartialMerkleTree::CPartialMerkleTree(const CMerkleTree &tree, const std::vector<uint32_t> &vMatchPos)
+    : nTransactions(tree.GetNumLeaves()), fBad(false)
 {
     // reset state
     vBits.clear();
     vHash.clear();
 
+    // an empty tree has nothing to traverse
+    if (nTransactions == 0)
+    {
+        vBits.push_back(false);
+        vHash.push_back(uint256());
+        return;
+    }
+
     // calculate height of tree
     int nHeight = 0;
     while (CalcTreeWidth(nHeight) > 1)
         nHeight++;
 
     // traverse the partial tree
-    TraverseAndBuild(nHeight, 0, vTxid, vMatch);
+    TraverseAndBuild(nHeight, 0, tree, vMatchPos);
 }
 
 CPartialMerkleTree::CPartialMerkleTree() : nTransactions(0), fBad(true) {}
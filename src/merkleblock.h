@@ -8,6 +8,7 @@
 #define NEXA_MERKLEBLOCK_H
 
 #include "bloom.h"
+#include "consensus/merkle.h"
 #include "primitives/block.h"
 #include "serialize.h"
 #include "uint256.h"
@@ -65,14 +66,12 @@ protected:
 
     /** helper function to efficiently calculate the number of nodes at given height in the merkle tree */
     unsigned int CalcTreeWidth(int height) { return (nTransactions + (1 << height) - 1) >> height; }
-    /** calculate the hash of a node in the merkle tree (at leaf level: the txid's themselves) */
-    uint256 CalcHash(int height, unsigned int pos, const std::vector<uint256> &vTxid);
 
     /** recursive function that traverses tree nodes, storing the data as bits and hashes */
     void TraverseAndBuild(int height,
         unsigned int pos,
-        const std::vector<uint256> &vTxid,
-        const std::vector<bool> &vMatch);
+        const CMerkleTree &tree,
+        const std::vector<uint32_t> &vMatchPos);
 
     /**
      * recursive function that traverses tree nodes, consuming the bits and hashes produced by TraverseAndBuild.
@@ -116,6 +115,12 @@ public:
     /** Construct a partial merkle tree from a list of transaction ids, and a mask that selects a subset of them */
     CPartialMerkleTree(const std::vector<uint256> &vTxid, const std::vector<bool> &vMatch);
 
+    /**
+     * Construct a partial merkle tree from a complete one, selecting the leaves at the sorted positions vMatchPos.
+     * No hashing is needed, so this takes O(log n) per selected leaf.
+     */
+    CPartialMerkleTree(const CMerkleTree &tree, const std::vector<uint32_t> &vMatchPos);
+
     CPartialMerkleTree();
 
     /**
@@ -155,6 +160,10 @@ public:
      */
     CMerkleBlock(const CBlock &block, const std::set<uint256> &txids);
 
+    /** Create from the header and merkle tree of a block, matching the transactions at the sorted positions
+     */
+    CMerkleBlock(const CBlockHeader &blockHeader, const CMerkleTree &tree, const std::vector<uint32_t> &vMatchPos);
+
     CMerkleBlock() {}
     ADD_SERIALIZE_METHODS;
 
@@ -22,6 +22,7 @@
 #include "electrum/rostrum.h"
 #include "expedited.h"
 #include "extversionkeys.h"
+#include "index/blockfilterindex.h"
 #include "main.h"
 #include "merkleblock.h"
 #include "nodestate.h"
@@ -401,6 +402,167 @@ static void enableCompactBlocks(CNode *pfrom)
     }
 }
 
+/**
+ * Validate a BIP157 getcfilters, getcfheaders or getcfcheckpt request. Peers that ask for filters we never
+ * advertised or for malformed ranges are disconnected, as BIP157 requires.
+ *
+ * @param[in]  pfrom            The peer that sent the request
+ * @param[in]  filter_type      The filter type the request is for. Must be basic filters.
+ * @param[in]  start_height     The start height for the request
+ * @param[in]  stop_hash        The stop_hash for the request
+ * @param[in]  max_height_diff  The maximum number of items permitted to request, as specified in BIP 157
+ * @param[out] pstop            The CBlockIndex for the stop_hash block, if the request can be serviced.
+ * @return                      True if the request can be serviced.
+ */
+static bool PrepareBlockFilterRequest(CNode *pfrom,
+    BlockFilterType filter_type,
+    uint32_t start_height,
+    const uint256 &stop_hash,
+    uint32_t max_height_diff,
+    const CBlockIndex *&pstop)
+{
+    if (!(nLocalServices & NODE_CF) || filter_type != BlockFilterType::BASIC)
+    {
+        LOG(NET, "peer %s requested unsupported block filter type: %d\n", pfrom->GetLogName(),
+            static_cast<uint8_t>(filter_type));
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    // The index may still be catching up after startup, in which case the request is simply not answered.
+    if (!IsBlockFilterIndexReady())
+        return false;
+
+    pstop = LookupBlockIndex(stop_hash);
+    if (!pstop)
+    {
+        LOG(NET, "peer %s requested block filters for unknown block %s\n", pfrom->GetLogName(), stop_hash.ToString());
+        pfrom->fDisconnect = true;
+        return false;
+    }
+    {
+        LOCK(cs_main);
+        if (!chainActive.Contains(pstop))
+        {
+            LOG(NET, "peer %s requested block filters for block %s which is not in the active chain\n",
+                pfrom->GetLogName(), stop_hash.ToString());
+            return false;
+        }
+    }
+
+    uint32_t stop_height = pstop->height();
+    if (start_height > stop_height)
+    {
+        LOG(NET, "peer %s sent invalid getcfilters/getcfheaders with start height %d and stop height %d\n",
+            pfrom->GetLogName(), start_height, stop_height);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+    if (stop_height - start_height >= max_height_diff)
+    {
+        LOG(NET, "peer %s requested too many cfilters/cfheaders: %d / %d\n", pfrom->GetLogName(),
+            stop_height - start_height + 1, max_height_diff);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+    return true;
+}
+
+/** Answer a getcfilters request with one cfilter message per block in the requested range */
+static void ProcessGetCFilters(CNode *pfrom, CDataStream &vRecv)
+{
+    uint8_t filter_type_ser;
+    uint32_t start_height;
+    uint256 stop_hash;
+    vRecv >> filter_type_ser >> start_height >> stop_hash;
+
+    const BlockFilterType filter_type = static_cast<BlockFilterType>(filter_type_ser);
+    const CBlockIndex *pstop = nullptr;
+    if (!PrepareBlockFilterRequest(pfrom, filter_type, start_height, stop_hash, MAX_GETCFILTERS_SIZE, pstop))
+        return;
+
+    std::vector<BlockFilter> filters;
+    if (!g_blockfilterindex->LookupFilterRange(start_height, pstop, filters))
+    {
+        LOG(NET, "Failed to find block filter in index: filter_type=%s, start_height=%d, stop_hash=%s\n",
+            BlockFilterTypeName(filter_type), start_height, stop_hash.ToString());
+        return;
+    }
+
+    for (const auto &filter : filters)
+    {
+        pfrom->PushMessage(NetMsgType::CFILTER, filter);
+    }
+}
+
+/** Answer a getcfheaders request with the filter header before the range and the filter hashes in the range */
+static void ProcessGetCFHeaders(CNode *pfrom, CDataStream &vRecv)
+{
+    uint8_t filter_type_ser;
+    uint32_t start_height;
+    uint256 stop_hash;
+    vRecv >> filter_type_ser >> start_height >> stop_hash;
+
+    const BlockFilterType filter_type = static_cast<BlockFilterType>(filter_type_ser);
+    const CBlockIndex *pstop = nullptr;
+    if (!PrepareBlockFilterRequest(pfrom, filter_type, start_height, stop_hash, MAX_GETCFHEADERS_SIZE, pstop))
+        return;
+
+    uint256 prev_header;
+    if (start_height > 0)
+    {
+        const CBlockIndex *pprev = pstop->GetAncestor(start_height - 1);
+        if (!g_blockfilterindex->LookupFilterHeader(pprev, prev_header))
+        {
+            LOG(NET, "Failed to find block filter header in index: filter_type=%s, block_hash=%s\n",
+                BlockFilterTypeName(filter_type), pprev->GetBlockHash().ToString());
+            return;
+        }
+    }
+
+    std::vector<uint256> filter_hashes;
+    if (!g_blockfilterindex->LookupFilterHashRange(start_height, pstop, filter_hashes))
+    {
+        LOG(NET, "Failed to find block filter hashes in index: filter_type=%s, start_height=%d, stop_hash=%s\n",
+            BlockFilterTypeName(filter_type), start_height, stop_hash.ToString());
+        return;
+    }
+
+    pfrom->PushMessage(NetMsgType::CFHEADERS, filter_type_ser, pstop->GetBlockHash(), prev_header, filter_hashes);
+}
+
+/** Answer a getcfcheckpt request with the filter header of every CFCHECKPT_INTERVAL'th block up to the stop block */
+static void ProcessGetCFCheckPt(CNode *pfrom, CDataStream &vRecv)
+{
+    uint8_t filter_type_ser;
+    uint256 stop_hash;
+    vRecv >> filter_type_ser >> stop_hash;
+
+    const BlockFilterType filter_type = static_cast<BlockFilterType>(filter_type_ser);
+    const CBlockIndex *pstop = nullptr;
+    if (!PrepareBlockFilterRequest(
+            pfrom, filter_type, /*start_height=*/0, stop_hash, std::numeric_limits<uint32_t>::max(), pstop))
+        return;
+
+    std::vector<uint256> headers(pstop->height() / CFCHECKPT_INTERVAL);
+
+    // Populate headers from the highest checkpoint down, walking back along the stop block's chain.
+    const CBlockIndex *pindex = pstop;
+    for (int i = headers.size() - 1; i >= 0; i--)
+    {
+        int height = (i + 1) * CFCHECKPT_INTERVAL;
+        pindex = pindex->GetAncestor(height);
+        if (!g_blockfilterindex->LookupFilterHeader(pindex, headers[i]))
+        {
+            LOG(NET, "Failed to find block filter header in index: filter_type=%s, block_hash=%s\n",
+                BlockFilterTypeName(filter_type), pindex->GetBlockHash().ToString());
+            return;
+        }
+    }
+
+    pfrom->PushMessage(NetMsgType::CFCHECKPT, filter_type_ser, pstop->GetBlockHash(), headers);
+}
+
 bool ProcessMessage(CNode *pfrom, std::string strCommand, CDataStream &vRecv, int64_t nStopwatchTimeReceived)
 {
     int64_t receiptTime = GetTime();
@@ -1974,6 +2136,21 @@ bool ProcessMessage(CNode *pfrom, std::string strCommand, CDataStream &vRecv, in
         pfrom->fRelayTxes = true;
     }
 
+    else if (strCommand == NetMsgType::GETCFILTERS)
+    {
+        ProcessGetCFilters(pfrom, vRecv);
+    }
+
+    else if (strCommand == NetMsgType::GETCFHEADERS)
+    {
+        ProcessGetCFHeaders(pfrom, vRecv);
+    }
+
+    else if (strCommand == NetMsgType::GETCFCHECKPT)
+    {
+        ProcessGetCFCheckPt(pfrom, vRecv);
+    }
+
     else if (strCommand == NetMsgType::DSPROOF)
     {
         if (doubleSpendProofs.Value() == true)
@@ -1989,40 +2166,27 @@ bool ProcessMessage(CNode *pfrom, std::string strCommand, CDataStream &vRecv, in
 
                 dspHash = dsp.GetHash();
                 DoubleSpendProof::Validity validity;
+                DoubleSpendProof::SpentOutput spent;
                 {
                     READLOCK(mempool.cs_txmempool);
-                    validity = dsp.validate(mempool);
+                    validity = dsp.prepareValidation(mempool, nullptr, spent);
+                }
+                bool fQueued = false;
+                if (validity == DoubleSpendProof::Valid)
+                {
+                    // Leave the signature checks to the verification threads unless their queue is full
+                    fQueued = dspVerifier.Enqueue(dsp, spent, pfrom->GetId());
+                    if (!fQueued)
+                        validity = dsp.checkSignatures(spent);
                 }
                 switch (validity)
                 {
                 case DoubleSpendProof::Valid:
-                {
+                    if (fQueued)
+                        break;
                     LOG(DSPROOF, "Double spend proof is valid from peer:%d\n", pfrom->GetId());
-                    const auto ptx = mempool.addDoubleSpendProof(dsp);
-                    if (ptx.get())
-                    {
-                        // find any descendants of this double spent transaction. If there are any
-                        // then we must also forward this double spend proof to any SPV peers that
-                        // want to know about this tx or its descendants.
-                        CTxMemPool::setEntries setDescendants;
-                        {
-                            READLOCK(mempool.cs_txmempool);
-                            CTxMemPool::indexed_transaction_set::const_iterator iter = mempool.mapTx.find(ptx->GetId());
-                            if (iter == mempool.mapTx.end())
-                            {
-                                break;
-                            }
-                            else
-                            {
-                                mempool._CalculateDescendants(iter, setDescendants);
-                            }
-                        }
-
-                        // added to mempool correctly, then forward to nodes.
-                        broadcastDspInv(ptx, dspHash, &setDescendants);
-                    }
+                    AcceptDoubleSpendProof(dsp);
                     break;
-                }
                 case DoubleSpendProof::MissingUTXO:
                 case DoubleSpendProof::MissingTransaction:
                     LOG(DSPROOF, "Double spend proof is orphan: postponed\n");
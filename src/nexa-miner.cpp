@@ -12,6 +12,7 @@
 #include "chainparams.h"
 #include "chainparamsbase.h"
 #include "consensus/params.h"
+#include "crypto/sha256.h"
 #include "fs.h"
 #include "hashwrapper.h"
 #include "key.h"
@@ -25,6 +26,7 @@
 #include "util.h"
 #include "utilstrencodings.h"
 
+#include <atomic>
 #include <cstdlib>
 #include <functional>
 #include <random>
@@ -107,8 +109,8 @@ public:
                 _("The address to send the newly generated nexa to. If omitted, will default to an address in the "
                   "nexa daemon's wallet."))
             .addArg("deterministic[=boolean]", ::AllowedArgs::optionalBool,
-                _("Instead of starting at a random nonce, start with 0x0N000001, where N is the thread number."
-                  "  Default is false."));
+                _("Instead of starting at a random nonce, start every thread's nonce counter at 1.  The last nonce "
+                  "byte is always the thread number.  Default is false."));
     }
 };
 
@@ -178,63 +180,46 @@ static bool CpuMinerJsonToData(const UniValue &params, uint256 &headerCommitment
     return true;
 }
 
+// Nonces are a 56 bit little-endian counter followed by the thread number, so no two threads search the same nonces
+static const unsigned int MINER_NONCE_SIZE = 8;
+static const unsigned int MINER_NONCE_COUNTER_BYTES = MINER_NONCE_SIZE - 1;
+
+// The cheap hash of the last header commitment that any thread solved.  Threads poll it between hash batches
+// (no lock needed) and stop searching a commitment as soon as another thread has found its solution.
+static std::atomic<uint64_t> solvedCommitment{0};
+
 static bool CpuMineBlockHasherNextChain(int &ntries,
-    uint256 headerCommitment,
-    uint32_t nBits,
-    const RandFunc &randFunc,
+    CMiningHasher &hasher,
+    const arith_uint256 &hashTarget,
     const Consensus::Params &conp,
-    uint32_t &count,
-    uint32_t rollAt,
-    uint32_t extra,
+    uint64_t &count,
+    uint64_t commitmentId,
     std::vector<unsigned char> &nonce)
 {
-    arith_uint256 hashTarget = arith_uint256().SetCompact(nBits);
-    bool found = false;
-
-    /* Eventually when hashing performance improved dramatically we may need to start with 6 bytes.
-
-    // Note that since I have a coinbase that is unique to my hashing effort, my hashing won't duplicate a competitor's
-    // efforts.  And a new candidate is generated every 30 seconds, so my hashing won't conflict with my earlier self.
-    // So it does not matter that we all start with few nonce bits.
-    if (nonce.size() < 6) nonce.resize(6);
-
-    //uint32_t startCount = randFunc();
-    nonce[4] = extra & 255;
-    nonce[5] = (extra >> 8) & 255;
-    */
-
-    if (nonce.size() < 4)
-        nonce.resize(4);
-
-    nonce[3] = extra & 255;
-
-    while (!found)
+    uint256 hashes[CMiningHasher::BATCH_SIZE];
+    while (ntries > 0)
     {
-        // Search
-        while (!found)
+        if (solvedCommitment.load(std::memory_order_relaxed) == commitmentId)
+            return false; // Another thread found it
+        hasher.HashBatch(count, hashes);
+        for (unsigned int i = 0; i < CMiningHasher::BATCH_SIZE; i++)
         {
-            ++count;
-            nonce[0] = count & 255;
-            nonce[1] = (count >> 8) & 255;
-            nonce[2] = (count >> 16) & 255;
-
-            uint256 miningHash = GetMiningHash(headerCommitment, nonce);
-            if (CheckProofOfWork(miningHash, nBits, conp))
+            if (CheckProofOfWorkTarget(hashes[i], hashTarget, conp))
             {
                 // Found a solution
-                found = true;
+                nonce = hasher.Nonce(count + i);
+                count += i + 1;
+                ntries -= i + 1;
+                solvedCommitment.store(commitmentId);
                 printf("%s: proof-of-work found  \n  mining puzzle solution: %s  \ntarget: %s\n", now().c_str(),
-                    miningHash.GetHex().c_str(), hashTarget.GetHex().c_str());
-                break;
-            }
-            if (ntries-- < 1)
-            {
-                return false; // Give up leave
+                    hashes[i].GetHex().c_str(), hashTarget.GetHex().c_str());
+                return true;
             }
         }
+        count += CMiningHasher::BATCH_SIZE;
+        ntries -= CMiningHasher::BATCH_SIZE;
     }
-
-    return found;
+    return false; // Give up leave
 }
 
 static double GetDifficulty(uint32_t nBits)
@@ -305,6 +290,12 @@ static UniValue CpuMineBlock(unsigned int searchDuration, bool &found, const Ran
         MilliSleep(1000);
         return ret;
     }
+    // Another thread solved this candidate and is fetching the next one
+    if (solvedCommitment.load() == headerCommitment.GetCheapHash())
+    {
+        MilliSleep(100);
+        return ret;
+    }
 
     // first check difficulty, and abort if it's lower than maxdifficulty from CLI
     const double difficulty = GetDifficulty(nBits);
@@ -343,17 +334,27 @@ static UniValue CpuMineBlock(unsigned int searchDuration, bool &found, const Ran
     printf("%s: Mining: id: %x headerCommitment: %s bits: %x difficulty: %3.4f\n", now().c_str(),
         (unsigned int)id.get_int64(), headerCommitment.ToString().c_str(), nBits, difficulty);
 
+    arith_uint256 hashTarget;
+    if (!GetProofOfWorkTarget(nBits, conp, hashTarget))
+    {
+        printf("%s: Invalid target bits: %x\n", now().c_str(), nBits);
+        MilliSleep(1000);
+        return ret;
+    }
+
     int64_t start = GetTimeMillis();
-    std::vector<unsigned char> nonce;
-    int ChunkAmt = 10000;
+    std::vector<unsigned char> nonce(MINER_NONCE_SIZE, 0);
+    nonce[MINER_NONCE_SIZE - 1] = threadNum & 255;
+    const int ChunkAmt = 320 * CMiningHasher::BATCH_SIZE;
     int checked = 0;
-    uint32_t startCount = 1;
+    uint64_t count = 1;
     if (!deterministicStartCount)
-        startCount = randFunc();
-    uint32_t rollAt = startCount - 1;
+        count = ((uint64_t)randFunc() << 32) | randFunc();
+    CMiningHasher hasher(headerCommitment, nonce, MINER_NONCE_COUNTER_BYTES);
     const BlkInfo blkInfo = {headerCommitment.GetCheapHash(), nBits};
 
-    while ((GetTimeMillis() < start + searchDuration) && !found && sharedBlkInfo == blkInfo)
+    while ((GetTimeMillis() < start + searchDuration) && !found && sharedBlkInfo == blkInfo &&
+           solvedCommitment.load(std::memory_order_relaxed) != blkInfo.prevCheapHash)
     {
         // When mining mainnet, you would normally want to advance the time to keep the block time as close to the
         // real time as possible.  However, this CPU miner is only useful on testnet and in testnet the block difficulty
@@ -362,8 +363,7 @@ static UniValue CpuMineBlock(unsigned int searchDuration, bool &found, const Ran
         // request a new block).
         // header.nTime = (header.nTime < GetTime()) ? GetTime() : header.nTime;
         int tries = ChunkAmt;
-        found = CpuMineBlockHasherNextChain(
-            tries, headerCommitment, nBits, randFunc, conp, startCount, rollAt, threadNum, nonce);
+        found = CpuMineBlockHasherNextChain(tries, hasher, hashTarget, conp, count, blkInfo.prevCheapHash, nonce);
         checked += ChunkAmt - tries;
     }
 
@@ -372,12 +372,12 @@ static UniValue CpuMineBlock(unsigned int searchDuration, bool &found, const Ran
     if (!found)
     {
         const float elapsed = GetTimeMillis() - start;
-        printf("%s: Checked %d possibilities in %5.1f secs, %3.3f MH/s\n", rightnow.c_str(), checked, elapsed / 1000,
-            (checked / 1e6) / (elapsed / 1e3));
+        printf("%s: Thread %d checked %d possibilities in %5.1f secs, %3.3f MH/s\n", rightnow.c_str(), threadNum,
+            checked, elapsed / 1000, (checked / 1e6) / (elapsed / 1e3));
         return ret;
     }
 
-    printf("%s: Solution! Checked %d possibilities\n", rightnow.c_str(), checked);
+    printf("%s: Thread %d solution! Checked %d possibilities\n", rightnow.c_str(), threadNum, checked);
 
     UniValue tmp(UniValue::VOBJ);
     tmp.pushKV("id", id);
@@ -817,6 +817,7 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
     SelectParams(ChainNameFromCommandLine());
+    printf("%s: Using the '%s' SHA256 implementation\n", now().c_str(), SHA256AutoDetect().c_str());
 
     // Launch miner threads
     int nThreads = GetArg("-cpus", 1);
@@ -13,6 +13,9 @@
 #include "uint256.h"
 #include "util.h"
 #include "validation/forks.h"
+
+#include <algorithm>
+
 static std::atomic<const CBlockIndex *> cachedAnchor{nullptr};
 
 void ResetASERTAnchorBlockCache() noexcept { cachedAnchor = nullptr; }
@@ -230,6 +233,7 @@ arith_uint256 CalculateASERT(const arith_uint256 &refTarget,
 
 #include "crypto/sha256.h"
 #include "key.h"
+#include "streams.h"
 
 uint32_t GetNextWorkRequired(const CBlockIndex *pindexPrev, const CBlockHeader *pblock, const Consensus::Params &params)
 {
@@ -259,40 +263,93 @@ static uint256 sha256(uint256 data)
     return ret;
 }
 
+CMiningHasher::CMiningHasher(const uint256 &headerCommitment,
+    const std::vector<unsigned char> &nonce,
+    unsigned int counterBytesIn)
+    : nonceTemplate(nonce), counterBytes(std::min<unsigned int>({counterBytesIn, (unsigned int)nonce.size(), 8}))
+{
+    assert(nonce.size() <= CBlockHeader::MAX_NONCE_SIZE);
+    // Serialize exactly as GetMiningHash does, then remember where the nonce bytes are
+    CDataStream ss(SER_GETHASH, 0);
+    ss << headerCommitment << nonce;
+    msgLen = ss.size();
+    noncePos = msgLen - nonce.size();
+    messages.resize(msgLen * BATCH_SIZE);
+    for (unsigned int i = 0; i < BATCH_SIZE; i++)
+    {
+        std::copy(ss.begin(), ss.end(), messages.begin() + i * msgLen);
+        inputs[i] = &messages[i * msgLen];
+        lengths[i] = msgLen;
+    }
+}
+
+void CMiningHasher::HashBatch(uint64_t counter, uint256 *hashes)
+{
+    for (unsigned int i = 0; i < BATCH_SIZE; i++)
+    {
+        unsigned char *dest = &messages[i * msgLen + noncePos];
+        const uint64_t c = counter + i;
+        for (unsigned int x = 0; x < counterBytes; x++)
+            dest[x] = (c >> (x * 8)) & 255;
+    }
+    static_assert(sizeof(uint256) == 32, "SHA256DMulti writes 32 bytes per hash");
+    SHA256DMulti(hashes[0].begin(), inputs, lengths, BATCH_SIZE);
+}
+
+std::vector<unsigned char> CMiningHasher::Nonce(uint64_t counter) const
+{
+    std::vector<unsigned char> ret(nonceTemplate);
+    for (unsigned int x = 0; x < counterBytes; x++)
+        ret[x] = (counter >> (x * 8)) & 255;
+    return ret;
+}
+
 bool MineBlock(CBlockHeader &blockHeader, unsigned long int tries, const Consensus::Params &cparams)
 {
     assert(blockHeader.size != 0); // Size must be properly calculated before we can figure out the hash
-    unsigned long int count = 0;
-    for (unsigned int x = 0; x < 8; x++)
-        if (x < blockHeader.nonce.size())
-            count = count | (blockHeader.nonce[x] << (x * 8));
+    const unsigned int counterBytes = std::min<size_t>(blockHeader.nonce.size(), 8);
+    uint64_t count = 0;
+    for (unsigned int x = 0; x < counterBytes; x++)
+        count = count | ((uint64_t)blockHeader.nonce[x] << (x * 8));
 
-    uint256 headerCommitment = blockHeader.GetMiningHeaderCommitment();
+    arith_uint256 target;
+    if (!GetProofOfWorkTarget(blockHeader.nBits, cparams, target))
+        return false;
 
+    CMiningHasher hasher(blockHeader.GetMiningHeaderCommitment(), blockHeader.nonce, counterBytes);
+    uint256 hashes[CMiningHasher::BATCH_SIZE];
     while (tries > 0)
     {
-        uint256 mhash = ::GetMiningHash(headerCommitment, blockHeader.nonce);
-        if (CheckProofOfWork(mhash, blockHeader.nBits, cparams))
+        const unsigned int batch = std::min<unsigned long int>(tries, CMiningHasher::BATCH_SIZE);
+        hasher.HashBatch(count, hashes);
+        for (unsigned int i = 0; i < batch; i++)
         {
-            // printf("pow hash: %s\n", mhash.GetHex().c_str());
-            return true;
+            if (CheckProofOfWorkTarget(hashes[i], target, cparams))
+            {
+                blockHeader.nonce = hasher.Nonce(count + i);
+                return true;
+            }
         }
-        ++count;
-        for (unsigned int x = 0; x < 8; x++)
-            if (x < blockHeader.nonce.size())
-                blockHeader.nonce[x] = (count >> (x * 8)) & 255;
-        tries--;
+        count += batch;
+        tries -= batch;
     }
+    blockHeader.nonce = hasher.Nonce(count);
     return false;
 }
 
 
-bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params &params)
+bool GetProofOfWorkTarget(unsigned int nBits, const Consensus::Params &params, arith_uint256 &target)
 {
     bool fNegative;
     bool fOverflow;
-    arith_uint256 bnTarget;
+    target.SetCompact(nBits, &fNegative, &fOverflow);
+
+    // Check range
+    return !(fNegative || target == 0 || fOverflow || target > UintToArith256(params.powLimit));
+}
 
+bool CheckProofOfWorkTarget(uint256 hash, const arith_uint256 &target, const Consensus::Params &params)
+{
     if (params.powAlgorithm == 1)
     {
         // This algorithm uses the hash as a priv key to sign sha256(hash) using deterministic k.
@@ -314,17 +371,16 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params
         sha.Finalize(hash.begin());
     }
 
-    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
-
-    // Check range
-    if (fNegative || bnTarget == 0 || fOverflow || bnTarget > UintToArith256(params.powLimit))
-        return false;
-
     // Check proof of work matches claimed amount
-    if (UintToArith256(hash) > bnTarget)
-        return false;
+    return UintToArith256(hash) <= target;
+}
 
-    return true;
+bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params &params)
+{
+    arith_uint256 bnTarget;
+    if (!GetProofOfWorkTarget(nBits, params, bnTarget))
+        return false;
+    return CheckProofOfWorkTarget(hash, bnTarget, params);
 }
 
 arith_uint256 GetBlockProof(const CBlockIndex &block) { return GetWorkForDifficultyBits(block.tgtBits()); }
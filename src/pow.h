@@ -10,12 +10,47 @@
 #include "consensus/params.h"
 
 #include <stdint.h>
+#include <vector>
 
 class CBlockHeader;
 class CBlockIndex;
 class uint256;
 class arith_uint256;
 
+/** Computes the mining hash (see GetMiningHash) of many nonces that share one header commitment.
+    The serialized commitment and nonce are laid out once per batch slot and only the counter bytes of each nonce
+    are rewritten, so a whole batch goes through a single SHA256DMulti call (two messages side by side on CPUs that
+    support it).  The message is shorter than one SHA256 block, so there is no fixed prefix whose midstate could be
+    reused between nonces.
+ */
+class CMiningHasher
+{
+public:
+    //! The number of nonces hashed by each HashBatch call
+    static const unsigned int BATCH_SIZE = 32;
+
+    /** nonce gives the nonce size and the bytes that stay fixed.  Its first counterBytes bytes (at most 8) hold a
+        little-endian counter that HashBatch and Nonce fill in. */
+    CMiningHasher(const uint256 &headerCommitment, const std::vector<unsigned char> &nonce, unsigned int counterBytes);
+
+    /** Hash the BATCH_SIZE nonces whose counters start at counter: hashes[i] is the mining hash of
+        Nonce(counter + i).  Counters wrap around within counterBytes. */
+    void HashBatch(uint64_t counter, uint256 *hashes);
+
+    //! The nonce holding this counter value
+    std::vector<unsigned char> Nonce(uint64_t counter) const;
+
+private:
+    std::vector<unsigned char> nonceTemplate;
+    unsigned int counterBytes;
+    //! Offset of the nonce bytes within each message
+    size_t noncePos;
+    size_t msgLen;
+    std::vector<unsigned char> messages;
+    const unsigned char *inputs[BATCH_SIZE];
+    size_t lengths[BATCH_SIZE];
+};
+
 /* Solve this block.  Not for performance use. The function modifies the nonce but does not change its size.
    NOTE: if nonce size is 0 or small, there may be no solution ever found!
  */
@@ -51,6 +86,10 @@ unsigned int GetNextWorkRequired(const CBlockIndex *pindexLast, const CBlockHead
 
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params &);
+/** Decode nBits into the target that a mining hash must not exceed.  Returns false if nBits is not a valid target */
+bool GetProofOfWorkTarget(unsigned int nBits, const Consensus::Params &, arith_uint256 &target);
+/** CheckProofOfWork against a target already decoded by GetProofOfWorkTarget, for loops that test many hashes */
+bool CheckProofOfWorkTarget(uint256 hash, const arith_uint256 &target, const Consensus::Params &);
 /** Get block's work: that is the work equivalent for the nBits of difficulty specified in this block */
 arith_uint256 GetBlockProof(const CBlockIndex &block);
 
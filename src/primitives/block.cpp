@@ -14,6 +14,10 @@
 #include "streams.h"
 #include "tinyformat.h"
 #include "utilstrencodings.h"
+#include "workerpool.h"
+
+#include <cstring>
+#include <exception>
 
 uint256 SatoshiBlockHeader::GetHash() const { return SerializeHash(*this); }
 
@@ -132,3 +136,132 @@ arith_uint256 GetWorkForDifficultyBits(uint32_t nBits)
     // or ~bnTarget / (nTarget+1) + 1.
     return (~bnTarget / (bnTarget + 1)) + 1;
 }
+
+
+namespace
+{
+/** Reads serialized objects out of a range of memory that belongs to a CDataStream */
+class CSpanReader
+{
+private:
+    const char *pos;
+    const char *end;
+    const int nType;
+    const int nVersion;
+
+public:
+    CSpanReader(const char *begin, const char *endIn, int nTypeIn, int nVersionIn)
+        : pos(begin), end(endIn), nType(nTypeIn), nVersion(nVersionIn)
+    {
+    }
+    int GetType() const { return nType; }
+    int GetVersion() const { return nVersion; }
+    const char *Pos() const { return pos; }
+    bool empty() const { return pos == end; }
+
+    void read(char *pch, size_t nSize)
+    {
+        ignore(nSize);
+        memcpy(pch, pos - nSize, nSize);
+    }
+
+    void ignore(uint64_t nSize)
+    {
+        if (nSize > (uint64_t)(end - pos))
+            throw std::ios_base::failure("CSpanReader::read(): end of data");
+        pos += nSize;
+    }
+
+    template <typename T>
+    CSpanReader &operator>>(T &obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
+/** Move past one serialized transaction.  This follows the layout that CTransaction::Unserialize reads. */
+void SkipTransaction(CSpanReader &r)
+{
+    r.ignore(1); // nVersion
+    const uint64_t nIn = ReadCompactSize(r);
+    for (uint64_t i = 0; i < nIn; i++)
+    {
+        r.ignore(1 + 32); // type, prevout
+        r.ignore(ReadCompactSize(r)); // scriptSig
+        r.ignore(4 + 8); // nSequence, amount
+    }
+    const uint64_t nOut = ReadCompactSize(r);
+    for (uint64_t i = 0; i < nOut; i++)
+    {
+        r.ignore(1 + 8); // type, nValue
+        r.ignore(ReadCompactSize(r)); // scriptPubKey
+    }
+    r.ignore(4); // nLockTime
+}
+
+/** Deserialize the transactions from nBegin up to nEnd, whose start positions are known */
+void DeserializeRange(const std::vector<const char *> &starts,
+    std::vector<CTransactionRef> &vtx,
+    uint64_t nBegin,
+    uint64_t nEnd,
+    int nType,
+    int nVersion)
+{
+    for (uint64_t i = nBegin; i < nEnd; i++)
+    {
+        CSpanReader r(starts[i], starts[i + 1], nType, nVersion);
+        vtx[i] = std::make_shared<const CTransaction>(deserialize, r);
+        if (!r.empty())
+            throw std::ios_base::failure("UnserializeTransactions(): transaction size mismatch");
+    }
+}
+} // namespace
+
+void UnserializeTransactions(CDataStream &s, uint64_t nTx, std::vector<CTransactionRef> &vtx, unsigned int nThreads)
+{
+    vtx.clear();
+    // Idem serializations leave out fields, so they can only be read by the transaction itself
+    if (nThreads <= 1 || nTx < 2 || (s.GetType() & SER_GETIDEM))
+    {
+        for (uint64_t i = 0; i < nTx; i++)
+            vtx.push_back(std::make_shared<const CTransaction>(deserialize, s));
+        return;
+    }
+
+    // Find where each transaction starts.  This only reads lengths, so it is quick compared to deserializing.
+    CSpanReader scan(s.data(), s.data() + s.size(), s.GetType(), s.GetVersion());
+    std::vector<const char *> starts;
+    for (uint64_t i = 0; i < nTx; i++)
+    {
+        starts.push_back(scan.Pos());
+        SkipTransaction(scan);
+    }
+    starts.push_back(scan.Pos());
+
+    vtx.resize(nTx);
+    nThreads = std::min<uint64_t>(nThreads, nTx);
+    const int nType = s.GetType();
+    const int nVersion = s.GetVersion();
+    try
+    {
+        workerPool.Run(nThreads, [&](size_t part) {
+            DeserializeRange(starts, vtx, nTx * part / nThreads, nTx * (part + 1) / nThreads, nType, nVersion);
+        });
+    }
+    catch (...)
+    {
+        vtx.clear();
+        throw;
+    }
+    s.ignore(starts.back() - starts.front());
+}
+
+void UnserializeBlockTransactions(CDataStream &s, std::vector<CTransactionRef> &vtx)
+{
+    const uint64_t nTx = ReadCompactSize(s);
+    const uint64_t nCores = workerPool.Size() + 1;
+    UnserializeTransactions(
+        s, nTx, vtx, std::min<uint64_t>(nCores, std::max<uint64_t>(nTx / MIN_PARALLEL_DESERIALIZE_TXNS_PER_THREAD, 1)));
+}
@@ -169,6 +169,26 @@ public:
 uint256 GetMiningHash(const uint256 &headerCommitment, const std::vector<unsigned char> &nonce);
 
 
+class CDataStream;
+
+//! Blocks with at least this many transactions per available core are deserialized on several threads
+static const uint64_t MIN_PARALLEL_DESERIALIZE_TXNS_PER_THREAD = 1000;
+
+/** Deserialize nTx transactions from s into vtx in up to nThreads parts.  The transactions are located first, then
+    each part, a contiguous range of them, is deserialized (and so hashed) straight from the stream's buffer on the
+    shared workerPool, or on the calling thread if the pool is not started.  Throws std::ios_base::failure, like
+    stream deserialization, if the data is malformed. */
+void UnserializeTransactions(CDataStream &s, uint64_t nTx, std::vector<CTransactionRef> &vtx, unsigned int nThreads);
+
+/** Read the transactions of a block.  Blocks that are already in memory (received from the network or read from
+    disk into a CDataStream) use the CDataStream overload, which spreads large blocks across the worker pool. */
+template <typename Stream>
+void UnserializeBlockTransactions(Stream &s, std::vector<CTransactionRef> &vtx)
+{
+    s >> vtx;
+}
+void UnserializeBlockTransactions(CDataStream &s, std::vector<CTransactionRef> &vtx);
+
 class CBlock : public CBlockHeader
 {
 public:
@@ -195,13 +215,17 @@ public:
         *((CBlockHeader *)this) = header;
     }
 
-    ADD_SERIALIZE_METHODS;
+    template <typename Stream>
+    void Serialize(Stream &s) const
+    {
+        s << *(const CBlockHeader *)this << vtx;
+    }
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream &s, Operation ser_action)
+    template <typename Stream>
+    void Unserialize(Stream &s)
     {
-        READWRITE(*(CBlockHeader *)this);
-        READWRITE(vtx);
+        s >> *(CBlockHeader *)this;
+        UnserializeBlockTransactions(s, vtx);
     }
 
     /** Returns the block's height as specified in its header */
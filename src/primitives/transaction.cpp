@@ -95,8 +95,8 @@ std::string CMutableTransaction::ToString() const { return CTransaction(*this).T
 void SatoshiTransaction::UpdateHash() const { *const_cast<uint256 *>(&hash) = SerializeHash(*this); }
 void CTransaction::UpdateHash() const
 {
-    *const_cast<uint256 *>(&id) = GetTxId(*this);
     *const_cast<uint256 *>(&idem) = GetTxIdem(*this);
+    *const_cast<uint256 *>(&id) = GetTxId(*this, idem);
 }
 CTransaction::CTransaction() : nTxSize(0), nVersion(CTransaction::CURRENT_VERSION), vin(), vout(), nLockTime(0) {}
 CTransaction::CTransaction(const CMutableTransaction &tx)
@@ -112,10 +112,10 @@ CTransaction::CTransaction(CMutableTransaction &&tx)
 }
 
 CTransaction::CTransaction(const CTransaction &tx)
-    : nTxSize(tx.nTxSize.load()), nVersion(tx.nVersion), vin(tx.vin), vout(tx.vout), nLockTime(tx.nLockTime)
+    : id(tx.id), idem(tx.idem), nTxSize(tx.nTxSize.load()), nVersion(tx.nVersion), vin(tx.vin), vout(tx.vout),
+      nLockTime(tx.nLockTime)
 {
-    UpdateHash();
-};
+}
 
 CTransaction &CTransaction::operator=(const CTransaction &tx)
 {
@@ -241,9 +241,8 @@ uint256 GetTxIdem(const T &tx)
     particular set of transaction bytes.
 */
 template <class T>
-uint256 GetTxId(const T &tx)
+uint256 GetTxId(const T &tx, const uint256 &txidem)
 {
-    uint256 txidem = GetTxIdem(tx);
     CHashWriter satisfierScriptHash(SER_GETHASH, 0);
     satisfierScriptHash << (int32_t)tx.vin.size();
     uint8_t invalidopcode = OP_INVALIDOPCODE;
@@ -260,6 +259,46 @@ uint256 GetTxId(const T &tx)
     return ret.GetHash();
 }
 
+template <class T>
+uint256 GetTxId(const T &tx)
+{
+    return GetTxId(tx, GetTxIdem(tx));
+}
+
+
+/** Reads from an underlying stream, hashing the bytes that are read into a transaction idem.  Hashing can be turned
+    off while the satisfier scripts (which are not part of the idem) are read. */
+template <typename Source>
+class CTxIdemReader : public CHashWriter
+{
+private:
+    Source *source;
+    bool fHashing = true;
+    size_t nBytesRead = 0;
+
+public:
+    CTxIdemReader(Source *source_) : CHashWriter(source_->GetType(), source_->GetVersion()), source(source_) {}
+    void read(char *pch, size_t nSize)
+    {
+        source->read(pch, nSize);
+        nBytesRead += nSize;
+        if (fHashing)
+            this->write(pch, nSize);
+    }
+
+    void SetHashing(bool fHashingIn) { fHashing = fHashingIn; }
+    /** Return the total number of bytes read, whether or not they were hashed */
+    size_t GetNumBytesRead() const { return nBytesRead; }
+
+    template <typename T>
+    CTxIdemReader<Source> &operator>>(T &obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
 
 struct CMutableTransaction;
 
@@ -301,22 +340,58 @@ public:
     CTransaction(const CTransaction &tx);
     CTransaction &operator=(const CTransaction &tx);
 
-    ADD_SERIALIZE_METHODS;
+    template <typename Stream>
+    void Serialize(Stream &s) const
+    {
+        s << nVersion << vin << vout << nLockTime;
+    }
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream &s, Operation ser_action)
+    /** Deserialize, computing the id, idem and size in the same pass from the bytes as they are read rather than
+        by serializing the transaction again afterwards. */
+    template <typename Stream>
+    void Unserialize(Stream &s)
     {
-        READWRITE(*const_cast<uint8_t *>(&this->nVersion));
-        READWRITE(*const_cast<std::vector<CTxIn> *>(&vin));
-        READWRITE(*const_cast<std::vector<CTxOut> *>(&vout));
-        READWRITE(*const_cast<uint32_t *>(&nLockTime));
-        if (ser_action.ForRead())
-            UpdateHash();
+        CTxIdemReader<Stream> reader(&s);
+        CHashWriter satisfierScriptHash(SER_GETHASH, 0);
+        const uint8_t invalidopcode = OP_INVALIDOPCODE;
+
+        reader >> *const_cast<uint8_t *>(&nVersion);
+        std::vector<CTxIn> &txin = *const_cast<std::vector<CTxIn> *>(&vin);
+        txin.clear();
+        const uint64_t nIn = ReadCompactSize(reader);
+        satisfierScriptHash << (int32_t)nIn;
+        for (uint64_t i = 0; i < nIn; i++)
+        {
+            // Same fields as CTxIn::SerializationOp, but the satisfier script goes into its own hash
+            txin.emplace_back();
+            CTxIn &in = txin.back();
+            reader >> in.type >> in.prevout;
+            if (!(s.GetType() & SER_GETIDEM))
+            {
+                reader.SetHashing(false);
+                reader >> *(CScriptBase *)(&in.scriptSig);
+                reader.SetHashing(true);
+                in.scriptSig.type = ScriptType::PUSH_ONLY;
+            }
+            satisfierScriptHash.write((const char *)in.scriptSig.data(), in.scriptSig.size());
+            satisfierScriptHash.write((const char *)&invalidopcode, 1);
+            reader >> in.nSequence >> in.amount;
+        }
+        reader >> *const_cast<std::vector<CTxOut> *>(&vout);
+        reader >> *const_cast<uint32_t *>(&nLockTime);
+
+        *const_cast<uint256 *>(&idem) = reader.GetHash();
+        CHashWriter idHash;
+        idHash << idem << satisfierScriptHash.GetHash();
+        *const_cast<uint256 *>(&id) = idHash.GetHash();
+        // An idem serialization leaves out the satisfiers, so its size is not the transaction size
+        nTxSize = (s.GetType() & SER_GETIDEM) ? 0 : reader.GetNumBytesRead();
     }
 
     template <typename Stream>
-    CTransaction(deserialize_type, Stream &s) : CTransaction(CMutableTransaction(deserialize, s))
+    CTransaction(deserialize_type, Stream &s) : nTxSize(0), nVersion(CURRENT_VERSION), nLockTime(0)
     {
+        Unserialize(s);
     }
 
     bool IsNull() const { return vin.empty() && vout.empty(); }
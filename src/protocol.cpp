@@ -75,6 +75,13 @@ const char *DSPROOF = "dsproof";
 const char *REQTXVAL = "req-txval";
 const char *RESTXVAL = "res-txval";
 
+const char *GETCFILTERS = "getcfilters";
+const char *CFILTER = "cfilter";
+const char *GETCFHEADERS = "getcfheaders";
+const char *CFHEADERS = "cfheaders";
+const char *GETCFCHECKPT = "getcfcheckpt";
+const char *CFCHECKPT = "cfcheckpt";
+
 const char *CAPDPREFIX = "capd";
 const char *CAPDGETINFO = "capdgetinfo";
 const char *CAPDINFO = "capdinfo";
@@ -152,6 +159,12 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::DSPROOF,
     NetMsgType::REQTXVAL,
     NetMsgType::RESTXVAL,
+    NetMsgType::GETCFILTERS,
+    NetMsgType::CFILTER,
+    NetMsgType::GETCFHEADERS,
+    NetMsgType::CFHEADERS,
+    NetMsgType::GETCFCHECKPT,
+    NetMsgType::CFCHECKPT,
     NetMsgType::CAPDINV,
     NetMsgType::CAPDGETMSG,
     NetMsgType::CAPDMSG,
@@ -6,11 +6,14 @@
 
 #include "pubkey.h"
 #include "utilstrencodings.h"
+#include "workerpool.h"
 
 #include <secp256k1.h>
 #include <secp256k1_recovery.h>
 #include <secp256k1_schnorr.h>
 
+#include <algorithm>
+
 namespace
 {
 /* Global secp256k1_context object used for verification. */
@@ -264,6 +267,29 @@ bool CPubKey::VerifySchnorr(const uint256 &hash, const std::vector<uint8_t> &vch
     return secp256k1_schnorr_verify(secp256k1_context_verify, &vchSig[0], hash.begin(), &pubkey);
 }
 
+std::vector<unsigned char> VerifySignatures(const std::vector<CHashSignature> &batch, unsigned int nThreads)
+{
+    if (nThreads == 0)
+    {
+        const size_t nCores = workerPool.Size() + 1;
+        nThreads = std::min<size_t>(nCores, std::max<size_t>(batch.size() / MIN_PARALLEL_SIG_VERIFY_PER_THREAD, 1));
+    }
+    nThreads = std::max<size_t>(std::min<size_t>(nThreads, batch.size()), 1);
+
+    std::vector<unsigned char> results(batch.size(), 0);
+    workerPool.Run(nThreads, [&](size_t range) {
+        for (size_t i = batch.size() * range / nThreads; i < batch.size() * (range + 1) / nThreads; i++)
+        {
+            const CHashSignature &item = batch[i];
+            if (item.sig.size() == 64)
+                results[i] = item.pubkey.VerifySchnorr(item.hash, item.sig);
+            else
+                results[i] = item.pubkey.VerifyECDSA(item.hash, item.sig);
+        }
+    });
+    return results;
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash, const std::vector<uint8_t> &vchSig)
 {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE)
@@ -228,6 +228,25 @@ struct CExtPubKey
     }
 };
 
+//! Batches with at least this many signatures per worker thread are verified on several threads
+static const size_t MIN_PARALLEL_SIG_VERIFY_PER_THREAD = 64;
+
+/** A signature of a 32 byte hash, to be checked by VerifySignatures */
+struct CHashSignature
+{
+    CPubKey pubkey;
+    uint256 hash;
+    std::vector<uint8_t> sig;
+};
+
+/**
+ * Verify a batch of signatures, split into up to nThreads contiguous ranges that are verified on the worker pool, or on
+ * the calling thread if the pool is not started (0 picks the number of ranges from the batch size and the number of
+ * worker threads).  Like OP_CHECKDATASIG, a 64 byte signature is verified as Schnorr and any other as DER-serialized
+ * ECDSA.  Returns 1 for each valid signature and 0 for each invalid one.
+ */
+std::vector<unsigned char> VerifySignatures(const std::vector<CHashSignature> &batch, unsigned int nThreads = 0);
+
 /** Users of this module must hold an ECCVerifyHandle. The constructor and
  *  destructor of these are not allowed to run in parallel, though. */
 class ECCVerifyHandle
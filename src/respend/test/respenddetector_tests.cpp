@@ -18,6 +18,8 @@
 #include "txmempool.h"
 #include <boost/test/unit_test.hpp>
 
+#include <set>
+
 using namespace respend;
 
 namespace
@@ -350,6 +352,13 @@ BOOST_AUTO_TEST_CASE(dsproof_orphan_handling)
             auto ref = MakeTransactionRef(spend2a);
             auto rc = dsp_first.validate(pool, ref);
             BOOST_CHECK(rc == DoubleSpendProof::Valid);
+
+            // The same validation in two steps, as the message handler does it
+            DoubleSpendProof::SpentOutput spent;
+            BOOST_CHECK(dsp_first.prepareValidation(pool, ref, spent) == DoubleSpendProof::Valid);
+            BOOST_CHECK(dsp_first.checkSignatures(spent) == DoubleSpendProof::Valid);
+            spent.pubkey.back() ^= 1;
+            BOOST_CHECK(dsp_first.checkSignatures(spent) == DoubleSpendProof::Invalid);
         }
     }
 
@@ -399,4 +408,74 @@ BOOST_AUTO_TEST_CASE(dsproof_orphan_handling)
     // Cleanup
     vNodes.erase(vNodes.end() - 1);
 }
+
+// A proof of a double spend of outpoint that can be stored but whose signatures are not real
+static DoubleSpendProof StoredProof(const COutPoint &outpoint, uint32_t lockTime)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    std::vector<std::vector<uint8_t> > pushData(1, std::vector<uint8_t>(65, 1));
+    ss << outpoint;
+    for (uint32_t spender = 0; spender < 2; spender++)
+        ss << uint32_t(1) << spender << lockTime << uint256() << uint256() << uint256() << uint256() << pushData;
+    DoubleSpendProof proof;
+    ss >> proof;
+    return proof;
+}
+
+BOOST_AUTO_TEST_CASE(dsproof_storage_shards)
+{
+    DoubleSpendProofStorage storage;
+    std::vector<COutPoint> outpoints;
+    std::vector<int> ids;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        outpoints.push_back(COutPoint(InsecureRand256()));
+        auto res = storage.add(StoredProof(outpoints.back(), i));
+        BOOST_CHECK(res.first);
+        BOOST_CHECK(res.second > 0);
+        ids.push_back(res.second);
+    }
+    BOOST_CHECK_EQUAL(storage.size(), 100);
+    BOOST_CHECK_EQUAL(std::set<int>(ids.begin(), ids.end()).size(), 100);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        DoubleSpendProof dsp = storage.proof(ids[i]);
+        BOOST_CHECK(dsp.Outpoint() == outpoints[i]);
+        BOOST_CHECK(storage.lookup(dsp.GetHash()).GetHash() == dsp.GetHash());
+    }
+
+    // A known proof keeps its id
+    auto res = storage.add(StoredProof(outpoints[0], 0));
+    BOOST_CHECK(!res.first);
+    BOOST_CHECK_EQUAL(res.second, ids[0]);
+
+    // Orphans are found by the exact outpoint they double spend
+    COutPoint shared(InsecureRand256());
+    DoubleSpendProof orphan1 = StoredProof(shared, 1000);
+    DoubleSpendProof orphan2 = StoredProof(shared, 1001);
+    storage.addOrphan(orphan1, 1);
+    storage.addOrphan(orphan2, 2);
+    storage.addOrphan(StoredProof(outpoints[1], 1002), 3);
+    std::list<std::pair<int, int> > found = storage.findOrphans(shared);
+    BOOST_CHECK_EQUAL(found.size(), 2);
+    BOOST_CHECK_EQUAL(found.front().second, 1);
+    BOOST_CHECK_EQUAL(found.back().second, 2);
+    BOOST_CHECK_EQUAL(storage.findOrphans(outpoints[1]).size(), 1);
+    BOOST_CHECK(storage.findOrphans(outpoints[2]).empty());
+
+    // A claimed orphan stays stored but is no longer found, and the other orphan of the outpoint is unaffected
+    storage.claimOrphan(found.front().first);
+    BOOST_CHECK_EQUAL(storage.orphanCount(found.front().first), 0);
+    BOOST_CHECK(storage.exists(orphan1.GetHash()));
+    BOOST_CHECK_EQUAL(storage.findOrphans(shared).size(), 1);
+    storage.remove(found.back().first);
+    BOOST_CHECK(!storage.exists(orphan2.GetHash()));
+    BOOST_CHECK(storage.findOrphans(shared).empty());
+
+    for (int id : ids)
+        storage.remove(id);
+    BOOST_CHECK_EQUAL(storage.size(), 2);
+    BOOST_CHECK_EQUAL(storage.findOrphans(outpoints[1]).size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,10 +8,12 @@
 #include "chain.h"
 #include "chainparams.h"
 #include "httpserver.h"
+#include "init.h"
 #include "main.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "rpc/blockchain.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "sync.h"
@@ -22,11 +24,17 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <numeric>
+
 #include <univalue.h>
 
 using namespace std;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; // allow a max of 15 outpoints to be queried at once
+static const size_t MAX_BULK_UTXO_OUTPOINTS = 100000; // per /rest/getutxos/bulk request
+static const size_t BULK_UTXO_BATCH_SIZE = 1000; // outpoints looked up in the coins database at a time
+static const size_t MAX_REST_BLOCK_RANGE = 10000; // blocks per /rest/blocks request
 
 enum RetFormat
 {
@@ -69,6 +77,9 @@ struct CCoin
 extern UniValue mempoolInfoToJSON();
 extern void ScriptPubKeyToJSON(const CScript &scriptPubKey, UniValue &out, bool fIncludeHex);
 extern UniValue blockheaderToJSON(const CBlockIndex *blockindex);
+extern UniValue getaddresshistory(const UniValue &params, bool fHelp);
+extern UniValue getaddressbalance(const UniValue &params, bool fHelp);
+extern UniValue getaddressutxos(const UniValue &params, bool fHelp);
 
 static bool RESTERR(HTTPRequest *req, enum HTTPStatusCode status, string message)
 {
@@ -132,6 +143,79 @@ static bool CheckWarmup(HTTPRequest *req)
     return true;
 }
 
+/** Sends a binary reply, or its hex form, in chunks as it is produced.  Serialize small items into it with <<, and
+ * hand large byte vectors over with WriteRaw() or WriteVector() so they are sent without being copied again.
+ */
+class RESTBinaryWriter
+{
+public:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    RESTBinaryWriter(HTTPRequest *_req, RetFormat _rf) : req(_req), rf(_rf), ss(SER_NETWORK, PROTOCOL_VERSION)
+    {
+        req->WriteHeader("Content-Type", rf == RF_HEX ? "text/plain" : "application/octet-stream");
+        req->StartChunkedReply(HTTP_OK);
+    }
+
+    template <typename T>
+    RESTBinaryWriter &operator<<(const T &obj)
+    {
+        ss << obj;
+        if (ss.size() >= CHUNK_SIZE)
+            Flush();
+        return *this;
+    }
+
+    /** Send data as it is */
+    bool WriteRaw(std::vector<unsigned char> &&data)
+    {
+        if (!Flush())
+            return false;
+        if (rf == RF_HEX)
+            fOpen = req->WriteReplyChunk(HexStr(data));
+        else
+            fOpen = req->WriteReplyChunk(std::move(data));
+        return fOpen;
+    }
+
+    /** Send data serialized like a std::vector<unsigned char>, that is prefixed with its size */
+    bool WriteVector(std::vector<unsigned char> &&data)
+    {
+        WriteCompactSize(ss, data.size());
+        return WriteRaw(std::move(data));
+    }
+
+    /** Send what is buffered.  Returns false once the client has gone away. */
+    bool Flush()
+    {
+        if (fOpen && !ss.empty())
+        {
+            if (rf == RF_HEX)
+                fOpen = req->WriteReplyChunk(HexStr(ss.begin(), ss.end()));
+            else
+                fOpen = req->WriteReplyChunk(std::vector<unsigned char>(ss.begin(), ss.end()));
+        }
+        ss.clear();
+        return fOpen;
+    }
+
+    bool Open() const { return fOpen; }
+
+    void End()
+    {
+        Flush();
+        if (fOpen && rf == RF_HEX)
+            req->WriteReplyChunk(std::string("\n"));
+        req->EndChunkedReply();
+    }
+
+private:
+    HTTPRequest *req;
+    const RetFormat rf;
+    CDataStream ss;
+    bool fOpen = true;
+};
+
 static bool rest_headers(HTTPRequest *req, const std::string &strURIPart)
 {
     if (!CheckWarmup(req))
@@ -230,26 +314,24 @@ static bool rest_block(HTTPRequest *req, const std::string &strURIPart, bool sho
     if (IsBlockPruned(pblockindex))
         return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-    const ConstCBlockRef pblock = ReadBlockFromDisk(pblockindex, Params().GetConsensus());
-    if (!pblock)
-        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
-
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << *pblock;
-
     switch (rf)
     {
     case RF_BINARY:
     {
-        string binaryBlock = ssBlock.str();
+        std::vector<unsigned char> rawBlock;
+        if (!ReadRawBlockFromDisk(rawBlock, pblockindex))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, string(rawBlock.begin(), rawBlock.end()));
         return true;
     }
 
     case RF_HEX:
     {
-        string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+        std::vector<unsigned char> rawBlock;
+        if (!ReadRawBlockFromDisk(rawBlock, pblockindex))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        string strHex = HexStr(rawBlock) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
@@ -257,10 +339,11 @@ static bool rest_block(HTTPRequest *req, const std::string &strURIPart, bool sho
 
     case RF_JSON:
     {
-        UniValue objBlock = blockToJSON(*pblock, pblockindex, showTxDetails);
-        string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        const ConstCBlockRef pblock = ReadBlockFromDisk(pblockindex, Params().GetConsensus());
+        if (!pblock)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        StreamJSONReply(
+            req, [&](JSONStreamWriter &out) { blockToJSON(out, *pblock, pblockindex, showTxDetails); });
         return true;
     }
 
@@ -355,11 +438,7 @@ static bool rest_mempool_contents(HTTPRequest *req, const std::string &strURIPar
     {
     case RF_JSON:
     {
-        UniValue mempoolObject = mempoolToJSON(true, true);
-
-        string strJSON = mempoolObject.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        StreamJSONReply(req, [](JSONStreamWriter &out) { mempoolToJSON(out, true, true); });
         return true;
     }
     default:
@@ -431,6 +510,29 @@ static bool rest_tx(HTTPRequest *req, const std::string &strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+/** Parse an outpoint given either as its hash or in txidem-index format */
+static bool ParseOutPointStr(const std::string &str, COutPoint &outpoint)
+{
+    uint256 txid;
+    auto dashpt = str.find("-");
+    if (dashpt == string::npos)
+    {
+        txid.SetHex(str);
+        outpoint = COutPoint(txid);
+        return true;
+    }
+
+    std::string strTxid = str.substr(0, dashpt);
+    std::string strOutput = str.substr(dashpt + 1);
+    int32_t nOutput;
+    if (!ParseInt32(strOutput, &nOutput) || !IsHex(strTxid))
+        return false;
+
+    txid.SetHex(strTxid);
+    outpoint = COutPoint(txid, (uint32_t)nOutput);
+    return true;
+}
+
 static bool rest_getutxos(HTTPRequest *req, const std::string &strURIPart)
 {
     if (!CheckWarmup(req))
@@ -465,27 +567,10 @@ static bool rest_getutxos(HTTPRequest *req, const std::string &strURIPart)
 
         for (size_t i = (fCheckMemPool) ? 1 : 0; i < uriParts.size(); i++)
         {
-            uint256 txid;
-            int32_t nOutput;
-            // Accept either outpoint or txidem-index format
-            auto dashpt = uriParts[i].find("-");
-            if (dashpt == string::npos)
-            {
-                std::string outpoint = uriParts[i];
-                txid.SetHex(outpoint);
-                vOutPoints.push_back(COutPoint(txid));
-            }
-            else
-            {
-                std::string strTxid = uriParts[i].substr(0, dashpt);
-                std::string strOutput = uriParts[i].substr(dashpt + 1);
-
-                if (!ParseInt32(strOutput, &nOutput) || !IsHex(strTxid))
-                    return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Parse error");
-
-                txid.SetHex(strTxid);
-                vOutPoints.push_back(COutPoint(txid, (uint32_t)nOutput));
-            }
+            COutPoint outpoint;
+            if (!ParseOutPointStr(uriParts[i], outpoint))
+                return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Parse error");
+            vOutPoints.push_back(outpoint);
         }
 
         if (vOutPoints.size() > 0)
@@ -649,6 +734,314 @@ static bool rest_getutxos(HTTPRequest *req, const std::string &strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+/** Stream a range of blocks in the active chain straight from the block files, optionally with their undo data.
+ * /rest/blocks/[undo/]<height>/<count>.<bin|hex>
+ *
+ * For each block the reply holds its height (int32), its hash, the serialized block as a byte vector and, with undo,
+ * the serialized undo data as a byte vector (empty for the genesis block).  If a block can not be read part way
+ * through, the reply ends early.
+ */
+static bool rest_blocks(HTTPRequest *req, const std::string &strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    vector<string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    const bool fUndo = !path.empty() && path[0] == "undo";
+    if (fUndo)
+        path.erase(path.begin());
+    if (path.size() != 2)
+        return RESTERR(
+            req, HTTP_BAD_REQUEST, "No height and count specified. Use /rest/blocks/[undo/]<height>/<count>.<ext>.");
+
+    int32_t nStart, nCount;
+    if (!ParseInt32(path[0], &nStart) || nStart < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + path[0]);
+    if (!ParseInt32(path[1], &nCount) || nCount < 1 || (size_t)nCount > MAX_REST_BLOCK_RANGE)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + path[1]);
+
+    if (rf != RF_BINARY && rf != RF_HEX)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+
+    std::vector<const CBlockIndex *> blocks;
+    blocks.reserve(nCount);
+    {
+        LOCK(cs_main);
+        if (nStart > chainActive.Height())
+            return RESTERR(req, HTTP_NOT_FOUND, "Height out of range: " + path[0]);
+        for (int32_t nHeight = nStart; nHeight < nStart + nCount && nHeight <= chainActive.Height(); nHeight++)
+        {
+            const CBlockIndex *pindex = chainActive[nHeight];
+            if (IsBlockPruned(pindex))
+                return RESTERR(req, HTTP_NOT_FOUND, strprintf("Block %d not available (pruned data)", nHeight));
+            if (fUndo && pindex->pprev && !(pindex->nStatus & BLOCK_HAVE_UNDO))
+                return RESTERR(req, HTTP_NOT_FOUND, strprintf("Undo data of block %d not available", nHeight));
+            blocks.push_back(pindex);
+        }
+    }
+
+    RESTBinaryWriter out(req, rf);
+    for (const CBlockIndex *pindex : blocks)
+    {
+        if (ShutdownRequested())
+            break;
+        std::vector<unsigned char> rawBlock;
+        if (!ReadRawBlockFromDisk(rawBlock, pindex))
+        {
+            LOGA("REST blocks reply for %s cut short: can not read block %s\n", req->GetURI(),
+                pindex->GetBlockHash().ToString());
+            break;
+        }
+        out << (int32_t)pindex->height() << pindex->GetBlockHash();
+        if (!out.WriteVector(std::move(rawBlock)))
+            break;
+
+        if (fUndo)
+        {
+            // Undo data is small next to the block and carries a checksum, so it is read and checked as usual
+            std::vector<unsigned char> rawUndo;
+            if (pindex->pprev)
+            {
+                CBlockUndo blockundo;
+                if (!ReadUndoFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev))
+                {
+                    LOGA("REST blocks reply for %s cut short: can not read undo data of block %s\n", req->GetURI(),
+                        pindex->GetBlockHash().ToString());
+                    break;
+                }
+                CDataStream ssUndo(SER_NETWORK, PROTOCOL_VERSION);
+                ssUndo << blockundo;
+                rawUndo.assign(ssUndo.begin(), ssUndo.end());
+            }
+            if (!out.WriteVector(std::move(rawUndo)))
+                break;
+        }
+    }
+    out.End();
+    return true;
+}
+
+/** Look up the unspent coins of outpoints in the chain state, in batches of BULK_UTXO_BATCH_SIZE that are read from
+ * the coins database in key order without being added to the coins cache.  found is called for every outpoint in
+ * the order given, and can return false to stop.
+ */
+static void LookupCoinsBatched(const std::vector<COutPoint> &vOutPoints,
+    const std::function<bool(size_t i, bool fFound, Coin &&coin)> &found)
+{
+    for (size_t nBegin = 0; nBegin < vOutPoints.size(); nBegin += BULK_UTXO_BATCH_SIZE)
+    {
+        const size_t nEnd = std::min(vOutPoints.size(), nBegin + BULK_UTXO_BATCH_SIZE);
+        std::vector<size_t> vOrder(nEnd - nBegin);
+        std::iota(vOrder.begin(), vOrder.end(), nBegin);
+        std::sort(vOrder.begin(), vOrder.end(),
+            [&vOutPoints](size_t a, size_t b) { return vOutPoints[a] < vOutPoints[b]; });
+
+        std::vector<COutPoint> vSorted;
+        vSorted.reserve(vOrder.size());
+        for (size_t i : vOrder)
+            vSorted.push_back(vOutPoints[i]);
+        std::vector<Coin> coins;
+        std::vector<bool> vFound;
+        pcoinsTip->GetCoins(vSorted, coins, vFound);
+
+        // Answer in the order asked
+        std::vector<size_t> vSortedPos(vOrder.size());
+        for (size_t k = 0; k < vOrder.size(); k++)
+            vSortedPos[vOrder[k] - nBegin] = k;
+        for (size_t i = nBegin; i < nEnd; i++)
+        {
+            const size_t k = vSortedPos[i - nBegin];
+            if (!found(i, vFound[k], std::move(coins[k])))
+                return;
+        }
+    }
+}
+
+/** Look up a large number of outpoints in the chain state, without the mempool.
+ * POST /rest/getutxos/bulk.<bin|hex|json>
+ *
+ * The body is a serialized vector of outpoints for bin (hex encoded for hex), or a JSON array of outpoints in hash or
+ * txidem-index format for json.  The binary reply holds the chain height (int32) and tip hash, then for every
+ * outpoint in the order asked a bool telling whether it is unspent, followed by the coin if it is.  The json reply
+ * has a utxos array with an entry for every outpoint, null if it is not unspent.
+ *
+ * Lookups are done in batches, so a long reply may see blocks connected while it is produced.
+ */
+static bool rest_getutxos_bulk(HTTPRequest *req, const std::string &strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Outpoints must be sent in the request body");
+
+    std::string strBody = req->ReadBody();
+    std::vector<COutPoint> vOutPoints;
+    switch (rf)
+    {
+    case RF_HEX:
+    {
+        std::vector<unsigned char> body = ParseHex(strBody);
+        strBody.assign(body.begin(), body.end());
+    }
+    // FALLTHROUGH
+    case RF_BINARY:
+    {
+        try
+        {
+            CDataStream oss(strBody.data(), strBody.data() + strBody.size(), SER_NETWORK, PROTOCOL_VERSION);
+            oss >> vOutPoints;
+        }
+        catch (const std::ios_base::failure &e)
+        {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        break;
+    }
+
+    case RF_JSON:
+    {
+        UniValue body;
+        if (!body.read(strBody) || !body.isArray())
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error: expected an array of outpoints");
+        for (size_t i = 0; i < body.size(); i++)
+        {
+            COutPoint outpoint;
+            if (!body[i].isStr() || !ParseOutPointStr(body[i].get_str(), outpoint))
+                return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Parse error at outpoint %u", i));
+            vOutPoints.push_back(outpoint);
+        }
+        break;
+    }
+
+    default:
+    {
+        return RESTERR(
+            req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    if (vOutPoints.empty())
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    if (vOutPoints.size() > MAX_BULK_UTXO_OUTPOINTS)
+        return RESTERR(req, HTTP_BAD_REQUEST,
+            strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", MAX_BULK_UTXO_OUTPOINTS, vOutPoints.size()));
+
+    int32_t nHeight;
+    uint256 hashTip;
+    {
+        LOCK(cs_main);
+        nHeight = chainActive.Height();
+        hashTip = chainActive.Tip()->GetBlockHash();
+    }
+
+    if (rf == RF_JSON)
+    {
+        StreamJSONReply(req, [&](JSONStreamWriter &out) {
+            out.BeginObject();
+            out.KV("chainHeight", nHeight);
+            out.KV("chaintipHash", hashTip.GetHex());
+            out.Key("utxos");
+            out.BeginArray();
+            LookupCoinsBatched(vOutPoints, [&](size_t i, bool fFound, Coin &&coin) {
+                if (!fFound)
+                {
+                    out.Null();
+                    return !out.Aborted();
+                }
+                UniValue utxo(UniValue::VOBJ);
+                utxo.pushKV("outpoint", vOutPoints[i].hash.GetHex());
+                utxo.pushKV("height", (int32_t)coin.nHeight);
+                utxo.pushKV("value", ValueFromAmount(coin.out.nValue));
+                UniValue o(UniValue::VOBJ);
+                ScriptPubKeyToJSON(coin.out.scriptPubKey, o, true);
+                utxo.pushKV("scriptPubKey", o);
+                out.Value(utxo);
+                return !out.Aborted();
+            });
+            out.EndArray();
+            out.EndObject();
+        });
+        return true;
+    }
+
+    RESTBinaryWriter out(req, rf);
+    out << nHeight << hashTip;
+    LookupCoinsBatched(vOutPoints, [&out](size_t, bool fFound, Coin &&coin) {
+        out << fFound;
+        if (fFound)
+            out << CCoin(std::move(coin));
+        return out.Open();
+    });
+    out.End();
+    return true;
+}
+
+/** Answer a scripthash query from the address index. The scripthash is the only path component, the format must be
+ *  json.
+ */
+static bool rest_scripthash(HTTPRequest *req,
+    const std::string &strURIPart,
+    UniValue (*query)(const UniValue &params, bool fHelp))
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid scripthash: " + hashStr);
+
+    switch (rf)
+    {
+    case RF_JSON:
+    {
+        UniValue rpcParams(UniValue::VARR);
+        rpcParams.push_back(hashStr);
+        UniValue result;
+        try
+        {
+            result = query(rpcParams, false);
+        }
+        catch (const UniValue &objError)
+        {
+            return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, find_value(objError, "message").get_str());
+        }
+        string strJSON = result.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default:
+    {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_scripthash_history(HTTPRequest *req, const std::string &strURIPart)
+{
+    return rest_scripthash(req, strURIPart, getaddresshistory);
+}
+
+static bool rest_scripthash_balance(HTTPRequest *req, const std::string &strURIPart)
+{
+    return rest_scripthash(req, strURIPart, getaddressbalance);
+}
+
+static bool rest_scripthash_utxos(HTTPRequest *req, const std::string &strURIPart)
+{
+    return rest_scripthash(req, strURIPart, getaddressutxos);
+}
+
 static const struct
 {
     const char *prefix;
@@ -661,13 +1054,18 @@ static const struct
     {"/rest/mempool/info", rest_mempool_info},
     {"/rest/mempool/contents", rest_mempool_contents},
     {"/rest/headers/", rest_headers},
+    {"/rest/blocks/", rest_blocks},
+    {"/rest/getutxos/bulk", rest_getutxos_bulk},
     {"/rest/getutxos", rest_getutxos},
+    {"/rest/scripthash/history/", rest_scripthash_history},
+    {"/rest/scripthash/balance/", rest_scripthash_balance},
+    {"/rest/scripthash/utxos/", rest_scripthash_utxos},
 };
 
 bool StartREST()
 {
     for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
-        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler);
+        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler, HTTP_WORK_REST);
     return true;
 }
 
@@ -16,9 +16,11 @@
 #include "consensus/validation.h"
 #include "dstencode.h"
 #include "hashwrapper.h"
+#include "index/tokenindex.h"
 #include "main.h"
 #include "policy/policy.h"
 #include "primitives/transaction.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "sync.h"
@@ -165,6 +167,54 @@ UniValue blockToJSON(const CBlock &block,
     return result;
 }
 
+void blockToJSON(JSONStreamWriter &out,
+    const CBlock &block,
+    const CBlockIndex *blockindex,
+    bool txDetails /* = false */,
+    bool listTxns /* = true */)
+{
+    UniValue header(UniValue::VOBJ);
+    blockheaderToJSON(blockindex, header);
+    out.BeginObject(header);
+
+    if (listTxns)
+    {
+        int64_t txTime = -1; // Don't display the time in the tx because its in the block data.
+        if (txDetails) // Details contains both id an idem
+        {
+            out.Key("tx");
+            out.BeginArray();
+            for (const auto &tx : block.vtx)
+            {
+                if (out.Aborted())
+                    break;
+                UniValue objTx(UniValue::VOBJ);
+                TxToJSON(*tx, txTime, uint256(), objTx);
+                out.Value(objTx);
+            }
+            out.EndArray();
+        }
+        else
+        {
+            out.Key("txid");
+            out.BeginArray();
+            for (const auto &tx : block.vtx)
+                out.Value(tx->GetId().GetHex());
+            out.EndArray();
+            out.Key("txidem");
+            out.BeginArray();
+            for (const auto &tx : block.vtx)
+                out.Value(tx->GetIdem().GetHex());
+            out.EndArray();
+        }
+    }
+    else
+    {
+        out.KV("txcount", (uint64_t)block.vtx.size());
+    }
+    out.EndObject();
+}
+
 UniValue getblockcount(const UniValue &params, bool fHelp)
 {
     if (fHelp || params.size() != 0)
@@ -327,6 +377,59 @@ UniValue mempoolToJSON(bool fVerbose /* = false */, bool idem /* = false */)
     }
 }
 
+/** The most mempool entries described under one hold of the mempool lock while streaming */
+static const size_t MEMPOOL_STREAM_BATCH = 1000;
+
+void mempoolToJSON(JSONStreamWriter &out, bool fVerbose /* = false */, bool idem /* = false */)
+{
+    if (fVerbose)
+    {
+        // The entries are described in batches, in txid order, and written out with the locks released, so that a
+        // slow client does not hold up the mempool.  Each entry is consistent but the whole is not one snapshot.
+        out.BeginObject();
+        std::vector<std::pair<std::string, UniValue> > batch;
+        uint256 lastId;
+        bool fFirst = true;
+        bool fMore = true;
+        while (fMore && !out.Aborted())
+        {
+            batch.clear();
+            {
+                LOCK(cs_main);
+                READLOCK(mempool.cs_txmempool);
+                auto iter = fFirst ? mempool.mapTx.begin() : mempool.mapTx.upper_bound(lastId);
+                fFirst = false;
+                for (; iter != mempool.mapTx.end() && batch.size() < MEMPOOL_STREAM_BATCH; ++iter)
+                {
+                    const CTxMemPoolEntry &e = *iter;
+                    const uint256 &hash = (idem) ? e.GetTx().GetIdem() : e.GetTx().GetId();
+                    UniValue info(UniValue::VOBJ);
+                    entryToJSON(info, e);
+                    batch.emplace_back(hash.ToString(), std::move(info));
+                    lastId = e.GetTx().GetId();
+                }
+                fMore = (iter != mempool.mapTx.end());
+            }
+            for (const auto &entry : batch)
+                out.KV(entry.first, entry.second);
+        }
+        out.EndObject();
+    }
+    else
+    {
+        vector<uint256> vtxid;
+        if (idem)
+            mempool.queryIdems(vtxid);
+        else
+            mempool.queryIds(vtxid);
+
+        out.BeginArray();
+        for (const uint256 &hash : vtxid)
+            out.Value(hash.ToString());
+        out.EndArray();
+    }
+}
+
 UniValue orphanpoolToJSON()
 {
     vector<uint256> vHashes;
@@ -339,6 +442,28 @@ UniValue orphanpoolToJSON()
     return a;
 }
 
+static void ParseGetRawTxPoolParams(const UniValue &params, bool &fVerbose, bool &idem)
+{
+    if (params.size() > 0)
+    {
+        if (params[0].isStr())
+            fVerbose = InterpretBool(params[0].get_str());
+        else if (params[0].isNum())
+            fVerbose = (params[0].get_int() != 0);
+        else
+            fVerbose = params[0].get_bool();
+    }
+    if (params.size() > 1)
+    {
+        std::string s = params[1].get_str();
+        makeLowercase(s);
+        if (s == "id")
+            idem = false;
+        else if (s != "idem")
+            throw JSONRPCError(RPC_INVALID_PARAMS, "2nd parameter must be 'id' or 'idem'");
+    }
+}
+
 UniValue getrawtxpool(const UniValue &params, bool fHelp)
 {
     if (fHelp || params.size() > 2)
@@ -365,30 +490,23 @@ UniValue getrawtxpool(const UniValue &params, bool fHelp)
 
     LOCK(cs_main);
 
-    bool idem = true;
     bool fVerbose = false;
-    if (params.size() > 0)
-    {
-        if (params[0].isStr())
-            fVerbose = InterpretBool(params[0].get_str());
-        else if (params[0].isNum())
-            fVerbose = (params[0].get_int() != 0);
-        else
-            fVerbose = params[0].get_bool();
-    }
-    if (params.size() > 1)
-    {
-        std::string s = params[1].get_str();
-        makeLowercase(s);
-        if (s == "id")
-            idem = false;
-        else if (s != "idem")
-            throw JSONRPCError(RPC_INVALID_PARAMS, "2nd parameter must be 'id' or 'idem'");
-    }
-
+    bool idem = true;
+    ParseGetRawTxPoolParams(params, fVerbose, idem);
     return mempoolToJSON(fVerbose, idem);
 }
 
+static RPCStreamResult getrawtxpoolStreamed(const UniValue &params)
+{
+    if (params.size() > 2)
+        return RPCStreamResult();
+
+    bool fVerbose = false;
+    bool idem = true;
+    ParseGetRawTxPoolParams(params, fVerbose, idem);
+    return [fVerbose, idem](JSONStreamWriter &out) { mempoolToJSON(out, fVerbose, idem); };
+}
+
 UniValue getrawtxpoolbyid(const UniValue &params, bool fHelp)
 {
     if (fHelp || params.size() > 1)
@@ -805,56 +923,9 @@ static CBlockUndo GetUndoChecked(const CBlockIndex *pblockindex)
     return blockUndo;
 }
 
-static UniValue getblock(const UniValue &params, bool fHelp)
+/** Find the block of getblock's first parameter and read the verbosity and tx_count parameters */
+static CBlockIndex *ParseGetBlockParams(const UniValue &params, int &nVerbose, bool &fListTxns)
 {
-    if (fHelp || params.size() < 1 || params.size() > 3)
-        throw runtime_error(
-            "getblock hash_or_height ( verbosity ) ( tx_count )\n"
-            "\nIf verbosity is 0, returns a string that is serialized, hex-encoded data for block 'hash'.\n"
-            "If verbosity is 1, returns the block header with a list of transaction hashes in the block\n"
-            "If verbosity is 2, returns the block header with a list of all decoded transaction details in the block\n"
-            "If tx_count is true, returns a block header with a count of all transactions in the block.\n"
-            "\nArguments:\n"
-            "1. \"hash_or_height\"      (string|numeric, required) The block hash or height.\n"
-            "2. \"verbosity\"           (numeric, optional, default=1) 0 for hex-encoded data, 1 \n"
-            "                          for a block header with list of txn hashes, and 2 for a block header with \n"
-            "                          detailed transaction data.\n"
-            "3. \"tx_count\"            (boolean, optional, default=false true to get a block header with a count of \n"
-            "                          of transactions in the block.\n"
-            "\nResult (for verbosity = 1, tx_count = false):\n"
-            "{\n"
-            "  \"hash\" : \"hash\",     (string) the block hash (same as provided)\n"
-            "  \"confirmations\" : n,   (numeric) The number of confirmations, or -1 if the block is not on the main "
-            "chain\n"
-            "  \"size\" : n,            (numeric) The block size\n"
-            "  \"height\" : n,          (numeric) The block height or index\n"
-            "  \"version\" : n,         (numeric) The block version\n"
-            "  \"versionHex\" : \"00000000\", (string) The block version formatted in hexadecimal\n"
-            "  \"merkleroot\" : \"xxxx\", (string) The merkle root\n"
-            "  \"tx\" : [               (array of string) The transaction ids\n"
-            "     \"transactionid\"     (string) The transaction id\n"
-            "     ,...\n"
-            "  ],\n"
-            "  \"time\" : ttt,          (numeric) The block time in seconds since epoch (Jan 1 1970 GMT)\n"
-            "  \"mediantime\" : ttt,    (numeric) The median block time in seconds since epoch (Jan 1 1970 GMT)\n"
-            "  \"nonce\" : n,           (numeric) The nonce\n"
-            "  \"bits\" : \"1d00ffff\", (string) The bits\n"
-            "  \"difficulty\" : x.xxx,  (numeric) The difficulty\n"
-            "  \"chainwork\" : \"xxxx\",  (string) Expected number of hashes required to produce the chain up to this "
-            "block (in hex)\n"
-            "  \"previousblockhash\" : \"hash\",  (string) The hash of the previous block\n"
-            "  \"nextblockhash\" : \"hash\"       (string) The hash of the next block\n"
-            "}\n"
-            "\nResult (for verbosity = 2, tx_count = false):\n"
-            "{\n"
-            "Same as for verbosity = 1 but with all the un-encoded details of each transaction\n"
-            "}\n"
-            "\nResult (for verbosity=0):\n"
-            "\"data\"             (string) A string that is serialized, hex-encoded data for block 'hash'.\n"
-            "\nExamples:\n" +
-            HelpExampleCli("getblock", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"") +
-            HelpExampleRpc("getblock", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\""));
-
     CBlockIndex *pindex = nullptr;
     bool isNumber = true;
     int height = -1;
@@ -908,15 +979,13 @@ static UniValue getblock(const UniValue &params, bool fHelp)
             throw JSONRPCError(
                 RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
         }
-        LOG(RPC, "%s for height %d (tip is at %d)", __func__, height, current_tip);
+        LOG(RPC, "getblock for height %d (tip is at %d)", height, current_tip);
         pindex = chainActive[height];
         DbgAssert(pindex && pindex->height() == height, throw std::runtime_error(__func__));
     }
 
     DbgAssert(pindex != nullptr, throw std::runtime_error(__func__));
 
-    int nVerbose = 1;
-    bool fListTxns = true;
     if (params.size() > 1)
     {
         if (params[1].isNum())
@@ -928,6 +997,62 @@ static UniValue getblock(const UniValue &params, bool fHelp)
     {
         fListTxns = !(is_param_trueish(params[2]));
     }
+    return pindex;
+}
+
+static UniValue getblock(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 3)
+        throw runtime_error(
+            "getblock hash_or_height ( verbosity ) ( tx_count )\n"
+            "\nIf verbosity is 0, returns a string that is serialized, hex-encoded data for block 'hash'.\n"
+            "If verbosity is 1, returns the block header with a list of transaction hashes in the block\n"
+            "If verbosity is 2, returns the block header with a list of all decoded transaction details in the block\n"
+            "If tx_count is true, returns a block header with a count of all transactions in the block.\n"
+            "\nArguments:\n"
+            "1. \"hash_or_height\"      (string|numeric, required) The block hash or height.\n"
+            "2. \"verbosity\"           (numeric, optional, default=1) 0 for hex-encoded data, 1 \n"
+            "                          for a block header with list of txn hashes, and 2 for a block header with \n"
+            "                          detailed transaction data.\n"
+            "3. \"tx_count\"            (boolean, optional, default=false true to get a block header with a count of \n"
+            "                          of transactions in the block.\n"
+            "\nResult (for verbosity = 1, tx_count = false):\n"
+            "{\n"
+            "  \"hash\" : \"hash\",     (string) the block hash (same as provided)\n"
+            "  \"confirmations\" : n,   (numeric) The number of confirmations, or -1 if the block is not on the main "
+            "chain\n"
+            "  \"size\" : n,            (numeric) The block size\n"
+            "  \"height\" : n,          (numeric) The block height or index\n"
+            "  \"version\" : n,         (numeric) The block version\n"
+            "  \"versionHex\" : \"00000000\", (string) The block version formatted in hexadecimal\n"
+            "  \"merkleroot\" : \"xxxx\", (string) The merkle root\n"
+            "  \"tx\" : [               (array of string) The transaction ids\n"
+            "     \"transactionid\"     (string) The transaction id\n"
+            "     ,...\n"
+            "  ],\n"
+            "  \"time\" : ttt,          (numeric) The block time in seconds since epoch (Jan 1 1970 GMT)\n"
+            "  \"mediantime\" : ttt,    (numeric) The median block time in seconds since epoch (Jan 1 1970 GMT)\n"
+            "  \"nonce\" : n,           (numeric) The nonce\n"
+            "  \"bits\" : \"1d00ffff\", (string) The bits\n"
+            "  \"difficulty\" : x.xxx,  (numeric) The difficulty\n"
+            "  \"chainwork\" : \"xxxx\",  (string) Expected number of hashes required to produce the chain up to this "
+            "block (in hex)\n"
+            "  \"previousblockhash\" : \"hash\",  (string) The hash of the previous block\n"
+            "  \"nextblockhash\" : \"hash\"       (string) The hash of the next block\n"
+            "}\n"
+            "\nResult (for verbosity = 2, tx_count = false):\n"
+            "{\n"
+            "Same as for verbosity = 1 but with all the un-encoded details of each transaction\n"
+            "}\n"
+            "\nResult (for verbosity=0):\n"
+            "\"data\"             (string) A string that is serialized, hex-encoded data for block 'hash'.\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getblock", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"") +
+            HelpExampleRpc("getblock", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\""));
+
+    int nVerbose = 1;
+    bool fListTxns = true;
+    CBlockIndex *pindex = ParseGetBlockParams(params, nVerbose, fListTxns);
 
     const CBlock block = GetBlockChecked(pindex);
 
@@ -945,6 +1070,24 @@ static UniValue getblock(const UniValue &params, bool fHelp)
     return blockToJSON(block, pindex, fVerbose, fListTxns);
 }
 
+static RPCStreamResult getblockStreamed(const UniValue &params)
+{
+    if (params.size() < 1 || params.size() > 3)
+        return RPCStreamResult();
+
+    int nVerbose = 1;
+    bool fListTxns = true;
+    CBlockIndex *pindex = ParseGetBlockParams(params, nVerbose, fListTxns);
+    // The hex form is a single string, there is nothing to stream
+    if (nVerbose == 0 && fListTxns == true)
+        return RPCStreamResult();
+
+    std::shared_ptr<const CBlock> block = std::make_shared<const CBlock>(GetBlockChecked(pindex));
+    const bool fVerbose = (nVerbose == 2);
+    return [block, pindex, fVerbose, fListTxns](JSONStreamWriter &out)
+    { blockToJSON(out, *block, pindex, fVerbose, fListTxns); };
+}
+
 static void ApplyStats(CCoinsStats &stats, CHashWriter &ss, const COutPoint &outpt, const Coin &coin)
 {
     ss << outpt;
@@ -2501,14 +2644,105 @@ enum class OutputScriptType
     P2WPKH
 };
 
+//! default and max number of outputs returned by one listtokenutxos (or indexed scantokens) call
+static const int64_t DEFAULT_TOKENINDEX_PAGE = 1000;
+static const int64_t MAX_TOKENINDEX_PAGE = 100000;
+
+/** Returns true if the token index can answer queries.  Throws if it is enabled but still catching up. */
+static bool UseTokenIndex()
+{
+    if (!g_tokenindex)
+        return false;
+    if (!g_tokenindex->IsSynced())
+        throw JSONRPCError(RPC_MISC_ERROR, "The token index is still syncing with the block chain");
+    return true;
+}
+
+static CGroupTokenID ParseTokenGroup(const UniValue &param)
+{
+    CGroupTokenID group = DecodeGroupToken(param.get_str());
+    if (!group.isUserGroup())
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid group specified");
+    return group;
+}
+
+static size_t ParseTokenPageSize(const UniValue &param)
+{
+    int64_t nMax = param.get_int64();
+    if (nMax <= 0 || nMax > MAX_TOKENINDEX_PAGE)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("limit must be between 1 and %d", MAX_TOKENINDEX_PAGE));
+    return nMax;
+}
+
+/** Read one page of token outputs from the token index.  Returns true if there are more after the page. */
+static bool ReadTokenPage(const CGroupTokenID &group,
+    bool fAuthorities,
+    const UniValue &limit,
+    const UniValue &after,
+    std::vector<std::pair<uint256, Coin> > &entries)
+{
+    size_t nMax = DEFAULT_TOKENINDEX_PAGE;
+    if (!limit.isNull())
+        nMax = ParseTokenPageSize(limit);
+    uint256 hashAfter;
+    if (!after.isNull())
+        hashAfter = ParseHashV(after, "after");
+
+    if (!g_tokenindex->GetUnspent(group, fAuthorities, hashAfter, nMax + 1, entries))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the token index");
+    bool fMore = entries.size() > nMax;
+    if (fMore)
+        entries.resize(nMax);
+    return fMore;
+}
+
+static UniValue TokenOutputToJSON(const uint256 &outpoint, const Coin &coin, const CGroupTokenInfo &info)
+{
+    const CTxOut &txo = coin.out;
+    CTxDestination dest;
+    ExtractDestination(txo.scriptPubKey, dest);
+
+    UniValue unspent(UniValue::VOBJ);
+    unspent.pushKV("outpoint", outpoint.GetHex());
+    if (IsValidDestination(dest))
+    {
+        unspent.pushKV("address", EncodeDestination(dest));
+    }
+    unspent.pushKV("scriptPubKey", HexStr(txo.scriptPubKey.begin(), txo.scriptPubKey.end()));
+    unspent.pushKV("amount", ValueFromAmount(txo.nValue));
+    unspent.pushKV("satoshis", txo.nValue);
+    if (info.isAuthority())
+    {
+        UniValue permissions(UniValue::VARR);
+        if (info.allowsMint())
+            permissions.push_back("mint");
+        if (info.allowsMelt())
+            permissions.push_back("melt");
+        if (info.allowsRenew())
+            permissions.push_back("baton");
+        if (info.allowsRescript())
+            permissions.push_back("rescript");
+        if (info.allowsSubgroup())
+            permissions.push_back("subgroup");
+        unspent.pushKV("authority", permissions);
+    }
+    else
+    {
+        unspent.pushKV("tokenAmount", info.quantity);
+    }
+    unspent.pushKV("height", (int32_t)coin.nHeight);
+    return unspent;
+}
+
 #ifdef ENABLE_WALLET
 
 UniValue scantokens(const UniValue &params, bool fHelp)
 {
-    if (fHelp || params.size() < 1 || params.size() > 2)
+    if (fHelp || params.size() < 1 || params.size() > 4)
         throw std::runtime_error(
-            "scantokens <action> ( <scanobjects> )\n"
+            "scantokens <action> ( <scanobjects> limit \"after\" )\n"
             "\nScans the unspent transaction output set for possible entries that belong to a specified token group.\n"
+            "With -tokenindex the outputs are read from the index instead, one page at a time.\n"
             "\nArguments:\n"
             "1. \"action\"                     (string, required) The action to execute\n"
             "                                      \"start\" for starting a scan\n"
@@ -2516,9 +2750,18 @@ UniValue scantokens(const UniValue &params, bool fHelp)
             "was successful)\n"
             "                                      \"status\" for progress report (in %) of the current scan\n"
             "2. \"tokenGroupID\"               (string, optional) Token group identifier\n"
+            "3. limit                        (numeric, optional, default=" +
+            std::to_string(DEFAULT_TOKENINDEX_PAGE) +
+            ") With -tokenindex, the maximum number of outputs to return\n"
+            "4. \"after\"                      (string, optional) With -tokenindex, continue after this outpoint, as "
+            "returned in \"next\"\n"
             "\n"
             "\nResult:\n"
             "{\n"
+            "  \"success\": true|false,        (boolean) Whether the scan completed, false if it was aborted\n"
+            "  \"searchedItems\": n,           (numeric) The number of unspent outputs scanned.  Not present "
+            "with -tokenindex,\n"
+            "                                      where no outputs are scanned\n"
             "  \"unspents\": [\n"
             "    {\n"
             "    \"txid\" : \"transactionid\",   (string) The transaction id\n"
@@ -2530,9 +2773,11 @@ UniValue scantokens(const UniValue &params, bool fHelp)
             "   }\n"
             "   ,...], \n"
             " \"totalAmount\" : xxx,          (numeric) The total token amount of all found unspent outputs\n"
+            " \"next\" : \"hex\"               (string, optional) With -tokenindex, pass as \"after\" to fetch "
+            "the next page\n"
             "]\n");
 
-    RPCTypeCheck(params, {UniValue::VSTR, UniValue::VSTR});
+    RPCTypeCheck(params, {UniValue::VSTR, UniValue::VSTR, UniValue::VNUM, UniValue::VSTR}, true);
 
     UniValue result(UniValue::VOBJ);
     if (params[0].get_str() == "status")
@@ -2572,10 +2817,26 @@ UniValue scantokens(const UniValue &params, bool fHelp)
             throw JSONRPCError(RPC_INVALID_PARAMETER, "No token group ID specified");
         }
 
-        CGroupTokenID needle = DecodeGroupToken(params[1].get_str());
-        if (!needle.isUserGroup())
+        CGroupTokenID needle = ParseTokenGroup(params[1]);
+
+        if (UseTokenIndex())
         {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid group specified");
+            std::vector<std::pair<uint256, Coin> > entries;
+            bool fMore = ReadTokenPage(needle, false, params[2], params[3], entries);
+            UniValue unspents(UniValue::VARR);
+            for (const auto &entry : entries)
+            {
+                const CGroupTokenInfo tokenGroupInfo(entry.second.out.scriptPubKey);
+                total_in += tokenGroupInfo.quantity;
+                unspents.push_back(TokenOutputToJSON(entry.first, entry.second, tokenGroupInfo));
+            }
+            // Nothing is scanned, so unlike a scan of the utxo set there is no searchedItems
+            result.pushKV("success", true);
+            result.pushKV("unspents", unspents);
+            result.pushKV("totalAmount", total_in);
+            if (fMore)
+                result.pushKV("next", entries.back().first.GetHex());
+            return result;
         }
 
         // Scan the unspent transaction output set for inputs
@@ -2598,29 +2859,10 @@ UniValue scantokens(const UniValue &params, bool fHelp)
 
         for (const auto &it : coins)
         {
-            const COutPoint &outpoint = it.first;
-            const Coin &coin = it.second;
-            const CTxOut &txo = coin.out;
-            const CGroupTokenInfo &tokenGroupInfo = CGroupTokenInfo(txo.scriptPubKey);
-            CTxDestination dest;
-            ExtractDestination(txo.scriptPubKey, dest);
-
-            input_txos.push_back(txo);
+            const CGroupTokenInfo tokenGroupInfo(it.second.out.scriptPubKey);
+            input_txos.push_back(it.second.out);
             total_in += tokenGroupInfo.quantity;
-
-            UniValue unspent(UniValue::VOBJ);
-            unspent.pushKV("outpoint", outpoint.hash.GetHex());
-            if (IsValidDestination(dest))
-            {
-                unspent.pushKV("address", EncodeDestination(dest));
-            }
-            unspent.pushKV("scriptPubKey", HexStr(txo.scriptPubKey.begin(), txo.scriptPubKey.end()));
-            unspent.pushKV("amount", ValueFromAmount(txo.nValue));
-            unspent.pushKV("satoshis", txo.nValue);
-            unspent.pushKV("tokenAmount", tokenGroupInfo.quantity);
-            unspent.pushKV("height", (int32_t)coin.nHeight);
-
-            unspents.push_back(unspent);
+            unspents.push_back(TokenOutputToJSON(it.first.hash, it.second, tokenGroupInfo));
         }
 
         result.pushKV("unspents", unspents);
@@ -2635,6 +2877,108 @@ UniValue scantokens(const UniValue &params, bool fHelp)
 
 #endif
 
+UniValue gettokensupply(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw std::runtime_error(
+            "gettokensupply \"tokenGroupID\"\n"
+            "\nReturns the tokens and authorities of a token group (or subgroup) that are held by unspent outputs.\n"
+            "Requires -tokenindex.\n"
+            "\nArguments:\n"
+            "1. \"tokenGroupID\"    (string, required) Token group identifier\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"groupIdentifier\" : \"id\", (string) The group that was queried\n"
+            "  \"supply\" : n,              (numeric) The tokens held by unspent outputs that are not authorities.\n"
+            "                              A total too large for a 64 bit integer is returned as a decimal string.\n"
+            "  \"utxos\" : n,               (numeric) The number of unspent outputs holding tokens\n"
+            "  \"authorities\" : n,         (numeric) The number of unspent authority outputs\n"
+            "  \"mintAuthorities\" : n,     (numeric) How many of the authorities can mint\n"
+            "  \"meltAuthorities\" : n      (numeric) How many of the authorities can melt\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("gettokensupply", "\"nexa:tr9v70v4s9s6jfwz32ts60zqmmkp50lqv7t0ux620d50xa7dhyqqqcg6kdm6f\"") +
+            HelpExampleRpc("gettokensupply", "\"nexa:tr9v70v4s9s6jfwz32ts60zqmmkp50lqv7t0ux620d50xa7dhyqqqcg6kdm6f\""));
+
+    if (!UseTokenIndex())
+        throw JSONRPCError(RPC_MISC_ERROR, "The token index is not enabled, restart with -tokenindex");
+    const CGroupTokenID group = ParseTokenGroup(params[0]);
+
+    CTokenSupply supply;
+    if (!g_tokenindex->GetSupply(group, supply))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the token index");
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("groupIdentifier", EncodeGroupToken(group));
+    if (supply.SupplyFitsAmount())
+        result.pushKV("supply", supply.supply);
+    else
+        result.pushKV("supply", supply.SupplyToString());
+    result.pushKV("utxos", supply.nUnspent);
+    result.pushKV("authorities", supply.nAuthorities);
+    result.pushKV("mintAuthorities", supply.nMintAuthorities);
+    result.pushKV("meltAuthorities", supply.nMeltAuthorities);
+    return result;
+}
+
+UniValue listtokenutxos(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 4)
+        throw std::runtime_error(
+            "listtokenutxos \"tokenGroupID\" ( limit \"after\" authorities )\n"
+            "\nReturns the unspent outputs holding tokens of a token group (or subgroup), or its unspent authorities.\n"
+            "Requires -tokenindex.\n"
+            "\nArguments:\n"
+            "1. \"tokenGroupID\"    (string, required) Token group identifier\n"
+            "2. limit              (numeric, optional, default=" +
+            std::to_string(DEFAULT_TOKENINDEX_PAGE) +
+            ") The maximum number of outputs to return\n"
+            "3. \"after\"            (string, optional) Continue after this outpoint, as returned in \"next\"\n"
+            "4. authorities        (boolean, optional, default=false) List the authorities instead of the tokens\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"groupIdentifier\" : \"id\", (string) The group that was queried\n"
+            "  \"utxos\" : [\n"
+            "    {\n"
+            "      \"outpoint\" : \"hex\",     (string) The outpoint hash\n"
+            "      \"address\" : \"address\",  (string) The address that holds the output\n"
+            "      \"scriptPubKey\" : \"hex\", (string) The output script\n"
+            "      \"amount\" : x.xxx,       (numeric) The output value\n"
+            "      \"satoshis\" : n,         (numeric) The output value in satoshis\n"
+            "      \"tokenAmount\" : n,      (numeric) The tokens held by the output (not for authorities)\n"
+            "      \"authority\" : [...],    (array) The permissions of an authority (only for authorities)\n"
+            "      \"height\" : n            (numeric) The height of the block containing the output\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"next\" : \"hex\"          (string, optional) Pass as \"after\" to fetch the next page\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("listtokenutxos", "\"nexa:tr9v70v4s9s6jfwz32ts60zqmmkp50lqv7t0ux620d50xa7dhyqqqcg6kdm6f\"") +
+            HelpExampleRpc(
+                "listtokenutxos", "\"nexa:tr9v70v4s9s6jfwz32ts60zqmmkp50lqv7t0ux620d50xa7dhyqqqcg6kdm6f\", 100"));
+
+    if (!UseTokenIndex())
+        throw JSONRPCError(RPC_MISC_ERROR, "The token index is not enabled, restart with -tokenindex");
+    const CGroupTokenID group = ParseTokenGroup(params[0]);
+    const bool fAuthorities = params.size() > 3 && params[3].get_bool();
+
+    std::vector<std::pair<uint256, Coin> > entries;
+    bool fMore = ReadTokenPage(group, fAuthorities, params[1], params[2], entries);
+
+    UniValue utxos(UniValue::VARR);
+    for (const auto &entry : entries)
+    {
+        utxos.push_back(TokenOutputToJSON(entry.first, entry.second, CGroupTokenInfo(entry.second.out.scriptPubKey)));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("groupIdentifier", EncodeGroupToken(group));
+    result.pushKV("utxos", utxos);
+    if (fMore)
+        result.pushKV("next", entries.back().first.GetHex());
+    return result;
+}
+
 static const CRPCCommand commands[] = {
     //  category              name                      actor (function)         okSafeMode
     //  --------------------- ------------------------  -----------------------  ----------
@@ -2665,6 +3009,8 @@ static const CRPCCommand commands[] = {
 #ifdef ENABLE_WALLET
     {"blockchain", "scantokens", &scantokens, true},
 #endif
+    {"blockchain", "gettokensupply", &gettokensupply, true},
+    {"blockchain", "listtokenutxos", &listtokenutxos, true},
     /* Not shown in help */
     {"hidden", "invalidateblock", &invalidateblock, true},
     {"hidden", "reconsiderblock", &reconsiderblock, true},
@@ -2678,4 +3024,6 @@ void RegisterBlockchainRPCCommands(CRPCTable &table)
 {
     for (auto cmd : commands)
         table.appendCommand(cmd);
+    table.appendStreamer("getblock", &getblockStreamed);
+    table.appendStreamer("getrawtxpool", &getrawtxpoolStreamed);
 }
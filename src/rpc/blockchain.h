@@ -13,6 +13,7 @@
 
 class CBlock;
 class CBlockIndex;
+class JSONStreamWriter;
 class UniValue;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
@@ -48,6 +49,13 @@ std::set<CBlockIndex *, CompareBlocksByHeight> GetChainTips();
 
 UniValue mempoolToJSON(bool fVerbose = false, bool idem = false);
 UniValue blockToJSON(const CBlock &block, const CBlockIndex *blockindex, bool txDetails = false, bool listTxns = true);
+/** Write the same JSON as mempoolToJSON() and blockToJSON() to a stream, without building it in memory first */
+void mempoolToJSON(JSONStreamWriter &out, bool fVerbose = false, bool idem = false);
+void blockToJSON(JSONStreamWriter &out,
+    const CBlock &block,
+    const CBlockIndex *blockindex,
+    bool txDetails = false,
+    bool listTxns = true);
 void ScriptPubKeyToJSON(const CScript &scriptPubKey, UniValue &out, bool fIncludeHex);
 
 #endif
@@ -2,10 +2,22 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "dstencode.h"
 #include "electrum/electrumrpcinfo.h"
+#include "index/addressindex.h"
 #include "rpc/server.h"
+#include "script/standard.h"
+#include "utilstrencodings.h"
 #include <univalue.h>
 
+#include <boost/algorithm/string.hpp>
+
+using namespace std;
+
+//! default and max number of entries returned by one getaddresshistory or getaddressutxos call
+static const int64_t DEFAULT_ADDRESSINDEX_PAGE = 1000;
+static const int64_t MAX_ADDRESSINDEX_PAGE = 100000;
+
 UniValue getelectruminfo(const UniValue &params, bool fHelp)
 {
     if (fHelp || params.size() != 0)
@@ -15,9 +27,255 @@ UniValue getelectruminfo(const UniValue &params, bool fHelp)
     return electrum::ElectrumRPCInfo().GetElectrumInfo();
 }
 
+/** Accept either an address or an Electrum-style scripthash (hex, as displayed by Electrum clients) */
+static uint256 ParseScriptHashOrAddress(const std::string &str)
+{
+    if (str.size() == 64 && IsHex(str))
+        return uint256S(str);
+
+    CTxDestination dest = DecodeDestination(str);
+    if (!IsValidDestination(dest))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or scripthash: " + str);
+    return ScriptHash(GetScriptForDestination(dest));
+}
+
+static void CheckAddressIndex()
+{
+    if (!g_addressindex)
+        throw JSONRPCError(RPC_MISC_ERROR, "The address index is not enabled, restart with -addressindex");
+    if (!g_addressindex->IsSynced())
+        throw JSONRPCError(RPC_MISC_ERROR, "The address index is still syncing with the block chain");
+}
+
+static size_t ParsePageSize(const UniValue &param)
+{
+    int64_t nMax = param.get_int64();
+    if (nMax <= 0 || nMax > MAX_ADDRESSINDEX_PAGE)
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER, strprintf("limit must be between 1 and %d", MAX_ADDRESSINDEX_PAGE));
+    return nMax;
+}
+
+/** Where a page of history ended, as "height:txhash:index:spend".  A single block can hold more entries of a
+ * scripthash than fit in a page, so the height alone is not enough to continue from.
+ */
+static std::string HistoryCursor(const CAddressHistoryKey &key)
+{
+    return strprintf("%u:%s:%u:%d", key.height, key.txhash.GetHex(), key.index, key.fSpend ? 1 : 0);
+}
+
+static CAddressHistoryKey ParseHistoryCursor(const uint256 &scripthash, const std::string &str)
+{
+    std::vector<std::string> parts;
+    boost::split(parts, str, boost::is_any_of(":"));
+    int32_t nHeight, nIndex, nSpend;
+    if (parts.size() != 4 || !ParseInt32(parts[0], &nHeight) || nHeight < 0 || parts[1].size() != 64 ||
+        !IsHex(parts[1]) || !ParseInt32(parts[2], &nIndex) || nIndex < 0 || !ParseInt32(parts[3], &nSpend) ||
+        (nSpend != 0 && nSpend != 1))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid history cursor: " + str);
+    return CAddressHistoryKey(scripthash, nHeight, uint256S(parts[1]), nIndex, nSpend == 1);
+}
+
+UniValue getaddresshistory(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 4)
+        throw runtime_error(
+            "getaddresshistory \"address|scripthash\" ( fromheight limit \"after\" )\n"
+            "\nReturns the confirmed history of an address or Electrum-style scripthash, in block order.\n"
+            "Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address|scripthash\" (string, required) The address or scripthash (hex)\n"
+            "2. fromheight            (numeric, optional, default=0) Only return entries at or above this height\n"
+            "3. limit                 (numeric, optional, default=" +
+            std::to_string(DEFAULT_ADDRESSINDEX_PAGE) +
+            ") The maximum number of entries to return\n"
+            "4. \"after\"               (string, optional) Continue after this entry, as returned in \"next\".\n"
+            "                          fromheight is ignored when this is given\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"scripthash\" : \"hex\",   (string) The scripthash that was queried\n"
+            "  \"count\" : n,              (numeric) The total number of history entries\n"
+            "  \"history\" : [\n"
+            "    {\n"
+            "      \"height\" : n,         (numeric) The height of the block containing the transaction\n"
+            "      \"tx_hash\" : \"hex\",  (string) The idem of a funding tx, or the id of a spending tx\n"
+            "      \"spend\" : true|false, (boolean) Whether this entry spends an output of the scripthash\n"
+            "      \"index\" : n,          (numeric) The output index when funding, the input index when spending\n"
+            "      \"amount\" : x.xxx      (numeric) The amount received (positive) or spent (negative)\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"more\" : true|false,      (boolean) Whether limit was reached before the end of the history\n"
+            "  \"next\" : \"cursor\"       (string, optional) Pass as \"after\" to fetch the next page\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getaddresshistory", "\"nexa:nqtsq5g5...\"") +
+            HelpExampleRpc("getaddresshistory", "\"nexa:nqtsq5g5...\", 100000, 500"));
+
+    CheckAddressIndex();
+    const uint256 scripthash = ParseScriptHashOrAddress(params[0].get_str());
+    uint32_t nFromHeight = 0;
+    if (params.size() > 1)
+    {
+        int nHeight = params[1].get_int();
+        if (nHeight < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "fromheight must not be negative");
+        nFromHeight = nHeight;
+    }
+    size_t nMax = DEFAULT_ADDRESSINDEX_PAGE;
+    if (params.size() > 2)
+        nMax = ParsePageSize(params[2]);
+
+    CAddressBalance balance;
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > entries;
+    bool fOk = g_addressindex->GetBalance(scripthash, balance);
+    if (params.size() > 3)
+    {
+        CAddressHistoryKey after = ParseHistoryCursor(scripthash, params[3].get_str());
+        fOk = fOk && g_addressindex->GetHistory(after, nMax + 1, entries);
+    }
+    else
+        fOk = fOk && g_addressindex->GetHistory(scripthash, nFromHeight, nMax + 1, entries);
+    if (!fOk)
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address index");
+
+    bool fMore = entries.size() > nMax;
+    if (fMore)
+        entries.resize(nMax);
+
+    UniValue history(UniValue::VARR);
+    for (const auto &entry : entries)
+    {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("height", (int64_t)entry.first.height);
+        obj.pushKV("tx_hash", entry.first.txhash.GetHex());
+        obj.pushKV("spend", entry.first.fSpend);
+        obj.pushKV("index", (int64_t)entry.first.index);
+        obj.pushKV("amount", ValueFromAmount(entry.second.amount));
+        history.push_back(obj);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("scripthash", scripthash.GetHex());
+    result.pushKV("count", balance.nHistory);
+    result.pushKV("history", history);
+    result.pushKV("more", fMore);
+    if (fMore)
+        result.pushKV("next", HistoryCursor(entries.back().first));
+    return result;
+}
+
+UniValue getaddressbalance(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error("getaddressbalance \"address|scripthash\"\n"
+                            "\nReturns the confirmed balance of an address or Electrum-style scripthash.\n"
+                            "Requires -addressindex.\n"
+                            "\nArguments:\n"
+                            "1. \"address|scripthash\" (string, required) The address or scripthash (hex)\n"
+                            "\nResult:\n"
+                            "{\n"
+                            "  \"scripthash\" : \"hex\", (string) The scripthash that was queried\n"
+                            "  \"confirmed\" : x.xxx,    (numeric) The confirmed balance\n"
+                            "  \"received\" : x.xxx,     (numeric) The total amount ever received\n"
+                            "  \"history\" : n,          (numeric) The number of history entries\n"
+                            "  \"utxos\" : n             (numeric) The number of unspent outputs\n"
+                            "}\n"
+                            "\nExamples:\n" +
+                            HelpExampleCli("getaddressbalance", "\"nexa:nqtsq5g5...\"") +
+                            HelpExampleRpc("getaddressbalance", "\"nexa:nqtsq5g5...\""));
+
+    CheckAddressIndex();
+    const uint256 scripthash = ParseScriptHashOrAddress(params[0].get_str());
+
+    CAddressBalance balance;
+    if (!g_addressindex->GetBalance(scripthash, balance))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address index");
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("scripthash", scripthash.GetHex());
+    result.pushKV("confirmed", ValueFromAmount(balance.balance));
+    result.pushKV("received", ValueFromAmount(balance.received));
+    result.pushKV("history", balance.nHistory);
+    result.pushKV("utxos", balance.nUnspent);
+    return result;
+}
+
+UniValue getaddressutxos(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 3)
+        throw runtime_error(
+            "getaddressutxos \"address|scripthash\" ( limit \"after\" )\n"
+            "\nReturns the confirmed unspent outputs of an address or Electrum-style scripthash.\n"
+            "Requires -addressindex.\n"
+            "\nArguments:\n"
+            "1. \"address|scripthash\" (string, required) The address or scripthash (hex)\n"
+            "2. limit                 (numeric, optional, default=" +
+            std::to_string(DEFAULT_ADDRESSINDEX_PAGE) +
+            ") The maximum number of outputs to return\n"
+            "3. \"after\"               (string, optional) Continue after this outpoint, as returned in \"next\"\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"scripthash\" : \"hex\",   (string) The scripthash that was queried\n"
+            "  \"utxos\" : [\n"
+            "    {\n"
+            "      \"outpoint\" : \"hex\", (string) The outpoint hash\n"
+            "      \"txidem\" : \"hex\",   (string) The idem of the transaction that created the output\n"
+            "      \"n\" : n,              (numeric) The output index\n"
+            "      \"height\" : n,         (numeric) The height of the block containing the output\n"
+            "      \"amount\" : x.xxx,     (numeric) The output value\n"
+            "      \"satoshis\" : n        (numeric) The output value in satoshis\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"next\" : \"hex\"          (string, optional) Pass as \"after\" to fetch the next page\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getaddressutxos", "\"nexa:nqtsq5g5...\"") +
+            HelpExampleRpc("getaddressutxos", "\"nexa:nqtsq5g5...\", 100"));
+
+    CheckAddressIndex();
+    const uint256 scripthash = ParseScriptHashOrAddress(params[0].get_str());
+    size_t nMax = DEFAULT_ADDRESSINDEX_PAGE;
+    if (params.size() > 1)
+        nMax = ParsePageSize(params[1]);
+    uint256 after;
+    if (params.size() > 2)
+        after = ParseHashV(params[2], "after");
+
+    std::vector<std::pair<uint256, CAddressUnspentValue> > entries;
+    if (!g_addressindex->GetUnspent(scripthash, after, nMax + 1, entries))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address index");
+
+    bool fMore = entries.size() > nMax;
+    if (fMore)
+        entries.resize(nMax);
+
+    UniValue utxos(UniValue::VARR);
+    for (const auto &entry : entries)
+    {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("outpoint", entry.first.GetHex());
+        obj.pushKV("txidem", entry.second.txidem.GetHex());
+        obj.pushKV("n", (int64_t)entry.second.n);
+        obj.pushKV("height", (int64_t)entry.second.height);
+        obj.pushKV("amount", ValueFromAmount(entry.second.amount));
+        obj.pushKV("satoshis", entry.second.amount);
+        utxos.push_back(obj);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("scripthash", scripthash.GetHex());
+    result.pushKV("utxos", utxos);
+    if (fMore)
+        result.pushKV("next", entries.back().first.GetHex());
+    return result;
+}
+
 static const CRPCCommand commands[] = {
     //  category, name, function, okSafeMode
     {"electrum", "getelectruminfo", &getelectruminfo, true},
+    {"electrum", "getaddresshistory", &getaddresshistory, true},
+    {"electrum", "getaddressbalance", &getaddressbalance, true},
+    {"electrum", "getaddressutxos", &getaddressutxos, true},
 };
 
 void RegisterElectrumRPC(CRPCTable &table)
@@ -0,0 +1,180 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include <univalue.h>
+
+JSONStreamWriter::JSONStreamWriter(const Sink &_sink, size_t _chunkSize) : sink(_sink), chunkSize(_chunkSize)
+{
+    buf.reserve(chunkSize + 1024);
+}
+
+void JSONStreamWriter::Next()
+{
+    if (fAfterKey)
+    {
+        fAfterKey = false;
+        return;
+    }
+    if (!vEmpty.empty())
+    {
+        if (!vEmpty.back())
+            buf += ',';
+        vEmpty.back() = false;
+    }
+}
+
+void JSONStreamWriter::MaybeFlush()
+{
+    if (buf.size() >= chunkSize)
+        Flush();
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (buf.empty())
+        return;
+    if (!fAborted && !sink(buf))
+        fAborted = true;
+    nFlushed += buf.size();
+    buf.clear();
+}
+
+void JSONStreamWriter::Append(const std::string &text)
+{
+    buf += text;
+    MaybeFlush();
+}
+
+// The same escaping as UniValue::write()
+void JSONStreamWriter::AppendString(const std::string &str)
+{
+    static const char hex[] = "0123456789abcdef";
+    buf += '"';
+    for (unsigned char ch : str)
+    {
+        switch (ch)
+        {
+        case '"':
+            buf += "\\\"";
+            break;
+        case '\\':
+            buf += "\\\\";
+            break;
+        case '\b':
+            buf += "\\b";
+            break;
+        case '\t':
+            buf += "\\t";
+            break;
+        case '\n':
+            buf += "\\n";
+            break;
+        case '\f':
+            buf += "\\f";
+            break;
+        case '\r':
+            buf += "\\r";
+            break;
+        default:
+            if (ch < 0x20 || ch == 0x7f)
+            {
+                buf += "\\u00";
+                buf += hex[ch >> 4];
+                buf += hex[ch & 0xf];
+            }
+            else
+                buf += ch;
+        }
+    }
+    buf += '"';
+    MaybeFlush();
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    Next();
+    buf += '{';
+    vEmpty.push_back(true);
+}
+
+void JSONStreamWriter::BeginObject(const UniValue &head)
+{
+    Next();
+    std::string text = head.write();
+    text.pop_back(); // leave the object open
+    buf += text;
+    vEmpty.push_back(head.empty());
+    MaybeFlush();
+}
+
+void JSONStreamWriter::EndObject()
+{
+    vEmpty.pop_back();
+    Append("}");
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    Next();
+    buf += '[';
+    vEmpty.push_back(true);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    vEmpty.pop_back();
+    Append("]");
+}
+
+void JSONStreamWriter::Key(const std::string &key)
+{
+    Next();
+    AppendString(key);
+    buf += ':';
+    fAfterKey = true;
+}
+
+void JSONStreamWriter::Value(const std::string &str)
+{
+    Next();
+    AppendString(str);
+}
+
+void JSONStreamWriter::Value(const char *str) { Value(std::string(str)); }
+
+void JSONStreamWriter::Value(int64_t num)
+{
+    Next();
+    Append(std::to_string(num));
+}
+
+void JSONStreamWriter::Value(uint64_t num)
+{
+    Next();
+    Append(std::to_string(num));
+}
+
+void JSONStreamWriter::Value(int num) { Value((int64_t)num); }
+
+void JSONStreamWriter::Value(bool flag)
+{
+    Next();
+    Append(flag ? "true" : "false");
+}
+
+void JSONStreamWriter::Value(const UniValue &value)
+{
+    Next();
+    Append(value.write());
+}
+
+void JSONStreamWriter::Null()
+{
+    Next();
+    Append("null");
+}
+
+void JSONStreamWriter::Raw(const std::string &text) { Append(text); }
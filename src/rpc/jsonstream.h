@@ -0,0 +1,88 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_RPC_JSONSTREAM_H
+#define NEXA_RPC_JSONSTREAM_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class UniValue;
+
+/** Writes JSON text in pieces to a sink as it is produced, so that large replies do not have to be built as a
+ * UniValue tree and then written to one string.  The output is the same compact form as UniValue::write().
+ *
+ * Containers are opened and closed explicitly and the writer adds the separators.  Small parts that are already
+ * UniValues, like a single transaction, can be written whole with Value().
+ */
+class JSONStreamWriter
+{
+public:
+    /** Receives the next piece of output.  Returns false if the output is no longer wanted, for example because
+     * the client went away, after which the writer drops everything.
+     */
+    typedef std::function<bool(const std::string &)> Sink;
+
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    JSONStreamWriter(const Sink &sink, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    void BeginObject();
+    /** Start an object that begins with the members of head, so further members can be added with Key() */
+    void BeginObject(const UniValue &head);
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Write the key of the next member of the current object */
+    void Key(const std::string &key);
+
+    void Value(const std::string &str);
+    void Value(const char *str);
+    void Value(int64_t num);
+    void Value(uint64_t num);
+    void Value(int num);
+    void Value(bool flag);
+    void Value(const UniValue &value);
+    void Null();
+
+    /** Write a member of the current object */
+    template <typename T>
+    void KV(const std::string &key, const T &value)
+    {
+        Key(key);
+        Value(value);
+    }
+
+    /** Append text that is not part of the JSON value, like a trailing newline */
+    void Raw(const std::string &text);
+
+    /** Hand everything written so far to the sink */
+    void Flush();
+
+    /** True once the sink has refused output.  Long loops should check this to stop early. */
+    bool Aborted() const { return fAborted; }
+    /** The number of bytes handed to the sink or waiting to be */
+    uint64_t BytesWritten() const { return nFlushed + buf.size(); }
+
+private:
+    //! Write the separator needed before a new value
+    void Next();
+    void Append(const std::string &text);
+    void AppendString(const std::string &str);
+    void MaybeFlush();
+
+    Sink sink;
+    size_t chunkSize;
+    std::string buf;
+    //! One entry per open container, true until it has a first member
+    std::vector<bool> vEmpty;
+    //! True right after a key, when the value needs no separator
+    bool fAfterKey = false;
+    bool fAborted = false;
+    uint64_t nFlushed = 0;
+};
+
+#endif // NEXA_RPC_JSONSTREAM_H
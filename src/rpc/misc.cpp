@@ -11,16 +11,20 @@
 #include "main.h"
 #include "net.h"
 #include "netbase.h"
+#include "pubkey.h"
 #include "rpc/blockchain.h"
 #include "rpc/server.h"
 #include "timedata.h"
 #include "util.h"
 #include "utilstrencodings.h"
+#include "utiltime.h"
+#include "workerpool.h"
 #ifdef ENABLE_WALLET
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #endif
 
+#include <algorithm>
 #include <stdint.h>
 #include <univalue.h>
 
@@ -463,6 +467,83 @@ UniValue verifymessage(const UniValue &params, bool fHelp)
     return (pubkey.GetID() == *keyID);
 }
 
+UniValue verifysignatures(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 2)
+        throw runtime_error(
+            "verifysignatures [{\"pubkey\":\"hex\",\"hash\":\"hex\",\"sig\":\"hex\"},...] ( threads )\n"
+            "\nVerify a batch of signatures of 32 byte hashes, spread across several threads.\n"
+            "A 64 byte signature is verified as Schnorr and any other as DER encoded ECDSA.\n"
+            "\nArguments:\n"
+            "1. \"signatures\"  (array, required) The signatures to verify\n"
+            "    [\n"
+            "      {\n"
+            "        \"pubkey\":\"hex\",  (string, required) The serialized public key\n"
+            "        \"hash\":\"hex\",    (string, required) The 32 byte hash that was signed, in the byte order\n"
+            "                              it was signed in (not reversed)\n"
+            "        \"sig\":\"hex\"      (string, required) The signature, without a sighash type\n"
+            "      }\n"
+            "      ,...\n"
+            "    ]\n"
+            "2. threads        (numeric, optional, default=0) The most threads to use, at most the node's worker\n"
+            "                  threads and the calling one.  0 picks the number of threads from the number of\n"
+            "                  signatures.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"results\": [true|false,...],  (array) Whether each signature is valid, in order\n"
+            "  \"valid\": n,                   (numeric) The number of valid signatures\n"
+            "  \"invalid\": n,                 (numeric) The number of invalid signatures\n"
+            "  \"elapsed\": n,                 (numeric) Seconds spent verifying\n"
+            "  \"persecond\": n                (numeric) Signatures verified per second\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("verifysignatures", "\"[{\\\"pubkey\\\":\\\"02...\\\",\\\"hash\\\":\\\"ab...\\\","
+                                               "\\\"sig\\\":\\\"cd...\\\"}]\"") +
+            HelpExampleRpc("verifysignatures", "[{\"pubkey\":\"02...\",\"hash\":\"ab...\",\"sig\":\"cd...\"}], 4"));
+
+    RPCTypeCheck(params, {UniValue::VARR, UniValue::VNUM});
+    const UniValue &items = params[0].get_array();
+    unsigned int nThreads = 0;
+    if (params.size() > 1)
+    {
+        const int64_t n = params[1].get_int64();
+        if (n < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, threads must not be negative");
+        nThreads = std::min<int64_t>(n, workerPool.Size() + 1);
+    }
+
+    std::vector<CHashSignature> batch(items.size());
+    for (unsigned int i = 0; i < items.size(); i++)
+    {
+        const UniValue &item = items[i];
+        RPCTypeCheckObj(item, {{"pubkey", UniValue::VSTR}, {"hash", UniValue::VSTR}, {"sig", UniValue::VSTR}});
+        std::vector<unsigned char> hash = ParseHexO(item, "hash");
+        if (hash.size() != 32)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid parameter, hash %u must be 32 bytes", i));
+        batch[i].hash = uint256(hash);
+        std::vector<unsigned char> pubkey = ParseHexO(item, "pubkey");
+        batch[i].pubkey.Set(pubkey.begin(), pubkey.end());
+        batch[i].sig = ParseHexO(item, "sig");
+    }
+
+    const int64_t nStart = GetTimeMicros();
+    std::vector<unsigned char> valid = VerifySignatures(batch, nThreads);
+    const int64_t nElapsed = GetTimeMicros() - nStart;
+
+    UniValue results(UniValue::VARR);
+    for (unsigned char v : valid)
+        results.push_back(v != 0);
+    const int64_t nValid = std::count(valid.begin(), valid.end(), 1);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("results", results);
+    ret.pushKV("valid", nValid);
+    ret.pushKV("invalid", (int64_t)valid.size() - nValid);
+    ret.pushKV("elapsed", nElapsed / 1000000.0);
+    ret.pushKV("persecond", nElapsed > 0 ? valid.size() * 1000000.0 / nElapsed : 0.0);
+    return ret;
+}
+
 UniValue setmocktime(const UniValue &params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -500,6 +581,7 @@ static const CRPCCommand commands[] = {
     {"util", "validateaddress", &validateaddress, true}, /* uses wallet if enabled */
     {"util", "createmultisig", &createmultisig, true},
     {"util", "verifymessage", &verifymessage, true},
+    {"util", "verifysignatures", &verifysignatures, true},
     {"util", "logline", &logline, true},
 
     /* Not shown in help */
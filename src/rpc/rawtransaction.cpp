@@ -15,6 +15,7 @@
 #include "init.h"
 #include "keystore.h"
 #include "main.h"
+#include "memusage.h"
 #include "merkleblock.h"
 #include "net.h"
 #include "policy/policy.h"
@@ -34,7 +35,9 @@
 #include "wallet/wallet.h"
 #endif
 
+#include <list>
 #include <stdint.h>
+#include <unordered_map>
 
 #include <boost/algorithm/string.hpp>
 
@@ -678,6 +681,107 @@ UniValue getrawtransactionssince(const UniValue &params, bool fHelp)
     return resultSet;
 }
 
+//! The memory the merkle trees of recently used blocks may take while they are kept for building transaction proofs
+static const size_t MAX_PROOF_TREE_CACHE_BYTES = 64 * 1024 * 1024;
+
+namespace
+{
+/** The merkle tree of a block and the position of each of its transactions, so that any number of transaction
+    proofs can be taken from a block without reading and hashing it again for every request */
+class CBlockProofTree
+{
+public:
+    const CBlockHeader header;
+    const uint256 hashBlock;
+    const CMerkleTree tree;
+    //! The position of every transaction in the block, by id and by idem
+    std::unordered_map<uint256, uint32_t, SaltedTxidHasher> positions;
+    //! Approximately how much memory the tree and the positions take
+    size_t nUsage;
+
+    explicit CBlockProofTree(const CBlock &block)
+        : header(block.GetBlockHeader()), hashBlock(block.GetHash()), tree(BlockMerkleTree(block))
+    {
+        positions.reserve(block.vtx.size() * 2);
+        for (uint32_t i = 0; i < block.vtx.size(); i++)
+        {
+            positions.emplace(block.vtx[i]->GetId(), i);
+            positions.emplace(block.vtx[i]->GetIdem(), i);
+        }
+        nUsage = sizeof(*this) + memusage::DynamicUsage(positions);
+        for (int height = 0; height <= tree.GetHeight(); height++)
+            nUsage += memusage::MallocUsage(tree.GetWidth(height) * sizeof(uint256));
+    }
+
+    /** Return the position of the transaction with this id or idem, or false if it is not in the block */
+    bool Find(const uint256 &hash, uint32_t &pos) const
+    {
+        auto it = positions.find(hash);
+        if (it == positions.end())
+            return false;
+        pos = it->second;
+        return true;
+    }
+
+    /** Serialize a proof of the transactions at these positions as hex */
+    std::string Proof(std::vector<uint32_t> vPos) const
+    {
+        std::sort(vPos.begin(), vPos.end());
+        vPos.erase(std::unique(vPos.begin(), vPos.end()), vPos.end());
+        CDataStream ssMB(SER_NETWORK, PROTOCOL_VERSION);
+        ssMB << CMerkleBlock(header, tree, vPos);
+        return HexStr(ssMB.begin(), ssMB.end());
+    }
+};
+typedef std::shared_ptr<const CBlockProofTree> CBlockProofTreeRef;
+
+/** The proof trees of the most recently used blocks, up to MAX_PROOF_TREE_CACHE_BYTES.  A tree larger than that on
+    its own is returned to the caller but not kept. */
+class CProofTreeCache
+{
+private:
+    CCriticalSection cs_trees;
+    //! most recently used first
+    std::list<CBlockProofTreeRef> trees GUARDED_BY(cs_trees);
+    size_t nUsage GUARDED_BY(cs_trees) = 0;
+
+public:
+    CBlockProofTreeRef Get(const CBlockIndex *pindex)
+    {
+        const uint256 hashBlock = pindex->GetBlockHash();
+        {
+            LOCK(cs_trees);
+            for (auto it = trees.begin(); it != trees.end(); ++it)
+            {
+                if ((*it)->hashBlock == hashBlock)
+                {
+                    trees.splice(trees.begin(), trees, it);
+                    return trees.front();
+                }
+            }
+        }
+
+        // Read and hash the block without holding the lock, so requests for other cached blocks are not held up
+        const ConstCBlockRef pblock = ReadBlockFromDisk(pindex, Params().GetConsensus());
+        if (!pblock)
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+        CBlockProofTreeRef proofTree = std::make_shared<const CBlockProofTree>(*pblock);
+
+        LOCK(cs_trees);
+        trees.push_front(proofTree);
+        nUsage += proofTree->nUsage;
+        while (nUsage > MAX_PROOF_TREE_CACHE_BYTES && !trees.empty())
+        {
+            nUsage -= trees.back()->nUsage;
+            trees.pop_back();
+        }
+        return proofTree;
+    }
+};
+} // namespace
+
+static CProofTreeCache proofTreeCache;
+
 UniValue gettxoutproof(const UniValue &params, bool fHelp)
 {
     if (fHelp || (params.size() != 1 && params.size() != 2))
@@ -700,7 +804,6 @@ UniValue gettxoutproof(const UniValue &params, bool fHelp)
             "\"data\"           (string) A string that is a serialized, hex-encoded data for the proof.\n");
 
     set<uint256> setTxHashes; // I dont know if its id or idem
-    set<uint256> setTxids;
     uint256 oneTxid;
     UniValue txids = params[0].get_array();
     for (unsigned int idx = 0; idx < txids.size(); idx++)
@@ -762,27 +865,17 @@ UniValue gettxoutproof(const UniValue &params, bool fHelp)
             throw JSONRPCError(RPC_INTERNAL_ERROR, "Transaction index corrupt");
     }
 
-    const ConstCBlockRef pblock = ReadBlockFromDisk(pblockindex, Params().GetConsensus());
-    if (!pblock)
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    const CBlockProofTreeRef proofTree = proofTreeCache.Get(pblockindex);
 
-    unsigned int ntxFound = 0;
-    for (const auto &tx : pblock->vtx)
+    std::vector<uint32_t> vPos;
+    for (const uint256 &hash : setTxHashes)
     {
-        if (setTxHashes.count(tx->GetId()) || setTxHashes.count(tx->GetIdem()))
-        {
-            ntxFound++;
-            setTxids.insert(tx->GetId());
-        }
+        uint32_t pos;
+        if (!proofTree->Find(hash, pos))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "(Not all) transactions not found in specified block");
+        vPos.push_back(pos);
     }
-    if (ntxFound != setTxHashes.size())
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "(Not all) transactions not found in specified block");
-
-    CDataStream ssMB(SER_NETWORK, PROTOCOL_VERSION);
-    CMerkleBlock mb(*pblock, setTxids);
-    ssMB << mb;
-    std::string strHex = HexStr(ssMB.begin(), ssMB.end());
-    return strHex;
+    return proofTree->Proof(std::move(vPos));
 }
 
 UniValue gettxoutproofs(const UniValue &params, bool fHelp)
@@ -833,32 +926,18 @@ UniValue gettxoutproofs(const UniValue &params, bool fHelp)
     if (!pblockindex)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    const ConstCBlockRef pblock = ReadBlockFromDisk(pblockindex, Params().GetConsensus());
-    if (!pblock)
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    const CBlockProofTreeRef proofTree = proofTreeCache.Get(pblockindex);
 
     UniValue resultSet(UniValue::VOBJ);
 
     for (const auto &txid : setTxHashes)
     {
-        std::set<uint256> setTxid;
-        for (const auto &tx : pblock->vtx)
-        {
-            if (txid == tx->GetId() || txid == tx->GetIdem())
-            {
-                setTxid.insert(tx->GetId());
-                break;
-            }
-        }
-        if (setTxid.size() == 0)
+        uint32_t pos;
+        if (!proofTree->Find(txid, pos))
         {
             continue;
         }
-        CDataStream ssMB(SER_NETWORK, PROTOCOL_VERSION);
-        CMerkleBlock mb(*pblock, setTxid);
-        ssMB << mb;
-        std::string strHex = HexStr(ssMB.begin(), ssMB.end());
-        resultSet.pushKV(txid.ToString(), strHex);
+        resultSet.pushKV(txid.ToString(), proofTree->Proof({pos}));
     }
     return resultSet;
 }
@@ -30,6 +30,9 @@ void RegisterNexaRPCCommands(CRPCTable &table);
 /** Register CAPD RPC commands */
 void RegisterCapdRPCCommands(CRPCTable &table);
 
+/** Register RPC server statistics commands */
+void RegisterRPCStatsCommands(CRPCTable &table);
+
 static inline void RegisterAllCoreRPCCommands(CRPCTable &tableRPC)
 {
     RegisterBlockchainRPCCommands(tableRPC);
@@ -41,6 +44,7 @@ static inline void RegisterAllCoreRPCCommands(CRPCTable &tableRPC)
     RegisterElectrumRPC(tableRPC);
     RegisterNexaRPCCommands(tableRPC);
     RegisterCapdRPCCommands(tableRPC);
+    RegisterRPCStatsCommands(tableRPC);
 }
 
 #endif // NEXA_RPC_REGISTER_H
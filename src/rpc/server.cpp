@@ -11,6 +11,7 @@
 #include "fs.h"
 #include "init.h"
 #include "random.h"
+#include "rpc/stats.h"
 #include "sync.h"
 #include "ui_interface.h"
 #include "util.h"
@@ -135,6 +136,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     {"gettxout", 1},
     {"gettxout", 2},
     {"gettxoutproof", 0},
+    {"verifysignatures", 0},
+    {"verifysignatures", 1},
     {"lockunspent", 0},
     {"lockunspent", 1},
     {"importprivkey", 2},
@@ -159,7 +162,14 @@ static const CRPCConvertParam vRPCConvertParams[] =
     {"gettxpoolancestors", 1},
     {"gettxpooldescendants", 1},
     {"getrawtransactionssince", 1},
-    {"getblockstats", 1}
+    {"getblockstats", 1},
+    {"getaddresshistory", 1},
+    {"getaddresshistory", 2},
+    {"getaddressutxos", 1},
+    {"scantokens", 2},
+    {"listtokenutxos", 1},
+    {"listtokenutxos", 3},
+    {"getrpcstats", 0}
 };
 /* clang-format on */
 
@@ -473,6 +483,16 @@ bool CRPCTable::appendCommand(const CRPCCommand &cmd)
     return true;
 }
 
+bool CRPCTable::appendStreamer(const std::string &name, rpcstreamfn_type streamer)
+{
+    if (IsRPCRunning())
+        return false;
+    if (!mapCommands.count(name) || mapStreamers.count(name))
+        return false;
+    mapStreamers[name] = streamer;
+    return true;
+}
+
 bool StartRPC()
 {
     LOG(RPC, "Starting RPC\n");
@@ -579,7 +599,7 @@ std::string JSONRPCExecBatch(const UniValue &vReq)
     return ret.write() + "\n";
 }
 
-UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &preparams) const
+UniValue CRPCTable::convertParams(const std::string &strMethod, const UniValue &preparams) const
 {
     // Return immediately if in warmup
     {
@@ -615,6 +635,12 @@ UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &prepar
     {
         params = preparams;
     }
+    return params;
+}
+
+UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &preparams) const
+{
+    UniValue params = convertParams(strMethod, preparams);
 
     // Find method
     const CRPCCommand *pcmd = tableRPC[strMethod];
@@ -628,6 +654,7 @@ UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &prepar
     g_rpcSignals.PreCommand(*pcmd);
 
     UniValue result;
+    const uint64_t nStart = GetStopwatchMicros();
     try
     {
         // Execute
@@ -635,11 +662,56 @@ UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &prepar
     }
     catch (const std::exception &e)
     {
+        RecordRPCMethodTime(strMethod, GetStopwatchMicros() - nStart);
         throw JSONRPCError(RPC_MISC_ERROR, e.what());
     }
+    catch (...)
+    {
+        RecordRPCMethodTime(strMethod, GetStopwatchMicros() - nStart);
+        throw;
+    }
+    RecordRPCMethodTime(strMethod, GetStopwatchMicros() - nStart);
     return result;
 }
 
+RPCStreamResult CRPCTable::executeStreamed(const std::string &strMethod, const UniValue &preparams) const
+{
+    auto streamer = mapStreamers.find(strMethod);
+    if (streamer == mapStreamers.end())
+        return RPCStreamResult();
+    UniValue params = convertParams(strMethod, preparams);
+
+    const CRPCCommand *pcmd = tableRPC[strMethod];
+    DbgAssert(pcmd, return RPCStreamResult());
+    g_rpcSignals.PreCommand(*pcmd);
+
+    const uint64_t nStart = GetStopwatchMicros();
+    RPCStreamResult write;
+    try
+    {
+        write = streamer->second(params);
+    }
+    catch (const std::exception &e)
+    {
+        RecordRPCMethodTime(strMethod, GetStopwatchMicros() - nStart);
+        throw JSONRPCError(RPC_MISC_ERROR, e.what());
+    }
+    catch (...)
+    {
+        RecordRPCMethodTime(strMethod, GetStopwatchMicros() - nStart);
+        throw;
+    }
+    // The method declined to stream these parameters, the caller falls back to execute()
+    if (!write)
+        return write;
+    // The time recorded includes writing the result out
+    return [write, strMethod, nStart](JSONStreamWriter &out)
+    {
+        write(out);
+        RecordRPCMethodTime(strMethod, GetStopwatchMicros() - nStart);
+    };
+}
+
 std::vector<std::string> CRPCTable::listCommands() const
 {
     std::vector<std::string> commandList;
@@ -11,6 +11,7 @@
 #include "rpc/protocol.h"
 #include "uint256.h"
 
+#include <functional>
 #include <list>
 #include <map>
 #include <stdint.h>
@@ -126,6 +127,15 @@ void RPCRunLater(const std::string &name, boost::function<void(void)> func, int6
 
 typedef UniValue (*rpcfn_type)(const UniValue &params, bool fHelp);
 
+class JSONStreamWriter;
+/** Writes the result of an RPC call to a stream instead of returning it as a UniValue */
+typedef std::function<void(JSONStreamWriter &out)> RPCStreamResult;
+/** The streaming form of an RPC method, for methods whose results can be very large.  It checks the parameters and
+ * loads what it needs, throwing errors like the normal method, and returns the function that writes the result.
+ * The normal method is still needed for help, batches and callers that want a UniValue.
+ */
+typedef RPCStreamResult (*rpcstreamfn_type)(const UniValue &params);
+
 class CRPCCommand
 {
 public:
@@ -142,6 +152,10 @@ class CRPCTable
 {
 private:
     std::map<std::string, CRPCCommand> mapCommands;
+    std::map<std::string, rpcstreamfn_type> mapStreamers;
+
+    //! Checks that RPC is out of warmup and converts string parameters to their types
+    UniValue convertParams(const std::string &strMethod, const UniValue &preparams) const;
 
 public:
     CRPCTable();
@@ -157,6 +171,14 @@ public:
      */
     UniValue execute(const std::string &method, const UniValue &params) const;
 
+    /**
+     * Execute the streaming form of a method, if it has one.
+     * @returns the function that writes the result, or an empty function if the method can not be streamed with
+     *          these parameters, in which case execute() should be used
+     * @throws an exception (UniValue) when an error happens before the result is written.
+     */
+    RPCStreamResult executeStreamed(const std::string &method, const UniValue &params) const;
+
     /**
      * Returns a list of registered commands
      * @returns List of registered commands.
@@ -171,6 +193,11 @@ public:
      * WARNING: The passed reference must be sufficiently long-lived
      */
     bool appendCommand(const CRPCCommand &ccmd);
+
+    /**
+     * Adds the streaming form of an already added method.
+     */
+    bool appendStreamer(const std::string &name, rpcstreamfn_type streamer);
 };
 
 extern CRPCTable tableRPC;
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/stats.h"
+
+#include "httpserver.h"
+#include "rpc/server.h"
+#include "sync.h"
+
+#include <univalue.h>
+
+#include <map>
+
+//! The upper bound of every histogram bucket but the last, in microseconds
+static const int64_t BUCKET_LIMITS[RPCLatencyHistogram::BUCKETS - 1] = {100, 1000, 10000, 100000, 1000000, 10000000};
+static const char *BUCKET_NAMES[RPCLatencyHistogram::BUCKETS] = {
+    "<100us", "<1ms", "<10ms", "<100ms", "<1s", "<10s", ">=10s"};
+
+// cs_rpcStats guards the following maps
+static CCriticalSection cs_rpcStats;
+static std::map<std::string, RPCLatencyHistogram> mapMethodTimes;
+static std::map<std::string, RPCLatencyHistogram> mapQueueWaits;
+
+void RPCLatencyHistogram::Add(int64_t micros)
+{
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && micros >= BUCKET_LIMITS[bucket])
+        bucket++;
+    buckets[bucket]++;
+    count++;
+    totalMicros += micros;
+    if (micros > maxMicros)
+        maxMicros = micros;
+}
+
+UniValue RPCLatencyHistogram::ToJSON() const
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("count", count);
+    ret.pushKV("average_ms", count ? (double)totalMicros / count / 1000.0 : 0.0);
+    ret.pushKV("max_ms", (double)maxMicros / 1000.0);
+    UniValue hist(UniValue::VOBJ);
+    for (int i = 0; i < BUCKETS; i++)
+        hist.pushKV(BUCKET_NAMES[i], buckets[i]);
+    ret.pushKV("histogram", hist);
+    return ret;
+}
+
+void RecordRPCMethodTime(const std::string &method, int64_t micros)
+{
+    LOCK(cs_rpcStats);
+    mapMethodTimes[method].Add(micros);
+}
+
+void RecordHTTPQueueWait(const std::string &queue, int64_t micros)
+{
+    LOCK(cs_rpcStats);
+    mapQueueWaits[queue].Add(micros);
+}
+
+void ResetRPCStats()
+{
+    LOCK(cs_rpcStats);
+    mapMethodTimes.clear();
+    mapQueueWaits.clear();
+}
+
+UniValue getrpcstats(const UniValue &params, bool fHelp)
+{
+    if (fHelp || params.size() > 1)
+        throw std::runtime_error(
+            "getrpcstats ( reset )\n"
+            "\nReturns the state of the HTTP work queues, how long requests waited in them and how long each RPC "
+            "method took to run.\n"
+            "\nArguments:\n"
+            "1. reset    (boolean, optional, default=false) Forget the recorded times after returning them\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"queues\": {           (object) One entry per work queue: fast, heavy and rest\n"
+            "    \"name\": {\n"
+            "      \"threads\": n,      (numeric) The number of worker threads\n"
+            "      \"depth\": n,        (numeric) The number of requests waiting\n"
+            "      \"maxdepth\": n,     (numeric) The most requests that can wait\n"
+            "      \"rejected\": n,     (numeric) The requests turned away because the queue was full\n"
+            "      \"wait\": {...}      (object) How long requests waited, as a latency object\n"
+            "    }, ...\n"
+            "  },\n"
+            "  \"methods\": {          (object) One latency object per RPC method that was called\n"
+            "    \"name\": {\n"
+            "      \"count\": n,        (numeric) The number of calls\n"
+            "      \"average_ms\": x.x, (numeric) The average time in milliseconds\n"
+            "      \"max_ms\": x.x,     (numeric) The longest time in milliseconds\n"
+            "      \"histogram\": {...} (object) The number of calls by time taken\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getrpcstats", "") + HelpExampleRpc("getrpcstats", "true"));
+
+    const bool fReset = params.size() > 0 && params[0].get_bool();
+
+    UniValue queues(UniValue::VOBJ);
+    UniValue methods(UniValue::VOBJ);
+    {
+        LOCK(cs_rpcStats);
+        for (const HTTPWorkQueueInfo &info : GetHTTPWorkQueueInfo())
+        {
+            UniValue queue(UniValue::VOBJ);
+            queue.pushKV("threads", info.threads);
+            queue.pushKV("depth", (uint64_t)info.depth);
+            queue.pushKV("maxdepth", (uint64_t)info.maxDepth);
+            queue.pushKV("rejected", info.rejected);
+            queue.pushKV("wait", mapQueueWaits[info.name].ToJSON());
+            queues.pushKV(info.name, queue);
+        }
+        for (const auto &method : mapMethodTimes)
+            methods.pushKV(method.first, method.second.ToJSON());
+        if (fReset)
+        {
+            mapMethodTimes.clear();
+            mapQueueWaits.clear();
+        }
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("queues", queues);
+    ret.pushKV("methods", methods);
+    return ret;
+}
+
+static const CRPCCommand commands[] = {
+    //  category              name                      actor (function)         okSafeMode
+    //  --------------------- ------------------------  -----------------------  ----------
+    {"control", "getrpcstats", &getrpcstats, true},
+};
+
+void RegisterRPCStatsCommands(CRPCTable &table)
+{
+    for (auto cmd : commands)
+        table.appendCommand(cmd);
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_RPC_STATS_H
+#define NEXA_RPC_STATS_H
+
+#include <stdint.h>
+#include <string>
+
+class UniValue;
+
+/** Counts of durations in decade wide buckets from 100 microseconds up to 10 seconds */
+class RPCLatencyHistogram
+{
+public:
+    static const int BUCKETS = 7;
+
+    void Add(int64_t micros);
+    UniValue ToJSON() const;
+
+private:
+    uint64_t count = 0;
+    int64_t totalMicros = 0;
+    int64_t maxMicros = 0;
+    uint64_t buckets[BUCKETS] = {};
+};
+
+/** Record how long an RPC method took to run */
+void RecordRPCMethodTime(const std::string &method, int64_t micros);
+/** Record how long a request waited in one of the HTTP work queues before a worker picked it up */
+void RecordHTTPQueueWait(const std::string &queue, int64_t micros);
+/** Forget all recorded times */
+void ResetRPCStats();
+
+#endif // NEXA_RPC_STATS_H
@@ -6,10 +6,557 @@
 #include "script/script.h"
 
 #ifndef ANDROID
+static_assert(GMP_NAIL_BITS == 0, "BigNum limbs must not have nail bits");
+static_assert(BIGNUM_FIXED_BITS % GMP_NUMB_BITS == 0, "BigNum fixed width must be a whole number of limbs");
+
+namespace
+{
+#if GMP_NUMB_BITS == 64 && defined(__SIZEOF_INT128__)
+typedef unsigned __int128 DoubleLimb;
+#define BIGNUM_DOUBLE_LIMB
+#elif GMP_NUMB_BITS == 32
+typedef uint64_t DoubleLimb;
+#define BIGNUM_DOUBLE_LIMB
+#endif
+
+const int FIXED_LIMBS = BigNum::FIXED_LIMBS;
+
+// The kernels below work on magnitudes: little-endian arrays of limbs.  Add, subtract and multiply do not branch
+// on the limb values, only on the (public) lengths.
+
+//! Returns the length of a without its high zero limbs
+inline int Normalize(const mp_limb_t *a, int an)
+{
+    while (an > 0 && a[an - 1] == 0)
+        an--;
+    return an;
+}
+
+//! Compares normalized magnitudes
+int CmpMag(const mp_limb_t *a, int an, const mp_limb_t *b, int bn)
+{
+    if (an != bn)
+        return an < bn ? -1 : 1;
+    for (int i = an - 1; i >= 0; i--)
+    {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+//! r = a + b, where an >= bn.  r must have room for an + 1 limbs.  Returns the length of r.
+int AddMag(mp_limb_t *r, const mp_limb_t *a, int an, const mp_limb_t *b, int bn)
+{
+    mp_limb_t carry = 0;
+    for (int i = 0; i < an; i++)
+    {
+        const mp_limb_t s = a[i] + (i < bn ? b[i] : 0);
+        const mp_limb_t c = s < a[i];
+        r[i] = s + carry;
+        carry = c | (r[i] < s);
+    }
+    r[an] = carry;
+    return an + (int)carry;
+}
+
+//! r = a - b, where a >= b.  Returns the normalized length of r.
+int SubMag(mp_limb_t *r, const mp_limb_t *a, int an, const mp_limb_t *b, int bn)
+{
+    mp_limb_t borrow = 0;
+    for (int i = 0; i < an; i++)
+    {
+        const mp_limb_t d = a[i] - (i < bn ? b[i] : 0);
+        const mp_limb_t c = d > a[i];
+        r[i] = d - borrow;
+        borrow = c | (r[i] > d);
+    }
+    return Normalize(r, an);
+}
+
+//! r = a * b.  r must have room for an + bn limbs and not overlap a or b.  Returns the normalized length of r.
+int MulMag(mp_limb_t *r, const mp_limb_t *a, int an, const mp_limb_t *b, int bn)
+{
+    if (an == 0 || bn == 0)
+        return 0;
+#ifdef BIGNUM_DOUBLE_LIMB
+    std::fill(r, r + bn, 0);
+    for (int i = 0; i < an; i++)
+    {
+        mp_limb_t carry = 0;
+        for (int j = 0; j < bn; j++)
+        {
+            const DoubleLimb t = (DoubleLimb)a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = (mp_limb_t)t;
+            carry = (mp_limb_t)(t >> GMP_NUMB_BITS);
+        }
+        r[i + bn] = carry;
+    }
+#else
+    if (an >= bn)
+        mpn_mul(r, a, an, b, bn);
+    else
+        mpn_mul(r, b, bn, a, an);
+#endif
+    return Normalize(r, an + bn);
+}
+
+#ifdef BIGNUM_DOUBLE_LIMB
+/** The reciprocal of a normalized (top bit set) limb d: floor((B^2 - 1) / d) - B, where B is 2^GMP_NUMB_BITS */
+inline mp_limb_t Reciprocal(mp_limb_t d)
+{
+    return (mp_limb_t)((~(DoubleLimb)0 - ((DoubleLimb)d << GMP_NUMB_BITS)) / d);
+}
+
+/** Divide (nh, nl) by the normalized limb d, where nh < d, with two multiplications instead of a double limb
+    division (Moller and Granlund, "Improved division by invariant integers").  Returns the quotient. */
+inline mp_limb_t DivRem2by1(mp_limb_t &r, mp_limb_t nh, mp_limb_t nl, mp_limb_t d, mp_limb_t dinv)
+{
+    const DoubleLimb p = (DoubleLimb)nh * dinv + (((DoubleLimb)nh << GMP_NUMB_BITS) | nl);
+    mp_limb_t q = (mp_limb_t)(p >> GMP_NUMB_BITS) + 1;
+    mp_limb_t rem = nl - q * d;
+    if (rem > (mp_limb_t)p)
+    {
+        q--;
+        rem += d;
+    }
+    if (rem >= d)
+    {
+        q++;
+        rem -= d;
+    }
+    r = rem;
+    return q;
+}
+#endif
+
+/** q = a / b and r = a % b, where a has no more than 2*FIXED_LIMBS limbs, b is normalized, nonzero and no more
+    than FIXED_LIMBS limbs, and an >= bn.  q needs room for an - bn + 1 limbs and r for bn limbs.  Lengths are not
+    normalized. */
+void DivRemMag(mp_limb_t *q, mp_limb_t *r, const mp_limb_t *a, int an, const mp_limb_t *b, int bn)
+{
+#ifdef BIGNUM_DOUBLE_LIMB
+    const int BITS = GMP_NUMB_BITS;
+    // Knuth's algorithm D (TAOCP 4.3.1): shift so that the top bit of the divisor is set, then find one quotient
+    // limb at a time from an estimate that is at most 2 too large.
+    int shift = 0;
+    while (!(b[bn - 1] & ((mp_limb_t)1 << (BITS - 1 - shift))))
+        shift++;
+    mp_limb_t v[FIXED_LIMBS];
+    mp_limb_t u[2 * FIXED_LIMBS + 1];
+    if (shift)
+    {
+        for (int i = bn - 1; i > 0; i--)
+            v[i] = (b[i] << shift) | (b[i - 1] >> (BITS - shift));
+        v[0] = b[0] << shift;
+        u[an] = a[an - 1] >> (BITS - shift);
+        for (int i = an - 1; i > 0; i--)
+            u[i] = (a[i] << shift) | (a[i - 1] >> (BITS - shift));
+        u[0] = a[0] << shift;
+    }
+    else
+    {
+        std::copy(b, b + bn, v);
+        std::copy(a, a + an, u);
+        u[an] = 0;
+    }
+    const mp_limb_t vtop = v[bn - 1];
+    const mp_limb_t vinv = Reciprocal(vtop);
+
+    if (bn == 1)
+    {
+        mp_limb_t rem = u[an];
+        for (int i = an - 1; i >= 0; i--)
+            q[i] = DivRem2by1(rem, rem, u[i], vtop, vinv);
+        r[0] = rem >> shift;
+        return;
+    }
+
+    for (int j = an - bn; j >= 0; j--)
+    {
+        mp_limb_t qhat;
+        mp_limb_t rhat;
+        bool rhatOverflow = false;
+        if (u[j + bn] >= vtop) // only equality is possible, and then the estimate is B - 1
+        {
+            qhat = ~(mp_limb_t)0;
+            rhat = u[j + bn - 1] + vtop;
+            rhatOverflow = rhat < vtop;
+        }
+        else
+            qhat = DivRem2by1(rhat, u[j + bn], u[j + bn - 1], vtop, vinv);
+        while (!rhatOverflow && (DoubleLimb)qhat * v[bn - 2] > (((DoubleLimb)rhat << BITS) | u[j + bn - 2]))
+        {
+            qhat--;
+            rhat += vtop;
+            rhatOverflow = rhat < vtop;
+        }
+
+        // u[j..j+bn] -= qhat * v, with the borrow folded into the carry (it can not overflow: qhat * v[i] + carry
+        // is at most B^2 - B)
+        mp_limb_t carry = 0;
+        for (int i = 0; i < bn; i++)
+        {
+            const DoubleLimb p = (DoubleLimb)qhat * v[i] + carry;
+            const mp_limb_t t = u[i + j] - (mp_limb_t)p;
+            carry = (mp_limb_t)(p >> BITS) + (t > u[i + j]);
+            u[i + j] = t;
+        }
+        const bool borrow = u[j + bn] < carry;
+        u[j + bn] -= carry;
+
+        if (borrow) // qhat was one too large, so add v back
+        {
+            qhat--;
+            mp_limb_t c2 = 0;
+            for (int i = 0; i < bn; i++)
+            {
+                const DoubleLimb sum = (DoubleLimb)u[i + j] + v[i] + c2;
+                u[i + j] = (mp_limb_t)sum;
+                c2 = (mp_limb_t)(sum >> BITS);
+            }
+            u[j + bn] += c2;
+        }
+        q[j] = qhat;
+    }
+
+    if (shift)
+    {
+        for (int i = 0; i < bn - 1; i++)
+            r[i] = (u[i] >> shift) | (u[i + 1] << (BITS - shift));
+        r[bn - 1] = u[bn - 1] >> shift;
+    }
+    else
+        std::copy(u, u + bn, r);
+#else
+    mpn_tdiv_qr(q, r, 0, a, an, b, bn);
+#endif
+}
+} // namespace
+
+mpz_ptr BigNum::big()
+{
+    if (isBig())
+        return n;
+    const int sz = size;
+    const int limbs = std::abs(sz);
+    mpz_t z;
+    mpz_init(z);
+    if (limbs)
+    {
+        std::copy(fixed, fixed + limbs, mpz_limbs_write(z, limbs));
+        mpz_limbs_finish(z, sz);
+    }
+    n[0] = z[0];
+    size = BIG;
+    return n;
+}
+
+void BigNum::shrink()
+{
+    if (!isBig() || mpz_size(n) > (size_t)FIXED_LIMBS)
+        return;
+    mp_limb_t mag[FIXED_LIMBS];
+    const int limbs = mpz_size(n);
+    const bool negative = mpz_sgn(n) < 0;
+    std::copy(mpz_limbs_read(n), mpz_limbs_read(n) + limbs, mag);
+    mpz_clear(n);
+    std::copy(mag, mag + limbs, fixed);
+    size = negative ? -limbs : limbs;
+}
+
+void BigNum::setMagnitude(const mp_limb_t *mag, int nLimbs, bool negative)
+{
+    nLimbs = Normalize(mag, nLimbs);
+    const int sz = (negative ? -nLimbs : nLimbs);
+    if (nLimbs <= FIXED_LIMBS)
+    {
+        if (isBig())
+            mpz_clear(n);
+        std::copy(mag, mag + nLimbs, fixed);
+        size = sz;
+    }
+    else
+    {
+        if (!isBig())
+        {
+            mpz_init(n);
+            size = BIG;
+        }
+        std::copy(mag, mag + nLimbs, mpz_limbs_write(n, nLimbs));
+        mpz_limbs_finish(n, sz);
+    }
+}
+
+void BigNum::setSum(const BigNum &a, const BigNum &b, bool subtract)
+{
+    const int an = std::abs(a.size);
+    const int bn = std::abs(b.size);
+    const bool aNeg = a.size < 0;
+    const bool bNeg = (b.size < 0) != subtract;
+    mp_limb_t r[FIXED_LIMBS + 1];
+    if (aNeg == bNeg)
+    {
+        const int rn = (an >= bn) ? AddMag(r, a.fixed, an, b.fixed, bn) : AddMag(r, b.fixed, bn, a.fixed, an);
+        setMagnitude(r, rn, aNeg);
+    }
+    else if (CmpMag(a.fixed, an, b.fixed, bn) >= 0)
+        setMagnitude(r, SubMag(r, a.fixed, an, b.fixed, bn), aNeg);
+    else
+        setMagnitude(r, SubMag(r, b.fixed, bn, a.fixed, an), bNeg);
+}
+
+void BigNum::tdivFixed(BigNum *q, BigNum *r, const mp_limb_t *a, int an, bool negative, const BigNum &d)
+{
+    const int dn = std::abs(d.size);
+    if (an < dn) // |a| < |d|
+    {
+        if (q)
+            q->setMagnitude(nullptr, 0, false);
+        if (r)
+            r->setMagnitude(a, an, negative);
+        return;
+    }
+    mp_limb_t qmag[2 * FIXED_LIMBS + 1];
+    mp_limb_t rmag[FIXED_LIMBS];
+    DivRemMag(qmag, rmag, a, an, d.fixed, dn);
+    if (q)
+        q->setMagnitude(qmag, an - dn + 1, negative != (d.size < 0));
+    if (r)
+        r->setMagnitude(rmag, dn, negative);
+}
+
+BigNum &BigNum::operator=(const BigNum &b)
+{
+    if (this == &b)
+        return *this;
+    if (b.isBig())
+    {
+        if (isBig())
+            mpz_set(n, b.n);
+        else
+            mpz_init_set(n, b.n);
+    }
+    else
+    {
+        if (isBig())
+            mpz_clear(n);
+        std::copy(b.fixed, b.fixed + std::abs(b.size), fixed);
+    }
+    size = b.size;
+    return *this;
+}
+
+BigNum &BigNum::operator=(BigNum &&b) noexcept
+{
+    if (this == &b)
+        return *this;
+    if (isBig())
+        mpz_clear(n);
+    size = b.size;
+    if (b.isBig())
+    {
+        n[0] = b.n[0];
+        b.size = 0;
+    }
+    else
+        std::copy(b.fixed, b.fixed + std::abs(size), fixed);
+    return *this;
+}
+
+int BigNum::cmp(const BigNum &p) const
+{
+    if (!isBig() && !p.isBig())
+    {
+        // Fixed numbers are normalized, so a longer magnitude is a larger one
+        if (size != p.size)
+            return size < p.size ? -1 : 1;
+        const int c = CmpMag(fixed, std::abs(size), p.fixed, std::abs(size));
+        return size < 0 ? -c : c;
+    }
+    mpz_t ta, tb;
+    return mpz_cmp(view(ta), p.view(tb));
+}
+
+BigNum BigNum::tdiv(const BigNum &d) const
+{
+    BigNum ret;
+    if (!isBig() && !d.isBig() && d.size != 0)
+        tdivFixed(nullptr, &ret, fixed, std::abs(size), size < 0, d);
+    else
+    {
+        mpz_t ta, tb;
+        mpz_tdiv_r(ret.big(), view(ta), d.view(tb));
+        ret.shrink();
+    }
+    return ret;
+}
+
+BigNum BigNum::mulTdiv(const BigNum &p, const BigNum &d) const
+{
+    if (isBig() || p.isBig() || d.isBig() || d.size == 0)
+        return (*this * p).tdiv(d);
+    BigNum ret;
+    mp_limb_t prod[2 * FIXED_LIMBS];
+    const int pn = MulMag(prod, fixed, std::abs(size), p.fixed, std::abs(p.size));
+    tdivFixed(nullptr, &ret, prod, pn, (size < 0) != (p.size < 0), d);
+    return ret;
+}
+
+BigNum BigNum::operator+(const BigNum &p) const
+{
+    BigNum ret;
+    if (!isBig() && !p.isBig())
+        ret.setSum(*this, p, false);
+    else
+    {
+        mpz_t ta, tb;
+        mpz_add(ret.big(), view(ta), p.view(tb));
+        ret.shrink();
+    }
+    return ret;
+}
+
+BigNum BigNum::operator-(const BigNum &p) const
+{
+    BigNum ret;
+    if (!isBig() && !p.isBig())
+        ret.setSum(*this, p, true);
+    else
+    {
+        mpz_t ta, tb;
+        mpz_sub(ret.big(), view(ta), p.view(tb));
+        ret.shrink();
+    }
+    return ret;
+}
+
+BigNum BigNum::operator-() const
+{
+    BigNum ret(*this);
+    if (ret.isBig())
+        mpz_neg(ret.n, ret.n);
+    else
+        ret.size = -ret.size;
+    return ret;
+}
+
+BigNum BigNum::operator*(const BigNum &p) const
+{
+    BigNum ret;
+    if (!isBig() && !p.isBig())
+    {
+        mp_limb_t prod[2 * FIXED_LIMBS];
+        const int pn = MulMag(prod, fixed, std::abs(size), p.fixed, std::abs(p.size));
+        ret.setMagnitude(prod, pn, (size < 0) != (p.size < 0));
+    }
+    else
+    {
+        mpz_t ta, tb;
+        mpz_mul(ret.big(), view(ta), p.view(tb));
+        ret.shrink();
+    }
+    return ret;
+}
+
+BigNum BigNum::operator/(const BigNum &p) const
+{
+    BigNum ret;
+    if (!isBig() && !p.isBig() && p.size != 0)
+        tdivFixed(&ret, nullptr, fixed, std::abs(size), size < 0, p);
+    else
+    {
+        mpz_t ta, tb;
+        mpz_tdiv_q(ret.big(), view(ta), p.view(tb));
+        ret.shrink();
+    }
+    return ret;
+}
+
+BigNum BigNum::operator%(const BigNum &p) const
+{
+    BigNum ret;
+    if (!isBig() && !p.isBig() && p.size != 0)
+    {
+        // The result is never negative: a negative remainder is moved up by |p|
+        tdivFixed(nullptr, &ret, fixed, std::abs(size), size < 0, p);
+        if (ret.size < 0)
+        {
+            BigNum absP(p);
+            absP.size = std::abs(absP.size);
+            ret.setSum(absP, -ret, true);
+        }
+    }
+    else
+    {
+        mpz_t ta, tb;
+        mpz_mod(ret.big(), view(ta), p.view(tb));
+        ret.shrink();
+    }
+    return ret;
+}
+
+BigNum BigNum::operator<<(const unsigned long int amt) const
+{
+    BigNum ret;
+    if (amt > MAX_BIGNUM_BITSHIFT_SIZE)
+        throw OutOfBounds("Left shift too far");
+    mpz_t tmp;
+    mpz_mul_2exp(ret.big(), view(tmp), amt);
+    ret.shrink();
+    return ret;
+}
+
+BigNum BigNum::operator>>(const unsigned long int amt) const
+{
+    BigNum ret;
+    if (amt > MAX_BIGNUM_BITSHIFT_SIZE)
+        return bnZero; // It must be zero because the bignum cannot be any bigger
+    mpz_t tmp;
+    mpz_tdiv_q_2exp(ret.big(), view(tmp), amt);
+    ret.shrink();
+    return ret;
+}
+
+BigNum &BigNum::deserialize(const unsigned char *buf, int bufsize)
+{
+    // If an empty buffer is passed, assume that is the number 0 (like OP_0)
+    if (bufsize == 0 || buf == nullptr)
+    {
+        setMagnitude(nullptr, 0, false);
+        return *this;
+    }
+    // CScriptNum uses a slightly different format which allows the sign bit to be packed into the mag bytes
+    const bool negative = buf[bufsize - 1] >= 0x80;
+    const int limbBytes = GMP_NUMB_BITS / 8;
+    if (bufsize <= FIXED_LIMBS * limbBytes)
+    {
+        mp_limb_t mag[FIXED_LIMBS] = {};
+        for (int i = 0; i < bufsize; i++)
+        {
+            const unsigned char c = (i == bufsize - 1) ? (buf[i] & 0x7f) : buf[i];
+            mag[i / limbBytes] |= (mp_limb_t)c << (8 * (i % limbBytes));
+        }
+        setMagnitude(mag, FIXED_LIMBS, negative);
+    }
+    else
+    {
+        std::vector<unsigned char> cpy(buf, buf + bufsize);
+        cpy[bufsize - 1] &= 0x7f;
+        mpz_ptr z = big();
+        mpz_import(z, bufsize, -1, 1, 0, 0, cpy.data());
+        if (negative)
+            mpz_neg(z, z);
+        shrink(); // it may have been zero padded
+    }
+    return *this;
+}
+
 const BigNum bnZero = 0_BN;
 const BigNum bnOne = 1_BN;
 const BigNum bnInt64Max(std::numeric_limits<int64_t>::max());
 const BigNum bnUint64Max = 0x10000000000000000_BN - 1; // can't use int ctor because it is not uint
+const BigNum bnDefaultBmd = 0x10000000000000000_BN; // 64 bit magnitude
 const BigNum &bnFalse(bnZero);
 const BigNum &bnTrue(bnOne);
 
@@ -85,8 +632,8 @@ bool BigNumScriptOp(BigNum &bn,
         bn = (bn1 > bn2 ? bn1 : bn2);
         break;
     case OP_MUL:
-        bn = bn1 * bn2;
-        break;
+        bn = bn1.mulTdiv(bn2, bmd);
+        return true;
     default:
         assert(!"invalid opcode");
         break;
@@ -102,6 +649,7 @@ const BigNum &bnFalse(bnZero);
 const BigNum &bnTrue(bnOne);
 const BigNum bnInt64Max;
 const BigNum bnUint64Max;
+const BigNum bnDefaultBmd;
 
 BigNum bigNumUpperLimit;
 BigNum bigNumLowerLimit;
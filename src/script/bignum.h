@@ -5,7 +5,10 @@
 #ifndef NEXA_BIGNUM_H
 #define NEXA_BIGNUM_H
 
+#include <algorithm>
+#include <cstdlib>
 #include <exception>
+#include <limits>
 #ifndef ANDROID // limit dependencies: BigNum is a NO_OP on android since script machine not needed
 #include <gmp.h>
 #endif
@@ -15,6 +18,8 @@
 
 #define MAX_BIGNUM_MAGNITUDE_SIZE 512
 #define MAX_BIGNUM_BITSHIFT_SIZE (MAX_BIGNUM_MAGNITUDE_SIZE * 8)
+//! Magnitude in bits of the BigNums that are stored without a heap allocation
+#define BIGNUM_FIXED_BITS 512
 
 class OutOfBounds : std::exception
 {
@@ -30,110 +35,113 @@ public:
 class BigNum
 {
 #ifndef ANDROID // limit dependencies
-protected:
-    mpz_t n;
-
 public:
-    BigNum(const std::string &str, int base = 10)
-    {
-        mpz_init(n);
-        mpz_set_str(n, str.c_str(), base);
-    }
+    /** Numbers whose magnitude fits in this many limbs are held inside the object and use the fixed width
+        arithmetic in bignum.cpp.  This covers the products of 256 bit numbers, so typical modular arithmetic
+        never touches the heap.  Larger numbers are GMP integers. */
+    static const int FIXED_LIMBS = BIGNUM_FIXED_BITS / GMP_NUMB_BITS;
 
-    BigNum(const char *str, int base = 10)
-    {
-        mpz_init(n);
-        mpz_set_str(n, str, base);
-    }
-
-    BigNum(int64_t i = 0)
-    {
-        bool neg = (i < 0);
-        if (neg)
-            i = -i; // So that the top bit is 0
-        mpz_init(n);
-        mpz_import(n, 1, 1, sizeof(int64_t), 0, 0, &i);
-        if (neg)
-            mpz_neg(n, n);
-    }
-
-    BigNum(const BigNum &b) { mpz_init_set(n, b.n); }
-
-    ~BigNum() { mpz_clear(n); }
+protected:
+    //! size of a BigNum that is held in n
+    static const int BIG = std::numeric_limits<int>::min();
 
-    BigNum &operator=(const BigNum &b)
+    /** Number of limbs of fixed in use, negative if the number is negative (like GMP's _mp_size), or BIG.
+        A number is held in n only if its magnitude does not fit in fixed, and fixed has no high zero limbs. */
+    int size;
+    union
     {
-        mpz_set(n, b.n);
-        return *this;
-    }
+        mp_limb_t fixed[FIXED_LIMBS];
+        mpz_t n;
+    };
+
+    bool isBig() const { return size == BIG; }
+    /** Return a read-only GMP view of this number, using tmp to describe the fixed limbs if needed */
+    mpz_srcptr view(mpz_ptr tmp) const { return isBig() ? n : mpz_roinit_n(tmp, fixed, size); }
+    /** Turn this number into a GMP integer and return it for modification.  Call shrink() when done. */
+    mpz_ptr big();
+    /** Move a GMP integer back into fixed if its magnitude fits */
+    void shrink();
+    /** Set this number from a magnitude of any length (high zero limbs are allowed) and a sign */
+    void setMagnitude(const mp_limb_t *mag, int nLimbs, bool negative);
+    /** Set this number to a + b (or a - b) where neither is big */
+    void setSum(const BigNum &a, const BigNum &b, bool subtract);
+    /** Truncating division of a magnitude of up to 2*FIXED_LIMBS limbs by d, where d is not big and not 0.
+        The quotient rounds toward 0 and the remainder has the sign of the dividend.  q or r may be null. */
+    static void tdivFixed(BigNum *q, BigNum *r, const mp_limb_t *a, int an, bool negative, const BigNum &d);
 
-    BigNum checkLimits() const { return *this; }
-    /** Modulo where the remainder gets the sign of the dividend */
-    BigNum tdiv(const BigNum &d) const
-    {
-        BigNum ret;
-        mpz_tdiv_r(ret.n, n, d.n);
-        return ret;
-    }
+public:
+    BigNum(const std::string &str, int base = 10) : BigNum(str.c_str(), base) {}
 
-    BigNum operator+(const BigNum &p) const
+    BigNum(const char *str, int base = 10) : size(0)
     {
-        BigNum ret;
-        mpz_add(ret.n, n, p.n);
-        return ret.checkLimits();
+        mpz_set_str(big(), str, base);
+        shrink();
     }
 
-    BigNum operator-(const BigNum &p) const
+    BigNum(int64_t i = 0) : size(0)
     {
-        BigNum ret;
-        mpz_sub(ret.n, n, p.n);
-        return ret.checkLimits();
+        uint64_t mag = (i < 0) ? (uint64_t)0 - (uint64_t)i : (uint64_t)i;
+        while (mag != 0)
+        {
+            fixed[size++] = (mp_limb_t)mag;
+            mag = (GMP_NUMB_BITS < 64) ? mag >> (GMP_NUMB_BITS % 64) : 0;
+        }
+        if (i < 0)
+            size = -size;
     }
 
-    BigNum operator-() const
+    BigNum(const BigNum &b) : size(b.size)
     {
-        BigNum ret;
-        mpz_neg(ret.n, n);
-        return ret.checkLimits();
+        if (b.isBig())
+            mpz_init_set(n, b.n);
+        else
+            std::copy(b.fixed, b.fixed + std::abs(size), fixed);
     }
-
-    BigNum operator*(const BigNum &p) const
+    // A big number's limbs are handed over, leaving b as 0
+    BigNum(BigNum &&b) noexcept : size(b.size)
     {
-        BigNum ret;
-        mpz_mul(ret.n, n, p.n);
-        return ret.checkLimits();
+        if (b.isBig())
+        {
+            n[0] = b.n[0];
+            b.size = 0;
+        }
+        else
+            std::copy(b.fixed, b.fixed + std::abs(size), fixed);
     }
 
-    BigNum operator/(const BigNum &p) const
+    ~BigNum()
     {
-        BigNum ret;
-        mpz_tdiv_q(ret.n, n, p.n);
-        return ret.checkLimits();
+        if (isBig())
+            mpz_clear(n);
     }
 
-    BigNum operator%(const BigNum &p) const
-    {
-        BigNum ret;
-        mpz_mod(ret.n, n, p.n);
-        return ret.checkLimits();
-    }
+    BigNum &operator=(const BigNum &b);
+    BigNum &operator=(BigNum &&b) noexcept;
 
-    BigNum operator<<(const unsigned long int amt) const
-    {
-        BigNum ret;
-        if (amt > MAX_BIGNUM_BITSHIFT_SIZE)
-            throw OutOfBounds("Left shift too far");
-        mpz_mul_2exp(ret.n, n, amt);
-        return ret.checkLimits();
-    }
+    BigNum checkLimits() const { return *this; }
+    /** Modulo where the remainder gets the sign of the dividend */
+    BigNum tdiv(const BigNum &d) const;
+    /** (*this * p).tdiv(d), without building the full product as a GMP integer if it is larger than the fixed
+        width but the operands are not */
+    BigNum mulTdiv(const BigNum &p, const BigNum &d) const;
+
+    BigNum operator+(const BigNum &p) const;
+    BigNum operator-(const BigNum &p) const;
+    BigNum operator-() const;
+    BigNum operator*(const BigNum &p) const;
+    BigNum operator/(const BigNum &p) const;
+    BigNum operator%(const BigNum &p) const;
+    BigNum operator<<(const unsigned long int amt) const;
     BigNum operator>>(const unsigned long int amt) const;
 
     BigNum operator>>(const BigNum &amt) const { return *this >> amt.asUint64(); }
     std::string str(int base = 10) const
     {
+        mpz_t tmp;
+        mpz_srcptr z = view(tmp);
         std::string ret;
-        ret.resize(mpz_sizeinbase(n, base));
-        mpz_get_str(&ret[0], base, n);
+        ret.resize(mpz_sizeinbase(z, base));
+        mpz_get_str(&ret[0], base, z);
         return ret;
     }
 
@@ -143,92 +151,75 @@ public:
     */
     int serialize(unsigned char *buf, size_t padTo, int sz = 0) const
     {
+        mpz_t tmp;
+        mpz_srcptr z = view(tmp);
         if (sz == 0)
             sz = padTo + 1; // If size is not provided, assume buf is exactly big enough for the chosen pad.
-        int sizeNeeded = ((mpz_sizeinbase(n, 2) + 7) / 8) + 1;
+        int sizeNeeded = ((mpz_sizeinbase(z, 2) + 7) / 8) + 1;
         if (sizeNeeded > sz)
             return -sizeNeeded;
         size_t count = 0;
-        mpz_export(buf, &count, -1, 1, 0, 0, n);
+        mpz_export(buf, &count, -1, 1, 0, 0, z);
         while (count < padTo) // 0 pad the rest
         {
             buf[count] = 0;
             count++;
         }
 
-        buf[count] = (mpz_sgn(n) == -1) ? 0x80 : 0;
+        buf[count] = (sgn() == -1) ? 0x80 : 0;
         return count + 1;
     }
 
     /** Returns the required storage in bytes of the magnitude of this BigNum.  The minimum lossless serialization
 is therefore 1 byte longer (for the sign). */
-    size_t magSize() const { return ((mpz_sizeinbase(n, 2) + 7) / 8); }
+    size_t magSize() const
+    {
+        mpz_t tmp;
+        return ((mpz_sizeinbase(view(tmp), 2) + 7) / 8);
+    }
     /** Return a byte vector of this BigNum in little-endian sign-magnitude format.
      */
     std::vector<unsigned char> serialize(size_t padTo) const
     {
+        mpz_t tmp;
+        mpz_srcptr z = view(tmp);
         std::vector<unsigned char> ret;
         size_t mSize = magSize();
         ret.reserve(std::max(padTo + 1, mSize + 1));
         ret.resize(mSize);
         size_t count = 0;
-        mpz_export(ret.data(), &count, -1, 1, 0, 0, n);
+        mpz_export(ret.data(), &count, -1, 1, 0, 0, z);
         while (count < padTo) // 0 pad the rest
         {
             ret.push_back(0);
             count++;
         }
 
-        ret.push_back((mpz_sgn(n) == -1) ? 0x80 : 0);
+        ret.push_back((sgn() == -1) ? 0x80 : 0);
         return ret;
     }
 
     /** Read this BigNum from a little-endian sign-magnitude formatted buffer */
-    BigNum &deserialize(const unsigned char *buf, int bufsize)
-    {
-        std::vector<unsigned char> cpy(buf, buf + bufsize);
-        return deserializeTouches(cpy.data(), cpy.size());
-    }
+    BigNum &deserialize(const unsigned char *buf, int bufsize);
 
     /** Read this BigNum from a little-endian sign-magnitude formatted buffer.
-        More efficient but touches (modifies then restores) the passed buffer */
-    BigNum &deserializeTouches(unsigned char *buf, int bufsize)
-    {
-        // If an empty buffer is passed, assume that is the number 0 (like OP_0)
-        if (bufsize == 0 || buf == nullptr)
-        {
-            mpz_set_ui(n, 0);
-        }
-        // CScriptNum uses a slightly different format which allows the sign bit to be packed into the mag bytes
-        else if (buf[bufsize - 1] >= 0x80)
-        {
-            auto tmp = buf[bufsize - 1];
-            buf[bufsize - 1] &= 0x7f;
-            mpz_import(n, bufsize, -1, 1, 0, 0, buf);
-            mpz_neg(n, n);
-            buf[bufsize - 1] = tmp;
-        }
-        else
-            mpz_import(n, bufsize, -1, 1, 0, 0, buf);
-        return *this;
-    }
+        Kept for existing callers: the buffer is no longer modified, so this is the same as deserialize */
+    BigNum &deserializeTouches(unsigned char *buf, int bufsize) { return deserialize(buf, bufsize); }
 
-    BigNum &deserialize(const std::vector<unsigned char> &c)
-    {
-        std::vector<unsigned char> cpy = c;
-        return deserializeTouches(cpy.data(), cpy.size());
-    }
+    BigNum &deserialize(const std::vector<unsigned char> &c) { return deserialize(c.data(), c.size()); }
 
     /** Return this bignum's magnitude (the sign is ignored) as an unsigned 64 bit integer.
         If this BigNum is too large, an exception is raised
     */
     uint64_t asUint64() const
     {
+        mpz_t tmp;
+        mpz_srcptr z = view(tmp);
         uint64_t ret;
-        size_t space = mpz_sizeinbase(n, 2);
+        size_t space = mpz_sizeinbase(z, 2);
         if (space > sizeof(uint64_t) * 8)
             throw OutOfBounds("Number out of range");
-        mpz_export(&ret, nullptr, 1, sizeof(uint64_t), 0, 0, n);
+        mpz_export(&ret, nullptr, 1, sizeof(uint64_t), 0, 0, z);
         return ret;
     }
     /** Return this bignum's magnitude (the sign is ignored) as a signed 64 bit integer.
@@ -239,18 +230,31 @@ is therefore 1 byte longer (for the sign). */
         uint64_t ret = asUint64();
         if (ret & 0x8000000000000000ULL)
             throw OutOfBounds("Number out of range");
-        return (mpz_sgn(n) == -1) ? -ret : ret;
+        return (sgn() == -1) ? -ret : ret;
     }
 
+    /** Returns -1, 0 or 1 depending on the sign of this number */
+    int sgn() const { return isBig() ? mpz_sgn(n) : (size > 0) - (size < 0); }
+    /** Returns a negative value, 0 or a positive value if this number is less than, equal to or greater than p */
+    int cmp(const BigNum &p) const;
+
     // Logic:
-    bool operator==(const BigNum &p) const { return (mpz_cmp(n, p.n) == 0); }
-    bool operator!=(const BigNum &p) const { return (mpz_cmp(n, p.n) != 0); }
-    bool operator<(const BigNum &p) const { return (mpz_cmp(n, p.n) < 0); }
-    bool operator>(const BigNum &p) const { return (mpz_cmp(n, p.n) > 0); }
-    bool operator<=(const BigNum &p) const { return (mpz_cmp(n, p.n) <= 0); }
-    bool operator>=(const BigNum &p) const { return (mpz_cmp(n, p.n) >= 0); }
-    bool operator==(const unsigned long int p) const { return (mpz_cmp_ui(n, p) == 0); }
-    bool operator==(const long int p) const { return (mpz_cmp_si(n, p) == 0); }
+    bool operator==(const BigNum &p) const { return (cmp(p) == 0); }
+    bool operator!=(const BigNum &p) const { return (cmp(p) != 0); }
+    bool operator<(const BigNum &p) const { return (cmp(p) < 0); }
+    bool operator>(const BigNum &p) const { return (cmp(p) > 0); }
+    bool operator<=(const BigNum &p) const { return (cmp(p) <= 0); }
+    bool operator>=(const BigNum &p) const { return (cmp(p) >= 0); }
+    bool operator==(const unsigned long int p) const
+    {
+        mpz_t tmp;
+        return (mpz_cmp_ui(view(tmp), p) == 0);
+    }
+    bool operator==(const long int p) const
+    {
+        mpz_t tmp;
+        return (mpz_cmp_si(view(tmp), p) == 0);
+    }
 #else
 public:
     BigNum(uint64_t i = 0) {}
@@ -278,6 +282,7 @@ public:
     BigNum &deserializeTouches(unsigned char *buf, int bufsize) { return *this; }
     BigNum &deserialize(const std::vector<unsigned char> &c) { return *this; }
     BigNum tdiv(const BigNum &d) const { return BigNum(); }
+    BigNum mulTdiv(const BigNum &p, const BigNum &d) const { return BigNum(); }
     size_t magSize() const { return 0; }
     std::string str(int base = 10) const { return std::string(); }
     unsigned long int asUint64() const { return 0; }
@@ -321,17 +326,7 @@ extern const BigNum &bnFalse;
 extern const BigNum &bnTrue;
 extern const BigNum bnInt64Max;
 extern const BigNum bnUint64Max;
+extern const BigNum bnDefaultBmd; // the BigNum modulo divisor that scripts start with
 
 
-#ifndef ANDROID
-inline BigNum BigNum::operator>>(const unsigned long int amt) const
-{
-    BigNum ret;
-    if (amt > MAX_BIGNUM_BITSHIFT_SIZE)
-        return bnZero; // It must be zero because the bignum cannot be any bigger
-    mpz_tdiv_q_2exp(ret.n, n, amt);
-    return ret.checkLimits();
-}
-#endif
-
 #endif
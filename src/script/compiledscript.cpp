@@ -0,0 +1,200 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "script/compiledscript.h"
+
+#include "hashwrapper.h"
+#include "memusage.h"
+#include "random.h"
+#include "script/interpreter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/** Returns true if stepping over this instruction in a branch that is not taken can not fail */
+static bool IsSkippable(const CompiledScript::Instruction &ins)
+{
+    if (ins.opcode <= OP_PUSHDATA4)
+        return ins.dataSize <= MAX_SCRIPT_ELEMENT_SIZE;
+    if (OP_IF <= ins.opcode && ins.opcode <= OP_ENDIF)
+        return ins.opcode != OP_VERIF && ins.opcode != OP_VERNOTIF;
+    // No opcode is disabled based on the script flags, so this can be decided when the script is compiled
+    return !IsOpcodeDisabled(ins.opcode, 0);
+}
+
+CompiledScript::CompiledScript(const CScript &scriptIn) : script(scriptIn)
+{
+    CScript::const_iterator pc = script.begin();
+    StackItem data;
+    while (pc < script.end())
+    {
+        Instruction ins;
+        ins.pos = pc - script.begin();
+        if (!script.GetOp(pc, ins.opcode, data))
+        {
+            fBadOpcode = true;
+            break;
+        }
+        ins.next = pc - script.begin();
+        ins.dataSize = data.isVch() ? data.size() : 0;
+        ins.dataPos = ins.next - ins.dataSize;
+        ins.jump = NO_JUMP;
+        ins.skipOps = 0;
+        code.push_back(ins);
+    }
+
+    // Count, for every prefix of the script, the operations and the instructions that can not be skipped
+    std::vector<uint32_t> ops(code.size() + 1, 0);
+    std::vector<uint32_t> unskippable(code.size() + 1, 0);
+    for (size_t i = 0; i < code.size(); i++)
+    {
+        ops[i + 1] = ops[i] + (code[i].opcode > OP_16 ? 1 : 0);
+        unskippable[i + 1] = unskippable[i] + (IsSkippable(code[i]) ? 0 : 1);
+    }
+
+    // Match every OP_IF, OP_NOTIF and OP_ELSE with the OP_ELSE or OP_ENDIF that ends its branch
+    std::vector<uint32_t> open;
+    for (uint32_t i = 0; i < code.size(); i++)
+    {
+        const opcodetype opcode = code[i].opcode;
+        if (opcode == OP_IF || opcode == OP_NOTIF)
+            open.push_back(i);
+        else if ((opcode == OP_ELSE || opcode == OP_ENDIF) && !open.empty())
+        {
+            const uint32_t start = open.back();
+            if (unskippable[i] == unskippable[start + 1])
+            {
+                code[start].jump = i;
+                code[start].skipOps = ops[i] - ops[start + 1];
+            }
+            if (opcode == OP_ELSE)
+                open.back() = i;
+            else
+                open.pop_back();
+        }
+    }
+}
+
+size_t CompiledScript::DynamicMemoryUsage() const
+{
+    return memusage::MallocUsage(sizeof(CompiledScript)) + memusage::DynamicUsage(script) +
+           memusage::DynamicUsage(code);
+}
+
+namespace
+{
+/** Compiled scripts by a salted hash of their bytes, evicted least recently used first */
+class CCompiledScriptCache
+{
+private:
+    struct Entry
+    {
+        uint64_t key;
+        CompiledScriptRef compiled;
+        size_t nUsage;
+    };
+    typedef std::list<Entry> EntryList;
+
+    uint64_t k0;
+    uint64_t k1;
+    //! Most recently used first
+    EntryList lru;
+    std::unordered_map<uint64_t, EntryList::iterator> cache;
+    //! The memory used by the entries
+    size_t nUsage = 0;
+    //! Hashes of scripts that were seen once but not cached, overwritten when two of them share a slot
+    std::vector<uint64_t> vSeen;
+    std::mutex cs_cache;
+
+    //! The memory used by one entry: the compiled script, its shared_ptr counter, the list node and the map node
+    static size_t EntryUsage(const CompiledScript &compiled)
+    {
+        return compiled.DynamicMemoryUsage() + memusage::MallocUsage(sizeof(memusage::stl_shared_counter)) +
+               memusage::MallocUsage(sizeof(Entry) + 2 * sizeof(void *)) +
+               memusage::MallocUsage(sizeof(memusage::unordered_node<std::pair<const uint64_t, EntryList::iterator> >));
+    }
+
+    size_t Usage() const { return nUsage + memusage::MallocUsage(sizeof(void *) * cache.bucket_count()); }
+    void Erase(EntryList::iterator it)
+    {
+        nUsage -= it->nUsage;
+        cache.erase(it->key);
+        lru.erase(it);
+    }
+
+public:
+    CCompiledScriptCache() : vSeen(COMPILED_SCRIPT_SEEN_ENTRIES, 0)
+    {
+        GetRandBytes((unsigned char *)&k0, sizeof(k0));
+        GetRandBytes((unsigned char *)&k1, sizeof(k1));
+    }
+
+    CompiledScriptRef Get(const CScript &script, bool fCacheFirstUse)
+    {
+        const uint64_t key = CSipHasher(k0, k1).Write(script.data(), script.size()).Finalize();
+        bool fCache = fCacheFirstUse;
+        {
+            std::lock_guard<std::mutex> lock(cs_cache);
+            auto it = cache.find(key);
+            // Compare the scripts: the hash only finds the entry
+            if (it != cache.end() && it->second->compiled->script == script)
+            {
+                lru.splice(lru.begin(), lru, it->second);
+                return it->second->compiled;
+            }
+            if (!fCache)
+            {
+                uint64_t &seen = vSeen[key % vSeen.size()];
+                fCache = (seen == key);
+                seen = key;
+            }
+        }
+
+        CompiledScriptRef compiled = std::make_shared<const CompiledScript>(script);
+        if (!fCache)
+            return compiled;
+
+        const size_t nEntryUsage = EntryUsage(*compiled);
+        std::lock_guard<std::mutex> lock(cs_cache);
+        auto it = cache.find(key);
+        if (it != cache.end())
+            Erase(it->second);
+        if (nEntryUsage > MAX_COMPILED_SCRIPT_CACHE_BYTES)
+            return compiled;
+        lru.push_front(Entry{key, compiled, nEntryUsage});
+        cache[key] = lru.begin();
+        nUsage += nEntryUsage;
+        while (Usage() > MAX_COMPILED_SCRIPT_CACHE_BYTES && lru.size() > 1)
+            Erase(std::prev(lru.end()));
+        return compiled;
+    }
+
+    size_t DynamicMemoryUsage()
+    {
+        std::lock_guard<std::mutex> lock(cs_cache);
+        return Usage();
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(cs_cache);
+        lru.clear();
+        cache.clear();
+        nUsage = 0;
+        std::fill(vSeen.begin(), vSeen.end(), 0);
+    }
+};
+} // namespace
+
+static CCompiledScriptCache compiledScriptCache;
+
+CompiledScriptRef GetCompiledScript(const CScript &script, bool fCacheFirstUse)
+{
+    return compiledScriptCache.Get(script, fCacheFirstUse);
+}
+size_t CompiledScriptCacheUsage() { return compiledScriptCache.DynamicMemoryUsage(); }
+void ClearCompiledScriptCache() { compiledScriptCache.Clear(); }
@@ -0,0 +1,69 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_SCRIPT_COMPILEDSCRIPT_H
+#define NEXA_SCRIPT_COMPILEDSCRIPT_H
+
+#include "script/script.h"
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+//! The most memory, in bytes, that the compiled script cache uses
+static const size_t MAX_COMPILED_SCRIPT_CACHE_BYTES = 4 << 20;
+//! The number of one-off scripts whose hashes are remembered, so that they are cached if they are seen again
+static const size_t COMPILED_SCRIPT_SEEN_ENTRIES = 4096;
+
+/** A script that has been decoded once into an array of instructions.  Scripts that run again and again (template
+    scripts and OP_EXEC subroutines) can then be executed without parsing opcodes and push lengths each time, and
+    branches that are not taken can be passed over in one step. */
+class CompiledScript
+{
+public:
+    static const uint32_t NO_JUMP = std::numeric_limits<uint32_t>::max();
+
+    struct Instruction
+    {
+        opcodetype opcode;
+        //! offset of the opcode in the script
+        uint32_t pos;
+        //! offset of the following instruction
+        uint32_t next;
+        //! offset and size of the data pushed by a push instruction
+        uint32_t dataPos;
+        uint32_t dataSize;
+        /** OP_IF, OP_NOTIF and OP_ELSE: the index of the matching OP_ELSE or OP_ENDIF.  NO_JUMP if there is none or
+            if the instructions in between could fail even when they are not executed (so they must be stepped). */
+        uint32_t jump;
+        //! The instructions between this one and jump that count toward the operation limit
+        uint32_t skipOps;
+    };
+
+    //! The script that was compiled.  Execution refers to this copy, so it lives as long as the CompiledScript.
+    const CScript script;
+    std::vector<Instruction> code;
+    //! True if the script ends with bytes that can not be decoded into an instruction
+    bool fBadOpcode = false;
+
+    explicit CompiledScript(const CScript &scriptIn);
+
+    //! The memory used by the compiled script, including the copy of the script
+    size_t DynamicMemoryUsage() const;
+};
+
+typedef std::shared_ptr<const CompiledScript> CompiledScriptRef;
+
+/** Return the compiled form of script, from the cache if it has been compiled before.  The least recently used
+    scripts are evicted once the cache uses MAX_COMPILED_SCRIPT_CACHE_BYTES.  If fCacheFirstUse is false (OP_EXEC
+    subscripts, which are often run only once) the script is only cached the second time it is seen. */
+CompiledScriptRef GetCompiledScript(const CScript &script, bool fCacheFirstUse = true);
+
+/** Return the memory used by the compiled script cache */
+size_t CompiledScriptCacheUsage();
+
+/** Remove all entries from the compiled script cache */
+void ClearCompiledScriptCache();
+
+#endif
@@ -224,7 +224,7 @@ bool CheckPubKeyEncoding(const valtype &vchPubKey, unsigned int flags, ScriptErr
     return true;
 }
 
-static inline bool IsOpcodeDisabled(opcodetype opcode, uint32_t flags)
+bool IsOpcodeDisabled(opcodetype opcode, uint32_t flags)
 {
     switch (opcode)
     {
@@ -239,6 +239,40 @@ static inline bool IsOpcodeDisabled(opcodetype opcode, uint32_t flags)
     return false;
 }
 
+//! The most stacks a thread keeps: every machine has two, and template scripts run two machines at once
+static const size_t MAX_ARENA_STACKS = 8;
+//! Stacks that grew beyond the consensus limit (a reserveIfNeeded margin is allowed) are not kept
+static const size_t MAX_ARENA_STACK_CAPACITY = MAX_STACK_SIZE + 64;
+//! Fresh stacks start with room for this many items, more than the typical spend script needs
+static const size_t ARENA_STACK_RESERVE = 16;
+
+Stack ScriptStackArena::take()
+{
+    if (vFree.empty())
+    {
+        Stack stk;
+        stk.reserve(ARENA_STACK_RESERVE);
+        return stk;
+    }
+    Stack stk = std::move(vFree.back());
+    vFree.pop_back();
+    return stk;
+}
+
+void ScriptStackArena::give(Stack &&stk)
+{
+    if (vFree.size() >= MAX_ARENA_STACKS || stk.capacity() == 0 || stk.capacity() > MAX_ARENA_STACK_CAPACITY)
+        return;
+    stk.clear();
+    vFree.push_back(std::move(stk));
+}
+
+ScriptStackArena &ScriptStackArena::local()
+{
+    static thread_local ScriptStackArena arena;
+    return arena;
+}
+
 bool EvalScript(Stack &stack,
     const CScript &script,
     unsigned int flags,
@@ -287,6 +321,8 @@ std::tuple<bool, opcodetype, StackItem, ScriptError> ScriptMachine::Peek()
 
 bool ScriptMachine::BeginStep(const CScript &_script)
 {
+    compiled.reset();
+    ip = 0;
     script = &_script;
     pc = pbegin = script->begin();
     pend = script->end();
@@ -320,7 +356,7 @@ bool ScriptMachine::Continue(size_t nSteps)
 bool ScriptMachine::ModifyScript(int position, uint8_t *data, size_t dataLength)
 {
     CScript *s = (CScript *)script;
-    if (!s)
+    if (!s || compiled)
         return false;
 
     if (s->size() < position + dataLength)
@@ -338,6 +374,8 @@ int ScriptMachine::setPos(size_t offset)
 {
     if (!script)
         return -1;
+    // Continue by decoding the script, since offset need not be the start of a compiled instruction
+    compiled.reset();
     if (pbegin + offset > pend)
         pc = pend;
     else
@@ -365,9 +403,58 @@ bool ScriptMachine::Eval(const CScript &_script)
     return ret;
 }
 
+bool ScriptMachine::Eval(const CompiledScriptRef &_compiled)
+{
+    bool ret;
+
+    // The compiled script holds its own copy of the script, which it keeps alive during execution
+    if (!(ret = BeginStep(_compiled->script)))
+        return ret;
+    compiled = _compiled;
+
+    while (pc < pend)
+    {
+        ret = Step();
+        if (!ret)
+            break;
+    }
+    if (ret)
+        ret = EndStep();
+    script = nullptr;
+    compiled.reset();
+
+    return ret;
+}
+
+bool ScriptMachine::FetchCompiled(opcodetype &opcode, StackItem &vchPushValue)
+{
+    // Instructions run out before the script does only if the rest of it can not be decoded
+    if (ip >= compiled->code.size())
+        return false;
+    const CompiledScript::Instruction &ins = compiled->code[ip++];
+    opcode = ins.opcode;
+    pc = pbegin + ins.next;
+    if (ins.dataSize)
+        vchPushValue.assign(pbegin + ins.dataPos, pc);
+    return true;
+}
+
+void ScriptMachine::SkipBranch()
+{
+    // Called just after an OP_IF, OP_NOTIF or OP_ELSE that leaves its branch unexecuted.  Stepping across the branch
+    // would do nothing but count its operations, so jump to the OP_ELSE or OP_ENDIF that ends it.
+    const CompiledScript::Instruction &ins = compiled->code[ip - 1];
+    if (ins.jump == CompiledScript::NO_JUMP || stats.nOpCount + ins.skipOps > maxOps)
+        return;
+    stats.nOpCount += ins.skipOps;
+    ip = ins.jump;
+    pc = pbegin + compiled->code[ip].pos;
+}
+
 bool ScriptMachine::EndStep()
 {
     script = nullptr; // let go of our use of the script
+    compiled.reset();
     if (!vfExec.empty())
         return set_error(&error, SCRIPT_ERR_UNBALANCED_CONDITIONAL);
     return set_success(&error);
@@ -397,7 +484,7 @@ bool ScriptMachine::Step()
             //
             // Read instruction
             //
-            if (!script->GetOp(pc, opcode, vchPushValue))
+            if (compiled ? !FetchCompiled(opcode, vchPushValue) : !script->GetOp(pc, opcode, vchPushValue))
             {
                 return set_error(serror, SCRIPT_ERR_BAD_OPCODE);
             }
@@ -421,7 +508,7 @@ bool ScriptMachine::Step()
                 {
                     return set_error(serror, SCRIPT_ERR_MINIMALDATA);
                 }
-                stack.push_back(vchPushValue);
+                stack.push_back(std::move(vchPushValue));
             }
             else if (fExec || (OP_IF <= opcode && opcode <= OP_ENDIF))
             {
@@ -691,7 +778,8 @@ bool ScriptMachine::Step()
                     popstack(stack); // remove code
 
                     stats.nOpExec++;
-                    sm.Eval(CScript(code.begin(), code.end()));
+                    // Subscripts are often run once, so only keep the ones that come back
+                    sm.Eval(GetCompiledScript(CScript(code.begin(), code.end()), false));
                     stats.update(sm.stats);
                     // If the evaluation of the subscript results in too many op_exec abort
                     if (stats.nOpExec > MAX_OP_EXEC)
@@ -734,6 +822,8 @@ bool ScriptMachine::Step()
                         popstack(stack);
                     }
                     vfExec.push_back(fValue);
+                    if (compiled && !vfExec.all_true())
+                        SkipBranch();
                 }
                 break;
 
@@ -744,6 +834,8 @@ bool ScriptMachine::Step()
                         return set_error(serror, SCRIPT_ERR_UNBALANCED_CONDITIONAL);
                     }
                     vfExec.toggle_top();
+                    if (compiled && !vfExec.all_true())
+                        SkipBranch();
                 }
                 break;
 
@@ -2204,7 +2296,7 @@ bool TransactionSignatureChecker::CheckSig(const vector<uint8_t> &vchSigIn,
     size_t nHashed = 0;
     if (txTo == nullptr || nIn >= txTo->vin.size())
         return false;
-    if (!SignatureHashNexa(scriptCode, *txTo, nIn, sigHashType, sighash, &nHashed))
+    if (!SignatureHashNexa(scriptCode, *txTo, nIn, sigHashType, sighash, &nHashed, txdata))
         return false;
 
     nBytesHashed += nHashed;
@@ -10,6 +10,7 @@
 #include "consensus/grouptokens.h"
 #include "primitives/transaction.h"
 #include "script/bignum.h"
+#include "script/compiledscript.h"
 #include "script/stackitem.h"
 #include "script_error.h"
 
@@ -122,6 +123,7 @@ enum
 };
 
 class BaseSignatureChecker;
+class PrecomputedTransactionData;
 
 bool CheckSignatureEncoding(const std::vector<unsigned char> &vchSig, unsigned int flags, ScriptError *serror);
 
@@ -171,22 +173,29 @@ class TransactionSignatureChecker : public BaseSignatureChecker
 protected:
     const CTransaction *txTo = nullptr;
     unsigned int nIn = 0;
+    //! optional sighash parts shared by all inputs of txTo, must outlive this checker
+    const PrecomputedTransactionData *txdata = nullptr;
     mutable size_t nBytesHashed = 0;
     mutable size_t nSigops = 0;
 
 public:
     TransactionSignatureChecker(const CTransaction *txToIn,
         unsigned int nInIn,
-        unsigned int flags = SCRIPT_ENABLE_SIGHASH_FORKID)
-        : txTo(txToIn), nIn(nInIn), nBytesHashed(0), nSigops(0)
+        unsigned int flags = SCRIPT_ENABLE_SIGHASH_FORKID,
+        const PrecomputedTransactionData *txdataIn = nullptr)
+        : txTo(txToIn), nIn(nInIn), txdata(txdataIn), nBytesHashed(0), nSigops(0)
     {
         nFlags = flags;
     }
     TransactionSignatureChecker() {} // 2 phase initialization
-    void Init(const CTransaction *txToIn, unsigned int nInIn, unsigned int flags = SCRIPT_ENABLE_SIGHASH_FORKID)
+    void Init(const CTransaction *txToIn,
+        unsigned int nInIn,
+        unsigned int flags = SCRIPT_ENABLE_SIGHASH_FORKID,
+        const PrecomputedTransactionData *txdataIn = nullptr)
     {
         txTo = txToIn;
         nIn = nInIn;
+        txdata = txdataIn;
         nFlags = flags;
         nBytesHashed = 0;
         nSigops = 0;
@@ -220,6 +229,25 @@ public:
 typedef StackItem StackDataType;
 typedef std::vector<StackItem> Stack;
 
+/** Keeps the storage of the stacks of finished script machines for the next machine created on the same thread.
+    The script check threads verify one input after another, so each machine starts with stacks that already have
+    room and pushing onto them does not allocate.
+ */
+class ScriptStackArena
+{
+protected:
+    std::vector<Stack> vFree;
+
+public:
+    /** Get an empty stack, reusing kept storage if there is any */
+    Stack take();
+    /** Clear the stack and keep its storage for a later take() */
+    void give(Stack &&stk);
+
+    /** The arena of the calling thread */
+    static ScriptStackArena &local();
+};
+
 /** All external state that a script is allowed to access must be provided here.
  */
 class ScriptImportedState
@@ -336,6 +364,15 @@ protected:
     /** Tracks current values of script execution metrics */
     ScriptMachineResourceTracker stats;
 
+    /** If the script is being run from its compiled form, that form and the index of the next instruction */
+    CompiledScriptRef compiled;
+    uint32_t ip = 0;
+
+    /** Read the next instruction of the compiled script.  Returns false if it can not be decoded */
+    bool FetchCompiled(opcodetype &opcode, StackItem &vchPushValue);
+    /** Jump across the branch that the last instruction made unexecuted, if that is equivalent to stepping */
+    void SkipBranch();
+
 private:
     /** A data type to abstract out the condition stack during script execution.
      *
@@ -420,13 +457,14 @@ public:
     const ScriptImportedState &sis;
 
     /** Bignum modulo (every bignum operation is modulo this number */
-    BigNum bigNumModulo = 0x10000000000000000_BN; // 64 bit magnitude
+    BigNum bigNumModulo = bnDefaultBmd; // 64 bit magnitude
 
     /** The maximum script size executable in the virtual machine */
     uint64_t maxScriptSize = MAX_SCRIPT_SIZE;
 
     ScriptMachine(const ScriptMachine &from)
-        : pc(from.pc), pbegin(from.pbegin), pend(from.pend), pbegincodehash(from.pbegincodehash), sis(from.sis)
+        : stack(ScriptStackArena::local().take()), altstack(ScriptStackArena::local().take()), pc(from.pc),
+          pbegin(from.pbegin), pend(from.pend), pbegincodehash(from.pbegincodehash), sis(from.sis)
     {
         flags = from.flags;
         stack = from.stack;
@@ -437,19 +475,31 @@ public:
         maxOps = from.maxOps;
         maxConsensusSigOps = from.maxConsensusSigOps;
         stats = from.stats;
+        compiled = from.compiled;
+        ip = from.ip;
     }
 
     ScriptMachine(unsigned int _flags, const ScriptImportedState &_sis, unsigned int _maxOps, unsigned int _maxSigOps)
-        : flags(_flags), script(nullptr), pc(CScript().end()), pbegin(CScript().end()), pend(CScript().end()),
+        : flags(_flags), stack(ScriptStackArena::local().take()), altstack(ScriptStackArena::local().take()),
+          script(nullptr), pc(CScript().end()), pbegin(CScript().end()), pend(CScript().end()),
           pbegincodehash(CScript().end()), maxOps(_maxOps), maxConsensusSigOps(_maxSigOps), sis(_sis)
     {
     }
 
+    ~ScriptMachine()
+    {
+        ScriptStackArena &arena = ScriptStackArena::local();
+        arena.give(std::move(stack));
+        arena.give(std::move(altstack));
+    }
+
     // How many OP_EXECs have been called recursively
     unsigned int execDepth = 0;
 
     // Execute the passed script starting at the current machine state (stack and altstack are not cleared).
     bool Eval(const CScript &_script);
+    // Execute a compiled script starting at the current machine state.  The result is the same as executing its script.
+    bool Eval(const CompiledScriptRef &_compiled);
 
     // Start a stepwise execution of a script, starting at the current machine state
     // If BeginStep succeeds, you must keep script alive until EndStep() returns
@@ -562,6 +612,10 @@ public:
     const ScriptMachineResourceTracker &getStats() { return stats; }
 };
 
+/** Returns true if the opcode fails whenever it is stepped over, even in a branch that is not taken.
+    CompiledScript relies on this not depending on the flags. */
+bool IsOpcodeDisabled(opcodetype opcode, uint32_t flags);
+
 bool EvalScript(Stack &stack,
     const CScript &script,
     unsigned int flags,
@@ -594,6 +648,31 @@ bool VerifyTemplate(const CScript &templat,
     ScriptError *serror,
     ScriptMachineResourceTracker *tracker);
 
+/** Verify a template spend by running the satisfier, the constraint and then the template script in the script
+    machine.  VerifyTemplate does this for every template that has no native verifier. */
+bool EvalTemplate(const CScript &templat,
+    const CScript &constraint,
+    const CScript &satisfier,
+    unsigned int flags,
+    unsigned int maxOps,
+    unsigned int maxActualSigops,
+    const ScriptImportedState &sis,
+    ScriptError *serror,
+    ScriptMachineResourceTracker *tracker);
+
+/** Verify a spend of the well-known p2pkt template without the script machine.  Only the usual spend is handled:
+    the constraint is a single data push (the pubkey) and so is the satisfier (the signature).  For anything else
+    this returns false and touches nothing, and the spend must be verified by EvalTemplate.  Otherwise it returns
+    true, and result, serror and tracker are set exactly as EvalTemplate would have set them. */
+bool VerifyP2pktTemplate(const CScript &constraint,
+    const CScript &satisfier,
+    unsigned int flags,
+    unsigned int maxOps,
+    const ScriptImportedState &sis,
+    ScriptError *serror,
+    ScriptMachineResourceTracker *tracker,
+    bool &result);
+
 // string prefixed to data when validating signed messages via RPC call.  This ensures
 // that the signature was intended for use on this blockchain.
 extern const std::string strMessageMagic;
@@ -38,6 +38,96 @@ bool VerifyTemplate(const CScript &templat,
     const ScriptImportedState &sis,
     ScriptError *serror,
     ScriptMachineResourceTracker *tracker)
+{
+    // Nearly every spend is p2pkt, so check those natively.  The caller has already matched the template script to
+    // its hash (or well-known identifier), so comparing the 2 script bytes identifies the p2pktHash template.
+    bool result;
+    if (templat == p2pkt && VerifyP2pktTemplate(constraint, satisfier, flags, maxOps, sis, serror, tracker, result))
+        return result;
+    return EvalTemplate(templat, constraint, satisfier, flags, maxOps, maxActualSigops, sis, serror, tracker);
+}
+
+// If script is exactly one data push that the script machine would accept, return true and put the pushed data in
+// data.
+static bool GetSingleDataPush(const CScript &script, valtype &data)
+{
+    CScript::const_iterator pc = script.begin();
+    opcodetype opcode;
+    if (!script.GetOp(pc, opcode, data) || pc != script.end() || opcode > OP_PUSHDATA4)
+        return false;
+    // Only accept minimal pushes so the result does not depend on SCRIPT_VERIFY_MINIMALDATA
+    return data.size() <= MAX_SCRIPT_ELEMENT_SIZE && CheckMinimalPush(data, opcode);
+}
+
+bool VerifyP2pktTemplate(const CScript &constraint,
+    const CScript &satisfier,
+    unsigned int flags,
+    unsigned int maxOps,
+    const ScriptImportedState &sis,
+    ScriptError *serror,
+    ScriptMachineResourceTracker *tracker,
+    bool &result)
+{
+    // The template executes OP_FROMALTSTACK and OP_CHECKSIGVERIFY, which both count toward the operation limit.
+    // Let the script machine report anything unusual.
+    const unsigned int templateOps = 2;
+    if (maxOps < templateOps)
+        return false;
+    valtype vchPubKey;
+    valtype vchSig;
+    if (!GetSingleDataPush(constraint, vchPubKey) || !GetSingleDataPush(satisfier, vchSig))
+        return false;
+
+    // From here on, do exactly what OP_CHECKSIGVERIFY does in the script machine.  Its script code is the whole
+    // template: the signature is a data push, which can not match either template opcode, so FindAndDelete
+    // never removes anything.
+    try
+    {
+        if (!CheckSignatureEncoding(vchSig, flags, serror) || !CheckPubKeyEncoding(vchPubKey, flags, serror))
+        {
+            result = false;
+            return true;
+        }
+        if (!sis.checker)
+        {
+            result = set_error(serror, SCRIPT_ERR_DATA_REQUIRED);
+            return true;
+        }
+        if (!sis.checker->CheckSig(vchSig, vchPubKey, p2pkt))
+        {
+            if ((flags & SCRIPT_VERIFY_NULLFAIL) && vchSig.size())
+                result = set_error(serror, SCRIPT_ERR_SIG_NULLFAIL);
+            else
+                result = set_error(serror, SCRIPT_ERR_CHECKSIGVERIFY);
+            return true;
+        }
+    }
+    catch (...)
+    {
+        result = set_error(serror, SCRIPT_ERR_UNKNOWN_ERROR);
+        return true;
+    }
+
+    if (tracker)
+    {
+        ScriptMachineResourceTracker stats;
+        stats.nOpCount = templateOps;
+        stats.consensusSigCheckCount = 1; // the signature can not be empty if it verified
+        tracker->update(stats);
+    }
+    result = set_success(serror);
+    return true;
+}
+
+bool EvalTemplate(const CScript &templat,
+    const CScript &constraint,
+    const CScript &satisfier,
+    unsigned int flags,
+    unsigned int maxOps,
+    unsigned int maxActualSigops,
+    const ScriptImportedState &sis,
+    ScriptError *serror,
+    ScriptMachineResourceTracker *tracker)
 {
     set_error(serror, SCRIPT_ERR_UNKNOWN_ERROR);
 
@@ -94,8 +184,8 @@ bool VerifyTemplate(const CScript &templat,
     // The data the satisfier script leaves for the template goes on the main stack (just like traditional BTC).
     sm.setStack(ssm.getStack());
 
-    // Step 3, evaluate the template
-    if (!sm.Eval(templat))
+    // Step 3, evaluate the template.  The same templates run over and over, so run them from the compiled script cache
+    if (!sm.Eval(GetCompiledScript(templat)))
     {
         if (serror)
             *serror = sm.getError();
@@ -50,8 +50,9 @@ public:
         unsigned int nInIn,
         const CAmount &amountIn,
         unsigned int flags,
-        bool storeIn = true)
-        : TransactionSignatureChecker(txToIn, nInIn, flags), store(storeIn)
+        bool storeIn = true,
+        const PrecomputedTransactionData *txdataIn = nullptr)
+        : TransactionSignatureChecker(txToIn, nInIn, flags, txdataIn), store(storeIn)
     {
     }
 
@@ -8,6 +8,7 @@
 
 /* clang-format on */
 #include "base58.h"
+#include "crypto/sha256.h"
 #include "primitives/transaction.h"
 #include "script/sighashtype.h"
 #include "script/sign.h"
@@ -17,6 +18,8 @@
 #include "utilstrencodings.h"
 
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -139,6 +142,79 @@ uint256 GetOutputsHashOf(const CTransaction &txTo, unsigned int a, unsigned int
     return ss.GetHash();
 }
 
+/** Set vFirstN[n] to the hash of the first n items, for every n up to the largest count a sighash type can hold */
+template <typename WriteItem>
+static void HashFirstN(size_t nItems, std::vector<uint256> &vFirstN, WriteItem writeItem)
+{
+    const size_t nMax = std::min<size_t>(nItems, std::numeric_limits<uint8_t>::max());
+    vFirstN.resize(nMax + 1);
+    CHashWriter ss(SER_GETHASH, 0);
+    for (size_t n = 0;; n++)
+    {
+        // finalize a copy, so the running hash can go on
+        vFirstN[n] = CHashWriter(ss).GetHash();
+        if (n == nMax)
+            break;
+        writeItem(ss, n);
+    }
+}
+
+PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction &txTo)
+{
+    // Serialize the four components and hash them side by side, which is quicker than one after the other
+    // when the sha256 implementation can run several hashes at once.
+    CDataStream ssPrevouts(SER_GETHASH, 0), ssSequence(SER_GETHASH, 0), ssInputAmounts(SER_GETHASH, 0);
+    CDataStream ssOutputs(SER_GETHASH, 0);
+    for (const CTxIn &txin : txTo.vin)
+    {
+        ssPrevouts << txin.type << txin.prevout;
+        ssSequence << txin.nSequence;
+        ssInputAmounts << txin.amount;
+    }
+    for (const CTxOut &txout : txTo.vout)
+    {
+        ssOutputs << txout;
+    }
+
+    const unsigned char *inputs[4] = {(const unsigned char *)ssPrevouts.data(),
+        (const unsigned char *)ssSequence.data(), (const unsigned char *)ssInputAmounts.data(),
+        (const unsigned char *)ssOutputs.data()};
+    const size_t lengths[4] = {ssPrevouts.size(), ssSequence.size(), ssInputAmounts.size(), ssOutputs.size()};
+    unsigned char hashes[4 * CSHA256::OUTPUT_SIZE];
+    SHA256DMulti(hashes, inputs, lengths, 4);
+    memcpy(hashPrevouts.begin(), hashes, CSHA256::OUTPUT_SIZE);
+    memcpy(hashSequence.begin(), hashes + CSHA256::OUTPUT_SIZE, CSHA256::OUTPUT_SIZE);
+    memcpy(hashInputAmounts.begin(), hashes + 2 * CSHA256::OUTPUT_SIZE, CSHA256::OUTPUT_SIZE);
+    memcpy(hashOutputs.begin(), hashes + 3 * CSHA256::OUTPUT_SIZE, CSHA256::OUTPUT_SIZE);
+}
+
+void PrecomputedTransactionData::GetFirstNInputHashes(const CTransaction &txTo,
+    unsigned int firstN,
+    uint256 &hashPrevoutsOut,
+    uint256 &hashSequenceOut,
+    uint256 &hashInputAmountsOut) const
+{
+    std::call_once(inputsOnce, [&]() {
+        HashFirstN(txTo.vin.size(), vPrevoutsFirstN,
+            [&](CHashWriter &ss, size_t n) { ss << txTo.vin[n].type << txTo.vin[n].prevout; });
+        HashFirstN(txTo.vin.size(), vSequenceFirstN, [&](CHashWriter &ss, size_t n) { ss << txTo.vin[n].nSequence; });
+        HashFirstN(txTo.vin.size(), vInputAmountsFirstN, [&](CHashWriter &ss, size_t n) { ss << txTo.vin[n].amount; });
+    });
+    assert(firstN < vPrevoutsFirstN.size());
+    hashPrevoutsOut = vPrevoutsFirstN[firstN];
+    hashSequenceOut = vSequenceFirstN[firstN];
+    hashInputAmountsOut = vInputAmountsFirstN[firstN];
+}
+
+const uint256 &PrecomputedTransactionData::GetFirstNOutputsHash(const CTransaction &txTo, unsigned int firstN) const
+{
+    std::call_once(outputsOnce, [&]() {
+        HashFirstN(txTo.vout.size(), vOutputsFirstN, [&](CHashWriter &ss, size_t n) { ss << txTo.vout[n]; });
+    });
+    assert(firstN < vOutputsFirstN.size());
+    return vOutputsFirstN[firstN];
+}
+
 /**
  * Wrapper that serializes like CTransaction, but with the modifications
  *  required for the signature hash done in-place
@@ -377,6 +453,19 @@ bool SignatureHashNexaComponents(const CTransaction &txTo,
     uint256 &hashSequence,
     uint256 &hashInputAmounts,
     uint256 &hashOutputs)
+{
+    return SignatureHashNexaComponents(
+        txTo, nIn, sigHashType, hashPrevouts, hashSequence, hashInputAmounts, hashOutputs, nullptr);
+}
+
+bool SignatureHashNexaComponents(const CTransaction &txTo,
+    unsigned int nIn,
+    const SigHashType &sigHashType,
+    uint256 &hashPrevouts,
+    uint256 &hashSequence,
+    uint256 &hashInputAmounts,
+    uint256 &hashOutputs,
+    const PrecomputedTransactionData *txdata)
 {
     size_t vinSize = txTo.vin.size();
     size_t voutSize = txTo.vout.size();
@@ -395,6 +484,11 @@ bool SignatureHashNexaComponents(const CTransaction &txTo,
         unsigned int firstN = sigHashType.inpData[0];
         if (firstN > vinSize)
             return false;
+        if (txdata)
+        {
+            txdata->GetFirstNInputHashes(txTo, firstN, hashPrevouts, hashSequence, hashInputAmounts);
+            break;
+        }
         hashPrevouts = GetPrevoutHash(txTo, firstN);
         hashSequence = GetSequenceHash(txTo, firstN);
         hashInputAmounts = GetInputAmountHash(txTo, firstN);
@@ -412,6 +506,13 @@ bool SignatureHashNexaComponents(const CTransaction &txTo,
     case SigHashType::Input::ALL:
         // Shouldn't ever happen because sighashtype would be invalid()
         DbgAssert(sigHashType.inpData.size() == 0, return false);
+        if (txdata)
+        {
+            hashPrevouts = txdata->hashPrevouts;
+            hashSequence = txdata->hashSequence;
+            hashInputAmounts = txdata->hashInputAmounts;
+            break;
+        }
         hashPrevouts = GetPrevoutHash(txTo, vinSize);
         hashSequence = GetSequenceHash(txTo, vinSize);
         hashInputAmounts = GetInputAmountHash(txTo, vinSize);
@@ -439,11 +540,11 @@ bool SignatureHashNexaComponents(const CTransaction &txTo,
         unsigned int count = sigHashType.outData[0];
         if (count > voutSize)
             return false;
-        hashOutputs = GetOutputsHash(txTo, count);
+        hashOutputs = txdata ? txdata->GetFirstNOutputsHash(txTo, count) : GetOutputsHash(txTo, count);
     }
     break;
     case SigHashType::Output::ALL:
-        hashOutputs = GetOutputsHash(txTo, voutSize);
+        hashOutputs = txdata ? txdata->hashOutputs : GetOutputsHash(txTo, voutSize);
         break;
     default:
         return false;
@@ -457,7 +558,8 @@ bool SignatureHashNexa(const CScript &scriptCode,
     unsigned int nIn,
     const SigHashType &sigHashType,
     uint256 &result,
-    size_t *nHashedOut)
+    size_t *nHashedOut,
+    const PrecomputedTransactionData *txdata)
 {
     uint256 hashPrevouts;
     uint256 hashSequence;
@@ -468,7 +570,8 @@ bool SignatureHashNexa(const CScript &scriptCode,
     result = SIGNATURE_HASH_ERROR;
 
     // Calculate all needed portions of the sighash
-    if (!SignatureHashNexaComponents(txTo, nIn, sigHashType, hashPrevouts, hashSequence, hashInputAmounts, hashOutputs))
+    if (!SignatureHashNexaComponents(
+            txTo, nIn, sigHashType, hashPrevouts, hashSequence, hashInputAmounts, hashOutputs, txdata))
         return false;
 
     return SignatureHashNexa(scriptCode, txTo.nVersion, txTo.nLockTime, sigHashType, hashPrevouts, hashSequence,
@@ -10,6 +10,8 @@
 #include "serialize.h"
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -24,6 +26,8 @@ enum
     BTCBCH_SIGHASH_ANYONECANPAY = 0x80,
 };
 
+class PrecomputedTransactionData;
+
 /** Signature hash type wrapper class */
 class SigHashType
 {
@@ -195,6 +199,14 @@ public:
         uint256 &hashSequence,
         uint256 &hashInputAmounts,
         uint256 &hashOutputs);
+    friend bool SignatureHashNexaComponents(const CTransaction &txTo,
+        unsigned int nIn,
+        const SigHashType &sigHashType,
+        uint256 &hashPrevouts,
+        uint256 &hashSequence,
+        uint256 &hashInputAmounts,
+        uint256 &hashOutputs,
+        const PrecomputedTransactionData *txdata);
 };
 
 inline SigHashType::Input &operator++(SigHashType::Input &c)
@@ -209,6 +221,48 @@ inline SigHashType::Output &operator++(SigHashType::Output &c)
     return c;
 }
 
+/**
+ * The parts of the signature hash that are the same for every input of a transaction.
+ *
+ * Without it every signature using the ALL or FIRSTN input and output types hashes the prevouts, sequences, amounts
+ * and outputs of the transaction again, which makes verifying a transaction quadratic in its number of inputs.
+ * Construct it once per transaction and share it between the checks of all of its inputs.
+ *
+ * The ALL hashes are computed right away. The FIRSTN hashes, for every N the sighash type can encode, are computed
+ * the first time a signature needs them, in a single pass over the inputs (or outputs). Safe to use from several
+ * script check threads at once.
+ */
+class PrecomputedTransactionData
+{
+public:
+    uint256 hashPrevouts;
+    uint256 hashSequence;
+    uint256 hashInputAmounts;
+    uint256 hashOutputs;
+
+    explicit PrecomputedTransactionData(const CTransaction &txTo);
+
+    /** Get the input hashes of the first firstN inputs of txTo, which must be the transaction this was built for */
+    void GetFirstNInputHashes(const CTransaction &txTo,
+        unsigned int firstN,
+        uint256 &hashPrevoutsOut,
+        uint256 &hashSequenceOut,
+        uint256 &hashInputAmountsOut) const;
+
+    /** Get the hash of the first firstN outputs of txTo, which must be the transaction this was built for */
+    const uint256 &GetFirstNOutputsHash(const CTransaction &txTo, unsigned int firstN) const;
+
+private:
+    mutable std::once_flag inputsOnce;
+    mutable std::once_flag outputsOnce;
+    //! element n is the hash of the first n inputs (or outputs)
+    mutable std::vector<uint256> vPrevoutsFirstN;
+    mutable std::vector<uint256> vSequenceFirstN;
+    mutable std::vector<uint256> vInputAmountsFirstN;
+    mutable std::vector<uint256> vOutputsFirstN;
+};
+typedef std::shared_ptr<const PrecomputedTransactionData> PrecomputedTransactionDataRef;
+
 /** Calculate the hash that a signature of this transaction signs.  The algorithm depends on sigHashType,
     Both in determining whether to use the Bitcoin Cash or Bitcoin algorithm, and also the specific data and
     algorithm within those two families. */
@@ -224,7 +278,8 @@ bool SignatureHashNexa(const CScript &scriptCode,
     unsigned int nIn,
     const SigHashType &sigHashType,
     uint256 &result,
-    size_t *nHashedOut = nullptr);
+    size_t *nHashedOut = nullptr,
+    const PrecomputedTransactionData *txdata = nullptr);
 
 /** Given the components of the sighash, calculate it
     (used by double spend proofs and normal signature calculation)
@@ -10,7 +10,9 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 class CScript;
@@ -46,11 +48,80 @@ public:
 
 protected: // Because access should verify the type
     VchType vch;
-    BigNum n;
+    union
+    {
+        // Only constructed while type is BIGNUM, so that byte array items (nearly all of them) never touch GMP
+        BigNum n;
+    };
+
+    // Turn this item into an (unchanged) byte array, destroying the BigNum if it is one
+    void toVch()
+    {
+        if (type == StackElementType::BIGNUM)
+        {
+            n.~BigNum();
+            type = StackElementType::VCH;
+        }
+    }
 
 public:
     // Default constructor sets its as a 0 size byte array
     StackItem() : type(StackElementType::VCH), vch(0) {}
+    StackItem(const StackItem &other) : type(other.type), vch(other.vch)
+    {
+        if (type == StackElementType::BIGNUM)
+            new (&n) BigNum(other.n);
+    }
+    // noexcept so that growing a Stack moves its items rather than copying them
+    StackItem(StackItem &&other) noexcept : type(other.type), vch(std::move(other.vch))
+    {
+        if (type == StackElementType::BIGNUM)
+            new (&n) BigNum(std::move(other.n));
+    }
+    ~StackItem() { toVch(); }
+
+    StackItem &operator=(const StackItem &other)
+    {
+        if (this == &other)
+            return *this;
+        if (other.type == StackElementType::BIGNUM)
+        {
+            if (type == StackElementType::BIGNUM)
+                n = other.n;
+            else
+                new (&n) BigNum(other.n);
+            vch.clear();
+        }
+        else
+        {
+            toVch();
+            vch = other.vch;
+        }
+        type = other.type;
+        return *this;
+    }
+
+    StackItem &operator=(StackItem &&other) noexcept
+    {
+        if (this == &other)
+            return *this;
+        if (other.type == StackElementType::BIGNUM)
+        {
+            if (type == StackElementType::BIGNUM)
+                n = std::move(other.n);
+            else
+                new (&n) BigNum(std::move(other.n));
+            vch.clear();
+        }
+        else
+        {
+            toVch();
+            vch = std::move(other.vch);
+        }
+        type = other.type;
+        return *this;
+    }
+
     // construct a vch stack item from memory
     StackItem(const unsigned char *begin, const unsigned char *end) : type(StackElementType::VCH), vch(begin, end) {}
     /*
@@ -87,7 +158,8 @@ public:
     {
     }
 
-    StackItem(const BigNum &bn) : type(StackElementType::BIGNUM), n(bn) {}
+    StackItem(const BigNum &bn) : type(StackElementType::BIGNUM) { new (&n) BigNum(bn); }
+    StackItem(BigNum &&bn) : type(StackElementType::BIGNUM) { new (&n) BigNum(std::move(bn)); }
     // Construct a StackItem as a vch if given a constant initializer of unsigned char
     // const StackItem example{0x30, 0x06, 0x02, 0x01, 0x01, 0x02, 0x01, 0x01};
     StackItem(const std::initializer_list<unsigned char> &ini)
@@ -193,20 +265,20 @@ public:
 
     void clear(void)
     {
-        type = StackElementType::VCH;
+        toVch();
         vch.clear();
     }
 
     template <class ITER>
     void assign(ITER pbegin, ITER pend)
     {
-        type = StackElementType::VCH;
+        toVch();
         vch.assign(pbegin, pend);
     }
 
     void assign(const VchType &buf)
     {
-        type = StackElementType::VCH;
+        toVch();
         vch = buf;
     }
 
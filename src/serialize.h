@@ -115,6 +115,12 @@ inline void ser_writedata32(Stream &s, uint32_t obj)
     s.write((char *)&obj, 4);
 }
 template <typename Stream>
+inline void ser_writedata32be(Stream &s, uint32_t obj)
+{
+    obj = htobe32(obj);
+    s.write((char *)&obj, 4);
+}
+template <typename Stream>
 inline void ser_writedata64(Stream &s, uint64_t obj)
 {
     obj = htole64(obj);
@@ -142,6 +148,13 @@ inline uint32_t ser_readdata32(Stream &s)
     return le32toh(obj);
 }
 template <typename Stream>
+inline uint32_t ser_readdata32be(Stream &s)
+{
+    uint32_t obj = 0;
+    s.read((char *)&obj, 4);
+    return be32toh(obj);
+}
+template <typename Stream>
 inline uint64_t ser_readdata64(Stream &s)
 {
     uint64_t obj = 0;
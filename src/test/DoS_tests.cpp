@@ -14,6 +14,7 @@
 #include "pow.h"
 #include "script/sign.h"
 #include "serialize.h"
+#include "txadmission.h"
 #include "txorphanpool.h"
 #include "util.h"
 
@@ -328,11 +329,9 @@ BOOST_AUTO_TEST_CASE(DoS_bantime_expiration)
 
 CTransaction RandomOrphan()
 {
-    std::map<uint256, CTxOrphanPool::COrphanTx>::iterator it;
     READLOCK(orphanpool.cs_orphanpool);
-    it = orphanpool.mapOrphanTransactions.lower_bound(InsecureRand256());
-    if (it == orphanpool.mapOrphanTransactions.end())
-        it = orphanpool.mapOrphanTransactions.begin();
+    auto it = orphanpool.mapOrphanTransactions.begin();
+    std::advance(it, InsecureRandRange(orphanpool.mapOrphanTransactions.size()));
     return *it->second.ptx;
 }
 
@@ -515,4 +514,150 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     }
 }
 
+static CTransactionRef OrphanSpending(const std::vector<COutPoint> &prevouts)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(prevouts.size());
+    for (size_t i = 0; i < prevouts.size(); i++)
+    {
+        tx.vin[i].prevout = prevouts[i];
+        tx.vin[i].amount = 1;
+        tx.vin[i].scriptSig << OP_1;
+    }
+    tx.vout.resize(2);
+    tx.vout[0].nValue = 1 * CENT;
+    tx.vout[0].scriptPubKey = CScript() << OP_1;
+    tx.vout[1].nValue = 1 * CENT;
+    tx.vout[1].scriptPubKey = CScript() << OP_2;
+    return MakeTransactionRef(tx);
+}
+
+static CTransactionRef RandomOrphanTx() { return OrphanSpending({COutPoint(InsecureRand256())}); }
+
+BOOST_AUTO_TEST_CASE(DoS_orphanEvictionOrder)
+{
+    orphanpool.clear();
+    int64_t nStartTime = GetTime();
+    std::vector<CTransactionRef> vOrphans;
+    for (int i = 0; i < 10; i++)
+    {
+        SetMockTime(nStartTime + i);
+        vOrphans.push_back(RandomOrphanTx());
+        WRITELOCK(orphanpool.cs_orphanpool);
+        BOOST_CHECK(orphanpool.AddOrphanTx(vOrphans.back(), i % 3));
+    }
+
+    // The oldest orphans go first
+    {
+        WRITELOCK(orphanpool.cs_orphanpool);
+        BOOST_CHECK_EQUAL(orphanpool.LimitOrphanTxSize(6, 10000000), 4U);
+    }
+    for (int i = 0; i < 10; i++)
+        BOOST_CHECK_EQUAL(orphanpool.AlreadyHaveOrphan(vOrphans[i]->GetId()), i >= 4);
+
+    // Each peer's memory use follows its orphans
+    uint64_t nPeerBytes = 0;
+    {
+        READLOCK(orphanpool.cs_orphanpool);
+        for (auto &it : orphanpool.mapOrphanTransactions)
+        {
+            if (it.second.fromPeer == 1)
+                nPeerBytes += it.second.nOrphanTxSize;
+        }
+    }
+    BOOST_CHECK_EQUAL(orphanpool.GetPeerOrphanBytes(1), nPeerBytes);
+
+    orphanpool.clear();
+    BOOST_CHECK_EQUAL(orphanpool.GetPeerOrphanBytes(1), 0U);
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(DoS_orphanPeerQuota)
+{
+    orphanpool.clear();
+    // A 1MB txpool leaves 100KB for orphans, and a quarter of that for each peer
+    maxTxPool.Set(1);
+    const uint64_t nQuota = CTxOrphanPool::PeerQuota();
+    BOOST_CHECK_EQUAL(nQuota, 25000U);
+
+    int64_t nStartTime = GetTime();
+    SetMockTime(nStartTime);
+    std::vector<CTransactionRef> vHonest;
+    for (int i = 0; i < 5; i++)
+    {
+        vHonest.push_back(RandomOrphanTx());
+        WRITELOCK(orphanpool.cs_orphanpool);
+        BOOST_CHECK(orphanpool.AddOrphanTx(vHonest.back(), 2));
+    }
+
+    // A flooding peer only pushes out its own, oldest, orphans
+    std::vector<CTransactionRef> vFlood;
+    for (int i = 0; i < 1000; i++)
+    {
+        SetMockTime(nStartTime + 1 + i);
+        vFlood.push_back(RandomOrphanTx());
+        {
+            WRITELOCK(orphanpool.cs_orphanpool);
+            BOOST_CHECK(orphanpool.AddOrphanTx(vFlood.back(), 1));
+        }
+        BOOST_CHECK(orphanpool.GetPeerOrphanBytes(1) <= nQuota);
+    }
+    BOOST_CHECK(orphanpool.GetPeerOrphanBytes(1) > nQuota / 2);
+    BOOST_CHECK(!orphanpool.AlreadyHaveOrphan(vFlood.front()->GetId()));
+    BOOST_CHECK(orphanpool.AlreadyHaveOrphan(vFlood.back()->GetId()));
+    for (const auto &tx : vHonest)
+        BOOST_CHECK(orphanpool.AlreadyHaveOrphan(tx->GetId()));
+    uint64_t nPeerBytes = orphanpool.GetPeerOrphanBytes(1) + orphanpool.GetPeerOrphanBytes(2);
+    BOOST_CHECK_EQUAL(orphanpool.GetOrphanPoolBytes(), nPeerBytes);
+
+    orphanpool.clear();
+    maxTxPool.Set(DEFAULT_MAX_MEMPOOL_SIZE);
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(DoS_orphanBatchedResolution)
+{
+    orphanpool.clear();
+    CTransactionRef parent1 = RandomOrphanTx();
+    CTransactionRef parent2 = RandomOrphanTx();
+    CTransactionRef a = OrphanSpending({parent1->OutpointAt(0)});
+    CTransactionRef b = OrphanSpending({parent1->OutpointAt(1), parent2->OutpointAt(0)});
+    CTransactionRef c = OrphanSpending({parent2->OutpointAt(1)});
+    CTransactionRef unrelated = RandomOrphanTx();
+    {
+        WRITELOCK(orphanpool.cs_orphanpool);
+        for (const auto &tx : {a, b, c, unrelated})
+            BOOST_CHECK(orphanpool.AddOrphanTx(tx, 1));
+        BOOST_CHECK_EQUAL(orphanpool.mapOrphanTransactionsByPrev.size(), 5U);
+    }
+
+    size_t nQueued;
+    {
+        LOCK(csTxInQ);
+        nQueued = txInQ.size() + txDeferQ.size();
+    }
+
+    // Both parents arriving together release every orphan that spends them, each one once
+    std::vector<CTransactionRef> vWorkQueue{parent1, parent2};
+    ProcessOrphans(vWorkQueue);
+    BOOST_CHECK_EQUAL(orphanpool.GetOrphanPoolSize(), 1U);
+    BOOST_CHECK(orphanpool.AlreadyHaveOrphan(unrelated->GetId()));
+    {
+        READLOCK(orphanpool.cs_orphanpool);
+        BOOST_CHECK_EQUAL(orphanpool.mapOrphanTransactionsByPrev.size(), 1U);
+        BOOST_CHECK_EQUAL(orphanpool.nBytesOrphanPool, orphanpool.mapOrphanTransactions.begin()->second.nOrphanTxSize);
+    }
+    {
+        LOCK(csTxInQ);
+        BOOST_CHECK_EQUAL(txInQ.size() + txDeferQ.size(), nQueued + 3);
+        // Admission threads are not running in this test, so empty the queues again
+        while (!txInQ.empty())
+            txInQ.pop();
+        while (!txDeferQ.empty())
+            txDeferQ.pop();
+        incomingConflicts.reset();
+    }
+    orphanpool.clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
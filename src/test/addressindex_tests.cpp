@@ -0,0 +1,132 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/addressindex.h"
+#include "test/test_nexa.h"
+#include "test/testutil.h"
+#include "undo.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, TestingSetup)
+
+static CAddressBalance Balance(const AddressIndex &index, const CScript &script)
+{
+    CAddressBalance balance;
+    BOOST_CHECK(index.GetBalance(ScriptHash(script), balance));
+    return balance;
+}
+
+static std::vector<std::pair<uint256, CAddressUnspentValue> > Unspent(const AddressIndex &index,
+    const CScript &script)
+{
+    std::vector<std::pair<uint256, CAddressUnspentValue> > entries;
+    BOOST_CHECK(index.GetUnspent(ScriptHash(script), uint256(), 100, entries));
+    return entries;
+}
+
+BOOST_AUTO_TEST_CASE(connect_and_rewind)
+{
+    AddressIndex index(new AddressIndexDB(1 << 20, true, true));
+
+    const CScript scriptA = CScript() << OP_1;
+    const CScript scriptB = CScript() << OP_2;
+    const CScript scriptC = CScript() << OP_3;
+    const CScript scriptD = CScript() << OP_4;
+
+    TestBlockIndexChain indexes(2);
+
+    // Block 0: a coinbase paying 50 to A
+    CBlock block0;
+    block0.vtx.push_back(MakeTx({}, {CTxOut(50 * COIN, scriptA)}));
+    BOOST_CHECK(index.WriteBlock(block0, CBlockUndo(), indexes[0]));
+    const uint256 idem0 = block0.vtx[0]->GetIdem();
+
+    // Block 1: tx1 spends A's coinbase output paying 30 to B and 20 back to A, and tx2 spends the B output of tx1
+    // to D. tx2 is placed first, as canonical ordering allows.
+    CBlock block1;
+    CTransactionRef tx1 = MakeTx({COutPoint(idem0, 0)}, {CTxOut(30 * COIN, scriptB), CTxOut(20 * COIN, scriptA)});
+    CTransactionRef tx2 = MakeTx({COutPoint(tx1->GetIdem(), 0)}, {CTxOut(30 * COIN, scriptD)});
+    block1.vtx.push_back(MakeTx({}, {CTxOut(50 * COIN, scriptC)}));
+    block1.vtx.push_back(tx2);
+    block1.vtx.push_back(tx1);
+
+    CBlockUndo undo1;
+    undo1.vtxundo.resize(2);
+    undo1.vtxundo[0].vprevout.emplace_back(CTxOut(30 * COIN, scriptB), 1, false);
+    undo1.vtxundo[1].vprevout.emplace_back(CTxOut(50 * COIN, scriptA), 0, true);
+    BOOST_CHECK(index.WriteBlock(block1, undo1, indexes[1]));
+
+    CAddressBalance balanceA = Balance(index, scriptA);
+    BOOST_CHECK_EQUAL(balanceA.received, 70 * COIN);
+    BOOST_CHECK_EQUAL(balanceA.balance, 20 * COIN);
+    BOOST_CHECK_EQUAL(balanceA.nHistory, 3U);
+    BOOST_CHECK_EQUAL(balanceA.nUnspent, 1U);
+
+    CAddressBalance balanceB = Balance(index, scriptB);
+    BOOST_CHECK_EQUAL(balanceB.balance, 0);
+    BOOST_CHECK_EQUAL(balanceB.nHistory, 2U);
+    BOOST_CHECK_EQUAL(balanceB.nUnspent, 0U);
+    BOOST_CHECK(Unspent(index, scriptB).empty());
+    BOOST_CHECK_EQUAL(Balance(index, scriptD).balance, 30 * COIN);
+
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > history;
+    BOOST_CHECK(index.GetHistory(ScriptHash(scriptA), 0, 100, history));
+    BOOST_CHECK_EQUAL(history.size(), 3U);
+    BOOST_CHECK_EQUAL(history[0].first.height, 0U);
+    BOOST_CHECK_EQUAL(history[0].second.amount, 50 * COIN);
+    BOOST_CHECK_EQUAL(history[1].first.height, 1U);
+    BOOST_CHECK_EQUAL(history[2].first.height, 1U);
+
+    // paging by height skips the earlier entries
+    history.clear();
+    BOOST_CHECK(index.GetHistory(ScriptHash(scriptA), 1, 100, history));
+    BOOST_CHECK_EQUAL(history.size(), 2U);
+
+    // paging with a cursor continues inside a height without repeating or skipping entries
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > page;
+    BOOST_CHECK(index.GetHistory(ScriptHash(scriptA), 1, 1, page));
+    BOOST_CHECK_EQUAL(page.size(), 1U);
+    BOOST_CHECK(page[0].first.txhash == history[0].first.txhash && page[0].first.index == history[0].first.index);
+    const CAddressHistoryKey cursor = page.back().first;
+    page.clear();
+    BOOST_CHECK(index.GetHistory(cursor, 100, page));
+    BOOST_CHECK_EQUAL(page.size(), 1U);
+    BOOST_CHECK(page[0].first.txhash == history[1].first.txhash && page[0].first.index == history[1].first.index &&
+                page[0].first.fSpend == history[1].first.fSpend);
+
+    auto unspentA = Unspent(index, scriptA);
+    BOOST_CHECK_EQUAL(unspentA.size(), 1U);
+    BOOST_CHECK(unspentA[0].first == COutPoint(tx1->GetIdem(), 1).hash);
+    BOOST_CHECK(unspentA[0].second.txidem == tx1->GetIdem());
+    BOOST_CHECK_EQUAL(unspentA[0].second.n, 1U);
+    BOOST_CHECK_EQUAL(unspentA[0].second.amount, 20 * COIN);
+
+    // Disconnecting block 1 restores A's coinbase output and removes everything else that block 1 added
+    BOOST_CHECK(index.RewindBlock(block1, undo1, indexes[1]));
+
+    balanceA = Balance(index, scriptA);
+    BOOST_CHECK_EQUAL(balanceA.received, 50 * COIN);
+    BOOST_CHECK_EQUAL(balanceA.balance, 50 * COIN);
+    BOOST_CHECK_EQUAL(balanceA.nHistory, 1U);
+    BOOST_CHECK_EQUAL(balanceA.nUnspent, 1U);
+
+    unspentA = Unspent(index, scriptA);
+    BOOST_CHECK_EQUAL(unspentA.size(), 1U);
+    BOOST_CHECK(unspentA[0].first == COutPoint(idem0, 0).hash);
+    BOOST_CHECK(unspentA[0].second.txidem == idem0);
+    BOOST_CHECK_EQUAL(unspentA[0].second.n, 0U);
+    BOOST_CHECK_EQUAL(unspentA[0].second.height, 0U);
+
+    for (const CScript &script : {scriptB, scriptC, scriptD})
+    {
+        BOOST_CHECK_EQUAL(Balance(index, script).nHistory, 0U);
+        BOOST_CHECK(Unspent(index, script).empty());
+        history.clear();
+        BOOST_CHECK(index.GetHistory(ScriptHash(script), 0, 100, history));
+        BOOST_CHECK(history.empty());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
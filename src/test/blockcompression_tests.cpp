@@ -0,0 +1,157 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockstorage/blockcompression.h"
+#include "blockstorage/blockstorage.h"
+#include "blockstorage/sequential_files.h"
+#include "chainparams.h"
+#include "hashwrapper.h"
+#include "main.h"
+#include "random.h"
+#include "test/test_nexa.h"
+#include "undo.h"
+
+#include <boost/test/unit_test.hpp>
+
+extern CCriticalSection cs_LastBlockFile;
+
+BOOST_FIXTURE_TEST_SUITE(blockcompression_tests, TestingSetup)
+
+static const BlockCompression ALL_CODECS[] = {BlockCompression::NONE, BlockCompression::LZ4, BlockCompression::ZSTD};
+
+/** Undo data with many repeated scripts, which any codec compresses well */
+static CBlockUndo MakeBlockUndo()
+{
+    CBlockUndo blockundo;
+    for (int i = 0; i < 50; i++)
+    {
+        blockundo.vtxundo.emplace_back();
+        for (int j = 0; j < 10; j++)
+        {
+            CScript script = CScript() << std::vector<unsigned char>(32, i) << OP_EQUAL;
+            blockundo.vtxundo.back().vprevout.emplace_back(CTxOut(1000 * j, script), 100 + i, false);
+        }
+    }
+    return blockundo;
+}
+
+static uint256 SerializeHash(const CBlockUndo &blockundo)
+{
+    CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+    hasher << blockundo;
+    return hasher.GetHash();
+}
+
+BOOST_AUTO_TEST_CASE(codec_names)
+{
+    for (BlockCompression codec : ALL_CODECS)
+    {
+        BlockCompression parsed;
+        BOOST_CHECK(BlockCompressionFromName(BlockCompressionName(codec), parsed));
+        BOOST_CHECK(parsed == codec);
+    }
+    BlockCompression parsed;
+    BOOST_CHECK(!BlockCompressionFromName("gzip", parsed));
+    BOOST_CHECK(IsBlockCompressionSupported(BlockCompression::NONE));
+    BOOST_CHECK(SupportedBlockCompressionNames().find("none") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(record_roundtrip)
+{
+    std::vector<unsigned char> raw;
+    for (int i = 0; i < 5000; i++)
+        raw.push_back(i % 7);
+
+    std::vector<unsigned char> record;
+    BOOST_CHECK(!CompressRecord(BlockCompression::NONE, 0, raw.data(), raw.size(), record));
+    BOOST_CHECK(record.empty());
+    BOOST_CHECK(!IsCompressedRecord(raw.data(), raw.size()));
+
+    for (BlockCompression codec : ALL_CODECS)
+    {
+        if (codec == BlockCompression::NONE || !IsBlockCompressionSupported(codec))
+            continue;
+        BOOST_CHECK(CompressRecord(codec, 0, raw.data(), raw.size(), record));
+        BOOST_CHECK(record.size() < raw.size());
+        BOOST_CHECK(IsCompressedRecord(record.data(), record.size()));
+
+        std::vector<unsigned char> decompressed;
+        DecompressRecord(record.data(), record.size(), decompressed);
+        BOOST_CHECK(decompressed == raw);
+
+        // The same record read from a stream
+        CDataStream ss(record, SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(ReadCompressedRecord(ss, decompressed));
+        BOOST_CHECK(decompressed == raw);
+
+        // Truncated records and unknown codecs are rejected
+        BOOST_CHECK_THROW(DecompressRecord(record.data(), record.size() - 1, decompressed), std::ios_base::failure);
+        // Sizes larger than a block file are rejected before anything is allocated for them
+        std::vector<unsigned char> oversized(record);
+        WriteLE32(oversized.data() + 9, 0xffffffff);
+        BOOST_CHECK_THROW(DecompressRecord(oversized.data(), oversized.size(), decompressed), std::ios_base::failure);
+        CDataStream ssOversized(oversized, SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK_THROW(ReadCompressedRecord(ssOversized, decompressed), std::ios_base::failure);
+        record[8] = 0xff;
+        BOOST_CHECK_THROW(DecompressRecord(record.data(), record.size(), decompressed), std::ios_base::failure);
+    }
+
+    // Data that does not compress is stored as it is
+    std::vector<unsigned char> random(5000);
+    GetRandBytes(random.data(), random.size());
+    for (BlockCompression codec : ALL_CODECS)
+    {
+        BOOST_CHECK(!CompressRecord(codec, 0, random.data(), random.size(), record));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(undo_sequential_files)
+{
+    const CMessageHeader::MessageStartChars &messageStart = Params().MessageStart();
+    const CBlockUndo blockundo = MakeBlockUndo();
+    const uint256 hashBlock = GetRandHash();
+    const uint64_t nUndoSize = ::GetSerializeSize(blockundo, SER_DISK, CLIENT_VERSION);
+
+    // Plain records written before compression was enabled stay readable with any setting, and compressed ones
+    // can be read back after compression is turned off again.
+    std::vector<CDiskBlockPos> vPos;
+    for (BlockCompression codec : ALL_CODECS)
+    {
+        if (!IsBlockCompressionSupported(codec))
+            continue;
+        SetBlockCompression(codec, 0);
+
+        CValidationState state;
+        CDiskBlockPos pos;
+        BOOST_REQUIRE(FindUndoPos(state, 0, pos, nUndoSize + 40));
+        BOOST_CHECK(WriteUndoToDiskSequenatial(blockundo, pos, hashBlock, messageStart));
+        vPos.push_back(pos);
+
+        // The space reserved for the uncompressed data is only used in full when there is no compression
+        LOCK(cs_LastBlockFile);
+        if (codec == BlockCompression::NONE)
+            BOOST_CHECK_EQUAL(vinfoBlockFile[0].nUndoSize, pos.nPos + nUndoSize + 32);
+        else
+            BOOST_CHECK(vinfoBlockFile[0].nUndoSize < pos.nPos + nUndoSize + 32);
+    }
+
+    for (BlockCompression codec : ALL_CODECS)
+    {
+        if (!IsBlockCompressionSupported(codec))
+            continue;
+        SetBlockCompression(codec, 0);
+        for (const CDiskBlockPos &pos : vPos)
+        {
+            CBlockUndo read;
+            BOOST_CHECK(ReadUndoFromDiskSequential(read, pos, hashBlock));
+            BOOST_CHECK(SerializeHash(read) == SerializeHash(blockundo));
+
+            // the checksum still commits to the block hash
+            BOOST_CHECK(!ReadUndoFromDiskSequential(read, pos, GetRandHash()));
+        }
+    }
+    SetBlockCompression(BlockCompression::NONE, DEFAULT_BLOCK_COMPRESSION_LEVEL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,54 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockstorage/blockfilewriter.h"
+#include "blockstorage/blockstorage.h"
+#include "blockstorage/sequential_files.h"
+#include "chainparams.h"
+#include "main.h"
+#include "test/test_nexa.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockfilewriter_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(queued_block_writes)
+{
+    const CBlock &genesis = Params().GenesisBlock();
+    const CMessageHeader::MessageStartChars &messageStart = Params().MessageStart();
+    const uint64_t nBlockSize = ::GetSerializeSize(genesis, SER_DISK, CLIENT_VERSION);
+
+    // A queue that holds a single block, so that most writes wait for the previous one
+    blockFileWriter.Start(nBlockSize);
+    BOOST_CHECK(blockFileWriter.IsRunning());
+
+    std::vector<CDiskBlockPos> vPos;
+    for (int i = 0; i < 20; i++)
+    {
+        CValidationState state;
+        CDiskBlockPos pos;
+        BOOST_REQUIRE(FindBlockPos(state, pos, nBlockSize + 8, i, genesis.GetBlockTime()));
+        BOOST_CHECK(WriteBlockToDiskSequential(genesis, pos, messageStart));
+        vPos.push_back(pos);
+
+        // readable right away, whether it is still queued or not
+        CBlockRef pblock = ReadBlockFromDiskSequential(pos, Params().GetConsensus());
+        BOOST_REQUIRE(pblock != nullptr);
+        BOOST_CHECK(pblock->GetHash() == genesis.GetHash());
+    }
+
+    BOOST_CHECK(FlushBlockFile());
+    BOOST_CHECK_EQUAL(blockFileWriter.QueueDepth(), 0);
+
+    blockFileWriter.Stop();
+    BOOST_CHECK(!blockFileWriter.IsRunning());
+    for (const CDiskBlockPos &pos : vPos)
+    {
+        CBlockRef pblock = ReadBlockFromDiskSequential(pos, Params().GetConsensus());
+        BOOST_REQUIRE(pblock != nullptr);
+        BOOST_CHECK(pblock->GetHash() == genesis.GetHash());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilter.h"
+#include "index/blockfilterindex.h"
+#include "streams.h"
+#include "test/test_nexa.h"
+#include "test/testutil.h"
+#include "undo.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockfilter_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(gcsfilter_test)
+{
+    GCSFilter::ElementSet included_elements, excluded_elements;
+    for (int i = 0; i < 100; ++i)
+    {
+        GCSFilter::Element element1(32);
+        element1[0] = i;
+        included_elements.insert(std::move(element1));
+
+        GCSFilter::Element element2(32);
+        element2[1] = i;
+        excluded_elements.insert(std::move(element2));
+    }
+
+    GCSFilter filter({0, 0, 10, 1 << 10}, included_elements);
+    for (const auto &element : included_elements)
+    {
+        BOOST_CHECK(filter.Match(element));
+
+        auto insertion = excluded_elements.insert(element);
+        BOOST_CHECK(filter.MatchAny(excluded_elements));
+        excluded_elements.erase(insertion.first);
+    }
+
+    // Reconstructing the filter from its encoding gives the same matches
+    GCSFilter decoded(filter.GetParams(), filter.GetEncoded());
+    BOOST_CHECK_EQUAL(decoded.GetN(), 100U);
+    for (const auto &element : included_elements)
+    {
+        BOOST_CHECK(decoded.Match(element));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
+{
+    GCSFilter filter;
+    BOOST_CHECK_EQUAL(filter.GetN(), 0U);
+    BOOST_CHECK_EQUAL(filter.GetEncoded().size(), 1U);
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(32)));
+
+    // A truncated encoding is rejected
+    GCSFilter full({0, 0, 10, 1 << 10}, {GCSFilter::Element(1, 1), GCSFilter::Element(1, 2)});
+    std::vector<unsigned char> truncated(full.GetEncoded().begin(), full.GetEncoded().begin() + 1);
+    BOOST_CHECK_THROW(GCSFilter(full.GetParams(), truncated), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_basic_test)
+{
+    const CScript included_scripts[5] = {
+        CScript() << std::vector<unsigned char>(32, 1) << OP_EQUAL,
+        CScript() << std::vector<unsigned char>(32, 2) << OP_EQUAL,
+        CScript() << std::vector<unsigned char>(32, 3) << OP_EQUAL,
+        CScript() << std::vector<unsigned char>(32, 4) << OP_EQUAL,
+        CScript() << std::vector<unsigned char>(32, 5) << OP_EQUAL,
+    };
+    const CScript excluded_scripts[3] = {
+        CScript() << OP_RETURN << OP_4 << OP_ADD << OP_8 << OP_EQUAL,
+        CScript(),
+        CScript() << std::vector<unsigned char>(32, 6) << OP_EQUAL,
+    };
+
+    CBlock block;
+    block.vtx.push_back(MakeTx({}, {CTxOut(100, included_scripts[0]), CTxOut(0, excluded_scripts[0])}));
+    block.vtx.push_back(MakeTx({COutPoint(GetRandHash(), 0), COutPoint(GetRandHash(), 1)},
+        {CTxOut(200, included_scripts[1]), CTxOut(300, excluded_scripts[1])}));
+
+    CBlockUndo block_undo;
+    block_undo.vtxundo.emplace_back();
+    block_undo.vtxundo.back().vprevout.emplace_back(CTxOut(500, included_scripts[2]), 1000, true);
+    block_undo.vtxundo.back().vprevout.emplace_back(CTxOut(600, included_scripts[3]), 10000, false);
+
+    BlockFilter block_filter(BlockFilterType::BASIC, block, block_undo);
+    const GCSFilter &filter = block_filter.GetFilter();
+
+    for (int i = 0; i < 4; i++)
+    {
+        BOOST_CHECK(filter.Match(GCSFilter::Element(included_scripts[i].begin(), included_scripts[i].end())));
+    }
+    BOOST_CHECK_EQUAL(filter.GetN(), 4U);
+    for (const CScript &script : excluded_scripts)
+    {
+        if (!script.empty())
+            BOOST_CHECK(!filter.Match(GCSFilter::Element(script.begin(), script.end())));
+    }
+
+    // Test serialization/unserialization.
+    BlockFilter block_filter2;
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block_filter;
+    stream >> block_filter2;
+
+    BOOST_CHECK(block_filter.GetFilterType() == block_filter2.GetFilterType());
+    BOOST_CHECK(block_filter.GetBlockHash() == block_filter2.GetBlockHash());
+    BOOST_CHECK(block_filter.GetEncodedFilter() == block_filter2.GetEncodedFilter());
+    BOOST_CHECK(block_filter.GetHash() == block_filter2.GetHash());
+
+    // The header commits to the previous header
+    const uint256 header = block_filter.ComputeHeader(uint256());
+    BOOST_CHECK(header != block_filter.ComputeHeader(header));
+
+    BlockFilter reconstructed(BlockFilterType::BASIC, block_filter.GetBlockHash(), block_filter.GetEncodedFilter());
+    BOOST_CHECK(reconstructed.GetHash() == block_filter.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_type_names)
+{
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(BlockFilterType::BASIC), "basic");
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(static_cast<BlockFilterType>(1)), "");
+
+    BlockFilterType filter_type;
+    BOOST_CHECK(BlockFilterTypeByName("basic", filter_type));
+    BOOST_CHECK(filter_type == BlockFilterType::BASIC);
+    BOOST_CHECK(!BlockFilterTypeByName("unknown", filter_type));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilterindex_header_chain)
+{
+    BlockFilterIndex index(new BlockFilterIndexDB(1 << 20, true, true));
+
+    TestBlockIndexChain indexes(3);
+    CBlock blocks[3];
+    for (int i = 0; i < 3; i++)
+    {
+        blocks[i].vtx.push_back(MakeTx({}, {CTxOut(50 * COIN, CScript() << i << OP_EQUAL)}));
+    }
+
+    // A block can only be indexed on top of its parent
+    BOOST_CHECK(!index.WriteBlock(blocks[1], CBlockUndo(), indexes[1]));
+    for (int i = 0; i < 3; i++)
+    {
+        BOOST_CHECK(index.WriteBlock(blocks[i], CBlockUndo(), indexes[i]));
+    }
+
+    uint256 header;
+    uint256 expected;
+    for (int i = 0; i < 3; i++)
+    {
+        BlockFilter filter;
+        BOOST_CHECK(index.LookupFilter(indexes[i], filter));
+        expected = filter.ComputeHeader(expected);
+        BOOST_CHECK(index.LookupFilterHeader(indexes[i], header));
+        BOOST_CHECK(header == expected);
+    }
+
+    std::vector<BlockFilter> filters;
+    BOOST_CHECK(index.LookupFilterRange(1, indexes[2], filters));
+    BOOST_CHECK_EQUAL(filters.size(), 2U);
+
+    std::vector<uint256> filter_hashes;
+    BOOST_CHECK(index.LookupFilterHashRange(0, indexes[2], filter_hashes));
+    BOOST_CHECK_EQUAL(filter_hashes.size(), 3U);
+    BOOST_CHECK(filter_hashes[1] == filters[0].GetHash());
+    BOOST_CHECK(filter_hashes[2] == filters[1].GetHash());
+
+    BOOST_CHECK(!index.LookupFilterRange(3, indexes[2], filters));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockstorage/blockindexsnapshot.h"
+#include "chain.h"
+#include "random.h"
+#include "test/test_nexa.h"
+#include "util.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockindexsnapshot_tests, TestingSetup)
+
+/** Build a small block tree: a chain of 10 blocks with a 2 block fork off height 5 */
+static void BuildBlockMap(BlockMap &mapIndex)
+{
+    std::vector<CBlockIndex *> vChain;
+    for (int i = 0; i < 12; i++)
+    {
+        CBlockIndex *pindex = new CBlockIndex();
+        CBlockIndex *pprev = nullptr;
+        if (i == 10)
+            pprev = vChain[5];
+        else if (i > 0)
+            pprev = vChain[i - 1];
+
+        pindex->pprev = pprev;
+        pindex->header.height = pprev ? pprev->height() + 1 : 0;
+        pindex->header.hashPrevBlock = pprev ? pprev->GetBlockHash() : uint256();
+        pindex->header.nTime = 1000 + i;
+        pindex->header.nonce = {(unsigned char)i};
+        pindex->nStatus = BLOCK_HAVE_DATA | BLOCK_VALID_TRANSACTIONS;
+        pindex->nFile = i / 4;
+        pindex->nDataPos = 100 * i;
+        pindex->nSequenceId = i;
+        pindex->nTimeReceived = 2000 + i;
+        auto it = mapIndex.emplace(GetRandHash(), pindex).first;
+        pindex->phashBlock = &it->first;
+        vChain.push_back(pindex);
+    }
+}
+
+static void ClearBlockMap(BlockMap &mapIndex)
+{
+    for (auto &entry : mapIndex)
+        delete entry.second;
+    mapIndex.clear();
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_roundtrip)
+{
+    const fs::path path = GetDataDir() / "blockindex_test.dat";
+    const uint256 id = GetRandHash();
+
+    BlockMap mapIndex;
+    BuildBlockMap(mapIndex);
+    BOOST_CHECK(WriteBlockIndexSnapshot(path, mapIndex, id));
+
+    BlockMap mapLoaded;
+    BOOST_CHECK(ReadBlockIndexSnapshot(path, id, mapLoaded));
+    BOOST_CHECK_EQUAL(mapLoaded.size(), mapIndex.size());
+    for (const auto &entry : mapIndex)
+    {
+        auto it = mapLoaded.find(entry.first);
+        BOOST_REQUIRE(it != mapLoaded.end());
+        const CBlockIndex *a = entry.second;
+        const CBlockIndex *b = it->second;
+        BOOST_CHECK(b->phashBlock == &it->first);
+        BOOST_CHECK(b->GetBlockHash() == a->GetBlockHash());
+        BOOST_CHECK_EQUAL(b->height(), a->height());
+        BOOST_CHECK(b->header.nonce == a->header.nonce);
+        BOOST_CHECK_EQUAL(b->nStatus, a->nStatus);
+        BOOST_CHECK_EQUAL(b->nFile, a->nFile);
+        BOOST_CHECK_EQUAL(b->nDataPos, a->nDataPos);
+        BOOST_CHECK_EQUAL(b->nSequenceId, a->nSequenceId);
+        BOOST_CHECK_EQUAL(b->nTimeReceived, a->nTimeReceived);
+        if (a->pprev)
+        {
+            BOOST_REQUIRE(b->pprev != nullptr);
+            BOOST_CHECK(b->pprev->GetBlockHash() == a->pprev->GetBlockHash());
+            // the parent is linked to the entry in the loaded map, not the original
+            BOOST_CHECK(b->pprev == mapLoaded[a->pprev->GetBlockHash()]);
+        }
+        else
+        {
+            BOOST_CHECK(b->pprev == nullptr);
+        }
+    }
+    ClearBlockMap(mapLoaded);
+
+    // A snapshot with another id is stale and must not load
+    BOOST_CHECK(!ReadBlockIndexSnapshot(path, GetRandHash(), mapLoaded));
+    BOOST_CHECK(mapLoaded.empty());
+
+    ClearBlockMap(mapIndex);
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_corrupt)
+{
+    const fs::path path = GetDataDir() / "blockindex_test.dat";
+    const uint256 id = GetRandHash();
+
+    BlockMap mapIndex;
+    BuildBlockMap(mapIndex);
+    BOOST_CHECK(WriteBlockIndexSnapshot(path, mapIndex, id));
+    ClearBlockMap(mapIndex);
+
+    // Flip one byte in the middle of the records
+    const uint64_t nSize = fs::file_size(path);
+    FILE *file = fsbridge::fopen(path, "r+b");
+    BOOST_REQUIRE(file != nullptr);
+    fseek(file, nSize / 2, SEEK_SET);
+    int ch = fgetc(file);
+    fseek(file, nSize / 2, SEEK_SET);
+    fputc(ch ^ 0xff, file);
+    fclose(file);
+
+    BOOST_CHECK(!ReadBlockIndexSnapshot(path, id, mapIndex));
+    BOOST_CHECK(mapIndex.empty());
+
+    // A missing file fails the same way
+    fs::remove(path);
+    BOOST_CHECK(!ReadBlockIndexSnapshot(path, id, mapIndex));
+    BOOST_CHECK(mapIndex.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <tgmath.h>
 
 #include "capd/capd.h"
+#include "hashwrapper.h"
 #include "streams.h"
 #include "test/test_nexa.h"
 // #include "test/test_random.h"
@@ -469,6 +470,310 @@ BOOST_AUTO_TEST_CASE(capd_pool_test_vectors2)
 }
 
 
+// Solve a message with this content and target, created age seconds ago
+static CapdMsgRef SolvedMsg(const std::string &content, const char *target, long int age = 0)
+{
+    CapdMsgRef m = std::make_shared<CapdMsg>(content);
+    m->SetPowTarget(uint256S(target));
+    m->Solve(age);
+    return m;
+}
+
+BOOST_AUTO_TEST_CASE(capd_pool_percentiles)
+{
+    int64_t now = GetTime();
+    SetMockTime(now);
+
+    CapdMsgPool mp;
+    mp.SetMaxSize(1000000);
+    BOOST_CHECK(mp.GetMsgAtPercentile(50) == nullmsgref);
+
+    std::vector<CapdMsgRef> added;
+    for (int i = 0; i < 21; i++)
+    {
+        std::string target(64, 'f');
+        target[0] = '0';
+        target[1] = '0';
+        target[2] = "137"[i % 3];
+        added.push_back(SolvedMsg("percentile " + std::to_string(i), target.c_str(), i));
+        mp.add(added.back());
+    }
+    std::sort(added.begin(), added.end(),
+        [](const CapdMsgRef &a, const CapdMsgRef &b) { return a->Priority() < b->Priority(); });
+    BOOST_CHECK(mp.GetMsgAtPercentile(0)->Priority() == added.front()->Priority());
+    BOOST_CHECK(mp.GetMsgAtPercentile(50)->Priority() == added[10]->Priority());
+    BOOST_CHECK(mp.GetMsgAtPercentile(100)->Priority() == added.back()->Priority());
+    BOOST_CHECK(mp.GetMsgAtPercentile(1000)->Priority() == added.back()->Priority());
+    for (unsigned int p = 10; p <= 100; p += 10)
+        BOOST_CHECK(mp.GetMsgAtPercentile(p - 10)->Priority() <= mp.GetMsgAtPercentile(p)->Priority());
+
+    // Priorities decay at rates that depend on the message, so the order changes as time passes: a message with 4
+    // times the work that is 300 seconds older starts ahead but has expired 300 seconds later
+    mp.clear();
+    CapdMsgRef older = SolvedMsg("older", "003fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", 300);
+    CapdMsgRef newer = SolvedMsg("newer", "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    mp.add(older);
+    mp.add(newer);
+    BOOST_CHECK(mp.GetMsgAtPercentile(100) == older);
+    BOOST_CHECK(mp.GetMsgAtPercentile(0) == newer);
+
+    SetMockTime(now + 300);
+    CapdMsgRef latest = SolvedMsg("latest", "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    mp.add(latest);
+    BOOST_CHECK(mp.GetMsgAtPercentile(0) == older);
+    BOOST_CHECK(mp.GetMsgAtPercentile(50) == newer);
+    BOOST_CHECK(mp.GetMsgAtPercentile(100) == latest);
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(capd_pool_batched_eviction)
+{
+    int64_t now = GetTime();
+    SetMockTime(now);
+
+    const uint64_t TEST_MSGPOOL_SIZE = 100000;
+    CapdMsgPool mp;
+    mp.SetMaxSize(TEST_MSGPOOL_SIZE);
+
+    // Messages of equal priority until one has to be evicted
+    uint64_t count = 0;
+    for (int i = 0; mp.Count() == count; i++)
+    {
+        BOOST_REQUIRE(i < 10000);
+        mp.add(SolvedMsg("evict " + std::to_string(i),
+            "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+        count++;
+    }
+    // A whole batch was freed, not just room for the new message
+    BOOST_CHECK(mp.Size() <= TEST_MSGPOOL_SIZE - TEST_MSGPOOL_SIZE / CAPD_PARE_BATCH_DIVISOR);
+    BOOST_CHECK(mp.Count() < count - 1);
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(capd_check_pow)
+{
+    std::vector<CapdMsgRef> msgs;
+    for (size_t i = 0; i < 3 * CAPD_POW_CHECK_PARALLEL_MIN; i++)
+    {
+        CapdMsgRef m = SolvedMsg("pow " + std::to_string(i),
+            "0fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+        if (i % 5 == 0)
+        {
+            // Make most of these fail by changing the message after it was solved
+            CapdMsgRef bad = MsgRefCopy(*m);
+            bad->cachedHash = uint256();
+            bad->data.push_back('!');
+            m = bad;
+        }
+        msgs.push_back(m);
+    }
+
+    for (size_t n : {size_t(1), CAPD_POW_CHECK_PARALLEL_MIN - 1, msgs.size()})
+    {
+        std::vector<CapdMsgRef> burst;
+        for (size_t i = 0; i < n; i++)
+        {
+            burst.push_back(MsgRefCopy(*msgs[i]));
+            burst.back()->cachedHash = uint256();
+        }
+        std::vector<unsigned char> results = capdProtocol.CheckPow(burst);
+        BOOST_REQUIRE_EQUAL(results.size(), n);
+        for (size_t i = 0; i < n; i++)
+        {
+            BOOST_CHECK(burst[i]->cachedHash != uint256());
+            BOOST_CHECK_EQUAL(results[i] != 0, msgs[i]->DoesPowMeetTarget());
+        }
+    }
+}
+
+// Find the solution one nonce at a time, the way messages used to be solved
+static std::vector<unsigned char> SolveInOrder(const uint256 &stage1, const arith_uint256 &target)
+{
+    for (unsigned int size = 1; size <= CAPD_MAX_NONCE_SIZE; size++)
+    {
+        std::vector<unsigned char> nonce(size);
+        for (uint64_t count = 0; count < (uint64_t(1) << (8 * size)); count++)
+        {
+            for (unsigned int x = 0; x < size; x++)
+                nonce[x] = (count >> (x * 8)) & 255;
+            uint256 hash;
+            CHash256().Write(stage1.begin(), stage1.size()).Write(nonce.data(), nonce.size()).Finalize(hash.begin());
+            if (target > UintToArith256(hash))
+                return nonce;
+        }
+    }
+    return std::vector<unsigned char>();
+}
+
+BOOST_AUTO_TEST_CASE(capd_parallel_solve)
+{
+    // Targets usually solved by 1, 2 and 3 byte nonces
+    for (const char *target : {"0fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+             "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+             "00003fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"})
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            uint256 stage1 = InsecureRand256();
+            std::vector<unsigned char> expected = SolveInOrder(stage1, UintToArith256(uint256S(target)));
+            for (unsigned int nThreads : {1, 2, 4})
+            {
+                std::vector<unsigned char> nonce;
+                BOOST_CHECK(SolveCapdNonce(stage1, UintToArith256(uint256S(target)), nonce, nThreads));
+                BOOST_CHECK(nonce == expected);
+            }
+        }
+    }
+
+    CapdMsg msg("parallel solve");
+    msg.SetPowTarget(uint256S("00003fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+    BOOST_CHECK(msg.Solve(0, 4));
+    BOOST_CHECK(msg.DoesPowMeetTarget());
+    std::vector<unsigned char> nonce = msg.nonce;
+    uint64_t createTime = msg.createTime;
+    BOOST_CHECK(msg.Solve(createTime, 1));
+    BOOST_CHECK(msg.nonce == nonce);
+
+    // A target that would take far longer than the time budget, or a cancelled search, gives up
+    uint256 stage1 = InsecureRand256();
+    arith_uint256 hard = UintToArith256(uint256S("00000000000000ffffffffffffffffffffffffffffffffffffffffffffffffff"));
+    auto start = std::chrono::steady_clock::now();
+    BOOST_CHECK(!SolveCapdNonce(stage1, hard, nonce, 2, 100));
+    BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    std::atomic<bool> cancel{true};
+    BOOST_CHECK(!SolveCapdNonce(stage1, hard, nonce, 2, 0, &cancel));
+}
+
+static std::vector<unsigned char> Bytes(const std::string &s) { return std::vector<unsigned char>(s.begin(), s.end()); }
+
+BOOST_AUTO_TEST_CASE(capd_subscriptions)
+{
+    CapdSubscriptions subs;
+    std::vector<CapdMsgRef> msgs;
+    uint64_t dropped = 0;
+    BOOST_CHECK_THROW(subs.Subscribe(std::vector<unsigned char>(CapdSubscriptions::MAX_PREFIX_SIZE + 1, 'a')),
+        CapdMsgPoolException);
+    BOOST_CHECK(!subs.Poll(12345, 10, 0, msgs, dropped));
+
+    uint64_t all = subs.Subscribe(std::vector<unsigned char>());
+    uint64_t ab = subs.Subscribe(Bytes("ab"), 2);
+    uint64_t abc = subs.Subscribe(Bytes("abc"));
+    BOOST_CHECK_EQUAL(subs.Count(), 3U);
+
+    std::vector<CapdMsgRef> sent;
+    for (const char *content : {"a", "abc1", "abd", "xyz", "abc2", "ab"})
+    {
+        sent.push_back(std::make_shared<CapdMsg>(content));
+        subs.Notify(sent.back());
+    }
+
+    // Nothing is waited for when messages are queued, and they come back oldest first
+    BOOST_CHECK(subs.Poll(all, 100, 60000, msgs, dropped));
+    BOOST_CHECK(msgs == sent);
+    BOOST_CHECK_EQUAL(dropped, 0U);
+    BOOST_CHECK(subs.Poll(abc, 1, 0, msgs, dropped));
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1U);
+    BOOST_CHECK(msgs[0] == sent[1]);
+    BOOST_CHECK(subs.Poll(abc, 10, 0, msgs, dropped));
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1U);
+    BOOST_CHECK(msgs[0] == sent[4]);
+    // The "ab" queue holds 2, so the oldest 2 of its 4 messages were dropped
+    BOOST_CHECK(subs.Poll(ab, 10, 0, msgs, dropped));
+    BOOST_REQUIRE_EQUAL(msgs.size(), 2U);
+    BOOST_CHECK(msgs[0] == sent[4]);
+    BOOST_CHECK(msgs[1] == sent[5]);
+    BOOST_CHECK_EQUAL(dropped, 2U);
+    BOOST_CHECK(subs.Poll(ab, 10, 0, msgs, dropped));
+    BOOST_CHECK(msgs.empty());
+    BOOST_CHECK_EQUAL(dropped, 0U);
+
+    // An empty poll waits out its timeout
+    auto start = std::chrono::steady_clock::now();
+    BOOST_CHECK(subs.Poll(abc, 10, 50, msgs, dropped));
+    BOOST_CHECK(msgs.empty());
+    BOOST_CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+    // A waiting poll returns as soon as a message arrives
+    CapdMsgRef late = std::make_shared<CapdMsg>("abc late");
+    std::thread notifier(
+        [&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            subs.Notify(late);
+        });
+    BOOST_CHECK(subs.Poll(abc, 10, 60000, msgs, dropped));
+    notifier.join();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1U);
+    BOOST_CHECK(msgs[0] == late);
+
+    BOOST_CHECK(subs.Unsubscribe(abc));
+    BOOST_CHECK(!subs.Unsubscribe(abc));
+    BOOST_CHECK(!subs.Poll(abc, 10, 0, msgs, dropped));
+    BOOST_CHECK_EQUAL(subs.Count(), 2U);
+
+    // Once interrupted, polls stop waiting
+    subs.Interrupt();
+    BOOST_CHECK(subs.Poll(all, 10, 0, msgs, dropped));
+    BOOST_CHECK(subs.Poll(all, 10, 60000, msgs, dropped));
+    BOOST_CHECK(msgs.empty());
+}
+
+BOOST_AUTO_TEST_CASE(capd_pool_notifies_subscribers)
+{
+    CapdMsgPool mp;
+    mp.SetMaxSize(1000000);
+    uint64_t id = mp.subscriptions.Subscribe(Bytes("notify"));
+    CapdMsgRef m = SolvedMsg("notify me", "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    mp.add(m);
+    mp.add(SolvedMsg("not me", "00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+    // A message already in the pool is not delivered again
+    mp.add(MsgRefCopy(*m));
+
+    std::vector<CapdMsgRef> msgs;
+    uint64_t dropped = 0;
+    BOOST_CHECK(mp.subscriptions.Poll(id, 10, 0, msgs, dropped));
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1U);
+    BOOST_CHECK(msgs[0]->GetHash() == m->GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(capd_subscriptions_load)
+{
+    // Many subscribers spread over a few prefixes, each with a small queue
+    const size_t SUBSCRIBERS = 10000;
+    const size_t PREFIXES = 100;
+    const size_t QUEUE = 5;
+    const size_t MSGS = 1000;
+    CapdSubscriptions subs;
+    std::vector<uint64_t> ids;
+    for (size_t i = 0; i < SUBSCRIBERS; i++)
+        ids.push_back(subs.Subscribe(Bytes("p" + std::to_string(i % PREFIXES) + ":"), QUEUE));
+    uint64_t all = subs.Subscribe(std::vector<unsigned char>(), CapdSubscriptions::MAX_QUEUE);
+
+    std::vector<size_t> sentPerPrefix(PREFIXES, 0);
+    for (size_t i = 0; i < MSGS; i++)
+    {
+        size_t prefix = (i * 7) % PREFIXES;
+        subs.Notify(std::make_shared<CapdMsg>("p" + std::to_string(prefix) + ":" + std::to_string(i)));
+        sentPerPrefix[prefix]++;
+    }
+
+    std::vector<CapdMsgRef> msgs;
+    uint64_t dropped = 0;
+    for (size_t i = 0; i < SUBSCRIBERS; i++)
+    {
+        std::string prefix = "p" + std::to_string(i % PREFIXES) + ":";
+        BOOST_CHECK(subs.Poll(ids[i], CapdSubscriptions::MAX_QUEUE, 0, msgs, dropped));
+        size_t sent = sentPerPrefix[i % PREFIXES];
+        BOOST_CHECK_EQUAL(msgs.size(), std::min(sent, QUEUE));
+        BOOST_CHECK_EQUAL(dropped, sent - msgs.size());
+        for (const auto &msg : msgs)
+            BOOST_CHECK(std::equal(prefix.begin(), prefix.end(), msg->data.begin()));
+    }
+    BOOST_CHECK(subs.Poll(all, CapdSubscriptions::MAX_QUEUE, 0, msgs, dropped));
+    BOOST_CHECK_EQUAL(msgs.size(), MSGS);
+    BOOST_CHECK_EQUAL(dropped, 0U);
+}
+
 BOOST_AUTO_TEST_CASE(capd_http) { BOOST_CHECK(1 == 1); }
 class CMsgMaker
 {
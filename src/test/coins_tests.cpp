@@ -810,5 +810,51 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_getcoins)
+{
+    // Coins in the backing view, in the cache only, spent in the cache and never created
+    CCoinsViewTest base;
+    std::vector<COutPoint> outpoints;
+    {
+        CCoinsViewCacheTest parent(&base);
+        for (int i = 0; i < 20; i++)
+        {
+            COutPoint outpoint(InsecureRand256());
+            parent.AddCoin(outpoint, Coin(CTxOut(i + 1, CScript() << OP_TRUE), i, false), false);
+            outpoints.push_back(outpoint);
+        }
+        parent.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(parent.Flush());
+    }
+    CCoinsViewCacheTest cache(&base);
+    COutPoint cached(InsecureRand256());
+    cache.AddCoin(cached, Coin(CTxOut(100, CScript() << OP_TRUE), 30, false), false);
+    outpoints.push_back(cached);
+    cache.SpendCoin(outpoints[3]);
+    outpoints.push_back(COutPoint(InsecureRand256()));
+    const unsigned int nCacheSize = cache.GetCacheSize();
+
+    std::vector<Coin> coins;
+    std::vector<bool> found;
+    cache.GetCoins(outpoints, coins, found);
+
+    // Nothing was added to the cache by the lookup
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), nCacheSize);
+    cache.SelfTest();
+
+    BOOST_CHECK_EQUAL(found.size(), outpoints.size());
+    BOOST_CHECK(!found[3]);
+    BOOST_CHECK(found[20]);
+    BOOST_CHECK(!found.back());
+    for (size_t i = 0; i < outpoints.size(); i++)
+    {
+        Coin coin;
+        const bool fHave = cache.GetCoin(outpoints[i], coin) && !coin.IsSpent();
+        BOOST_CHECK_EQUAL(found[i], fHave);
+        if (fHave)
+            BOOST_CHECK(coins[i] == coin);
+    }
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "consensus/consensus.h"
+#include "script/compiledscript.h"
+#include "script/interpreter.h"
+#include "script/script.h"
+#include "test/test_nexa.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(compiledscript_tests, BasicTestingSetup)
+
+// Run script both ways and check that the compiled form behaves exactly like the decoded one
+static void CheckCompiledMatches(const CScript &script, unsigned int maxOps)
+{
+    ScriptMachine sm(MANDATORY_SCRIPT_VERIFY_FLAGS, ScriptImportedState(), maxOps, 0xffffffff);
+    ScriptMachine smc(MANDATORY_SCRIPT_VERIFY_FLAGS, ScriptImportedState(), maxOps, 0xffffffff);
+    bool ret = sm.Eval(script);
+    bool retc = smc.Eval(std::make_shared<const CompiledScript>(script));
+    BOOST_CHECK_EQUAL(ret, retc);
+    BOOST_CHECK_EQUAL(sm.getError(), smc.getError());
+    BOOST_CHECK_EQUAL(sm.getOpCount(), smc.getOpCount());
+    const Stack &stk = sm.getStack();
+    const Stack &stkc = smc.getStack();
+    BOOST_REQUIRE_EQUAL(stk.size(), stkc.size());
+    for (size_t i = 0; i < stk.size(); i++)
+        BOOST_CHECK(stk[i].data() == stkc[i].data());
+}
+
+BOOST_AUTO_TEST_CASE(compile_instructions)
+{
+    const std::vector<unsigned char> data(300, 7);
+    CScript script = CScript() << OP_1 << OP_IF << data << OP_ELSE << OP_2 << OP_ADD << OP_ENDIF << OP_DROP;
+    CompiledScript cs(script);
+    BOOST_CHECK(!cs.fBadOpcode);
+    BOOST_REQUIRE_EQUAL(cs.code.size(), 8U);
+    BOOST_CHECK_EQUAL(cs.code[2].opcode, OP_PUSHDATA2);
+    BOOST_CHECK_EQUAL(cs.code[2].dataSize, data.size());
+    BOOST_CHECK(std::equal(data.begin(), data.end(), script.begin() + cs.code[2].dataPos));
+    BOOST_CHECK_EQUAL(cs.code[3].pos, cs.code[2].next);
+    BOOST_CHECK_EQUAL(cs.code[7].next, script.size());
+
+    // Each branch leads to the instruction that ends it
+    BOOST_CHECK_EQUAL(cs.code[1].jump, 3U);
+    BOOST_CHECK_EQUAL(cs.code[1].skipOps, 0U);
+    BOOST_CHECK_EQUAL(cs.code[3].jump, 6U);
+    BOOST_CHECK_EQUAL(cs.code[3].skipOps, 1U);
+    BOOST_CHECK_EQUAL(cs.code[0].jump, CompiledScript::NO_JUMP);
+
+    // A branch holding something that fails even when not executed can not be jumped over
+    CompiledScript disabled(CScript() << OP_0 << OP_IF << OP_2MUL << OP_ENDIF);
+    BOOST_CHECK_EQUAL(disabled.code[1].jump, CompiledScript::NO_JUMP);
+    CompiledScript oversized(CScript() << OP_0 << OP_IF << std::vector<unsigned char>(MAX_SCRIPT_ELEMENT_SIZE + 1)
+                                       << OP_ENDIF);
+    BOOST_CHECK_EQUAL(oversized.code[1].jump, CompiledScript::NO_JUMP);
+
+    // A truncated push ends the instructions
+    CScript truncated = CScript() << OP_1;
+    truncated.push_back(OP_PUSHDATA1);
+    truncated.push_back(10);
+    truncated.push_back(1);
+    CompiledScript bad(truncated);
+    BOOST_CHECK(bad.fBadOpcode);
+    BOOST_CHECK_EQUAL(bad.code.size(), 1U);
+    CheckCompiledMatches(truncated, MAX_OPS_PER_SCRIPT);
+}
+
+BOOST_AUTO_TEST_CASE(skip_untaken_branches)
+{
+    CScript script = CScript() << OP_0 << OP_IF;
+    for (int i = 0; i < 50; i++)
+        script << OP_1 << OP_DUP << OP_DROP << OP_DROP;
+    script << OP_ELSE << OP_1 << OP_ENDIF;
+    // The skipped operations still count toward the limit, whichever way the script is run
+    CheckCompiledMatches(script, MAX_OPS_PER_SCRIPT);
+    CheckCompiledMatches(script, 100);
+    CheckCompiledMatches(script, 102);
+    CheckCompiledMatches(script, 103);
+
+    CheckCompiledMatches(CScript() << OP_0 << OP_IF << OP_2MUL << OP_ENDIF << OP_1, MAX_OPS_PER_SCRIPT);
+    CheckCompiledMatches(CScript() << OP_0 << OP_IF << OP_VERIF << OP_ENDIF << OP_1, MAX_OPS_PER_SCRIPT);
+    CheckCompiledMatches(CScript() << OP_1 << OP_IF << OP_ELSE << OP_ELSE << OP_2 << OP_ELSE << OP_3 << OP_ENDIF,
+        MAX_OPS_PER_SCRIPT);
+}
+
+BOOST_AUTO_TEST_CASE(random_scripts_match_interpreter)
+{
+    static const opcodetype ops[] = {OP_0, OP_1, OP_2, OP_IF, OP_NOTIF, OP_ELSE, OP_ENDIF, OP_IF, OP_ELSE, OP_ENDIF,
+        OP_DUP, OP_DROP, OP_ADD, OP_VERIFY, OP_NOP, OP_DEPTH, OP_TOALTSTACK, OP_FROMALTSTACK, OP_2MUL, OP_VERIF,
+        OP_RETURN, OP_CODESEPARATOR};
+    static const size_t pushSizes[] = {1, 2, 20, 75, 76, 255, 256, MAX_SCRIPT_ELEMENT_SIZE + 1};
+    for (int i = 0; i < 2000; i++)
+    {
+        CScript script;
+        const int len = InsecureRandRange(60);
+        for (int j = 0; j < len; j++)
+        {
+            if (InsecureRandRange(8) == 0)
+            {
+                const size_t sz = pushSizes[InsecureRandRange(sizeof(pushSizes) / sizeof(pushSizes[0]))];
+                script << std::vector<unsigned char>(sz, InsecureRandBits(8));
+            }
+            else
+                script << ops[InsecureRandRange(sizeof(ops) / sizeof(ops[0]))];
+        }
+        if (InsecureRandRange(10) == 0)
+        {
+            script.push_back(OP_PUSHDATA1);
+            script.push_back(20);
+        }
+        CheckCompiledMatches(script, 1 + InsecureRandRange(40));
+        CheckCompiledMatches(script, MAX_OPS_PER_SCRIPT);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compiled_script_cache)
+{
+    ClearCompiledScriptCache();
+    CScript a = CScript() << OP_1 << OP_IF << OP_2 << OP_ENDIF;
+    CScript b = CScript() << OP_1 << OP_IF << OP_3 << OP_ENDIF;
+    CompiledScriptRef ca = GetCompiledScript(a);
+    BOOST_CHECK(ca->script == a);
+    BOOST_CHECK(GetCompiledScript(a) == ca);
+    CompiledScriptRef cb = GetCompiledScript(b);
+    BOOST_CHECK(cb != ca);
+    BOOST_CHECK(cb->script == b);
+    ClearCompiledScriptCache();
+    BOOST_CHECK(GetCompiledScript(a) != ca);
+}
+
+BOOST_AUTO_TEST_CASE(compiled_script_cache_lru)
+{
+    ClearCompiledScriptCache();
+    CScript a = CScript() << OP_1 << OP_IF << OP_2 << OP_ENDIF;
+    CompiledScriptRef ca = GetCompiledScript(a);
+
+    // Large scripts overflow the cache many times over, but the one that keeps being used is not evicted
+    std::vector<CompiledScriptRef> vBig;
+    for (int i = 0; i < 100; i++)
+    {
+        CScript big = CScript() << i;
+        big.insert(big.end(), 10000, OP_NOP);
+        vBig.push_back(GetCompiledScript(big));
+        BOOST_CHECK(CompiledScriptCacheUsage() <= MAX_COMPILED_SCRIPT_CACHE_BYTES);
+        BOOST_CHECK(GetCompiledScript(a) == ca);
+    }
+    BOOST_CHECK(GetCompiledScript(vBig.front()->script) != vBig.front());
+    BOOST_CHECK(GetCompiledScript(vBig.back()->script) == vBig.back());
+}
+
+BOOST_AUTO_TEST_CASE(compiled_script_cache_one_off)
+{
+    ClearCompiledScriptCache();
+    CScript a = CScript() << OP_1 << OP_IF << OP_2 << OP_ENDIF;
+    CompiledScriptRef first = GetCompiledScript(a, false);
+    CompiledScriptRef second = GetCompiledScript(a, false);
+    BOOST_CHECK(second != first);
+    BOOST_CHECK(GetCompiledScript(a, false) == second);
+    BOOST_CHECK(GetCompiledScript(a) == second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -548,4 +548,38 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256d_multi)
+{
+    // Message lengths around the block and padding boundaries, paired up with each other in every combination
+    const size_t lengths[] = {0, 1, 31, 32, 55, 56, 63, 64, 65, 119, 120, 128, 200, 1000};
+    const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+    std::vector<std::vector<unsigned char> > msgs;
+    for (size_t a = 0; a < count; ++a)
+    {
+        for (size_t b = 0; b < count; ++b)
+        {
+            msgs.push_back(InsecureRandBytes(lengths[a]));
+            msgs.push_back(InsecureRandBytes(lengths[b]));
+        }
+    }
+    // and one left over
+    msgs.push_back(InsecureRandBytes(100));
+
+    std::vector<const unsigned char *> inputs;
+    std::vector<size_t> sizes;
+    for (const std::vector<unsigned char> &msg : msgs)
+    {
+        inputs.push_back(msg.data());
+        sizes.push_back(msg.size());
+    }
+    std::vector<unsigned char> out(32 * msgs.size());
+    SHA256DMulti(out.data(), inputs.data(), sizes.data(), msgs.size());
+    for (size_t i = 0; i < msgs.size(); ++i)
+    {
+        unsigned char hash[32];
+        CHash256().Write(msgs[i].data(), msgs[i].size()).Finalize(hash);
+        BOOST_CHECK(memcmp(hash, &out[32 * i], 32) == 0);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "httpserver.h"
+#include "netbase.h"
+#include "rpc/protocol.h"
+#include "test/test_nexa.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+// Far more than the connection, the socket buffers and the chunked reply limit can hold, so that the handler has to
+// wait on the client
+static const size_t CHUNK_SIZE = 64 * 1024;
+static const size_t CHUNK_COUNT = 1024;
+static const uint16_t TEST_HTTP_PORT = 23457;
+
+/** Runs the node's HTTP server on TEST_HTTP_PORT, with a handler on /chunked that streams CHUNK_COUNT chunks of 'x' */
+struct HTTPServerSetup : public BasicTestingSetup
+{
+    bool fStarted = false;
+    //! Set by the handler to the number of chunks the client took
+    std::shared_ptr<std::promise<size_t> > handlerDone = std::make_shared<std::promise<size_t> >();
+
+    HTTPServerSetup()
+    {
+        mapArgs["-rpcport"] = std::to_string(TEST_HTTP_PORT);
+        if (!InitHTTPServer())
+            return;
+        std::shared_ptr<std::promise<size_t> > done = handlerDone;
+        RegisterHTTPHandler("/chunked", true,
+            [done](HTTPRequest *req, const std::string &)
+            {
+                req->StartChunkedReply(HTTP_OK);
+                size_t nSent = 0;
+                while (nSent < CHUNK_COUNT && req->WriteReplyChunk(std::string(CHUNK_SIZE, 'x')))
+                    nSent++;
+                req->EndChunkedReply();
+                done->set_value(nSent);
+            });
+        StartHTTPServer();
+        fStarted = true;
+    }
+
+    ~HTTPServerSetup()
+    {
+        if (fStarted)
+        {
+            UnregisterHTTPHandler("/chunked", true);
+            InterruptHTTPServer();
+            StopHTTPServer();
+        }
+        mapArgs.erase("-rpcport");
+    }
+};
+
+/** Wait up to 30 seconds for the socket to be readable, then read from it.  Returns -1 on a timeout or error. */
+static int RecvWithTimeout(SOCKET hSocket, char *buf, size_t len)
+{
+    fd_set fdRead;
+    FD_ZERO(&fdRead);
+    FD_SET(hSocket, &fdRead);
+    struct timeval timeout = {30, 0};
+    if (select(hSocket + 1, &fdRead, nullptr, nullptr, &timeout) <= 0)
+        return -1;
+    return recv(hSocket, buf, len, 0);
+}
+
+/** Connect to the test server and ask for the chunked reply */
+static SOCKET RequestChunkedReply()
+{
+    CService addr;
+    SOCKET hSocket = INVALID_SOCKET;
+    if (!LookupNumeric("127.0.0.1", addr, TEST_HTTP_PORT) || !ConnectSocket(addr, hSocket, 5000))
+        return INVALID_SOCKET;
+    const std::string request = "GET /chunked HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    if (send(hSocket, request.data(), request.size(), MSG_NOSIGNAL) != (int)request.size())
+        CloseSocket(hSocket);
+    return hSocket;
+}
+
+BOOST_FIXTURE_TEST_SUITE(httpserver_tests, HTTPServerSetup)
+
+BOOST_AUTO_TEST_CASE(chunked_reply_slow_reader)
+{
+    if (!fStarted)
+    {
+        std::cerr << __func__ << ": could not bind to port " << TEST_HTTP_PORT << ", skipping test" << std::endl;
+        return;
+    }
+    SOCKET hSocket = RequestChunkedReply();
+    BOOST_REQUIRE(hSocket != INVALID_SOCKET);
+
+    // Let the handler fill every buffer on the way and wait for the client
+    MilliSleep(1000);
+
+    // The body is only 'x', and neither the headers after "\r\n\r\n" nor the hex chunk sizes contain one
+    std::string head;
+    size_t nBody = 0;
+    char buf[64 * 1024];
+    int nRead;
+    while ((nRead = RecvWithTimeout(hSocket, buf, sizeof(buf))) > 0)
+    {
+        size_t start = 0;
+        if (head.find("\r\n\r\n") == std::string::npos)
+        {
+            size_t nOld = head.size();
+            head.append(buf, nRead);
+            size_t end = head.find("\r\n\r\n");
+            if (end == std::string::npos)
+                continue;
+            start = end + 4 - nOld;
+        }
+        nBody += std::count(buf + start, buf + nRead, 'x');
+    }
+    BOOST_CHECK_EQUAL(nRead, 0);
+    CloseSocket(hSocket);
+
+    BOOST_CHECK_EQUAL(nBody, CHUNK_SIZE * CHUNK_COUNT);
+    std::future<size_t> result = handlerDone->get_future();
+    BOOST_REQUIRE(result.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+    BOOST_CHECK_EQUAL(result.get(), CHUNK_COUNT);
+}
+
+BOOST_AUTO_TEST_CASE(chunked_reply_client_leaves)
+{
+    if (!fStarted)
+    {
+        std::cerr << __func__ << ": could not bind to port " << TEST_HTTP_PORT << ", skipping test" << std::endl;
+        return;
+    }
+    SOCKET hSocket = RequestChunkedReply();
+    BOOST_REQUIRE(hSocket != INVALID_SOCKET);
+
+    // Take a little of the reply, then go away while the handler waits for us
+    char buf[1024];
+    BOOST_CHECK(RecvWithTimeout(hSocket, buf, sizeof(buf)) > 0);
+    MilliSleep(1000);
+    CloseSocket(hSocket);
+
+    // The handler notices and stops instead of waiting forever
+    std::future<size_t> result = handlerDone->get_future();
+    BOOST_REQUIRE(result.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+    BOOST_CHECK(result.get() < CHUNK_COUNT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -319,4 +319,49 @@ BOOST_AUTO_TEST_CASE(key_test1)
                                    "6b4b1573c84da49a38405d"));
 }
 
+
+BOOST_AUTO_TEST_CASE(verify_signatures_batch)
+{
+    std::vector<CHashSignature> batch;
+    std::vector<unsigned char> expected;
+    for (int i = 0; i < 300; i++)
+    {
+        CKey key;
+        key.MakeNewKey(InsecureRandBool());
+        CHashSignature item;
+        item.pubkey = key.GetPubKey();
+        item.hash = InsecureRand256();
+        if (i % 2)
+            BOOST_CHECK(key.SignSchnorr(item.hash, item.sig));
+        else
+            BOOST_CHECK(key.SignECDSA(item.hash, item.sig));
+        bool fValid = true;
+        switch (InsecureRandRange(6))
+        {
+        case 0:
+            // signature of a different hash
+            item.hash = InsecureRand256();
+            fValid = false;
+            break;
+        case 1:
+            // damaged signature
+            item.sig[InsecureRandRange(item.sig.size())] ^= 1 + InsecureRandRange(255);
+            fValid = (item.sig.size() == 64) ? item.pubkey.VerifySchnorr(item.hash, item.sig) :
+                                               item.pubkey.VerifyECDSA(item.hash, item.sig);
+            break;
+        case 2:
+            // invalid public key
+            item.pubkey = CPubKey();
+            fValid = false;
+            break;
+        }
+        batch.push_back(item);
+        expected.push_back(fValid);
+    }
+
+    for (unsigned int nThreads : {0, 1, 3, 16})
+        BOOST_CHECK(VerifySignatures(batch, nThreads) == expected);
+    BOOST_CHECK(VerifySignatures(std::vector<CHashSignature>()).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
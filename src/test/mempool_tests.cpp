@@ -5,6 +5,7 @@
 
 #include "txmempool.h"
 #include "util.h"
+#include "validationinterface.h"
 
 #include "test/test_nexa.h"
 
@@ -1806,6 +1807,87 @@ BOOST_AUTO_TEST_CASE(MempoolRemoveTest)
     removed.clear();
 }
 
+/** Records the mempool removals announced through the validation interface */
+class RemovalRecorder : public CValidationInterface
+{
+public:
+    std::vector<std::pair<uint256, MemPoolRemovalReason> > removals;
+
+    RemovalRecorder() { GetMainSignals().nRemovedFromMempoolListeners++; }
+    ~RemovalRecorder() { GetMainSignals().nRemovedFromMempoolListeners--; }
+
+protected:
+    void TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason) override
+    {
+        removals.emplace_back(ptx->GetId(), reason);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(MempoolRemovalReasonTest)
+{
+    TestMemPoolEntryHelper entry;
+    CMutableTransaction txParent;
+    txParent.vin.resize(1);
+    txParent.vin[0].scriptSig = CScript() << OP_11;
+    txParent.vout.resize(1);
+    txParent.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txParent.vout[0].nValue = 33000LL;
+
+    CMutableTransaction txChild;
+    txChild.vin.resize(1);
+    txChild.vin[0].scriptSig = CScript() << OP_11;
+    txChild.vin[0].prevout = txParent.OutpointAt(0);
+    txChild.vout.resize(1);
+    txChild.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+    txChild.vout[0].nValue = 11000LL;
+
+    // Spends the same output as txChild
+    CMutableTransaction txConflict = txChild;
+    txConflict.vout[0].nValue = 10000LL;
+
+    CTxMemPool testPool;
+    RemovalRecorder recorder;
+    RaiiRegisterValidationInterface registration(&recorder);
+
+    // Expiry takes the descendants along
+    testPool.addUnchecked(entry.Time(1).FromTx(txParent));
+    testPool.addUnchecked(entry.Time(1).FromTx(txChild));
+    std::vector<COutPoint> vCoinsToUncache;
+    BOOST_CHECK_EQUAL(testPool.Expire(2, vCoinsToUncache), 2);
+    BOOST_CHECK_EQUAL(recorder.removals.size(), 2UL);
+    for (const auto &r : recorder.removals)
+        BOOST_CHECK(r.second == MemPoolRemovalReason::EXPIRY);
+    recorder.removals.clear();
+
+    // The parent is mined, and a block spending the child's input conflicts it out
+    testPool.addUnchecked(entry.FromTx(txParent));
+    testPool.addUnchecked(entry.FromTx(txChild));
+    std::vector<CTransactionRef> vtx{MakeTransactionRef(txParent), MakeTransactionRef(txConflict)};
+    std::list<CTransactionRef> conflicts;
+    testPool.removeForBlock(vtx, 1, conflicts);
+    BOOST_CHECK_EQUAL(testPool.size(), 0UL);
+    BOOST_REQUIRE_EQUAL(recorder.removals.size(), 2UL);
+    BOOST_CHECK(recorder.removals[0].first == txParent.GetId());
+    BOOST_CHECK(recorder.removals[0].second == MemPoolRemovalReason::BLOCK);
+    BOOST_CHECK(recorder.removals[1].first == txChild.GetId());
+    BOOST_CHECK(recorder.removals[1].second == MemPoolRemovalReason::CONFLICT);
+    recorder.removals.clear();
+
+    // Evicted for size
+    testPool.addUnchecked(entry.FromTx(txParent));
+    testPool.TrimToSize(0);
+    BOOST_REQUIRE_EQUAL(recorder.removals.size(), 1UL);
+    BOOST_CHECK(recorder.removals[0].second == MemPoolRemovalReason::SIZELIMIT);
+    recorder.removals.clear();
+
+    // Removed explicitly
+    testPool.addUnchecked(entry.FromTx(txParent));
+    std::list<CTransactionRef> removed;
+    testPool.removeRecursive(txParent, removed);
+    BOOST_REQUIRE_EQUAL(recorder.removals.size(), 1UL);
+    BOOST_CHECK(recorder.removals[0].second == MemPoolRemovalReason::UNKNOWN);
+}
+
 template <typename name>
 void CheckSort(CTxMemPool &pool, std::vector<std::string> &sortedOrder)
 {
@@ -201,4 +201,40 @@ BOOST_AUTO_TEST_CASE(merkle_test)
     }
 }
 
+
+BOOST_AUTO_TEST_CASE(merkle_tree)
+{
+    for (uint32_t nLeaves : {0, 1, 2, 3, 5, 8, 17, 1000, 40001})
+    {
+        std::vector<uint256> leaves(nLeaves);
+        for (auto &leaf : leaves)
+            leaf = InsecureRand256();
+        if (nLeaves > 2 && InsecureRandBool())
+            leaves[nLeaves - 1] = leaves[nLeaves - 2];
+
+        bool mutated = false;
+        const uint256 root = ComputeMerkleRoot(leaves, &mutated, 1);
+        // Hashing the levels on several threads gives the same result
+        for (unsigned int nThreads : {0, 1, 3, 8})
+        {
+            bool parallelMutated = false;
+            BOOST_CHECK(ComputeMerkleRoot(leaves, &parallelMutated, nThreads) == root);
+            BOOST_CHECK_EQUAL(parallelMutated, mutated);
+
+            CMerkleTree tree(leaves, nThreads);
+            BOOST_CHECK(tree.GetRoot() == root);
+            BOOST_CHECK_EQUAL(tree.IsMutated(), mutated);
+            BOOST_CHECK_EQUAL(tree.GetNumLeaves(), nLeaves);
+            for (int i = 0; i < 20 && nLeaves > 0; i++)
+            {
+                const uint32_t pos = (i < 2) ? i * (nLeaves - 1) : InsecureRandRange(nLeaves);
+                std::vector<uint256> branch = tree.GetBranch(pos);
+                BOOST_CHECK(branch == ComputeMerkleBranch(leaves, pos));
+                BOOST_CHECK(ComputeMerkleRootFromBranch(leaves[pos], branch, pos) == root);
+            }
+            BOOST_CHECK(tree.GetBranch(nLeaves).empty());
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
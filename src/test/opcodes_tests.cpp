@@ -596,6 +596,48 @@ BOOST_AUTO_TEST_CASE(type_conversion_test)
     CheckNum2BinError({{0xab, 0xcd, 0xef, 0x80}, {0x03}}, SCRIPT_ERR_IMPOSSIBLE_ENCODING);
 }
 
+BOOST_AUTO_TEST_CASE(stackitem_copy_move_test)
+{
+    const valtype bytes{0x01, 0x02, 0x03};
+    const valtype num(BigNum(-12345));
+
+    // Copies keep the type and value of the source
+    valtype a(bytes), b(num);
+    BOOST_CHECK(a.isVch() && a.data() == bytes.data());
+    BOOST_CHECK(b.isBigNum() && b.num() == num.num());
+
+    // Assignment changes the type in both directions
+    a = num;
+    BOOST_CHECK(a.isBigNum() && a.num() == num.num());
+    b = bytes;
+    BOOST_CHECK(b.isVch() && b.data() == bytes.data());
+    a = b;
+    BOOST_CHECK(a.isVch() && a.data() == bytes.data());
+
+    // Moves leave the value in the destination
+    valtype c(std::move(a));
+    BOOST_CHECK(c.isVch() && c.data() == bytes.data());
+    valtype d(num);
+    valtype e(std::move(d));
+    BOOST_CHECK(e.isBigNum() && e.num() == num.num());
+    c = std::move(e);
+    BOOST_CHECK(c.isBigNum() && c.num() == num.num());
+    c.assign(bytes.begin(), bytes.end());
+    BOOST_CHECK(c.isVch() && c.data() == bytes.data());
+
+    // Growing a stack of mixed items moves them without changing them
+    stacktype stack;
+    for (int i = 0; i < 100; i++)
+        stack.push_back(i % 2 ? valtype(BigNum(i)) : valtype(VchStack, i, 0x55));
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 2)
+            BOOST_CHECK(stack[i].isBigNum() && stack[i].num() == BigNum(i));
+        else
+            BOOST_CHECK(stack[i].isVch() && stack[i].data() == VchType(i, 0x55));
+    }
+}
+
 static void CheckDivMod(const valtype &a,
     const valtype &b,
     const valtype &divExpected,
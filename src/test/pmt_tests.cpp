@@ -131,4 +131,40 @@ BOOST_AUTO_TEST_CASE(pmt_malleability)
     BOOST_CHECK(tree.ExtractMatches(vTxid, vIndex).IsNull());
 }
 
+
+BOOST_AUTO_TEST_CASE(pmt_from_tree)
+{
+    std::vector<uint256> vTxid(3001);
+    for (auto &txid : vTxid)
+        txid = InsecureRand256();
+    CMerkleTree tree(vTxid);
+
+    // Many single transaction proofs taken from the same tree
+    for (uint32_t pos : {0U, 1U, 1500U, 2999U, 3000U})
+    {
+        CPartialMerkleTree pmt(tree, {pos});
+        std::vector<uint256> vMatchTxid;
+        std::vector<unsigned int> vIndex;
+        BOOST_CHECK(pmt.ExtractMatches(vMatchTxid, vIndex) == tree.GetRoot());
+        BOOST_CHECK(vMatchTxid == std::vector<uint256>(1, vTxid[pos]));
+        BOOST_CHECK(vIndex == std::vector<unsigned int>(1, pos));
+
+        // The same proof as the one built from the transaction ids
+        std::vector<bool> vMatch(vTxid.size(), false);
+        vMatch[pos] = true;
+        CDataStream ss1(SER_NETWORK, PROTOCOL_VERSION);
+        CDataStream ss2(SER_NETWORK, PROTOCOL_VERSION);
+        ss1 << pmt;
+        ss2 << CPartialMerkleTree(vTxid, vMatch);
+        BOOST_CHECK(ss1.str() == ss2.str());
+    }
+
+    // An empty tree has no matches and no root
+    CMerkleTree emptyTree{std::vector<uint256>()};
+    CPartialMerkleTree empty(emptyTree, std::vector<uint32_t>());
+    std::vector<uint256> vMatchTxid;
+    std::vector<unsigned int> vIndex;
+    BOOST_CHECK(empty.ExtractMatches(vMatchTxid, vIndex).IsNull());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
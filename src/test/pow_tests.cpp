@@ -6,6 +6,7 @@
 #include "chain.h"
 #include "chainparams.h"
 #include "pow.h"
+#include "primitives/block.h"
 #include "random.h"
 #include "test/test_nexa.h"
 #include "util.h"
@@ -459,4 +460,70 @@ BOOST_AUTO_TEST_CASE(calculate_asert_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(mining_hasher_test)
+{
+    const uint256 commitment = InsecureRand256();
+    const unsigned int nonceSizes[] = {0, 3, 4, 8, 16};
+    for (unsigned int nonceSize : nonceSizes)
+    {
+        for (unsigned int counterBytes = 0; counterBytes <= 9; counterBytes += 3)
+        {
+            std::vector<unsigned char> nonce(nonceSize);
+            for (auto &b : nonce)
+                b = InsecureRandBits(8);
+            const uint64_t counter = InsecureRandBits(64);
+            CMiningHasher hasher(commitment, nonce, counterBytes);
+            uint256 hashes[CMiningHasher::BATCH_SIZE];
+            hasher.HashBatch(counter, hashes);
+            for (unsigned int i = 0; i < CMiningHasher::BATCH_SIZE; i++)
+            {
+                std::vector<unsigned char> expected(nonce);
+                for (unsigned int x = 0; x < std::min<size_t>({counterBytes, nonceSize, 8}); x++)
+                    expected[x] = ((counter + i) >> (x * 8)) & 255;
+                BOOST_CHECK(hasher.Nonce(counter + i) == expected);
+                BOOST_CHECK(hashes[i] == GetMiningHash(commitment, expected));
+            }
+        }
+    }
+
+    // The counter wraps within its bytes and leaves the rest of the nonce alone
+    CMiningHasher hasher(commitment, {0, 0, 7}, 1);
+    BOOST_CHECK(hasher.Nonce(0x1ff) == std::vector<unsigned char>({0xff, 0, 7}));
+    BOOST_CHECK(hasher.Nonce(0x200) == std::vector<unsigned char>({0, 0, 7}));
+}
+
+BOOST_AUTO_TEST_CASE(pow_target_test)
+{
+    Consensus::Params params = Params().GetConsensus();
+    params.powLimit = uint256S("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    const uint32_t limitBits = UintToArith256(params.powLimit).GetCompact();
+    const uint32_t nBitsList[] = {limitBits, 0x207fff00, 0x1f00ffff, 0x2100ffff, 0x04923456, 0, 0x01803456};
+    for (unsigned int algorithm = 0; algorithm <= 1; algorithm++)
+    {
+        params.powAlgorithm = algorithm;
+        for (uint32_t nBits : nBitsList)
+        {
+            arith_uint256 target;
+            const bool valid = GetProofOfWorkTarget(nBits, params, target);
+            BOOST_CHECK_EQUAL(valid, nBits == limitBits || nBits == 0x207fff00 || nBits == 0x1f00ffff);
+            for (int i = 0; i < 20; i++)
+            {
+                const uint256 hash = InsecureRand256();
+                BOOST_CHECK_EQUAL(CheckProofOfWork(hash, nBits, params),
+                    valid && CheckProofOfWorkTarget(hash, target, params));
+            }
+        }
+
+        // MineBlock tries whole batches but stops at the first nonce that works
+        CBlockHeader header;
+        header.size = 1000;
+        header.nBits = limitBits;
+        header.nonce.resize(4);
+        BOOST_CHECK(MineBlock(header, 1000, params));
+        BOOST_CHECK(CheckProofOfWork(GetMiningHash(header.GetMiningHeaderCommitment(), header.nonce), limitBits,
+            params));
+        BOOST_CHECK_EQUAL(header.nonce.size(), 4U);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,9 +7,12 @@
 #include "rpc/server.h"
 
 #include "base58.h"
+#include "httprpc.h"
 #include "net.h"
 #include "netbase.h"
 #include "rpc/blockchain.h"
+#include "rpc/jsonstream.h"
+#include "rpc/stats.h"
 #include "unlimited.h"
 
 #include "test/test_nexa.h"
@@ -537,4 +540,162 @@ BOOST_AUTO_TEST_CASE(rpc_getblockstats_calculate_percentiles_by_size)
     }
 }
 
+BOOST_AUTO_TEST_CASE(rpc_stats)
+{
+    RPCLatencyHistogram hist;
+    hist.Add(50);
+    hist.Add(100);
+    hist.Add(2500);
+    hist.Add(20000000);
+    UniValue obj = hist.ToJSON();
+    BOOST_CHECK_EQUAL(find_value(obj, "count").get_int(), 4);
+    BOOST_CHECK_EQUAL(find_value(obj, "max_ms").get_real(), 20000.0);
+    const UniValue &buckets = find_value(obj, "histogram");
+    BOOST_CHECK_EQUAL(find_value(buckets, "<100us").get_int(), 1);
+    BOOST_CHECK_EQUAL(find_value(buckets, "<1ms").get_int(), 1);
+    BOOST_CHECK_EQUAL(find_value(buckets, "<10ms").get_int(), 1);
+    BOOST_CHECK_EQUAL(find_value(buckets, "<1s").get_int(), 0);
+    BOOST_CHECK_EQUAL(find_value(buckets, ">=10s").get_int(), 1);
+
+    // Calls through the RPC table are timed per method, and reset clears them
+    SetRPCWarmupFinished();
+    ResetRPCStats();
+    tableRPC.execute("uptime", UniValue(UniValue::VARR));
+    tableRPC.execute("uptime", UniValue(UniValue::VARR));
+    UniValue stats = CallRPC("getrpcstats true");
+    BOOST_CHECK(find_value(stats, "queues").isObject());
+    const UniValue &uptime = find_value(find_value(stats, "methods"), "uptime");
+    BOOST_CHECK_EQUAL(find_value(uptime, "count").get_int(), 2);
+    stats = CallRPC("getrpcstats");
+    BOOST_CHECK(find_value(find_value(stats, "methods"), "uptime").isNull());
+    BOOST_CHECK_THROW(CallRPC("getrpcstats true extra"), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_classify)
+{
+    InitRPCWorkClasses();
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":\"getblockcount\",\"params\":[],\"id\":1}"), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":\"getblock\",\"params\":[\"00\"],\"id\":1}"), HTTP_WORK_HEAVY);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":\"capd\",\"params\":[\"info\"],\"id\":1}"), HTTP_WORK_REST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":\"capd\",\"params\":[\"poll\",1],\"id\":1}"), HTTP_WORK_POLL);
+
+    // Unknown methods and requests without a usable method are left to the handler on the fast queue
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":\"nosuchmethod\",\"params\":[],\"id\":1}"), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":5,\"params\":[],\"id\":1}"), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"params\":[\"poll\"],\"id\":1}"), HTTP_WORK_FAST);
+
+    // Malformed bodies
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody(""), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("{\"method\":\"getblock\","), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("getblock"), HTTP_WORK_FAST);
+
+    // A batch goes to the slowest queue any of its calls needs, wherever that call is
+    const std::string fast = "{\"method\":\"getblockcount\",\"params\":[],\"id\":1}";
+    const std::string heavy = "{\"method\":\"getblock\",\"params\":[\"00\"],\"id\":2}";
+    const std::string rest = "{\"method\":\"capd\",\"params\":[\"info\"],\"id\":3}";
+    const std::string poll = "{\"method\":\"capd\",\"params\":[\"poll\",1],\"id\":4}";
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[]"), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[1,\"getblock\"]"), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[" + fast + "," + fast + "]"), HTTP_WORK_FAST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[" + fast + "," + heavy + "]"), HTTP_WORK_HEAVY);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[" + heavy + "," + rest + "]"), HTTP_WORK_REST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[" + rest + "," + heavy + "]"), HTTP_WORK_REST);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody("[" + heavy + "," + poll + "," + rest + "]"), HTTP_WORK_POLL);
+
+    // Bodies up to the limit are parsed, larger ones go to the heavy queue unparsed
+    const std::string head = "{\"method\":\"getblockcount\",\"params\":[\"";
+    const std::string tail = "\"],\"id\":1}";
+    std::string body = head + std::string(MAX_CLASSIFY_BODY_SIZE - head.size() - tail.size(), 'a') + tail;
+    BOOST_CHECK_EQUAL(body.size(), MAX_CLASSIFY_BODY_SIZE);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody(body), HTTP_WORK_FAST);
+    body = head + std::string(MAX_CLASSIFY_BODY_SIZE + 1 - head.size() - tail.size(), 'a') + tail;
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody(body), HTTP_WORK_HEAVY);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody(body.substr(0, MAX_CLASSIFY_BODY_SIZE + 1)), HTTP_WORK_HEAVY);
+
+    // The configuration moves methods between the fast and heavy queues
+    mapMultiArgs["-rpcheavymethod"] = {"getblockcount"};
+    mapMultiArgs["-rpcfastmethod"] = {"getblock"};
+    InitRPCWorkClasses();
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody(fast), HTTP_WORK_HEAVY);
+    BOOST_CHECK_EQUAL(ClassifyJSONRPCBody(heavy), HTTP_WORK_FAST);
+    mapMultiArgs.erase("-rpcheavymethod");
+    mapMultiArgs.erase("-rpcfastmethod");
+    InitRPCWorkClasses();
+}
+
+BOOST_AUTO_TEST_CASE(rpc_jsonstream)
+{
+    UniValue head(UniValue::VOBJ);
+    head.pushKV("hash", "00ff");
+    head.pushKV("height", 7);
+    UniValue tx(UniValue::VOBJ);
+    tx.pushKV("txid", "ab\"c\\\n\x01\x7f");
+    tx.pushKV("fee", ValueFromAmount(1234));
+
+    UniValue expected = head;
+    UniValue txs(UniValue::VARR);
+    txs.push_back(tx);
+    txs.push_back(tx);
+    expected.pushKV("tx", txs);
+    expected.pushKV("empty", UniValue(UniValue::VARR));
+    expected.pushKV("size", (int64_t)-5);
+    expected.pushKV("flag", false);
+    expected.pushKV("none", NullUniValue);
+
+    // A tiny chunk size so the output is handed over in many pieces
+    std::string streamed;
+    size_t nChunks = 0;
+    JSONStreamWriter out(
+        [&](const std::string &chunk) {
+            streamed += chunk;
+            nChunks++;
+            return true;
+        },
+        8);
+    out.BeginObject(head);
+    out.Key("tx");
+    out.BeginArray();
+    out.Value(tx);
+    out.Value(tx);
+    out.EndArray();
+    out.Key("empty");
+    out.BeginArray();
+    out.EndArray();
+    out.KV("size", (int64_t)-5);
+    out.KV("flag", false);
+    out.Key("none");
+    out.Null();
+    out.EndObject();
+    out.Flush();
+    BOOST_CHECK_EQUAL(streamed, expected.write());
+    BOOST_CHECK(nChunks > 1);
+    BOOST_CHECK_EQUAL(out.BytesWritten(), streamed.size());
+
+    // Once the sink refuses output the writer stops handing it over
+    nChunks = 0;
+    JSONStreamWriter refused(
+        [&](const std::string &) {
+            nChunks++;
+            return false;
+        },
+        8);
+    refused.BeginArray();
+    for (int i = 0; i < 10; i++)
+        refused.Value(std::string("0123456789"));
+    refused.EndArray();
+    refused.Flush();
+    BOOST_CHECK(refused.Aborted());
+    BOOST_CHECK_EQUAL(nChunks, 1);
+
+    // The streamed mempool listing is the same as the UniValue one
+    streamed.clear();
+    JSONStreamWriter pool([&](const std::string &chunk) {
+        streamed += chunk;
+        return true;
+    });
+    mempoolToJSON(pool, true);
+    pool.Flush();
+    BOOST_CHECK_EQUAL(streamed, mempoolToJSON(true).write());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -717,6 +717,116 @@ BOOST_AUTO_TEST_CASE(bignum_test)
     BOOST_CHECK(biggest.serialize(buf, 10) == -513); // Check correct requested size error
 }
 
+// Random sign-magnitude bytes, biased toward the limb patterns that exercise carries and division corrections
+static std::vector<unsigned char> RandomBigNumBytes()
+{
+    static const size_t lengths[] = {0, 1, 8, 9, 16, 31, 32, 33, 48, 63, 64, 65, 96, 128, 200, 300};
+    size_t len = lengths[InsecureRandRange(sizeof(lengths) / sizeof(lengths[0]))];
+    if (len > 1 && InsecureRandBool())
+        len -= InsecureRandRange(len / 2);
+    std::vector<unsigned char> ret(len + 1);
+    const int pattern = InsecureRandRange(4);
+    for (size_t i = 0; i < len; i++)
+    {
+        if (pattern == 0)
+            ret[i] = InsecureRandBits(8);
+        else if (pattern == 1)
+            ret[i] = 0xff;
+        else if (pattern == 2)
+            ret[i] = (i % 8 == 7) ? 0x80 : 0;
+        else
+            ret[i] = InsecureRandBool() ? 0xff : InsecureRandBits(8);
+    }
+    ret[len] = InsecureRandBool() ? 0x80 : 0; // sign
+    return ret;
+}
+
+static void BigNumBytesToMpz(mpz_t out, const std::vector<unsigned char> &b)
+{
+    mpz_import(out, b.size() - 1, -1, 1, 0, 0, b.data());
+    if (b.back() & 0x80)
+        mpz_neg(out, out);
+}
+
+static bool BigNumEqualsMpz(const BigNum &bn, const mpz_t z)
+{
+    mpz_t tmp;
+    mpz_init(tmp);
+    BigNumBytesToMpz(tmp, bn.serialize(0));
+    bool ret = (mpz_cmp(tmp, z) == 0);
+    mpz_clear(tmp);
+    return ret;
+}
+
+BOOST_AUTO_TEST_CASE(bignum_gmp_differential_test)
+{
+    // BigNum keeps small numbers in fixed width limbs with its own arithmetic, so check it against plain GMP
+    // across the fixed width boundary
+    mpz_t za, zb, zr, zq;
+    mpz_inits(za, zb, zr, zq, nullptr);
+    for (int i = 0; i < 3000; i++)
+    {
+        const std::vector<unsigned char> va = RandomBigNumBytes();
+        const std::vector<unsigned char> vb = RandomBigNumBytes();
+        BigNum a, b;
+        a.deserialize(va);
+        b.deserialize(vb);
+        BigNumBytesToMpz(za, va);
+        BigNumBytesToMpz(zb, vb);
+        BOOST_REQUIRE(BigNumEqualsMpz(a, za));
+        BOOST_REQUIRE(BigNumEqualsMpz(b, zb));
+
+        const int c = a.cmp(b);
+        const int zc = mpz_cmp(za, zb);
+        BOOST_CHECK((c < 0) == (zc < 0) && (c > 0) == (zc > 0));
+        BOOST_CHECK((a == b) == (zc == 0));
+        BOOST_CHECK((a < b) == (zc < 0));
+
+        mpz_add(zr, za, zb);
+        BOOST_CHECK(BigNumEqualsMpz(a + b, zr));
+        mpz_sub(zr, za, zb);
+        BOOST_CHECK(BigNumEqualsMpz(a - b, zr));
+        mpz_neg(zr, za);
+        BOOST_CHECK(BigNumEqualsMpz(-a, zr));
+        mpz_mul(zr, za, zb);
+        BOOST_CHECK(BigNumEqualsMpz(a * b, zr));
+
+        const unsigned long amt = InsecureRandRange(700);
+        mpz_mul_2exp(zr, za, amt);
+        BOOST_CHECK(BigNumEqualsMpz(a << amt, zr));
+        mpz_tdiv_q_2exp(zr, za, amt);
+        BOOST_CHECK(BigNumEqualsMpz(a >> amt, zr));
+
+        if (mpz_sgn(zb) != 0)
+        {
+            mpz_tdiv_q(zr, za, zb);
+            BOOST_CHECK(BigNumEqualsMpz(a / b, zr));
+            mpz_tdiv_r(zr, za, zb);
+            BOOST_CHECK(BigNumEqualsMpz(a.tdiv(b), zr));
+            mpz_mod(zr, za, zb);
+            BOOST_CHECK(BigNumEqualsMpz(a % b, zr));
+
+            // products of fixed width numbers that do not fit in the fixed width themselves
+            mpz_mul(zq, za, za);
+            mpz_tdiv_r(zr, zq, zb);
+            BOOST_CHECK(BigNumEqualsMpz(a.mulTdiv(a, b), zr));
+            BigNum sq = a * a;
+            BOOST_CHECK(BigNumEqualsMpz(sq, zq));
+            mpz_tdiv_q(zr, zq, zb);
+            BOOST_CHECK(BigNumEqualsMpz(sq / b, zr));
+        }
+
+        // assignment between fixed and GMP held numbers
+        BigNum r = a;
+        r = b;
+        BOOST_CHECK(BigNumEqualsMpz(r, zb));
+        r = a * b;
+        r = std::move(a);
+        BOOST_CHECK(BigNumEqualsMpz(r, za));
+    }
+    mpz_clears(za, zb, zr, zq, nullptr);
+}
+
 std::vector<unsigned char> bns(long int i, size_t pad = 8) { return BigNum(i).serialize(pad); }
 void testScript(const CScript &s, bool expectedRet, bool expectedStackTF, ScriptError expectedError)
 {
@@ -1,6 +1,7 @@
 #include "core_io.h"
 #include "key.h"
 #include "keystore.h"
+#include "policy/policy.h"
 #include "rpc/server.h"
 #include "script/script.h"
 #include "script/script_error.h"
@@ -145,6 +146,152 @@ BOOST_AUTO_TEST_CASE(verifywellknown)
     }
 }
 
+// Check that the native p2pkt verifier gives the same answer as running the template in the script machine
+static void CheckP2pktFastPath(const CScript &constraint,
+    const CScript &satisfier,
+    unsigned int flags,
+    unsigned int maxOps,
+    const ScriptImportedState &sis,
+    bool expectHandled)
+{
+    ScriptError error = SCRIPT_ERR_OK;
+    ScriptError fastError = SCRIPT_ERR_OK;
+    ScriptMachineResourceTracker tracker;
+    ScriptMachineResourceTracker fastTracker;
+    bool fastRet = false;
+    bool handled =
+        VerifyP2pktTemplate(constraint, satisfier, flags, maxOps, sis, &fastError, &fastTracker, fastRet);
+    BOOST_CHECK_EQUAL(handled, expectHandled);
+    bool ret = EvalTemplate(p2pkt, constraint, satisfier, flags, maxOps, 0xffffffff, sis, &error, &tracker);
+    if (!handled)
+    {
+        BOOST_CHECK_EQUAL(fastError, SCRIPT_ERR_OK);
+        BOOST_CHECK_EQUAL(fastTracker.nOpCount, 0U);
+        return;
+    }
+    BOOST_CHECK_EQUAL(fastRet, ret);
+    BOOST_CHECK_MESSAGE(fastError == error, ScriptErrorString(fastError) << " != " << ScriptErrorString(error));
+    BOOST_CHECK_EQUAL(fastTracker.nOpCount, tracker.nOpCount);
+    BOOST_CHECK_EQUAL(fastTracker.consensusSigCheckCount, tracker.consensusSigCheckCount);
+    BOOST_CHECK_EQUAL(fastTracker.nOpExec, tracker.nOpExec);
+}
+
+BOOST_AUTO_TEST_CASE(p2pkt_fast_path)
+{
+    QuickAddress owner;
+    QuickAddress other;
+    CKey uncompressedKey;
+    uncompressedKey.MakeNewKey(false);
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].amount = 1000;
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 1000;
+    mtx.vout[0].scriptPubKey = P2pktOutput(other.pubkey);
+    const CTransaction tx(mtx);
+
+    auto sign = [&tx](const CKey &key, const SigHashType &sigHashType) {
+        uint256 hash;
+        BOOST_REQUIRE(SignatureHashNexa(p2pkt, tx, 0, sigHashType, hash));
+        std::vector<unsigned char> sig;
+        BOOST_REQUIRE(key.SignSchnorr(hash, sig));
+        sigHashType.appendToSig(sig);
+        return sig;
+    };
+
+    std::vector<std::vector<unsigned char> > sigs;
+    sigs.push_back(sign(owner.secret, defaultSigHashType));
+    sigs.push_back(sign(owner.secret, SigHashType().withAnyoneCanPay()));
+    sigs.push_back(sign(other.secret, defaultSigHashType));
+    sigs.push_back(sign(uncompressedKey, defaultSigHashType));
+    sigs.push_back(std::vector<unsigned char>());
+    std::vector<unsigned char> corrupt = sigs[0];
+    corrupt[10] ^= 1;
+    sigs.push_back(corrupt);
+    sigs.push_back(std::vector<unsigned char>(sigs[0].begin(), sigs[0].begin() + 63));
+    sigs.push_back(std::vector<unsigned char>(sigs[0].begin(), sigs[0].begin() + 64));
+    std::vector<unsigned char> badHashType = sigs[0];
+    badHashType.push_back(0xff);
+    badHashType.push_back(0xff);
+    sigs.push_back(badHashType);
+    sigs.push_back(std::vector<unsigned char>(80, 1));
+
+    std::vector<std::vector<unsigned char> > pubkeys;
+    pubkeys.push_back(ToByteVector(owner.pubkey));
+    pubkeys.push_back(ToByteVector(other.pubkey));
+    pubkeys.push_back(ToByteVector(uncompressedKey.GetPubKey()));
+    pubkeys.push_back(std::vector<unsigned char>());
+    pubkeys.push_back(std::vector<unsigned char>(33, 2));
+    std::vector<unsigned char> hybrid = ToByteVector(uncompressedKey.GetPubKey());
+    hybrid[0] = 0x06 | (hybrid[64] & 1);
+    pubkeys.push_back(hybrid);
+
+    const unsigned int flagSets[] = {MANDATORY_SCRIPT_VERIFY_FLAGS, STANDARD_SCRIPT_VERIFY_FLAGS,
+        MANDATORY_SCRIPT_VERIFY_FLAGS & ~SCRIPT_VERIFY_NULLFAIL, SCRIPT_VERIFY_NONE,
+        SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_NULLFAIL, SCRIPT_VERIFY_COMPRESSED_PUBKEYTYPE};
+    for (unsigned int flags : flagSets)
+    {
+        TransactionSignatureChecker checker(&tx, 0, flags);
+        const ScriptImportedState sis(&checker);
+        for (const auto &pubkey : pubkeys)
+        {
+            for (const auto &sig : sigs)
+            {
+                const CScript constraint = CScript() << pubkey;
+                const CScript satisfier = CScript() << sig;
+                CheckP2pktFastPath(constraint, satisfier, flags, maxScriptTemplateOps, sis, true);
+                CheckP2pktFastPath(constraint, satisfier, flags, 2, sis, true);
+                CheckP2pktFastPath(constraint, satisfier, flags, 1, sis, false);
+                CheckP2pktFastPath(constraint, satisfier, flags, 2, ScriptImportedState(), true);
+            }
+        }
+
+        // Anything but a single minimal data push is left to the script machine
+        const CScript constraint = CScript() << pubkeys[0];
+        const CScript satisfier = CScript() << sigs[0];
+        CheckP2pktFastPath(constraint, satisfier + satisfier, flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(constraint + constraint, satisfier, flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(constraint, CScript(), flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(CScript(), satisfier, flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(constraint, CScript() << OP_1, flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(constraint, CScript() << OP_RESERVED, flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(constraint, CScript() << OP_NOP, flags, maxScriptTemplateOps, sis, false);
+        CScript nonMinimal;
+        nonMinimal.push_back(OP_PUSHDATA1);
+        nonMinimal.push_back(sigs[0].size());
+        nonMinimal.insert(nonMinimal.end(), sigs[0].begin(), sigs[0].end());
+        CheckP2pktFastPath(constraint, nonMinimal, flags, maxScriptTemplateOps, sis, false);
+        CScript truncated;
+        truncated.push_back(10);
+        truncated.push_back(1);
+        CheckP2pktFastPath(constraint, truncated, flags, maxScriptTemplateOps, sis, false);
+        CheckP2pktFastPath(constraint, CScript() << std::vector<unsigned char>(MAX_SCRIPT_ELEMENT_SIZE + 1, 1), flags,
+            maxScriptTemplateOps, sis, false);
+    }
+
+    // A full spend takes the fast path whether the template is given by its well-known identifier or its hash
+    {
+        TransactionSignatureChecker checker(&tx, 0, MANDATORY_SCRIPT_VERIFY_FLAGS);
+        const ScriptImportedState sis(&checker);
+        CScript args = CScript() << ToByteVector(owner.pubkey);
+        CScript txout = P2pktOutput(owner.pubkey);
+        CScript txoutHash = ScriptTemplateOutput(VchHash160(p2pkt.begin(), p2pkt.end()), VchHash160(args));
+        ScriptError error;
+        ScriptMachineResourceTracker tracker;
+        BOOST_CHECK(VerifyScript(CScript() << vch(args) << sigs[0], txout, MANDATORY_SCRIPT_VERIFY_FLAGS, sis, &error,
+            &tracker));
+        BOOST_CHECK_EQUAL(error, SCRIPT_ERR_OK);
+        BOOST_CHECK(VerifyScript(CScript() << vch(p2pkt) << vch(args) << sigs[0], txoutHash,
+            MANDATORY_SCRIPT_VERIFY_FLAGS, sis, &error, &tracker));
+        BOOST_CHECK_EQUAL(tracker.nOpCount, 4U);
+        BOOST_CHECK_EQUAL(tracker.consensusSigCheckCount, 2U);
+        BOOST_CHECK(!VerifyScript(CScript() << vch(args) << sigs[2], txout, MANDATORY_SCRIPT_VERIFY_FLAGS, sis,
+            &error, &tracker));
+        BOOST_CHECK_EQUAL(error, SCRIPT_ERR_SIG_NULLFAIL);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(verifytemplate)
 {
     auto flags = MANDATORY_SCRIPT_VERIFY_FLAGS;
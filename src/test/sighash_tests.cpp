@@ -202,6 +202,53 @@ BOOST_AUTO_TEST_CASE(sighash_from_data)
 }
 #endif
 
+BOOST_AUTO_TEST_CASE(sighash_precomputed)
+{
+    // Enough inputs that FIRSTN can not cover all of them
+    CMutableTransaction mtx;
+    RandomTransaction(mtx);
+    while (mtx.vin.size() < 300)
+    {
+        mtx.vin.push_back(mtx.vin.back());
+        mtx.vin.back().prevout.hash = InsecureRand256();
+        mtx.vin.back().amount = InsecureRandRange(100000000);
+    }
+    while (mtx.vout.size() < 5)
+        mtx.vout.push_back(mtx.vout.back());
+    const CTransaction tx(mtx);
+    const PrecomputedTransactionData txdata(tx);
+
+    std::vector<SigHashType> sigHashTypes;
+    for (unsigned int n : {1, 2, 100, 255})
+    {
+        sigHashTypes.push_back(SigHashType().setFirstNIn(n));
+        sigHashTypes.push_back(SigHashType().setFirstNIn(n).setFirstNOut(3));
+    }
+    sigHashTypes.push_back(SigHashType());
+    sigHashTypes.push_back(SigHashType().withAnyoneCanPay());
+    sigHashTypes.push_back(SigHashType().setNoOut());
+    sigHashTypes.push_back(SigHashType().setFirstNOut(5));
+    sigHashTypes.push_back(SigHashType().set2Outs(4, 1));
+    // more outputs than there are
+    sigHashTypes.push_back(SigHashType().setFirstNOut(6));
+
+    CScript scriptCode;
+    RandomScript(scriptCode);
+    for (const SigHashType &sigHashType : sigHashTypes)
+    {
+        for (unsigned int nIn : {0, 1, 254, 299})
+        {
+            uint256 sighash;
+            uint256 sighashPrecomputed;
+            bool ok = SignatureHashNexa(scriptCode, tx, nIn, sigHashType, sighash);
+            bool okPrecomputed =
+                SignatureHashNexa(scriptCode, tx, nIn, sigHashType, sighashPrecomputed, nullptr, &txdata);
+            BOOST_CHECK_EQUAL(ok, okPrecomputed);
+            BOOST_CHECK(sighash == sighashPrecomputed);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(sighash_test_fail)
 {
     CScript scriptCode = CScript();
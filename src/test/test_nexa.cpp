@@ -28,6 +28,7 @@
 #include "txmempool.h"
 #include "ui_interface.h"
 #include "validation/validation.h"
+#include "workerpool.h"
 
 #include <memory>
 
@@ -56,13 +57,19 @@ BasicTestingSetup::BasicTestingSetup(const std::string &chainName)
     SetupEnvironment();
     SetupNetworking();
     InitSignatureCache();
+    // Run the code that spreads work across the worker pool on more than one thread
+    workerPool.Start(3, "worker");
     fPrintToDebugLog = false; // don't want to write to debug.log file
     fCheckBlockIndex = true;
     SelectParams(chainName);
     noui_connect();
 }
 
-BasicTestingSetup::~BasicTestingSetup() { ECC_Stop(); }
+BasicTestingSetup::~BasicTestingSetup()
+{
+    workerPool.Stop();
+    ECC_Stop();
+}
 TestingSetup::TestingSetup(const std::string &chainName) : BasicTestingSetup(chainName)
 {
     const CChainParams &chainparams = Params();
@@ -33,6 +33,30 @@ CMutableTransaction CreateRandomTx()
     return tx;
 }
 
+CTransactionRef MakeTx(const std::vector<COutPoint> &prevouts, const std::vector<CTxOut> &outs)
+{
+    CMutableTransaction tx;
+    for (const auto &prevout : prevouts)
+    {
+        CTxIn in;
+        in.prevout = prevout;
+        tx.vin.push_back(in);
+    }
+    tx.vout = outs;
+    return MakeTransactionRef(tx);
+}
+
+TestBlockIndexChain::TestBlockIndexChain(size_t nLength) : hashes(nLength), indexes(nLength)
+{
+    for (size_t i = 0; i < nLength; i++)
+    {
+        hashes[i] = GetRandHash();
+        indexes[i].header.height = i;
+        indexes[i].phashBlock = &hashes[i];
+        indexes[i].pprev = i ? &indexes[i - 1] : nullptr;
+    }
+}
+
 // create a pay to public key hash script
 CScript p2pkh(const CKeyID &dest)
 {
@@ -9,6 +9,7 @@
 #ifndef NEXA_TEST_TESTUTIL_H
 #define NEXA_TEST_TESTUTIL_H
 
+#include "chain.h"
 #include "fs.h"
 #include "key.h"
 #include "pubkey.h"
@@ -20,6 +21,25 @@ struct CMutableTransaction;
 fs::path GetTempPath();
 CMutableTransaction CreateRandomTx();
 
+// A transaction spending prevouts to outs, with empty input scripts
+CTransactionRef MakeTx(const std::vector<COutPoint> &prevouts, const std::vector<CTxOut> &outs);
+
+/** A chain of block index entries with random hashes, starting at height 0, for tests that hand blocks to an index
+ *  directly */
+class TestBlockIndexChain
+{
+public:
+    explicit TestBlockIndexChain(size_t nLength);
+    TestBlockIndexChain(const TestBlockIndexChain &) = delete;
+    TestBlockIndexChain &operator=(const TestBlockIndexChain &) = delete;
+
+    CBlockIndex *operator[](size_t nHeight) { return &indexes[nHeight]; }
+
+private:
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> indexes;
+};
+
 
 // create a pay to public key hash script
 CScript p2pkh(const CKeyID &dest);
@@ -0,0 +1,186 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "index/tokenindex.h"
+#include "script/scripttemplate.h"
+#include "test/test_nexa.h"
+#include "test/testutil.h"
+#include "undo.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(tokenindex_tests, TestingSetup)
+
+static CTokenSupply Supply(const TokenIndex &index, const CGroupTokenID &group)
+{
+    CTokenSupply supply;
+    BOOST_CHECK(index.GetSupply(group, supply));
+    return supply;
+}
+
+static std::vector<std::pair<uint256, Coin> > Unspent(const TokenIndex &index,
+    const CGroupTokenID &group,
+    bool fAuthorities = false,
+    const uint256 &after = uint256(),
+    size_t nMax = 100)
+{
+    std::vector<std::pair<uint256, Coin> > entries;
+    BOOST_CHECK(index.GetUnspent(group, fAuthorities, after, nMax, entries));
+    return entries;
+}
+
+BOOST_AUTO_TEST_CASE(connect_and_rewind)
+{
+    TokenIndex index(new TokenIndexDB(1 << 20, true, true));
+
+    const VchType argsHash(20, 1);
+    const CGroupTokenID group(GetRandHash());
+    std::vector<unsigned char> subgroupId = group.bytes();
+    subgroupId.push_back(7);
+    const CGroupTokenID subgroup(subgroupId);
+    const CAmount mintMelt = (CAmount)(GroupAuthorityFlags::AUTHORITY | GroupAuthorityFlags::MINT |
+                                       GroupAuthorityFlags::MELT | GroupAuthorityFlags::BATON);
+
+    TestBlockIndexChain indexes(2);
+
+    // Block 0: an authority, 100 tokens, 5 subgroup tokens and an ordinary output
+    CBlock block0;
+    block0.vtx.push_back(MakeTx({}, {CTxOut(COIN, P2pktOutput(argsHash, group, mintMelt)),
+                                        CTxOut(COIN, P2pktOutput(argsHash, group, 100)),
+                                        CTxOut(COIN, P2pktOutput(argsHash, subgroup, 5)),
+                                        CTxOut(COIN, P2pktOutput(argsHash))}));
+    BOOST_CHECK(index.WriteBlock(block0, CBlockUndo(), indexes[0]));
+    const CTransaction &tx0 = *block0.vtx[0];
+    const uint256 idem0 = tx0.GetIdem();
+
+    CTokenSupply supply = Supply(index, group);
+    BOOST_CHECK_EQUAL(supply.supply, 100);
+    BOOST_CHECK_EQUAL(supply.nUnspent, 1U);
+    BOOST_CHECK_EQUAL(supply.nAuthorities, 1U);
+    BOOST_CHECK_EQUAL(supply.nMintAuthorities, 1U);
+    BOOST_CHECK_EQUAL(supply.nMeltAuthorities, 1U);
+    BOOST_CHECK_EQUAL(Supply(index, subgroup).supply, 5);
+    BOOST_CHECK_EQUAL(Unspent(index, group, true).size(), 1U);
+
+    // Block 1: tx1 melts 40 of the 100 tokens into outputs of 50 and 10, and tx2 moves the 50 on. tx2 is placed
+    // first, as canonical ordering allows.
+    CBlock block1;
+    CTransactionRef tx1 = MakeTx({COutPoint(idem0, 1), COutPoint(idem0, 0)},
+        {CTxOut(COIN, P2pktOutput(argsHash, group, 50)), CTxOut(COIN, P2pktOutput(argsHash, group, 10)),
+            CTxOut(COIN, P2pktOutput(argsHash, group, mintMelt))});
+    CTransactionRef tx2 = MakeTx({COutPoint(tx1->GetIdem(), 0)}, {CTxOut(COIN, P2pktOutput(argsHash, group, 50))});
+    block1.vtx.push_back(MakeTx({}, {CTxOut(50 * COIN, P2pktOutput(argsHash))}));
+    block1.vtx.push_back(tx2);
+    block1.vtx.push_back(tx1);
+
+    CBlockUndo undo1;
+    undo1.vtxundo.resize(2);
+    undo1.vtxundo[0].vprevout.emplace_back(tx1->vout[0], 1, false);
+    undo1.vtxundo[1].vprevout.emplace_back(tx0.vout[1], 0, true);
+    undo1.vtxundo[1].vprevout.emplace_back(tx0.vout[0], 0, true);
+    BOOST_CHECK(index.WriteBlock(block1, undo1, indexes[1]));
+
+    supply = Supply(index, group);
+    BOOST_CHECK_EQUAL(supply.supply, 60);
+    BOOST_CHECK_EQUAL(supply.nUnspent, 2U);
+    BOOST_CHECK_EQUAL(supply.nAuthorities, 1U);
+
+    auto unspent = Unspent(index, group);
+    BOOST_CHECK_EQUAL(unspent.size(), 2U);
+    std::set<uint256> outpoints;
+    for (const auto &entry : unspent)
+    {
+        outpoints.insert(entry.first);
+        BOOST_CHECK_EQUAL(entry.second.nHeight, 1U);
+    }
+    BOOST_CHECK(outpoints.count(COutPoint(tx1->GetIdem(), 1).hash));
+    BOOST_CHECK(outpoints.count(COutPoint(tx2->GetIdem(), 0).hash));
+
+    // Paging continues after the last outpoint returned
+    auto page = Unspent(index, group, false, uint256(), 1);
+    BOOST_CHECK_EQUAL(page.size(), 1U);
+    auto rest = Unspent(index, group, false, page[0].first);
+    BOOST_CHECK_EQUAL(rest.size(), 1U);
+    BOOST_CHECK(rest[0].first != page[0].first);
+
+    auto authorities = Unspent(index, group, true);
+    BOOST_CHECK_EQUAL(authorities.size(), 1U);
+    BOOST_CHECK(authorities[0].first == COutPoint(tx1->GetIdem(), 2).hash);
+
+    // The subgroup is indexed on its own and was not touched
+    BOOST_CHECK_EQUAL(Unspent(index, subgroup).size(), 1U);
+
+    // Disconnecting block 1 restores the outputs of block 0
+    BOOST_CHECK(index.RewindBlock(block1, undo1, indexes[1]));
+
+    supply = Supply(index, group);
+    BOOST_CHECK_EQUAL(supply.supply, 100);
+    BOOST_CHECK_EQUAL(supply.nUnspent, 1U);
+    BOOST_CHECK_EQUAL(supply.nAuthorities, 1U);
+    unspent = Unspent(index, group);
+    BOOST_CHECK_EQUAL(unspent.size(), 1U);
+    BOOST_CHECK(unspent[0].first == COutPoint(idem0, 1).hash);
+    BOOST_CHECK(unspent[0].second.out == tx0.vout[1]);
+    BOOST_CHECK(unspent[0].second.IsCoinBase());
+    authorities = Unspent(index, group, true);
+    BOOST_CHECK_EQUAL(authorities.size(), 1U);
+    BOOST_CHECK(authorities[0].first == COutPoint(idem0, 0).hash);
+
+    // And disconnecting block 0 leaves nothing behind
+    BOOST_CHECK(index.RewindBlock(block0, CBlockUndo(), indexes[0]));
+    for (const CGroupTokenID &g : {group, subgroup})
+    {
+        supply = Supply(index, g);
+        BOOST_CHECK_EQUAL(supply.supply, 0);
+        BOOST_CHECK_EQUAL(supply.nUnspent, 0U);
+        BOOST_CHECK_EQUAL(supply.nAuthorities, 0U);
+        BOOST_CHECK(Unspent(index, g).empty());
+        BOOST_CHECK(Unspent(index, g, true).empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tokenindex_supply_beyond_amount)
+{
+    const CAmount nMax = std::numeric_limits<CAmount>::max();
+    CTokenSupply supply;
+    supply.AddSupply(nMax);
+    BOOST_CHECK(supply.SupplyFitsAmount());
+    BOOST_CHECK_EQUAL(supply.supply, nMax);
+
+    // Past the range of an amount the total stays exact
+    supply.AddSupply(nMax);
+    BOOST_CHECK(!supply.SupplyFitsAmount());
+    BOOST_CHECK_EQUAL(supply.SupplyToString(), "18446744073709551614");
+    supply.AddSupply(nMax);
+    supply.AddSupply(nMax);
+    BOOST_CHECK_EQUAL(supply.SupplyToString(), "36893488147419103228");
+
+    // and survives the database
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << supply;
+    CTokenSupply read;
+    ss >> read;
+    BOOST_CHECK_EQUAL(read.SupplyToString(), "36893488147419103228");
+
+    // Removing the tokens again comes back to 0
+    for (int i = 0; i < 3; i++)
+        read.AddSupply(-nMax);
+    BOOST_CHECK(read.SupplyFitsAmount());
+    BOOST_CHECK_EQUAL(read.supply, nMax);
+    read.AddSupply(-nMax);
+    BOOST_CHECK(read.SupplyFitsAmount());
+    BOOST_CHECK_EQUAL(read.supply, 0);
+    BOOST_CHECK_EQUAL(read.supplyHigh, 0);
+
+    // Negative totals, which a rewind may pass through, work the same way
+    read.AddSupply(-nMax);
+    read.AddSupply(-nMax);
+    read.AddSupply(-2);
+    BOOST_CHECK(!read.SupplyFitsAmount());
+    BOOST_CHECK_EQUAL(read.SupplyToString(), "-18446744073709551616");
+    read.AddSupply(5);
+    BOOST_CHECK_EQUAL(read.SupplyToString(), "-18446744073709551611");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -15,6 +15,7 @@
 #include "keystore.h"
 #include "main.h" // For CheckTransaction
 #include "policy/policy.h"
+#include "primitives/block.h"
 #include "script/script.h"
 #include "script/script_error.h"
 #include "test/scriptflags.h"
@@ -760,4 +761,98 @@ BOOST_AUTO_TEST_CASE(large_transaction_tests)
 #endif
 }
 
+static CMutableTransaction RandomSizedTx()
+{
+    CMutableTransaction tx = CreateRandomTx();
+    // Vary the scriptSig length across the compact size boundary
+    static const size_t sizes[] = {0, 1, 75, 252, 253, 600};
+    tx.vin.resize(1 + InsecureRandRange(3));
+    for (auto &in : tx.vin)
+    {
+        in.prevout.hash = InsecureRand256();
+        in.amount = InsecureRandRange(100) * CENT;
+        in.scriptSig = CScript();
+        size_t sz = sizes[InsecureRandRange(sizeof(sizes) / sizeof(sizes[0]))];
+        if (sz)
+            in.scriptSig << std::vector<unsigned char>(sz, InsecureRandBits(8));
+    }
+    tx.nLockTime = InsecureRandBits(32);
+    return tx;
+}
+
+BOOST_AUTO_TEST_CASE(deserialize_computes_ids)
+{
+    for (int i = 0; i < 200; i++)
+    {
+        CMutableTransaction mtx = RandomSizedTx();
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << mtx;
+        const size_t nSize = ss.size();
+        CTransaction tx(deserialize, ss);
+        BOOST_CHECK(ss.empty());
+        BOOST_CHECK(tx.GetId() == GetTxId(mtx));
+        BOOST_CHECK(tx.GetIdem() == GetTxIdem(mtx));
+        BOOST_CHECK_EQUAL(tx.GetTxSize(), nSize);
+        BOOST_CHECK_EQUAL(tx.GetTxSize(), ::GetSerializeSize(mtx, SER_NETWORK, PROTOCOL_VERSION));
+
+        // Copies keep the hashes of the original
+        CTransaction copy(tx);
+        BOOST_CHECK(copy.GetId() == tx.GetId());
+        BOOST_CHECK(copy.GetIdem() == tx.GetIdem());
+        BOOST_CHECK(CTransaction(mtx).GetId() == tx.GetId());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_block_deserialize)
+{
+    CBlock block;
+    block.nTime = 1234;
+    for (int i = 0; i < 3000; i++)
+        block.vtx.push_back(MakeTransactionRef(RandomSizedTx()));
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+    ss << uint32_t(0xdeadbeef);
+
+    // Reading the whole block picks the number of threads itself
+    {
+        CDataStream s(ss);
+        CBlock read;
+        s >> read;
+        BOOST_REQUIRE_EQUAL(read.vtx.size(), block.vtx.size());
+        for (size_t i = 0; i < block.vtx.size(); i++)
+            BOOST_CHECK(read.vtx[i]->GetId() == block.vtx[i]->GetId());
+        BOOST_CHECK(read.GetHash() == block.GetHash());
+        uint32_t trailer = 0;
+        s >> trailer;
+        BOOST_CHECK_EQUAL(trailer, 0xdeadbeef);
+        BOOST_CHECK(s.empty());
+    }
+
+    for (unsigned int nThreads : {1, 3, 8})
+    {
+        CDataStream s(ss);
+        CBlockHeader header;
+        s >> header;
+        uint64_t nTx = ReadCompactSize(s);
+        BOOST_REQUIRE_EQUAL(nTx, block.vtx.size());
+        std::vector<CTransactionRef> vtx;
+        UnserializeTransactions(s, nTx, vtx, nThreads);
+        BOOST_REQUIRE_EQUAL(vtx.size(), block.vtx.size());
+        for (size_t i = 0; i < block.vtx.size(); i++)
+        {
+            BOOST_CHECK(vtx[i]->GetId() == block.vtx[i]->GetId());
+            BOOST_CHECK(vtx[i]->GetIdem() == block.vtx[i]->GetIdem());
+            BOOST_CHECK_EQUAL(vtx[i]->GetTxSize(), block.vtx[i]->GetTxSize());
+        }
+        BOOST_CHECK_EQUAL(s.size(), sizeof(uint32_t));
+
+        // Truncated data fails the same way the serial path does
+        CDataStream t(ss.begin(), ss.end() - 100, SER_NETWORK, PROTOCOL_VERSION);
+        t >> header;
+        nTx = ReadCompactSize(t);
+        BOOST_CHECK_THROW(UnserializeTransactions(t, nTx, vtx, nThreads), std::ios_base::failure);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
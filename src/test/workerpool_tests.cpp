@@ -0,0 +1,84 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_nexa.h"
+#include "workerpool.h"
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(workerpool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(workerpool_run)
+{
+    CWorkerPool pool;
+    // Not started: every job runs on the calling thread
+    std::vector<std::thread::id> ids(100);
+    pool.Run(ids.size(), [&](size_t i) { ids[i] = std::this_thread::get_id(); });
+    for (const std::thread::id &id : ids)
+        BOOST_CHECK(id == std::this_thread::get_id());
+
+    pool.Start(4, "testworker");
+    BOOST_CHECK_EQUAL(pool.Size(), 4);
+    std::vector<std::atomic<int> > counts(10000);
+    pool.Run(counts.size(), [&](size_t i) { counts[i]++; });
+    for (const std::atomic<int> &count : counts)
+        BOOST_CHECK_EQUAL(count.load(), 1);
+
+    // A job may itself use the pool, since the thread that calls Run() takes part
+    std::atomic<int> total{0};
+    pool.Run(8, [&](size_t) { pool.Run(8, [&](size_t) { total++; }); });
+    BOOST_CHECK_EQUAL(total.load(), 64);
+
+    // The first exception is rethrown and the jobs that have not started are skipped
+    std::atomic<int> nRan{0};
+    BOOST_CHECK_THROW(pool.Run(1000,
+                          [&](size_t i) {
+                              nRan++;
+                              if (i == 0)
+                                  throw std::runtime_error("job failed");
+                          }),
+        std::runtime_error);
+    BOOST_CHECK(nRan.load() < 1000);
+
+    pool.Stop();
+    BOOST_CHECK_EQUAL(pool.Size(), 0);
+    total = 0;
+    pool.Run(8, [&](size_t) { total++; });
+    BOOST_CHECK_EQUAL(total.load(), 8);
+}
+
+BOOST_AUTO_TEST_CASE(workerpool_post)
+{
+    CWorkerPool pool;
+    std::atomic<int> nDone{0};
+    BOOST_CHECK(!pool.Post([&]() { nDone++; }, 10));
+
+    pool.Start(1, "testworker");
+    // Hold the only worker so that posted tasks stay queued
+    std::atomic<bool> fRelease{false};
+    BOOST_CHECK(pool.Post(
+        [&]() {
+            while (!fRelease.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        },
+        10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_CHECK(pool.Post([&]() { nDone++; }, 2));
+    BOOST_CHECK(pool.Post([&]() { nDone++; }, 2));
+    BOOST_CHECK(!pool.Post([&]() { nDone++; }, 2));
+    fRelease = true;
+    for (int i = 0; i < 1000 && nDone.load() < 2; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    BOOST_CHECK_EQUAL(nDone.load(), 2);
+
+    pool.Stop();
+    BOOST_CHECK(!pool.Post([&]() { nDone++; }, 10));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,186 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_nexa.h"
+#include "zmq/zmqpublishqueue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(zmq_publishqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(boundedqueue_order_and_capacity)
+{
+    CBoundedQueue<std::shared_ptr<int> > queue(5);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 8U);
+    BOOST_CHECK(queue.Empty());
+
+    std::shared_ptr<int> item;
+    BOOST_CHECK(!queue.TryPop(item));
+
+    for (int i = 0; i < 8; i++)
+        BOOST_CHECK(queue.TryPush(std::make_shared<int>(i)));
+    BOOST_CHECK(!queue.Empty());
+
+    // A full queue refuses the item and leaves it with the caller
+    std::shared_ptr<int> extra = std::make_shared<int>(8);
+    BOOST_CHECK(!queue.TryPush(std::move(extra)));
+    BOOST_CHECK(extra && *extra == 8);
+
+    // Go round the ring a few times, keeping it half full
+    for (int i = 0; i < 4; i++)
+    {
+        BOOST_CHECK(queue.TryPop(item));
+        BOOST_CHECK_EQUAL(*item, i);
+    }
+    for (int i = 8; i < 40; i++)
+    {
+        BOOST_CHECK(queue.TryPush(std::make_shared<int>(i)));
+        BOOST_CHECK(queue.TryPop(item));
+        BOOST_CHECK_EQUAL(*item, i - 4);
+    }
+    for (int i = 36; i < 40; i++)
+    {
+        BOOST_CHECK(queue.TryPop(item));
+        BOOST_CHECK_EQUAL(*item, i);
+    }
+    BOOST_CHECK(!queue.TryPop(item));
+    BOOST_CHECK(queue.Empty());
+
+    // Popped items are not kept alive by the queue
+    std::shared_ptr<int> held = std::make_shared<int>(1);
+    BOOST_CHECK(queue.TryPush(std::shared_ptr<int>(held)));
+    BOOST_CHECK(queue.TryPop(item));
+    item.reset();
+    BOOST_CHECK_EQUAL(held.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(boundedqueue_concurrent_producers)
+{
+    const int PRODUCERS = 4;
+    const int ITEMS = 20000;
+    CBoundedQueue<int> queue(64);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < ITEMS; i++)
+            {
+                while (!queue.TryPush(p * ITEMS + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Every item arrives exactly once, and the items of each producer arrive in the order they were pushed
+    std::vector<int> next(PRODUCERS, 0);
+    int received = 0;
+    while (received < PRODUCERS * ITEMS)
+    {
+        int item;
+        if (!queue.TryPop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const int p = item / ITEMS;
+        BOOST_REQUIRE(p >= 0 && p < PRODUCERS);
+        BOOST_REQUIRE_EQUAL(item % ITEMS, next[p]);
+        next[p]++;
+        received++;
+    }
+    for (std::thread &t : producers)
+        t.join();
+    BOOST_CHECK(queue.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(reservedqueue_keeps_room_for_urgent)
+{
+    CReservedQueue<int> queue(16, 4);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 16U);
+
+    // A flood of ordinary items, like transactions while the publisher is stalled, only gets the unreserved slots
+    int nOrdinary = 0;
+    while (queue.TryPush(int(nOrdinary), false))
+        nOrdinary++;
+    BOOST_CHECK_EQUAL(nOrdinary, 12);
+    BOOST_CHECK(!queue.TryPush(100, false));
+
+    // An urgent item, like a block, still gets in, until the reserve is used up too
+    for (int i = 0; i < 4; i++)
+        BOOST_CHECK(queue.TryPush(1000 + i, true));
+    BOOST_CHECK(!queue.TryPush(2000, true));
+    BOOST_CHECK(!queue.TryPush(101, false));
+
+    // Everything comes out in the order it went in, and popping frees ordinary slots again
+    int item;
+    for (int i = 0; i < nOrdinary; i++)
+    {
+        BOOST_CHECK(queue.TryPop(item));
+        BOOST_CHECK_EQUAL(item, i);
+    }
+    BOOST_CHECK(queue.TryPush(102, false));
+    for (int i = 0; i < 4; i++)
+    {
+        BOOST_CHECK(queue.TryPop(item));
+        BOOST_CHECK_EQUAL(item, 1000 + i);
+    }
+    BOOST_CHECK(queue.TryPop(item));
+    BOOST_CHECK_EQUAL(item, 102);
+    BOOST_CHECK(queue.Empty());
+
+    // At least one slot is left for ordinary items, however much is reserved
+    CReservedQueue<int> small(2, 5);
+    BOOST_CHECK(small.TryPush(1, false));
+    BOOST_CHECK(!small.TryPush(2, false));
+    BOOST_CHECK(small.TryPush(3, true));
+}
+
+BOOST_AUTO_TEST_CASE(reservedqueue_urgent_during_flood)
+{
+    const int PRODUCERS = 4;
+    const int ITEMS = 20000;
+    const int BLOCK = -1;
+    CReservedQueue<int> queue(256, 32);
+
+    // Producers flood the queue with transactions while nothing is taking them off, so most are dropped
+    std::atomic<int> nDropped{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&queue, &nDropped, p]() {
+            for (int i = 0; i < ITEMS; i++)
+            {
+                if (!queue.TryPush(p * ITEMS + i, false))
+                    nDropped++;
+            }
+        });
+    }
+    // A block arrives in the middle of the flood and is not dropped
+    BOOST_CHECK(queue.TryPush(int(BLOCK), true));
+    for (std::thread &t : producers)
+        t.join();
+    BOOST_CHECK(nDropped.load() > 0);
+
+    // The publisher sees the block once it catches up
+    int nBlocks = 0;
+    int nReceived = 0;
+    int item;
+    while (queue.TryPop(item))
+    {
+        if (item == BLOCK)
+            nBlocks++;
+        nReceived++;
+    }
+    BOOST_CHECK_EQUAL(nBlocks, 1);
+    BOOST_CHECK_EQUAL(nReceived + nDropped.load(), PRODUCERS * ITEMS + 1);
+    BOOST_CHECK(nReceived <= 256);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -150,6 +150,18 @@ void EnqueueTxForAdmission(CTxInputData &txd)
     TestConflictEnqueueTx(txd);
 }
 
+void EnqueueTxForAdmission(std::vector<CTxInputData> &vTxd)
+{
+    LOCK(csTxInQ);
+    for (CTxInputData &txd : vTxd)
+    {
+        if (txDeferQ.size() > 1000)
+            txDeferQ.push(txd);
+        else
+            TestConflictEnqueueTx(txd);
+    }
+}
+
 static void TestConflictEnqueueTx(CTxInputData &txd)
 {
     bool conflict = false;
@@ -484,9 +496,8 @@ void ThreadTxAdmission()
                             orphanpool.AddOrphanTx(tx, txd.nodeId);
 
                             // DoS prevention: do not allow mapOrphanTransactions to grow unbounded
-                            const uint64_t nMaxOrphanPoolSize = maxTxPool.Value() * ONE_MEGABYTE / 10;
-                            unsigned int nEvicted =
-                                orphanpool.LimitOrphanTxSize(maxOrphanPool.Value(), nMaxOrphanPoolSize);
+                            unsigned int nEvicted = orphanpool.LimitOrphanTxSize(
+                                maxOrphanPool.Value(), CTxOrphanPool::MaxOrphanPoolBytes());
                             if (nEvicted > 0)
                                 LOG(MEMPOOL, "mapOrphan overflow, removed %u tx\n", nEvicted);
                         }
@@ -923,10 +934,11 @@ bool ParallelAcceptToMemoryPool(Snapshot &ss,
             }
         }
 
-        // Check that input script constraints are satisfied
+        // Check that input script constraints are satisfied. Both script checks below share the signature hash parts.
+        PrecomputedTransactionDataRef txdata = std::make_shared<const PrecomputedTransactionData>(*tx);
         unsigned char sighashType = 0;
-        if (!CheckInputs(
-                tx, state, view, true, flags, true, &resourceTracker, chainparams, nullptr, &sighashType, debugger))
+        if (!CheckInputs(tx, state, view, true, flags, true, &resourceTracker, chainparams, nullptr, &sighashType,
+                debugger, txdata))
         {
             if (debugger && debugger->InputsCheck1IsValid())
             {
@@ -1093,7 +1105,7 @@ bool ParallelAcceptToMemoryPool(Snapshot &ss,
         // can be exploited as a DoS attack.
         unsigned char sighashType2 = 0;
         if (!CheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS | featureFlags, true, nullptr,
-                chainparams, nullptr, &sighashType2, debugger))
+                chainparams, nullptr, &sighashType2, debugger, txdata))
         {
             if (debugger && debugger->InputsCheck1IsValid())
             {
@@ -1179,65 +1191,23 @@ TransactionClass ParseTransactionClass(const std::string &s)
 
 void ProcessOrphans(std::vector<CTransactionRef> &vWorkQueue)
 {
-    // Recursively process any orphan transactions that depended on this one.
     // NOTE: you must not return early since EraseOrphansByTime() must always be checked
-    std::map<uint256, CTxInputData> mapEnqueue;
-    {
-        READLOCK(orphanpool.cs_orphanpool);
-        for (unsigned int i = 0; i < vWorkQueue.size(); i++)
-        {
-            CTransactionRef tx = vWorkQueue[i];
-            for (unsigned int j = 0; j < tx->vout.size(); j++)
-            {
-                std::map<uint256, std::set<uint256> >::iterator itByPrev =
-                    orphanpool.mapOrphanTransactionsByPrev.find(tx->OutpointAt(j).hash);
-                if (itByPrev == orphanpool.mapOrphanTransactionsByPrev.end())
-                    continue;
-                //            for (std::set<uint256>::iterator mi = itByPrev->second.begin(); mi !=
-                //            itByPrev->second.end(); ++mi)
-                for (const auto &orphanHash : itByPrev->second)
-                {
-                    // Make sure we actually have an entry on the orphan cache. While this should never fail because
-                    // we always erase orphans and any mapOrphanTransactionsByPrev at the same time, still we need to
-                    // be sure.
-                    bool fOk = true;
-                    std::map<uint256, CTxOrphanPool::COrphanTx>::iterator iter =
-                        orphanpool.mapOrphanTransactions.find(orphanHash);
-                    DbgAssert(iter != orphanpool.mapOrphanTransactions.end(), fOk = false);
-                    if (!fOk)
-                        continue;
+    orphanpool.EraseOrphansByTime();
 
-                    {
-                        CTxInputData txd;
-                        txd.tx = iter->second.ptx;
-                        txd.nodeId = iter->second.fromPeer;
-                        txd.nodeName = "orphan";
-                        LOG(MEMPOOL, "Resubmitting orphan tx: %s\n", orphanHash.ToString());
-                        mapEnqueue.emplace(std::move(orphanHash), std::move(txd));
-                    }
-                }
-            }
-        }
-    }
+    // Every orphan that this batch of transactions unblocks is taken out of the orphan pool in one pass, so that no
+    // other thread can enqueue it a second time, and then all of them are handed to the admission threads together.
+    std::vector<CTxOrphanPool::COrphanTx> vOrphans = orphanpool.TakeOrphansSpending(vWorkQueue);
+    if (vOrphans.empty())
+        return;
 
-    // First delete the orphans before enqueuing them otherwise we may end up putting them
-    // in the queue twice.
-    orphanpool.EraseOrphansByTime();
-    if (!mapEnqueue.empty())
+    std::vector<CTxInputData> vTxd(vOrphans.size());
+    for (size_t i = 0; i < vOrphans.size(); i++)
     {
-        {
-            WRITELOCK(orphanpool.cs_orphanpool);
-            for (auto it = mapEnqueue.begin(); it != mapEnqueue.end(); it++)
-            {
-                // If the orphan was not erased then it must already have been erased/enqueued by another thread
-                // so do not enqueue this orphan again.
-                if (!orphanpool.EraseOrphanTx(it->first))
-                    it = mapEnqueue.erase(it);
-            }
-        }
-        for (auto &it : mapEnqueue)
-            EnqueueTxForAdmission(it.second);
+        vTxd[i].tx = vOrphans[i].ptx;
+        vTxd[i].nodeId = vOrphans[i].fromPeer;
+        vTxd[i].nodeName = "orphan";
     }
+    EnqueueTxForAdmission(vTxd);
 }
 
 
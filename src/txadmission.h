@@ -156,6 +156,8 @@ void FlushTxAdmission();
 
 /// Put the tx on the tx admission queue for processing
 void EnqueueTxForAdmission(CTxInputData &txd);
+/// Put a batch of tx on the tx admission queue, taking the queue lock once
+void EnqueueTxForAdmission(std::vector<CTxInputData> &vTxd);
 
 /** (try to) add transaction to memory pool **/
 bool AcceptToMemoryPool(CTxMemPool &pool,
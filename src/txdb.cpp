@@ -25,12 +25,20 @@ static const char DB_TXINDEX = 't';
 static const char DB_TXIDEM_INDEX = 'i';
 static const char DB_OUTPOINT_INDEX = 'p';
 static const char DB_TXINDEX_BLOCK = 'T';
+static const char DB_ADDRESS_HISTORY = 'h';
+static const char DB_ADDRESS_UNSPENT = 'u';
+static const char DB_ADDRESS_BALANCE = 's';
+static const char DB_BLOCK_FILTER = 'f';
+static const char DB_TOKEN_UNSPENT = 'g';
+static const char DB_TOKEN_AUTHORITY = 'a';
+static const char DB_TOKEN_SUPPLY = 'q';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_BLOCK_INDEX_SNAPSHOT = 'N';
 
 
 namespace
@@ -78,6 +86,27 @@ bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const
     return db.Exists(CoinEntry(&outpoint));
 }
 
+void CCoinsViewDB::GetCoins(const std::vector<COutPoint> &outpoints,
+    std::vector<Coin> &coins,
+    std::vector<bool> &found) const
+{
+    coins.resize(outpoints.size());
+    found.assign(outpoints.size(), false);
+
+    READLOCK(cs_utxo);
+    std::unique_ptr<CDBIterator> pcursor(const_cast<CDBWrapper &>(db).NewIterator());
+    COutPoint key;
+    for (size_t i = 0; i < outpoints.size(); i++)
+    {
+        pcursor->Seek(CoinEntry(&outpoints[i]));
+        if (!pcursor->Valid())
+            continue;
+        CoinEntry entry(&key);
+        if (pcursor->GetKey(entry) && entry.key == DB_COIN && key == outpoints[i])
+            found[i] = pcursor->GetValue(coins[i]);
+    }
+}
+
 uint256 CCoinsViewDB::GetBestBlock() const
 {
     READLOCK(cs_utxo);
@@ -375,6 +404,10 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue)
     return true;
 }
 
+bool CBlockTreeDB::WriteBlockIndexSnapshotId(const uint256 &id) { return Write(DB_BLOCK_INDEX_SNAPSHOT, id, true); }
+bool CBlockTreeDB::ReadBlockIndexSnapshotId(uint256 &id) { return Read(DB_BLOCK_INDEX_SNAPSHOT, id); }
+bool CBlockTreeDB::EraseBlockIndexSnapshotId() { return Erase(DB_BLOCK_INDEX_SNAPSHOT, true); }
+
 bool CBlockTreeDB::FindBlockIndex(uint256 blockhash, CDiskBlockIndex *pindex)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
@@ -730,10 +763,43 @@ CacheConfig CacheSizeCalculations(int64_t _nTotalCache)
         cache.nCoinDBCache /= 2;
         cache.nTxIndexCache = cache.nCoinDBCache;
     }
+    if (!GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX))
+    {
+        cache.nAddressIndexCache = 0;
+    }
+    else
+    {
+        // The address index gets its own slice of the remainder rather than a share of the utxo disk cache.
+        // Its lookups are by scripthash prefix so a modest cache covers the hot part of the index.
+        cache.nAddressIndexCache = std::min(_nTotalCache / 8, (int64_t)(512 << 20));
+    }
+    if (!GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+    {
+        cache.nBlockFilterIndexCache = 0;
+    }
+    else
+    {
+        // Filters are written once and read sequentially, so the index needs far less cache than the others.
+        cache.nBlockFilterIndexCache = std::min(cache.nCoinDBCache / 8, (int64_t)(64 << 20));
+        cache.nCoinDBCache -= cache.nBlockFilterIndexCache;
+    }
+    if (!GetBoolArg("-tokenindex", DEFAULT_TOKENINDEX))
+    {
+        cache.nTokenIndexCache = 0;
+    }
+    else
+    {
+        // Only token outputs are indexed, which are a small part of the utxo set.
+        cache.nTokenIndexCache = std::min(cache.nCoinDBCache / 4, (int64_t)(256 << 20));
+        cache.nCoinDBCache -= cache.nTokenIndexCache;
+    }
 
     // the remainder goes to the global in-memory utxo coins cache max size
     _nTotalCache -= cache.nCoinDBCache;
     _nTotalCache -= cache.nTxIndexCache;
+    _nTotalCache -= cache.nAddressIndexCache;
+    _nTotalCache -= cache.nBlockFilterIndexCache;
+    _nTotalCache -= cache.nTokenIndexCache;
     nCoinCacheMaxSize = _nTotalCache;
 
     return cache;
@@ -1015,3 +1081,309 @@ bool TxIndexDB::MigrateData(CBlockTreeDB &block_tree_db, const CBlockLocator &be
     LOGA("[COMPLETED txindex upgrade].\n");
     return true;
 }
+
+AddressIndexDB::AddressIndexDB(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : CDBWrapper(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{
+}
+
+bool AddressIndexDB::ReadBalance(const uint256 &scripthash, CAddressBalance &balance) const
+{
+    if (!Read(std::make_pair(DB_ADDRESS_BALANCE, scripthash), balance))
+    {
+        balance = CAddressBalance();
+    }
+    return true;
+}
+
+/** Read up to nMax history entries of start.scripthash from the key start on, skipping start itself if fAfter */
+static bool ReadHistoryFrom(AddressIndexDB &db,
+    const CAddressHistoryKey &start,
+    bool fAfter,
+    size_t nMax,
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries)
+{
+    const uint256 &scripthash = start.scripthash;
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(std::make_pair(DB_ADDRESS_HISTORY, start));
+
+    std::pair<char, CAddressHistoryKey> key;
+    while (pcursor->Valid() && entries.size() < nMax)
+    {
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESS_HISTORY || key.second.scripthash != scripthash)
+            break;
+        if (fAfter && key.second.height == start.height && key.second.txhash == start.txhash &&
+            key.second.index == start.index && key.second.fSpend == start.fSpend)
+        {
+            pcursor->Next();
+            continue;
+        }
+
+        CAddressHistoryValue value;
+        if (!pcursor->GetValue(value))
+            return error("%s: failed to read address history value", __func__);
+        entries.emplace_back(key.second, value);
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool AddressIndexDB::ReadHistory(const uint256 &scripthash,
+    uint32_t nFromHeight,
+    size_t nMax,
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const
+{
+    return ReadHistoryFrom(
+        *const_cast<AddressIndexDB *>(this), CAddressHistoryKey(scripthash, nFromHeight), false, nMax, entries);
+}
+
+bool AddressIndexDB::ReadHistory(const CAddressHistoryKey &after,
+    size_t nMax,
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const
+{
+    return ReadHistoryFrom(*const_cast<AddressIndexDB *>(this), after, true, nMax, entries);
+}
+
+bool AddressIndexDB::ReadHistoryEntry(const CAddressHistoryKey &key, CAddressHistoryValue &value) const
+{
+    return Read(std::make_pair(DB_ADDRESS_HISTORY, key), value);
+}
+
+bool AddressIndexDB::ReadUnspent(const uint256 &scripthash,
+    const uint256 &after,
+    size_t nMax,
+    std::vector<std::pair<uint256, CAddressUnspentValue> > &entries) const
+{
+    std::unique_ptr<CDBIterator> pcursor(const_cast<AddressIndexDB *>(this)->NewIterator());
+    pcursor->Seek(std::make_pair(DB_ADDRESS_UNSPENT, std::make_pair(scripthash, after)));
+
+    std::pair<char, std::pair<uint256, uint256> > key;
+    while (pcursor->Valid() && entries.size() < nMax)
+    {
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESS_UNSPENT || key.second.first != scripthash)
+            break;
+        if (key.second.second == after && !after.IsNull())
+        {
+            pcursor->Next();
+            continue;
+        }
+
+        CAddressUnspentValue value;
+        if (!pcursor->GetValue(value))
+            return error("%s: failed to read address unspent value", __func__);
+        entries.emplace_back(key.second.second, value);
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool AddressIndexDB::ReadUnspentEntry(const uint256 &scripthash,
+    const uint256 &outpoint,
+    CAddressUnspentValue &value) const
+{
+    return Read(std::make_pair(DB_ADDRESS_UNSPENT, std::make_pair(scripthash, outpoint)), value);
+}
+
+bool AddressIndexDB::WriteUpdate(const CAddressIndexUpdate &update, const CBlockLocator &locator)
+{
+    CDBBatch batch(*this);
+    for (const auto &key : update.historyErase)
+    {
+        batch.Erase(std::make_pair(DB_ADDRESS_HISTORY, key));
+    }
+    for (const auto &entry : update.historyWrite)
+    {
+        batch.Write(std::make_pair(DB_ADDRESS_HISTORY, entry.first), entry.second);
+    }
+    for (const auto &key : update.unspentErase)
+    {
+        batch.Erase(std::make_pair(DB_ADDRESS_UNSPENT, key));
+    }
+    for (const auto &entry : update.unspentWrite)
+    {
+        batch.Write(std::make_pair(DB_ADDRESS_UNSPENT, entry.first), entry.second);
+    }
+    for (const auto &entry : update.balances)
+    {
+        if (entry.second.nHistory == 0)
+            batch.Erase(std::make_pair(DB_ADDRESS_BALANCE, entry.first));
+        else
+            batch.Write(std::make_pair(DB_ADDRESS_BALANCE, entry.first), entry.second);
+    }
+    batch.Write(DB_BEST_BLOCK, locator);
+    return WriteBatch(batch);
+}
+
+bool AddressIndexDB::ReadBestBlock(CBlockLocator &locator) const
+{
+    bool success = Read(DB_BEST_BLOCK, locator);
+    if (!success)
+    {
+        locator.SetNull();
+    }
+    return success;
+}
+
+bool AddressIndexDB::WriteBestBlock(const CBlockLocator &locator) { return Write(DB_BEST_BLOCK, locator); }
+
+BlockFilterIndexDB::BlockFilterIndexDB(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : CDBWrapper(GetDataDir() / "indexes" / "blockfilter" / "basic", n_cache_size, f_memory, f_wipe)
+{
+}
+
+bool BlockFilterIndexDB::ReadFilter(const uint256 &blockhash, CBlockFilterEntry &entry) const
+{
+    return Read(std::make_pair(DB_BLOCK_FILTER, blockhash), entry);
+}
+
+bool BlockFilterIndexDB::WriteFilter(const uint256 &blockhash,
+    const CBlockFilterEntry &entry,
+    const CBlockLocator &locator)
+{
+    CDBBatch batch(*this);
+    batch.Write(std::make_pair(DB_BLOCK_FILTER, blockhash), entry);
+    batch.Write(DB_BEST_BLOCK, locator);
+    return WriteBatch(batch);
+}
+
+bool BlockFilterIndexDB::ReadBestBlock(CBlockLocator &locator) const
+{
+    bool success = Read(DB_BEST_BLOCK, locator);
+    if (!success)
+    {
+        locator.SetNull();
+    }
+    return success;
+}
+
+bool BlockFilterIndexDB::WriteBestBlock(const CBlockLocator &locator) { return Write(DB_BEST_BLOCK, locator); }
+
+void CTokenSupply::AddSupply(CAmount n)
+{
+    const uint64_t nLow = (uint64_t)supply;
+    const uint64_t nNewLow = nLow + (uint64_t)n;
+    // A negative n adds n + 2^64 to the low word, so 2^64 is taken back from the high word
+    if (n < 0)
+        supplyHigh--;
+    if (nNewLow < nLow)
+        supplyHigh++;
+    supply = (CAmount)nNewLow;
+}
+
+std::string CTokenSupply::SupplyToString() const
+{
+    if (SupplyFitsAmount())
+        return std::to_string(supply);
+
+    // Negate a negative total, then divide the magnitude by 10 repeatedly, 32 bits at a time
+    uint64_t nLow = (uint64_t)supply;
+    uint64_t nHigh = (uint64_t)supplyHigh;
+    const bool fNegative = supplyHigh < 0;
+    if (fNegative)
+    {
+        nLow = ~nLow + 1;
+        nHigh = ~nHigh + (nLow == 0 ? 1 : 0);
+    }
+    uint32_t limbs[4] = {(uint32_t)(nHigh >> 32), (uint32_t)nHigh, (uint32_t)(nLow >> 32), (uint32_t)nLow};
+    std::string strDigits;
+    while (limbs[0] || limbs[1] || limbs[2] || limbs[3])
+    {
+        uint64_t nRemainder = 0;
+        for (uint32_t &limb : limbs)
+        {
+            const uint64_t nCur = (nRemainder << 32) | limb;
+            limb = nCur / 10;
+            nRemainder = nCur % 10;
+        }
+        strDigits.push_back('0' + nRemainder);
+    }
+    if (fNegative)
+        strDigits.push_back('-');
+    return std::string(strDigits.rbegin(), strDigits.rend());
+}
+
+TokenIndexDB::TokenIndexDB(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : CDBWrapper(GetDataDir() / "indexes" / "tokenindex", n_cache_size, f_memory, f_wipe)
+{
+}
+
+bool TokenIndexDB::ReadSupply(const std::vector<unsigned char> &group, CTokenSupply &supply) const
+{
+    if (!Read(std::make_pair(DB_TOKEN_SUPPLY, group), supply))
+    {
+        supply = CTokenSupply();
+    }
+    return true;
+}
+
+bool TokenIndexDB::ReadUnspent(const std::vector<unsigned char> &group,
+    bool fAuthorities,
+    const uint256 &after,
+    size_t nMax,
+    std::vector<std::pair<uint256, Coin> > &entries) const
+{
+    const char prefix = fAuthorities ? DB_TOKEN_AUTHORITY : DB_TOKEN_UNSPENT;
+    std::unique_ptr<CDBIterator> pcursor(const_cast<TokenIndexDB *>(this)->NewIterator());
+    pcursor->Seek(std::make_pair(prefix, CTokenOutputKey(group, after)));
+
+    std::pair<char, CTokenOutputKey> key;
+    while (pcursor->Valid() && entries.size() < nMax)
+    {
+        if (!pcursor->GetKey(key) || key.first != prefix || key.second.first != group)
+            break;
+        if (key.second.second == after && !after.IsNull())
+        {
+            pcursor->Next();
+            continue;
+        }
+
+        Coin coin;
+        if (!pcursor->GetValue(coin))
+            return error("%s: failed to read token index value", __func__);
+        entries.emplace_back(key.second.second, std::move(coin));
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool TokenIndexDB::WriteUpdate(const CTokenIndexUpdate &update, const CBlockLocator &locator)
+{
+    CDBBatch batch(*this);
+    for (const auto &key : update.unspentErase)
+    {
+        batch.Erase(std::make_pair(DB_TOKEN_UNSPENT, key));
+    }
+    for (const auto &entry : update.unspentWrite)
+    {
+        batch.Write(std::make_pair(DB_TOKEN_UNSPENT, entry.first), entry.second);
+    }
+    for (const auto &key : update.authorityErase)
+    {
+        batch.Erase(std::make_pair(DB_TOKEN_AUTHORITY, key));
+    }
+    for (const auto &entry : update.authorityWrite)
+    {
+        batch.Write(std::make_pair(DB_TOKEN_AUTHORITY, entry.first), entry.second);
+    }
+    for (const auto &entry : update.supplies)
+    {
+        if (entry.second.nUnspent == 0 && entry.second.nAuthorities == 0)
+            batch.Erase(std::make_pair(DB_TOKEN_SUPPLY, entry.first));
+        else
+            batch.Write(std::make_pair(DB_TOKEN_SUPPLY, entry.first), entry.second);
+    }
+    batch.Write(DB_BEST_BLOCK, locator);
+    return WriteBatch(batch);
+}
+
+bool TokenIndexDB::ReadBestBlock(CBlockLocator &locator) const
+{
+    bool success = Read(DB_BEST_BLOCK, locator);
+    if (!success)
+    {
+        locator.SetNull();
+    }
+    return success;
+}
+
+bool TokenIndexDB::WriteBestBlock(const CBlockLocator &locator) { return Write(DB_BEST_BLOCK, locator); }
@@ -24,6 +24,9 @@ class uint256;
 extern CTweak<uint64_t> dbcacheTweak;
 
 static const bool DEFAULT_TXINDEX = false;
+static const bool DEFAULT_ADDRESSINDEX = false;
+static const bool DEFAULT_BLOCKFILTERINDEX = false;
+static const bool DEFAULT_TOKENINDEX = false;
 
 //! The max allowed size of the in memory UTXO cache which can also be dynamically adjusted
 //! (if it has been configured) based on the current availability of memory.
@@ -61,6 +64,9 @@ uint64_t GetTotalSystemMemory();
  * @param nBlockUndoDBCache   The total database size for the block undo read/write caches, used in blocksdb
  * @param nBlockTreeDBCache   The total database size for the block index read/write caches
  * @param nBlockTxIndexCache  The total database size for the transaction index read/write caches
+ * @param nAddressIndexCache  The total database size for the address (scripthash) index read/write caches
+ * @param nBlockFilterIndexCache The total database size for the compact block filter index read/write caches
+ * @param nTokenIndexCache    The total database size for the token group index read/write caches
  * @param nCoinDBCache        The total database size for the on disk utxo read/write caches
  * NOTE: the UTXO in memory cache size is a global var and so is not held in this struct
  */
@@ -70,9 +76,16 @@ struct CacheConfig
     int64_t nBlockUndoDBCache;
     int64_t nBlockTreeDBCache;
     int64_t nTxIndexCache;
+    int64_t nAddressIndexCache;
+    int64_t nBlockFilterIndexCache;
+    int64_t nTokenIndexCache;
     int64_t nCoinDBCache;
 
-    CacheConfig() : nBlockDBCache(0), nBlockUndoDBCache(0), nBlockTreeDBCache(0), nTxIndexCache(0), nCoinDBCache(0) {}
+    CacheConfig()
+        : nBlockDBCache(0), nBlockUndoDBCache(0), nBlockTreeDBCache(0), nTxIndexCache(0), nAddressIndexCache(0),
+          nBlockFilterIndexCache(0), nTokenIndexCache(0), nCoinDBCache(0)
+    {
+    }
 };
 
 /** Discover the sizes for each of the caches. This is done during init.cpp on startup but also
@@ -133,6 +146,10 @@ public:
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
+    //! Reads every coin through one database iterator, so the batch sees a single consistent state of the database
+    void GetCoins(const std::vector<COutPoint> &outpoints,
+        std::vector<Coin> &coins,
+        std::vector<bool> &found) const override;
     uint256 GetBestBlock() const;
     uint256 _GetBestBlock() const override;
     uint256 GetBestBlock(BlockDBMode mode) const;
@@ -198,6 +215,9 @@ public:
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool WriteBlockIndexSnapshotId(const uint256 &id);
+    bool ReadBlockIndexSnapshotId(uint256 &id);
+    bool EraseBlockIndexSnapshotId();
     bool FindBlockIndex(uint256 blockhash, CDiskBlockIndex *index);
     bool LoadBlockIndexGuts();
     bool GetSortedHashIndex(std::vector<std::pair<int, CDiskBlockIndex> > &hashesByHeight);
@@ -244,4 +264,321 @@ public:
     /// been upgraded yet to the new database.
     bool MigrateData(CBlockTreeDB &block_tree_db, const CBlockLocator &best_locator);
 };
+
+/** One entry in the history of a scripthash: either an output paying to the script (funding) or an input
+ *  spending such an output. The height is serialized big endian so that a database cursor walks the history
+ *  of a scripthash in block order.
+ */
+struct CAddressHistoryKey
+{
+    uint256 scripthash;
+    uint32_t height;
+    uint256 txhash; // idem of the funding tx, or id of the spending tx
+    uint32_t index; // output index when funding, input index when spending
+    bool fSpend;
+
+    CAddressHistoryKey() : height(0), index(0), fSpend(false) {}
+    CAddressHistoryKey(const uint256 &_scripthash, uint32_t _height)
+        : scripthash(_scripthash), height(_height), index(0), fSpend(false)
+    {
+    }
+    CAddressHistoryKey(const uint256 &_scripthash,
+        uint32_t _height,
+        const uint256 &_txhash,
+        uint32_t _index,
+        bool _fSpend)
+        : scripthash(_scripthash), height(_height), txhash(_txhash), index(_index), fSpend(_fSpend)
+    {
+    }
+
+    template <typename Stream>
+    void Serialize(Stream &s) const
+    {
+        s << scripthash;
+        ser_writedata32be(s, height);
+        s << txhash;
+        ser_writedata32be(s, index);
+        ser_writedata8(s, fSpend ? 1 : 0);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream &s)
+    {
+        s >> scripthash;
+        height = ser_readdata32be(s);
+        s >> txhash;
+        index = ser_readdata32be(s);
+        fSpend = ser_readdata8(s) != 0;
+    }
+};
+
+/** The value of a history entry. Spending entries also carry the location of the output they spent so that the
+ *  unspent output can be restored when the spending block is disconnected.
+ */
+struct CAddressHistoryValue
+{
+    CAmount amount; // positive when funding, negative when spending
+    uint256 prevIdem;
+    uint32_t prevN;
+    uint32_t prevHeight;
+
+    CAddressHistoryValue() : amount(0), prevN(0), prevHeight(0) {}
+    explicit CAddressHistoryValue(CAmount _amount) : amount(_amount), prevN(0), prevHeight(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(amount);
+        if (amount < 0)
+        {
+            READWRITE(prevIdem);
+            READWRITE(prevN);
+            READWRITE(prevHeight);
+        }
+    }
+};
+
+/** An unspent output paying to a scripthash, keyed by (scripthash, outpoint hash) */
+struct CAddressUnspentValue
+{
+    uint256 txidem;
+    uint32_t n;
+    uint32_t height;
+    CAmount amount;
+
+    CAddressUnspentValue() : n(0), height(0), amount(0) {}
+    CAddressUnspentValue(const uint256 &_txidem, uint32_t _n, uint32_t _height, CAmount _amount)
+        : txidem(_txidem), n(_n), height(_height), amount(_amount)
+    {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(txidem);
+        READWRITE(n);
+        READWRITE(height);
+        READWRITE(amount);
+    }
+};
+
+/** Running totals for a scripthash so that balance queries are a single database read */
+struct CAddressBalance
+{
+    CAmount received;
+    CAmount balance;
+    uint64_t nHistory;
+    uint64_t nUnspent;
+
+    CAddressBalance() : received(0), balance(0), nHistory(0), nUnspent(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(received);
+        READWRITE(balance);
+        READWRITE(nHistory);
+        READWRITE(nUnspent);
+    }
+};
+
+/** All the database changes needed to connect or disconnect one block, written as a single batch */
+struct CAddressIndexUpdate
+{
+    std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > historyWrite;
+    std::vector<CAddressHistoryKey> historyErase;
+    std::vector<std::pair<std::pair<uint256, uint256>, CAddressUnspentValue> > unspentWrite;
+    std::vector<std::pair<uint256, uint256> > unspentErase;
+    std::map<uint256, CAddressBalance> balances;
+};
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ *
+ * Maps the Electrum-style scripthash (sha256 of the output script) of every output in the active chain to its
+ * history, its unspent outputs and its running balance. Like the TxIndexDB it stores the block locator of the
+ * chain the database is synced to.
+ */
+class AddressIndexDB : public CDBWrapper
+{
+public:
+    explicit AddressIndexDB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the running totals for a scripthash. Returns an empty balance if the scripthash was never seen.
+    bool ReadBalance(const uint256 &scripthash, CAddressBalance &balance) const;
+
+    /// Read up to nMax history entries of a scripthash starting at block height nFromHeight, in block order.
+    bool ReadHistory(const uint256 &scripthash,
+        uint32_t nFromHeight,
+        size_t nMax,
+        std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const;
+
+    /// Read up to nMax history entries of after.scripthash that come after the entry "after", in block order.
+    /// The key of the last entry of a page continues the history where the page ended (for paging).
+    bool ReadHistory(const CAddressHistoryKey &after,
+        size_t nMax,
+        std::vector<std::pair<CAddressHistoryKey, CAddressHistoryValue> > &entries) const;
+
+    /// Read one history entry
+    bool ReadHistoryEntry(const CAddressHistoryKey &key, CAddressHistoryValue &value) const;
+
+    /// Read up to nMax unspent outputs of a scripthash, starting after the outpoint hash "after" (for paging).
+    bool ReadUnspent(const uint256 &scripthash,
+        const uint256 &after,
+        size_t nMax,
+        std::vector<std::pair<uint256, CAddressUnspentValue> > &entries) const;
+
+    /// Read one unspent output of a scripthash
+    bool ReadUnspentEntry(const uint256 &scripthash, const uint256 &outpoint, CAddressUnspentValue &value) const;
+
+    /// Atomically apply the changes for one block along with the new best block locator.
+    bool WriteUpdate(const CAddressIndexUpdate &update, const CBlockLocator &locator);
+
+    /// Read block locator of the chain that the address index is in sync with.
+    bool ReadBestBlock(CBlockLocator &locator) const;
+
+    /// Write block locator of the chain that the address index is in sync with.
+    bool WriteBestBlock(const CBlockLocator &locator);
+};
+
+/** One compact block filter as stored in the block filter index */
+struct CBlockFilterEntry
+{
+    uint256 filterHash;
+    uint256 header;
+    std::vector<unsigned char> filter;
+
+    CBlockFilterEntry() {}
+    CBlockFilterEntry(const uint256 &_filterHash, const uint256 &_header, const std::vector<unsigned char> &_filter)
+        : filterHash(_filterHash), header(_header), filter(_filter)
+    {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(filterHash);
+        READWRITE(header);
+        READWRITE(filter);
+    }
+};
+
+/**
+ * Access to the compact block filter index database (indexes/blockfilter/basic/)
+ *
+ * Filters are keyed by block hash rather than height, so the filters of blocks that were reorganized out of the
+ * active chain stay valid and never have to be erased. Like the TxIndexDB it stores the block locator of the chain
+ * the database is synced to.
+ */
+class BlockFilterIndexDB : public CDBWrapper
+{
+public:
+    explicit BlockFilterIndexDB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the filter, filter hash and filter header of a block. Returns false if the block is not indexed.
+    bool ReadFilter(const uint256 &blockhash, CBlockFilterEntry &entry) const;
+
+    /// Atomically write the filter of one block along with the new best block locator.
+    bool WriteFilter(const uint256 &blockhash, const CBlockFilterEntry &entry, const CBlockLocator &locator);
+
+    /// Read block locator of the chain that the block filter index is in sync with.
+    bool ReadBestBlock(CBlockLocator &locator) const;
+
+    /// Write block locator of the chain that the block filter index is in sync with.
+    bool WriteBestBlock(const CBlockLocator &locator);
+};
+
+/** Running totals of a token group (or subgroup) over its unspent outputs in the active chain, so that supply
+ *  queries are a single database read */
+struct CTokenSupply
+{
+    //! Tokens held by the outputs that are not authorities.  Together the outputs of a group can hold more tokens
+    //! than a CAmount can count, so the total is a 128 bit number: supplyHigh * 2^64 + (uint64_t)supply.
+    CAmount supply;
+    int64_t supplyHigh;
+    uint64_t nUnspent; // unspent outputs holding tokens
+    uint64_t nAuthorities; // unspent authority outputs
+    uint64_t nMintAuthorities;
+    uint64_t nMeltAuthorities;
+
+    CTokenSupply()
+        : supply(0), supplyHigh(0), nUnspent(0), nAuthorities(0), nMintAuthorities(0), nMeltAuthorities(0)
+    {
+    }
+
+    /** Add n tokens to the total, or remove them if n is negative */
+    void AddSupply(CAmount n);
+    /** Whether the total fits in supply on its own */
+    bool SupplyFitsAmount() const { return supplyHigh == (supply < 0 ? -1 : 0); }
+    /** The total in decimal */
+    std::string SupplyToString() const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action)
+    {
+        READWRITE(supply);
+        READWRITE(supplyHigh);
+        READWRITE(nUnspent);
+        READWRITE(nAuthorities);
+        READWRITE(nMintAuthorities);
+        READWRITE(nMeltAuthorities);
+    }
+};
+
+/** Identifies one unspent output of a token group: (group id bytes, outpoint hash) */
+typedef std::pair<std::vector<unsigned char>, uint256> CTokenOutputKey;
+
+/** All the database changes needed to connect or disconnect one block, written as a single batch.  Token holding
+ *  outputs and authorities are kept apart so that each can be listed without skipping over the other. */
+struct CTokenIndexUpdate
+{
+    std::vector<std::pair<CTokenOutputKey, Coin> > unspentWrite;
+    std::vector<CTokenOutputKey> unspentErase;
+    std::vector<std::pair<CTokenOutputKey, Coin> > authorityWrite;
+    std::vector<CTokenOutputKey> authorityErase;
+    std::map<std::vector<unsigned char>, CTokenSupply> supplies;
+};
+
+/**
+ * Access to the token group index database (indexes/tokenindex/)
+ *
+ * Maps every token group and subgroup to its unspent outputs, its unspent authorities and running supply totals.
+ * Groups are keyed by the bytes of their group id. Like the TxIndexDB it stores the block locator of the chain the
+ * database is synced to.
+ */
+class TokenIndexDB : public CDBWrapper
+{
+public:
+    explicit TokenIndexDB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the running totals of a group. Returns empty totals if the group has no unspent outputs.
+    bool ReadSupply(const std::vector<unsigned char> &group, CTokenSupply &supply) const;
+
+    /// Read up to nMax unspent outputs (or authorities if fAuthorities) of a group, starting after the outpoint
+    /// hash "after" (for paging).
+    bool ReadUnspent(const std::vector<unsigned char> &group,
+        bool fAuthorities,
+        const uint256 &after,
+        size_t nMax,
+        std::vector<std::pair<uint256, Coin> > &entries) const;
+
+    /// Atomically apply the changes for one block along with the new best block locator.
+    bool WriteUpdate(const CTokenIndexUpdate &update, const CBlockLocator &locator);
+
+    /// Read block locator of the chain that the token index is in sync with.
+    bool ReadBestBlock(CBlockLocator &locator) const;
+
+    /// Write block locator of the chain that the token index is in sync with.
+    bool WriteBestBlock(const CBlockLocator &locator);
+};
 #endif // NEXA_TXDB_H
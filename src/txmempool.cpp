@@ -25,6 +25,7 @@
 #include "utilmoneystr.h"
 #include "utiltime.h"
 #include "validation/validation.h"
+#include "validationinterface.h"
 #include "version.h"
 
 #include <mutex>
@@ -707,9 +708,32 @@ bool CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, bool fCurrentEstimat
     return _addUnchecked(entry, fCurrentEstimate);
 }
 
-void CTxMemPool::removeUnchecked(TxIdIter it)
+const char *RemovalReasonToString(MemPoolRemovalReason reason)
+{
+    switch (reason)
+    {
+    case MemPoolRemovalReason::EXPIRY:
+        return "expiry";
+    case MemPoolRemovalReason::SIZELIMIT:
+        return "sizelimit";
+    case MemPoolRemovalReason::REORG:
+        return "reorg";
+    case MemPoolRemovalReason::BLOCK:
+        return "block";
+    case MemPoolRemovalReason::CONFLICT:
+        return "conflict";
+    case MemPoolRemovalReason::UNKNOWN:
+        break;
+    }
+    return "unknown";
+}
+
+void CTxMemPool::removeUnchecked(TxIdIter it, MemPoolRemovalReason reason)
 {
     AssertWriteLockHeld(cs_txmempool);
+    // Listeners must only take a reference to the transaction here, since the mempool lock is held
+    if (GetMainSignals().nRemovedFromMempoolListeners.load(std::memory_order_relaxed) > 0)
+        GetMainSignals().TransactionRemovedFromMempool(it->GetSharedTx(), reason);
     if (it->dsproof != -1)
         m_dspStorage->remove(it->dsproof);
 
@@ -792,7 +816,9 @@ void CTxMemPool::ResubmitCommitQ()
     }
 }
 
-void CTxMemPool::_removeRecursive(const CTransaction &origTx, std::list<CTransactionRef> &removed)
+void CTxMemPool::_removeRecursive(const CTransaction &origTx,
+    std::list<CTransactionRef> &removed,
+    MemPoolRemovalReason reason)
 {
     AssertWriteLockHeld(cs_txmempool);
 
@@ -828,7 +854,7 @@ void CTxMemPool::_removeRecursive(const CTransaction &origTx, std::list<CTransac
     {
         removed.push_back(it->GetSharedTx());
     }
-    _RemoveStaged(setAllRemoves);
+    _RemoveStaged(setAllRemoves, reason);
 
     // As a final step we must resubmit whatever is in the CommitQ and CommitQFinal in case
     // there are any anscestors that were removed from the mempool above.
@@ -878,7 +904,7 @@ void CTxMemPool::removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMem
     for (const CTransaction &tx : transactionsToRemove)
     {
         std::list<CTransactionRef> removed;
-        _removeRecursive(tx, removed);
+        _removeRecursive(tx, removed, MemPoolRemovalReason::REORG);
     }
 }
 
@@ -900,7 +926,7 @@ void CTxMemPool::_removeConflicts(const CTransaction &tx, std::list<CTransaction
             const CTransaction &txConflict = *it->second.ptx;
             if (txConflict != tx)
             {
-                _removeRecursive(txConflict, removed);
+                _removeRecursive(txConflict, removed, MemPoolRemovalReason::CONFLICT);
             }
         }
     }
@@ -986,7 +1012,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef> &vtx,
         {
             setAncestorsFromBlock.erase(it);
             mapTxnChainTips.erase(it);
-            removeUnchecked(it);
+            removeUnchecked(it, MemPoolRemovalReason::BLOCK);
         }
 
         // This is a safeguard in the case where ancestors of transactions in this block have re-entered
@@ -997,7 +1023,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef> &vtx,
             DbgAssert(!"Ancestors in the mempool when they should not be", );
             for (TxIdIter it : setAncestorsFromBlock)
             {
-                removeUnchecked(it);
+                removeUnchecked(it, MemPoolRemovalReason::BLOCK);
             }
         }
     }
@@ -1558,14 +1584,14 @@ size_t CTxMemPool::_DynamicMemoryUsage() const
            cachedInnerUsage;
 }
 
-void CTxMemPool::_RemoveStaged(setEntries &stage)
+void CTxMemPool::_RemoveStaged(setEntries &stage, MemPoolRemovalReason reason)
 {
     {
         AssertWriteLockHeld(cs_txmempool);
         _UpdateForRemoveFromMempool(stage);
         for (const TxIdIter &it : stage)
         {
-            removeUnchecked(it);
+            removeUnchecked(it, reason);
         }
     }
 }
@@ -1586,7 +1612,7 @@ int CTxMemPool::Expire(int64_t time, std::vector<COutPoint> &vCoinsToUncache)
         for (const CTxIn &txin : it2->GetTx().vin)
             vCoinsToUncache.push_back(txin.prevout);
 
-    _RemoveStaged(stage);
+    _RemoveStaged(stage, MemPoolRemovalReason::EXPIRY);
     return stage.size();
 }
 
@@ -1748,7 +1774,7 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint> *pvNoSpends
             for (TxIdIter it3 : stage)
                 vTxn.push_back(it3->GetSharedTx());
         }
-        _RemoveStaged(stage);
+        _RemoveStaged(stage, MemPoolRemovalReason::SIZELIMIT);
         if (pvNoSpendsRemaining)
         {
             for (CTransactionRef &ptx : vTxn)
@@ -337,6 +337,20 @@ struct TxMempoolInfo
     int64_t feeDelta;
 };
 
+/** Why a transaction left the mempool, passed to listeners of TransactionRemovedFromMempool */
+enum class MemPoolRemovalReason
+{
+    UNKNOWN = 0, //!< Removed explicitly, for example by the removeRecursive() of a caller
+    EXPIRY, //!< Older than the mempool expiry time
+    SIZELIMIT, //!< Evicted to keep the mempool under its size limit
+    REORG, //!< No longer final or spends an immature coinbase after a reorg
+    BLOCK, //!< Included in a block
+    CONFLICT, //!< Spends an output that a transaction in a block also spends
+};
+
+/** A short lower case name of the removal reason, for logs and notifications */
+const char *RemovalReasonToString(MemPoolRemovalReason reason);
+
 /** An inpoint - a combination of a transaction and an index n into its vin */
 class CInPoint
 {
@@ -611,7 +625,9 @@ public:
     bool _addUnchecked(const CTxMemPoolEntry &entry, bool fCurrentEstimate = true);
 
     void removeRecursive(const CTransaction &tx, std::list<CTransactionRef> &removed);
-    void _removeRecursive(const CTransaction &tx, std::list<CTransactionRef> &removed);
+    void _removeRecursive(const CTransaction &tx,
+        std::list<CTransactionRef> &removed,
+        MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
     void removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMemPoolHeight, int flags);
     void removeConflicts(const CTransaction &tx, std::list<CTransactionRef> &removed);
     void _removeConflicts(const CTransaction &tx, std::list<CTransactionRef> &removed);
@@ -661,7 +677,7 @@ public:
      *  Set updateDescendants to true when removing a tx that was in a block, so
      *  that any in-mempool descendants have their ancestor state updated.
      */
-    void _RemoveStaged(setEntries &stage);
+    void _RemoveStaged(setEntries &stage, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
 
     /** Resumbit and clear all txns currently in the txCommitQ and txCommitQFinal.
      *  This has the effect of removing and descendants for txns that were already removed
@@ -828,9 +844,9 @@ private:
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(TxIdIter entry);
 
-    /** Remove a transaction from the mempool
+    /** Remove a transaction from the mempool and tell listeners why it was removed
      */
-    void removeUnchecked(TxIdIter entry);
+    void removeUnchecked(TxIdIter entry, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
 
     /** Temporary storage for double spend proofs */
     std::unique_ptr<DoubleSpendProofStorage> m_dspStorage;
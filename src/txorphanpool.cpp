@@ -6,12 +6,15 @@
 #include "txorphanpool.h"
 
 #include "init.h"
+#include "policy/policy.h"
 #include "main.h"
 #include "timedata.h"
 #include "txadmission.h"
 #include "util.h"
 #include "utiltime.h"
 
+#include <algorithm>
+
 CTxOrphanPool::CTxOrphanPool() : nBytesOrphanPool(0){ nLastOrphanCheck.store(GetTime()); };
 
 bool CTxOrphanPool::AlreadyHaveOrphan(const uint256 &hash)
@@ -22,6 +25,9 @@ bool CTxOrphanPool::AlreadyHaveOrphan(const uint256 &hash)
     return false;
 }
 
+uint64_t CTxOrphanPool::MaxOrphanPoolBytes() { return (uint64_t)maxTxPool.Value() * ONE_MEGABYTE / 10; }
+uint64_t CTxOrphanPool::PeerQuota() { return MaxOrphanPoolBytes() / 100 * orphanPoolPeerQuota.Value(); }
+
 bool CTxOrphanPool::AddOrphanTx(const CTransactionRef ptx, NodeId peer)
 {
     AssertWriteLockHeld(cs_orphanpool);
@@ -41,9 +47,34 @@ bool CTxOrphanPool::AddOrphanTx(const CTransactionRef ptx, NodeId peer)
     }
 
     uint64_t nTxMemoryUsed = RecursiveDynamicUsage(*ptx) + sizeof(ptx);
-    mapOrphanTransactions.emplace(hash, COrphanTx{ptx, peer, GetTime(), nTxMemoryUsed});
+
+    // A peer that floods us with orphans only pushes out its own
+    const uint64_t nPeerQuota = PeerQuota();
+    if (nTxMemoryUsed > nPeerQuota)
+    {
+        LOG(MEMPOOL, "ignoring orphan tx %s larger than the peer quota\n", hash.ToString());
+        return false;
+    }
+    auto itPeer = mapOrphansByPeer.find(peer);
+    while (itPeer != mapOrphansByPeer.end() && itPeer->second.nBytes + nTxMemoryUsed > nPeerQuota)
+    {
+        const uint256 evict = itPeer->second.setByAge.begin()->hash;
+        pcoinsTip->UncacheTx(*mapOrphanTransactions.at(evict).ptx);
+        LOG(MEMPOOL, "peer %d is over its orphan quota, evicting orphan tx %s\n", peer, evict.ToString());
+        EraseOrphanTx(evict);
+        // The peer's entry is removed along with its last orphan
+        itPeer = mapOrphansByPeer.find(peer);
+    }
+
+    COrphanTx orphan{ptx, peer, GetTime(), nTxMemoryUsed};
+    CEvictionKey key{orphan.nEntryTime, nTxMemoryUsed, hash};
+    mapOrphanTransactions.emplace(hash, orphan);
     for (const CTxIn &txin : ptx->vin)
-        mapOrphanTransactionsByPrev[txin.prevout.hash].insert(hash);
+        mapOrphanTransactionsByPrev[txin.prevout].push_back(hash);
+    setOrphansByAge.insert(key);
+    CPeerOrphans &peerOrphans = mapOrphansByPeer[peer];
+    peerOrphans.setByAge.insert(key);
+    peerOrphans.nBytes += nTxMemoryUsed;
 
     nBytesOrphanPool += nTxMemoryUsed;
     LOG(MEMPOOL, "stored orphan tx %s bytes:%ld (mapsz %u prevsz %u), orphan pool bytes:%ld\n", hash.ToString(),
@@ -55,52 +86,60 @@ bool CTxOrphanPool::EraseOrphanTx(uint256 hash)
 {
     AssertWriteLockHeld(cs_orphanpool);
 
-    std::map<uint256, COrphanTx>::iterator it = mapOrphanTransactions.find(hash);
+    OrphanMap::iterator it = mapOrphanTransactions.find(hash);
     if (it == mapOrphanTransactions.end())
         return false;
     for (const CTxIn &txin : it->second.ptx->vin)
     {
-        std::map<uint256, std::set<uint256> >::iterator itPrev = mapOrphanTransactionsByPrev.find(txin.prevout.hash);
+        auto itPrev = mapOrphanTransactionsByPrev.find(txin.prevout);
         if (itPrev == mapOrphanTransactionsByPrev.end())
             continue;
-        itPrev->second.erase(hash);
-        if (itPrev->second.empty())
+        std::vector<uint256> &spenders = itPrev->second;
+        spenders.erase(std::remove(spenders.begin(), spenders.end(), hash), spenders.end());
+        if (spenders.empty())
             mapOrphanTransactionsByPrev.erase(itPrev);
     }
 
-    nBytesOrphanPool -= it->second.nOrphanTxSize;
-    LOG(MEMPOOL, "Erased orphan tx %s of size %ld bytes, orphan pool bytes:%ld\n", it->second.ptx->GetId().ToString(),
-        it->second.nOrphanTxSize, nBytesOrphanPool);
+    const COrphanTx &orphan = it->second;
+    const CEvictionKey key{orphan.nEntryTime, orphan.nOrphanTxSize, hash};
+    setOrphansByAge.erase(key);
+    auto itPeer = mapOrphansByPeer.find(orphan.fromPeer);
+    if (itPeer != mapOrphansByPeer.end())
+    {
+        itPeer->second.setByAge.erase(key);
+        itPeer->second.nBytes -= orphan.nOrphanTxSize;
+        if (itPeer->second.setByAge.empty())
+            mapOrphansByPeer.erase(itPeer);
+    }
+
+    nBytesOrphanPool -= orphan.nOrphanTxSize;
+    LOG(MEMPOOL, "Erased orphan tx %s of size %ld bytes, orphan pool bytes:%ld\n", orphan.ptx->GetId().ToString(),
+        orphan.nOrphanTxSize, nBytesOrphanPool);
     mapOrphanTransactions.erase(it);
     return true;
 }
 
 void CTxOrphanPool::EraseOrphansByTime()
 {
-    // Because we have to iterate through the entire orphan cache which can be large we don't want to check this
-    // every time a tx enters the mempool but just once every 5 minutes is good enough.
+    // Expired orphans are at the front of setOrphansByAge, but there is still no need to look for them every time a
+    // tx enters the mempool, so just once every 5 minutes is good enough.
     int64_t now = GetTime();
     if (now < nLastOrphanCheck.load() + 5 * 60)
         return;
     nLastOrphanCheck.store(now);
 
     WRITELOCK(cs_orphanpool);
-    int64_t nOrphanTxCutoffTime = 0;
-    nOrphanTxCutoffTime = now - orphanPoolExpiry.Value() * 60 * 60;
-    std::map<uint256, COrphanTx>::iterator iter = mapOrphanTransactions.begin();
-    while (iter != mapOrphanTransactions.end())
+    int64_t nOrphanTxCutoffTime = now - orphanPoolExpiry.Value() * 60 * 60;
+    while (!setOrphansByAge.empty() && setOrphansByAge.begin()->nEntryTime < nOrphanTxCutoffTime)
     {
-        std::map<uint256, COrphanTx>::iterator mi = iter++; // increment to avoid iterator becoming invalid
-        int64_t nEntryTime = mi->second.nEntryTime;
-        if (nEntryTime < nOrphanTxCutoffTime)
-        {
-            // Uncache any coins that may exist for orphans that will be erased
-            pcoinsTip->UncacheTx(*mi->second.ptx);
+        const uint256 txHash = setOrphansByAge.begin()->hash;
+        const int64_t nEntryTime = setOrphansByAge.begin()->nEntryTime;
 
-            const uint256 &txHash = mi->second.ptx->GetId();
-            EraseOrphanTx(txHash);
-            LOG(MEMPOOL, "Erased old orphan tx %s of age %d seconds\n", txHash.ToString(), now - nEntryTime);
-        }
+        // Uncache any coins that may exist for orphans that will be erased
+        pcoinsTip->UncacheTx(*mapOrphanTransactions.at(txHash).ptx);
+
+        EraseOrphanTx(txHash);
+        LOG(MEMPOOL, "Erased old orphan tx %s of age %d seconds\n", txHash.ToString(), now - nEntryTime);
     }
 }
 
@@ -114,21 +153,53 @@ unsigned int CTxOrphanPool::LimitOrphanTxSize(unsigned int nMaxOrphans, uint64_t
     unsigned int nEvicted = 0;
     while (mapOrphanTransactions.size() > nMaxOrphans || nBytesOrphanPool > nMaxBytes)
     {
-        // Evict a random orphan:
-        uint256 randomhash = GetRandHash();
-        std::map<uint256, COrphanTx>::iterator it = mapOrphanTransactions.lower_bound(randomhash);
-        if (it == mapOrphanTransactions.end())
-            it = mapOrphanTransactions.begin();
+        // Evict the oldest orphan, which is the least likely to still be resolved
+        const uint256 hash = setOrphansByAge.begin()->hash;
 
         // Uncache any coins that may exist for orphans that will be erased
-        pcoinsTip->UncacheTx(*it->second.ptx);
+        pcoinsTip->UncacheTx(*mapOrphanTransactions.at(hash).ptx);
 
-        EraseOrphanTx(it->first);
+        EraseOrphanTx(hash);
         ++nEvicted;
     }
     return nEvicted;
 }
 
+std::vector<CTxOrphanPool::COrphanTx> CTxOrphanPool::TakeOrphansSpending(const std::vector<CTransactionRef> &vtx)
+{
+    std::vector<COrphanTx> vOrphans;
+    {
+        // Most of the time nothing is waiting, and then there is no need to hold up other threads with a write lock
+        READLOCK(cs_orphanpool);
+        if (mapOrphanTransactionsByPrev.empty())
+            return vOrphans;
+    }
+
+    WRITELOCK(cs_orphanpool);
+    std::vector<uint256> vHashes;
+    for (const CTransactionRef &tx : vtx)
+    {
+        for (unsigned int j = 0; j < tx->vout.size(); j++)
+        {
+            auto itByPrev = mapOrphanTransactionsByPrev.find(tx->OutpointAt(j));
+            if (itByPrev != mapOrphanTransactionsByPrev.end())
+                vHashes.insert(vHashes.end(), itByPrev->second.begin(), itByPrev->second.end());
+        }
+    }
+
+    // An orphan spending several of these outputs was found once for each of them
+    for (const uint256 &hash : vHashes)
+    {
+        OrphanMap::iterator it = mapOrphanTransactions.find(hash);
+        if (it == mapOrphanTransactions.end())
+            continue;
+        LOG(MEMPOOL, "Resubmitting orphan tx: %s\n", hash.ToString());
+        vOrphans.push_back(it->second);
+        EraseOrphanTx(hash);
+    }
+    return vOrphans;
+}
+
 void CTxOrphanPool::QueryIds(std::vector<uint256> &vHashes)
 {
     READLOCK(cs_orphanpool);
@@ -161,8 +232,9 @@ std::vector<CTxOrphanPool::COrphanTx> CTxOrphanPool::AllTxOrphanPoolInfo() const
     AssertLockHeld(orphanpool.cs_orphanpool);
     std::vector<COrphanTx> vInfo;
     vInfo.reserve(mapOrphanTransactions.size());
-    for (auto &it : mapOrphanTransactions)
-        vInfo.push_back(it.second);
+    // Oldest first, which usually puts orphans ahead of the orphans that spend them
+    for (const CEvictionKey &key : setOrphansByAge)
+        vInfo.push_back(mapOrphanTransactions.at(key.hash));
 
     return vInfo;
 }
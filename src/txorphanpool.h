@@ -6,17 +6,20 @@
 #ifndef NEXA_TX_ORPHANPOOL
 #define NEXA_TX_ORPHANPOOL
 
+#include "coins.h"
 #include "net.h"
 #include "primitives/transaction.h"
 #include "sync.h"
+#include "txmempool.h"
 #include "uint256.h"
 
-#include <map>
 #include <set>
 #include <stdint.h>
+#include <unordered_map>
 
 extern CTweak<uint32_t> maxOrphanPool;
 extern CTweak<uint32_t> orphanPoolExpiry;
+extern CTweak<uint32_t> orphanPoolPeerQuota;
 
 class CTxOrphanPool
 {
@@ -30,6 +33,34 @@ private:
     //! txn hashes that are in the previous block
     std::vector<uint256> vPreviousBlock GUARDED_BY(cs_orphanpool);
 
+    //! Orders orphans for eviction: oldest first, and the largest first of those that arrived in the same second
+    struct CEvictionKey
+    {
+        int64_t nEntryTime;
+        uint64_t nOrphanTxSize;
+        uint256 hash;
+
+        bool operator<(const CEvictionKey &b) const
+        {
+            if (nEntryTime != b.nEntryTime)
+                return nEntryTime < b.nEntryTime;
+            if (nOrphanTxSize != b.nOrphanTxSize)
+                return nOrphanTxSize > b.nOrphanTxSize;
+            return hash < b.hash;
+        }
+    };
+
+    struct CPeerOrphans
+    {
+        uint64_t nBytes = 0;
+        std::set<CEvictionKey> setByAge;
+    };
+
+    //! Every orphan in eviction order.  A set rather than a heap, since resolved orphans leave from the middle.
+    std::set<CEvictionKey> setOrphansByAge GUARDED_BY(cs_orphanpool);
+    //! Memory used by, and eviction order of, the orphans that each peer sent us
+    std::unordered_map<NodeId, CPeerOrphans> mapOrphansByPeer GUARDED_BY(cs_orphanpool);
+
 public:
     //! Current in memory footprint of all txns in the orphan pool.
     uint64_t nBytesOrphanPool GUARDED_BY(cs_orphanpool);
@@ -42,15 +73,19 @@ public:
         uint64_t nOrphanTxSize;
     };
 
-    std::map<uint256, COrphanTx> mapOrphanTransactions GUARDED_BY(cs_orphanpool);
-    std::map<uint256, std::set<uint256> > mapOrphanTransactionsByPrev GUARDED_BY(cs_orphanpool);
+    typedef std::unordered_map<uint256, COrphanTx, SaltedTxidHasher> OrphanMap;
+    OrphanMap mapOrphanTransactions GUARDED_BY(cs_orphanpool);
+    //! The orphans spending each outpoint.  Almost always there is just one, so a vector is the cheapest container.
+    typedef std::unordered_map<COutPoint, std::vector<uint256>, SaltedOutpointHasher> OrphansByPrevMap;
+    OrphansByPrevMap mapOrphanTransactionsByPrev GUARDED_BY(cs_orphanpool);
 
     CTxOrphanPool();
 
     //! Do we already have this orphan in the orphan pool
     bool AlreadyHaveOrphan(const uint256 &txid);
 
-    //! Add a transaction to the orphan pool
+    //! Add a transaction to the orphan pool.  If this takes the peer past its share of the pool (see PeerQuota())
+    //! then the peer's oldest orphans are evicted to make room.
     bool AddOrphanTx(const CTransactionRef ptx, NodeId peer);
 
     //! Erase an ophan tx from the orphan pool
@@ -61,8 +96,27 @@ public:
     void EraseOrphansByTime();
 
     //! Limit the orphan pool size by either number of transactions or the max orphan pool size allowed.
+    //! The oldest orphans are evicted first.
     unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans, uint64_t nMaxBytes);
 
+    //! Remove and return every orphan that spends an output of one of these transactions, so they can be enqueued
+    //! for admission together
+    std::vector<COrphanTx> TakeOrphansSpending(const std::vector<CTransactionRef> &vtx);
+
+    //! The largest memory footprint the orphan pool may have
+    static uint64_t MaxOrphanPoolBytes();
+
+    //! The most orphan pool memory that the orphans from any one peer may use
+    static uint64_t PeerQuota();
+
+    //! Orphan pool bytes used by the orphans this peer sent
+    uint64_t GetPeerOrphanBytes(NodeId peer)
+    {
+        READLOCK(cs_orphanpool);
+        auto it = mapOrphansByPeer.find(peer);
+        return (it == mapOrphansByPeer.end()) ? 0 : it->second.nBytes;
+    }
+
     //! Return all the transaction hashes for transactions currently in the orphan pool.
     void QueryIds(std::vector<uint256> &vHashes);
 
@@ -97,6 +151,8 @@ public:
         WRITELOCK(cs_orphanpool);
         mapOrphanTransactions.clear();
         mapOrphanTransactionsByPrev.clear();
+        setOrphansByAge.clear();
+        mapOrphansByPeer.clear();
         nBytesOrphanPool = 0;
     }
 
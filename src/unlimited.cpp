@@ -8,6 +8,7 @@
 #include "base58.h"
 #include "blockrelay/graphene.h"
 #include "blockrelay/thinblock.h"
+#include "blockstorage/blockfilewriter.h"
 #include "blockstorage/blockstorage.h"
 #include "cashaddrenc.h"
 #include "chain.h"
@@ -397,6 +398,8 @@ void UnlimitedCleanup()
         LOCK(cs_blockvalidationtime);
         nBlockValidationTime.Stop();
     }
+    blockWriteQueueDepth.Stop();
+    blockFileSyncs.Stop();
 
     CStatBase *obj = nullptr;
     while (!mallocedStats.empty())
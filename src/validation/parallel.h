@@ -11,6 +11,7 @@
 #include "primitives/block.h"
 #include "protocol.h"
 #include "script/sigcache.h"
+#include "script/sighashtype.h"
 #include "serialize.h"
 #include "stat.h"
 #include "uint256.h"
@@ -93,6 +94,8 @@ protected:
     CScript scriptPubKey;
     bool cacheStore;
     ScriptError error;
+    //! sighash parts shared by the checks of all inputs of the transaction
+    PrecomputedTransactionDataRef txdata;
     CachingTransactionSignatureChecker checker;
     ScriptImportedState sis;
 
@@ -123,10 +126,11 @@ public:
         const CValidationState &validationData,
         unsigned int inputIdx,
         unsigned int nFlagsIn,
-        bool cacheIn)
+        bool cacheIn,
+        const PrecomputedTransactionDataRef &txdataIn = nullptr)
         : resourceTracker(resourceTrackerIn), scriptPubKey(scriptPubKeyIn), cacheStore(cacheIn),
-          error(SCRIPT_ERR_UNKNOWN_ERROR),
-          checker(&(*txIn), inputIdx, txIn->vin[inputIdx].amount, nFlagsIn, cacheStore),
+          error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn),
+          checker(&(*txIn), inputIdx, txIn->vin[inputIdx].amount, nFlagsIn, cacheStore, txdata.get()),
           sis(&checker, txIn, validationData, coins, inputIdx)
     {
         assert(inputIdx < txIn->vin.size());
@@ -140,6 +144,7 @@ public:
         scriptPubKey.swap(check.scriptPubKey);
         std::swap(cacheStore, check.cacheStore);
         std::swap(error, check.error);
+        std::swap(txdata, check.txdata);
         std::swap(checker, check.checker);
         std::swap(sis, check.sis);
         // local script state should always point to its own checker so undo the swap of these pointers
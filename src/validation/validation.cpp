@@ -8,6 +8,7 @@
 
 #include "blockrelay/blockrelay_common.h"
 #include "blockstorage/blockcache.h"
+#include "blockstorage/blockindexsnapshot.h"
 #include "blockstorage/blockstorage.h"
 #include "blockstorage/sequential_files.h"
 #include "checkpoints.h"
@@ -18,6 +19,7 @@
 #include "consensus/tx_verify.h"
 #include "dosman.h"
 #include "expedited.h"
+#include "index/baseindex.h"
 #include "index/txindex.h"
 #include "init.h"
 #include "requestManager.h"
@@ -475,7 +477,8 @@ CBlockIndex *InsertBlockIndex(const uint256 &hash)
     return pindexNew;
 }
 
-bool LoadBlockIndexDB()
+/** Load mapBlockIndex by walking every entry of the block index database */
+static bool LoadBlockIndexGutsFromDB()
 {
     // Open and read all ldb index files so that they are in the Operating System file cache before we iterate
     // through the index files and load the block index. While this is a bit of a hack, it has an enormous
@@ -512,11 +515,33 @@ bool LoadBlockIndexDB()
     }
 
     // Load the block index data
+    return pblocktree->LoadBlockIndexGuts();
+}
+
+bool LoadBlockIndexDB()
+{
     const CChainParams &chainparams = Params();
-    if (!pblocktree->LoadBlockIndexGuts())
+    int64_t nStart = GetStopwatchMicros();
+
+    // A block index snapshot left by a clean shutdown loads far faster than walking the block index database.
+    bool fSnapshot = false;
+    if (GetBoolArg("-blockindexsnapshot", DEFAULT_BLOCKINDEX_SNAPSHOT))
+    {
+        LOCK(cs_main);
+        fSnapshot = LoadBlockIndexSnapshot(*pblocktree);
+    }
+    else
+    {
+        // Never leave a snapshot valid across a run that does not keep it up to date
+        pblocktree->EraseBlockIndexSnapshotId();
+    }
+    if (!fSnapshot && !LoadBlockIndexGutsFromDB())
     {
         return false;
     }
+    int64_t nLoaded = GetStopwatchMicros();
+    LOGA("%s: loaded %u block index entries from the %s in %.2fms\n", __func__, mapBlockIndex.size(),
+        fSnapshot ? "snapshot" : "database", (nLoaded - nStart) * 0.001);
 
     LOCK(cs_main);
     /** This sync method will break on pruned nodes so we cant use if pruned*/
@@ -529,6 +554,7 @@ bool LoadBlockIndexDB()
         // may increase startup time significantly but is faster than network sync
         SyncStorage(chainparams);
     }
+    int64_t nSynced = GetStopwatchMicros();
 
     delete pblocktreeother;
     pblocktreeother = nullptr;
@@ -624,6 +650,8 @@ bool LoadBlockIndexDB()
             pindexBestHeader = pindex;
     }
 
+    int64_t nLinked = GetStopwatchMicros();
+
     if (!pblockdb) // sequential files
     {
         // Check presence of blk files
@@ -662,6 +690,9 @@ bool LoadBlockIndexDB()
         }
     }
 
+    LOGA("%s: startup phases: storage sync %.2fms, chain linking %.2fms, block files %.2fms\n", __func__,
+        (nSynced - nLoaded) * 0.001, (nLinked - nSynced) * 0.001, (GetStopwatchMicros() - nLinked) * 0.001);
+
     if (fHavePruned)
     {
         LOGA("LoadBlockIndexDB(): Block files have previously been pruned\n");
@@ -696,12 +727,7 @@ bool LoadBlockIndexDB()
 
 void UnloadBlockIndex()
 {
-    {
-        WRITELOCK(orphanpool.cs_orphanpool);
-        orphanpool.mapOrphanTransactions.clear();
-        orphanpool.mapOrphanTransactionsByPrev.clear();
-        orphanpool.nBytesOrphanPool = 0;
-    }
+    orphanpool.clear();
 
     nPreferredDownload.store(0);
     nodestate.Clear();
@@ -1089,7 +1115,8 @@ bool CheckInputs(const CTransactionRef &tx,
     const CChainParams &chainparams,
     std::vector<CScriptCheck> *pvChecks,
     unsigned char *sighashType,
-    CValidationDebugger *debugger)
+    CValidationDebugger *debugger,
+    PrecomputedTransactionDataRef txdata)
 {
     bool allPassed = true;
     if (!tx->IsCoinBase())
@@ -1144,6 +1171,9 @@ bool CheckInputs(const CTransactionRef &tx,
                 CoinAccessor coin(inputs, tx->vin[i].prevout);
                 spendingCoins.push_back(coin->out);
             }
+            // Hash the parts of the signature hash that every input shares only once
+            if (!txdata)
+                txdata = std::make_shared<const PrecomputedTransactionData>(*tx);
             for (size_t i = 0; i < tx->vin.size(); i++)
             {
                 const COutPoint &prevout = tx->vin[i].prevout;
@@ -1203,12 +1233,12 @@ bool CheckInputs(const CTransactionRef &tx,
                 if (pvChecks)
                 {
                     pvChecks->push_back(CScriptCheck(
-                        resourceTracker, scriptPubKey, amount, tx, spendingCoins, state, i, flags, cacheStore));
+                        resourceTracker, scriptPubKey, amount, tx, spendingCoins, state, i, flags, cacheStore, txdata));
                 }
                 else
                 {
-                    CScriptCheck check(
-                        resourceTracker, scriptPubKey, amount, tx, spendingCoins, state, i, flags, cacheStore);
+                    CScriptCheck check(resourceTracker, scriptPubKey, amount, tx, spendingCoins, state, i, flags,
+                        cacheStore, txdata);
                     if (!check())
                     {
                         ScriptError scriptError = check.GetScriptError();
@@ -1225,8 +1255,8 @@ bool CheckInputs(const CTransactionRef &tx,
                             // arguments; if so, don't trigger DoS protection to
                             // avoid splitting the network between upgraded and
                             // non-upgraded nodes.
-                            CScriptCheck check2(
-                                nullptr, scriptPubKey, amount, tx, spendingCoins, state, i, mandatoryFlags, cacheStore);
+                            CScriptCheck check2(nullptr, scriptPubKey, amount, tx, spendingCoins, state, i,
+                                mandatoryFlags, cacheStore, txdata);
                             if (check2())
                             {
                                 if (debugger)
@@ -1253,8 +1283,8 @@ bool CheckInputs(const CTransactionRef &tx,
                         // Note that this will create strange error messages like
                         // "upgrade-conditional-script-failure (Opcode missing or not
                         // understood)".
-                        CScriptCheck check3(
-                            nullptr, scriptPubKey, amount, tx, spendingCoins, state, i, mandatoryFlags, cacheStore);
+                        CScriptCheck check3(nullptr, scriptPubKey, amount, tx, spendingCoins, state, i,
+                            mandatoryFlags, cacheStore, txdata);
                         if (check3())
                         {
                             if (debugger)
@@ -2593,6 +2623,9 @@ bool ConnectBlock(ConstCBlockRef pblock,
         g_txindex->BlockConnected(*pblock, pindex);
     }
 
+    // Bring the indexes that are built from block and undo data up to date
+    IndexesBlockConnected(*pblock, blockundo, pindex);
+
     // add this block to the view's block chain (the main UTXO in memory cache)
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -2911,6 +2944,7 @@ bool DisconnectTip(CValidationState &state, const Consensus::Params &consensusPa
         bool result = view.Flush();
         assert(result);
     }
+    IndexesBlockDisconnected(*pblock, pindexDelete);
     LOG(BENCH, "- Disconnect block: %.2fms\n", (GetStopwatchMicros() - nStart) * 0.001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
@@ -2930,6 +2964,7 @@ bool DisconnectTip(CValidationState &state, const Consensus::Params &consensusPa
 
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    GetMainSignals().BlockDisconnected(pblock, pindexDelete);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
     for (const auto &ptx : pblock->vtx)
@@ -81,7 +81,8 @@ void CheckBlockIndex(const Consensus::Params &consensusParams);
 /**
  * Check whether all inputs of this transaction are valid (no double spends, scripts & sigs, amounts)
  * This does not modify the UTXO set. If pvChecks is not nullptr, script checks are pushed onto it
- * instead of being performed inline.
+ * instead of being performed inline. txdata holds the signature hash parts shared by all inputs; if it is nullptr
+ * it is computed here.
  */
 bool CheckInputs(const CTransactionRef &tx,
     CValidationState &state,
@@ -93,7 +94,8 @@ bool CheckInputs(const CTransactionRef &tx,
     const CChainParams &chainparams,
     std::vector<CScriptCheck> *pvChecks = nullptr,
     unsigned char *sighashType = nullptr,
-    CValidationDebugger *debugger = nullptr);
+    CValidationDebugger *debugger = nullptr,
+    PrecomputedTransactionDataRef txdata = nullptr);
 
 /** Remove invalidity status from a block and its descendants. */
 bool ReconsiderBlock(CValidationState &state, CBlockIndex *pindex);
@@ -27,10 +27,21 @@ void RegisterValidationInterface(CValidationInterface *pwalletIn)
     g_signals.ScriptForMining.connect(
         boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, boost::arg<1>()));
     g_signals.BlockFound.connect(boost::bind(&CValidationInterface::ResetRequestCount, pwalletIn, boost::arg<1>()));
+    g_signals.NewCapdMessage.connect(boost::bind(&CValidationInterface::NewCapdMessage, pwalletIn, boost::arg<1>()));
+    g_signals.TransactionRemovedFromMempool.connect(boost::bind(
+        &CValidationInterface::TransactionRemovedFromMempool, pwalletIn, boost::arg<1>(), boost::arg<2>()));
+    g_signals.BlockDisconnected.connect(
+        boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, boost::arg<1>(), boost::arg<2>()));
 }
 
 void UnregisterValidationInterface(CValidationInterface *pwalletIn)
 {
+    g_signals.BlockDisconnected.disconnect(
+        boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, boost::arg<1>(), boost::arg<2>()));
+    g_signals.TransactionRemovedFromMempool.disconnect(boost::bind(
+        &CValidationInterface::TransactionRemovedFromMempool, pwalletIn, boost::arg<1>(), boost::arg<2>()));
+    g_signals.NewCapdMessage.disconnect(
+        boost::bind(&CValidationInterface::NewCapdMessage, pwalletIn, boost::arg<1>()));
     g_signals.BlockFound.disconnect(boost::bind(&CValidationInterface::ResetRequestCount, pwalletIn, boost::arg<1>()));
     g_signals.ScriptForMining.disconnect(
         boost::bind(&CValidationInterface::GetScriptForMining, pwalletIn, boost::arg<1>()));
@@ -52,6 +63,9 @@ void UnregisterValidationInterface(CValidationInterface *pwalletIn)
 
 void UnregisterAllValidationInterfaces()
 {
+    g_signals.BlockDisconnected.disconnect_all_slots();
+    g_signals.TransactionRemovedFromMempool.disconnect_all_slots();
+    g_signals.NewCapdMessage.disconnect_all_slots();
     g_signals.BlockFound.disconnect_all_slots();
     g_signals.ScriptForMining.disconnect_all_slots();
     g_signals.BlockChecked.disconnect_all_slots();
@@ -9,9 +9,12 @@
 
 #include "primitives/transaction.h"
 
+#include <atomic>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/signals2/signal.hpp>
 
+class CapdMsg;
 class CBlock;
 struct CBlockLocator;
 class CBlockIndex;
@@ -19,6 +22,7 @@ class CReserveScript;
 class CValidationInterface;
 class CValidationState;
 class uint256;
+enum class MemPoolRemovalReason;
 
 typedef std::shared_ptr<const CBlock> ConstCBlockRef;
 
@@ -55,6 +59,9 @@ protected:
     virtual void BlockChecked(const CBlock &, const CValidationState &) {}
     virtual void GetScriptForMining(boost::shared_ptr<CReserveScript> &) {}
     virtual void ResetRequestCount(const uint256 &hash) {}
+    virtual void NewCapdMessage(const std::shared_ptr<CapdMsg> &msg) {}
+    virtual void TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason) {}
+    virtual void BlockDisconnected(const ConstCBlockRef &pblock, const CBlockIndex *pindex) {}
     friend void ::RegisterValidationInterface(CValidationInterface *);
     friend void ::UnregisterValidationInterface(CValidationInterface *);
     friend void ::UnregisterAllValidationInterfaces();
@@ -83,6 +90,17 @@ struct CMainSignals
     boost::signals2::signal<void(boost::shared_ptr<CReserveScript> &)> ScriptForMining;
     /** Notifies listeners that a block has been successfully mined */
     boost::signals2::signal<void(const uint256 &)> BlockFound;
+    /** Notifies listeners of a message that entered the CAPD message pool */
+    boost::signals2::signal<void(const std::shared_ptr<CapdMsg> &)> NewCapdMessage;
+    /** Notifies listeners of a transaction leaving the mempool.  Called with the mempool lock held, so listeners
+     * must not block or call back into the mempool.  Only signalled while nRemovedFromMempoolListeners is non zero.
+     */
+    boost::signals2::signal<void(const CTransactionRef &, MemPoolRemovalReason)> TransactionRemovedFromMempool;
+    /** How many listeners want TransactionRemovedFromMempool.  Every registered interface is connected to it, so
+     * those that use it count themselves here, and the mempool skips the signal when nobody does. */
+    std::atomic<int> nRemovedFromMempoolListeners{0};
+    /** Notifies listeners of a block that was disconnected from the tip of the active chain */
+    boost::signals2::signal<void(const ConstCBlockRef &, const CBlockIndex *)> BlockDisconnected;
 };
 
 CMainSignals &GetMainSignals();
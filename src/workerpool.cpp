@@ -0,0 +1,158 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "workerpool.h"
+
+#include "tinyformat.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+CWorkerPool workerPool;
+
+void CWorkerPool::Start(int nThreads, const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    if (!threads.empty())
+        return;
+    fStopping = false;
+    for (int i = 0; i < nThreads; i++)
+    {
+        const std::string threadName = strprintf("%s%d", name, i);
+        threads.emplace_back(
+            [this, threadName]()
+            {
+                RenameThread(threadName.c_str());
+                Thread();
+            });
+    }
+}
+
+void CWorkerPool::Stop()
+{
+    std::vector<std::thread> stopping;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fStopping = true;
+        queue.clear();
+        stopping.swap(threads);
+        condWork.notify_all();
+    }
+    for (std::thread &t : stopping)
+        t.join();
+}
+
+size_t CWorkerPool::Size()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return threads.size();
+}
+
+void CWorkerPool::Thread()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            condWork.wait(lock, [this]() { return fStopping || !queue.empty(); });
+            if (fStopping)
+                return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+bool CWorkerPool::Post(std::function<void()> task, size_t nMaxQueued)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    if (threads.empty() || fStopping || queue.size() >= nMaxQueued)
+        return false;
+    queue.push_back(std::move(task));
+    condWork.notify_one();
+    return true;
+}
+
+namespace
+{
+/** The shared state of one Run() call.  Workers that pick up a helper task after the call has returned find no jobs
+    left, so they never touch the caller's job function. */
+struct CWorkerPoolRun
+{
+    const std::function<void(size_t)> *job;
+    const size_t n;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> fFailed{false};
+
+    std::mutex cs;
+    std::condition_variable condDone;
+    size_t nDone = 0;
+    std::exception_ptr error;
+
+    CWorkerPoolRun(const std::function<void(size_t)> &jobIn, size_t nIn) : job(&jobIn), n(nIn) {}
+
+    /** Claim and run jobs until there are none left */
+    void Work()
+    {
+        size_t nFinished = 0;
+        for (size_t i = next++; i < n; i = next++)
+        {
+            if (!fFailed.load())
+            {
+                try
+                {
+                    (*job)(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(cs);
+                    if (!error)
+                        error = std::current_exception();
+                    fFailed = true;
+                }
+            }
+            nFinished++;
+        }
+        if (nFinished == 0)
+            return;
+        std::lock_guard<std::mutex> lock(cs);
+        nDone += nFinished;
+        if (nDone == n)
+            condDone.notify_all();
+    }
+};
+} // namespace
+
+void CWorkerPool::Run(size_t n, const std::function<void(size_t)> &job)
+{
+    if (n == 0)
+        return;
+    auto run = std::make_shared<CWorkerPoolRun>(job, n);
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (!fStopping)
+        {
+            // Helpers go ahead of posted tasks since a caller is waiting on them
+            const size_t nHelpers = std::min(threads.size(), n - 1);
+            for (size_t i = 0; i < nHelpers; i++)
+                queue.push_front([run]() { run->Work(); });
+            if (nHelpers == 1)
+                condWork.notify_one();
+            else if (nHelpers > 1)
+                condWork.notify_all();
+        }
+    }
+
+    // Whatever the helpers have not claimed, possibly everything, is done here
+    run->Work();
+    std::unique_lock<std::mutex> lock(run->cs);
+    run->condDone.wait(lock, [&run]() { return run->nDone == run->n; });
+    if (run->error)
+        std::rethrow_exception(run->error);
+}
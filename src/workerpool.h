@@ -0,0 +1,62 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_WORKERPOOL_H
+#define NEXA_WORKERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * A set of long lived worker threads that CPU bound work is spread across, so that no threads are created per call.
+ *
+ * The pool does nothing until it is started.  The node starts the shared workerPool in AppInit2 and stops it in
+ * Shutdown; library users (cashlib) start it themselves if they want parallelism.  Until then, and after Stop(),
+ * Run() executes everything on the calling thread and Post() declines work, so callers never depend on the pool.
+ */
+class CWorkerPool
+{
+public:
+    ~CWorkerPool() { Stop(); }
+
+    /** Start nThreads worker threads, named <name>0, <name>1, ...  Does nothing if the pool is already started. */
+    void Start(int nThreads, const std::string &name);
+
+    /** Stop and join the worker threads.  Tasks still queued by Post() are dropped. */
+    void Stop();
+
+    /** The number of worker threads, 0 if the pool is not started */
+    size_t Size();
+
+    /**
+     * Call job(0) ... job(n - 1), on the worker threads and the calling thread, and return once they have all
+     * finished.  The calling thread takes part, so Run() can be called from a task on the pool, and it runs every
+     * job itself if the pool is not started.  If a job throws, the jobs that have not started yet are skipped and
+     * the first exception is rethrown here.
+     */
+    void Run(size_t n, const std::function<void(size_t)> &job);
+
+    /** Queue task to run on a worker thread.  Returns false, and the caller should do the work itself, if the pool is
+        not started or nMaxQueued tasks are already waiting. */
+    bool Post(std::function<void()> task, size_t nMaxQueued);
+
+private:
+    void Thread();
+
+    std::mutex cs;
+    std::condition_variable condWork;
+    std::deque<std::function<void()> > queue;
+    bool fStopping = false;
+    std::vector<std::thread> threads;
+};
+
+/** The worker threads shared by block deserialization, merkle root hashing, signature batches and CAPD proof of work */
+extern CWorkerPool workerPool;
+
+#endif // NEXA_WORKERPOOL_H
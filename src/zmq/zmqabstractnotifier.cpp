@@ -8,6 +8,27 @@
 
 
 CZMQAbstractNotifier::~CZMQAbstractNotifier() { assert(!psocket); }
-bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/) { return true; }
-bool CZMQAbstractNotifier::NotifyTransaction(const CTransactionRef & /*transaction*/) { return true; }
-bool CZMQAbstractNotifier::NotifyDoubleSpend(const CTransactionRef /*transaction*/) { return true; }
+bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/, uint32_t /*nSequence*/) { return true; }
+bool CZMQAbstractNotifier::NotifyTransaction(const CTransactionRef & /*transaction*/, uint32_t /*nSequence*/)
+{
+    return true;
+}
+bool CZMQAbstractNotifier::NotifyDoubleSpend(const CTransactionRef /*transaction*/, uint32_t /*nSequence*/)
+{
+    return true;
+}
+bool CZMQAbstractNotifier::NotifyCapdMessage(const std::shared_ptr<CapdMsg> & /*msg*/, uint32_t /*nSequence*/)
+{
+    return true;
+}
+bool CZMQAbstractNotifier::NotifyRemovedTransaction(const CTransactionRef & /*transaction*/,
+    MemPoolRemovalReason /*reason*/,
+    uint32_t /*nSequence*/)
+{
+    return true;
+}
+bool CZMQAbstractNotifier::NotifyBlockDisconnect(const CBlockIndex * /*CBlockIndex*/, uint32_t /*nSequence*/)
+{
+    return true;
+}
+bool CZMQAbstractNotifier::Flush() { return true; }
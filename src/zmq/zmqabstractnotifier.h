@@ -8,8 +8,24 @@
 
 #include "zmqconfig.h"
 
+class CapdMsg;
 class CBlockIndex;
 class CZMQAbstractNotifier;
+enum class MemPoolRemovalReason;
+
+/** The kinds of event that are published.  Each notifier publishes one kind, and every kind has its own sequence
+ * numbers.
+ */
+enum ZMQEventKind
+{
+    ZMQ_EVENT_BLOCK, //!< New chain tip
+    ZMQ_EVENT_TRANSACTION, //!< Transaction accepted into the mempool or seen in a block
+    ZMQ_EVENT_DOUBLESPEND, //!< Double spend of a mempool transaction
+    ZMQ_EVENT_CAPDMSG, //!< New CAPD message
+    ZMQ_EVENT_REMOVEDTX, //!< Transaction left the mempool
+    ZMQ_EVENT_BLOCKDISCONNECT, //!< Block disconnected from the tip
+    ZMQ_EVENT_KINDS
+};
 
 typedef CZMQAbstractNotifier *(*CZMQNotifierFactory)();
 
@@ -29,12 +45,19 @@ public:
     void SetType(const std::string &t) { type = t; }
     std::string GetAddress() const { return address; }
     void SetAddress(const std::string &a) { address = a; }
+    virtual ZMQEventKind GetEventKind() const = 0;
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
-    virtual bool NotifyTransaction(const CTransactionRef &ptx);
-    virtual bool NotifyDoubleSpend(const CTransactionRef ptx);
+    // nSequence counts the events of this notifier's kind, and skips ahead when events were dropped
+    virtual bool NotifyBlock(const CBlockIndex *pindex, uint32_t nSequence);
+    virtual bool NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence);
+    virtual bool NotifyDoubleSpend(const CTransactionRef ptx, uint32_t nSequence);
+    virtual bool NotifyCapdMessage(const std::shared_ptr<CapdMsg> &msg, uint32_t nSequence);
+    virtual bool NotifyRemovedTransaction(const CTransactionRef &ptx, MemPoolRemovalReason reason, uint32_t nSequence);
+    virtual bool NotifyBlockDisconnect(const CBlockIndex *pindex, uint32_t nSequence);
+    /** Send anything held back to be published together.  Called whenever the publish queue has been emptied. */
+    virtual bool Flush();
 
 protected:
     void *psocket;
@@ -20,6 +20,11 @@
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 
+//! How many notifications can wait to be published before new ones are dropped, unless -zmqqueuesize says otherwise
+static const unsigned int DEFAULT_ZMQ_QUEUE_SIZE = 65536;
+//! How many transactions the rawtx batch notifier puts in one message, unless -zmqbatchsize says otherwise
+static const unsigned int DEFAULT_ZMQ_BATCH_SIZE = 100;
+
 void zmqError(const char *str);
 
 #endif // NEXA_ZMQ_ZMQCONFIG_H
@@ -11,8 +11,24 @@
 #include "util.h"
 #include "version.h"
 
+#include <algorithm>
+#include <functional>
+
 void zmqError(const char *str) { LOG(ZMQ, "zmq: Error: %s, errno=%s\n", str, zmq_strerror(errno)); }
-CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr) {}
+//! The share of the publish queue that only block and block disconnect events can use
+static const size_t ZMQ_BLOCK_EVENT_RESERVE_DIVISOR = 8;
+
+static bool IsBlockEvent(ZMQEventKind kind) { return kind == ZMQ_EVENT_BLOCK || kind == ZMQ_EVENT_BLOCKDISCONNECT; }
+
+CZMQNotificationInterface::CZMQNotificationInterface(size_t nQueueSize)
+    : pcontext(nullptr), queue(nQueueSize, nQueueSize / ZMQ_BLOCK_EVENT_RESERVE_DIVISOR + 1)
+{
+    fWanted.fill(false);
+    for (auto &n : nDropped)
+        n.store(0, std::memory_order_relaxed);
+    nSequence.fill(0);
+}
+
 CZMQNotificationInterface::~CZMQNotificationInterface()
 {
     Shutdown();
@@ -25,6 +41,7 @@ CZMQNotificationInterface::~CZMQNotificationInterface()
 
 std::list<const CZMQAbstractNotifier *> CZMQNotificationInterface::GetActiveNotifiers() const
 {
+    LOCK(cs_notifiers);
     std::list<const CZMQAbstractNotifier *> result;
     for (const auto *n : notifiers)
     {
@@ -46,6 +63,10 @@ CZMQNotificationInterface *CZMQNotificationInterface::CreateWithArguments(
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubrawds"] = CZMQAbstractNotifier::Create<CZMQPublishRawDoubleSpendNotifier>;
+    factories["pubcapdmsg"] = CZMQAbstractNotifier::Create<CZMQPublishCapdMessageNotifier>;
+    factories["pubrawtxbatch"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionBatchNotifier>;
+    factories["pubremovedtx"] = CZMQAbstractNotifier::Create<CZMQPublishRemovedTransactionNotifier>;
+    factories["pubblockdisconnect"] = CZMQAbstractNotifier::Create<CZMQPublishBlockDisconnectNotifier>;
 
     for (std::map<std::string, CZMQNotifierFactory>::const_iterator i = factories.begin(); i != factories.end(); ++i)
     {
@@ -63,7 +84,8 @@ CZMQNotificationInterface *CZMQNotificationInterface::CreateWithArguments(
 
     if (!notifiers.empty())
     {
-        notificationInterface = new CZMQNotificationInterface();
+        const int64_t nQueueSize = GetArg("-zmqqueuesize", DEFAULT_ZMQ_QUEUE_SIZE);
+        notificationInterface = new CZMQNotificationInterface(std::max<int64_t>(nQueueSize, 1));
         notificationInterface->notifiers = notifiers;
 
         if (!notificationInterface->Initialize())
@@ -111,6 +133,17 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    for (const CZMQAbstractNotifier *notifier : notifiers)
+        fWanted[notifier->GetEventKind()] = true;
+    if (fWanted[ZMQ_EVENT_REMOVEDTX])
+    {
+        GetMainSignals().nRemovedFromMempoolListeners++;
+        fRemovalListener = true;
+    }
+    fStop = false;
+    publisherThread = std::thread(&TraceThread<std::function<void()> >, "zmqpublish",
+        std::bind(&CZMQNotificationInterface::ThreadPublish, this));
+
     return true;
 }
 
@@ -118,8 +151,24 @@ bool CZMQNotificationInterface::Initialize()
 void CZMQNotificationInterface::Shutdown()
 {
     LOG(ZMQ, "zmq: Shutdown notification interface\n");
+    if (fRemovalListener)
+    {
+        GetMainSignals().nRemovedFromMempoolListeners--;
+        fRemovalListener = false;
+    }
+    if (publisherThread.joinable())
+    {
+        // The publisher thread sends whatever is still queued before it exits
+        fStop = true;
+        {
+            std::lock_guard<std::mutex> lock(cs_wake);
+        }
+        condWake.notify_one();
+        publisherThread.join();
+    }
     if (pcontext)
     {
+        LOCK(cs_notifiers);
         for (std::list<CZMQAbstractNotifier *>::iterator i = notifiers.begin(); i != notifiers.end(); ++i)
         {
             CZMQAbstractNotifier *notifier = *i;
@@ -132,29 +181,120 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
-void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
+void CZMQNotificationInterface::Enqueue(CZMQEvent &&event)
 {
-    for (std::list<CZMQAbstractNotifier *>::iterator i = notifiers.begin(); i != notifiers.end();)
+    if (!fWanted[event.kind])
+        return;
+    const ZMQEventKind kind = event.kind;
+    // The next event of this kind that gets into the queue carries the count of those dropped before it, so the
+    // publisher thread skips their sequence numbers just before publishing it
+    event.nDroppedBefore = nDropped[kind].exchange(0, std::memory_order_relaxed);
+    bool fQueued = queue.TryPush(std::move(event), IsBlockEvent(kind));
+    if (!fQueued && IsBlockEvent(kind))
     {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindex))
+        // Subscribers can not do without block events.  The queue is only full of them when the publisher is behind
+        // by a whole reserve of blocks, so wait for it to make room.
+        while (!fQueued && !fStop.load())
         {
-            i++;
+            {
+                std::lock_guard<std::mutex> lock(cs_wake);
+            }
+            condWake.notify_one();
+            std::this_thread::yield();
+            fQueued = queue.TryPush(std::move(event), true);
         }
-        else
+        if (!fQueued)
+            return; // shutting down
+    }
+    if (!fQueued)
+    {
+        // Never block the caller, which may hold cs_main or the mempool lock.  A failed push leaves the event as it
+        // was, so hand its count back along with this one.
+        nDropped[kind].fetch_add(event.nDroppedBefore + 1, std::memory_order_relaxed);
+        if (nDroppedTotal.fetch_add(1, std::memory_order_relaxed) % 1000 == 0)
+            LOG(ZMQ, "zmq: Publish queue is full, dropping notifications\n");
+        return;
+    }
+    // Pairs with the publisher thread setting fWaiting before it looks at the queue one last time, so that either
+    // it sees this event or we see that it needs waking
+    if (fWaiting.load())
+    {
         {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
+            std::lock_guard<std::mutex> lock(cs_wake);
         }
+        condWake.notify_one();
     }
 }
 
-void CZMQNotificationInterface::SyncTransaction(const CTransactionRef &ptx, const ConstCBlockRef pblock, int txIndex)
+void CZMQNotificationInterface::ThreadPublish()
+{
+    while (true)
+    {
+        CZMQEvent event;
+        bool fPublished = false;
+        while (queue.TryPop(event))
+        {
+            Publish(event);
+            fPublished = true;
+        }
+        if (fPublished)
+        {
+            FlushNotifiers();
+            continue;
+        }
+        if (fStop)
+            break;
+
+        std::unique_lock<std::mutex> lock(cs_wake);
+        fWaiting = true;
+        // The timeout is only a backstop; producers wake us when they see fWaiting
+        if (queue.Empty() && !fStop)
+            condWake.wait_for(lock, std::chrono::milliseconds(500));
+        fWaiting = false;
+    }
+}
+
+void CZMQNotificationInterface::Publish(const CZMQEvent &event)
 {
+    nSequence[event.kind] += event.nDroppedBefore;
+    const uint32_t seq = nSequence[event.kind]++;
+
+    LOCK(cs_notifiers);
     for (std::list<CZMQAbstractNotifier *>::iterator i = notifiers.begin(); i != notifiers.end();)
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(ptx))
+        if (notifier->GetEventKind() != event.kind)
+        {
+            i++;
+            continue;
+        }
+
+        bool fOk = true;
+        switch (event.kind)
+        {
+        case ZMQ_EVENT_BLOCK:
+            fOk = notifier->NotifyBlock(event.pindex, seq);
+            break;
+        case ZMQ_EVENT_TRANSACTION:
+            fOk = notifier->NotifyTransaction(event.ptx, seq);
+            break;
+        case ZMQ_EVENT_DOUBLESPEND:
+            fOk = notifier->NotifyDoubleSpend(event.ptx, seq);
+            break;
+        case ZMQ_EVENT_CAPDMSG:
+            fOk = notifier->NotifyCapdMessage(event.msg, seq);
+            break;
+        case ZMQ_EVENT_REMOVEDTX:
+            fOk = notifier->NotifyRemovedTransaction(event.ptx, event.reason, seq);
+            break;
+        case ZMQ_EVENT_BLOCKDISCONNECT:
+            fOk = notifier->NotifyBlockDisconnect(event.pindex, seq);
+            break;
+        case ZMQ_EVENT_KINDS:
+            break;
+        }
+
+        if (fOk)
         {
             i++;
         }
@@ -166,12 +306,13 @@ void CZMQNotificationInterface::SyncTransaction(const CTransactionRef &ptx, cons
     }
 }
 
-void CZMQNotificationInterface::SyncDoubleSpend(const CTransactionRef ptx)
+void CZMQNotificationInterface::FlushNotifiers()
 {
+    LOCK(cs_notifiers);
     for (std::list<CZMQAbstractNotifier *>::iterator i = notifiers.begin(); i != notifiers.end();)
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyDoubleSpend(ptx))
+        if (notifier->Flush())
         {
             i++;
         }
@@ -183,5 +324,53 @@ void CZMQNotificationInterface::SyncDoubleSpend(const CTransactionRef ptx)
     }
 }
 
+void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindex)
+{
+    CZMQEvent event;
+    event.kind = ZMQ_EVENT_BLOCK;
+    event.pindex = pindex;
+    Enqueue(std::move(event));
+}
+
+void CZMQNotificationInterface::SyncTransaction(const CTransactionRef &ptx, const ConstCBlockRef pblock, int txIndex)
+{
+    CZMQEvent event;
+    event.kind = ZMQ_EVENT_TRANSACTION;
+    event.ptx = ptx;
+    Enqueue(std::move(event));
+}
+
+void CZMQNotificationInterface::SyncDoubleSpend(const CTransactionRef ptx)
+{
+    CZMQEvent event;
+    event.kind = ZMQ_EVENT_DOUBLESPEND;
+    event.ptx = ptx;
+    Enqueue(std::move(event));
+}
+
+void CZMQNotificationInterface::NewCapdMessage(const std::shared_ptr<CapdMsg> &msg)
+{
+    CZMQEvent event;
+    event.kind = ZMQ_EVENT_CAPDMSG;
+    event.msg = msg;
+    Enqueue(std::move(event));
+}
+
+void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason)
+{
+    CZMQEvent event;
+    event.kind = ZMQ_EVENT_REMOVEDTX;
+    event.ptx = ptx;
+    event.reason = reason;
+    Enqueue(std::move(event));
+}
+
+void CZMQNotificationInterface::BlockDisconnected(const ConstCBlockRef &pblock, const CBlockIndex *pindex)
+{
+    CZMQEvent event;
+    event.kind = ZMQ_EVENT_BLOCKDISCONNECT;
+    event.pindex = pindex;
+    Enqueue(std::move(event));
+}
 
 CZMQNotificationInterface *pzmqNotificationInterface = nullptr;
@@ -6,13 +6,46 @@
 #ifndef NEXA_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define NEXA_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include "sync.h"
 #include "validationinterface.h"
+#include "zmqabstractnotifier.h"
+#include "zmqpublishqueue.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <list>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
+/** A notification waiting in the publish queue */
+struct CZMQEvent
+{
+    ZMQEventKind kind = ZMQ_EVENT_KINDS;
+    const CBlockIndex *pindex = nullptr;
+    CTransactionRef ptx;
+    std::shared_ptr<CapdMsg> msg;
+    MemPoolRemovalReason reason{};
+    //! Events of this kind dropped since the last one that was queued
+    uint32_t nDroppedBefore = 0;
+};
+
+/**
+ * Publishes validation events to the configured ZeroMQ notifiers.
+ *
+ * The validation interface callbacks only put the event in a lock free queue, so the threads that validate blocks
+ * and transactions never wait for serialization or for ZeroMQ.  A single publisher thread takes the events off the
+ * queue in order and hands them to the notifiers.  If the queue is full the event is dropped, and the next event of
+ * its kind that is queued carries the count, so that its sequence number skips ahead exactly where the gap is.
+ *
+ * Block and block disconnect events are never dropped.  Part of the queue is kept for them, so that a flood of
+ * transactions can not crowd them out, and one that still finds the queue full waits for the publisher.
+ */
 class CZMQNotificationInterface : public CValidationInterface
 {
 public:
@@ -21,6 +54,10 @@ public:
     static CZMQNotificationInterface *CreateWithArguments(const std::map<std::string, std::string> &args);
     std::list<const CZMQAbstractNotifier *> GetActiveNotifiers() const;
 
+    /** The number of transaction, double spend, CAPD and removed transaction events that were dropped because the
+        publish queue was full */
+    uint64_t GetDroppedCount() const { return nDroppedTotal.load(std::memory_order_relaxed); }
+
 protected:
     bool Initialize();
     void Shutdown();
@@ -29,12 +66,42 @@ protected:
     void SyncTransaction(const CTransactionRef &ptx, const ConstCBlockRef pblock, int txIndex = -1) override;
     void SyncDoubleSpend(const CTransactionRef ptx) override;
     void UpdatedBlockTip(const CBlockIndex *pindex) override;
+    void NewCapdMessage(const std::shared_ptr<CapdMsg> &msg) override;
+    void TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason) override;
+    void BlockDisconnected(const ConstCBlockRef &pblock, const CBlockIndex *pindex) override;
 
 private:
-    CZMQNotificationInterface();
+    CZMQNotificationInterface(size_t nQueueSize);
+
+    /** Queue an event for the publisher thread, if any notifier publishes its kind */
+    void Enqueue(CZMQEvent &&event);
+    void ThreadPublish();
+    /** Hand one event to the notifiers of its kind */
+    void Publish(const CZMQEvent &event);
+    /** Let the notifiers send what they held back */
+    void FlushNotifiers();
 
     void *pcontext;
+    //! Protects notifiers, which the publisher thread shuts down and removes when they fail
+    mutable CCriticalSection cs_notifiers;
     std::list<CZMQAbstractNotifier *> notifiers;
+    //! Which kinds of event some notifier publishes, set before the publisher thread starts
+    std::array<bool, ZMQ_EVENT_KINDS> fWanted;
+    //! Whether we are counted in nRemovedFromMempoolListeners
+    bool fRemovalListener = false;
+
+    CReservedQueue<CZMQEvent> queue;
+    //! Events of each kind dropped since one of that kind was last queued
+    std::array<std::atomic<uint32_t>, ZMQ_EVENT_KINDS> nDropped;
+    std::atomic<uint64_t> nDroppedTotal{0};
+    //! The next sequence number of each kind.  Only used by the publisher thread.
+    std::array<uint32_t, ZMQ_EVENT_KINDS> nSequence;
+
+    std::thread publisherThread;
+    std::mutex cs_wake;
+    std::condition_variable condWake;
+    std::atomic<bool> fWaiting{false};
+    std::atomic<bool> fStop{false};
 };
 
 extern CZMQNotificationInterface *pzmqNotificationInterface;
@@ -5,8 +5,11 @@
 
 #include "zmqpublishnotifier.h"
 #include "blockstorage/blockstorage.h"
+#include "capd/capd.h"
 #include "chainparams.h"
+#include "crypto/common.h"
 #include "main.h"
+#include "txmempool.h"
 #include "util.h"
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier *> mapPublishNotifiers;
@@ -92,6 +95,17 @@ bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
     }
 }
 
+bool CZMQAbstractPublishNotifier::SendMessage(const char *topic,
+    size_t topicSize,
+    const void *data,
+    size_t size,
+    uint32_t nSequence)
+{
+    unsigned char seq[sizeof(nSequence)];
+    WriteLE32(seq, nSequence);
+    return zmq_send_multipart(psocket, topic, topicSize, data, size, seq, sizeof(seq), nullptr) == 0;
+}
+
 void CZMQAbstractPublishNotifier::Shutdown()
 {
     // If Initialize did not succeed, or was never called, then shutdown may be called with psocket == nullptr
@@ -124,105 +138,172 @@ void CZMQAbstractPublishNotifier::Shutdown()
     }
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+// Hashes are published in the byte order they are displayed in
+static void ReverseHash(const uint256 &hash, char *data)
+{
+    for (unsigned int i = 0; i < 32; i++)
+        data[31 - i] = hash.begin()[i];
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, uint32_t nSequence)
 {
     uint256 hash = pindex->GetBlockHash();
     LOG(ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
     char data[32];
-    for (unsigned int i = 0; i < 32; i++)
-        data[31 - i] = hash.begin()[i];
-    int rc = zmq_send_multipart(psocket, "hashblock", 9, data, 32, 0);
-    return rc == 0;
+    ReverseHash(hash, data);
+    return SendMessage("hashblock", 9, data, 32, nSequence);
 }
 
-bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransactionRef &ptx)
+bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence)
 {
-    int rc;
+    bool ok;
 
     {
         uint256 hash = ptx->GetId();
         LOG(ZMQ, "zmq: Publish txid %s\n", hash.GetHex());
         char data[32];
-        for (unsigned int i = 0; i < 32; i++)
-            data[31 - i] = hash.begin()[i];
-        rc = zmq_send_multipart(psocket, "txid", 4, data, 32, 0);
+        ReverseHash(hash, data);
+        ok = SendMessage("txid", 4, data, 32, nSequence);
     }
 
     {
         uint256 hash = ptx->GetIdem();
         LOG(ZMQ, "zmq: Publish txidem %s\n", hash.GetHex());
         char data[32];
-        for (unsigned int i = 0; i < 32; i++)
-            data[31 - i] = hash.begin()[i];
-        rc |= zmq_send_multipart(psocket, "txidem", 6, data, 32, 0);
+        ReverseHash(hash, data);
+        ok &= SendMessage("txidem", 6, data, 32, nSequence);
     }
 
-    return rc == 0;
+    return ok;
 }
 
-bool CZMQPublishHashDoubleSpendNotifier::NotifyDoubleSpend(const CTransactionRef ptx)
+bool CZMQPublishHashDoubleSpendNotifier::NotifyDoubleSpend(const CTransactionRef ptx, uint32_t nSequence)
 {
-    int rc;
+    bool ok;
     {
         uint256 hash = ptx->GetId();
         LOG(ZMQ, "zmq: Publish dsid %s\n", hash.GetHex());
         char data[32];
-        for (unsigned int i = 0; i < 32; i++)
-            data[31 - i] = hash.begin()[i];
-        rc = zmq_send_multipart(psocket, "dsid", 4, data, 32, 0);
+        ReverseHash(hash, data);
+        ok = SendMessage("dsid", 4, data, 32, nSequence);
     }
 
     {
         uint256 hash = ptx->GetIdem();
         LOG(ZMQ, "zmq: Publish dsidem %s\n", hash.GetHex());
         char data[32];
-        for (unsigned int i = 0; i < 32; i++)
-            data[31 - i] = hash.begin()[i];
-        rc |= zmq_send_multipart(psocket, "dsidem", 6, data, 32, 0);
-        return rc == 0;
+        ReverseHash(hash, data);
+        ok &= SendMessage("dsidem", 6, data, 32, nSequence);
     }
+    return ok;
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, uint32_t nSequence)
 {
     LOG(ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
     const Consensus::Params &consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    // No cs_main: the block was stored, and its position set, before it became the tip, and block index entries are
+    // never freed.  This is how blocks are read to serve peers.
+    const ConstCBlockRef pblock = ReadBlockFromDisk(pindex, consensusParams);
+    if (!pblock)
     {
-        LOCK(cs_main);
-        const ConstCBlockRef pblock = ReadBlockFromDisk(pindex, consensusParams);
-        if (!pblock)
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << *pblock;
+        zmqError("Can't read block from disk");
+        return false;
     }
 
-    int rc = zmq_send_multipart(psocket, "rawblock", 8, &(*ss.begin()), ss.size(), 0);
-    return rc == 0;
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << *pblock;
+
+    return SendMessage("rawblock", 8, &(*ss.begin()), ss.size(), nSequence);
 }
 
-bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransactionRef &ptx)
+bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence)
 {
     uint256 id = ptx->GetId();
     uint256 idem = ptx->GetIdem();
     LOG(ZMQ, "zmq: Publish rawtx %s (%s)\n", id.GetHex(), idem.GetHex());
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
     ss << *ptx;
-    int rc = zmq_send_multipart(psocket, "rawtx", 5, &(*ss.begin()), ss.size(), 0);
-    return rc == 0;
+    return SendMessage("rawtx", 5, &(*ss.begin()), ss.size(), nSequence);
 }
 
-bool CZMQPublishRawDoubleSpendNotifier::NotifyDoubleSpend(const CTransactionRef ptx)
+bool CZMQPublishRawTransactionBatchNotifier::Initialize(void *pcontext)
+{
+    nBatchSize = std::max<int64_t>(1, GetArg("-zmqbatchsize", DEFAULT_ZMQ_BATCH_SIZE));
+    batch.reserve(nBatchSize);
+    return CZMQAbstractPublishNotifier::Initialize(pcontext);
+}
+
+bool CZMQPublishRawTransactionBatchNotifier::NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence)
+{
+    // The sequence numbers of the transactions in one message must follow each other, so that a subscriber can tell
+    // from the sequence number of the message and the number of transactions in it whether anything was dropped
+    if (!batch.empty() && nSequence != (uint32_t)(nBatchSequence + batch.size()))
+    {
+        if (!Flush())
+            return false;
+    }
+    if (batch.empty())
+        nBatchSequence = nSequence;
+    batch.push_back(ptx);
+    if (batch.size() >= nBatchSize)
+        return Flush();
+    return true;
+}
+
+bool CZMQPublishRawTransactionBatchNotifier::Flush()
+{
+    if (batch.empty())
+        return true;
+    LOG(ZMQ, "zmq: Publish txbatch of %d transactions\n", batch.size());
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << batch;
+    batch.clear();
+    return SendMessage("txbatch", 7, &(*ss.begin()), ss.size(), nBatchSequence);
+}
+
+bool CZMQPublishRawDoubleSpendNotifier::NotifyDoubleSpend(const CTransactionRef ptx, uint32_t nSequence)
 {
     uint256 id = ptx->GetId();
     uint256 idem = ptx->GetIdem();
     LOG(ZMQ, "zmq: Publish rawds %s (%s)\n", id.GetHex(), idem.GetHex());
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
     ss << ptx;
-    int rc = zmq_send_multipart(psocket, "rawds", 5, &(*ss.begin()), ss.size(), 0);
-    return rc == 0;
+    return SendMessage("rawds", 5, &(*ss.begin()), ss.size(), nSequence);
+}
+
+bool CZMQPublishCapdMessageNotifier::NotifyCapdMessage(const std::shared_ptr<CapdMsg> &msg, uint32_t nSequence)
+{
+    LOG(ZMQ, "zmq: Publish capdmsg %s\n", msg->GetHash().GetHex());
+    // The topic is followed by the start of the message data, so that a subscriber's ZMQ_SUBSCRIBE filter can select
+    // the messages that begin with a prefix, and ZeroMQ drops the others before they are sent
+    std::string topic = "capdmsg";
+    const size_t prefixLen = std::min<size_t>(msg->data.size(), CapdSubscriptions::MAX_PREFIX_SIZE);
+    topic.append(msg->data.begin(), msg->data.begin() + prefixLen);
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << *msg;
+    return SendMessage(topic.data(), topic.size(), &(*ss.begin()), ss.size(), nSequence);
+}
+
+bool CZMQPublishRemovedTransactionNotifier::NotifyRemovedTransaction(const CTransactionRef &ptx,
+    MemPoolRemovalReason reason,
+    uint32_t nSequence)
+{
+    uint256 hash = ptx->GetId();
+    LOG(ZMQ, "zmq: Publish removedtx %s (%s)\n", hash.GetHex(), RemovalReasonToString(reason));
+    // The transaction id followed by one byte for the reason
+    char data[33];
+    ReverseHash(hash, data);
+    data[32] = (char)reason;
+    return SendMessage("removedtx", 9, data, 33, nSequence);
+}
+
+bool CZMQPublishBlockDisconnectNotifier::NotifyBlockDisconnect(const CBlockIndex *pindex, uint32_t nSequence)
+{
+    uint256 hash = pindex->GetBlockHash();
+    LOG(ZMQ, "zmq: Publish blockdisconnect %s\n", hash.GetHex());
+    char data[32];
+    ReverseHash(hash, data);
+    return SendMessage("blockdisconnect", 15, data, 32, nSequence);
 }
@@ -8,6 +8,8 @@
 
 #include "zmqabstractnotifier.h"
 
+#include <vector>
+
 class CBlockIndex;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
@@ -15,42 +17,91 @@ class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 public:
     bool Initialize(void *pcontext);
     void Shutdown();
+
+protected:
+    /** Send a message made of the topic, the body and the 4 byte little endian sequence number */
+    bool SendMessage(const char *topic, size_t topicSize, const void *data, size_t size, uint32_t nSequence);
 };
 
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_BLOCK; }
+    bool NotifyBlock(const CBlockIndex *pindex, uint32_t nSequence);
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransactionRef &ptx);
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_TRANSACTION; }
+    bool NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence);
 };
 
 class CZMQPublishHashDoubleSpendNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyDoubleSpend(const CTransactionRef ptx);
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_DOUBLESPEND; }
+    bool NotifyDoubleSpend(const CTransactionRef ptx, uint32_t nSequence);
 };
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex);
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_BLOCK; }
+    bool NotifyBlock(const CBlockIndex *pindex, uint32_t nSequence);
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransactionRef &ptx);
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_TRANSACTION; }
+    bool NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence);
+};
+
+/** Publishes raw transactions several to a message, which costs subscribers far fewer messages when the transaction
+ * rate is high.  A batch is sent when it is full, or as soon as no more events are waiting to be published.
+ */
+class CZMQPublishRawTransactionBatchNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_TRANSACTION; }
+    bool Initialize(void *pcontext);
+    bool NotifyTransaction(const CTransactionRef &ptx, uint32_t nSequence);
+    bool Flush();
+
+private:
+    size_t nBatchSize = DEFAULT_ZMQ_BATCH_SIZE;
+    std::vector<CTransactionRef> batch;
+    //! Sequence number of the first transaction in the batch
+    uint32_t nBatchSequence = 0;
 };
 
 class CZMQPublishRawDoubleSpendNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyDoubleSpend(const CTransactionRef ptx);
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_DOUBLESPEND; }
+    bool NotifyDoubleSpend(const CTransactionRef ptx, uint32_t nSequence);
+};
+
+class CZMQPublishCapdMessageNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_CAPDMSG; }
+    bool NotifyCapdMessage(const std::shared_ptr<CapdMsg> &msg, uint32_t nSequence);
+};
+
+class CZMQPublishRemovedTransactionNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_REMOVEDTX; }
+    bool NotifyRemovedTransaction(const CTransactionRef &ptx, MemPoolRemovalReason reason, uint32_t nSequence);
+};
+
+class CZMQPublishBlockDisconnectNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    ZMQEventKind GetEventKind() const { return ZMQ_EVENT_BLOCKDISCONNECT; }
+    bool NotifyBlockDisconnect(const CBlockIndex *pindex, uint32_t nSequence);
 };
 
 #endif // NEXA_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -0,0 +1,175 @@
+// Copyright (c) 2024 The Bitcoin Unlimited developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef NEXA_ZMQ_ZMQPUBLISHQUEUE_H
+#define NEXA_ZMQ_ZMQPUBLISHQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A bounded queue that any number of threads can push to and pop from without taking a lock.
+ *
+ * This is D. Vyukov's bounded MPMC queue: every slot of a ring buffer carries a turn counter that says whether the
+ * slot is free for the producer or filled for the consumer at a given position, so a push or a pop only has to win
+ * one compare-and-swap on the shared position.  The capacity is rounded up to a power of two.  When the queue is
+ * full TryPush() fails instead of waiting, so callers that must not block can decide what to drop.
+ */
+template <typename T>
+class CBoundedQueue
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> turn;
+        T data;
+    };
+
+    //! Keep the positions written by producers and by consumers on different cache lines
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> buffer;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+
+    static size_t RoundUpCapacity(size_t n)
+    {
+        size_t capacity = 2;
+        while (capacity < n)
+            capacity <<= 1;
+        return capacity;
+    }
+
+public:
+    explicit CBoundedQueue(size_t capacityIn)
+        : mask(RoundUpCapacity(capacityIn) - 1), buffer(new Cell[mask + 1]), enqueuePos(0), dequeuePos(0)
+    {
+        for (size_t i = 0; i <= mask; i++)
+            buffer[i].turn.store(i, std::memory_order_relaxed);
+    }
+
+    CBoundedQueue(const CBoundedQueue &) = delete;
+    CBoundedQueue &operator=(const CBoundedQueue &) = delete;
+
+    size_t Capacity() const { return mask + 1; }
+
+    /** Add an item to the back of the queue.  Returns false, leaving item untouched, if the queue is full. */
+    bool TryPush(T &&item)
+    {
+        Cell *cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &buffer[pos & mask];
+            const size_t turn = cell->turn.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)turn - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false; // the consumer has not taken the item that was written here one lap ago
+            else
+                pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+        cell->data = std::move(item);
+        cell->turn.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Take the item at the front of the queue.  Returns false if the queue is empty. */
+    bool TryPop(T &item)
+    {
+        Cell *cell;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &buffer[pos & mask];
+            const size_t turn = cell->turn.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)turn - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+        item = std::move(cell->data);
+        // Don't hold on to whatever the moved-from item still references until the slot is reused
+        cell->data = T();
+        cell->turn.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** True if nothing has been pushed that was not popped yet.  Only a hint while other threads are pushing. */
+    bool Empty() const
+    {
+        return enqueuePos.load(std::memory_order_seq_cst) == dequeuePos.load(std::memory_order_seq_cst);
+    }
+};
+
+/**
+ * A CBoundedQueue that keeps part of its capacity for urgent items.  Ordinary items are refused once nReserved or fewer
+ * slots are left, so that a flood of them can not crowd out the few items that must not be lost.
+ */
+template <typename T>
+class CReservedQueue
+{
+private:
+    CBoundedQueue<T> queue;
+    //! Ordinary items are refused once this many items are queued
+    const size_t nOrdinaryLimit;
+    //! Counted before an item is pushed and after it is popped, so it is never less than the number in the queue
+    std::atomic<size_t> nQueued;
+
+public:
+    CReservedQueue(size_t capacityIn, size_t nReserved)
+        : queue(capacityIn), nOrdinaryLimit(queue.Capacity() - std::min(nReserved, queue.Capacity() - 1)), nQueued(0)
+    {
+    }
+
+    CReservedQueue(const CReservedQueue &) = delete;
+    CReservedQueue &operator=(const CReservedQueue &) = delete;
+
+    size_t Capacity() const { return queue.Capacity(); }
+
+    /** Add an item to the back of the queue.  Returns false, leaving item untouched, if the queue is full, or if the
+        item is not urgent and only the reserved slots are left. */
+    bool TryPush(T &&item, bool fUrgent)
+    {
+        if (nQueued.fetch_add(1, std::memory_order_relaxed) >= nOrdinaryLimit && !fUrgent)
+        {
+            nQueued.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!queue.TryPush(std::move(item)))
+        {
+            nQueued.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /** Take the item at the front of the queue.  Returns false if the queue is empty. */
+    bool TryPop(T &item)
+    {
+        if (!queue.TryPop(item))
+            return false;
+        nQueued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** True if nothing has been pushed that was not popped yet.  Only a hint while other threads are pushing. */
+    bool Empty() const { return queue.Empty(); }
+};
+
+#endif // NEXA_ZMQ_ZMQPUBLISHQUEUE_H